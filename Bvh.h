@@ -0,0 +1,894 @@
+//Bounding volume hierarchy over object aabbs, binned SAH build into one flat node array
+//children of a node are always next to each other and after their parent, so refitting is one reverse pass over the array
+//moving objects are refit in place (only their leaf's ancestors), the tree gets rebuilt when the caller decides it has degraded (BvhSahCost)
+
+#define BVH_BINS 16
+#define BVH_MAX_LEAF_OBJECTS 4 //leaves never get bigger than this, even when SAH would rather not split
+#define BVH_TRAVERSAL_COST 1.0f //relative to testing one object, for the split vs leaf decision
+#define BVH_STACK_SIZE 64
+//a depth first walk holds one pending sibling per level above the node plus the two children it just pushed, so leaves no deeper
+//than this keep every stack below in bounds. the build switches to median splits when SAH would go deeper, and the walks still check
+//before pushing so a tree that isn't BuildBvh's skips the children that don't fit instead of writing past the stack
+#define BVH_MAX_DEPTH ( BVH_STACK_SIZE - 1 )
+#define BVH_NO_HIT 0xffffffff
+
+//32 bytes, two per cache line
+typedef struct BvhNode
+{
+	Vec3f vMin;
+	u32 dwLeftFirst; //interior: left child (right is + 1), leaf: first entry in pObjectIndices
+	Vec3f vMax;
+	u32 dwCount; //objects in the leaf, 0 for interior nodes
+} BvhNode;
+
+//build only, sorted in place alongside the split so every pass over a node's objects walks memory linearly
+typedef struct BvhBuildRef
+{
+	Vec3f vMin;
+	u32 dwObject;
+	Vec3f vMax;
+	u32 dwPad;
+} BvhBuildRef;
+
+typedef struct Bvh
+{
+	BvhNode *pNodes;
+	u32 *pParents; //per node, for walking up on an incremental refit
+	u32 *pObjectIndices; //leaves own ranges of this
+	u32 *pObjectLeaf; //object -> the leaf it is in
+	Vec3f *pObjectMin;
+	Vec3f *pObjectMax;
+	BvhBuildRef *pBuildRefs;
+	u32 dwNumObjects;
+	u32 dwNumNodes;
+	u32 dwMaxObjects;
+	u32 dwMaxDepth; //deepest leaf of the last build, root is 0
+} Bvh;
+
+inline
+bool InitBvh( Bvh *a_pBvh, u32 dwMaxObjects )
+{
+	a_pBvh->dwMaxObjects = dwMaxObjects;
+	a_pBvh->dwNumObjects = 0;
+	a_pBvh->dwNumNodes = 0;
+	a_pBvh->dwMaxDepth = 0;
+	u32 dwMaxNodes = ( 2 * dwMaxObjects ) + 1;
+	a_pBvh->pNodes = (BvhNode*)malloc( sizeof(BvhNode) * dwMaxNodes );
+	a_pBvh->pParents = (u32*)malloc( sizeof(u32) * ( dwMaxNodes + ( 2 * dwMaxObjects ) ) );
+	a_pBvh->pObjectMin = (Vec3f*)malloc( sizeof(Vec3f) * 2 * dwMaxObjects );
+	a_pBvh->pBuildRefs = (BvhBuildRef*)malloc( sizeof(BvhBuildRef) * dwMaxObjects );
+	if( !a_pBvh->pNodes || !a_pBvh->pParents || !a_pBvh->pObjectMin || !a_pBvh->pBuildRefs )
+	{
+		free( a_pBvh->pNodes );
+		free( a_pBvh->pParents );
+		free( a_pBvh->pObjectMin );
+		free( a_pBvh->pBuildRefs );
+		return false;
+	}
+	a_pBvh->pObjectIndices = a_pBvh->pParents + dwMaxNodes;
+	a_pBvh->pObjectLeaf = a_pBvh->pObjectIndices + dwMaxObjects;
+	a_pBvh->pObjectMax = a_pBvh->pObjectMin + dwMaxObjects;
+	return true;
+}
+
+inline
+void DestroyBvh( Bvh *a_pBvh )
+{
+	free( a_pBvh->pNodes );
+	free( a_pBvh->pParents );
+	free( a_pBvh->pObjectMin );
+	free( a_pBvh->pBuildRefs );
+	a_pBvh->pNodes = nullptr;
+	a_pBvh->pParents = nullptr;
+	a_pBvh->pObjectMin = nullptr;
+	a_pBvh->pBuildRefs = nullptr;
+}
+
+inline
+f32 BvhHalfArea( Vec3f *a_pMin, Vec3f *a_pMax )
+{
+	f32 fX = a_pMax->x - a_pMin->x, fY = a_pMax->y - a_pMin->y, fZ = a_pMax->z - a_pMin->z;
+	return ( fX * fY ) + ( fY * fZ ) + ( fZ * fX );
+}
+
+inline
+void BvhGrow( Vec3f *a_pMin, Vec3f *a_pMax, Vec3f *a_pOtherMin, Vec3f *a_pOtherMax )
+{
+	for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+	{
+		a_pMin->v[dwAxis] = a_pOtherMin->v[dwAxis] < a_pMin->v[dwAxis] ? a_pOtherMin->v[dwAxis] : a_pMin->v[dwAxis];
+		a_pMax->v[dwAxis] = a_pOtherMax->v[dwAxis] > a_pMax->v[dwAxis] ? a_pOtherMax->v[dwAxis] : a_pMax->v[dwAxis];
+	}
+}
+
+inline
+void BvhFitLeaf( Bvh *a_pBvh, BvhNode *a_pNode )
+{
+	a_pNode->vMin = { INFINITY, INFINITY, INFINITY };
+	a_pNode->vMax = { -INFINITY, -INFINITY, -INFINITY };
+	for( u32 dwEntry = a_pNode->dwLeftFirst; dwEntry < a_pNode->dwLeftFirst + a_pNode->dwCount; ++dwEntry )
+	{
+		u32 dwObject = a_pBvh->pObjectIndices[dwEntry];
+		BvhGrow( &a_pNode->vMin, &a_pNode->vMax, &a_pBvh->pObjectMin[dwObject], &a_pBvh->pObjectMax[dwObject] );
+	}
+}
+
+inline
+void BvhFitInterior( Bvh *a_pBvh, BvhNode *a_pNode )
+{
+	BvhNode *pLeft = &a_pBvh->pNodes[a_pNode->dwLeftFirst];
+	BvhNode *pRight = pLeft + 1;
+	a_pNode->vMin = pLeft->vMin;
+	a_pNode->vMax = pLeft->vMax;
+	BvhGrow( &a_pNode->vMin, &a_pNode->vMax, &pRight->vMin, &pRight->vMax );
+}
+
+inline
+void BvhFitRefs( BvhBuildRef *a_pRefs, BvhNode *a_pNode )
+{
+	a_pNode->vMin = { INFINITY, INFINITY, INFINITY };
+	a_pNode->vMax = { -INFINITY, -INFINITY, -INFINITY };
+	for( u32 dwEntry = a_pNode->dwLeftFirst; dwEntry < a_pNode->dwLeftFirst + a_pNode->dwCount; ++dwEntry )
+	{
+		BvhGrow( &a_pNode->vMin, &a_pNode->vMax, &a_pRefs[dwEntry].vMin, &a_pRefs[dwEntry].vMax );
+	}
+}
+
+//centroid scaled by 2, only ever compared against bins derived from the same values
+inline
+f32 BvhRefCentroid( BvhBuildRef *a_pRef, u32 dwAxis )
+{
+	return a_pRef->vMin.v[dwAxis] + a_pRef->vMax.v[dwAxis];
+}
+
+//picks the cheapest of BVH_BINS - 1 split planes per axis by surface area, returns false if keeping the leaf is cheaper
+//the split is returned as the bin mapping plus the first bin on the right, so partitioning puts objects exactly where they were binned
+inline
+bool BvhFindSplit( BvhBuildRef *a_pRefs, BvhNode *a_pNode, u32 *a_pAxis, f32 *a_pBinLow, f32 *a_pBinScale, u32 *a_pRightBin )
+{
+	u32 dwFirst = a_pNode->dwLeftFirst;
+	u32 dwLast = dwFirst + a_pNode->dwCount;
+	Vec3f vCentroidMin = { INFINITY, INFINITY, INFINITY };
+	Vec3f vCentroidMax = { -INFINITY, -INFINITY, -INFINITY };
+	for( u32 dwEntry = dwFirst; dwEntry < dwLast; ++dwEntry )
+	{
+		Vec3f vCentroid = { BvhRefCentroid( &a_pRefs[dwEntry], 0 ), BvhRefCentroid( &a_pRefs[dwEntry], 1 ), BvhRefCentroid( &a_pRefs[dwEntry], 2 ) };
+		BvhGrow( &vCentroidMin, &vCentroidMax, &vCentroid, &vCentroid );
+	}
+
+	//all three axes binned in one walk over the objects
+	Vec3f vBinMin[3][BVH_BINS], vBinMax[3][BVH_BINS];
+	u32 dwBinCount[3][BVH_BINS];
+	f32 fScale[3];
+	for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+	{
+		f32 fRange = vCentroidMax.v[dwAxis] - vCentroidMin.v[dwAxis];
+		fScale[dwAxis] = fRange > 0.0f ? BVH_BINS / fRange : 0.0f;
+		for( u32 dwBin = 0; dwBin < BVH_BINS; ++dwBin )
+		{
+			vBinMin[dwAxis][dwBin] = { INFINITY, INFINITY, INFINITY };
+			vBinMax[dwAxis][dwBin] = { -INFINITY, -INFINITY, -INFINITY };
+			dwBinCount[dwAxis][dwBin] = 0;
+		}
+	}
+	for( u32 dwEntry = dwFirst; dwEntry < dwLast; ++dwEntry )
+	{
+		BvhBuildRef *pRef = &a_pRefs[dwEntry];
+		for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+		{
+			u32 dwBin = (u32)( ( BvhRefCentroid( pRef, dwAxis ) - vCentroidMin.v[dwAxis] ) * fScale[dwAxis] );
+			dwBin = dwBin < BVH_BINS - 1 ? dwBin : BVH_BINS - 1;
+			++dwBinCount[dwAxis][dwBin];
+			BvhGrow( &vBinMin[dwAxis][dwBin], &vBinMax[dwAxis][dwBin], &pRef->vMin, &pRef->vMax );
+		}
+	}
+
+	f32 fBestCost = INFINITY;
+	for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+	{
+		if( fScale[dwAxis] == 0.0f )
+		{
+			continue;
+		}
+		//sweep from both sides so every plane's two halves are known
+		f32 fLeftArea[BVH_BINS - 1], fRightArea[BVH_BINS - 1];
+		u32 dwLeftCount[BVH_BINS - 1], dwRightCount[BVH_BINS - 1];
+		Vec3f vLeftMin = { INFINITY, INFINITY, INFINITY }, vLeftMax = { -INFINITY, -INFINITY, -INFINITY };
+		Vec3f vRightMin = { INFINITY, INFINITY, INFINITY }, vRightMax = { -INFINITY, -INFINITY, -INFINITY };
+		u32 dwLeftSum = 0, dwRightSum = 0;
+		for( u32 dwPlane = 0; dwPlane < BVH_BINS - 1; ++dwPlane )
+		{
+			dwLeftSum += dwBinCount[dwAxis][dwPlane];
+			dwLeftCount[dwPlane] = dwLeftSum;
+			BvhGrow( &vLeftMin, &vLeftMax, &vBinMin[dwAxis][dwPlane], &vBinMax[dwAxis][dwPlane] );
+			fLeftArea[dwPlane] = dwLeftSum ? BvhHalfArea( &vLeftMin, &vLeftMax ) : 0.0f;
+
+			u32 dwRightBin = BVH_BINS - 1 - dwPlane;
+			dwRightSum += dwBinCount[dwAxis][dwRightBin];
+			dwRightCount[dwRightBin - 1] = dwRightSum;
+			BvhGrow( &vRightMin, &vRightMax, &vBinMin[dwAxis][dwRightBin], &vBinMax[dwAxis][dwRightBin] );
+			fRightArea[dwRightBin - 1] = dwRightSum ? BvhHalfArea( &vRightMin, &vRightMax ) : 0.0f;
+		}
+		for( u32 dwPlane = 0; dwPlane < BVH_BINS - 1; ++dwPlane )
+		{
+			f32 fCost = ( dwLeftCount[dwPlane] * fLeftArea[dwPlane] ) + ( dwRightCount[dwPlane] * fRightArea[dwPlane] );
+			if( fCost < fBestCost && dwLeftCount[dwPlane] && dwRightCount[dwPlane] )
+			{
+				fBestCost = fCost;
+				*a_pAxis = dwAxis;
+				*a_pBinLow = vCentroidMin.v[dwAxis];
+				*a_pBinScale = fScale[dwAxis];
+				*a_pRightBin = dwPlane + 1;
+			}
+		}
+	}
+	if( fBestCost == INFINITY )
+	{
+		return false; //all centroids in one spot
+	}
+	f32 fLeafCost = a_pNode->dwCount * BvhHalfArea( &a_pNode->vMin, &a_pNode->vMax );
+	f32 fSplitCost = ( BVH_TRAVERSAL_COST * BvhHalfArea( &a_pNode->vMin, &a_pNode->vMax ) ) + fBestCost;
+	return fSplitCost < fLeafCost || a_pNode->dwCount > BVH_MAX_LEAF_OBJECTS;
+}
+
+//levels of median splits it takes to get dwCount objects down to leaf size
+inline
+u32 BvhMedianLevels( u32 dwCount )
+{
+	u32 dwLevels = 0;
+	while( dwCount > BVH_MAX_LEAF_OBJECTS )
+	{
+		dwCount = ( dwCount + 1 ) / 2;
+		++dwLevels;
+	}
+	return dwLevels;
+}
+
+//quickselect along the node's longest centroid axis, the dwMid - dwFirst smallest centroids end up left of dwMid
+inline
+void BvhMedianSplit( BvhBuildRef *a_pRefs, BvhNode *a_pNode, u32 dwMid )
+{
+	u32 dwFirst = a_pNode->dwLeftFirst;
+	u32 dwLast = dwFirst + a_pNode->dwCount;
+	Vec3f vCentroidMin = { INFINITY, INFINITY, INFINITY };
+	Vec3f vCentroidMax = { -INFINITY, -INFINITY, -INFINITY };
+	for( u32 dwEntry = dwFirst; dwEntry < dwLast; ++dwEntry )
+	{
+		Vec3f vCentroid = { BvhRefCentroid( &a_pRefs[dwEntry], 0 ), BvhRefCentroid( &a_pRefs[dwEntry], 1 ), BvhRefCentroid( &a_pRefs[dwEntry], 2 ) };
+		BvhGrow( &vCentroidMin, &vCentroidMax, &vCentroid, &vCentroid );
+	}
+	Vec3f vRange;
+	Vec3fSub( &vCentroidMax, &vCentroidMin, &vRange );
+	u32 dwAxis = vRange.x >= vRange.y ? ( vRange.x >= vRange.z ? 0 : 2 ) : ( vRange.y >= vRange.z ? 1 : 2 );
+
+	s32 iLow = (s32)dwFirst, iHigh = (s32)dwLast - 1, iMid = (s32)dwMid;
+	while( iLow < iHigh )
+	{
+		f32 fPivot = BvhRefCentroid( &a_pRefs[( iLow + iHigh ) / 2], dwAxis );
+		s32 i = iLow, j = iHigh;
+		while( i <= j )
+		{
+			while( BvhRefCentroid( &a_pRefs[i], dwAxis ) < fPivot ) ++i;
+			while( BvhRefCentroid( &a_pRefs[j], dwAxis ) > fPivot ) --j;
+			if( i <= j )
+			{
+				BvhBuildRef tmp = a_pRefs[i];
+				a_pRefs[i++] = a_pRefs[j];
+				a_pRefs[j--] = tmp;
+			}
+		}
+		//[iLow, j] <= pivot <= [i, iHigh], anything between is the pivot itself
+		if( iMid <= j )
+		{
+			iHigh = j;
+		}
+		else if( iMid >= i )
+		{
+			iLow = i;
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+//a_pMin/a_pMax are copied, the object's index in them is its id in every query
+inline
+void BuildBvh( Bvh *a_pBvh, Vec3f *a_pMin, Vec3f *a_pMax, u32 dwNumObjects )
+{
+#if MAIN_DEBUG
+	assert( dwNumObjects <= a_pBvh->dwMaxObjects && dwNumObjects > 0 );
+#endif
+	a_pBvh->dwNumObjects = dwNumObjects;
+	memcpy( a_pBvh->pObjectMin, a_pMin, sizeof(Vec3f) * dwNumObjects );
+	memcpy( a_pBvh->pObjectMax, a_pMax, sizeof(Vec3f) * dwNumObjects );
+	BvhBuildRef *pRefs = a_pBvh->pBuildRefs;
+	for( u32 dwObject = 0; dwObject < dwNumObjects; ++dwObject )
+	{
+		pRefs[dwObject].vMin = a_pMin[dwObject];
+		pRefs[dwObject].vMax = a_pMax[dwObject];
+		pRefs[dwObject].dwObject = dwObject;
+	}
+
+	BvhNode *pRoot = &a_pBvh->pNodes[0];
+	pRoot->dwLeftFirst = 0;
+	pRoot->dwCount = dwNumObjects;
+	BvhFitRefs( pRefs, pRoot );
+	a_pBvh->pParents[0] = BVH_NO_HIT;
+	a_pBvh->dwNumNodes = 1;
+	a_pBvh->dwMaxDepth = 0;
+
+	//nodes to split, depth first so a subtree's nodes stay close together in the array
+	u32 dwStack[BVH_STACK_SIZE], dwDepthStack[BVH_STACK_SIZE];
+	u32 dwStackSize = 0;
+	dwStack[dwStackSize] = 0;
+	dwDepthStack[dwStackSize++] = 0;
+	while( dwStackSize )
+	{
+		u32 dwNodeIdx = dwStack[--dwStackSize];
+		u32 dwDepth = dwDepthStack[dwStackSize];
+		BvhNode *pNode = &a_pBvh->pNodes[dwNodeIdx];
+		a_pBvh->dwMaxDepth = dwDepth > a_pBvh->dwMaxDepth ? dwDepth : a_pBvh->dwMaxDepth;
+		u32 dwAxis, dwRightBin;
+		f32 fBinLow, fBinScale;
+		u32 dwFirst = pNode->dwLeftFirst;
+		u32 dwLast = dwFirst + pNode->dwCount;
+		u32 dwMid;
+		if( pNode->dwCount <= 1 || dwStackSize + 2 > BVH_STACK_SIZE )
+		{
+			continue;
+		}
+		//SAH can peel a few objects off per level (clustered or exponentially spaced objects), once median splits from here on
+		//would only just reach leaf size within BVH_MAX_DEPTH it has to be median splits
+		if( dwDepth + BvhMedianLevels( pNode->dwCount ) < BVH_MAX_DEPTH && BvhFindSplit( pRefs, pNode, &dwAxis, &fBinLow, &fBinScale, &dwRightBin ) )
+		{
+			dwMid = dwFirst;
+			u32 dwEnd = dwLast;
+			while( dwMid < dwEnd )
+			{
+				u32 dwBin = (u32)( ( BvhRefCentroid( &pRefs[dwMid], dwAxis ) - fBinLow ) * fBinScale );
+				if( dwBin < dwRightBin )
+				{
+					++dwMid;
+				}
+				else
+				{
+					BvhBuildRef tmp = pRefs[dwMid];
+					pRefs[dwMid] = pRefs[--dwEnd];
+					pRefs[dwEnd] = tmp;
+				}
+			}
+		}
+		else if( pNode->dwCount > BVH_MAX_LEAF_OBJECTS )
+		{
+			dwMid = dwFirst + ( pNode->dwCount / 2 ); //out of depth or stacked centroids
+			BvhMedianSplit( pRefs, pNode, dwMid );
+		}
+		else
+		{
+			continue;
+		}
+
+		u32 dwLeftIdx = a_pBvh->dwNumNodes;
+		a_pBvh->dwNumNodes += 2;
+		BvhNode *pLeft = &a_pBvh->pNodes[dwLeftIdx];
+		BvhNode *pRight = pLeft + 1;
+		pLeft->dwLeftFirst = dwFirst;
+		pLeft->dwCount = dwMid - dwFirst;
+		pRight->dwLeftFirst = dwMid;
+		pRight->dwCount = dwLast - dwMid;
+		BvhFitRefs( pRefs, pLeft );
+		BvhFitRefs( pRefs, pRight );
+		a_pBvh->pParents[dwLeftIdx] = dwNodeIdx;
+		a_pBvh->pParents[dwLeftIdx + 1] = dwNodeIdx;
+		pNode->dwLeftFirst = dwLeftIdx;
+		pNode->dwCount = 0;
+		dwStack[dwStackSize] = dwLeftIdx + 1;
+		dwDepthStack[dwStackSize++] = dwDepth + 1;
+		dwStack[dwStackSize] = dwLeftIdx;
+		dwDepthStack[dwStackSize++] = dwDepth + 1;
+	}
+#if MAIN_DEBUG
+	assert( a_pBvh->dwMaxDepth <= BVH_MAX_DEPTH );
+#endif
+
+	for( u32 dwEntry = 0; dwEntry < dwNumObjects; ++dwEntry )
+	{
+		a_pBvh->pObjectIndices[dwEntry] = pRefs[dwEntry].dwObject;
+	}
+	for( u32 dwNodeIdx = 0; dwNodeIdx < a_pBvh->dwNumNodes; ++dwNodeIdx )
+	{
+		BvhNode *pNode = &a_pBvh->pNodes[dwNodeIdx];
+		for( u32 dwEntry = pNode->dwLeftFirst; pNode->dwCount && dwEntry < pNode->dwLeftFirst + pNode->dwCount; ++dwEntry )
+		{
+			a_pBvh->pObjectLeaf[a_pBvh->pObjectIndices[dwEntry]] = dwNodeIdx;
+		}
+	}
+}
+
+//moves one object, only its leaf and the ancestors whose bounds actually change get touched
+inline
+void BvhUpdateObject( Bvh *a_pBvh, u32 dwObject, Vec3f *a_pMin, Vec3f *a_pMax )
+{
+	a_pBvh->pObjectMin[dwObject] = *a_pMin;
+	a_pBvh->pObjectMax[dwObject] = *a_pMax;
+	u32 dwNodeIdx = a_pBvh->pObjectLeaf[dwObject];
+	BvhFitLeaf( a_pBvh, &a_pBvh->pNodes[dwNodeIdx] );
+	dwNodeIdx = a_pBvh->pParents[dwNodeIdx];
+	while( dwNodeIdx != BVH_NO_HIT )
+	{
+		BvhNode *pNode = &a_pBvh->pNodes[dwNodeIdx];
+		Vec3f vOldMin = pNode->vMin, vOldMax = pNode->vMax;
+		BvhFitInterior( a_pBvh, pNode );
+		if( !memcmp( &vOldMin, &pNode->vMin, sizeof(Vec3f) ) && !memcmp( &vOldMax, &pNode->vMax, sizeof(Vec3f) ) )
+		{
+			break;
+		}
+		dwNodeIdx = a_pBvh->pParents[dwNodeIdx];
+	}
+}
+
+//when most objects moved, cheaper than walking up from each of them
+inline
+void BvhRefit( Bvh *a_pBvh )
+{
+	for( u32 dwNodeIdx = a_pBvh->dwNumNodes; dwNodeIdx-- > 0; )
+	{
+		BvhNode *pNode = &a_pBvh->pNodes[dwNodeIdx];
+		if( pNode->dwCount )
+		{
+			BvhFitLeaf( a_pBvh, pNode );
+		}
+		else
+		{
+			BvhFitInterior( a_pBvh, pNode );
+		}
+	}
+}
+
+//expected cost of a query relative to the root, grows as refits stretch the nodes, rebuild once it is well past the value right after a build
+inline
+f32 BvhSahCost( Bvh *a_pBvh )
+{
+	f32 fRootArea = BvhHalfArea( &a_pBvh->pNodes[0].vMin, &a_pBvh->pNodes[0].vMax );
+	f32 fCost = 0.0f;
+	for( u32 dwNodeIdx = 0; dwNodeIdx < a_pBvh->dwNumNodes; ++dwNodeIdx )
+	{
+		BvhNode *pNode = &a_pBvh->pNodes[dwNodeIdx];
+		fCost += BvhHalfArea( &pNode->vMin, &pNode->vMax ) * ( pNode->dwCount ? (f32)pNode->dwCount : BVH_TRAVERSAL_COST );
+	}
+	return fRootArea > 0.0f ? fCost / fRootArea : 0.0f;
+}
+
+inline
+void BvhAppendSubtree( Bvh *a_pBvh, u32 dwNodeIdx, u32 *a_pOut, u32 dwMaxOut, u32 *a_pNumOut )
+{
+	u32 dwStack[BVH_STACK_SIZE];
+	u32 dwStackSize = 0;
+	dwStack[dwStackSize++] = dwNodeIdx;
+	while( dwStackSize )
+	{
+		BvhNode *pNode = &a_pBvh->pNodes[dwStack[--dwStackSize]];
+		if( pNode->dwCount )
+		{
+			for( u32 dwEntry = pNode->dwLeftFirst; dwEntry < pNode->dwLeftFirst + pNode->dwCount && *a_pNumOut < dwMaxOut; ++dwEntry )
+			{
+				a_pOut[(*a_pNumOut)++] = a_pBvh->pObjectIndices[dwEntry];
+			}
+		}
+		else if( dwStackSize + 2 <= BVH_STACK_SIZE )
+		{
+			dwStack[dwStackSize++] = pNode->dwLeftFirst + 1;
+			dwStack[dwStackSize++] = pNode->dwLeftFirst;
+		}
+	}
+}
+
+//objects whose aabb is not fully outside any plane, subtrees fully inside are taken without testing further
+//returns how many object ids were written to a_pOut
+inline
+u32 BvhFrustumQuery( Bvh *a_pBvh, CullFrustum *a_pFrustum, u32 *a_pOut, u32 dwMaxOut )
+{
+	u32 dwNumOut = 0;
+	u32 dwStack[BVH_STACK_SIZE];
+	u32 dwStackSize = 0;
+	dwStack[dwStackSize++] = 0;
+	while( dwStackSize )
+	{
+		u32 dwNodeIdx = dwStack[--dwStackSize];
+		BvhNode *pNode = &a_pBvh->pNodes[dwNodeIdx];
+		Vec3f vCenter, vExtent;
+		Vec3fAdd( &pNode->vMin, &pNode->vMax, &vCenter );
+		Vec3fScale( &vCenter, 0.5f, &vCenter );
+		Vec3fSub( &pNode->vMax, &vCenter, &vExtent );
+		u8 bOutside = 0, bInside = 1;
+		for( u32 dwPlane = 0; dwPlane < a_pFrustum->dwNumPlanes; ++dwPlane )
+		{
+			Vec4f *pPlane = &a_pFrustum->planes[dwPlane];
+			f32 fDist = ( pPlane->x * vCenter.x ) + ( pPlane->y * vCenter.y ) + ( pPlane->z * vCenter.z ) + pPlane->w;
+			f32 fRadius = ( fabsf( pPlane->x ) * vExtent.x ) + ( fabsf( pPlane->y ) * vExtent.y ) + ( fabsf( pPlane->z ) * vExtent.z );
+			if( fDist + fRadius < 0.0f )
+			{
+				bOutside = 1;
+				break;
+			}
+			bInside &= fDist - fRadius >= 0.0f;
+		}
+		if( bOutside )
+		{
+			continue;
+		}
+		if( bInside || pNode->dwCount )
+		{
+			//a leaf that straddles a plane still tests its objects, so the result matches culling the boxes one by one
+			if( pNode->dwCount && !bInside )
+			{
+				for( u32 dwEntry = pNode->dwLeftFirst; dwEntry < pNode->dwLeftFirst + pNode->dwCount && dwNumOut < dwMaxOut; ++dwEntry )
+				{
+					u32 dwObject = a_pBvh->pObjectIndices[dwEntry];
+					Vec3f vObjCenter, vObjExtent;
+					Vec3fAdd( &a_pBvh->pObjectMin[dwObject], &a_pBvh->pObjectMax[dwObject], &vObjCenter );
+					Vec3fScale( &vObjCenter, 0.5f, &vObjCenter );
+					Vec3fSub( &a_pBvh->pObjectMax[dwObject], &vObjCenter, &vObjExtent );
+					if( CullBoxInFrustum( a_pFrustum, vObjCenter.x, vObjCenter.y, vObjCenter.z, vObjExtent.x, vObjExtent.y, vObjExtent.z ) )
+					{
+						a_pOut[dwNumOut++] = dwObject;
+					}
+				}
+			}
+			else
+			{
+				BvhAppendSubtree( a_pBvh, dwNodeIdx, a_pOut, dwMaxOut, &dwNumOut );
+			}
+			continue;
+		}
+		if( dwStackSize + 2 <= BVH_STACK_SIZE )
+		{
+			dwStack[dwStackSize++] = pNode->dwLeftFirst + 1;
+			dwStack[dwStackSize++] = pNode->dwLeftFirst;
+		}
+	}
+	return dwNumOut;
+}
+
+//slab test, distance along the ray to where it enters the box or INFINITY if it misses within fMaxT
+inline
+f32 BvhRayBox( Vec3f *a_pOrigin, Vec3f *a_pInvDir, f32 fMaxT, Vec3f *a_pMin, Vec3f *a_pMax )
+{
+	f32 fNear = 0.0f, fFar = fMaxT;
+	for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+	{
+		f32 fT0 = ( a_pMin->v[dwAxis] - a_pOrigin->v[dwAxis] ) * a_pInvDir->v[dwAxis];
+		f32 fT1 = ( a_pMax->v[dwAxis] - a_pOrigin->v[dwAxis] ) * a_pInvDir->v[dwAxis];
+		f32 fEnter = fT0 < fT1 ? fT0 : fT1;
+		f32 fExit = fT0 < fT1 ? fT1 : fT0;
+		fNear = fEnter > fNear ? fEnter : fNear;
+		fFar = fExit < fFar ? fExit : fFar;
+	}
+	return fNear <= fFar ? fNear : INFINITY;
+}
+
+//closest object aabb along the ray (controller pointing), returns BVH_NO_HIT if nothing within fMaxT
+//children are visited near first so most of the far side gets skipped once something is hit
+inline
+u32 BvhRayCast( Bvh *a_pBvh, Vec3f *a_pOrigin, Vec3f *a_pDir, f32 fMaxT, f32 *a_pHitT )
+{
+	Vec3f vInvDir = { 1.0f / a_pDir->x, 1.0f / a_pDir->y, 1.0f / a_pDir->z };
+	u32 dwHit = BVH_NO_HIT;
+	f32 fClosest = fMaxT;
+	u32 dwStack[BVH_STACK_SIZE];
+	u32 dwStackSize = 0;
+	if( BvhRayBox( a_pOrigin, &vInvDir, fClosest, &a_pBvh->pNodes[0].vMin, &a_pBvh->pNodes[0].vMax ) == INFINITY )
+	{
+		return BVH_NO_HIT;
+	}
+	dwStack[dwStackSize++] = 0;
+	while( dwStackSize )
+	{
+		BvhNode *pNode = &a_pBvh->pNodes[dwStack[--dwStackSize]];
+		if( pNode->dwCount )
+		{
+			for( u32 dwEntry = pNode->dwLeftFirst; dwEntry < pNode->dwLeftFirst + pNode->dwCount; ++dwEntry )
+			{
+				u32 dwObject = a_pBvh->pObjectIndices[dwEntry];
+				f32 fT = BvhRayBox( a_pOrigin, &vInvDir, fClosest, &a_pBvh->pObjectMin[dwObject], &a_pBvh->pObjectMax[dwObject] );
+				if( fT < fClosest || ( fT == fClosest && dwHit == BVH_NO_HIT ) )
+				{
+					fClosest = fT;
+					dwHit = dwObject;
+				}
+			}
+			continue;
+		}
+		u32 dwLeft = pNode->dwLeftFirst;
+		f32 fLeftT = BvhRayBox( a_pOrigin, &vInvDir, fClosest, &a_pBvh->pNodes[dwLeft].vMin, &a_pBvh->pNodes[dwLeft].vMax );
+		f32 fRightT = BvhRayBox( a_pOrigin, &vInvDir, fClosest, &a_pBvh->pNodes[dwLeft + 1].vMin, &a_pBvh->pNodes[dwLeft + 1].vMax );
+		//push the far one first so the near one is popped next
+		if( dwStackSize + 2 > BVH_STACK_SIZE )
+		{
+			continue;
+		}
+		if( fLeftT <= fRightT )
+		{
+			if( fRightT != INFINITY ) dwStack[dwStackSize++] = dwLeft + 1;
+			if( fLeftT != INFINITY ) dwStack[dwStackSize++] = dwLeft;
+		}
+		else
+		{
+			if( fLeftT != INFINITY ) dwStack[dwStackSize++] = dwLeft;
+			if( fRightT != INFINITY ) dwStack[dwStackSize++] = dwLeft + 1;
+		}
+	}
+	*a_pHitT = fClosest;
+	return dwHit;
+}
+
+//objects whose aabb touches the given one (grabbing, triggers), returns how many ids were written
+inline
+u32 BvhOverlapQuery( Bvh *a_pBvh, Vec3f *a_pMin, Vec3f *a_pMax, u32 *a_pOut, u32 dwMaxOut )
+{
+	u32 dwNumOut = 0;
+	u32 dwStack[BVH_STACK_SIZE];
+	u32 dwStackSize = 0;
+	dwStack[dwStackSize++] = 0;
+	while( dwStackSize )
+	{
+		BvhNode *pNode = &a_pBvh->pNodes[dwStack[--dwStackSize]];
+		if( pNode->vMin.x > a_pMax->x || pNode->vMax.x < a_pMin->x ||
+			pNode->vMin.y > a_pMax->y || pNode->vMax.y < a_pMin->y ||
+			pNode->vMin.z > a_pMax->z || pNode->vMax.z < a_pMin->z )
+		{
+			continue;
+		}
+		if( pNode->dwCount )
+		{
+			for( u32 dwEntry = pNode->dwLeftFirst; dwEntry < pNode->dwLeftFirst + pNode->dwCount && dwNumOut < dwMaxOut; ++dwEntry )
+			{
+				u32 dwObject = a_pBvh->pObjectIndices[dwEntry];
+				Vec3f *pMin = &a_pBvh->pObjectMin[dwObject], *pMax = &a_pBvh->pObjectMax[dwObject];
+				if( !( pMin->x > a_pMax->x || pMax->x < a_pMin->x || pMin->y > a_pMax->y || pMax->y < a_pMin->y || pMin->z > a_pMax->z || pMax->z < a_pMin->z ) )
+				{
+					a_pOut[dwNumOut++] = dwObject;
+				}
+			}
+			continue;
+		}
+		if( dwStackSize + 2 <= BVH_STACK_SIZE )
+		{
+			dwStack[dwStackSize++] = pNode->dwLeftFirst + 1;
+			dwStack[dwStackSize++] = pNode->dwLeftFirst;
+		}
+	}
+	return dwNumOut;
+}
+
+#if BENCHMARK_MODE
+inline
+f32 BvhBenchmarkRand( u32 *a_pSeed )
+{
+	*a_pSeed = ( *a_pSeed * 1664525 ) + 1013904223;
+	return ( *a_pSeed >> 8 ) / (f32)( 1 << 24 );
+}
+
+//build/refit/query times from 1k to 1M objects at the same density, every query is checked against a brute force pass over all objects
+//then a row of exponentially spaced objects, where SAH splits off one object per level, has to stay within BVH_MAX_DEPTH
+//returns the number of failed checks
+u32 BenchmarkBvh()
+{
+	const u32 dwMaxObjects = 1000000;
+	const u32 dwNumQueries = 1000;
+	const u32 dwNumChecked = 64; //queries also run brute force, only the first few so 1M stays quick
+	Bvh bvh;
+	if( !InitBvh( &bvh, dwMaxObjects ) )
+	{
+		printf( "Bvh: out of memory\n" );
+		return 1;
+	}
+	Vec3f *pMin = (Vec3f*)malloc( sizeof(Vec3f) * 2 * dwMaxObjects );
+	Vec3f *pMax = pMin + dwMaxObjects;
+	u32 *pResults = (u32*)malloc( sizeof(u32) * dwMaxObjects );
+	if( !pMin || !pResults )
+	{
+		printf( "Bvh: out of memory\n" );
+		free( pMin );
+		free( pResults );
+		DestroyBvh( &bvh );
+		return 1;
+	}
+	u32 dwTotalFailures = 0;
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	f64 fToMs = 1000.0 / (f64)PerfCountFrequency.QuadPart;
+
+	ovrFovPort fov;
+	fov.UpTan = 1.3316f; fov.DownTan = 1.3316f; fov.LeftTan = 1.0924f; fov.RightTan = 1.0924f;
+
+	for( u32 dwNumObjects = 1000; dwNumObjects <= dwMaxObjects; dwNumObjects *= 10 )
+	{
+		u32 dwSeed = 4242;
+		f32 fSide = 40.0f * cbrtf( dwNumObjects / 1000.0f );
+		for( u32 dwObject = 0; dwObject < dwNumObjects; ++dwObject )
+		{
+			Vec3f vCenter, vExtent;
+			for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+			{
+				vCenter.v[dwAxis] = ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide;
+				vExtent.v[dwAxis] = 0.05f + ( 0.5f * BvhBenchmarkRand( &dwSeed ) );
+			}
+			Vec3fSub( &vCenter, &vExtent, &pMin[dwObject] );
+			Vec3fAdd( &vCenter, &vExtent, &pMax[dwObject] );
+		}
+		u32 dwFailures = 0;
+
+		QueryPerformanceCounter( &startCounter );
+		BuildBvh( &bvh, pMin, pMax, dwNumObjects );
+		QueryPerformanceCounter( &endCounter );
+		f64 fBuildMs = ( endCounter.QuadPart - startCounter.QuadPart ) * fToMs;
+		f32 fBuiltCost = BvhSahCost( &bvh );
+
+		//a tenth of the objects drift a little, like the moving props of a frame
+		u32 dwNumMoved = dwNumObjects / 10;
+		QueryPerformanceCounter( &startCounter );
+		for( u32 dwMoved = 0; dwMoved < dwNumMoved; ++dwMoved )
+		{
+			u32 dwObject = ( dwMoved * 7919 ) % dwNumObjects;
+			Vec3f vOffset = { ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * 0.2f, ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * 0.2f, ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * 0.2f };
+			Vec3fAdd( &pMin[dwObject], &vOffset, &pMin[dwObject] );
+			Vec3fAdd( &pMax[dwObject], &vOffset, &pMax[dwObject] );
+			BvhUpdateObject( &bvh, dwObject, &pMin[dwObject], &pMax[dwObject] );
+		}
+		QueryPerformanceCounter( &endCounter );
+		f64 fUpdateMs = ( endCounter.QuadPart - startCounter.QuadPart ) * fToMs;
+		QueryPerformanceCounter( &startCounter );
+		BvhRefit( &bvh );
+		QueryPerformanceCounter( &endCounter );
+		f64 fRefitMs = ( endCounter.QuadPart - startCounter.QuadPart ) * fToMs;
+		f32 fRefitCost = BvhSahCost( &bvh );
+
+		//frustums from random spots looking along random yaws
+		f64 fFrustumMs = 0.0;
+		u32 dwFrustumHits = 0;
+		Vec3f vYawAxis = { 0.0f, 1.0f, 0.0f };
+		for( u32 dwQuery = 0; dwQuery < dwNumQueries; ++dwQuery )
+		{
+			Quatf qYaw;
+			InitUnitQuatf( &qYaw, 360.0f * BvhBenchmarkRand( &dwSeed ), &vYawAxis );
+			Vec3f vPos = { ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide, 0.0f, ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide };
+			CullFrustum frustum;
+			InitCullFrustumFromFov( &frustum, fov, &qYaw, &vPos, EYE_NEAR_PLANE, 0.0f );
+			//far plane 20m out (facing back at the eye) so the query stays a view sized chunk of the scene
+			Vec3f vEyeBack = { 0.0f, 0.0f, 1.0f }, vFarNormal, vFarPoint;
+			Vec3fRotByUnitQuat( &vEyeBack, &qYaw, &vFarNormal );
+			Vec3fScale( &vFarNormal, -20.0f, &vFarPoint );
+			Vec3fAdd( &vFarPoint, &vPos, &vFarPoint );
+			SetCullPlane( &frustum.planes[frustum.dwNumPlanes++], &vFarNormal, &vFarPoint );
+
+			QueryPerformanceCounter( &startCounter );
+			u32 dwNumOut = BvhFrustumQuery( &bvh, &frustum, pResults, dwMaxObjects );
+			QueryPerformanceCounter( &endCounter );
+			fFrustumMs += ( endCounter.QuadPart - startCounter.QuadPart ) * fToMs;
+			dwFrustumHits += dwNumOut;
+			if( dwQuery < dwNumChecked )
+			{
+				u32 dwExpected = 0;
+				for( u32 dwObject = 0; dwObject < dwNumObjects; ++dwObject )
+				{
+					Vec3f vCenter, vExtent;
+					Vec3fAdd( &pMin[dwObject], &pMax[dwObject], &vCenter );
+					Vec3fScale( &vCenter, 0.5f, &vCenter );
+					Vec3fSub( &pMax[dwObject], &vCenter, &vExtent );
+					dwExpected += CullBoxInFrustum( &frustum, vCenter.x, vCenter.y, vCenter.z, vExtent.x, vExtent.y, vExtent.z );
+				}
+				dwFailures += dwExpected != dwNumOut ? 1 : 0;
+			}
+		}
+
+		//pointing rays from inside the scene
+		f64 fRayMs = 0.0;
+		u32 dwRayHits = 0;
+		for( u32 dwQuery = 0; dwQuery < dwNumQueries; ++dwQuery )
+		{
+			Vec3f vOrigin = { ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide, ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide, ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide };
+			Vec3f vDir = { BvhBenchmarkRand( &dwSeed ) - 0.5f, BvhBenchmarkRand( &dwSeed ) - 0.5f, BvhBenchmarkRand( &dwSeed ) - 0.5f };
+			Vec3fNormalize( &vDir, &vDir );
+			f32 fHitT = INFINITY;
+			QueryPerformanceCounter( &startCounter );
+			u32 dwHit = BvhRayCast( &bvh, &vOrigin, &vDir, 100.0f, &fHitT );
+			QueryPerformanceCounter( &endCounter );
+			fRayMs += ( endCounter.QuadPart - startCounter.QuadPart ) * fToMs;
+			dwRayHits += dwHit != BVH_NO_HIT ? 1 : 0;
+			if( dwQuery < dwNumChecked )
+			{
+				Vec3f vInvDir = { 1.0f / vDir.x, 1.0f / vDir.y, 1.0f / vDir.z };
+				f32 fExpectedT = 100.0f;
+				u32 dwExpectedHit = BVH_NO_HIT;
+				for( u32 dwObject = 0; dwObject < dwNumObjects; ++dwObject )
+				{
+					f32 fT = BvhRayBox( &vOrigin, &vInvDir, fExpectedT, &pMin[dwObject], &pMax[dwObject] );
+					if( fT < fExpectedT || ( fT == fExpectedT && dwExpectedHit == BVH_NO_HIT ) )
+					{
+						fExpectedT = fT;
+						dwExpectedHit = dwObject;
+					}
+				}
+				//ties between boxes at the same distance may pick either, the distance has to match
+				dwFailures += ( dwExpectedHit == BVH_NO_HIT ) != ( dwHit == BVH_NO_HIT ) ? 1 : 0;
+				dwFailures += dwHit != BVH_NO_HIT && fHitT != fExpectedT ? 1 : 0;
+			}
+		}
+
+		//grab sized boxes
+		f64 fOverlapMs = 0.0;
+		u32 dwOverlapHits = 0;
+		for( u32 dwQuery = 0; dwQuery < dwNumQueries; ++dwQuery )
+		{
+			Vec3f vCenter = { ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide, ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide, ( BvhBenchmarkRand( &dwSeed ) - 0.5f ) * fSide };
+			Vec3f vExtent = { 0.5f, 0.5f, 0.5f }, vQueryMin, vQueryMax;
+			Vec3fSub( &vCenter, &vExtent, &vQueryMin );
+			Vec3fAdd( &vCenter, &vExtent, &vQueryMax );
+			QueryPerformanceCounter( &startCounter );
+			u32 dwNumOut = BvhOverlapQuery( &bvh, &vQueryMin, &vQueryMax, pResults, dwMaxObjects );
+			QueryPerformanceCounter( &endCounter );
+			fOverlapMs += ( endCounter.QuadPart - startCounter.QuadPart ) * fToMs;
+			dwOverlapHits += dwNumOut;
+			if( dwQuery < dwNumChecked )
+			{
+				u32 dwExpected = 0;
+				for( u32 dwObject = 0; dwObject < dwNumObjects; ++dwObject )
+				{
+					dwExpected += !( pMin[dwObject].x > vQueryMax.x || pMax[dwObject].x < vQueryMin.x || pMin[dwObject].y > vQueryMax.y ||
+						pMax[dwObject].y < vQueryMin.y || pMin[dwObject].z > vQueryMax.z || pMax[dwObject].z < vQueryMin.z );
+				}
+				dwFailures += dwExpected != dwNumOut ? 1 : 0;
+			}
+		}
+
+		dwFailures += bvh.dwMaxDepth <= BVH_MAX_DEPTH ? 0 : 1;
+		dwTotalFailures += dwFailures;
+		printf( "Bvh %u objects: %u nodes %u deep, build %.2fms, %u moved %.2fms, full refit %.2fms, SAH cost %.1f -> %.1f\n", dwNumObjects, bvh.dwNumNodes,
+			bvh.dwMaxDepth, fBuildMs, dwNumMoved, fUpdateMs, fRefitMs, fBuiltCost, fRefitCost );
+		printf( "    per query: frustum %.2fus (%u avg hits), ray %.2fus (%u/%u hit), overlap %.2fus (%.1f avg hits), %u failures\n",
+			( fFrustumMs * 1000.0 ) / dwNumQueries, dwFrustumHits / dwNumQueries, ( fRayMs * 1000.0 ) / dwNumQueries, dwRayHits, dwNumQueries,
+			( fOverlapMs * 1000.0 ) / dwNumQueries, (f32)dwOverlapHits / dwNumQueries, dwFailures );
+	}
+
+	//boxes half as long as their distance along x, 2% further out each from 1e-30 to 1e30. the bins are uniform so each SAH split only
+	//peels the farthest few off the rest, SAH alone builds this 77 deep
+	const u32 dwNumChained = 6900;
+	f32 fX = 1e-30f;
+	for( u32 dwObject = 0; dwObject < dwNumChained; ++dwObject, fX *= 1.02f )
+	{
+		pMin[dwObject] = { fX, 0.0f, 0.0f };
+		pMax[dwObject] = { fX * 1.5f, 1.0f, 1.0f };
+	}
+	BuildBvh( &bvh, pMin, pMax, dwNumChained );
+	u32 dwFailures = bvh.dwMaxDepth <= BVH_MAX_DEPTH ? 0 : 1;
+	u32 dwSeed = 4242;
+	for( u32 dwQuery = 0; dwQuery < 64; ++dwQuery )
+	{
+		//a box around one object with its neighbors' boxes touching or not
+		u32 dwObject = (u32)( BvhBenchmarkRand( &dwSeed ) * dwNumChained );
+		Vec3f vQueryMin = pMin[dwObject], vQueryMax = pMax[dwObject];
+		vQueryMax.x += BvhBenchmarkRand( &dwSeed ) * ( pMax[dwObject].x - pMin[dwObject].x );
+		u32 dwNumOut = BvhOverlapQuery( &bvh, &vQueryMin, &vQueryMax, pResults, dwMaxObjects );
+		u32 dwExpected = 0;
+		for( u32 dwOther = 0; dwOther < dwNumChained; ++dwOther )
+		{
+			dwExpected += !( pMin[dwOther].x > vQueryMax.x || pMax[dwOther].x < vQueryMin.x );
+		}
+		dwFailures += dwExpected == dwNumOut ? 0 : 1;
+	}
+	//along the row from beyond the farthest one, the first hit is the farthest one
+	Vec3f vOrigin = { fX * 2.0f, 0.5f, 0.5f }, vDir = { -1.0f, 0.0f, 0.0f };
+	f32 fHitT = INFINITY;
+	dwFailures += BvhRayCast( &bvh, &vOrigin, &vDir, INFINITY, &fHitT ) == dwNumChained - 1 ? 0 : 1;
+	dwTotalFailures += dwFailures;
+	printf( "Bvh %u exponentially spaced objects: %u nodes %u deep (%u max), %u failures\n", dwNumChained, bvh.dwNumNodes, bvh.dwMaxDepth, BVH_MAX_DEPTH, dwFailures );
+
+	free( pResults );
+	free( pMin );
+	DestroyBvh( &bvh );
+	return dwTotalFailures;
+}
+#endif
@@ -14,32 +14,68 @@ if "%Platform%" neq "x64" (
 set VERTEXSHADERSKINNED=VertexShaderSkinned.hlsl
 set VERTEXSHADER=VertexShader.hlsl
 set PIXELSHADER=PixelShader.hlsl
+set INDIRECTCULLSHADER=IndirectCull.hlsl
 set FILES=main.cpp
 
-set SHADERFLAGS=/WX /D__SHADER_TARGET_MAJOR=5 /D__SHADER_TARGET_MINOR=0 /DMAX_BONES=32
-set RELEASEFLAGS=/O2 /DMAIN_DEBUG=0 /DMAX_BONES=32 /DAVX_ACTIVE=0 /DRUNTIME_DEBUG_COMPILE=0 /DCOMPILED_DEBUG_CSO=0
-set AVXRELEASEFLAGS=/O2 /arch:AVX2 /DMAX_BONES=32 /DMAIN_DEBUG=0 /DAVX_ACTIVE=1 /DRUNTIME_DEBUG_COMPILE=0 /DCOMPILED_DEBUG_CSO=0
-set DEBUGFLAGS=/Zi /DMAIN_DEBUG=1 /DMAX_BONES=32 /DAVX_ACTIVE=0 /DRUNTIME_DEBUG_COMPILE=0 /DCOMPILED_DEBUG_CSO=0
+set SHADERFLAGS=/WX /D__SHADER_TARGET_MAJOR=5 /D__SHADER_TARGET_MINOR=0
+set RELEASEFLAGS=/O2 /DMAIN_DEBUG=0 /DMAX_BONES=32 /DAVX_ACTIVE=0 /DRUNTIME_DEBUG_COMPILE=0 /DCOMPILED_DEBUG_CSO=0 /DBENCHMARK_MODE=0 /DREVERSE_Z=1
+set AVXRELEASEFLAGS=/O2 /arch:AVX2 /DMAX_BONES=32 /DMAIN_DEBUG=0 /DAVX_ACTIVE=1 /DRUNTIME_DEBUG_COMPILE=0 /DCOMPILED_DEBUG_CSO=0 /DBENCHMARK_MODE=0 /DREVERSE_Z=1
+set BENCHMARKFLAGS=/O2 /arch:AVX2 /DMAIN_DEBUG=1 /DMAX_BONES=32 /DAVX_ACTIVE=1 /DRUNTIME_DEBUG_COMPILE=0 /DCOMPILED_DEBUG_CSO=0 /DBENCHMARK_MODE=1 /DREVERSE_Z=1
+set DEBUGFLAGS=/Zi /DMAIN_DEBUG=1 /DMAX_BONES=32 /DAVX_ACTIVE=0 /DRUNTIME_DEBUG_COMPILE=0 /DCOMPILED_DEBUG_CSO=0 /DBENCHMARK_MODE=0 /DREVERSE_Z=1
 
 ::TODO only link with d3dcompiler.lib if RUNTIME_DEBUG_COMPILE is 1
 set LIBS=d3d12.lib dxgi.lib dxguid.lib kernel32.lib user32.lib gdi32.lib .\libOVR\LibOVR.lib
 
 ::TODO does dxc compiler produce better performing shader code?
 
+::skinned shader permutations (MAX_BONES, ARRAY_IN_STRUCTURED_BUFFER, INSTANCED), ShaderPack lists them and packs the .cso files into one header
+cl /nologo /W3 /O2 ShaderPack.cpp /Fe: ShaderPack.exe /link /subsystem:console
+if errorlevel 1 exit /b 1
+
+::LOD chains of the meshes in Models.h (MeshLod.h), the same header for every build below
+cl /nologo /W3 /O2 MeshSimplify.cpp /Fe: MeshSimplify.exe /link /subsystem:console
+if errorlevel 1 exit /b 1
+MeshSimplify.exe modelLods.h
+if errorlevel 1 exit /b 1
+
+::CPU side of the modules on their own (Tests.cpp), nothing else gets built if one of its checks fails
+cl /nologo /W3 /O2 /DMAX_BONES=32 Tests.cpp /Fe: Tests.exe /I.\libOVR\Include /link /subsystem:console
+if errorlevel 1 exit /b 1
+Tests.exe
+if errorlevel 1 exit /b 1
+
 ::Release
 fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShader.h /Vn vertexShaderBlob
-fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADERSKINNED% /Fh vertShaderSkinned.h /Vn vertexShaderSkinnedBlob
+fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /DINSTANCED=1 /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShaderInstanced.h /Vn vertexShaderInstancedBlob
+fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /DDRAW_DATA=1 /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShaderDrawCBV.h /Vn vertexShaderDrawCBVBlob
+fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /DDRAW_DATA=2 /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShaderDrawIndex.h /Vn vertexShaderDrawIndexBlob
+for /f "tokens=1,*" %%A in ('ShaderPack.exe list skinnedPermutation') do fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% %%B /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADERSKINNED% /Fo %%A
+ShaderPack.exe pack skinnedPermutation skinnedShaders.h skinnedShaderArchive
 fxc /nologo /T ps_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %PIXELSHADER% /Fh pixelShader.h /Vn pixelShaderBlob
+fxc /nologo /T cs_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %INDIRECTCULLSHADER% /Fh indirectCull.h /Vn indirectCullBlob
 cl /nologo /W3 /GS- /Gs999999 %RELEASEFLAGS% %FILES% /Fe: BasicOVR.exe %LIBS% /I.\libOVR\Include /link /incremental:no /opt:icf /opt:ref /subsystem:windows
 
 ::Release AVX
 fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShader.h /Vn vertexShaderBlob
-fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADERSKINNED% /Fh vertShaderSkinned.h /Vn vertexShaderSkinnedBlob
+fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /DINSTANCED=1 /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShaderInstanced.h /Vn vertexShaderInstancedBlob
+fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /DDRAW_DATA=1 /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShaderDrawCBV.h /Vn vertexShaderDrawCBVBlob
+fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% /DDRAW_DATA=2 /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADER% /Fh vertShaderDrawIndex.h /Vn vertexShaderDrawIndexBlob
+for /f "tokens=1,*" %%A in ('ShaderPack.exe list skinnedPermutation') do fxc /nologo /T vs_5_0 /O3 %SHADERFLAGS% %%B /Qstrip_reflect /Qstrip_debug /Qstrip_priv %VERTEXSHADERSKINNED% /Fo %%A
+ShaderPack.exe pack skinnedPermutation skinnedShaders.h skinnedShaderArchive
 fxc /nologo /T ps_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %PIXELSHADER% /Fh pixelShader.h /Vn pixelShaderBlob
+fxc /nologo /T cs_5_0 /O3 %SHADERFLAGS% /Qstrip_reflect /Qstrip_debug /Qstrip_priv %INDIRECTCULLSHADER% /Fh indirectCull.h /Vn indirectCullBlob
 cl /nologo /W3 /GS- /Gs999999 %AVXRELEASEFLAGS% %FILES% /Fe: BasicOVRAVX2.exe %LIBS% /I.\libOVR\Include /link /incremental:no /opt:icf /opt:ref /subsystem:windows
 
 ::Debug
 fxc /nologo /T vs_5_0 /Zi %SHADERFLAGS% %VERTEXSHADER% /Fh vertShaderDebug.h /Vn vertexShaderBlob
-fxc /nologo /T vs_5_0 /Zi %SHADERFLAGS% %VERTEXSHADERSKINNED% /Fh vertShaderSkinnedDebug.h /Vn vertexShaderSkinnedBlob
+fxc /nologo /T vs_5_0 /Zi %SHADERFLAGS% /DINSTANCED=1 %VERTEXSHADER% /Fh vertShaderInstancedDebug.h /Vn vertexShaderInstancedBlob
+fxc /nologo /T vs_5_0 /Zi %SHADERFLAGS% /DDRAW_DATA=1 %VERTEXSHADER% /Fh vertShaderDrawCBVDebug.h /Vn vertexShaderDrawCBVBlob
+fxc /nologo /T vs_5_0 /Zi %SHADERFLAGS% /DDRAW_DATA=2 %VERTEXSHADER% /Fh vertShaderDrawIndexDebug.h /Vn vertexShaderDrawIndexBlob
+for /f "tokens=1,*" %%A in ('ShaderPack.exe list skinnedPermutationDebug') do fxc /nologo /T vs_5_0 /Zi %SHADERFLAGS% %%B %VERTEXSHADERSKINNED% /Fo %%A
+ShaderPack.exe pack skinnedPermutationDebug skinnedShadersDebug.h skinnedShaderArchive
 fxc /nologo /T ps_5_0 /Zi %SHADERFLAGS% %PIXELSHADER% /Fh pixelShaderDebug.h /Vn pixelShaderBlob
+fxc /nologo /T cs_5_0 /Zi %SHADERFLAGS% %INDIRECTCULLSHADER% /Fh indirectCullDebug.h /Vn indirectCullBlob
 cl /nologo /W3 /GS- /Gs999999 %DEBUGFLAGS% %FILES% /FC /Fe: BasicOVRDebug.exe %LIBS% /I.\libOVR\Include /link /incremental:no /opt:icf /opt:ref /subsystem:console
+
+::Benchmark (headless, reuses the debug shader headers, run: .\BasicOVRBenchmark.exe)
+cl /nologo /W3 /GS- /Gs999999 %BENCHMARKFLAGS% %FILES% /Fe: BasicOVRBenchmark.exe %LIBS% /I.\libOVR\Include /link /incremental:no /opt:icf /opt:ref /subsystem:console
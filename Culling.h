@@ -0,0 +1,725 @@
+//Frustum culling, bounds are kept SoA so 8 of them get tested against a plane at once with AVX2
+//everything is tested against one combined frustum that holds both eyes first, only what survives that is tested per eye
+//the output is a visibility bitmask per eye, one bit per object in the order they were added
+//the combined frustum is the usual VR trick, the widest of both eyes' tangents with the apex pushed back behind the eyes until it holds both
+
+#if AVX_ACTIVE
+#include <immintrin.h>
+#endif
+
+#define CULL_BATCH 8 //objects per AVX2 test, capacities are rounded up to this
+#define CULL_MAX_PLANES 6
+#define CULL_PARALLEL_EYES 0.9999f //|dot| of the eye orientations above which the combined frustum is built, canted displays just skip it
+
+//planes point inwards, a point p is inside when dot( n, p ) + w >= 0 for every plane
+typedef struct CullFrustum
+{
+	Vec4f planes[CULL_MAX_PLANES];
+	u32 dwNumPlanes;
+} CullFrustum;
+
+typedef struct StereoCullFrustum
+{
+	CullFrustum eyes[ovrEye_Count];
+	CullFrustum combined; //contains both eye frustums, 0 planes if it couldn't be built
+} StereoCullFrustum;
+
+typedef struct CullBoxes
+{
+	f32 *pCenterX, *pCenterY, *pCenterZ;
+	f32 *pExtentX, *pExtentY, *pExtentZ; //half sizes
+	u32 dwCount;
+	u32 dwCapacity; //multiple of CULL_BATCH, whatever is past dwCount gets tested too and masked off after
+} CullBoxes;
+
+typedef struct CullSpheres
+{
+	f32 *pX, *pY, *pZ, *pRadius;
+	u32 dwCount;
+	u32 dwCapacity;
+} CullSpheres;
+
+//bone space boxes of a skinned mesh, stored as the matrix taking the unit cube onto the box in bind pose model space
+//so one multiply with the bone's palette matrix gives the box's current world placement
+typedef struct SkinnedCullBounds
+{
+	Mat4f mBoxToBind[MAX_BONES];
+	u8 bHasVertices[MAX_BONES];
+	u32 dwNumBones;
+} SkinnedCullBounds;
+
+inline
+u32 CullMaskBytes( u32 dwCount )
+{
+	return ( dwCount + 7 ) / 8;
+}
+
+inline
+u8 CullIsVisible( u8 *a_pMask, u32 dwIdx )
+{
+	return ( a_pMask[dwIdx >> 3] >> ( dwIdx & 7 ) ) & 1;
+}
+
+inline
+void SetCullPlane( Vec4f *a_pPlane, Vec3f *a_pNormal, Vec3f *a_pPoint )
+{
+	Vec3f vNormal;
+	Vec3fNormalize( a_pNormal, &vNormal );
+	a_pPlane->x = vNormal.x;
+	a_pPlane->y = vNormal.y;
+	a_pPlane->z = vNormal.z;
+	a_pPlane->w = -Vec3fDot( &vNormal, a_pPoint );
+}
+
+//eye space is right handed looking down -z like the view matrix, the planes are rotated into world space by the eye's orientation
+//fApexBack moves the apex of the side planes behind the eye, for the combined frustum
+inline
+void InitCullFrustumFromFov( CullFrustum *a_pFrustum, ovrFovPort tanHalfFov, Quatf *a_pRot, Vec3f *a_pPos, f32 nearPlane, f32 fApexBack )
+{
+	Vec3f vEyeNormals[5] =
+	{
+		{ 1.0f, 0.0f, -tanHalfFov.LeftTan },
+		{ -1.0f, 0.0f, -tanHalfFov.RightTan },
+		{ 0.0f, -1.0f, -tanHalfFov.UpTan },
+		{ 0.0f, 1.0f, -tanHalfFov.DownTan },
+		{ 0.0f, 0.0f, -1.0f }
+	};
+	Vec3f vEyeBack = { 0.0f, 0.0f, fApexBack };
+	Vec3f vEyeNear = { 0.0f, 0.0f, -nearPlane };
+	Vec3f vApex, vNear;
+	Vec3fRotByUnitQuat( &vEyeBack, a_pRot, &vApex );
+	Vec3fAdd( &vApex, a_pPos, &vApex );
+	Vec3fRotByUnitQuat( &vEyeNear, a_pRot, &vNear );
+	Vec3fAdd( &vNear, a_pPos, &vNear );
+	for( u32 dwPlane = 0; dwPlane < 5; ++dwPlane )
+	{
+		Vec3f vNormal;
+		Vec3fRotByUnitQuat( &vEyeNormals[dwPlane], a_pRot, &vNormal );
+		SetCullPlane( &a_pFrustum->planes[dwPlane], &vNormal, dwPlane == 4 ? &vNear : &vApex );
+	}
+	a_pFrustum->dwNumPlanes = 5; //no far plane, the projection goes to infinity
+}
+
+//both eye frustums plus one that contains them: the wider of each eye's tangents, from an apex far enough behind the
+//eyes that the side planes clear both of them
+inline
+void InitStereoCullFrustum( StereoCullFrustum *a_pStereo, ovrFovPort *a_pFovs, Quatf *a_pRots, Vec3f *a_pPositions, f32 nearPlane )
+{
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		InitCullFrustumFromFov( &a_pStereo->eyes[dwEye], a_pFovs[dwEye], &a_pRots[dwEye], &a_pPositions[dwEye], nearPlane, 0.0f );
+	}
+
+	Quatf *pLeftRot = &a_pRots[ovrEye_Left];
+	Quatf *pRightRot = &a_pRots[ovrEye_Right];
+	f32 fOrientationDot = ( pLeftRot->w * pRightRot->w ) + ( pLeftRot->x * pRightRot->x ) + ( pLeftRot->y * pRightRot->y ) + ( pLeftRot->z * pRightRot->z );
+	if( fabsf( fOrientationDot ) < CULL_PARALLEL_EYES )
+	{
+		a_pStereo->combined.dwNumPlanes = 0;
+		return;
+	}
+
+	ovrFovPort combinedFov;
+	combinedFov.LeftTan = a_pFovs[ovrEye_Left].LeftTan > a_pFovs[ovrEye_Right].LeftTan ? a_pFovs[ovrEye_Left].LeftTan : a_pFovs[ovrEye_Right].LeftTan;
+	combinedFov.RightTan = a_pFovs[ovrEye_Left].RightTan > a_pFovs[ovrEye_Right].RightTan ? a_pFovs[ovrEye_Left].RightTan : a_pFovs[ovrEye_Right].RightTan;
+	combinedFov.UpTan = a_pFovs[ovrEye_Left].UpTan > a_pFovs[ovrEye_Right].UpTan ? a_pFovs[ovrEye_Left].UpTan : a_pFovs[ovrEye_Right].UpTan;
+	combinedFov.DownTan = a_pFovs[ovrEye_Left].DownTan > a_pFovs[ovrEye_Right].DownTan ? a_pFovs[ovrEye_Left].DownTan : a_pFovs[ovrEye_Right].DownTan;
+
+	//eye offset from the center in the combined frame, the other eye is at minus this
+	Vec3f vCenter, vEyeOffset, vLocalOffset;
+	Vec3fAdd( &a_pPositions[ovrEye_Left], &a_pPositions[ovrEye_Right], &vCenter );
+	Vec3fScale( &vCenter, 0.5f, &vCenter );
+	Vec3fSub( &a_pPositions[ovrEye_Right], &vCenter, &vEyeOffset );
+	Quatf qInvRot;
+	QuatfConjugate( pLeftRot, &qInvRot );
+	Vec3fRotByUnitQuat( &vEyeOffset, &qInvRot, &vLocalOffset );
+	f32 fOffX = fabsf( vLocalOffset.x ), fOffY = fabsf( vLocalOffset.y ), fOffZ = fabsf( vLocalOffset.z );
+
+	//a plane with tangent t through the apex b behind the center clears an eye frustum with a tangent <= t
+	//as long as b >= |offset along the view axis| + |offset sideways| / t
+	const f32 fTans[4] = { combinedFov.LeftTan, combinedFov.RightTan, combinedFov.UpTan, combinedFov.DownTan };
+	const f32 fSideOffsets[4] = { fOffX, fOffX, fOffY, fOffY };
+	f32 fApexBack = 0.0f;
+	for( u32 dwPlane = 0; dwPlane < 4; ++dwPlane )
+	{
+		if( fTans[dwPlane] <= 0.0f )
+		{
+			a_pStereo->combined.dwNumPlanes = 0;
+			return;
+		}
+		f32 fBack = fOffZ + ( fSideOffsets[dwPlane] / fTans[dwPlane] );
+		fApexBack = fBack > fApexBack ? fBack : fApexBack;
+	}
+	//and the near plane moves back by however far an eye sits behind the center
+	InitCullFrustumFromFov( &a_pStereo->combined, combinedFov, pLeftRot, &vCenter, nearPlane - fOffZ, fApexBack );
+}
+
+inline
+bool InitCullBoxes( CullBoxes *a_pBoxes, u32 dwCapacity )
+{
+	a_pBoxes->dwCapacity = ( ( dwCapacity + CULL_BATCH - 1 ) / CULL_BATCH ) * CULL_BATCH;
+	a_pBoxes->dwCount = 0;
+	a_pBoxes->pCenterX = (f32*)calloc( a_pBoxes->dwCapacity * 6, sizeof(f32) );
+	if( !a_pBoxes->pCenterX )
+	{
+		return false;
+	}
+	a_pBoxes->pCenterY = a_pBoxes->pCenterX + a_pBoxes->dwCapacity;
+	a_pBoxes->pCenterZ = a_pBoxes->pCenterY + a_pBoxes->dwCapacity;
+	a_pBoxes->pExtentX = a_pBoxes->pCenterZ + a_pBoxes->dwCapacity;
+	a_pBoxes->pExtentY = a_pBoxes->pExtentX + a_pBoxes->dwCapacity;
+	a_pBoxes->pExtentZ = a_pBoxes->pExtentY + a_pBoxes->dwCapacity;
+	return true;
+}
+
+inline
+void DestroyCullBoxes( CullBoxes *a_pBoxes )
+{
+	free( a_pBoxes->pCenterX );
+	a_pBoxes->pCenterX = nullptr;
+}
+
+//returns the index to look up in the masks
+inline
+u32 AddCullBox( CullBoxes *a_pBoxes, Vec3f *a_pCenter, Vec3f *a_pExtent )
+{
+#if MAIN_DEBUG
+	assert( a_pBoxes->dwCount < a_pBoxes->dwCapacity );
+#endif
+	u32 dwIdx = a_pBoxes->dwCount++;
+	a_pBoxes->pCenterX[dwIdx] = a_pCenter->x;
+	a_pBoxes->pCenterY[dwIdx] = a_pCenter->y;
+	a_pBoxes->pCenterZ[dwIdx] = a_pCenter->z;
+	a_pBoxes->pExtentX[dwIdx] = a_pExtent->x;
+	a_pBoxes->pExtentY[dwIdx] = a_pExtent->y;
+	a_pBoxes->pExtentZ[dwIdx] = a_pExtent->z;
+	return dwIdx;
+}
+
+inline
+bool InitCullSpheres( CullSpheres *a_pSpheres, u32 dwCapacity )
+{
+	a_pSpheres->dwCapacity = ( ( dwCapacity + CULL_BATCH - 1 ) / CULL_BATCH ) * CULL_BATCH;
+	a_pSpheres->dwCount = 0;
+	a_pSpheres->pX = (f32*)calloc( a_pSpheres->dwCapacity * 4, sizeof(f32) );
+	if( !a_pSpheres->pX )
+	{
+		return false;
+	}
+	a_pSpheres->pY = a_pSpheres->pX + a_pSpheres->dwCapacity;
+	a_pSpheres->pZ = a_pSpheres->pY + a_pSpheres->dwCapacity;
+	a_pSpheres->pRadius = a_pSpheres->pZ + a_pSpheres->dwCapacity;
+	return true;
+}
+
+inline
+void DestroyCullSpheres( CullSpheres *a_pSpheres )
+{
+	free( a_pSpheres->pX );
+	a_pSpheres->pX = nullptr;
+}
+
+inline
+u32 AddCullSphere( CullSpheres *a_pSpheres, Vec3f *a_pCenter, f32 fRadius )
+{
+#if MAIN_DEBUG
+	assert( a_pSpheres->dwCount < a_pSpheres->dwCapacity );
+#endif
+	u32 dwIdx = a_pSpheres->dwCount++;
+	a_pSpheres->pX[dwIdx] = a_pCenter->x;
+	a_pSpheres->pY[dwIdx] = a_pCenter->y;
+	a_pSpheres->pZ[dwIdx] = a_pCenter->z;
+	a_pSpheres->pRadius[dwIdx] = fRadius;
+	return dwIdx;
+}
+
+//world aabb of a local aabb under a row vector affine matrix
+inline
+void TransformCullBox( Vec3f *a_pCenter, Vec3f *a_pExtent, Mat4f *a_pMat, Vec3f *a_pOutCenter, Vec3f *a_pOutExtent )
+{
+	for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+	{
+		a_pOutCenter->v[dwAxis] = ( a_pCenter->x * a_pMat->m[0][dwAxis] ) + ( a_pCenter->y * a_pMat->m[1][dwAxis] ) + ( a_pCenter->z * a_pMat->m[2][dwAxis] ) + a_pMat->m[3][dwAxis];
+		a_pOutExtent->v[dwAxis] = ( a_pExtent->x * fabsf( a_pMat->m[0][dwAxis] ) ) + ( a_pExtent->y * fabsf( a_pMat->m[1][dwAxis] ) ) + ( a_pExtent->z * fabsf( a_pMat->m[2][dwAxis] ) );
+	}
+}
+
+//bone space box per bone from every vertex the bone has any weight on, a_pVertices is the interleaved vertex buffer
+//(pos at 0, joints at dwJointOffset, weights at dwJointOffset + 4, all in u32 units)
+inline
+void InitSkinnedCullBounds( SkinnedCullBounds *a_pBounds, u32 *a_pVertices, u32 dwNumVertices, u32 dwStride, u32 dwJointOffset, Mat4f *a_pInvBind, u32 dwNumBones )
+{
+	Vec3f vMin[MAX_BONES], vMax[MAX_BONES];
+	a_pBounds->dwNumBones = dwNumBones;
+	for( u32 dwBone = 0; dwBone < dwNumBones; ++dwBone )
+	{
+		vMin[dwBone] = { INFINITY, INFINITY, INFINITY };
+		vMax[dwBone] = { -INFINITY, -INFINITY, -INFINITY };
+		a_pBounds->bHasVertices[dwBone] = 0;
+	}
+	for( u32 dwVertex = 0; dwVertex < dwNumVertices; ++dwVertex )
+	{
+		u32 *pVertex = a_pVertices + ( dwVertex * dwStride );
+		Vec3f vBindPos;
+		memcpy( &vBindPos, pVertex, sizeof(Vec3f) );
+		for( u32 dwInfluence = 0; dwInfluence < 4; ++dwInfluence )
+		{
+			u32 dwBone = pVertex[dwJointOffset + dwInfluence];
+			f32 fWeight;
+			memcpy( &fWeight, &pVertex[dwJointOffset + 4 + dwInfluence], sizeof(f32) );
+			if( fWeight <= 0.0f || dwBone >= dwNumBones )
+			{
+				continue;
+			}
+			Mat4f *pInvBind = &a_pInvBind[dwBone];
+			for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+			{
+				f32 fBonePos = ( vBindPos.x * pInvBind->m[0][dwAxis] ) + ( vBindPos.y * pInvBind->m[1][dwAxis] ) + ( vBindPos.z * pInvBind->m[2][dwAxis] ) + pInvBind->m[3][dwAxis];
+				vMin[dwBone].v[dwAxis] = fBonePos < vMin[dwBone].v[dwAxis] ? fBonePos : vMin[dwBone].v[dwAxis];
+				vMax[dwBone].v[dwAxis] = fBonePos > vMax[dwBone].v[dwAxis] ? fBonePos : vMax[dwBone].v[dwAxis];
+			}
+			a_pBounds->bHasVertices[dwBone] = 1;
+		}
+	}
+	for( u32 dwBone = 0; dwBone < dwNumBones; ++dwBone )
+	{
+		if( !a_pBounds->bHasVertices[dwBone] )
+		{
+			continue;
+		}
+		//box in bone space, then back to bind space with the inverse of the (rigid) inverse bind
+		Mat4f mBox;
+		memset( &mBox, 0, sizeof(Mat4f) );
+		mBox.m[0][0] = ( vMax[dwBone].x - vMin[dwBone].x ) * 0.5f;
+		mBox.m[1][1] = ( vMax[dwBone].y - vMin[dwBone].y ) * 0.5f;
+		mBox.m[2][2] = ( vMax[dwBone].z - vMin[dwBone].z ) * 0.5f;
+		mBox.m[3][0] = ( vMax[dwBone].x + vMin[dwBone].x ) * 0.5f;
+		mBox.m[3][1] = ( vMax[dwBone].y + vMin[dwBone].y ) * 0.5f;
+		mBox.m[3][2] = ( vMax[dwBone].z + vMin[dwBone].z ) * 0.5f;
+		mBox.m[3][3] = 1.0f;
+
+		Mat4f mBind;
+		InverseUpper3x3Mat4f( &a_pInvBind[dwBone], &mBind );
+		for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+		{
+			mBind.m[3][dwAxis] = -( ( a_pInvBind[dwBone].m[3][0] * mBind.m[0][dwAxis] ) + ( a_pInvBind[dwBone].m[3][1] * mBind.m[1][dwAxis] ) + ( a_pInvBind[dwBone].m[3][2] * mBind.m[2][dwAxis] ) );
+		}
+		mBind.m[3][3] = 1.0f;
+		Mat4fMult( &mBox, &mBind, &a_pBounds->mBoxToBind[dwBone] );
+	}
+}
+
+//world aabb of the skinned mesh, the union of every bone's box under its palette matrix (bind pose model space to model space)
+//followed by the model matrix
+inline
+void SkinnedCullBox( SkinnedCullBounds *a_pBounds, Mat4f *a_pPalette, Mat4f *a_pModel, Vec3f *a_pOutCenter, Vec3f *a_pOutExtent )
+{
+	Vec3f vMin = { INFINITY, INFINITY, INFINITY };
+	Vec3f vMax = { -INFINITY, -INFINITY, -INFINITY };
+	Vec3f vUnitCenter = { 0.0f, 0.0f, 0.0f };
+	Vec3f vUnitExtent = { 1.0f, 1.0f, 1.0f };
+	for( u32 dwBone = 0; dwBone < a_pBounds->dwNumBones; ++dwBone )
+	{
+		if( !a_pBounds->bHasVertices[dwBone] )
+		{
+			continue;
+		}
+		Mat4f mBoxToModel, mBoxToWorld;
+		Mat4fMult( &a_pBounds->mBoxToBind[dwBone], &a_pPalette[dwBone], &mBoxToModel );
+		Mat4fMult( &mBoxToModel, a_pModel, &mBoxToWorld );
+		Vec3f vCenter, vExtent;
+		TransformCullBox( &vUnitCenter, &vUnitExtent, &mBoxToWorld, &vCenter, &vExtent );
+		for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+		{
+			f32 fLow = vCenter.v[dwAxis] - vExtent.v[dwAxis];
+			f32 fHigh = vCenter.v[dwAxis] + vExtent.v[dwAxis];
+			vMin.v[dwAxis] = fLow < vMin.v[dwAxis] ? fLow : vMin.v[dwAxis];
+			vMax.v[dwAxis] = fHigh > vMax.v[dwAxis] ? fHigh : vMax.v[dwAxis];
+		}
+	}
+	for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+	{
+		a_pOutCenter->v[dwAxis] = ( vMax.v[dwAxis] + vMin.v[dwAxis] ) * 0.5f;
+		a_pOutExtent->v[dwAxis] = ( vMax.v[dwAxis] - vMin.v[dwAxis] ) * 0.5f;
+	}
+}
+
+inline
+u8 CullBoxInFrustum( CullFrustum *a_pFrustum, f32 fCX, f32 fCY, f32 fCZ, f32 fEX, f32 fEY, f32 fEZ )
+{
+	for( u32 dwPlane = 0; dwPlane < a_pFrustum->dwNumPlanes; ++dwPlane )
+	{
+		Vec4f *pPlane = &a_pFrustum->planes[dwPlane];
+		f32 fDist = ( pPlane->x * fCX ) + ( pPlane->y * fCY ) + ( pPlane->z * fCZ ) + pPlane->w;
+		f32 fRadius = ( fabsf( pPlane->x ) * fEX ) + ( fabsf( pPlane->y ) * fEY ) + ( fabsf( pPlane->z ) * fEZ );
+		if( fDist + fRadius < 0.0f )
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+inline
+u8 CullSphereInFrustum( CullFrustum *a_pFrustum, f32 fX, f32 fY, f32 fZ, f32 fRadius )
+{
+	for( u32 dwPlane = 0; dwPlane < a_pFrustum->dwNumPlanes; ++dwPlane )
+	{
+		Vec4f *pPlane = &a_pFrustum->planes[dwPlane];
+		f32 fDist = ( pPlane->x * fX ) + ( pPlane->y * fY ) + ( pPlane->z * fZ ) + pPlane->w;
+		if( fDist + fRadius < 0.0f )
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//the padding past dwCount in the last mask byte is cleared so callers can count bits
+inline
+void CullClearMaskTail( u8 *a_pMask, u32 dwCount )
+{
+	if( dwCount & 7 )
+	{
+		a_pMask[dwCount >> 3] &= (u8)( ( 1 << ( dwCount & 7 ) ) - 1 );
+	}
+}
+
+//one object at a time, the reference the AVX2 path is checked against and the path for non AVX builds
+inline
+void StereoCullBoxesScalar( StereoCullFrustum *a_pStereo, CullBoxes *a_pBoxes, u8 *a_pLeftMask, u8 *a_pRightMask )
+{
+	memset( a_pLeftMask, 0, CullMaskBytes( a_pBoxes->dwCount ) );
+	memset( a_pRightMask, 0, CullMaskBytes( a_pBoxes->dwCount ) );
+	for( u32 dwIdx = 0; dwIdx < a_pBoxes->dwCount; ++dwIdx )
+	{
+		f32 fCX = a_pBoxes->pCenterX[dwIdx], fCY = a_pBoxes->pCenterY[dwIdx], fCZ = a_pBoxes->pCenterZ[dwIdx];
+		f32 fEX = a_pBoxes->pExtentX[dwIdx], fEY = a_pBoxes->pExtentY[dwIdx], fEZ = a_pBoxes->pExtentZ[dwIdx];
+		if( !CullBoxInFrustum( &a_pStereo->combined, fCX, fCY, fCZ, fEX, fEY, fEZ ) )
+		{
+			continue;
+		}
+		a_pLeftMask[dwIdx >> 3] |= (u8)( CullBoxInFrustum( &a_pStereo->eyes[ovrEye_Left], fCX, fCY, fCZ, fEX, fEY, fEZ ) << ( dwIdx & 7 ) );
+		a_pRightMask[dwIdx >> 3] |= (u8)( CullBoxInFrustum( &a_pStereo->eyes[ovrEye_Right], fCX, fCY, fCZ, fEX, fEY, fEZ ) << ( dwIdx & 7 ) );
+	}
+}
+
+inline
+void StereoCullSpheresScalar( StereoCullFrustum *a_pStereo, CullSpheres *a_pSpheres, u8 *a_pLeftMask, u8 *a_pRightMask )
+{
+	memset( a_pLeftMask, 0, CullMaskBytes( a_pSpheres->dwCount ) );
+	memset( a_pRightMask, 0, CullMaskBytes( a_pSpheres->dwCount ) );
+	for( u32 dwIdx = 0; dwIdx < a_pSpheres->dwCount; ++dwIdx )
+	{
+		f32 fX = a_pSpheres->pX[dwIdx], fY = a_pSpheres->pY[dwIdx], fZ = a_pSpheres->pZ[dwIdx], fRadius = a_pSpheres->pRadius[dwIdx];
+		if( !CullSphereInFrustum( &a_pStereo->combined, fX, fY, fZ, fRadius ) )
+		{
+			continue;
+		}
+		a_pLeftMask[dwIdx >> 3] |= (u8)( CullSphereInFrustum( &a_pStereo->eyes[ovrEye_Left], fX, fY, fZ, fRadius ) << ( dwIdx & 7 ) );
+		a_pRightMask[dwIdx >> 3] |= (u8)( CullSphereInFrustum( &a_pStereo->eyes[ovrEye_Right], fX, fY, fZ, fRadius ) << ( dwIdx & 7 ) );
+	}
+}
+
+#if AVX_ACTIVE
+//8 lanes against every plane of the frustum, returns the lanes inside as a movemask
+//mul then add (no fma) so the result matches the scalar path bit for bit
+inline
+u32 CullBoxesInFrustumAvx2( CullFrustum *a_pFrustum, __m256 vCX, __m256 vCY, __m256 vCZ, __m256 vEX, __m256 vEY, __m256 vEZ )
+{
+	__m256 vAbsMask = _mm256_castsi256_ps( _mm256_set1_epi32( 0x7fffffff ) );
+	__m256 vOutside = _mm256_setzero_ps();
+	for( u32 dwPlane = 0; dwPlane < a_pFrustum->dwNumPlanes; ++dwPlane )
+	{
+		Vec4f *pPlane = &a_pFrustum->planes[dwPlane];
+		__m256 vNX = _mm256_set1_ps( pPlane->x );
+		__m256 vNY = _mm256_set1_ps( pPlane->y );
+		__m256 vNZ = _mm256_set1_ps( pPlane->z );
+		__m256 vDist = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vNX, vCX ), _mm256_mul_ps( vNY, vCY ) ), _mm256_mul_ps( vNZ, vCZ ) ), _mm256_set1_ps( pPlane->w ) );
+		__m256 vRadius = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_and_ps( vNX, vAbsMask ), vEX ), _mm256_mul_ps( _mm256_and_ps( vNY, vAbsMask ), vEY ) ), _mm256_mul_ps( _mm256_and_ps( vNZ, vAbsMask ), vEZ ) );
+		vOutside = _mm256_or_ps( vOutside, _mm256_cmp_ps( _mm256_add_ps( vDist, vRadius ), _mm256_setzero_ps(), _CMP_LT_OQ ) );
+	}
+	return (u32)( ~_mm256_movemask_ps( vOutside ) ) & 0xff;
+}
+
+inline
+u32 CullSpheresInFrustumAvx2( CullFrustum *a_pFrustum, __m256 vX, __m256 vY, __m256 vZ, __m256 vRadius )
+{
+	__m256 vOutside = _mm256_setzero_ps();
+	for( u32 dwPlane = 0; dwPlane < a_pFrustum->dwNumPlanes; ++dwPlane )
+	{
+		Vec4f *pPlane = &a_pFrustum->planes[dwPlane];
+		__m256 vDist = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( pPlane->x ), vX ), _mm256_mul_ps( _mm256_set1_ps( pPlane->y ), vY ) ), _mm256_mul_ps( _mm256_set1_ps( pPlane->z ), vZ ) ), _mm256_set1_ps( pPlane->w ) );
+		vOutside = _mm256_or_ps( vOutside, _mm256_cmp_ps( _mm256_add_ps( vDist, vRadius ), _mm256_setzero_ps(), _CMP_LT_OQ ) );
+	}
+	return (u32)( ~_mm256_movemask_ps( vOutside ) ) & 0xff;
+}
+
+//a batch that misses the combined frustum costs one frustum test instead of two
+inline
+void StereoCullBoxesAvx2( StereoCullFrustum *a_pStereo, CullBoxes *a_pBoxes, u8 *a_pLeftMask, u8 *a_pRightMask )
+{
+	for( u32 dwBase = 0; dwBase < a_pBoxes->dwCount; dwBase += CULL_BATCH )
+	{
+		__m256 vCX = _mm256_loadu_ps( a_pBoxes->pCenterX + dwBase );
+		__m256 vCY = _mm256_loadu_ps( a_pBoxes->pCenterY + dwBase );
+		__m256 vCZ = _mm256_loadu_ps( a_pBoxes->pCenterZ + dwBase );
+		__m256 vEX = _mm256_loadu_ps( a_pBoxes->pExtentX + dwBase );
+		__m256 vEY = _mm256_loadu_ps( a_pBoxes->pExtentY + dwBase );
+		__m256 vEZ = _mm256_loadu_ps( a_pBoxes->pExtentZ + dwBase );
+		u32 dwCombined = CullBoxesInFrustumAvx2( &a_pStereo->combined, vCX, vCY, vCZ, vEX, vEY, vEZ );
+		if( !dwCombined )
+		{
+			a_pLeftMask[dwBase >> 3] = 0;
+			a_pRightMask[dwBase >> 3] = 0;
+			continue;
+		}
+		a_pLeftMask[dwBase >> 3] = (u8)( dwCombined & CullBoxesInFrustumAvx2( &a_pStereo->eyes[ovrEye_Left], vCX, vCY, vCZ, vEX, vEY, vEZ ) );
+		a_pRightMask[dwBase >> 3] = (u8)( dwCombined & CullBoxesInFrustumAvx2( &a_pStereo->eyes[ovrEye_Right], vCX, vCY, vCZ, vEX, vEY, vEZ ) );
+	}
+	CullClearMaskTail( a_pLeftMask, a_pBoxes->dwCount );
+	CullClearMaskTail( a_pRightMask, a_pBoxes->dwCount );
+}
+
+inline
+void StereoCullSpheresAvx2( StereoCullFrustum *a_pStereo, CullSpheres *a_pSpheres, u8 *a_pLeftMask, u8 *a_pRightMask )
+{
+	for( u32 dwBase = 0; dwBase < a_pSpheres->dwCount; dwBase += CULL_BATCH )
+	{
+		__m256 vX = _mm256_loadu_ps( a_pSpheres->pX + dwBase );
+		__m256 vY = _mm256_loadu_ps( a_pSpheres->pY + dwBase );
+		__m256 vZ = _mm256_loadu_ps( a_pSpheres->pZ + dwBase );
+		__m256 vRadius = _mm256_loadu_ps( a_pSpheres->pRadius + dwBase );
+		u32 dwCombined = CullSpheresInFrustumAvx2( &a_pStereo->combined, vX, vY, vZ, vRadius );
+		if( !dwCombined )
+		{
+			a_pLeftMask[dwBase >> 3] = 0;
+			a_pRightMask[dwBase >> 3] = 0;
+			continue;
+		}
+		a_pLeftMask[dwBase >> 3] = (u8)( dwCombined & CullSpheresInFrustumAvx2( &a_pStereo->eyes[ovrEye_Left], vX, vY, vZ, vRadius ) );
+		a_pRightMask[dwBase >> 3] = (u8)( dwCombined & CullSpheresInFrustumAvx2( &a_pStereo->eyes[ovrEye_Right], vX, vY, vZ, vRadius ) );
+	}
+	CullClearMaskTail( a_pLeftMask, a_pSpheres->dwCount );
+	CullClearMaskTail( a_pRightMask, a_pSpheres->dwCount );
+}
+#endif
+
+//masks need CullMaskBytes( count ) bytes each
+inline
+void StereoCullBoxes( StereoCullFrustum *a_pStereo, CullBoxes *a_pBoxes, u8 *a_pLeftMask, u8 *a_pRightMask )
+{
+#if AVX_ACTIVE
+	StereoCullBoxesAvx2( a_pStereo, a_pBoxes, a_pLeftMask, a_pRightMask );
+#else
+	StereoCullBoxesScalar( a_pStereo, a_pBoxes, a_pLeftMask, a_pRightMask );
+#endif
+}
+
+inline
+void StereoCullSpheres( StereoCullFrustum *a_pStereo, CullSpheres *a_pSpheres, u8 *a_pLeftMask, u8 *a_pRightMask )
+{
+#if AVX_ACTIVE
+	StereoCullSpheresAvx2( a_pStereo, a_pSpheres, a_pLeftMask, a_pRightMask );
+#else
+	StereoCullSpheresScalar( a_pStereo, a_pSpheres, a_pLeftMask, a_pRightMask );
+#endif
+}
+
+inline
+u32 CullCountVisible( u8 *a_pMask, u32 dwCount )
+{
+	u32 dwVisible = 0;
+	for( u32 dwByte = 0; dwByte < CullMaskBytes( dwCount ); ++dwByte )
+	{
+		u32 dwBits = a_pMask[dwByte];
+		while( dwBits )
+		{
+			dwBits &= dwBits - 1;
+			++dwVisible;
+		}
+	}
+	return dwVisible;
+}
+
+#if BENCHMARK_MODE
+//random scene around a standing player, most of it behind or beside them like a real level
+//checks the AVX2 masks against the scalar ones, the stereo masks against culling each eye on its own, that nothing inside an eye's
+//frustum gets culled and that the hand boxes hold the skinned mesh
+u32 BenchmarkCulling()
+{
+	const u32 dwNumObjects = 16384;
+	const u32 dwIterations = 200;
+	CullBoxes boxes;
+	CullSpheres spheres;
+	memset( &boxes, 0, sizeof(boxes) );
+	memset( &spheres, 0, sizeof(spheres) );
+	u32 dwMaskBytes = CullMaskBytes( dwNumObjects );
+	u8 *pMasks = (u8*)malloc( dwMaskBytes * 4 );
+	if( !pMasks || !InitCullBoxes( &boxes, dwNumObjects ) || !InitCullSpheres( &spheres, dwNumObjects ) )
+	{
+		printf( "Culling: out of memory\n" );
+		free( pMasks );
+		DestroyCullBoxes( &boxes );
+		return 1;
+	}
+	u8 *pScalarLeft = pMasks, *pScalarRight = pMasks + dwMaskBytes, *pLeft = pMasks + ( 2 * dwMaskBytes ), *pRight = pMasks + ( 3 * dwMaskBytes );
+	u32 dwSeed = 777;
+	for( u32 dwIdx = 0; dwIdx < dwNumObjects; ++dwIdx )
+	{
+		f32 fRand[5];
+		for( u32 dwRand = 0; dwRand < 5; ++dwRand )
+		{
+			dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+			fRand[dwRand] = ( dwSeed >> 8 ) / (f32)( 1 << 24 );
+		}
+		Vec3f vCenter = { ( fRand[0] - 0.5f ) * 200.0f, ( fRand[1] - 0.5f ) * 20.0f, ( fRand[2] - 0.5f ) * 200.0f };
+		Vec3f vExtent = { 0.05f + fRand[3], 0.05f + fRand[4], 0.05f + ( fRand[3] * fRand[4] ) };
+		AddCullBox( &boxes, &vCenter, &vExtent );
+		AddCullSphere( &spheres, &vCenter, Vec3fLength( &vExtent ) );
+	}
+
+	//CV1 fovs, eyes 64mm apart at standing height, looking a bit to the side and down
+	ovrFovPort fovs[ovrEye_Count];
+	fovs[0].UpTan = 1.3316f; fovs[0].DownTan = 1.3316f; fovs[0].LeftTan = 1.0586f; fovs[0].RightTan = 1.0924f;
+	fovs[1].UpTan = 1.3316f; fovs[1].DownTan = 1.3316f; fovs[1].LeftTan = 1.0924f; fovs[1].RightTan = 1.0586f;
+	Vec3f vYawAxis = { 0.0f, 1.0f, 0.0f };
+	Vec3f vPitchAxis = { 1.0f, 0.0f, 0.0f };
+	Quatf qYaw, qPitch, qHead;
+	InitUnitQuatf( &qYaw, 30.0f, &vYawAxis );
+	InitUnitQuatf( &qPitch, -15.0f, &vPitchAxis );
+	QuatfMult( &qYaw, &qPitch, &qHead );
+	Quatf qEyeRots[ovrEye_Count] = { qHead, qHead };
+	Vec3f vEyePositions[ovrEye_Count];
+	Vec3f vHeadPos = { 0.0f, 1.6f, 0.0f };
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		Vec3f vLocalEye = { dwEye == ovrEye_Left ? -0.032f : 0.032f, 0.0f, 0.0f };
+		Vec3fRotByUnitQuat( &vLocalEye, &qHead, &vEyePositions[dwEye] );
+		Vec3fAdd( &vEyePositions[dwEye], &vHeadPos, &vEyePositions[dwEye] );
+	}
+	StereoCullFrustum stereo;
+	InitStereoCullFrustum( &stereo, fovs, qEyeRots, vEyePositions, EYE_NEAR_PLANE );
+
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	f64 fScalarNs[2], fSimdNs[2];
+	u32 dwMismatches = 0;
+	u32 dwStereoMismatches = 0;
+	for( u32 bSpheres = 0; bSpheres < 2; ++bSpheres )
+	{
+		QueryPerformanceCounter( &startCounter );
+		for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+		{
+			if( bSpheres ) StereoCullSpheresScalar( &stereo, &spheres, pScalarLeft, pScalarRight );
+			else           StereoCullBoxesScalar( &stereo, &boxes, pScalarLeft, pScalarRight );
+		}
+		QueryPerformanceCounter( &endCounter );
+		fScalarNs[bSpheres] = ( 1000000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwIterations * dwNumObjects );
+
+		QueryPerformanceCounter( &startCounter );
+		for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+		{
+			if( bSpheres ) StereoCullSpheres( &stereo, &spheres, pLeft, pRight );
+			else           StereoCullBoxes( &stereo, &boxes, pLeft, pRight );
+		}
+		QueryPerformanceCounter( &endCounter );
+		fSimdNs[bSpheres] = ( 1000000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwIterations * dwNumObjects );
+		dwMismatches += memcmp( pScalarLeft, pLeft, dwMaskBytes ) != 0 ? 1 : 0;
+		dwMismatches += memcmp( pScalarRight, pRight, dwMaskBytes ) != 0 ? 1 : 0;
+		//skipping what misses the combined frustum must not lose anything either eye sees on its own
+		for( u32 dwIdx = 0; dwIdx < dwNumObjects; ++dwIdx )
+		{
+			for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+			{
+				CullFrustum *pEye = &stereo.eyes[dwEye];
+				u8 bMono = bSpheres ? CullSphereInFrustum( pEye, spheres.pX[dwIdx], spheres.pY[dwIdx], spheres.pZ[dwIdx], spheres.pRadius[dwIdx] ) :
+					CullBoxInFrustum( pEye, boxes.pCenterX[dwIdx], boxes.pCenterY[dwIdx], boxes.pCenterZ[dwIdx], boxes.pExtentX[dwIdx], boxes.pExtentY[dwIdx], boxes.pExtentZ[dwIdx] );
+				dwStereoMismatches += CullIsVisible( dwEye == ovrEye_Left ? pLeft : pRight, dwIdx ) == bMono ? 0 : 1;
+			}
+		}
+		printf( "Culling %s: %u objects, %u visible left %u right, %.2fns/object scalar, %.2fns/object %s\n", bSpheres ? "spheres" : "boxes", dwNumObjects,
+			CullCountVisible( pLeft, dwNumObjects ), CullCountVisible( pRight, dwNumObjects ), fScalarNs[bSpheres], fSimdNs[bSpheres], AVX_ACTIVE ? "avx2" : "scalar" );
+	}
+
+	//every center that projects inside an eye's clip volume has to come out visible for that eye, and be inside the combined frustum
+	u32 dwFalseCulls = 0;
+	u32 dwOutsideCombined = 0;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		Mat4f mView, mProj, mVP;
+		InitViewMat4ByQuatf( &mView, &qEyeRots[dwEye], &vEyePositions[dwEye] );
+		InitReverseZInfinitePerspectiveProjectionMat4fOculusDirectXRH( &mProj, fovs[dwEye], EYE_NEAR_PLANE );
+		Mat4fMult( &mView, &mProj, &mVP );
+		u8 *pEyeMask = dwEye == ovrEye_Left ? pLeft : pRight;
+		for( u32 dwIdx = 0; dwIdx < dwNumObjects; ++dwIdx )
+		{
+			f32 fClip[4];
+			for( u32 dwCol = 0; dwCol < 4; ++dwCol )
+			{
+				fClip[dwCol] = ( spheres.pX[dwIdx] * mVP.m[0][dwCol] ) + ( spheres.pY[dwIdx] * mVP.m[1][dwCol] ) + ( spheres.pZ[dwIdx] * mVP.m[2][dwCol] ) + mVP.m[3][dwCol];
+			}
+			u8 bInside = fClip[3] > 0.0f && fabsf( fClip[0] ) <= fClip[3] && fabsf( fClip[1] ) <= fClip[3] && fClip[2] >= 0.0f && fClip[2] <= fClip[3];
+			if( bInside )
+			{
+				dwFalseCulls += CullIsVisible( pEyeMask, dwIdx ) ? 0 : 1;
+				dwOutsideCombined += CullSphereInFrustum( &stereo.combined, spheres.pX[dwIdx], spheres.pY[dwIdx], spheres.pZ[dwIdx], 0.0f ) ? 0 : 1;
+			}
+		}
+	}
+
+	//skin the hand with a made up palette on the CPU, every vertex has to land in the skinned box
+	const u32 dwHandStride = 18;
+	const u32 dwNumHandVertices = sizeof(handVertices) / ( sizeof(u32) * dwHandStride );
+	SkinnedCullBounds handBounds;
+	InitSkinnedCullBounds( &handBounds, handVertices, dwNumHandVertices, dwHandStride, 6, handInvBind, handBonesCount );
+	Mat4f mPalette[MAX_BONES];
+	for( u32 dwBone = 0; dwBone < handBonesCount; ++dwBone )
+	{
+		Vec3f vAxis = { 0.3f, 1.0f - ( 0.1f * dwBone ), 0.2f * dwBone };
+		Vec3fNormalize( &vAxis, &vAxis );
+		Quatf qBone;
+		InitUnitQuatf( &qBone, 20.0f * dwBone, &vAxis );
+		Vec3f vBonePos = { 0.01f * dwBone, -0.02f, 0.005f * dwBone };
+		InitModelMat4ByQuatf( &mPalette[dwBone], &qBone, &vBonePos );
+	}
+	Mat4f mHandModel;
+	Vec3f vHandPos = { 0.2f, 1.2f, -0.4f };
+	InitModelMat4ByQuatf( &mHandModel, &qHead, &vHandPos );
+	Vec3f vHandCenter, vHandExtent;
+	SkinnedCullBox( &handBounds, mPalette, &mHandModel, &vHandCenter, &vHandExtent );
+	u32 dwOutsideHandBox = 0;
+	for( u32 dwVertex = 0; dwVertex < dwNumHandVertices; ++dwVertex )
+	{
+		u32 *pVertex = handVertices + ( dwVertex * dwHandStride );
+		Vec3f vBindPos;
+		memcpy( &vBindPos, pVertex, sizeof(Vec3f) );
+		Mat4f mSkin;
+		memset( &mSkin, 0, sizeof(Mat4f) );
+		for( u32 dwInfluence = 0; dwInfluence < 4; ++dwInfluence )
+		{
+			f32 fWeight;
+			memcpy( &fWeight, &pVertex[10 + dwInfluence], sizeof(f32) );
+			for( u32 dwElem = 0; dwElem < 16; ++dwElem )
+			{
+				( &mSkin.m[0][0] )[dwElem] += fWeight * ( &mPalette[pVertex[6 + dwInfluence]].m[0][0] )[dwElem];
+			}
+		}
+		Mat4f mSkinWorld;
+		Mat4fMult( &mSkin, &mHandModel, &mSkinWorld );
+		for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+		{
+			f32 fWorld = ( vBindPos.x * mSkinWorld.m[0][dwAxis] ) + ( vBindPos.y * mSkinWorld.m[1][dwAxis] ) + ( vBindPos.z * mSkinWorld.m[2][dwAxis] ) + mSkinWorld.m[3][dwAxis];
+			dwOutsideHandBox += fabsf( fWorld - vHandCenter.v[dwAxis] ) > vHandExtent.v[dwAxis] + 1e-5f ? 1 : 0;
+		}
+	}
+	u32 dwFailures = dwMismatches + dwStereoMismatches + dwFalseCulls + dwOutsideCombined + dwOutsideHandBox;
+	printf( "Culling: %u avx2/scalar mask mismatches, %u stereo/per eye mismatches, %u visible centers culled, %u outside the combined frustum, %u hand vertex axes outside the skinned box (hand box %.3f x %.3f x %.3f m), %u failures\n",
+		dwMismatches, dwStereoMismatches, dwFalseCulls, dwOutsideCombined, dwOutsideHandBox, vHandExtent.x * 2.0f, vHandExtent.y * 2.0f, vHandExtent.z * 2.0f, dwFailures );
+
+	free( pMasks );
+	DestroyCullBoxes( &boxes );
+	DestroyCullSpheres( &spheres );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,323 @@
+//Depth layer, each eye's depth goes to the compositor in its own swap chain next to the color one (ovrLayerEyeFovDepth)
+//so positional timewarp and ASW can reproject by the scene's actual depth instead of assuming everything is at infinity
+//the compositor only gets 3 numbers to turn a depth sample back into meters, ovrTimewarpProjectionDesc
+//https://developer.oculus.com/documentation/native/pc/dg-render-advanced/ (Layers, EyeFovDepth)
+
+#define EYE_NEAR_PLANE 0.01f
+#define EYE_FAR_PLANE 1000.0f //standard z only, reverse z has no far plane
+
+#if REVERSE_Z
+#define EYE_DEPTH_CLEAR 0.0f
+#define EYE_DEPTH_FUNC D3D12_COMPARISON_FUNC_GREATER
+#else
+#define EYE_DEPTH_CLEAR 1.0f
+#define EYE_DEPTH_FUNC D3D12_COMPARISON_FUNC_LESS
+#endif
+
+//Oculus eye projections, built from each eye's fov tangents since the eye frusta are off center
+inline
+void InitPerspectiveProjectionMat4fOculusDirectXLH( Mat4f *a_pMat, ovrFovPort tanHalfFov, f32 nearPlane, f32 farPlane )
+{
+    f32 projXScale = 2.0f / ( tanHalfFov.LeftTan + tanHalfFov.RightTan );
+    f32 projXOffset = ( tanHalfFov.LeftTan - tanHalfFov.RightTan ) * projXScale * 0.5f;
+    f32 projYScale = 2.0f / ( tanHalfFov.UpTan + tanHalfFov.DownTan );
+    f32 projYOffset = ( tanHalfFov.UpTan - tanHalfFov.DownTan ) * projYScale * 0.5f;
+	f32 nMinF = farPlane/(nearPlane-farPlane);
+	a_pMat->m[0][0] = projXScale;  a_pMat->m[0][1] = 0;            a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;           a_pMat->m[1][1] = projYScale;   a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = projXOffset; a_pMat->m[2][1] = -projYOffset; a_pMat->m[2][2] = -nMinF;          a_pMat->m[2][3] = 1.0f;
+	a_pMat->m[3][0] = 0;           a_pMat->m[3][1] = 0;            a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
+}
+
+
+inline
+void InitPerspectiveProjectionMat4fOculusDirectXRH( Mat4f *a_pMat, ovrFovPort tanHalfFov, f32 nearPlane, f32 farPlane )
+{
+    f32 projXScale = 2.0f / ( tanHalfFov.LeftTan + tanHalfFov.RightTan );
+    f32 projXOffset = ( tanHalfFov.LeftTan - tanHalfFov.RightTan ) * projXScale * 0.5f;
+    f32 projYScale = 2.0f / ( tanHalfFov.UpTan + tanHalfFov.DownTan );
+    f32 projYOffset = ( tanHalfFov.UpTan - tanHalfFov.DownTan ) * projYScale * 0.5f;
+	f32 nMinF = farPlane/(nearPlane-farPlane);
+	a_pMat->m[0][0] = projXScale;   a_pMat->m[0][1] = 0;           a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;            a_pMat->m[1][1] = projYScale;  a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = -projXOffset; a_pMat->m[2][1] = projYOffset; a_pMat->m[2][2] = nMinF;           a_pMat->m[2][3] = -1.0f;
+	a_pMat->m[3][0] = 0;            a_pMat->m[3][1] = 0;           a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
+}
+
+//reverse z with the far plane at infinity, depth = near/distance so 1 at the near plane and 0 at infinity
+//floats are densest near 0 which cancels out the 1/z falloff, needs a GREATER depth test and a 0 clear
+inline
+void InitReverseZInfinitePerspectiveProjectionMat4fOculusDirectXLH( Mat4f *a_pMat, ovrFovPort tanHalfFov, f32 nearPlane )
+{
+    f32 projXScale = 2.0f / ( tanHalfFov.LeftTan + tanHalfFov.RightTan );
+    f32 projXOffset = ( tanHalfFov.LeftTan - tanHalfFov.RightTan ) * projXScale * 0.5f;
+    f32 projYScale = 2.0f / ( tanHalfFov.UpTan + tanHalfFov.DownTan );
+    f32 projYOffset = ( tanHalfFov.UpTan - tanHalfFov.DownTan ) * projYScale * 0.5f;
+	a_pMat->m[0][0] = projXScale;  a_pMat->m[0][1] = 0;            a_pMat->m[0][2] = 0;         a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;           a_pMat->m[1][1] = projYScale;   a_pMat->m[1][2] = 0;         a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = projXOffset; a_pMat->m[2][1] = -projYOffset; a_pMat->m[2][2] = 0;         a_pMat->m[2][3] = 1.0f;
+	a_pMat->m[3][0] = 0;           a_pMat->m[3][1] = 0;            a_pMat->m[3][2] = nearPlane; a_pMat->m[3][3] = 0;
+}
+
+inline
+void InitReverseZInfinitePerspectiveProjectionMat4fOculusDirectXRH( Mat4f *a_pMat, ovrFovPort tanHalfFov, f32 nearPlane )
+{
+    f32 projXScale = 2.0f / ( tanHalfFov.LeftTan + tanHalfFov.RightTan );
+    f32 projXOffset = ( tanHalfFov.LeftTan - tanHalfFov.RightTan ) * projXScale * 0.5f;
+    f32 projYScale = 2.0f / ( tanHalfFov.UpTan + tanHalfFov.DownTan );
+    f32 projYOffset = ( tanHalfFov.UpTan - tanHalfFov.DownTan ) * projYScale * 0.5f;
+	a_pMat->m[0][0] = projXScale;   a_pMat->m[0][1] = 0;           a_pMat->m[0][2] = 0;         a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;            a_pMat->m[1][1] = projYScale;  a_pMat->m[1][2] = 0;         a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = -projXOffset; a_pMat->m[2][1] = projYOffset; a_pMat->m[2][2] = 0;         a_pMat->m[2][3] = -1.0f;
+	a_pMat->m[3][0] = 0;            a_pMat->m[3][1] = 0;           a_pMat->m[3][2] = nearPlane; a_pMat->m[3][3] = 0;
+}
+
+inline
+void InitEyeProjection( Mat4f *a_pProj, ovrFovPort tanHalfFov )
+{
+#if REVERSE_Z
+	InitReverseZInfinitePerspectiveProjectionMat4fOculusDirectXRH( a_pProj, tanHalfFov, EYE_NEAR_PLANE );
+#else
+	InitPerspectiveProjectionMat4fOculusDirectXRH( a_pProj, tanHalfFov, EYE_NEAR_PLANE, EYE_FAR_PLANE );
+#endif
+}
+
+//ovrTimewarpProjectionDesc_FromProjection without LibOVR's utility code
+//libOVR's matrices are column vector (clip = M * v) so its [2][3] and [3][2] are our [3][2] and [2][3]
+inline
+void InitTimewarpProjectionDesc( Mat4f *a_pProj, ovrTimewarpProjectionDesc *a_pDesc )
+{
+	a_pDesc->Projection22 = a_pProj->m[2][2];
+	a_pDesc->Projection23 = a_pProj->m[3][2];
+	a_pDesc->Projection32 = a_pProj->m[2][3];
+}
+
+//what the compositor does with the desc, depth = ( P22*z + P23 ) / ( P32*z ) solved for view space z (negative in front of us, RH)
+inline
+f32 TimewarpDepthToViewZ( ovrTimewarpProjectionDesc *a_pDesc, f32 fDepth )
+{
+	return a_pDesc->Projection23 / ( ( fDepth * a_pDesc->Projection32 ) - a_pDesc->Projection22 );
+}
+
+//the other way, the depth a point fDistance meters in front of the eye ends up with in a D32_FLOAT target
+inline
+f32 TimewarpDistanceToDepth( ovrTimewarpProjectionDesc *a_pDesc, f32 fDistance )
+{
+	if( isinf( fDistance ) )
+	{
+		//the limit, P22 / P32. inf * P22 is NaN when P22 is 0 (reverse z) and the limit there would come out as -0, whose bits aren't next to 0's
+		f32 fDepth = a_pDesc->Projection22 / a_pDesc->Projection32;
+		return fDepth == 0.0f ? 0.0f : fDepth;
+	}
+	f32 fViewZ = -fDistance;
+	return ( ( a_pDesc->Projection22 * fViewZ ) + a_pDesc->Projection23 ) / ( a_pDesc->Projection32 * fViewZ );
+}
+
+//Depth precision analysis, works off the desc so any of the projections can be compared
+//depth values are positive floats so their bit patterns are in order, subtracting them counts the representable depths in between
+
+//meters between the depth value a point at fDistance lands on and the next representable one further away
+//anything closer together than this can z-fight
+inline
+f64 DepthResolutionAt( ovrTimewarpProjectionDesc *a_pDesc, f32 fDistance )
+{
+	f32 fDepth = TimewarpDistanceToDepth( a_pDesc, fDistance );
+	f32 fFurtherDepth = TimewarpDistanceToDepth( a_pDesc, fDistance * 1.001f );
+	u32 dwBits;
+	memcpy( &dwBits, &fDepth, sizeof(u32) );
+	dwBits = fFurtherDepth < fDepth ? dwBits - 1 : dwBits + 1;
+	f32 fNextDepth;
+	memcpy( &fNextDepth, &dwBits, sizeof(u32) );
+	//linearize in doubles so the error we measure is the depth buffer's and not ours
+	f64 fNextViewZ = (f64)a_pDesc->Projection23 / ( ( (f64)fNextDepth * a_pDesc->Projection32 ) - a_pDesc->Projection22 );
+	return fabs( -fNextViewZ - (f64)fDistance );
+}
+
+//how many distinct D32_FLOAT depth values there are for everything between the two distances
+//clamped to [0,1] like the depth buffer does, at a plane the depth can come out a hair past it (e.g. -0.0000001 with fma contraction)
+inline
+u32 DepthValuesBetween( ovrTimewarpProjectionDesc *a_pDesc, f32 fNearDistance, f32 fFarDistance )
+{
+	f32 fNearDepth = TimewarpDistanceToDepth( a_pDesc, fNearDistance );
+	f32 fFarDepth = TimewarpDistanceToDepth( a_pDesc, fFarDistance );
+	fNearDepth = fNearDepth < 0.0f ? 0.0f : fNearDepth > 1.0f ? 1.0f : fNearDepth;
+	fFarDepth = fFarDepth < 0.0f ? 0.0f : fFarDepth > 1.0f ? 1.0f : fFarDepth;
+	u32 dwNearBits, dwFarBits;
+	memcpy( &dwNearBits, &fNearDepth, sizeof(u32) );
+	memcpy( &dwFarBits, &fFarDepth, sizeof(u32) );
+	return dwNearBits > dwFarBits ? dwNearBits - dwFarBits : dwFarBits - dwNearBits;
+}
+
+#if MAIN_DEBUG
+#define DEPTH_PRECISION_RANGES 6
+//returns how many depth values the ranges add up to
+inline
+u64 DepthPrecisionPrintReport( const char *a_pName, ovrTimewarpProjectionDesc *a_pDesc, f32 fNearPlane, f32 fFarPlane )
+{
+	const f32 fDistances[] = { 0.05f, 0.3f, 1.0f, 10.0f, 100.0f, 999.0f };
+	const f32 fRangeEdges[DEPTH_PRECISION_RANGES + 1] = { fNearPlane, 0.1f, 1.0f, 10.0f, 100.0f, 1000.0f, fFarPlane };
+	printf( "Depth precision (%s, near %gm far %gm):\n", a_pName, fNearPlane, fFarPlane );
+	printf( "  resolution:" );
+	for( u32 dwDist = 0; dwDist < sizeof(fDistances) / sizeof(fDistances[0]); ++dwDist )
+	{
+		printf( "  %gm: %.3gmm", fDistances[dwDist], DepthResolutionAt( a_pDesc, fDistances[dwDist] ) * 1000.0 );
+	}
+	printf( "\n  depth values:" );
+	u64 qwTotal = 0;
+	u32 dwValues[DEPTH_PRECISION_RANGES];
+	for( u32 dwRange = 0; dwRange < DEPTH_PRECISION_RANGES; ++dwRange )
+	{
+		dwValues[dwRange] = fRangeEdges[dwRange + 1] > fRangeEdges[dwRange] ? DepthValuesBetween( a_pDesc, fRangeEdges[dwRange], fRangeEdges[dwRange + 1] ) : 0;
+		qwTotal += dwValues[dwRange];
+	}
+	for( u32 dwRange = 0; dwRange < DEPTH_PRECISION_RANGES; ++dwRange )
+	{
+		if( fRangeEdges[dwRange + 1] > fRangeEdges[dwRange] )
+		{
+			printf( "  %g-%gm: %u (%.1f%%)", fRangeEdges[dwRange], fRangeEdges[dwRange + 1], dwValues[dwRange], ( 100.0 * dwValues[dwRange] ) / (f64)qwTotal );
+		}
+	}
+	printf( "\n" );
+	return qwTotal;
+}
+#endif
+
+#if BENCHMARK_MODE
+//ovrMatrix4f_Projection( fov, near, far, flags ) written out (OVR_StereoProjection.cpp CreateProjection), right handed, clip z 0..1
+//ovrProjection_None, or ovrProjection_FarClipAtInfinity | ovrProjection_FarLessThanNear when bReverseZInfinite
+//column vector layout like libOVR so the check below really compares the two conventions
+inline
+void ReferenceOvrMatrix4fProjection( ovrFovPort tanHalfFov, f32 nearPlane, f32 farPlane, u8 bReverseZInfinite, ovrMatrix4f *a_pOut )
+{
+	f32 handednessScale = -1.0f;
+	f32 projXScale = 2.0f / ( tanHalfFov.LeftTan + tanHalfFov.RightTan );
+	f32 projXOffset = ( tanHalfFov.LeftTan - tanHalfFov.RightTan ) * projXScale * 0.5f;
+	f32 projYScale = 2.0f / ( tanHalfFov.UpTan + tanHalfFov.DownTan );
+	f32 projYOffset = ( tanHalfFov.UpTan - tanHalfFov.DownTan ) * projYScale * 0.5f;
+	memset( a_pOut, 0, sizeof(ovrMatrix4f) );
+	a_pOut->M[0][0] = projXScale;
+	a_pOut->M[0][2] = handednessScale * projXOffset;
+	a_pOut->M[1][1] = projYScale;
+	a_pOut->M[1][2] = handednessScale * -projYOffset;
+	if( bReverseZInfinite )
+	{
+		a_pOut->M[2][2] = 0.0f;
+		a_pOut->M[2][3] = nearPlane;
+	}
+	else
+	{
+		a_pOut->M[2][2] = -handednessScale * farPlane / ( nearPlane - farPlane );
+		a_pOut->M[2][3] = ( farPlane * nearPlane ) / ( nearPlane - farPlane );
+	}
+	a_pOut->M[3][2] = handednessScale;
+}
+
+//checks our projections and desc against the libOVR formulas and that depth makes it back to meters through the desc
+//returns the number of failed checks
+u32 BenchmarkDepthLayer()
+{
+	//default eye fovs of a CV1 (left, right) plus a symmetric and a very lopsided one
+	ovrFovPort fovs[4];
+	fovs[0].UpTan = 1.3316f; fovs[0].DownTan = 1.3316f; fovs[0].LeftTan = 1.0586f; fovs[0].RightTan = 1.0924f;
+	fovs[1].UpTan = 1.3316f; fovs[1].DownTan = 1.3316f; fovs[1].LeftTan = 1.0924f; fovs[1].RightTan = 1.0586f;
+	fovs[2].UpTan = 1.0f;    fovs[2].DownTan = 1.0f;    fovs[2].LeftTan = 1.0f;    fovs[2].RightTan = 1.0f;
+	fovs[3].UpTan = 0.4f;    fovs[3].DownTan = 2.1f;    fovs[3].LeftTan = 1.7f;    fovs[3].RightTan = 0.3f;
+	const f32 fPlanes[3][2] = { { EYE_NEAR_PLANE, EYE_FAR_PLANE }, { 0.1f, 100.0f }, { 0.05f, 20000.0f } };
+	const f32 fDistances[7] = { 0.02f, 0.3f, 1.0f, 4.0f, 50.0f, 900.0f, 100000.0f };
+
+	u32 dwFailed = 0;
+	f32 fMaxMatrixError = 0.0f;
+	f32 fMaxRelZError[2] = { 0.0f, 0.0f };
+	for( u32 bReverseZ = 0; bReverseZ < 2; ++bReverseZ )
+	{
+		for( u32 dwFov = 0; dwFov < 4; ++dwFov )
+		{
+			for( u32 dwPlanes = 0; dwPlanes < 3; ++dwPlanes )
+			{
+				f32 fNear = fPlanes[dwPlanes][0];
+				f32 fFar = bReverseZ ? INFINITY : fPlanes[dwPlanes][1];
+				Mat4f mProj;
+				if( bReverseZ )
+				{
+					InitReverseZInfinitePerspectiveProjectionMat4fOculusDirectXRH( &mProj, fovs[dwFov], fNear );
+				}
+				else
+				{
+					InitPerspectiveProjectionMat4fOculusDirectXRH( &mProj, fovs[dwFov], fNear, fFar );
+				}
+				ovrMatrix4f mRef;
+				ReferenceOvrMatrix4fProjection( fovs[dwFov], fNear, fFar, (u8)bReverseZ, &mRef );
+
+				//ours is the transpose of libOVR's
+				for( u32 dwRow = 0; dwRow < 4; ++dwRow )
+				{
+					for( u32 dwCol = 0; dwCol < 4; ++dwCol )
+					{
+						f32 fRef = mRef.M[dwCol][dwRow];
+						f32 fError = fabsf( mProj.m[dwRow][dwCol] - fRef ) / ( fabsf( fRef ) > 1.0f ? fabsf( fRef ) : 1.0f );
+						fMaxMatrixError = fError > fMaxMatrixError ? fError : fMaxMatrixError;
+						dwFailed += fError > 1e-6f ? 1 : 0;
+					}
+				}
+
+				ovrTimewarpProjectionDesc desc;
+				InitTimewarpProjectionDesc( &mProj, &desc );
+				dwFailed += desc.Projection22 != mRef.M[2][2] ? 1 : 0;
+				dwFailed += desc.Projection23 != mRef.M[2][3] ? 1 : 0;
+				dwFailed += desc.Projection32 != mRef.M[3][2] ? 1 : 0;
+
+				//project points straight ahead (row vector, only z and w matter) and linearize the stored depth again
+				for( u32 dwDist = 0; dwDist < 7; ++dwDist )
+				{
+					f32 fViewZ = -fDistances[dwDist];
+					if( fDistances[dwDist] < fNear || fDistances[dwDist] > fFar )
+					{
+						continue;
+					}
+					f32 fClipZ = ( fViewZ * mProj.m[2][2] ) + mProj.m[3][2];
+					f32 fClipW = fViewZ * mProj.m[2][3];
+					f32 fDepth = fClipZ / fClipW;
+					dwFailed += ( fDepth < 0.0f || fDepth > 1.0f ) ? 1 : 0;
+					dwFailed += fDepth != TimewarpDistanceToDepth( &desc, fDistances[dwDist] ) ? 1 : 0;
+					f32 fRelError = fabsf( ( TimewarpDepthToViewZ( &desc, fDepth ) - fViewZ ) / fViewZ );
+					fMaxRelZError[bReverseZ] = fRelError > fMaxRelZError[bReverseZ] ? fRelError : fMaxRelZError[bReverseZ];
+					//standard float depth far from the near plane is only good to ~1%, the precision is all spent near the camera
+					dwFailed += fRelError > ( bReverseZ ? 1e-5f : 0.01f ) ? 1 : 0;
+				}
+			}
+		}
+	}
+	printf( "Depth layer: %u failed checks (max matrix error %g, max linearized depth error %.4f%% standard z, %.6f%% reverse z)\n", dwFailed, fMaxMatrixError, fMaxRelZError[0] * 100.0f, fMaxRelZError[1] * 100.0f );
+	return dwFailed;
+}
+
+//depth resolution and where the representable depth values go for both depth modes, plus the near plane the hands could use with reverse z
+//returns the number of failed checks
+u32 BenchmarkDepthPrecision()
+{
+	ovrFovPort fov;
+	fov.UpTan = 1.3316f; fov.DownTan = 1.3316f; fov.LeftTan = 1.0586f; fov.RightTan = 1.0924f;
+	Mat4f mProj;
+	ovrTimewarpProjectionDesc desc;
+	const u32 dwOneBits = 0x3f800000; //1.0f, the number of floats from 0 up to 1
+	u32 dwFailed = 0;
+
+	InitPerspectiveProjectionMat4fOculusDirectXRH( &mProj, fov, EYE_NEAR_PLANE, EYE_FAR_PLANE );
+	InitTimewarpProjectionDesc( &mProj, &desc );
+	u64 qwTotal = DepthPrecisionPrintReport( "standard z", &desc, EYE_NEAR_PLANE, EYE_FAR_PLANE );
+	//the buckets have to add up to every float from the near plane's 0 to the far plane's 1
+	dwFailed += qwTotal == DepthValuesBetween( &desc, EYE_NEAR_PLANE, EYE_FAR_PLANE ) && qwTotal == dwOneBits ? 0 : 1;
+
+	const f32 fNearPlanes[2] = { EYE_NEAR_PLANE, 0.001f };
+	for( u32 dwNear = 0; dwNear < 2; ++dwNear )
+	{
+		InitReverseZInfinitePerspectiveProjectionMat4fOculusDirectXRH( &mProj, fov, fNearPlanes[dwNear] );
+		InitTimewarpProjectionDesc( &mProj, &desc );
+		qwTotal = DepthPrecisionPrintReport( "reverse z infinite", &desc, fNearPlanes[dwNear], INFINITY );
+		//the buckets have to add up to every float from the near plane's 1 down to infinity's 0
+		dwFailed += TimewarpDistanceToDepth( &desc, INFINITY ) == 0.0f && qwTotal == DepthValuesBetween( &desc, fNearPlanes[dwNear], INFINITY ) && qwTotal == dwOneBits ? 0 : 1;
+	}
+	printf( "Depth precision: %u failed checks\n", dwFailed );
+	return dwFailed;
+}
+#endif
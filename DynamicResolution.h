@@ -0,0 +1,218 @@
+//Dynamic resolution, the eye targets stay allocated at full size and each frame only renders into a scaled viewport of them
+//(the compositor is told the smaller viewport in ovrLayerEyeFov so it samples just that part)
+//a PID on the measured GPU frame time picks the scale, hysteresis keeps it from flickering between sizes:
+//drop quickly when over budget, only go back up after a sustained stretch of headroom
+//https://developer.oculus.com/documentation/native/pc/dg-render-advanced/ (Adaptive Resolution)
+
+#define DYNRES_MIN_SCALE 0.6f //per axis, so ~36% of the pixels
+#define DYNRES_MAX_SCALE 1.0f //the size the targets were allocated at
+#define DYNRES_STEP 0.05f //applied scales are quantized to this
+#define DYNRES_TARGET_BUDGET 0.85f //fraction of the frame the GPU may use, the rest is the compositor's and slack
+#define DYNRES_KP 0.4f
+#define DYNRES_KI 0.05f
+#define DYNRES_KD 0.2f
+#define DYNRES_DOWN_FRAMES 2 //frames in a row wanting a lower scale before we drop
+#define DYNRES_UP_FRAMES 45 //frames in a row wanting a higher scale before we raise it, ~0.5 seconds at 90hz
+
+typedef struct DynamicResolution
+{
+	f32 fTargetMs;
+	f32 fScale; //applied, quantized
+	f32 fDesiredScale; //raw PID output
+	f32 fIntegral;
+	f32 fPrevError;
+	u32 dwDownFrames;
+	u32 dwUpFrames;
+	u64 qwLastGpuFrame; //last gpu timer frame fed in, so each measurement is only used once
+} DynamicResolution;
+
+DynamicResolution dynamicResolution;
+
+inline
+void InitDynamicResolution( DynamicResolution *a_pDynRes, f32 fDisplayRefreshRate )
+{
+	a_pDynRes->fTargetMs = ( 1000.0f / fDisplayRefreshRate ) * DYNRES_TARGET_BUDGET;
+	a_pDynRes->fScale = DYNRES_MAX_SCALE;
+	a_pDynRes->fDesiredScale = DYNRES_MAX_SCALE;
+	a_pDynRes->fIntegral = 0.0f;
+	a_pDynRes->fPrevError = 0.0f;
+	a_pDynRes->dwDownFrames = 0;
+	a_pDynRes->dwUpFrames = 0;
+	a_pDynRes->qwLastGpuFrame = 0;
+}
+
+//feed one measured GPU frame time, returns the scale to render the next frame at
+inline
+f32 DynamicResolutionUpdate( DynamicResolution *a_pDynRes, f32 fGpuMs )
+{
+	//normalized so the gains don't depend on refresh rate, positive is headroom
+	f32 fError = ( a_pDynRes->fTargetMs - fGpuMs ) / a_pDynRes->fTargetMs;
+	f32 fDerivative = fError - a_pDynRes->fPrevError;
+	a_pDynRes->fPrevError = fError;
+
+	//the GPU cost goes with the pixel count, so this is roughly what the next step up would take, only go up if that still fits
+	//without it a load that sits between two steps makes the scale hunt: go up, blow the target, drop, build up headroom, repeat
+	f32 fStepUp = ( a_pDynRes->fScale + DYNRES_STEP ) / a_pDynRes->fScale;
+	bool bStepUpFits = a_pDynRes->fScale < DYNRES_MAX_SCALE && fGpuMs * fStepUp * fStepUp <= a_pDynRes->fTargetMs;
+
+	f32 fIntegral = a_pDynRes->fIntegral + fError;
+	f32 fOutput = DYNRES_MAX_SCALE + ( DYNRES_KP * fError ) + ( DYNRES_KI * fIntegral ) + ( DYNRES_KD * fDerivative );
+	//anti windup, stop integrating once the output is pinned at a limit in the direction the error is pushing,
+	//a step up that doesn't fit counts as a limit too
+	bool bPinnedHigh = fOutput >= DYNRES_MAX_SCALE || ( fOutput > a_pDynRes->fScale && !bStepUpFits );
+	if( !( ( bPinnedHigh && fError > 0.0f ) || ( fOutput <= DYNRES_MIN_SCALE && fError < 0.0f ) ) )
+	{
+		a_pDynRes->fIntegral = fIntegral;
+	}
+	a_pDynRes->fDesiredScale = clamp( fOutput, DYNRES_MIN_SCALE, DYNRES_MAX_SCALE );
+
+	//hysteresis, only move a whole step and only once the controller has wanted to for a while
+	f32 fQuantized = DYNRES_MIN_SCALE + ( floorf( ( ( a_pDynRes->fDesiredScale - DYNRES_MIN_SCALE ) / DYNRES_STEP ) + 0.5f ) * DYNRES_STEP );
+	fQuantized = clamp( fQuantized, DYNRES_MIN_SCALE, DYNRES_MAX_SCALE );
+	if( fQuantized < a_pDynRes->fScale - ( DYNRES_STEP * 0.5f ) )
+	{
+		a_pDynRes->dwUpFrames = 0;
+		if( ++a_pDynRes->dwDownFrames >= DYNRES_DOWN_FRAMES )
+		{
+			a_pDynRes->fScale = fQuantized;
+			a_pDynRes->dwDownFrames = 0;
+		}
+	}
+	else if( fQuantized > a_pDynRes->fScale + ( DYNRES_STEP * 0.5f ) && bStepUpFits )
+	{
+		a_pDynRes->dwDownFrames = 0;
+		if( ++a_pDynRes->dwUpFrames >= DYNRES_UP_FRAMES )
+		{
+			a_pDynRes->fScale = a_pDynRes->fScale + DYNRES_STEP; //one step at a time on the way up
+			a_pDynRes->dwUpFrames = 0;
+		}
+	}
+	else
+	{
+		a_pDynRes->dwDownFrames = 0;
+		a_pDynRes->dwUpFrames = 0;
+	}
+	return a_pDynRes->fScale;
+}
+
+//the scaled rect in the top left of the full size target
+inline
+void DynamicResolutionEyeViewport( f32 fScale, ovrRecti *a_pFullViewport, ovrRecti *a_pViewport, D3D12_VIEWPORT *a_pD3DViewport, D3D12_RECT *a_pScissorRect )
+{
+	a_pViewport->Pos = a_pFullViewport->Pos;
+	a_pViewport->Size.w = (s32)( ( a_pFullViewport->Size.w * fScale ) + 0.5f );
+	a_pViewport->Size.h = (s32)( ( a_pFullViewport->Size.h * fScale ) + 0.5f );
+
+	a_pD3DViewport->TopLeftX = (f32)a_pViewport->Pos.x;
+	a_pD3DViewport->TopLeftY = (f32)a_pViewport->Pos.y;
+	a_pD3DViewport->Width = (f32)a_pViewport->Size.w;
+	a_pD3DViewport->Height = (f32)a_pViewport->Size.h;
+	a_pD3DViewport->MinDepth = 0.0f;
+	a_pD3DViewport->MaxDepth = 1.0f;
+
+	a_pScissorRect->left = a_pViewport->Pos.x;
+	a_pScissorRect->top = a_pViewport->Pos.y;
+	a_pScissorRect->right = a_pViewport->Pos.x + a_pViewport->Size.w;
+	a_pScissorRect->bottom = a_pViewport->Pos.y + a_pViewport->Size.h;
+}
+
+#if BENCHMARK_MODE
+//replays a gpu timing trace offline: the trace gives the GPU cost of a frame at full res, the cost scales with the pixel count,
+//and the measurement reaches the controller dwLatency frames late like the timestamp readback does
+//returns how many frames went over the full frame budget, a_pNumChanges gets how many times the applied scale changed
+inline
+u32 DynamicResolutionReplay( f32 *a_pFullResGpuMs, u32 dwNumFrames, u32 dwLatency, f32 fDisplayRefreshRate, u32 *a_pNumChanges, f32 *a_pAvgScale )
+{
+	DynamicResolution dynRes;
+	InitDynamicResolution( &dynRes, fDisplayRefreshRate );
+	f32 fBudgetMs = 1000.0f / fDisplayRefreshRate;
+	f32 fScaleHistory[8] = { DYNRES_MAX_SCALE, DYNRES_MAX_SCALE, DYNRES_MAX_SCALE, DYNRES_MAX_SCALE, DYNRES_MAX_SCALE, DYNRES_MAX_SCALE, DYNRES_MAX_SCALE, DYNRES_MAX_SCALE };
+	u32 dwOverBudget = 0;
+	u32 dwNumChanges = 0;
+	f64 fScaleSum = 0.0;
+	f32 fScale = DYNRES_MAX_SCALE;
+	for( u32 dwFrame = 0; dwFrame < dwNumFrames; ++dwFrame )
+	{
+		fScaleHistory[dwFrame & 7] = fScale;
+		f32 fGpuMs = 0.5f + ( ( a_pFullResGpuMs[dwFrame] - 0.5f ) * fScale * fScale ); //0.5ms doesn't scale (barriers, clears of the fixed size targets)
+		dwOverBudget += fGpuMs > fBudgetMs ? 1 : 0;
+		fScaleSum += fScale;
+		if( dwFrame >= dwLatency )
+		{
+			f32 fMeasuredScale = fScaleHistory[( dwFrame - dwLatency ) & 7];
+			f32 fMeasuredMs = 0.5f + ( ( a_pFullResGpuMs[dwFrame - dwLatency] - 0.5f ) * fMeasuredScale * fMeasuredScale );
+			f32 fNewScale = DynamicResolutionUpdate( &dynRes, fMeasuredMs );
+			dwNumChanges += fNewScale != fScale ? 1 : 0;
+			fScale = fNewScale;
+		}
+	}
+	*a_pNumChanges = dwNumChanges;
+	*a_pAvgScale = (f32)( fScaleSum / dwNumFrames );
+	return dwOverBudget;
+}
+
+u32 BenchmarkDynamicResolution()
+{
+	//recorded-style trace at 90hz: light scene, a heavy stretch, a spike, then noisy load hovering right at the budget
+	const u32 dwNumFrames = 1800;
+	f32 *pGpuMs = (f32*)malloc( sizeof(f32) * dwNumFrames );
+	if( !pGpuMs )
+	{
+		printf( "Dynamic resolution: out of memory\n" );
+		return 1;
+	}
+	u32 dwSeed = 12345;
+	for( u32 dwFrame = 0; dwFrame < dwNumFrames; ++dwFrame )
+	{
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		f32 fNoise = ( ( dwSeed >> 8 ) / (f32)( 1 << 24 ) - 0.5f ) * 0.8f;
+		f32 fMs;
+		if( dwFrame < 300 )       fMs = 6.0f;
+		else if( dwFrame < 900 )  fMs = 14.0f;
+		else if( dwFrame < 910 )  fMs = 25.0f;
+		else if( dwFrame < 1200 ) fMs = 7.0f;
+		else                      fMs = 10.5f;
+		pGpuMs[dwFrame] = fMs + fNoise;
+	}
+	u32 dwFixedOver = 0;
+	for( u32 dwFrame = 0; dwFrame < dwNumFrames; ++dwFrame )
+	{
+		dwFixedOver += pGpuMs[dwFrame] > ( 1000.0f / 90.0f ) ? 1 : 0;
+	}
+	u32 dwNumChanges;
+	f32 fAvgScale;
+	u32 dwDynOver = DynamicResolutionReplay( pGpuMs, dwNumFrames, 3, 90.0f, &dwNumChanges, &fAvgScale );
+	u32 dwFailures = 0;
+	//the controller only ever sees frames 3 late, so it gets a handful over at each step up in load but no more
+	dwFailures += dwDynOver * 20 < dwFixedOver ? 0 : 1;
+
+	//a light load has to stay at full res without ever touching the scale
+	u32 dwSteadyChanges;
+	f32 fSteadyScale;
+	for( u32 dwFrame = 0; dwFrame < dwNumFrames; ++dwFrame )
+	{
+		pGpuMs[dwFrame] = 6.0f;
+	}
+	dwFailures += DynamicResolutionReplay( pGpuMs, dwNumFrames, 3, 90.0f, &dwSteadyChanges, &fSteadyScale ) == 0 && dwSteadyChanges == 0 && fSteadyScale == DYNRES_MAX_SCALE ? 0 : 1;
+	//a constant heavy load has to settle on one scale that fits and then leave it alone, no hunting up and down
+	for( u32 dwFrame = 0; dwFrame < dwNumFrames; ++dwFrame )
+	{
+		pGpuMs[dwFrame] = 14.0f;
+	}
+	u32 dwHeavyOver = DynamicResolutionReplay( pGpuMs, dwNumFrames, 3, 90.0f, &dwSteadyChanges, &fSteadyScale );
+	u32 dwFirstHalfChanges;
+	DynamicResolutionReplay( pGpuMs, dwNumFrames / 2, 3, 90.0f, &dwFirstHalfChanges, &fSteadyScale );
+	dwFailures += dwHeavyOver < 10 && dwSteadyChanges == dwFirstHalfChanges ? 0 : 1;
+
+	ovrRecti fullViewport = { { 0, 0 }, { 1344, 1600 } };
+	ovrRecti viewport;
+	D3D12_VIEWPORT d3dViewport;
+	D3D12_RECT scissorRect;
+	DynamicResolutionEyeViewport( 0.5f, &fullViewport, &viewport, &d3dViewport, &scissorRect );
+	dwFailures += viewport.Size.w == 672 && viewport.Size.h == 800 && d3dViewport.Width == 672.0f && scissorRect.right == 672 && scissorRect.bottom == 800 ? 0 : 1;
+	printf( "Dynamic resolution: %u/%u frames over budget at fixed res, %u with dynamic res (avg scale %.2f, %u scale changes), constant heavy load %u over with %u changes, %u failures\n",
+		dwFixedOver, dwNumFrames, dwDynOver, fAvgScale, dwNumChanges, dwHeavyOver, dwSteadyChanges, dwFailures );
+	free( pGpuMs );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,654 @@
+//Fixed foveated rendering, the lenses blur the periphery anyway so it doesn't need a pixel shader run per pixel
+//rings around the lens center (in each side's fraction of the fov port, so the rings follow its asymmetry) each get a coarser
+//D3D12_SHADING_RATE, FoveationBuildRateImage turns them into a shading rate image with a texel per VRS tile, applied with
+//RSSetShadingRateImage on hardware with VRS tier 2. the targets never change size but dynamic resolution renders into a
+//scaled corner of them, so there is an image per dynamic resolution step
+//without VRS the octilinear multires layer is the fallback: each eye is drawn as 4 quadrants, each with its own w warp
+//(w' = w + warp*|x| + warp*|y|) squeezing the periphery into fewer pixels, and the compositor unwarps it.
+//that layer has no depth, so the fallback gives up what DepthLayer.h gets the compositor
+//https://microsoft.github.io/DirectX-Specs/d3d/VariableRateShading.html
+//https://developer.oculus.com/documentation/native/pc/dg-render-advanced/ (ovrLayerEyeFovMultires)
+
+#define FOVEATION_MAX_RINGS 4
+#define FOVEATION_NUM_LEVELS 4
+#define FOVEATION_NUM_QUADRANTS 4 //octilinear, top left, top right, bottom left, bottom right like ovrTextureLayoutOctilinear
+#define FOVEATION_MAX_WARP 0.5f //a quarter of the pixels, past this the corners are too squeezed
+#define FOVEATION_NUM_SCALES ( (u32)( ( ( DYNRES_MAX_SCALE - DYNRES_MIN_SCALE ) / DYNRES_STEP ) + 1.5f ) ) //rate images per eye
+
+enum FoveationMode
+{
+	FOVEATION_OFF,
+	FOVEATION_VRS, //tier 2 shading rate image
+	FOVEATION_MULTIRES, //octilinear layer, 4 quadrants per eye
+};
+
+typedef struct FoveationRing
+{
+	f32 fRadius; //outer edge, 1 is the edge of the fov port straight left, right, up or down of the lens center. the last ring has no edge
+	u8 bRate; //D3D12_SHADING_RATE
+} FoveationRing;
+
+typedef struct FoveationConfig
+{
+	FoveationRing rings[FOVEATION_MAX_RINGS]; //inside out
+	u32 dwNumRings;
+} FoveationConfig;
+
+//FOVEATION_LEVEL picks one, level 0 is off
+const FoveationConfig foveationLevels[FOVEATION_NUM_LEVELS] =
+{
+	{ { { 0.0f, D3D12_SHADING_RATE_1X1 } }, 1 },
+	{ { { 0.7f, D3D12_SHADING_RATE_1X1 }, { 0.0f, D3D12_SHADING_RATE_2X2 } }, 2 },
+	{ { { 0.55f, D3D12_SHADING_RATE_1X1 }, { 0.8f, D3D12_SHADING_RATE_2X2 }, { 0.0f, D3D12_SHADING_RATE_4X4 } }, 3 },
+	{ { { 0.4f, D3D12_SHADING_RATE_1X1 }, { 0.6f, D3D12_SHADING_RATE_2X2 }, { 0.0f, D3D12_SHADING_RATE_4X4 } }, 3 },
+};
+
+typedef struct FoveationQuadrant
+{
+	Mat4f mViewProj; //the eye's with the quadrant's warp
+	D3D12_VIEWPORT viewport; //maps the quadrant's half of ndc onto its rect
+	D3D12_RECT scissorRect; //the quadrant's rect
+} FoveationQuadrant;
+
+typedef struct Foveation
+{
+	FoveationConfig config; //rates already limited to what the device supports
+	u32 dwMode;
+	u32 dwTileSize; //pixels per rate image texel, D3D12_FEATURE_DATA_D3D12_OPTIONS6::ShadingRateImageTileSize
+	f32 fWarp; //octilinear warp on every side
+	f32 fShadedFraction; //of the full res pixels, at full scale
+	ID3D12Resource *pRateImages[ovrEye_Count][FOVEATION_NUM_SCALES]; //by dynamic resolution step
+	ID3D12GraphicsCommandList5 *pCommandLists[ovrEye_Count]; //the eye lists, for the VRS calls
+	ID3D12Resource *pUpload; //rate images on their way in, released once the streaming list ran
+} Foveation;
+
+Foveation foveation;
+
+inline
+u32 FoveationRateWidth( u8 bRate )
+{
+	return 1u << ( ( bRate >> D3D12_SHADING_RATE_X_AXIS_SHIFT ) & D3D12_SHADING_RATE_VALID_MASK );
+}
+
+inline
+u32 FoveationRateHeight( u8 bRate )
+{
+	return 1u << ( bRate & D3D12_SHADING_RATE_VALID_MASK );
+}
+
+//2x4, 4x2 and 4x4 are optional (AdditionalShadingRatesSupported), without them an axis goes no coarser than 2
+inline
+void FoveationClampConfig( FoveationConfig *a_pConfig, bool bAdditionalRates )
+{
+	if( bAdditionalRates )
+	{
+		return;
+	}
+	for( u32 dwRing = 0; dwRing < a_pConfig->dwNumRings; ++dwRing )
+	{
+		u8 bRate = a_pConfig->rings[dwRing].bRate;
+		u32 dwX = ( bRate >> D3D12_SHADING_RATE_X_AXIS_SHIFT ) & D3D12_SHADING_RATE_VALID_MASK;
+		u32 dwY = bRate & D3D12_SHADING_RATE_VALID_MASK;
+		a_pConfig->rings[dwRing].bRate = (u8)D3D12_MAKE_COARSE_SHADING_RATE( dwX < 1 ? dwX : 1, dwY < 1 ? dwY : 1 );
+	}
+}
+
+//rate of the ring a point fRadiusSq (squared, in ring units) from the lens center is in
+inline
+u8 FoveationRingRate( FoveationConfig *a_pConfig, f32 fRadiusSq )
+{
+	u32 dwRing = 0;
+	while( dwRing + 1 < a_pConfig->dwNumRings && fRadiusSq > a_pConfig->rings[dwRing].fRadius * a_pConfig->rings[dwRing].fRadius )
+	{
+		++dwRing;
+	}
+	return a_pConfig->rings[dwRing].bRate;
+}
+
+//pixel edge fPixel of dwSize across the fov port to ring units, fNegTan is the tangent at pixel 0 (left, or up since rows go down)
+//and fPosTan the one at dwSize. the lens center is at 0 and it's linear on each side of it
+inline
+f32 FoveationRingCoord( f32 fPixel, u32 dwSize, f32 fNegTan, f32 fPosTan )
+{
+	f32 fTan = -fNegTan + ( ( fPixel / (f32)dwSize ) * ( fNegTan + fPosTan ) );
+	return fTan < 0.0f ? fTan / fNegTan : fTan / fPosTan;
+}
+
+//the distance to the lens center of a tile's closest point on one axis, 0 when the tile has the center in it
+inline
+f32 FoveationTileCoord( u32 dwTile, u32 dwTileSize, u32 dwSize, f32 fNegTan, f32 fPosTan )
+{
+	f32 fStart = FoveationRingCoord( (f32)( dwTile * dwTileSize ), dwSize, fNegTan, fPosTan );
+	f32 fEnd = FoveationRingCoord( (f32)( ( dwTile + 1 ) * dwTileSize ), dwSize, fNegTan, fPosTan );
+	if( fStart <= 0.0f && fEnd >= 0.0f )
+	{
+		return 0.0f;
+	}
+	return fabsf( fStart ) < fabsf( fEnd ) ? fabsf( fStart ) : fabsf( fEnd );
+}
+
+//fills a dwImageWidth by dwImageHeight R8_UINT shading rate image for a dwViewportWidth by dwViewportHeight viewport in its top left,
+//a tile takes the rate of its pixel closest to the lens center so it's never coarser than any of its pixels want, tiles past the
+//viewport never get drawn and take the coarsest rate. returns the fraction of the viewport's pixels the pixel shader still runs for
+inline
+f32 FoveationBuildRateImage( FoveationConfig *a_pConfig, ovrFovPort *a_pFov, u32 dwViewportWidth, u32 dwViewportHeight, u32 dwTileSize,
+	u32 dwImageWidth, u32 dwImageHeight, u8 *a_pImage )
+{
+	u8 bOutside = a_pConfig->rings[a_pConfig->dwNumRings - 1].bRate;
+	f64 fShaded = 0.0;
+	for( u32 dwTileY = 0; dwTileY < dwImageHeight; ++dwTileY )
+	{
+		u8 *pRow = a_pImage + ( dwTileY * dwImageWidth );
+		u32 dwTop = dwTileY * dwTileSize;
+		if( dwTop >= dwViewportHeight )
+		{
+			memset( pRow, bOutside, dwImageWidth );
+			continue;
+		}
+		u32 dwHeight = dwViewportHeight - dwTop < dwTileSize ? dwViewportHeight - dwTop : dwTileSize;
+		f32 fY = FoveationTileCoord( dwTileY, dwTileSize, dwViewportHeight, a_pFov->UpTan, a_pFov->DownTan );
+		for( u32 dwTileX = 0; dwTileX < dwImageWidth; ++dwTileX )
+		{
+			u32 dwLeft = dwTileX * dwTileSize;
+			if( dwLeft >= dwViewportWidth )
+			{
+				pRow[dwTileX] = bOutside;
+				continue;
+			}
+			u32 dwWidth = dwViewportWidth - dwLeft < dwTileSize ? dwViewportWidth - dwLeft : dwTileSize;
+			f32 fX = FoveationTileCoord( dwTileX, dwTileSize, dwViewportWidth, a_pFov->LeftTan, a_pFov->RightTan );
+			u8 bRate = FoveationRingRate( a_pConfig, ( fX * fX ) + ( fY * fY ) );
+			pRow[dwTileX] = bRate;
+			fShaded += (f64)( dwWidth * dwHeight ) / ( FoveationRateWidth( bRate ) * FoveationRateHeight( bRate ) );
+		}
+	}
+	return (f32)( fShaded / ( (f64)dwViewportWidth * dwViewportHeight ) );
+}
+
+//applied scale to its rate image, the scales are quantized to DYNRES_STEP
+inline
+u32 FoveationScaleIndex( f32 fScale )
+{
+	u32 dwIndex = (u32)( ( ( fScale - DYNRES_MIN_SCALE ) / DYNRES_STEP ) + 0.5f );
+	return dwIndex < FOVEATION_NUM_SCALES ? dwIndex : FOVEATION_NUM_SCALES - 1;
+}
+
+//the warp the octilinear fallback uses, each side keeps its center at full density and the quadrant's pixels shrink by (1 - warp)
+//per axis, so it's picked to spend the pixels the rate image would have shaded
+inline
+f32 FoveationWarp( f32 fShadedFraction )
+{
+	f32 fWarp = 1.0f - sqrtf( fShadedFraction );
+	return clamp( fWarp, 0.0f, FOVEATION_MAX_WARP );
+}
+
+//layout of a viewport drawn octilinear, clip space 0,0 stays where it is in the unwarped viewport and each side shrinks by (1 - warp).
+//a_pViewport is made the part the quadrants cover, that's what goes in the layer
+inline
+void FoveationOctilinearLayout( f32 fWarp, ovrRecti *a_pViewport, ovrTextureLayoutOctilinear *a_pLayout )
+{
+	a_pLayout->WarpLeft = fWarp;
+	a_pLayout->WarpRight = fWarp;
+	a_pLayout->WarpUp = fWarp;
+	a_pLayout->WarpDown = fWarp;
+	a_pLayout->SizeLeft = floorf( ( a_pViewport->Size.w * 0.5f * ( 1.0f - fWarp ) ) + 0.5f );
+	a_pLayout->SizeRight = a_pLayout->SizeLeft;
+	a_pLayout->SizeUp = floorf( ( a_pViewport->Size.h * 0.5f * ( 1.0f - fWarp ) ) + 0.5f );
+	a_pLayout->SizeDown = a_pLayout->SizeUp;
+	a_pViewport->Size.w = (s32)( a_pLayout->SizeLeft + a_pLayout->SizeRight );
+	a_pViewport->Size.h = (s32)( a_pLayout->SizeUp + a_pLayout->SizeDown );
+}
+
+//what dwQuadrant draws with. clip x and y get scaled by 1 / (1 - warp) and w grows by warp times how far out they are, so the
+//fov port's edge straight out from the split still lands on the quadrant's edge while the center keeps its pixel density and the edge gets (1 - warp)^2 of it.
+//it's linear within a quadrant so the rasterizer interpolates it like any projection, and along a pixel's ray w' stays
+//proportional to w so depth keeps its order
+inline
+void FoveationQuadrantSetup( ovrTextureLayoutOctilinear *a_pLayout, ovrRecti *a_pViewport, u32 dwQuadrant, Mat4f *a_pViewProj, FoveationQuadrant *a_pQuadrant )
+{
+	f32 fSignX = ( dwQuadrant & 1 ) ? 1.0f : -1.0f;
+	f32 fSignY = ( dwQuadrant & 2 ) ? -1.0f : 1.0f; //clip y is up, the quadrants go down
+	f32 fWarpX = ( dwQuadrant & 1 ) ? a_pLayout->WarpRight : a_pLayout->WarpLeft;
+	f32 fWarpY = ( dwQuadrant & 2 ) ? a_pLayout->WarpDown : a_pLayout->WarpUp;
+	f32 fSizeX = ( dwQuadrant & 1 ) ? a_pLayout->SizeRight : a_pLayout->SizeLeft;
+	f32 fSizeY = ( dwQuadrant & 2 ) ? a_pLayout->SizeDown : a_pLayout->SizeUp;
+	f32 fScaleX = 1.0f / ( 1.0f - fWarpX );
+	f32 fScaleY = 1.0f / ( 1.0f - fWarpY );
+
+	Mat4f mWarp;
+	memset( &mWarp, 0, sizeof( Mat4f ) );
+	mWarp.m[0][0] = fScaleX;
+	mWarp.m[1][1] = fScaleY;
+	mWarp.m[2][2] = 1.0f;
+	mWarp.m[3][3] = 1.0f;
+	mWarp.m[0][3] = fSignX * fWarpX * fScaleX;
+	mWarp.m[1][3] = fSignY * fWarpY * fScaleY;
+	Mat4fMult( a_pViewProj, &mWarp, &a_pQuadrant->mViewProj );
+
+	//ndc 0 on the split, +-1 on the quadrant's outer edge
+	f32 fCenterX = (f32)a_pViewport->Pos.x + a_pLayout->SizeLeft;
+	f32 fCenterY = (f32)a_pViewport->Pos.y + a_pLayout->SizeUp;
+	a_pQuadrant->viewport.TopLeftX = fCenterX - fSizeX;
+	a_pQuadrant->viewport.TopLeftY = fCenterY - fSizeY;
+	a_pQuadrant->viewport.Width = 2.0f * fSizeX;
+	a_pQuadrant->viewport.Height = 2.0f * fSizeY;
+	a_pQuadrant->viewport.MinDepth = 0.0f;
+	a_pQuadrant->viewport.MaxDepth = 1.0f;
+
+	a_pQuadrant->scissorRect.left = (s32)( ( dwQuadrant & 1 ) ? fCenterX : fCenterX - fSizeX );
+	a_pQuadrant->scissorRect.right = (s32)( ( dwQuadrant & 1 ) ? fCenterX + fSizeX : fCenterX );
+	a_pQuadrant->scissorRect.top = (s32)( ( dwQuadrant & 2 ) ? fCenterY : fCenterY - fSizeY );
+	a_pQuadrant->scissorRect.bottom = (s32)( ( dwQuadrant & 2 ) ? fCenterY + fSizeY : fCenterY );
+}
+
+//a rate image for every eye and dynamic resolution step, built straight into one upload buffer and copied over on the streaming
+//list, which has to be open. each image's rows are padded to the copy pitch, FoveationBuildRateImage just sees a wider image
+inline
+bool InitFoveationRateImages( u32 dwTileSize )
+{
+	foveation.dwTileSize = dwTileSize;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprints[ovrEye_Count];
+	u64 qwUploadSize = 0;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		footprints[dwEye].Footprint.Format = DXGI_FORMAT_R8_UINT;
+		footprints[dwEye].Footprint.Width = ( oculusEyeRenderViewport[dwEye].Size.w + dwTileSize - 1 ) / dwTileSize;
+		footprints[dwEye].Footprint.Height = ( oculusEyeRenderViewport[dwEye].Size.h + dwTileSize - 1 ) / dwTileSize;
+		footprints[dwEye].Footprint.Depth = 1;
+		footprints[dwEye].Footprint.RowPitch = ( footprints[dwEye].Footprint.Width + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1 ) & ~( D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1 );
+		u64 qwImageSize = ( (u64)footprints[dwEye].Footprint.RowPitch * footprints[dwEye].Footprint.Height + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1 ) & ~( (u64)D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1 );
+		qwUploadSize += qwImageSize * FOVEATION_NUM_SCALES;
+	}
+
+	D3D12_HEAP_PROPERTIES heapDesc;
+	heapDesc.Type = D3D12_HEAP_TYPE_UPLOAD;
+	heapDesc.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapDesc.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	heapDesc.CreationNodeMask = 1;
+	heapDesc.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC uploadDesc;
+	uploadDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	uploadDesc.Alignment = 0;
+	uploadDesc.Width = qwUploadSize;
+	uploadDesc.Height = 1;
+	uploadDesc.DepthOrArraySize = 1;
+	uploadDesc.MipLevels = 1;
+	uploadDesc.Format = DXGI_FORMAT_UNKNOWN;
+	uploadDesc.SampleDesc.Count = 1;
+	uploadDesc.SampleDesc.Quality = 0;
+	uploadDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	uploadDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	if( FAILED( device->CreateCommittedResource( &heapDesc, D3D12_HEAP_FLAG_NONE, &uploadDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS( &foveation.pUpload ) ) ) )
+	{
+		logError( "Failed to create shading rate image upload buffer!\n" );
+		return false;
+	}
+	u8 *pUploadData;
+	if( FAILED( foveation.pUpload->Map( 0, nullptr, (void**)&pUploadData ) ) )
+	{
+		logError( "Failed to map shading rate image upload buffer!\n" );
+		return false;
+	}
+
+	heapDesc.Type = D3D12_HEAP_TYPE_DEFAULT;
+	D3D12_RESOURCE_DESC imageDesc = uploadDesc;
+	imageDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	imageDesc.Format = DXGI_FORMAT_R8_UINT;
+	imageDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+	D3D12_RESOURCE_BARRIER barriers[ovrEye_Count * FOVEATION_NUM_SCALES];
+	u64 qwOffset = 0;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		D3D12_SUBRESOURCE_FOOTPRINT *pFootprint = &footprints[dwEye].Footprint;
+		imageDesc.Width = pFootprint->Width;
+		imageDesc.Height = pFootprint->Height;
+		for( u32 dwScale = 0; dwScale < FOVEATION_NUM_SCALES; ++dwScale )
+		{
+			ID3D12Resource **ppImage = &foveation.pRateImages[dwEye][dwScale];
+			if( FAILED( device->CreateCommittedResource( &heapDesc, D3D12_HEAP_FLAG_NONE, &imageDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS( ppImage ) ) ) )
+			{
+				logError( "Failed to create shading rate image!\n" );
+				foveation.pUpload->Unmap( 0, nullptr );
+				return false;
+			}
+#if MAIN_DEBUG
+			(*ppImage)->SetName( L"Shading Rate Image" );
+#endif
+			//the size DynamicResolutionEyeViewport gives this step
+			ovrRecti viewport;
+			D3D12_VIEWPORT d3dViewport;
+			D3D12_RECT scissorRect;
+			f32 fScale = DYNRES_MIN_SCALE + ( dwScale * DYNRES_STEP );
+			DynamicResolutionEyeViewport( fScale, &oculusEyeRenderViewport[dwEye], &viewport, &d3dViewport, &scissorRect );
+			f32 fShaded = FoveationBuildRateImage( &foveation.config, &oculusHMDDesc.DefaultEyeFov[dwEye], viewport.Size.w, viewport.Size.h, dwTileSize,
+				pFootprint->RowPitch, pFootprint->Height, pUploadData + qwOffset );
+			if( dwEye == ovrEye_Left && dwScale == FOVEATION_NUM_SCALES - 1 )
+			{
+				foveation.fShadedFraction = fShaded;
+			}
+
+			footprints[dwEye].Offset = qwOffset;
+			D3D12_TEXTURE_COPY_LOCATION src;
+			src.pResource = foveation.pUpload;
+			src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+			src.PlacedFootprint = footprints[dwEye];
+			D3D12_TEXTURE_COPY_LOCATION dst;
+			dst.pResource = *ppImage;
+			dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+			dst.SubresourceIndex = 0;
+			commandLists[ovrEye_Count]->CopyTextureRegion( &dst, 0, 0, 0, &src, nullptr );
+			qwOffset += ( (u64)pFootprint->RowPitch * pFootprint->Height + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1 ) & ~( (u64)D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1 );
+
+			D3D12_RESOURCE_BARRIER *pBarrier = &barriers[( dwEye * FOVEATION_NUM_SCALES ) + dwScale];
+			pBarrier->Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			pBarrier->Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+			pBarrier->Transition.pResource = *ppImage;
+			pBarrier->Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+			pBarrier->Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+			pBarrier->Transition.StateAfter = D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE;
+		}
+	}
+	foveation.pUpload->Unmap( 0, nullptr );
+	commandLists[ovrEye_Count]->ResourceBarrier( _countof( barriers ), barriers );
+	return true;
+}
+
+//picks VRS when the device has tier 2, else the octilinear layer when the runtime has it, else nothing.
+//has to run before the first frame is submitted (extensions) and while the streaming list is open (rate images)
+inline
+bool InitFoveation( u32 dwLevel )
+{
+	foveation.dwMode = FOVEATION_OFF;
+	foveation.pUpload = nullptr;
+	foveation.fWarp = 0.0f;
+	foveation.fShadedFraction = 1.0f;
+	if( dwLevel == 0 || dwLevel >= FOVEATION_NUM_LEVELS )
+	{
+		return true;
+	}
+	foveation.config = foveationLevels[dwLevel];
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS6 options6;
+	bool bVrs = SUCCEEDED( device->CheckFeatureSupport( D3D12_FEATURE_D3D12_OPTIONS6, &options6, sizeof( options6 ) ) ) &&
+		options6.VariableShadingRateTier >= D3D12_VARIABLE_SHADING_RATE_TIER_2;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count && bVrs; ++dwEye )
+	{
+		bVrs = SUCCEEDED( commandLists[dwEye]->QueryInterface( IID_PPV_ARGS( &foveation.pCommandLists[dwEye] ) ) );
+	}
+	if( bVrs )
+	{
+		FoveationClampConfig( &foveation.config, options6.AdditionalShadingRatesSupported != FALSE );
+		if( !InitFoveationRateImages( options6.ShadingRateImageTileSize ) )
+		{
+			return false;
+		}
+		foveation.dwMode = FOVEATION_VRS;
+#if MAIN_DEBUG
+		printf( "Foveation: VRS tier 2, %upx tiles, %.1f%% of the pixels shaded\n", foveation.dwTileSize, foveation.fShadedFraction * 100.0f );
+#endif
+		return true;
+	}
+
+	ovrBool bOctilinear = ovrFalse;
+	if( ovr_IsExtensionSupported( oculusSession, ovrExtension_TextureLayout_Octilinear, &bOctilinear ) < 0 || !bOctilinear ||
+		ovr_EnableExtension( oculusSession, ovrExtension_TextureLayout_Octilinear ) < 0 )
+	{
+#if MAIN_DEBUG
+		printf( "Foveation: no VRS tier 2 or octilinear layer, shading at full rate\n" );
+#endif
+		return true;
+	}
+	//the warp spends what the rate image would have shaded with every rate available
+	const u32 dwTileSize = 16;
+	u32 dwImageWidth = ( oculusEyeRenderViewport[ovrEye_Left].Size.w + dwTileSize - 1 ) / dwTileSize;
+	u32 dwImageHeight = ( oculusEyeRenderViewport[ovrEye_Left].Size.h + dwTileSize - 1 ) / dwTileSize;
+	u8 *pImage = (u8*)malloc( dwImageWidth * dwImageHeight );
+	if( !pImage )
+	{
+		return false;
+	}
+	foveation.fShadedFraction = FoveationBuildRateImage( &foveation.config, &oculusHMDDesc.DefaultEyeFov[ovrEye_Left], oculusEyeRenderViewport[ovrEye_Left].Size.w,
+		oculusEyeRenderViewport[ovrEye_Left].Size.h, dwTileSize, dwImageWidth, dwImageHeight, pImage );
+	free( pImage );
+	foveation.fWarp = FoveationWarp( foveation.fShadedFraction );
+	foveation.dwMode = FOVEATION_MULTIRES;
+#if MAIN_DEBUG
+	printf( "Foveation: octilinear layer, warp %.3f, %.1f%% of the pixels\n", foveation.fWarp, ( 1.0f - foveation.fWarp ) * ( 1.0f - foveation.fWarp ) * 100.0f );
+#endif
+	return true;
+}
+
+//once per eye list before its draws, the shading rate state doesn't survive the list's Reset
+inline
+void FoveationBeginEye( u32 dwEye, f32 fScale )
+{
+	if( foveation.dwMode != FOVEATION_VRS )
+	{
+		return;
+	}
+	//the image decides, a draw's own rate (always 1x1 here) passes through
+	const D3D12_SHADING_RATE_COMBINER combiners[D3D12_RS_SET_SHADING_RATE_COMBINER_COUNT] = { D3D12_SHADING_RATE_COMBINER_PASSTHROUGH, D3D12_SHADING_RATE_COMBINER_OVERRIDE };
+	foveation.pCommandLists[dwEye]->RSSetShadingRate( D3D12_SHADING_RATE_1X1, combiners );
+	foveation.pCommandLists[dwEye]->RSSetShadingRateImage( foveation.pRateImages[dwEye][FoveationScaleIndex( fScale )] );
+}
+
+//how many times an eye's passes get submitted, once per quadrant for the octilinear layer
+inline
+u32 FoveationNumQuadrants()
+{
+	return foveation.dwMode == FOVEATION_MULTIRES ? FOVEATION_NUM_QUADRANTS : 1;
+}
+
+//binds quadrant dwQuadrant of an octilinear eye and returns the view projection to submit it with, without the layer it's a_pViewProj
+inline
+Mat4f *FoveationBindQuadrant( RenderBackend *a_pBackend, FoveationQuadrant *a_pQuadrants, u32 dwQuadrant, Mat4f *a_pViewProj )
+{
+	if( foveation.dwMode != FOVEATION_MULTIRES )
+	{
+		return a_pViewProj;
+	}
+	RenderSetViewport( a_pBackend, &a_pQuadrants[dwQuadrant].viewport, &a_pQuadrants[dwQuadrant].scissorRect );
+	a_pBackend->dwConstants = RENDER_CONSTANTS_NONE; //the view projection it has bound is the last quadrant's
+	return &a_pQuadrants[dwQuadrant].mViewProj;
+}
+
+#if BENCHMARK_MODE
+//where a view space direction lands in pixels through a quadrant, or with a null quadrant through the plain viewport
+inline
+void FoveationProject( Mat4f *a_pViewProj, D3D12_VIEWPORT *a_pViewport, f32 fTanX, f32 fTanY, f32 fDistance, f32 *a_pX, f32 *a_pY, f32 *a_pDepth )
+{
+	f32 fView[4] = { fTanX * fDistance, fTanY * fDistance, -fDistance, 1.0f };
+	f32 fClip[4];
+	for( u32 dwAxis = 0; dwAxis < 4; ++dwAxis )
+	{
+		fClip[dwAxis] = ( fView[0] * a_pViewProj->m[0][dwAxis] ) + ( fView[1] * a_pViewProj->m[1][dwAxis] ) + ( fView[2] * a_pViewProj->m[2][dwAxis] ) + ( fView[3] * a_pViewProj->m[3][dwAxis] );
+	}
+	*a_pX = a_pViewport->TopLeftX + ( ( ( fClip[0] / fClip[3] ) + 1.0f ) * 0.5f * a_pViewport->Width );
+	*a_pY = a_pViewport->TopLeftY + ( ( 1.0f - ( fClip[1] / fClip[3] ) ) * 0.5f * a_pViewport->Height );
+	*a_pDepth = fClip[2] / fClip[3];
+}
+
+//rate images for a Rift sized pair of eyes at every dynamic resolution step and level: a tile is never coarser than any pixel in it
+//wants, rates never get finer going out from the lens center, nothing past the optional rates when they're off.
+//then the octilinear quadrants: the fov port edges land on the quadrant edges, the seams line up, the center keeps full density
+//and depth keeps its order
+u32 BenchmarkFoveation()
+{
+	LARGE_INTEGER frequency, startCounter, endCounter;
+	QueryPerformanceFrequency( &frequency );
+	u32 dwFailures = 0;
+	ovrFovPort fovs[ovrEye_Count] = { { 1.33f, 1.33f, 1.06f, 0.84f }, { 1.33f, 1.33f, 0.84f, 1.06f } }; //up, down, left, right
+	const u32 dwFullWidth = 1344;
+	const u32 dwFullHeight = 1600;
+	const u32 dwTileSize = 16;
+	u32 dwImageWidth = ( dwFullWidth + dwTileSize - 1 ) / dwTileSize;
+	u32 dwImageHeight = ( dwFullHeight + dwTileSize - 1 ) / dwTileSize;
+	u8 *pImage = (u8*)malloc( dwImageWidth * dwImageHeight );
+	if( !pImage )
+	{
+		printf( "Foveation: out of memory\n" );
+		return 1;
+	}
+
+	f32 fShaded[FOVEATION_NUM_LEVELS];
+	f64 fBuildUs = 0.0;
+	for( u32 dwAdditional = 0; dwAdditional < 2; ++dwAdditional )
+	{
+		for( u32 dwLevel = 0; dwLevel < FOVEATION_NUM_LEVELS; ++dwLevel )
+		{
+			FoveationConfig config = foveationLevels[dwLevel];
+			FoveationClampConfig( &config, dwAdditional != 0 );
+			for( u32 dwScale = 0; dwScale < FOVEATION_NUM_SCALES; ++dwScale )
+			{
+				dwFailures += FoveationScaleIndex( DYNRES_MIN_SCALE + ( dwScale * DYNRES_STEP ) ) == dwScale ? 0 : 1;
+				ovrRecti fullViewport = { { 0, 0 }, { (s32)dwFullWidth, (s32)dwFullHeight } };
+				ovrRecti viewport;
+				D3D12_VIEWPORT d3dViewport;
+				D3D12_RECT scissorRect;
+				DynamicResolutionEyeViewport( DYNRES_MIN_SCALE + ( dwScale * DYNRES_STEP ), &fullViewport, &viewport, &d3dViewport, &scissorRect );
+				u32 dwWidth = (u32)viewport.Size.w;
+				u32 dwHeight = (u32)viewport.Size.h;
+				for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+				{
+					QueryPerformanceCounter( &startCounter );
+					f32 fFraction = FoveationBuildRateImage( &config, &fovs[dwEye], dwWidth, dwHeight, dwTileSize, dwImageWidth, dwImageHeight, pImage );
+					QueryPerformanceCounter( &endCounter );
+					fBuildUs += ( 1000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / (f64)frequency.QuadPart;
+					if( dwAdditional && dwScale == FOVEATION_NUM_SCALES - 1 && dwEye == ovrEye_Left )
+					{
+						fShaded[dwLevel] = fFraction;
+					}
+					dwFailures += fFraction > 0.0f && fFraction <= 1.0f ? 0 : 1;
+
+					//every pixel against its tile
+					for( u32 dwY = 0; dwY < dwHeight; ++dwY )
+					{
+						f32 fY = FoveationRingCoord( dwY + 0.5f, dwHeight, fovs[dwEye].UpTan, fovs[dwEye].DownTan );
+						for( u32 dwX = 0; dwX < dwWidth; ++dwX )
+						{
+							f32 fX = FoveationRingCoord( dwX + 0.5f, dwWidth, fovs[dwEye].LeftTan, fovs[dwEye].RightTan );
+							u8 bWanted = FoveationRingRate( &config, ( fX * fX ) + ( fY * fY ) );
+							u8 bRate = pImage[( ( dwY / dwTileSize ) * dwImageWidth ) + ( dwX / dwTileSize )];
+							dwFailures += FoveationRateWidth( bRate ) <= FoveationRateWidth( bWanted ) && FoveationRateHeight( bRate ) <= FoveationRateHeight( bWanted ) ? 0 : 1;
+						}
+					}
+					//no finer than the neighbor closer to the center, and capped without the optional rates
+					u32 dwCenterX = (u32)( ( fovs[dwEye].LeftTan / ( fovs[dwEye].LeftTan + fovs[dwEye].RightTan ) ) * dwWidth ) / dwTileSize;
+					u32 dwCenterY = (u32)( ( fovs[dwEye].UpTan / ( fovs[dwEye].UpTan + fovs[dwEye].DownTan ) ) * dwHeight ) / dwTileSize;
+					dwFailures += pImage[( dwCenterY * dwImageWidth ) + dwCenterX] == config.rings[0].bRate ? 0 : 1;
+					for( u32 dwTileY = 0; dwTileY < dwImageHeight; ++dwTileY )
+					{
+						for( u32 dwTileX = 0; dwTileX < dwImageWidth; ++dwTileX )
+						{
+							u8 bRate = pImage[( dwTileY * dwImageWidth ) + dwTileX];
+							dwFailures += dwAdditional || ( FoveationRateWidth( bRate ) <= 2 && FoveationRateHeight( bRate ) <= 2 ) ? 0 : 1;
+							if( ( dwTileX + 1 ) * dwTileSize > dwWidth || ( dwTileY + 1 ) * dwTileSize > dwHeight )
+							{
+								continue; //a partial tile's closest pixel isn't where the full one's would be
+							}
+							u32 dwInnerX = dwTileX < dwCenterX ? dwTileX + 1 : ( dwTileX > dwCenterX ? dwTileX - 1 : dwTileX );
+							u32 dwInnerY = dwTileY < dwCenterY ? dwTileY + 1 : ( dwTileY > dwCenterY ? dwTileY - 1 : dwTileY );
+							u8 bInner = pImage[( dwInnerY * dwImageWidth ) + dwInnerX];
+							dwFailures += FoveationRateWidth( bInner ) <= FoveationRateWidth( bRate ) && FoveationRateHeight( bInner ) <= FoveationRateHeight( bRate ) ? 0 : 1;
+						}
+					}
+				}
+			}
+		}
+	}
+	u32 dwNumImages = 2 * FOVEATION_NUM_LEVELS * FOVEATION_NUM_SCALES * ovrEye_Count;
+
+	//octilinear at the medium level's warp
+	f32 fWarp = FoveationWarp( fShaded[2] );
+	f32 fMaxSeamError = 0.0f;
+	f32 fMaxEdgeError = 0.0f;
+	f32 fCenterDensity = 0.0f;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		Mat4f mProj;
+		InitEyeProjection( &mProj, fovs[dwEye] );
+		ovrRecti viewport = { { 16, 8 }, { (s32)dwFullWidth, (s32)dwFullHeight } };
+		D3D12_VIEWPORT fullViewport = { 16.0f, 8.0f, (f32)dwFullWidth, (f32)dwFullHeight, 0.0f, 1.0f };
+		ovrTextureLayoutOctilinear layout;
+		FoveationOctilinearLayout( fWarp, &viewport, &layout );
+		dwFailures += viewport.Size.w <= (s32)dwFullWidth && viewport.Size.h <= (s32)dwFullHeight ? 0 : 1;
+		FoveationQuadrant quadrants[FOVEATION_NUM_QUADRANTS];
+		for( u32 dwQuadrant = 0; dwQuadrant < FOVEATION_NUM_QUADRANTS; ++dwQuadrant )
+		{
+			FoveationQuadrantSetup( &layout, &viewport, dwQuadrant, &mProj, &quadrants[dwQuadrant] );
+		}
+		//clip 0,0 is the middle of the tangents, the quadrants split there
+		f32 fMidX = ( fovs[dwEye].RightTan - fovs[dwEye].LeftTan ) * 0.5f;
+		f32 fMidY = ( fovs[dwEye].UpTan - fovs[dwEye].DownTan ) * 0.5f;
+		const u32 dwSteps = 64;
+		for( u32 dwStepY = 0; dwStepY <= dwSteps; ++dwStepY )
+		{
+			f32 fTanY = fovs[dwEye].UpTan - ( ( fovs[dwEye].UpTan + fovs[dwEye].DownTan ) * dwStepY / dwSteps );
+			for( u32 dwStepX = 0; dwStepX <= dwSteps; ++dwStepX )
+			{
+				f32 fTanX = -fovs[dwEye].LeftTan + ( ( fovs[dwEye].LeftTan + fovs[dwEye].RightTan ) * dwStepX / dwSteps );
+				u32 dwQuadrant = ( fTanX >= fMidX ? 1 : 0 ) | ( fTanY >= fMidY ? 0 : 2 );
+				FoveationQuadrant *pQuadrant = &quadrants[dwQuadrant];
+				f32 fX, fY, fDepth, fFarX, fFarY, fFarDepth;
+				FoveationProject( &pQuadrant->mViewProj, &pQuadrant->viewport, fTanX, fTanY, 2.0f, &fX, &fY, &fDepth );
+				FoveationProject( &pQuadrant->mViewProj, &pQuadrant->viewport, fTanX, fTanY, 5.0f, &fFarX, &fFarY, &fFarDepth );
+				D3D12_RECT *pRect = &pQuadrant->scissorRect;
+				dwFailures += fX >= pRect->left - 0.01f && fX <= pRect->right + 0.01f && fY >= pRect->top - 0.01f && fY <= pRect->bottom + 0.01f ? 0 : 1;
+				dwFailures += fabsf( fFarX - fX ) < 0.01f && fabsf( fFarY - fY ) < 0.01f ? 0 : 1;
+#if REVERSE_Z
+				dwFailures += fFarDepth < fDepth ? 0 : 1;
+#else
+				dwFailures += fFarDepth > fDepth ? 0 : 1;
+#endif
+			}
+		}
+		//straight out from the split the fov port's edges land on the rect's, towards the corners they get pulled in
+		f32 fEdgeTans[4][2] = { { -fovs[dwEye].LeftTan, fMidY }, { fovs[dwEye].RightTan, fMidY }, { fMidX, fovs[dwEye].UpTan }, { fMidX, -fovs[dwEye].DownTan } };
+		for( u32 dwEdge = 0; dwEdge < 4; ++dwEdge )
+		{
+			u32 dwQuadrant = dwEdge == 1 ? 1 : ( dwEdge == 3 ? 2 : 0 );
+			D3D12_RECT *pRect = &quadrants[dwQuadrant].scissorRect;
+			f32 fX, fY, fDepth;
+			FoveationProject( &quadrants[dwQuadrant].mViewProj, &quadrants[dwQuadrant].viewport, fEdgeTans[dwEdge][0], fEdgeTans[dwEdge][1], 2.0f, &fX, &fY, &fDepth );
+			f32 fEdgeError = dwEdge < 2 ? fabsf( fX - (f32)( dwEdge ? pRect->right : pRect->left ) ) : fabsf( fY - (f32)( dwEdge == 3 ? pRect->bottom : pRect->top ) );
+			fMaxEdgeError = fEdgeError > fMaxEdgeError ? fEdgeError : fMaxEdgeError;
+		}
+		//the same direction on the split from each side
+		for( u32 dwStep = 0; dwStep <= dwSteps; ++dwStep )
+		{
+			f32 fTanY = fovs[dwEye].UpTan - ( ( fovs[dwEye].UpTan + fovs[dwEye].DownTan ) * dwStep / dwSteps );
+			f32 fTanX = -fovs[dwEye].LeftTan + ( ( fovs[dwEye].LeftTan + fovs[dwEye].RightTan ) * dwStep / dwSteps );
+			u32 dwRow = fTanY >= fMidY ? 0 : 2;
+			u32 dwColumn = fTanX >= fMidX ? 1 : 0;
+			f32 fAX, fAY, fBX, fBY, fDepth;
+			FoveationProject( &quadrants[dwRow].mViewProj, &quadrants[dwRow].viewport, fMidX, fTanY, 3.0f, &fAX, &fAY, &fDepth );
+			FoveationProject( &quadrants[dwRow + 1].mViewProj, &quadrants[dwRow + 1].viewport, fMidX, fTanY, 3.0f, &fBX, &fBY, &fDepth );
+			f32 fSeamError = fabsf( fAX - fBX ) + fabsf( fAY - fBY );
+			FoveationProject( &quadrants[dwColumn].mViewProj, &quadrants[dwColumn].viewport, fTanX, fMidY, 3.0f, &fAX, &fAY, &fDepth );
+			FoveationProject( &quadrants[dwColumn + 2].mViewProj, &quadrants[dwColumn + 2].viewport, fTanX, fMidY, 3.0f, &fBX, &fBY, &fDepth );
+			fSeamError += fabsf( fAX - fBX ) + fabsf( fAY - fBY );
+			fMaxSeamError = fSeamError > fMaxSeamError ? fSeamError : fMaxSeamError;
+		}
+		//pixels per tangent right of the split, against the unwarped viewport
+		f32 fWarpedA, fWarpedB, fFullA, fFullB, fY, fDepth;
+		f32 fStep = 0.001f;
+		FoveationProject( &quadrants[1].mViewProj, &quadrants[1].viewport, fMidX, fMidY + 0.0001f, 3.0f, &fWarpedA, &fY, &fDepth );
+		FoveationProject( &quadrants[1].mViewProj, &quadrants[1].viewport, fMidX + fStep, fMidY + 0.0001f, 3.0f, &fWarpedB, &fY, &fDepth );
+		FoveationProject( &mProj, &fullViewport, fMidX, fMidY, 3.0f, &fFullA, &fY, &fDepth );
+		FoveationProject( &mProj, &fullViewport, fMidX + fStep, fMidY, 3.0f, &fFullB, &fY, &fDepth );
+		fCenterDensity = ( fWarpedB - fWarpedA ) / ( fFullB - fFullA );
+		dwFailures += fabsf( fCenterDensity - 1.0f ) < 0.02f ? 0 : 1;
+	}
+	dwFailures += fMaxEdgeError < 0.05f ? 0 : 1;
+	dwFailures += fMaxSeamError < 0.05f ? 0 : 1;
+
+	printf( "Foveation: %u rate images %ux%u tiles in %.1fus each, shaded low %.1f%% medium %.1f%% high %.1f%%\n", dwNumImages, dwImageWidth, dwImageHeight,
+		fBuildUs / dwNumImages, fShaded[1] * 100.0f, fShaded[2] * 100.0f, fShaded[3] * 100.0f );
+	printf( "Foveation multires: warp %.3f, %.1f%% of the pixels, center density %.3f, edge error %.4fpx, seam error %.4fpx, %u failures\n",
+		fWarp, ( 1.0f - fWarp ) * ( 1.0f - fWarp ) * 100.0f, fCenterDensity, fMaxEdgeError, fMaxSeamError, dwFailures );
+	free( pImage );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,122 @@
+//Frame packets, everything the render thread needs to record and submit one ovr frame
+//the sim thread fills one per frame index while the render thread is still recording/submitting the last one
+//triple buffered, every published packet gets rendered exactly once: ovr_WaitToBeginFrame was already called for its index
+//and a waited index that never sees Begin/EndFrame stalls the compositor, so the sim thread waits for the render thread
+//to take the last packet before it waits on the next index (it only ever waits while it is a whole frame ahead)
+//https://developer.oculus.com/documentation/native/pc/dg-render-advanced/ (WaitToBeginFrame, BeginFrame and EndFrame can be on different threads)
+
+#define FRAME_PACKET_COUNT 3
+#define FRAME_PACKET_FRESH 0x4 //set in dwShared when the sim thread published a packet the render thread hasn't taken yet
+#define FRAME_PACKET_WAIT_MS 100 //so the render thread still notices Running going to 0 when nothing is being published
+
+typedef struct FramePacket
+{
+	u64 qwOculusFrameIndex; //the index ovr_WaitToBeginFrame was called with, Begin/EndFrame must use the same one
+	f64 fPredictedDisplayTime;
+	LARGE_INTEGER earlyPoseCounter; //when the sim thread sampled tracking, for the late latching stats
+	ovrPosef EyeRenderPose[ovrEye_Count];
+	ovrFovPort EyeFov[ovrEye_Count];
+	Quatf qCamRot;
+	Vec3f vCamPos;
+	SceneDrawList draws;
+	u8 hwHandPresent[ovrHand_Count];
+	Mat4f mHandModel[ovrHand_Count]; //fallback if tracking drops out before the render thread latches the hands
+	Mat4f mHandFinalBones[ovrHand_Count][handBonesCount]; //model space, hand model gets multiplied in at latch time
+} FramePacket;
+
+typedef struct FramePacketTripleBuffer
+{
+	FramePacket packets[FRAME_PACKET_COUNT];
+	volatile LONG dwShared; //index of the packet owned by neither thread (plus FRAME_PACKET_FRESH), only touched with InterlockedExchange
+	u32 dwWriteIdx; //sim thread only
+	u32 dwReadIdx; //render thread only
+	HANDLE hPacketReady; //auto reset, signalled on every publish
+	HANDLE hPacketTaken; //auto reset, signalled on every acquire
+} FramePacketTripleBuffer;
+
+FramePacketTripleBuffer framePackets;
+
+inline
+void DestroyFramePackets( FramePacketTripleBuffer *a_pBuffer )
+{
+	if( a_pBuffer->hPacketReady )
+	{
+		CloseHandle( a_pBuffer->hPacketReady );
+		a_pBuffer->hPacketReady = nullptr;
+	}
+	if( a_pBuffer->hPacketTaken )
+	{
+		CloseHandle( a_pBuffer->hPacketTaken );
+		a_pBuffer->hPacketTaken = nullptr;
+	}
+	for( u32 dwPacket = 0; dwPacket < FRAME_PACKET_COUNT; ++dwPacket )
+	{
+		DestroySceneDrawList( &a_pBuffer->packets[dwPacket].draws );
+	}
+}
+
+//dwMaxDraws is the most renderables the sim thread will ever put in one packet
+inline
+bool InitFramePackets( FramePacketTripleBuffer *a_pBuffer, u32 dwMaxDraws )
+{
+	a_pBuffer->dwWriteIdx = 0;
+	a_pBuffer->dwShared = 1;
+	a_pBuffer->dwReadIdx = 2;
+	a_pBuffer->hPacketReady = CreateEvent( nullptr, FALSE, FALSE, nullptr );
+	a_pBuffer->hPacketTaken = CreateEvent( nullptr, FALSE, FALSE, nullptr );
+	bool bSucceeded = a_pBuffer->hPacketReady != nullptr && a_pBuffer->hPacketTaken != nullptr;
+	for( u32 dwPacket = 0; dwPacket < FRAME_PACKET_COUNT; ++dwPacket )
+	{
+		bSucceeded = InitSceneDrawList( &a_pBuffer->packets[dwPacket].draws, dwMaxDraws ) && bSucceeded;
+	}
+	if( !bSucceeded )
+	{
+		DestroyFramePackets( a_pBuffer );
+	}
+	return bSucceeded;
+}
+
+inline
+FramePacket* FramePacketWriteSlot( FramePacketTripleBuffer *a_pBuffer )
+{
+	return &a_pBuffer->packets[a_pBuffer->dwWriteIdx];
+}
+
+//sim thread, true once the render thread took the last published packet, false if it still hadn't after dwTimeoutMs
+//has to be true before ovr_WaitToBeginFrame for the next index, PublishFramePacket would drop the untaken packet otherwise
+inline
+bool WaitFramePacketTaken( FramePacketTripleBuffer *a_pBuffer, DWORD dwTimeoutMs )
+{
+	if( a_pBuffer->dwShared & FRAME_PACKET_FRESH )
+	{
+		WaitForSingleObject( a_pBuffer->hPacketTaken, dwTimeoutMs );
+	}
+	return !( a_pBuffer->dwShared & FRAME_PACKET_FRESH );
+}
+
+//swap the filled write slot into the middle, InterlockedExchange is a full barrier so the packet contents are visible before the index is
+inline
+void PublishFramePacket( FramePacketTripleBuffer *a_pBuffer )
+{
+	LONG dwPrevShared = InterlockedExchange( &a_pBuffer->dwShared, (LONG)( a_pBuffer->dwWriteIdx | FRAME_PACKET_FRESH ) );
+	a_pBuffer->dwWriteIdx = (u32)( dwPrevShared & ~FRAME_PACKET_FRESH );
+	SetEvent( a_pBuffer->hPacketReady );
+}
+
+//returns the unrendered packet or nullptr if none was published within dwTimeoutMs
+inline
+FramePacket* AcquireFramePacket( FramePacketTripleBuffer *a_pBuffer, DWORD dwTimeoutMs )
+{
+	if( !( a_pBuffer->dwShared & FRAME_PACKET_FRESH ) )
+	{
+		WaitForSingleObject( a_pBuffer->hPacketReady, dwTimeoutMs );
+		if( !( a_pBuffer->dwShared & FRAME_PACKET_FRESH ) )
+		{
+			return nullptr;
+		}
+	}
+	LONG dwPrevShared = InterlockedExchange( &a_pBuffer->dwShared, (LONG)a_pBuffer->dwReadIdx );
+	a_pBuffer->dwReadIdx = (u32)( dwPrevShared & ~FRAME_PACKET_FRESH );
+	SetEvent( a_pBuffer->hPacketTaken );
+	return &a_pBuffer->packets[a_pBuffer->dwReadIdx];
+}
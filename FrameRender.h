@@ -0,0 +1,195 @@
+//Frame rendering, the CPU side of what a frame draws: the models' layout, the hands' palettes, the scene, the sorted draws and how each
+//eye records them. RenderFrame records through it into the eye command lists, BenchmarkSoftRaster into a command stream it rasterizes,
+//so the images the benchmark checks are of what the app submits
+
+#define FRAME_STATIC_VERTEX_SIZE ( 3*sizeof(f32) + 3*sizeof(f32) + 4*sizeof(f32) ) //position, normal, color
+#define FRAME_SKINNED_VERTEX_SIZE ( 3*sizeof(f32) + 3*sizeof(f32) + 4*sizeof(u32) + 4*sizeof(f32) + 4*sizeof(f32) ) //position, normal, joints, weights, color
+
+const f32 frameClearColor[] = { 0.5294f, 0.8078f, 0.9216f, 1.0f };
+
+//by MeshId
+const void *frameMeshVertices[MESH_COUNT] = { planeVertices, cubeVertices, handVertices };
+const u32 frameMeshVerticesSize[MESH_COUNT] = { sizeof( planeVertices ), sizeof( cubeVertices ), sizeof( handVertices ) };
+const u32 frameMeshVertexSize[MESH_COUNT] = { FRAME_STATIC_VERTEX_SIZE, FRAME_STATIC_VERTEX_SIZE, FRAME_SKINNED_VERTEX_SIZE };
+const u32 *frameMeshIndexData[MESH_COUNT] = { planeIndices, cubeIndicies, handLodIndices };
+const u32 frameMeshLevels[MESH_COUNT] = { 1, 1, handLodCount };
+
+//16 bit indices wherever the vertex count allows it, the hand's whole LOD chain goes in instead of handIndices (its first level is
+//handIndices as they are). a_ppMeshIndices is by MeshId, the hand's has a MeshIndices per level. returns the bytes FrameWriteModels writes
+inline
+u32 FrameBuildMeshIndices( MeshIndices **a_ppMeshIndices )
+{
+	BuildMeshIndices( a_ppMeshIndices[MESH_PLANE], planeIndices, 0, planeIndexCount, sizeof( planeVertices ) / FRAME_STATIC_VERTEX_SIZE );
+	BuildMeshIndices( a_ppMeshIndices[MESH_CUBE], cubeIndicies, 0, cubeIndexCount, sizeof( cubeVertices ) / FRAME_STATIC_VERTEX_SIZE );
+	BuildMeshLodIndices( a_ppMeshIndices[MESH_HAND], handLodLevels, handLodCount, handLodIndices, sizeof( handVertices ) / FRAME_SKINNED_VERTEX_SIZE );
+	u32 dwSize = 0;
+	for( u32 dwMesh = 0; dwMesh < MESH_COUNT; ++dwMesh )
+	{
+		dwSize += frameMeshVerticesSize[dwMesh] + MeshIndicesSize( a_ppMeshIndices[dwMesh], frameMeshLevels[dwMesh] );
+	}
+	return dwSize;
+}
+
+//each mesh's vertices then its indices into a_pOut, and the views of them for a buffer at qwBase holding a copy of it
+inline
+void FrameWriteModels( u8 *a_pOut, D3D12_GPU_VIRTUAL_ADDRESS qwBase, MeshIndices **a_ppMeshIndices, D3D12_VERTEX_BUFFER_VIEW **a_ppVertexBufferViews,
+	D3D12_INDEX_BUFFER_VIEW **a_ppIndexBufferViews )
+{
+	u32 dwOffset = 0;
+	for( u32 dwMesh = 0; dwMesh < MESH_COUNT; ++dwMesh )
+	{
+		MeshIndices *pMeshIndices = a_ppMeshIndices[dwMesh];
+		memcpy( a_pOut + dwOffset, frameMeshVertices[dwMesh], frameMeshVerticesSize[dwMesh] );
+		a_ppVertexBufferViews[dwMesh]->BufferLocation = qwBase + dwOffset;
+		a_ppVertexBufferViews[dwMesh]->StrideInBytes = frameMeshVertexSize[dwMesh];
+		a_ppVertexBufferViews[dwMesh]->SizeInBytes = frameMeshVerticesSize[dwMesh];
+		dwOffset += frameMeshVerticesSize[dwMesh];
+
+		WriteMeshIndices( pMeshIndices, frameMeshLevels[dwMesh], frameMeshIndexData[dwMesh], a_pOut + dwOffset );
+		a_ppIndexBufferViews[dwMesh]->BufferLocation = qwBase + dwOffset;
+		a_ppIndexBufferViews[dwMesh]->SizeInBytes = MeshIndicesCount( pMeshIndices, frameMeshLevels[dwMesh] ) * pMeshIndices->dwIndexSize;
+		a_ppIndexBufferViews[dwMesh]->Format = pMeshIndices->format;
+		dwOffset += MeshIndicesSize( pMeshIndices, frameMeshLevels[dwMesh] );
+	}
+}
+
+//the hand's model space bones (inverse bind included) at the animation's first key frame, what both hands start at
+inline
+void FrameHandStartingBones( Mat4f *a_pFinalBones )
+{
+	Mat4f mFrameBindBones[handBonesCount];
+	InitModelMat4ByQuatf( &mFrameBindBones[0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans );
+	Mat4fMult( &handInvBind[0], &mFrameBindBones[0], &a_pFinalBones[0] );
+	for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
+	{
+		Mat4f mLocalFrameBone;
+		InitModelMat4ByQuatf( &mLocalFrameBone, &handInnerKeyFrames[0][dwBone-firstInnerBone].qRot, &handInnerKeyFrames[0][dwBone-firstInnerBone].vPos );
+		Mat4fMult( &mLocalFrameBone, &mFrameBindBones[handBoneParents[dwBone]], &mFrameBindBones[dwBone] );
+		Mat4fMult( &handInvBind[dwBone], &mFrameBindBones[dwBone], &a_pFinalBones[dwBone] );
+	}
+	for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
+	{
+		Mat4f mLocalFrameBone;
+		InitModelMat4ByQuatf( &mLocalFrameBone, &handOutterKeyFrames[0][dwBone-firstOutterBone].qRot, &handOutterKeyFrames[0][dwBone-firstOutterBone].vPos );
+		Mat4fMult( &mLocalFrameBone, &mFrameBindBones[handBoneParents[dwBone]], &mFrameBindBones[dwBone] );
+		Mat4fMult( &handInvBind[dwBone], &mFrameBindBones[dwBone], &a_pFinalBones[dwBone] );
+	}
+}
+
+//a hand's palette, its model space bones times the hand's model matrix. built on the stack and copied out in one go,
+//the bone buffer is write combined
+inline
+void FrameWriteHandPalette( Mat4f *a_pFinalBones, Mat4f *a_pHandModel, u8 *a_pOut )
+{
+	Mat4f mPaletteBones[handBonesCount];
+	for( u32 dwBone = 0; dwBone < handBonesCount; ++dwBone )
+	{
+		Mat4fMult( &a_pFinalBones[dwBone], a_pHandModel, &mPaletteBones[dwBone] );
+	}
+	memcpy( a_pOut, mPaletteBones, sizeof( Mat4f ) * handBonesCount );
+}
+
+//the floor, a cube 5m ahead and the hands, each hand is skinned with its own palette so the palette is the hand
+inline
+void FrameCreateSceneEntities( EntityStore *a_pStore, EntityHandle *a_pCube, EntityHandle *a_pHands )
+{
+	Quatf qIdentity = { 1.0f, 0.0f, 0.0f, 0.0f };
+	EntityHandle planeEntity = CreateEntity( a_pStore );
+	AddRenderable( a_pStore, planeEntity, MESH_PLANE );
+
+	*a_pCube = CreateEntity( a_pStore );
+	Vec3f vCubePos = { 0.0f, 0.0f, -5.0f };
+	SetEntityTransform( a_pStore, *a_pCube, &vCubePos, &qIdentity, 1.0f );
+	AddRenderable( a_pStore, *a_pCube, MESH_CUBE );
+
+	for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
+	{
+		a_pHands[dwHand] = CreateEntity( a_pStore );
+		AddRenderable( a_pStore, a_pHands[dwHand], MESH_HAND );
+		AddSkinnedInstance( a_pStore, a_pHands[dwHand], dwHand );
+	}
+}
+
+//the light PixelShader.hlsl shades with
+inline
+void FrameInitPixelConstants( pixelShaderCB *a_pPixelConstants )
+{
+	a_pPixelConstants->vLightColor = {0.83137f,0.62745f,0.09020f,1.0f};
+	a_pPixelConstants->vInvLightDir = {0.57735026919f,0.57735026919f,0.57735026919f};
+}
+
+//a_ppPipelines by RenderPipeline, a_ppRootSignatures by RenderRootSignature, the mesh arrays by MeshId and a_pPalettes per hand,
+//FrameBuildDraws fills the palettes, the instance buffer and the draw data in every frame
+inline
+void FrameInitRenderResources( RenderResources *a_pResources, ID3D12PipelineState **a_ppPipelines, ID3D12RootSignature **a_ppRootSignatures,
+	ID3D12PipelineState *pDrawCBVPipeline, ID3D12PipelineState *pDrawIndexPipeline, D3D12_VERTEX_BUFFER_VIEW **a_ppVertexBufferViews,
+	D3D12_INDEX_BUFFER_VIEW **a_ppIndexBufferViews, MeshIndices **a_ppMeshIndices, D3D12_GPU_VIRTUAL_ADDRESS *a_pPalettes, pixelShaderCB *a_pPixelConstants )
+{
+	memset( a_pResources, 0, sizeof( RenderResources ) );
+	for( u32 dwPipeline = 0; dwPipeline < RENDER_PIPELINE_COUNT; ++dwPipeline )
+	{
+		a_pResources->pPipelines[dwPipeline] = a_ppPipelines[dwPipeline];
+	}
+	for( u32 dwSignature = 0; dwSignature < RENDER_ROOT_SIGNATURE_COUNT; ++dwSignature )
+	{
+		a_pResources->pRootSignatures[dwSignature] = a_ppRootSignatures[dwSignature];
+	}
+	a_pResources->ppVertexBuffers = a_ppVertexBufferViews;
+	a_pResources->ppIndexBuffers = a_ppIndexBufferViews;
+	a_pResources->ppMeshIndices = a_ppMeshIndices;
+	a_pResources->pPalettes = a_pPalettes;
+	a_pResources->pPixelConstants = a_pPixelConstants;
+	a_pResources->dwDrawDataMode = RENDER_DRAW_DATA_ROOT_CONSTANTS;
+	a_pResources->pDrawDataPipelines[RENDER_DRAW_DATA_ROOT_CONSTANTS] = a_ppPipelines[RENDER_PIPELINE_STATIC];
+	a_pResources->pDrawDataPipelines[RENDER_DRAW_DATA_ROOT_CBV] = pDrawCBVPipeline;
+	a_pResources->pDrawDataPipelines[RENDER_DRAW_DATA_INDEX] = pDrawIndexPipeline;
+}
+
+//this frame's upload buffers the draws are written to
+typedef struct FrameDrawBuffers
+{
+	RenderInstance *pInstances;
+	D3D12_VERTEX_BUFFER_VIEW *pInstanceBufferView;
+	u8 *pDrawData;
+	D3D12_GPU_VIRTUAL_ADDRESS qwDrawData;
+	D3D12_GPU_VIRTUAL_ADDRESS qwBones; //every hand's palette back to back dwPaletteSize apart
+	u32 dwPaletteSize;
+} FrameDrawBuffers;
+
+//sorted by state so each eye binds every pipeline, mesh and palette about once, static draws come first,
+//meshes with repeated draws are batched into instanced draws whose instances are written once for both eyes.
+//iDrawDataMode is the RenderDrawDataMode of the static draws left over, -1 lets RenderDrawDataPickMode choose. returns where the skinned draws start
+inline
+u32 FrameBuildDraws( RenderQueue *a_pQueue, RenderResources *a_pResources, SceneDrawList *a_pDraws, u8 *a_pLeftVisible, u8 *a_pRightVisible,
+	u8 *a_pPalettePresent, Vec3f *a_pCenterEye, u8 bInstancing, s32 iDrawDataMode, FrameDrawBuffers *a_pBuffers )
+{
+	BuildSceneRenderQueue( a_pQueue, a_pDraws, a_pLeftVisible, a_pRightVisible, a_pPalettePresent, a_pCenterEye, bInstancing );
+	RenderQueueSort( a_pQueue );
+	RenderQueueWriteInstances( a_pQueue, a_pDraws, a_pBuffers->pInstances );
+	//the buffer modes write the transforms once for both eyes
+	a_pResources->dwDrawDataMode = iDrawDataMode >= 0 ? (u32)iDrawDataMode : RenderDrawDataPickMode( RenderQueueCountDrawData( a_pQueue ) );
+	if( a_pResources->dwDrawDataMode != RENDER_DRAW_DATA_ROOT_CONSTANTS )
+	{
+		RenderQueueWriteDrawData( a_pQueue, a_pDraws, a_pBuffers->pDrawData,
+			a_pResources->dwDrawDataMode == RENDER_DRAW_DATA_ROOT_CBV ? RENDER_DRAW_DATA_CBV_SIZE : sizeof( RenderDrawData ) );
+		a_pResources->qwDrawData = a_pBuffers->qwDrawData;
+	}
+	for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
+	{
+		a_pResources->pPalettes[dwHand] = a_pBuffers->qwBones + ( dwHand * a_pBuffers->dwPaletteSize );
+	}
+	a_pResources->pInstanceBuffer = a_pBuffers->pInstanceBufferView;
+	return RenderQueueLowerBound( a_pQueue, RenderSortKey( RENDER_PASS_OPAQUE, RENDER_PIPELINE_SKINNED, 0, 0, 0, 0, 0 ) );
+}
+
+//an eye's sorted draws [dwBegin, dwEnd), once per foveation quadrant (just once without the octilinear layer)
+inline
+void FrameSubmitDraws( RenderBackend *a_pBackend, RenderQueue *a_pQueue, RenderResources *a_pResources, SceneDrawList *a_pDraws, FoveationQuadrant *a_pQuadrants,
+	Mat4f *a_pViewProj, u8 *a_pVisible, u32 dwBegin, u32 dwEnd )
+{
+	for( u32 dwQuadrant = 0; dwQuadrant < FoveationNumQuadrants(); ++dwQuadrant )
+	{
+		Mat4f *pVP = FoveationBindQuadrant( a_pBackend, a_pQuadrants, dwQuadrant, a_pViewProj );
+		RenderQueueSubmit( a_pQueue, a_pBackend, a_pResources, a_pDraws, pVP, a_pVisible, dwBegin, dwEnd );
+	}
+}
@@ -0,0 +1,382 @@
+//GPU timing, timestamp queries around every pass of each eye's command list
+//each eye resolves its own queries into the readback ring at the end of its command list, the results get read
+//a few frames later once the fence says the GPU is past them, so the CPU never waits on the GPU for timings
+//results are averaged per eye per pass and put on the profiler's timeline as a GPU track (GetClockCalibration lines the clocks up)
+//a frame can also carry a tag (e.g. which shader permutation it drew with), passes are then averaged per tag too for A/B comparisons
+
+#define GPU_TIMER_FRAMES 4 //readback ring depth, a frame goes untimed if the GPU is this far behind
+#define GPU_TIMER_AVG_FRAMES 90 //frames per average, also how often the GPU/CPU clocks get recalibrated
+#define GPU_TIMER_MAX_TAGS 4
+
+enum GpuPass
+{
+	GPU_PASS_EYE, //whole command list, barriers included
+	GPU_PASS_CLEAR,
+	GPU_PASS_STATIC, //every non skinned draw in the draw list
+	GPU_PASS_HANDS, //skinned
+	GPU_PASS_COUNT
+};
+
+#define GPU_TIMER_QUERIES_PER_EYE ( GPU_PASS_COUNT * 2 ) //begin and end
+#define GPU_TIMER_QUERIES_PER_FRAME ( ovrEye_Count * GPU_TIMER_QUERIES_PER_EYE )
+
+//string literals so the profiler can group them
+const char *gpuPassNames[ovrEye_Count][GPU_PASS_COUNT] =
+{
+	{ "GPU Left Eye", "GPU Left Clear", "GPU Left Static", "GPU Left Hands" },
+	{ "GPU Right Eye", "GPU Right Clear", "GPU Right Static", "GPU Right Hands" }
+};
+
+typedef struct GpuTimerSlot
+{
+	u64 qwFrameIndex;
+	u64 qwFenceValue;
+	u32 dwTag;
+	u8 bPending; //submitted and not read back yet
+} GpuTimerSlot;
+
+typedef struct GpuTimer
+{
+	ID3D12QueryHeap *pQueryHeap;
+	ID3D12Resource *pReadbackBuffer;
+	ID3D12Fence *pFence;
+	u64 qwFenceValue;
+	u64 qwTimestampFrequency; //ticks per second
+	u64 qwCalibrationGpuTimestamp; //GetClockCalibration pair, the same instant on both clocks
+	u64 qwCalibrationCpuCounter;
+	f64 fCpuCounterFrequency; //QueryPerformanceFrequency, it's fixed at boot so only asked for once
+	GpuTimerSlot slots[GPU_TIMER_FRAMES];
+	u32 dwWriteSlot; //slot recording this frame, GPU_TIMER_FRAMES if this frame isn't timed
+	f64 fSumPassUs[ovrEye_Count][GPU_PASS_COUNT];
+	f64 fSumFrameUs;
+	u32 dwNumSummed;
+	f64 fAvgPassUs[ovrEye_Count][GPU_PASS_COUNT]; //over the last GPU_TIMER_AVG_FRAMES timed frames
+	f64 fAvgFrameUs; //first eye begin to last eye end
+	f64 fLastFrameUs; //most recent frame read back
+	u32 dwFrameTag; //set before GpuTimerBeginFrame, the frame being recorded gets it
+	const char *tagNames[GPU_TIMER_MAX_TAGS]; //only named tags get reported
+	f64 fSumTagPassUs[GPU_TIMER_MAX_TAGS][GPU_PASS_COUNT]; //both eyes
+	u32 dwNumTagFrames[GPU_TIMER_MAX_TAGS];
+	f64 fAvgTagPassUs[GPU_TIMER_MAX_TAGS][GPU_PASS_COUNT]; //per frame, over the tag's frames in the last GPU_TIMER_AVG_FRAMES
+	u32 dwAvgTagFrames[GPU_TIMER_MAX_TAGS];
+	u64 qwNumFramesProcessed;
+	ProfilerThreadRing *pRing; //only the render thread writes it
+} GpuTimer;
+
+GpuTimer gpuTimer;
+
+inline
+bool InitGpuTimer()
+{
+	D3D12_QUERY_HEAP_DESC queryHeapDesc;
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	queryHeapDesc.Count = GPU_TIMER_FRAMES * GPU_TIMER_QUERIES_PER_FRAME;
+	queryHeapDesc.NodeMask = 0;
+	if( FAILED( device->CreateQueryHeap( &queryHeapDesc, IID_PPV_ARGS( &gpuTimer.pQueryHeap ) ) ) )
+	{
+		logError( "Failed to create timestamp query heap!\n" );
+		return false;
+	}
+
+	D3D12_HEAP_PROPERTIES readbackHeapDesc;
+	readbackHeapDesc.Type = D3D12_HEAP_TYPE_READBACK;
+	readbackHeapDesc.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	readbackHeapDesc.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	readbackHeapDesc.CreationNodeMask = 1;
+	readbackHeapDesc.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC readbackBufferDesc;
+	readbackBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	readbackBufferDesc.Alignment = 0;
+	readbackBufferDesc.Width = sizeof(u64) * GPU_TIMER_FRAMES * GPU_TIMER_QUERIES_PER_FRAME;
+	readbackBufferDesc.Height = 1;
+	readbackBufferDesc.DepthOrArraySize = 1;
+	readbackBufferDesc.MipLevels = 1;
+	readbackBufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	readbackBufferDesc.SampleDesc.Count = 1;
+	readbackBufferDesc.SampleDesc.Quality = 0;
+	readbackBufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	readbackBufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	if( FAILED( device->CreateCommittedResource( &readbackHeapDesc, D3D12_HEAP_FLAG_NONE, &readbackBufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS( &gpuTimer.pReadbackBuffer ) ) ) )
+	{
+		logError( "Failed to create timestamp readback buffer!\n" );
+		return false;
+	}
+#if MAIN_DEBUG
+	gpuTimer.pReadbackBuffer->SetName(L"Timestamp Readback Buffer");
+#endif
+
+	if( FAILED( device->CreateFence( 0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS( &gpuTimer.pFence ) ) ) )
+	{
+		logError( "Failed to create timestamp fence!\n" );
+		return false;
+	}
+	gpuTimer.qwFenceValue = 0;
+
+	if( FAILED( commandQueue->GetTimestampFrequency( &gpuTimer.qwTimestampFrequency ) ) )
+	{
+		logError( "Failed to get GPU timestamp frequency!\n" );
+		return false;
+	}
+	commandQueue->GetClockCalibration( &gpuTimer.qwCalibrationGpuTimestamp, &gpuTimer.qwCalibrationCpuCounter );
+	LARGE_INTEGER PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	gpuTimer.fCpuCounterFrequency = (f64)PerfCountFrequency.QuadPart;
+
+	for( u32 dwSlot = 0; dwSlot < GPU_TIMER_FRAMES; ++dwSlot )
+	{
+		gpuTimer.slots[dwSlot].bPending = 0;
+	}
+	gpuTimer.dwWriteSlot = GPU_TIMER_FRAMES;
+	gpuTimer.dwNumSummed = 0;
+	gpuTimer.qwNumFramesProcessed = 0;
+	gpuTimer.pRing = ProfilerAddRing( "GPU" );
+	return true;
+}
+
+//GPU timestamp to rdtsc ticks on the profiler's timeline
+inline
+u64 GpuTimestampToTsc( u64 qwGpuTimestamp )
+{
+	f64 fCalibrationUs = ( 1000000.0 * (s64)( gpuTimer.qwCalibrationCpuCounter - profiler.startCounter.QuadPart ) ) / gpuTimer.fCpuCounterFrequency;
+	f64 fSinceCalibrationUs = ( 1000000.0 * (s64)( qwGpuTimestamp - gpuTimer.qwCalibrationGpuTimestamp ) ) / (f64)gpuTimer.qwTimestampFrequency;
+	return profiler.qwStartTsc + (u64)( ( fCalibrationUs + fSinceCalibrationUs ) * profiler.fTscPerUs );
+}
+
+//one frame's worth of timestamps, laid out [eye][pass][begin/end]
+inline
+void GpuTimerProcessResults( u64 *a_pTimestamps, u32 dwTag )
+{
+	f64 fUsPerTick = 1000000.0 / (f64)gpuTimer.qwTimestampFrequency;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		for( u32 dwPass = 0; dwPass < GPU_PASS_COUNT; ++dwPass )
+		{
+			u64 qwBegin = a_pTimestamps[( dwEye * GPU_TIMER_QUERIES_PER_EYE ) + ( dwPass * 2 )];
+			u64 qwEnd = a_pTimestamps[( dwEye * GPU_TIMER_QUERIES_PER_EYE ) + ( dwPass * 2 ) + 1];
+			qwEnd = qwEnd < qwBegin ? qwBegin : qwEnd; //can happen if the GPU clock got reset (power state change)
+			gpuTimer.fSumPassUs[dwEye][dwPass] += ( qwEnd - qwBegin ) * fUsPerTick;
+			gpuTimer.fSumTagPassUs[dwTag][dwPass] += ( qwEnd - qwBegin ) * fUsPerTick;
+			if( gpuTimer.pRing )
+			{
+				ProfilerRecordToRing( gpuTimer.pRing, gpuPassNames[dwEye][dwPass], GpuTimestampToTsc( qwBegin ), GpuTimestampToTsc( qwEnd ) );
+			}
+		}
+	}
+	u64 qwFrameBegin = a_pTimestamps[0];
+	u64 qwFrameEnd = a_pTimestamps[( ( ovrEye_Count - 1 ) * GPU_TIMER_QUERIES_PER_EYE ) + ( GPU_PASS_EYE * 2 ) + 1];
+	gpuTimer.fLastFrameUs = qwFrameEnd > qwFrameBegin ? ( qwFrameEnd - qwFrameBegin ) * fUsPerTick : 0.0;
+	gpuTimer.fSumFrameUs += gpuTimer.fLastFrameUs;
+	++gpuTimer.dwNumTagFrames[dwTag];
+	++gpuTimer.qwNumFramesProcessed;
+
+	if( ++gpuTimer.dwNumSummed == GPU_TIMER_AVG_FRAMES )
+	{
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			for( u32 dwPass = 0; dwPass < GPU_PASS_COUNT; ++dwPass )
+			{
+				gpuTimer.fAvgPassUs[dwEye][dwPass] = gpuTimer.fSumPassUs[dwEye][dwPass] / GPU_TIMER_AVG_FRAMES;
+				gpuTimer.fSumPassUs[dwEye][dwPass] = 0.0;
+			}
+		}
+		for( u32 dwTagIdx = 0; dwTagIdx < GPU_TIMER_MAX_TAGS; ++dwTagIdx )
+		{
+			for( u32 dwPass = 0; dwPass < GPU_PASS_COUNT; ++dwPass )
+			{
+				gpuTimer.fAvgTagPassUs[dwTagIdx][dwPass] = gpuTimer.dwNumTagFrames[dwTagIdx] ? gpuTimer.fSumTagPassUs[dwTagIdx][dwPass] / gpuTimer.dwNumTagFrames[dwTagIdx] : 0.0;
+				gpuTimer.fSumTagPassUs[dwTagIdx][dwPass] = 0.0;
+			}
+			gpuTimer.dwAvgTagFrames[dwTagIdx] = gpuTimer.dwNumTagFrames[dwTagIdx];
+			gpuTimer.dwNumTagFrames[dwTagIdx] = 0;
+		}
+		gpuTimer.fAvgFrameUs = gpuTimer.fSumFrameUs / GPU_TIMER_AVG_FRAMES;
+		gpuTimer.fSumFrameUs = 0.0;
+		gpuTimer.dwNumSummed = 0;
+	}
+}
+
+//read back every slot the GPU is done with, never blocks
+inline
+void GpuTimerCollect()
+{
+	u64 qwCompletedValue = gpuTimer.pFence->GetCompletedValue();
+	ProfilerCalibrate(); //GpuTimestampToTsc needs an up to date rdtsc rate
+	for( u32 dwSlot = 0; dwSlot < GPU_TIMER_FRAMES; ++dwSlot )
+	{
+		GpuTimerSlot *pSlot = &gpuTimer.slots[dwSlot];
+		if( !pSlot->bPending || pSlot->qwFenceValue > qwCompletedValue )
+		{
+			continue;
+		}
+		D3D12_RANGE readRange;
+		readRange.Begin = sizeof(u64) * dwSlot * GPU_TIMER_QUERIES_PER_FRAME;
+		readRange.End = readRange.Begin + ( sizeof(u64) * GPU_TIMER_QUERIES_PER_FRAME );
+		u8 *pReadbackData;
+		if( FAILED( gpuTimer.pReadbackBuffer->Map( 0, &readRange, (void**)&pReadbackData ) ) )
+		{
+			pSlot->bPending = 0; //drop this frame's timings, don't hold the slot forever
+			continue;
+		}
+		u64 qwTimestamps[GPU_TIMER_QUERIES_PER_FRAME];
+		memcpy( qwTimestamps, pReadbackData + readRange.Begin, sizeof(qwTimestamps) );
+		D3D12_RANGE writeRange = { 0, 0 }; //we didn't write anything
+		gpuTimer.pReadbackBuffer->Unmap( 0, &writeRange );
+		pSlot->bPending = 0;
+		GpuTimerProcessResults( qwTimestamps, pSlot->dwTag );
+	}
+}
+
+//render thread, before recording
+inline
+void GpuTimerBeginFrame( u64 qwFrameIndex )
+{
+	GpuTimerCollect();
+	if( ( qwFrameIndex % GPU_TIMER_AVG_FRAMES ) == 0 )
+	{
+		commandQueue->GetClockCalibration( &gpuTimer.qwCalibrationGpuTimestamp, &gpuTimer.qwCalibrationCpuCounter ); //the two clocks drift
+	}
+	u32 dwSlot = (u32)( qwFrameIndex % GPU_TIMER_FRAMES );
+	if( gpuTimer.slots[dwSlot].bPending )
+	{
+		gpuTimer.dwWriteSlot = GPU_TIMER_FRAMES; //GPU is way behind, skip timing this frame rather than wait
+		return;
+	}
+	gpuTimer.slots[dwSlot].qwFrameIndex = qwFrameIndex;
+	gpuTimer.slots[dwSlot].dwTag = gpuTimer.dwFrameTag < GPU_TIMER_MAX_TAGS ? gpuTimer.dwFrameTag : 0;
+	gpuTimer.dwWriteSlot = dwSlot;
+}
+
+inline
+void GpuTimerQuery( ID3D12GraphicsCommandList *a_pCommandList, u32 dwEye, u32 dwPass, u32 dwEnd )
+{
+	if( gpuTimer.dwWriteSlot == GPU_TIMER_FRAMES )
+	{
+		return;
+	}
+	u32 dwQuery = ( gpuTimer.dwWriteSlot * GPU_TIMER_QUERIES_PER_FRAME ) + ( dwEye * GPU_TIMER_QUERIES_PER_EYE ) + ( dwPass * 2 ) + dwEnd;
+	a_pCommandList->EndQuery( gpuTimer.pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, dwQuery );
+}
+
+//end of each eye's command list, every query of the eye has to have been written this frame
+inline
+void GpuTimerResolve( ID3D12GraphicsCommandList *a_pCommandList, u32 dwEye )
+{
+	if( gpuTimer.dwWriteSlot == GPU_TIMER_FRAMES )
+	{
+		return;
+	}
+	u32 dwFirstQuery = ( gpuTimer.dwWriteSlot * GPU_TIMER_QUERIES_PER_FRAME ) + ( dwEye * GPU_TIMER_QUERIES_PER_EYE );
+	a_pCommandList->ResolveQueryData( gpuTimer.pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, dwFirstQuery, GPU_TIMER_QUERIES_PER_EYE, gpuTimer.pReadbackBuffer, sizeof(u64) * dwFirstQuery );
+}
+
+//render thread, right after the eye command lists are executed
+inline
+void GpuTimerEndFrame()
+{
+	if( gpuTimer.dwWriteSlot == GPU_TIMER_FRAMES )
+	{
+		return;
+	}
+	++gpuTimer.qwFenceValue;
+	if( FAILED( commandQueue->Signal( gpuTimer.pFence, gpuTimer.qwFenceValue ) ) )
+	{
+		return; //slot stays free, this frame just goes unreported
+	}
+	gpuTimer.slots[gpuTimer.dwWriteSlot].qwFenceValue = gpuTimer.qwFenceValue;
+	gpuTimer.slots[gpuTimer.dwWriteSlot].bPending = 1;
+}
+
+#if MAIN_DEBUG
+inline
+void GpuTimerPrintReport()
+{
+	printf( "GPU frame %.1fus (avg over %u frames)\n", gpuTimer.fAvgFrameUs, GPU_TIMER_AVG_FRAMES );
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		printf( "  %s eye %.1fus: clear %.1fus static %.1fus hands %.1fus\n", dwEye == ovrEye_Left ? "left" : "right", gpuTimer.fAvgPassUs[dwEye][GPU_PASS_EYE],
+			gpuTimer.fAvgPassUs[dwEye][GPU_PASS_CLEAR], gpuTimer.fAvgPassUs[dwEye][GPU_PASS_STATIC], gpuTimer.fAvgPassUs[dwEye][GPU_PASS_HANDS] );
+	}
+	for( u32 dwTag = 0; dwTag < GPU_TIMER_MAX_TAGS; ++dwTag )
+	{
+		if( gpuTimer.tagNames[dwTag] && gpuTimer.dwAvgTagFrames[dwTag] )
+		{
+			printf( "  %s (%u frames): static %.1fus hands %.1fus\n", gpuTimer.tagNames[dwTag], gpuTimer.dwAvgTagFrames[dwTag],
+				gpuTimer.fAvgTagPassUs[dwTag][GPU_PASS_STATIC], gpuTimer.fAvgTagPassUs[dwTag][GPU_PASS_HANDS] );
+		}
+	}
+}
+#endif
+
+#if BENCHMARK_MODE
+//no device here, so feed the aggregation synthetic timestamps with known pass lengths, returns the number of failed checks
+u32 BenchmarkGpuTimer()
+{
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	gpuTimer.qwTimestampFrequency = 10000000; //10MHz, a common GPU timestamp rate
+	gpuTimer.qwCalibrationGpuTimestamp = 5000000000;
+	QueryPerformanceCounter( (LARGE_INTEGER*)&gpuTimer.qwCalibrationCpuCounter );
+	gpuTimer.fCpuCounterFrequency = (f64)PerfCountFrequency.QuadPart;
+	gpuTimer.dwNumSummed = 0;
+	gpuTimer.fSumFrameUs = 0.0;
+	memset( gpuTimer.fSumPassUs, 0, sizeof(gpuTimer.fSumPassUs) );
+	memset( gpuTimer.fSumTagPassUs, 0, sizeof(gpuTimer.fSumTagPassUs) );
+	memset( gpuTimer.dwNumTagFrames, 0, sizeof(gpuTimer.dwNumTagFrames) );
+	gpuTimer.tagNames[0] = "tag 0";
+	gpuTimer.tagNames[1] = "tag 1 (hands 10us slower)";
+	gpuTimer.pRing = ProfilerAddRing( "GPU (synthetic)" );
+	ProfilerCalibrate();
+
+	const u64 qwPassTicks[GPU_PASS_COUNT] = { 0, 500, 1800, 4000 }; //clear 50us static 180us hands 400us, eye is the sum
+	u64 qwTimestamps[GPU_TIMER_QUERIES_PER_FRAME];
+	u64 qwTime = gpuTimer.qwCalibrationGpuTimestamp;
+	//what the averages have to come out to, summed in ticks alongside the synthetic timestamps
+	u64 qwLeftHandsTicks = 0, qwFrameTicks = 0, qwTagHandsTicks[2] = { 0, 0 };
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwFrame = 0; dwFrame < GPU_TIMER_AVG_FRAMES; ++dwFrame )
+	{
+		u64 qwFrameBegin = qwTime;
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			u64 *pEye = &qwTimestamps[dwEye * GPU_TIMER_QUERIES_PER_EYE];
+			pEye[GPU_PASS_EYE * 2] = qwTime;
+			qwTime += 20; //barrier
+			for( u32 dwPass = GPU_PASS_CLEAR; dwPass < GPU_PASS_COUNT; ++dwPass )
+			{
+				pEye[dwPass * 2] = qwTime;
+				qwTime += qwPassTicks[dwPass] + ( dwFrame % 3 ) + ( dwPass == GPU_PASS_HANDS ? ( dwFrame & 1 ) * 100 : 0 ); //a little jitter, odd frames are the B side
+				pEye[( dwPass * 2 ) + 1] = qwTime;
+			}
+			qwTime += 20;
+			pEye[( GPU_PASS_EYE * 2 ) + 1] = qwTime;
+			u64 qwHandsTicks = pEye[( GPU_PASS_HANDS * 2 ) + 1] - pEye[GPU_PASS_HANDS * 2];
+			qwLeftHandsTicks += dwEye == ovrEye_Left ? qwHandsTicks : 0;
+			qwTagHandsTicks[dwFrame & 1] += qwHandsTicks;
+		}
+		qwFrameTicks += qwTime - qwFrameBegin;
+		qwTime += 111111 - ( 2 * ( 6300 + 40 ) ); //rest of an 11.1ms frame
+		GpuTimerProcessResults( qwTimestamps, dwFrame & 1 );
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fUsPerFrame = ( 1000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * GPU_TIMER_AVG_FRAMES );
+	GpuTimerPrintReport();
+
+	u32 dwFailures = 0;
+	f64 fUsPerTick = 1000000.0 / (f64)gpuTimer.qwTimestampFrequency;
+	f64 fExpectedLeftHandsUs = ( qwLeftHandsTicks * fUsPerTick ) / GPU_TIMER_AVG_FRAMES;
+	f64 fExpectedFrameUs = ( qwFrameTicks * fUsPerTick ) / GPU_TIMER_AVG_FRAMES;
+	f64 fExpectedTagDeltaUs = ( ( (f64)qwTagHandsTicks[1] - (f64)qwTagHandsTicks[0] ) * fUsPerTick ) / ( GPU_TIMER_AVG_FRAMES / 2 );
+	f64 fTagDeltaUs = gpuTimer.fAvgTagPassUs[1][GPU_PASS_HANDS] - gpuTimer.fAvgTagPassUs[0][GPU_PASS_HANDS];
+	dwFailures += fabs( gpuTimer.fAvgPassUs[ovrEye_Left][GPU_PASS_HANDS] - fExpectedLeftHandsUs ) < 0.01 ? 0 : 1;
+	dwFailures += fabs( gpuTimer.fAvgFrameUs - fExpectedFrameUs ) < 0.01 ? 0 : 1;
+	dwFailures += fabs( fTagDeltaUs - fExpectedTagDeltaUs ) < 0.01 ? 0 : 1;
+	dwFailures += gpuTimer.dwAvgTagFrames[0] == GPU_TIMER_AVG_FRAMES / 2 && gpuTimer.dwAvgTagFrames[1] == GPU_TIMER_AVG_FRAMES / 2 ? 0 : 1;
+	//a second of GPU time has to land a second later on the profiler's rdtsc timeline
+	f64 fTscPerSecond = (f64)( GpuTimestampToTsc( gpuTimer.qwCalibrationGpuTimestamp + gpuTimer.qwTimestampFrequency ) - GpuTimestampToTsc( gpuTimer.qwCalibrationGpuTimestamp ) );
+	dwFailures += fabs( ( fTscPerSecond / ( profiler.fTscPerUs * 1000000.0 ) ) - 1.0 ) < 0.0001 ? 0 : 1;
+	printf( "GPU timer: %.2fus of CPU per frame to process results, left hands %.1fus (%.1fus expected), frame %.1fus (%.1fus expected), tag 1 hands %.1fus over tag 0 (%.1fus expected), %u failures\n",
+		fUsPerFrame, gpuTimer.fAvgPassUs[ovrEye_Left][GPU_PASS_HANDS], fExpectedLeftHandsUs, gpuTimer.fAvgFrameUs, fExpectedFrameUs, fTagDeltaUs, fExpectedTagDeltaUs, dwFailures );
+	return dwFailures;
+}
+#endif
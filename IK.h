@@ -0,0 +1,569 @@
+//Inverse kinematics for the finger chains of handSkeleton (bones 1-3 and 4-6)
+//https://theorangeduck.com/page/simple-two-joint
+//http://www.andreasaristidou.com/FABRIK.html
+
+//everything is in the space of the chain root's parent (hand model space for the fingers),
+//so callers need to bring world targets into that space first (inverse of mHandModel)
+
+#if AVX_ACTIVE
+#include <immintrin.h>
+#endif
+
+#define IK_MAX_CHAIN_BONES 4
+#define IK_MAX_CHAIN_JOINTS (IK_MAX_CHAIN_BONES+1) //+1 for the end effector (tip)
+#define IK_BATCH_WIDTH 8 //chains per SoA batch, 8 floats lines up with an AVX2 register
+#define IK_TOLERANCE 0.0001f //0.1mm is plenty for fingers
+
+typedef struct IKChain
+{
+	Quatf qParentRot; //rotation of the bone the chain hangs off of (bone 0 for fingers)
+	Vec3f vParentPos;
+	Quatf qLocalRot[IK_MAX_CHAIN_BONES];
+	Vec3f vLocalTrans[IK_MAX_CHAIN_BONES];
+	Vec3f vTipTrans; //end effector offset in the last bone's space
+	u32 dwNumBones;
+} IKChain;
+
+//SoA so the solve can run IK_BATCH_WIDTH chains per instruction, all chains in a batch share dwNumBones
+typedef struct IKChainBatch
+{
+	f32 fJointX[IK_MAX_CHAIN_JOINTS][IK_BATCH_WIDTH];
+	f32 fJointY[IK_MAX_CHAIN_JOINTS][IK_BATCH_WIDTH];
+	f32 fJointZ[IK_MAX_CHAIN_JOINTS][IK_BATCH_WIDTH];
+	f32 fBoneLen[IK_MAX_CHAIN_BONES][IK_BATCH_WIDTH];
+	f32 fTargetX[IK_BATCH_WIDTH];
+	f32 fTargetY[IK_BATCH_WIDTH];
+	f32 fTargetZ[IK_BATCH_WIDTH];
+	u32 dwNumBones;
+} IKChainBatch;
+
+inline
+void IKChainWorldRots( IKChain *a_pChain, Quatf *a_pWorldRots )
+{
+	Quatf qParent = a_pChain->qParentRot;
+	for( u32 dwBone = 0; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		QuatfMult( &qParent, &a_pChain->qLocalRot[dwBone], &a_pWorldRots[dwBone] );
+		qParent = a_pWorldRots[dwBone];
+	}
+}
+
+//forward kinematics, fills dwNumBones+1 joint positions (the last being the tip)
+inline
+void IKChainJoints( IKChain *a_pChain, Quatf *a_pWorldRots, Vec3f *a_pJoints )
+{
+	Quatf *pParentRot = &a_pChain->qParentRot;
+	Vec3f vParentPos = a_pChain->vParentPos;
+	for( u32 dwBone = 0; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		Vec3f vOffset;
+		Vec3fRotByUnitQuat( &a_pChain->vLocalTrans[dwBone], pParentRot, &vOffset );
+		Vec3fAdd( &vParentPos, &vOffset, &a_pJoints[dwBone] );
+		vParentPos = a_pJoints[dwBone];
+		pParentRot = &a_pWorldRots[dwBone];
+	}
+	Vec3f vOffset;
+	Vec3fRotByUnitQuat( &a_pChain->vTipTrans, pParentRot, &vOffset );
+	Vec3fAdd( &vParentPos, &vOffset, &a_pJoints[a_pChain->dwNumBones] );
+}
+
+inline
+void IKChainSetWorldRots( IKChain *a_pChain, Quatf *a_pWorldRots )
+{
+	Quatf qInvParent;
+	QuatfConjugate( &a_pChain->qParentRot, &qInvParent );
+	for( u32 dwBone = 0; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		QuatfMult( &qInvParent, &a_pWorldRots[dwBone], &a_pChain->qLocalRot[dwBone] );
+		QuatfNormalize( &a_pChain->qLocalRot[dwBone], &a_pChain->qLocalRot[dwBone] );
+		QuatfConjugate( &a_pWorldRots[dwBone], &qInvParent );
+	}
+}
+
+inline
+void IKInitChainFromSkeleton( IKChain *a_pChain, Bone *a_pSkeleton, u32 *a_pParents, u32 dwFirstBone, u32 dwNumBones, Vec3f *a_pTipTrans )
+{
+#if MAIN_DEBUG
+	assert( dwNumBones <= IK_MAX_CHAIN_BONES );
+#endif
+	//walk up to the model root to get where the chain hangs from
+	Quatf qParentRot = { 1.0f, 0.0f, 0.0f, 0.0f };
+	Vec3f vParentPos = { 0.0f, 0.0f, 0.0f };
+	u32 dwAncestors[16];
+	u32 dwNumAncestors = 0;
+	for( u32 dwBone = a_pParents[dwFirstBone]; dwBone != (u32)-1 && dwNumAncestors < 16; dwBone = a_pParents[dwBone] )
+	{
+		dwAncestors[dwNumAncestors++] = dwBone;
+	}
+	while( dwNumAncestors > 0 )
+	{
+		Bone *pBone = &a_pSkeleton[dwAncestors[--dwNumAncestors]];
+		Vec3f vOffset;
+		Vec3fRotByUnitQuat( &pBone->vLocalTrans, &qParentRot, &vOffset );
+		Vec3fAdd( &vParentPos, &vOffset, &vParentPos );
+		Quatf qTmp;
+		QuatfMult( &qParentRot, &pBone->qLocalRot, &qTmp );
+		qParentRot = qTmp;
+	}
+
+	a_pChain->qParentRot = qParentRot;
+	a_pChain->vParentPos = vParentPos;
+	for( u32 dwBone = 0; dwBone < dwNumBones; ++dwBone )
+	{
+		a_pChain->qLocalRot[dwBone] = a_pSkeleton[dwFirstBone+dwBone].qLocalRot;
+		a_pChain->vLocalTrans[dwBone] = a_pSkeleton[dwFirstBone+dwBone].vLocalTrans;
+	}
+	a_pChain->vTipTrans = *a_pTipTrans;
+	a_pChain->dwNumBones = dwNumBones;
+}
+
+//analytic two bone solve on the first 2 bones of the chain, the effector is joint 2 (the tip for 2 bone chains)
+//a_pPole picks the bend plane, pass nullptr to keep the current one
+inline
+void IKSolveTwoBone( IKChain *a_pChain, Vec3f *a_pTarget, Vec3f *a_pPole )
+{
+#if MAIN_DEBUG
+	assert( a_pChain->dwNumBones >= 2 );
+#endif
+	Quatf qWorldRots[IK_MAX_CHAIN_BONES];
+	Vec3f vJoints[IK_MAX_CHAIN_JOINTS];
+	IKChainWorldRots( a_pChain, qWorldRots );
+	IKChainJoints( a_pChain, qWorldRots, vJoints );
+
+	Vec3f vAB, vBC, vAC, vAT;
+	Vec3fSub( &vJoints[1], &vJoints[0], &vAB );
+	Vec3fSub( &vJoints[2], &vJoints[1], &vBC );
+	Vec3fSub( &vJoints[2], &vJoints[0], &vAC );
+	Vec3fSub( a_pTarget, &vJoints[0], &vAT );
+
+	f32 fLenAB = Vec3fLength( &vAB );
+	f32 fLenBC = Vec3fLength( &vBC );
+	f32 fLenAC = Vec3fLength( &vAC );
+	f32 fLenAT = clamp( Vec3fLength( &vAT ), IK_TOLERANCE, fLenAB + fLenBC - IK_TOLERANCE );
+	if( fLenAB < IK_TOLERANCE || fLenBC < IK_TOLERANCE || fLenAC < IK_TOLERANCE )
+	{
+		return;
+	}
+
+	//bend: law of cosines for the interior angles the target distance needs
+	Vec3f vBend = vAB;
+	if( a_pPole )
+	{
+		Vec3fSub( a_pPole, &vJoints[0], &vBend );
+	}
+	Vec3f vAxis;
+	Vec3fCross( &vAC, &vBend, &vAxis );
+	if( Vec3fDot( &vAxis, &vAxis ) < IK_TOLERANCE*IK_TOLERANCE )
+	{
+		return; //straight chain with no pole, no plane to bend in
+	}
+	Vec3fNormalize( &vAxis, &vAxis );
+
+	Vec3f vBA;
+	Vec3fScale( &vAB, -1.0f, &vBA );
+	f32 fCurrA = acosf( clamp( Vec3fDot( &vAC, &vAB ) / ( fLenAC * fLenAB ), -1.0f, 1.0f ) );
+	f32 fCurrB = acosf( clamp( Vec3fDot( &vBA, &vBC ) / ( fLenAB * fLenBC ), -1.0f, 1.0f ) );
+	f32 fWantA = acosf( clamp( ( ( fLenBC * fLenBC ) - ( fLenAB * fLenAB ) - ( fLenAT * fLenAT ) ) / ( -2.0f * fLenAB * fLenAT ), -1.0f, 1.0f ) );
+	f32 fWantB = acosf( clamp( ( ( fLenAT * fLenAT ) - ( fLenAB * fLenAB ) - ( fLenBC * fLenBC ) ) / ( -2.0f * fLenAB * fLenBC ), -1.0f, 1.0f ) );
+
+	//InitUnitQuatf takes degrees
+	Quatf qBendA, qBendB;
+	InitUnitQuatf( &qBendA, ( fWantA - fCurrA ) * ( 180.0f / PI_F ), &vAxis );
+	InitUnitQuatf( &qBendB, ( fWantB - fCurrB ) * ( 180.0f / PI_F ), &vAxis );
+
+	Quatf qTmp;
+	QuatfMult( &qBendA, &qWorldRots[0], &qTmp );
+	qWorldRots[0] = qTmp;
+	Quatf qBendAB;
+	QuatfMult( &qBendB, &qBendA, &qBendAB );
+	for( u32 dwBone = 1; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		QuatfMult( &qBendAB, &qWorldRots[dwBone], &qTmp );
+		qWorldRots[dwBone] = qTmp;
+	}
+	IKChainSetWorldRots( a_pChain, qWorldRots );
+
+	//swing: point the bent chain at the target
+	IKChainWorldRots( a_pChain, qWorldRots );
+	IKChainJoints( a_pChain, qWorldRots, vJoints );
+	Vec3fSub( &vJoints[2], &vJoints[0], &vAC );
+	Quatf qSwing;
+	InitUnitQuatfFromTo( &qSwing, &vAC, &vAT );
+	for( u32 dwBone = 0; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		QuatfMult( &qSwing, &qWorldRots[dwBone], &qTmp );
+		qWorldRots[dwBone] = qTmp;
+	}
+	IKChainSetWorldRots( a_pChain, qWorldRots );
+}
+
+//cyclic coordinate descent, returns the remaining distance from the tip to the target
+inline
+f32 IKSolveCCD( IKChain *a_pChain, Vec3f *a_pTarget, u32 dwMaxIterations )
+{
+	Quatf qWorldRots[IK_MAX_CHAIN_BONES];
+	Vec3f vJoints[IK_MAX_CHAIN_JOINTS];
+	Vec3f vErr;
+	IKChainWorldRots( a_pChain, qWorldRots );
+	IKChainJoints( a_pChain, qWorldRots, vJoints );
+	for( u32 dwIter = 0; dwIter < dwMaxIterations; ++dwIter )
+	{
+		Vec3fSub( a_pTarget, &vJoints[a_pChain->dwNumBones], &vErr );
+		if( Vec3fLength( &vErr ) < IK_TOLERANCE )
+		{
+			break;
+		}
+		for( s32 dwBone = (s32)a_pChain->dwNumBones - 1; dwBone >= 0; --dwBone )
+		{
+			Vec3f vToTip, vToTarget;
+			Vec3fSub( &vJoints[a_pChain->dwNumBones], &vJoints[dwBone], &vToTip );
+			Vec3fSub( a_pTarget, &vJoints[dwBone], &vToTarget );
+			Quatf qDelta;
+			InitUnitQuatfFromTo( &qDelta, &vToTip, &vToTarget );
+			//rotate this bone and carry every child joint along with it
+			for( u32 dwChild = (u32)dwBone; dwChild < a_pChain->dwNumBones; ++dwChild )
+			{
+				Quatf qTmp;
+				QuatfMult( &qDelta, &qWorldRots[dwChild], &qTmp );
+				QuatfNormalize( &qTmp, &qWorldRots[dwChild] );
+			}
+			for( u32 dwJoint = (u32)dwBone + 1; dwJoint <= a_pChain->dwNumBones; ++dwJoint )
+			{
+				Vec3f vRel, vRot;
+				Vec3fSub( &vJoints[dwJoint], &vJoints[dwBone], &vRel );
+				Vec3fRotByUnitQuat( &vRel, &qDelta, &vRot );
+				Vec3fAdd( &vJoints[dwBone], &vRot, &vJoints[dwJoint] );
+			}
+		}
+	}
+	IKChainSetWorldRots( a_pChain, qWorldRots );
+	Vec3fSub( a_pTarget, &vJoints[a_pChain->dwNumBones], &vErr );
+	return Vec3fLength( &vErr );
+}
+
+inline
+void IKBatchLoadChain( IKChainBatch *a_pBatch, u32 dwLane, IKChain *a_pChain, Vec3f *a_pTarget )
+{
+	Quatf qWorldRots[IK_MAX_CHAIN_BONES];
+	Vec3f vJoints[IK_MAX_CHAIN_JOINTS];
+	IKChainWorldRots( a_pChain, qWorldRots );
+	IKChainJoints( a_pChain, qWorldRots, vJoints );
+	a_pBatch->dwNumBones = a_pChain->dwNumBones;
+	for( u32 dwJoint = 0; dwJoint <= a_pChain->dwNumBones; ++dwJoint )
+	{
+		a_pBatch->fJointX[dwJoint][dwLane] = vJoints[dwJoint].x;
+		a_pBatch->fJointY[dwJoint][dwLane] = vJoints[dwJoint].y;
+		a_pBatch->fJointZ[dwJoint][dwLane] = vJoints[dwJoint].z;
+	}
+	for( u32 dwBone = 0; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		Vec3f vBone;
+		Vec3fSub( &vJoints[dwBone+1], &vJoints[dwBone], &vBone );
+		a_pBatch->fBoneLen[dwBone][dwLane] = Vec3fLength( &vBone );
+	}
+	a_pBatch->fTargetX[dwLane] = a_pTarget->x;
+	a_pBatch->fTargetY[dwLane] = a_pTarget->y;
+	a_pBatch->fTargetZ[dwLane] = a_pTarget->z;
+}
+
+//re-aims each bone of the chain at its solved joint, keeps the twist the bone already had
+inline
+void IKBatchStoreChain( IKChainBatch *a_pBatch, u32 dwLane, IKChain *a_pChain )
+{
+	Quatf qWorldRots[IK_MAX_CHAIN_BONES];
+	Vec3f vJoints[IK_MAX_CHAIN_JOINTS];
+	IKChainWorldRots( a_pChain, qWorldRots );
+	for( u32 dwBone = 0; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		IKChainJoints( a_pChain, qWorldRots, vJoints );
+		Vec3f vCurr, vSolved;
+		Vec3fSub( &vJoints[dwBone+1], &vJoints[dwBone], &vCurr );
+		vSolved.x = a_pBatch->fJointX[dwBone+1][dwLane] - vJoints[dwBone].x;
+		vSolved.y = a_pBatch->fJointY[dwBone+1][dwLane] - vJoints[dwBone].y;
+		vSolved.z = a_pBatch->fJointZ[dwBone+1][dwLane] - vJoints[dwBone].z;
+		Quatf qDelta;
+		InitUnitQuatfFromTo( &qDelta, &vCurr, &vSolved );
+		for( u32 dwChild = dwBone; dwChild < a_pChain->dwNumBones; ++dwChild )
+		{
+			Quatf qTmp;
+			QuatfMult( &qDelta, &qWorldRots[dwChild], &qTmp );
+			QuatfNormalize( &qTmp, &qWorldRots[dwChild] );
+		}
+	}
+	IKChainSetWorldRots( a_pChain, qWorldRots );
+}
+
+//FABRIK on one lane of a batch, the scalar path of IKSolveFABRIKBatch and what the batched lanes get checked against
+inline
+void IKSolveFABRIKLane( IKChainBatch *a_pBatch, u32 dwLane, u32 dwIterations )
+{
+	const u32 dwEnd = a_pBatch->dwNumBones;
+	f32 fRootX = a_pBatch->fJointX[0][dwLane];
+	f32 fRootY = a_pBatch->fJointY[0][dwLane];
+	f32 fRootZ = a_pBatch->fJointZ[0][dwLane];
+	for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+	{
+		//backward: pin the tip to the target and pull the chain after it
+		a_pBatch->fJointX[dwEnd][dwLane] = a_pBatch->fTargetX[dwLane];
+		a_pBatch->fJointY[dwEnd][dwLane] = a_pBatch->fTargetY[dwLane];
+		a_pBatch->fJointZ[dwEnd][dwLane] = a_pBatch->fTargetZ[dwLane];
+		for( s32 dwJoint = (s32)dwEnd - 1; dwJoint >= 0; --dwJoint )
+		{
+			f32 fDx = a_pBatch->fJointX[dwJoint][dwLane] - a_pBatch->fJointX[dwJoint+1][dwLane];
+			f32 fDy = a_pBatch->fJointY[dwJoint][dwLane] - a_pBatch->fJointY[dwJoint+1][dwLane];
+			f32 fDz = a_pBatch->fJointZ[dwJoint][dwLane] - a_pBatch->fJointZ[dwJoint+1][dwLane];
+			f32 fScale = a_pBatch->fBoneLen[dwJoint][dwLane] / ( sqrtf( fDx*fDx + fDy*fDy + fDz*fDz ) + 1e-12f );
+			a_pBatch->fJointX[dwJoint][dwLane] = a_pBatch->fJointX[dwJoint+1][dwLane] + fDx*fScale;
+			a_pBatch->fJointY[dwJoint][dwLane] = a_pBatch->fJointY[dwJoint+1][dwLane] + fDy*fScale;
+			a_pBatch->fJointZ[dwJoint][dwLane] = a_pBatch->fJointZ[dwJoint+1][dwLane] + fDz*fScale;
+		}
+		//forward: pin the root back where it was and push the chain out
+		a_pBatch->fJointX[0][dwLane] = fRootX;
+		a_pBatch->fJointY[0][dwLane] = fRootY;
+		a_pBatch->fJointZ[0][dwLane] = fRootZ;
+		for( u32 dwJoint = 1; dwJoint <= dwEnd; ++dwJoint )
+		{
+			f32 fDx = a_pBatch->fJointX[dwJoint][dwLane] - a_pBatch->fJointX[dwJoint-1][dwLane];
+			f32 fDy = a_pBatch->fJointY[dwJoint][dwLane] - a_pBatch->fJointY[dwJoint-1][dwLane];
+			f32 fDz = a_pBatch->fJointZ[dwJoint][dwLane] - a_pBatch->fJointZ[dwJoint-1][dwLane];
+			f32 fScale = a_pBatch->fBoneLen[dwJoint-1][dwLane] / ( sqrtf( fDx*fDx + fDy*fDy + fDz*fDz ) + 1e-12f );
+			a_pBatch->fJointX[dwJoint][dwLane] = a_pBatch->fJointX[dwJoint-1][dwLane] + fDx*fScale;
+			a_pBatch->fJointY[dwJoint][dwLane] = a_pBatch->fJointY[dwJoint-1][dwLane] + fDy*fScale;
+			a_pBatch->fJointZ[dwJoint][dwLane] = a_pBatch->fJointZ[dwJoint-1][dwLane] + fDz*fScale;
+		}
+	}
+}
+
+#if AVX_ACTIVE
+//moves joint a_dwTo to bone length a_dwBone away from joint a_dwFrom along the line between them, all 8 lanes at once
+inline
+void IKFABRIKPull8( IKChainBatch *a_pBatch, u32 dwTo, u32 dwFrom, u32 dwBone )
+{
+	__m256 vFromX = _mm256_loadu_ps( a_pBatch->fJointX[dwFrom] );
+	__m256 vFromY = _mm256_loadu_ps( a_pBatch->fJointY[dwFrom] );
+	__m256 vFromZ = _mm256_loadu_ps( a_pBatch->fJointZ[dwFrom] );
+	__m256 vDx = _mm256_sub_ps( _mm256_loadu_ps( a_pBatch->fJointX[dwTo] ), vFromX );
+	__m256 vDy = _mm256_sub_ps( _mm256_loadu_ps( a_pBatch->fJointY[dwTo] ), vFromY );
+	__m256 vDz = _mm256_sub_ps( _mm256_loadu_ps( a_pBatch->fJointZ[dwTo] ), vFromZ );
+	//same operation order as IKSolveFABRIKLane with a full sqrt and div, not the rsqrt estimate, so both paths agree
+	__m256 vLenSq = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vDx, vDx ), _mm256_mul_ps( vDy, vDy ) ), _mm256_mul_ps( vDz, vDz ) );
+	__m256 vScale = _mm256_div_ps( _mm256_loadu_ps( a_pBatch->fBoneLen[dwBone] ), _mm256_add_ps( _mm256_sqrt_ps( vLenSq ), _mm256_set1_ps( 1e-12f ) ) );
+	_mm256_storeu_ps( a_pBatch->fJointX[dwTo], _mm256_add_ps( vFromX, _mm256_mul_ps( vDx, vScale ) ) );
+	_mm256_storeu_ps( a_pBatch->fJointY[dwTo], _mm256_add_ps( vFromY, _mm256_mul_ps( vDy, vScale ) ) );
+	_mm256_storeu_ps( a_pBatch->fJointZ[dwTo], _mm256_add_ps( vFromZ, _mm256_mul_ps( vDz, vScale ) ) );
+}
+#endif
+
+//FABRIK over every lane of every batch with a fixed iteration count, no early outs so the lanes never diverge
+//unused lanes should be loaded with a copy of a real chain so they stay finite
+inline
+void IKSolveFABRIKBatch( IKChainBatch *a_pBatches, u32 dwNumBatches, u32 dwIterations )
+{
+	for( u32 dwBatch = 0; dwBatch < dwNumBatches; ++dwBatch )
+	{
+		IKChainBatch *pBatch = &a_pBatches[dwBatch];
+#if AVX_ACTIVE
+		const u32 dwEnd = pBatch->dwNumBones;
+		__m256 vRootX = _mm256_loadu_ps( pBatch->fJointX[0] );
+		__m256 vRootY = _mm256_loadu_ps( pBatch->fJointY[0] );
+		__m256 vRootZ = _mm256_loadu_ps( pBatch->fJointZ[0] );
+		for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+		{
+			memcpy( pBatch->fJointX[dwEnd], pBatch->fTargetX, sizeof( pBatch->fTargetX ) );
+			memcpy( pBatch->fJointY[dwEnd], pBatch->fTargetY, sizeof( pBatch->fTargetY ) );
+			memcpy( pBatch->fJointZ[dwEnd], pBatch->fTargetZ, sizeof( pBatch->fTargetZ ) );
+			for( s32 dwJoint = (s32)dwEnd - 1; dwJoint >= 0; --dwJoint )
+			{
+				IKFABRIKPull8( pBatch, (u32)dwJoint, (u32)dwJoint + 1, (u32)dwJoint );
+			}
+			_mm256_storeu_ps( pBatch->fJointX[0], vRootX );
+			_mm256_storeu_ps( pBatch->fJointY[0], vRootY );
+			_mm256_storeu_ps( pBatch->fJointZ[0], vRootZ );
+			for( u32 dwJoint = 1; dwJoint <= dwEnd; ++dwJoint )
+			{
+				IKFABRIKPull8( pBatch, dwJoint, dwJoint - 1, dwJoint - 1 );
+			}
+		}
+#else
+		for( u32 dwLane = 0; dwLane < IK_BATCH_WIDTH; ++dwLane )
+		{
+			IKSolveFABRIKLane( pBatch, dwLane, dwIterations );
+		}
+#endif
+	}
+}
+
+//rebuilds the skinning matrices of the chain's bones, a_pModelBones must already hold the chain's parent
+inline
+void IKWriteChainFinalBones( IKChain *a_pChain, Bone *a_pSkeleton, u32 *a_pParents, Mat4f *a_pInvBind, u32 dwFirstBone, Mat4f *a_pModelBones, Mat4f *a_pFinalBones )
+{
+	for( u32 dwBone = 0; dwBone < a_pChain->dwNumBones; ++dwBone )
+	{
+		u32 dwSkelBone = dwFirstBone + dwBone;
+		Mat4f mLocal;
+		InitModelMat4ByQuatf( &mLocal, &a_pChain->qLocalRot[dwBone], &a_pSkeleton[dwSkelBone].vLocalTrans );
+		Mat4fMult( &mLocal, &a_pModelBones[a_pParents[dwSkelBone]], &a_pModelBones[dwSkelBone] );
+		Mat4fMult( &a_pInvBind[dwSkelBone], &a_pModelBones[dwSkelBone], &a_pFinalBones[dwSkelBone] );
+	}
+}
+
+#if BENCHMARK_MODE
+u32 BenchmarkIK()
+{
+	const u32 dwNumChains = 4096; //way more fingers than 2 hands have, to get a stable number
+	const u32 dwNumBatches = dwNumChains / IK_BATCH_WIDTH;
+	const u32 dwRuns = 64;
+	const u32 dwIterations = 4;
+
+	IKChain chain;
+	Vec3f vTip = { 0.0f, 0.025f, 0.0f };
+	IKInitChainFromSkeleton( &chain, handSkeleton, handBoneParents, firstOutterBone, numOutterChannels, &vTip );
+
+	IKChain *pChains = (IKChain*)malloc( sizeof(IKChain) * dwNumChains );
+	Vec3f *pTargets = (Vec3f*)malloc( sizeof(Vec3f) * dwNumChains );
+	IKChainBatch *pBatches = (IKChainBatch*)malloc( sizeof(IKChainBatch) * dwNumBatches );
+	if( !pChains || !pTargets || !pBatches )
+	{
+		printf( "IK: out of memory\n" );
+		free( pBatches );
+		free( pTargets );
+		free( pChains );
+		return 1;
+	}
+
+	Quatf qWorldRots[IK_MAX_CHAIN_BONES];
+	Vec3f vJoints[IK_MAX_CHAIN_JOINTS];
+	IKChainWorldRots( &chain, qWorldRots );
+	IKChainJoints( &chain, qWorldRots, vJoints );
+	for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+	{
+		pChains[dwChain] = chain;
+		f32 fT = (f32)dwChain / (f32)dwNumChains;
+		pTargets[dwChain].x = vJoints[0].x + 0.03f * cosf( fT * 2.0f * PI_F );
+		pTargets[dwChain].y = vJoints[0].y + 0.04f;
+		pTargets[dwChain].z = vJoints[0].z + 0.03f * sinf( fT * 2.0f * PI_F );
+	}
+
+	LARGE_INTEGER PerfCountFrequency, Start, End;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+
+	QueryPerformanceCounter( &Start );
+	for( u32 dwRun = 0; dwRun < dwRuns; ++dwRun )
+	{
+		for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+		{
+			IKChain solve = pChains[dwChain];
+			IKSolveTwoBone( &solve, &pTargets[dwChain], nullptr );
+		}
+	}
+	QueryPerformanceCounter( &End );
+	f64 fSeconds = (f64)( End.QuadPart - Start.QuadPart ) / (f64)PerfCountFrequency.QuadPart;
+	printf( "IK two bone:  %.0f solves/sec\n", ( dwRuns * dwNumChains ) / fSeconds );
+
+	QueryPerformanceCounter( &Start );
+	for( u32 dwRun = 0; dwRun < dwRuns; ++dwRun )
+	{
+		for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+		{
+			IKChain solve = pChains[dwChain];
+			IKSolveCCD( &solve, &pTargets[dwChain], dwIterations );
+		}
+	}
+	QueryPerformanceCounter( &End );
+	fSeconds = (f64)( End.QuadPart - Start.QuadPart ) / (f64)PerfCountFrequency.QuadPart;
+	printf( "IK CCD (%u iterations):  %.0f solves/sec\n", dwIterations, ( dwRuns * dwNumChains ) / fSeconds );
+
+	QueryPerformanceCounter( &Start );
+	for( u32 dwRun = 0; dwRun < dwRuns; ++dwRun )
+	{
+		for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+		{
+			IKBatchLoadChain( &pBatches[dwChain / IK_BATCH_WIDTH], dwChain % IK_BATCH_WIDTH, &pChains[dwChain], &pTargets[dwChain] );
+		}
+		IKSolveFABRIKBatch( pBatches, dwNumBatches, dwIterations );
+		for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+		{
+			IKChain solve = pChains[dwChain];
+			IKBatchStoreChain( &pBatches[dwChain / IK_BATCH_WIDTH], dwChain % IK_BATCH_WIDTH, &solve );
+		}
+	}
+	QueryPerformanceCounter( &End );
+	fSeconds = (f64)( End.QuadPart - Start.QuadPart ) / (f64)PerfCountFrequency.QuadPart;
+	printf( "IK FABRIK SoA batch (%u iterations, load+solve+store):  %.0f solves/sec\n", dwIterations, ( dwRuns * dwNumChains ) / fSeconds );
+
+	//correctness: every target above is in reach, so each solver has to land the effector on it without stretching a bone
+	const u32 dwCheckIterations = 32;
+	const f32 fReachTolerance = 0.001f;
+	const f32 fLengthTolerance = 0.00001f;
+	u32 dwFailures = 0;
+	f32 fBoneLen[IK_MAX_CHAIN_BONES];
+	for( u32 dwBone = 0; dwBone < chain.dwNumBones; ++dwBone )
+	{
+		Vec3f vBone;
+		Vec3fSub( &vJoints[dwBone+1], &vJoints[dwBone], &vBone );
+		fBoneLen[dwBone] = Vec3fLength( &vBone );
+	}
+	f32 fMaxErr[3] = { 0.0f, 0.0f, 0.0f }; //two bone, CCD, FABRIK
+	for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+	{
+		IKChain solved[3] = { pChains[dwChain], pChains[dwChain], pChains[dwChain] };
+		IKSolveTwoBone( &solved[0], &pTargets[dwChain], nullptr );
+		IKSolveCCD( &solved[1], &pTargets[dwChain], dwCheckIterations );
+		IKChainBatch *pBatch = &pBatches[dwChain / IK_BATCH_WIDTH];
+		IKBatchStoreChain( pBatch, dwChain % IK_BATCH_WIDTH, &solved[2] );
+		for( u32 dwSolver = 0; dwSolver < 3; ++dwSolver )
+		{
+			IKChainWorldRots( &solved[dwSolver], qWorldRots );
+			IKChainJoints( &solved[dwSolver], qWorldRots, vJoints );
+			//the two bone solve places joint 2, the other two the tip
+			Vec3f vErr;
+			Vec3fSub( &pTargets[dwChain], &vJoints[dwSolver == 0 ? 2 : chain.dwNumBones], &vErr );
+			fMaxErr[dwSolver] = fmaxf( fMaxErr[dwSolver], Vec3fLength( &vErr ) );
+			for( u32 dwBone = 0; dwBone < chain.dwNumBones; ++dwBone )
+			{
+				Vec3f vBone;
+				Vec3fSub( &vJoints[dwBone+1], &vJoints[dwBone], &vBone );
+				dwFailures += fabsf( Vec3fLength( &vBone ) - fBoneLen[dwBone] ) < fLengthTolerance ? 0 : 1;
+			}
+		}
+	}
+	//pBatches still hold the last timed run at dwIterations, resolve them at dwCheckIterations and then
+	//every chain again on its own through the scalar lane solve, the batched lanes must not mix or drift from it
+	for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+	{
+		IKBatchLoadChain( &pBatches[dwChain / IK_BATCH_WIDTH], dwChain % IK_BATCH_WIDTH, &pChains[dwChain], &pTargets[dwChain] );
+	}
+	IKSolveFABRIKBatch( pBatches, dwNumBatches, dwCheckIterations );
+	f32 fMaxLaneDiff = 0.0f;
+	for( u32 dwChain = 0; dwChain < dwNumChains; ++dwChain )
+	{
+		IKChainBatch *pBatch = &pBatches[dwChain / IK_BATCH_WIDTH];
+		u32 dwLane = dwChain % IK_BATCH_WIDTH;
+		IKChainBatch single;
+		IKBatchLoadChain( &single, 0, &pChains[dwChain], &pTargets[dwChain] );
+		IKSolveFABRIKLane( &single, 0, dwCheckIterations );
+		for( u32 dwJoint = 0; dwJoint <= chain.dwNumBones; ++dwJoint )
+		{
+			fMaxLaneDiff = fmaxf( fMaxLaneDiff, fabsf( pBatch->fJointX[dwJoint][dwLane] - single.fJointX[dwJoint][0] ) );
+			fMaxLaneDiff = fmaxf( fMaxLaneDiff, fabsf( pBatch->fJointY[dwJoint][dwLane] - single.fJointY[dwJoint][0] ) );
+			fMaxLaneDiff = fmaxf( fMaxLaneDiff, fabsf( pBatch->fJointZ[dwJoint][dwLane] - single.fJointZ[dwJoint][0] ) );
+		}
+		for( u32 dwBone = 0; dwBone < chain.dwNumBones; ++dwBone )
+		{
+			f32 fDx = pBatch->fJointX[dwBone+1][dwLane] - pBatch->fJointX[dwBone][dwLane];
+			f32 fDy = pBatch->fJointY[dwBone+1][dwLane] - pBatch->fJointY[dwBone][dwLane];
+			f32 fDz = pBatch->fJointZ[dwBone+1][dwLane] - pBatch->fJointZ[dwBone][dwLane];
+			dwFailures += fabsf( sqrtf( fDx*fDx + fDy*fDy + fDz*fDz ) - fBoneLen[dwBone] ) < fLengthTolerance ? 0 : 1;
+		}
+	}
+	dwFailures += fMaxErr[0] < fReachTolerance && fMaxErr[1] < fReachTolerance && fMaxErr[2] < fReachTolerance ? 0 : 1;
+	dwFailures += fMaxLaneDiff < fLengthTolerance ? 0 : 1;
+	printf( "IK checks: max effector error two bone %.2gm, CCD %.2gm, FABRIK %.2gm, batch vs single lane %.2gm, %u failures\n",
+		fMaxErr[0], fMaxErr[1], fMaxErr[2], fMaxLaneDiff, dwFailures );
+
+	free( pBatches );
+	free( pTargets );
+	free( pChains );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,92 @@
+//GPU side of IndirectDraw.h, one thread per static draw: world box from the mesh bounds, tested against each eye's planes,
+//then for each eye that sees it an indirect command (vertex/index buffer views, vertexShaderCB root constants, draw arguments)
+//appended to that eye's half of the argument buffer. counts holds each eye's ExecuteIndirect count
+
+#define EYE_COUNT 2
+#define CULL_MAX_PLANES 6
+#define INDIRECT_COMMAND_SIZE 160
+
+cbuffer cullCB : register(b0)
+{
+	float4 viewProjRows[EYE_COUNT * 4]; //row vector convention like the cpu side, mvp = world * viewProj
+	float4 planes[EYE_COUNT * CULL_MAX_PLANES]; //inwards, the unused ones are 0,0,0,1 and always pass
+	uint numObjects;
+	uint commandCapacity; //commands per eye, the right eye's start right after
+};
+
+struct IndirectMesh
+{
+	uint4 vertexBufferView; //D3D12_VERTEX_BUFFER_VIEW
+	uint4 indexBufferView; //D3D12_INDEX_BUFFER_VIEW
+	float3 center; //mesh space bounds
+	uint indexCount;
+	float3 extent;
+	uint pad;
+};
+
+StructuredBuffer<float4> worldRows : register(t0); //4 per object
+StructuredBuffer<float4> normalRows : register(t1); //3 per object, w is padding
+StructuredBuffer<uint> meshes : register(t2);
+StructuredBuffer<IndirectMesh> meshTable : register(t3);
+RWByteAddressBuffer commands : register(u0);
+RWByteAddressBuffer counts : register(u1); //a uint per eye, cleared before the dispatch
+
+[numthreads(64, 1, 1)]
+void main( uint3 threadId : SV_DispatchThreadID )
+{
+	uint object = threadId.x;
+	if( object >= numObjects )
+	{
+		return;
+	}
+	float4 w0 = worldRows[( object * 4 ) + 0];
+	float4 w1 = worldRows[( object * 4 ) + 1];
+	float4 w2 = worldRows[( object * 4 ) + 2];
+	float4 w3 = worldRows[( object * 4 ) + 3];
+	IndirectMesh mesh = meshTable[meshes[object]];
+
+	//same as TransformCullBox
+	float3 center = ( w0.xyz * mesh.center.x ) + ( w1.xyz * mesh.center.y ) + ( w2.xyz * mesh.center.z ) + w3.xyz;
+	float3 extent = ( abs( w0.xyz ) * mesh.extent.x ) + ( abs( w1.xyz ) * mesh.extent.y ) + ( abs( w2.xyz ) * mesh.extent.z );
+
+	for( uint eye = 0; eye < EYE_COUNT; ++eye )
+	{
+		bool visible = true;
+		for( uint plane = 0; plane < CULL_MAX_PLANES; ++plane )
+		{
+			float4 p = planes[( eye * CULL_MAX_PLANES ) + plane];
+			float dist = dot( p.xyz, center ) + p.w;
+			float radius = dot( abs( p.xyz ), extent );
+			visible = visible && ( dist + radius >= 0.0f );
+		}
+		if( !visible )
+		{
+			continue;
+		}
+		uint slot;
+		counts.InterlockedAdd( eye * 4, 1, slot );
+		if( slot >= commandCapacity )
+		{
+			continue;
+		}
+
+		float4 vp0 = viewProjRows[( eye * 4 ) + 0];
+		float4 vp1 = viewProjRows[( eye * 4 ) + 1];
+		float4 vp2 = viewProjRows[( eye * 4 ) + 2];
+		float4 vp3 = viewProjRows[( eye * 4 ) + 3];
+		uint address = ( ( eye * commandCapacity ) + slot ) * INDIRECT_COMMAND_SIZE;
+		commands.Store4( address, mesh.vertexBufferView );
+		commands.Store4( address + 16, mesh.indexBufferView );
+		//vertexShaderCB, the mvp rows then the first 11 floats of the normal matrix rows
+		commands.Store4( address + 32, asuint( ( vp0 * w0.x ) + ( vp1 * w0.y ) + ( vp2 * w0.z ) + ( vp3 * w0.w ) ) );
+		commands.Store4( address + 48, asuint( ( vp0 * w1.x ) + ( vp1 * w1.y ) + ( vp2 * w1.z ) + ( vp3 * w1.w ) ) );
+		commands.Store4( address + 64, asuint( ( vp0 * w2.x ) + ( vp1 * w2.y ) + ( vp2 * w2.z ) + ( vp3 * w2.w ) ) );
+		commands.Store4( address + 80, asuint( ( vp0 * w3.x ) + ( vp1 * w3.y ) + ( vp2 * w3.z ) + ( vp3 * w3.w ) ) );
+		commands.Store4( address + 96, asuint( normalRows[( object * 3 ) + 0] ) );
+		commands.Store4( address + 112, asuint( normalRows[( object * 3 ) + 1] ) );
+		commands.Store3( address + 128, asuint( normalRows[( object * 3 ) + 2].xyz ) );
+		//D3D12_DRAW_INDEXED_ARGUMENTS
+		commands.Store4( address + 140, uint4( mesh.indexCount, 1, 0, 0 ) );
+		commands.Store( address + 156, 0 );
+	}
+}
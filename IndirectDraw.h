@@ -0,0 +1,478 @@
+//GPU driven static draws, the static part of the draw list goes up SoA once per frame, a compute pass (IndirectCull.hlsl) culls
+//every draw against both eyes and appends the visible ones' indirect commands to each eye's list through a per eye counter, then
+//each eye draws its list with one ExecuteIndirect that takes the count from that counter, so neither the recording cost nor the
+//command processor's grows with the culled objects. the order of a list is whatever order the threads appended in, the set of
+//commands isn't, IndirectCullEmulate (the kernel on the cpu) is checked against it sorted
+
+#define INDIRECT_CULL_GROUP 64 //numthreads of IndirectCull.hlsl
+#define INDIRECT_CONSTANTS ( ( 4 * 4 ) + ( ( 4 * 2 ) + 3 ) ) //vertexShaderCB as root constants, the same count the root signature has
+#define INDIRECT_SECTION_ALIGNMENT 256 //every section of the per frame upload starts on a constant buffer boundary
+
+//one command in the argument buffer, what the command signature describes (160 bytes)
+typedef struct IndirectCommand
+{
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffer;
+	D3D12_INDEX_BUFFER_VIEW indexBuffer;
+	f32 fConstants[INDIRECT_CONSTANTS];
+	D3D12_DRAW_INDEXED_ARGUMENTS draw;
+} IndirectCommand;
+
+//per MeshId, the kernel copies the views and tests the mesh space box
+typedef struct IndirectMesh
+{
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffer;
+	D3D12_INDEX_BUFFER_VIEW indexBuffer;
+	Vec3f vCenter;
+	u32 dwIndexCount;
+	Vec3f vExtent;
+	u32 dwPad;
+} IndirectMesh;
+
+//cullCB
+typedef struct IndirectCullParams
+{
+	Mat4f mViewProj[ovrEye_Count];
+	Vec4f planes[ovrEye_Count][CULL_MAX_PLANES]; //unused planes are 0,0,0,1
+	u32 dwNumObjects;
+	u32 dwCommandCapacity; //commands per eye
+	u32 dwPad[2];
+} IndirectCullParams;
+
+//byte offsets of each section in one frame's upload buffer
+typedef struct IndirectFrameLayout
+{
+	u64 qwParams;
+	u64 qwWorld;
+	u64 qwNormal;
+	u64 qwMesh;
+	u64 qwMeshTable;
+	u64 qwCounts; //zeros, copied over the count buffer before the cull
+	u64 qwSize;
+} IndirectFrameLayout;
+
+//one frame's upload buffer as the cpu writes it
+typedef struct IndirectFrame
+{
+	IndirectCullParams *pParams;
+	Mat4f *pWorld;
+	Mat3x4f *pNormal;
+	u32 *pMesh;
+	IndirectMesh *pMeshes;
+	u32 *pCounts;
+} IndirectFrame;
+
+inline
+u64 IndirectAlign( u64 qwSize )
+{
+	return ( qwSize + INDIRECT_SECTION_ALIGNMENT - 1 ) & ~(u64)( INDIRECT_SECTION_ALIGNMENT - 1 );
+}
+
+inline
+void InitIndirectFrameLayout( IndirectFrameLayout *a_pLayout, u32 dwCapacity, u32 dwNumMeshes )
+{
+	a_pLayout->qwParams = 0;
+	a_pLayout->qwWorld = IndirectAlign( sizeof( IndirectCullParams ) );
+	a_pLayout->qwNormal = a_pLayout->qwWorld + IndirectAlign( sizeof( Mat4f ) * dwCapacity );
+	a_pLayout->qwMesh = a_pLayout->qwNormal + IndirectAlign( sizeof( Mat3x4f ) * dwCapacity );
+	a_pLayout->qwMeshTable = a_pLayout->qwMesh + IndirectAlign( sizeof( u32 ) * dwCapacity );
+	a_pLayout->qwCounts = a_pLayout->qwMeshTable + IndirectAlign( sizeof( IndirectMesh ) * dwNumMeshes );
+	a_pLayout->qwSize = a_pLayout->qwCounts + IndirectAlign( sizeof( u32 ) * ovrEye_Count );
+}
+
+inline
+void InitIndirectFrame( IndirectFrame *a_pFrame, IndirectFrameLayout *a_pLayout, u8 *a_pBase )
+{
+	a_pFrame->pParams = (IndirectCullParams*)( a_pBase + a_pLayout->qwParams );
+	a_pFrame->pWorld = (Mat4f*)( a_pBase + a_pLayout->qwWorld );
+	a_pFrame->pNormal = (Mat3x4f*)( a_pBase + a_pLayout->qwNormal );
+	a_pFrame->pMesh = (u32*)( a_pBase + a_pLayout->qwMesh );
+	a_pFrame->pMeshes = (IndirectMesh*)( a_pBase + a_pLayout->qwMeshTable );
+	a_pFrame->pCounts = (u32*)( a_pBase + a_pLayout->qwCounts );
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		a_pFrame->pCounts[dwEye] = 0;
+	}
+}
+
+//a command draws the whole mesh, so it has to be a single part one (MeshIndices.h)
+inline
+void SetIndirectMesh( IndirectMesh *a_pMesh, D3D12_VERTEX_BUFFER_VIEW *a_pVertexBuffer, D3D12_INDEX_BUFFER_VIEW *a_pIndexBuffer, u32 dwIndexCount,
+	Vec3f *a_pCenter, Vec3f *a_pExtent )
+{
+	a_pMesh->vertexBuffer = *a_pVertexBuffer;
+	a_pMesh->indexBuffer = *a_pIndexBuffer;
+	a_pMesh->vCenter = *a_pCenter;
+	a_pMesh->dwIndexCount = dwIndexCount;
+	a_pMesh->vExtent = *a_pExtent;
+	a_pMesh->dwPad = 0;
+}
+
+inline
+void SetIndirectEye( IndirectCullParams *a_pParams, u32 dwEye, CullFrustum *a_pFrustum, Mat4f *a_pViewProj )
+{
+	a_pParams->mViewProj[dwEye] = *a_pViewProj;
+	for( u32 dwPlane = 0; dwPlane < CULL_MAX_PLANES; ++dwPlane )
+	{
+		Vec4f vPass = { 0.0f, 0.0f, 0.0f, 1.0f };
+		a_pParams->planes[dwEye][dwPlane] = dwPlane < a_pFrustum->dwNumPlanes ? a_pFrustum->planes[dwPlane] : vPass;
+	}
+}
+
+//the static draws of the list into the frame's upload, 3 copies however many there are
+inline
+void WriteIndirectObjects( IndirectFrame *a_pFrame, SceneDrawList *a_pDraws, u32 dwCommandCapacity )
+{
+	u32 dwNumObjects = a_pDraws->dwNumStatic;
+	memcpy( a_pFrame->pWorld, a_pDraws->pWorld, sizeof( Mat4f ) * dwNumObjects );
+	memcpy( a_pFrame->pNormal, a_pDraws->pNormal, sizeof( Mat3x4f ) * dwNumObjects );
+	memcpy( a_pFrame->pMesh, a_pDraws->pMesh, sizeof( u32 ) * dwNumObjects );
+	a_pFrame->pParams->dwNumObjects = dwNumObjects;
+	a_pFrame->pParams->dwCommandCapacity = dwCommandCapacity;
+}
+
+//IndirectCull.hlsl for the objects [dwBegin, dwEnd), the same math in the same order: TransformCullBox, CullBoxInFrustum
+//against all CULL_MAX_PLANES and Mat4fMult for the mvp. a_pCounts is the count buffer, one append counter per eye, ranges
+//can run on several threads at once like thread groups do
+inline
+void IndirectCullEmulate( IndirectCullParams *a_pParams, Mat4f *a_pWorld, Mat3x4f *a_pNormal, u32 *a_pMesh, IndirectMesh *a_pMeshes,
+	IndirectCommand *a_pCommands, volatile LONG *a_pCounts, u32 dwBegin, u32 dwEnd )
+{
+	CullFrustum eyeFrustums[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		memcpy( eyeFrustums[dwEye].planes, a_pParams->planes[dwEye], sizeof( eyeFrustums[dwEye].planes ) );
+		eyeFrustums[dwEye].dwNumPlanes = CULL_MAX_PLANES;
+	}
+	for( u32 dwObject = dwBegin; dwObject < dwEnd; ++dwObject )
+	{
+		IndirectMesh *pMesh = &a_pMeshes[a_pMesh[dwObject]];
+		Vec3f vCenter, vExtent;
+		TransformCullBox( &pMesh->vCenter, &pMesh->vExtent, &a_pWorld[dwObject], &vCenter, &vExtent );
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			if( !CullBoxInFrustum( &eyeFrustums[dwEye], vCenter.x, vCenter.y, vCenter.z, vExtent.x, vExtent.y, vExtent.z ) )
+			{
+				continue;
+			}
+			u32 dwSlot = (u32)InterlockedIncrement( &a_pCounts[dwEye] ) - 1;
+			if( dwSlot >= a_pParams->dwCommandCapacity )
+			{
+				continue;
+			}
+			IndirectCommand *pCommand = &a_pCommands[( dwEye * a_pParams->dwCommandCapacity ) + dwSlot];
+			pCommand->vertexBuffer = pMesh->vertexBuffer;
+			pCommand->indexBuffer = pMesh->indexBuffer;
+			vertexShaderCB constants;
+			Mat4fMult( &a_pWorld[dwObject], &a_pParams->mViewProj[dwEye], &constants.mvpMat );
+			constants.nMat = a_pNormal[dwObject];
+			memcpy( pCommand->fConstants, &constants, sizeof( pCommand->fConstants ) );
+			pCommand->draw.IndexCountPerInstance = pMesh->dwIndexCount;
+			pCommand->draw.InstanceCount = 1;
+			pCommand->draw.StartIndexLocation = 0;
+			pCommand->draw.BaseVertexLocation = 0;
+			pCommand->draw.StartInstanceLocation = 0;
+		}
+	}
+}
+
+//one eye's commands, up to dwMaxCommands of them, however many the eye's counter says. everything they set (geometry, vertex
+//constants) is forgotten by the backend afterwards
+inline
+void IndirectDrawSubmit( RenderBackend *a_pBackend, RenderResources *a_pResources, ID3D12CommandSignature *a_pCommandSignature,
+	ID3D12Resource *a_pArguments, u64 qwArgumentOffset, ID3D12Resource *a_pCounts, u64 qwCountOffset, u32 dwMaxCommands )
+{
+	if( !dwMaxCommands )
+	{
+		return;
+	}
+	RenderSetRootSignature( a_pBackend, a_pResources, a_pResources->pRootSignatures[RENDER_ROOT_SIGNATURE_STATIC] );
+	RenderSetPipeline( a_pBackend, a_pResources->pPipelines[RENDER_PIPELINE_STATIC] );
+	a_pBackend->pVertexBuffer = nullptr;
+	a_pBackend->pIndexBuffer = nullptr;
+	a_pBackend->dwConstants = RENDER_CONSTANTS_NONE;
+	++a_pBackend->stats.dwNumDraws;
+	++a_pBackend->stats.dwNumApiCalls;
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->ExecuteIndirect( a_pCommandSignature, dwMaxCommands, a_pArguments, qwArgumentOffset, a_pCounts, qwCountOffset );
+	}
+}
+
+#if BENCHMARK_MODE
+typedef struct IndirectEmulateJob
+{
+	IndirectCullParams *pParams;
+	IndirectFrame *pFrame;
+	IndirectCommand *pCommands;
+	volatile LONG *pCounts;
+} IndirectEmulateJob;
+
+void IndirectEmulateRange( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	IndirectEmulateJob *pJob = (IndirectEmulateJob*)pContext;
+	IndirectCullEmulate( pJob->pParams, pJob->pFrame->pWorld, pJob->pFrame->pNormal, pJob->pFrame->pMesh, pJob->pFrame->pMeshes, pJob->pCommands,
+		pJob->pCounts, dwBegin, dwEnd );
+}
+
+int IndirectCompareCommand( const void *a_pA, const void *a_pB )
+{
+	return memcmp( a_pA, a_pB, sizeof( IndirectCommand ) );
+}
+
+//10k static draws over 4 meshes around a pair of eyes: run in one go the emulated kernel appends in object order, so every
+//command and both counts have to match what the cpu path would cull and set. run in reversed thread groups and on workers the
+//lists come out in another order, sorted they have to be byte identical to the first. the per frame cpu cost (the object upload)
+//is timed against the cpu path (cull, sort and record every draw). returns the number of failed checks
+u32 BenchmarkIndirectDraw()
+{
+	const u32 dwNumDraws = 10000;
+	const u32 dwNumMeshes = 4;
+	const u32 dwIterations = 50;
+	SceneDrawList drawList = {};
+	RenderQueue queue = {};
+	CullBoxes boxes = {};
+	IndirectFrameLayout layout;
+	InitIndirectFrameLayout( &layout, dwNumDraws, dwNumMeshes );
+	u8 *pUpload = (u8*)malloc( layout.qwSize );
+	IndirectCommand *pCommands = (IndirectCommand*)malloc( sizeof( IndirectCommand ) * dwNumDraws * ovrEye_Count );
+	IndirectCommand *pReversed = (IndirectCommand*)malloc( sizeof( IndirectCommand ) * dwNumDraws * ovrEye_Count );
+	IndirectCommand *pThreaded = (IndirectCommand*)malloc( sizeof( IndirectCommand ) * dwNumDraws * ovrEye_Count );
+	u8 *pVisible = (u8*)malloc( CullMaskBytes( dwNumDraws ) * ovrEye_Count );
+	bool bAllocated = InitSceneDrawList( &drawList, dwNumDraws );
+	bAllocated = InitRenderQueue( &queue, dwNumDraws ) && bAllocated;
+	bAllocated = InitCullBoxes( &boxes, dwNumDraws ) && bAllocated;
+	if( !bAllocated || !pUpload || !pCommands || !pReversed || !pThreaded || !pVisible )
+	{
+		printf( "Indirect draw: out of memory\n" );
+		free( pVisible );
+		free( pThreaded );
+		free( pReversed );
+		free( pCommands );
+		free( pUpload );
+		DestroyCullBoxes( &boxes );
+		DestroyRenderQueue( &queue );
+		DestroySceneDrawList( &drawList );
+		return 1;
+	}
+	//the commands are compared whole, padding included
+	memset( pCommands, 0, sizeof( IndirectCommand ) * dwNumDraws * ovrEye_Count );
+	memset( pReversed, 0, sizeof( IndirectCommand ) * dwNumDraws * ovrEye_Count );
+	memset( pThreaded, 0, sizeof( IndirectCommand ) * dwNumDraws * ovrEye_Count );
+	IndirectFrame frame;
+	InitIndirectFrame( &frame, &layout, pUpload );
+
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffers[dwNumMeshes];
+	D3D12_INDEX_BUFFER_VIEW indexBuffers[dwNumMeshes];
+	D3D12_VERTEX_BUFFER_VIEW *pVertexBuffers[dwNumMeshes];
+	D3D12_INDEX_BUFFER_VIEW *pIndexBuffers[dwNumMeshes];
+	MeshIndices meshIndices[dwNumMeshes];
+	MeshIndices *pMeshIndices[dwNumMeshes];
+	Vec3f meshCenters[dwNumMeshes];
+	Vec3f meshExtents[dwNumMeshes];
+	for( u32 dwMesh = 0; dwMesh < dwNumMeshes; ++dwMesh )
+	{
+		memset( &vertexBuffers[dwMesh], 0, sizeof( D3D12_VERTEX_BUFFER_VIEW ) );
+		memset( &indexBuffers[dwMesh], 0, sizeof( D3D12_INDEX_BUFFER_VIEW ) );
+		vertexBuffers[dwMesh].BufferLocation = 0x100000 * ( dwMesh + 1 );
+		vertexBuffers[dwMesh].SizeInBytes = 0x1000;
+		vertexBuffers[dwMesh].StrideInBytes = 40;
+		indexBuffers[dwMesh].BufferLocation = 0x800000 + ( 0x100000 * dwMesh );
+		indexBuffers[dwMesh].SizeInBytes = 0x800;
+		pVertexBuffers[dwMesh] = &vertexBuffers[dwMesh];
+		pIndexBuffers[dwMesh] = &indexBuffers[dwMesh];
+		SetMeshIndicesSinglePart( &meshIndices[dwMesh], DXGI_FORMAT_R16_UINT, 36 * ( dwMesh + 1 ) );
+		pMeshIndices[dwMesh] = &meshIndices[dwMesh];
+		Vec3f vCenter = { 0.0f, 0.25f * dwMesh, 0.0f };
+		Vec3f vExtent = { 0.5f, 0.5f + ( 0.25f * dwMesh ), 0.5f };
+		meshCenters[dwMesh] = vCenter;
+		meshExtents[dwMesh] = vExtent;
+		SetIndirectMesh( &frame.pMeshes[dwMesh], &vertexBuffers[dwMesh], &indexBuffers[dwMesh], meshIndices[dwMesh].dwIndexCount, &vCenter, &vExtent );
+	}
+
+	u32 dwSeed = 4242;
+	drawList.dwCount = dwNumDraws;
+	drawList.dwNumStatic = dwNumDraws;
+	for( u32 dwDraw = 0; dwDraw < dwNumDraws; ++dwDraw )
+	{
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		Quatf qRot;
+		Vec3f vAxis = { 0.0f, 1.0f, 0.0f };
+		InitUnitQuatf( &qRot, (f32)( dwSeed & 1023 ) * ( 2.0f * PI_F / 1024.0f ), &vAxis );
+		Vec3f vPos = { (f32)( ( dwSeed >> 8 ) & 127 ) - 64.0f, (f32)( ( dwSeed >> 15 ) & 7 ), (f32)( ( dwSeed >> 18 ) & 127 ) - 64.0f };
+		InitModelMat4ByQuatf( &drawList.pWorld[dwDraw], &qRot, &vPos );
+		InverseTransposeUpper3x3Mat4f( &drawList.pWorld[dwDraw], &drawList.pNormal[dwDraw] );
+		drawList.pMesh[dwDraw] = ( dwSeed >> 26 ) % dwNumMeshes;
+		drawList.pPalette[dwDraw] = ENTITY_NONE;
+		drawList.pLod[dwDraw] = 0;
+	}
+
+	//a rift like pair of eyes looking down -z
+	ovrFovPort eyeFovs[ovrEye_Count];
+	Quatf eyeRots[ovrEye_Count];
+	Vec3f eyePositions[ovrEye_Count];
+	Mat4f eyeViewProjs[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		eyeFovs[dwEye].UpTan = 1.3f;
+		eyeFovs[dwEye].DownTan = 1.3f;
+		eyeFovs[dwEye].LeftTan = dwEye == ovrEye_Left ? 1.4f : 1.1f;
+		eyeFovs[dwEye].RightTan = dwEye == ovrEye_Left ? 1.1f : 1.4f;
+		eyeRots[dwEye].w = 1.0f;
+		eyeRots[dwEye].x = 0.0f;
+		eyeRots[dwEye].y = 0.0f;
+		eyeRots[dwEye].z = 0.0f;
+		eyePositions[dwEye].x = dwEye == ovrEye_Left ? -0.032f : 0.032f;
+		eyePositions[dwEye].y = 1.6f;
+		eyePositions[dwEye].z = 0.0f;
+		Mat4f mView, mProj;
+		InitViewMat4ByQuatf( &mView, &eyeRots[dwEye], &eyePositions[dwEye] );
+		InitEyeProjection( &mProj, eyeFovs[dwEye] );
+		Mat4fMult( &mView, &mProj, &eyeViewProjs[dwEye] );
+	}
+	StereoCullFrustum stereoFrustum;
+	InitStereoCullFrustum( &stereoFrustum, eyeFovs, eyeRots, eyePositions, EYE_NEAR_PLANE );
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		SetIndirectEye( frame.pParams, dwEye, &stereoFrustum.eyes[dwEye], &eyeViewProjs[dwEye] );
+	}
+
+	//the cpu side of a gpu driven frame is just the upload
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	f64 fUploadTicks = 0.0;
+	for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+	{
+		QueryPerformanceCounter( &startCounter );
+		WriteIndirectObjects( &frame, &drawList, dwNumDraws );
+		QueryPerformanceCounter( &endCounter );
+		fUploadTicks += (f64)( endCounter.QuadPart - startCounter.QuadPart );
+	}
+
+	//against what the cpu path does for the same draws every frame, per eye submission through the null backend
+	pixelShaderCB pixelConstants = {};
+	D3D12_VERTEX_BUFFER_VIEW instanceBuffer;
+	RenderResources resources;
+	for( u32 dwPipeline = 0; dwPipeline < RENDER_PIPELINE_COUNT; ++dwPipeline )
+	{
+		resources.pPipelines[dwPipeline] = (ID3D12PipelineState*)&vertexBuffers[dwPipeline];
+	}
+	resources.pRootSignatures[RENDER_ROOT_SIGNATURE_STATIC] = (ID3D12RootSignature*)&indexBuffers[0];
+	resources.pRootSignatures[RENDER_ROOT_SIGNATURE_SKINNED] = (ID3D12RootSignature*)&indexBuffers[1];
+	resources.ppVertexBuffers = pVertexBuffers;
+	resources.ppIndexBuffers = pIndexBuffers;
+	resources.ppMeshIndices = pMeshIndices;
+	resources.pPalettes = nullptr;
+	resources.pInstanceBuffer = &instanceBuffer;
+	resources.pPixelConstants = &pixelConstants;
+	resources.dwDrawDataMode = RENDER_DRAW_DATA_ROOT_CONSTANTS;
+	u8 *pLeftVisible = pVisible;
+	u8 *pRightVisible = pVisible + CullMaskBytes( dwNumDraws );
+	RenderBackend backend;
+	Vec3f vCenterEye = { 0.0f, 1.6f, 0.0f };
+	f64 fCpuPathTicks = 0.0;
+	for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+	{
+		QueryPerformanceCounter( &startCounter );
+		boxes.dwCount = 0;
+		for( u32 dwDraw = 0; dwDraw < dwNumDraws; ++dwDraw )
+		{
+			Vec3f vCenter, vExtent;
+			u32 dwMesh = drawList.pMesh[dwDraw];
+			TransformCullBox( &meshCenters[dwMesh], &meshExtents[dwMesh], &drawList.pWorld[dwDraw], &vCenter, &vExtent );
+			AddCullBox( &boxes, &vCenter, &vExtent );
+		}
+		StereoCullBoxes( &stereoFrustum, &boxes, pLeftVisible, pRightVisible );
+		BuildSceneRenderQueue( &queue, &drawList, pLeftVisible, pRightVisible, nullptr, &vCenterEye, 0 );
+		RenderQueueSort( &queue );
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			RenderBackendBegin( &backend, nullptr, nullptr );
+			RenderQueueSubmit( &queue, &backend, &resources, &drawList, &eyeViewProjs[dwEye], dwEye == ovrEye_Left ? pLeftVisible : pRightVisible, 0, queue.dwCount );
+		}
+		QueryPerformanceCounter( &endCounter );
+		fCpuPathTicks += (f64)( endCounter.QuadPart - startCounter.QuadPart );
+	}
+
+	//the emulated kernel, in one go, one thread group at a time from the last and split over workers
+	volatile LONG counts[ovrEye_Count] = { 0, 0 };
+	volatile LONG reversedCounts[ovrEye_Count] = { 0, 0 };
+	volatile LONG threadedCounts[ovrEye_Count] = { 0, 0 };
+	IndirectEmulateJob job = { frame.pParams, &frame, pCommands, counts };
+	QueryPerformanceCounter( &startCounter );
+	IndirectEmulateRange( &job, 0, dwNumDraws );
+	QueryPerformanceCounter( &endCounter );
+	f64 fEmulateTicks = (f64)( endCounter.QuadPart - startCounter.QuadPart );
+	job.pCommands = pReversed;
+	job.pCounts = reversedCounts;
+	for( u32 dwGroup = ( dwNumDraws + INDIRECT_CULL_GROUP - 1 ) / INDIRECT_CULL_GROUP; dwGroup-- > 0; )
+	{
+		u32 dwEnd = ( dwGroup + 1 ) * INDIRECT_CULL_GROUP;
+		IndirectEmulateRange( &job, dwGroup * INDIRECT_CULL_GROUP, dwEnd < dwNumDraws ? dwEnd : dwNumDraws );
+	}
+	WorkerPool pool;
+	InitWorkerPool( &pool, 3 );
+	job.pCommands = pThreaded;
+	job.pCounts = threadedCounts;
+	ParallelFor( &pool, dwNumDraws, INDIRECT_CULL_GROUP * 4, IndirectEmulateRange, &job );
+	DestroyWorkerPool( &pool );
+
+	//every command against the cpu path's culling and constants, the combined frustum is only a conservative early out so the
+	//per eye answer is what CullBoxInFrustum gives for that eye alone. in one go the visible draws append in object order
+	u32 dwFailures = 0;
+	u32 dwNumVisible[ovrEye_Count] = { 0, 0 };
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		for( u32 dwDraw = 0; dwDraw < dwNumDraws; ++dwDraw )
+		{
+			u32 dwMesh = drawList.pMesh[dwDraw];
+			Vec3f vCenter, vExtent;
+			TransformCullBox( &meshCenters[dwMesh], &meshExtents[dwMesh], &drawList.pWorld[dwDraw], &vCenter, &vExtent );
+			if( !CullBoxInFrustum( &stereoFrustum.eyes[dwEye], vCenter.x, vCenter.y, vCenter.z, vExtent.x, vExtent.y, vExtent.z ) )
+			{
+				continue;
+			}
+			if( dwNumVisible[dwEye] >= (u32)counts[dwEye] )
+			{
+				++dwFailures;
+				break;
+			}
+			IndirectCommand *pCommand = &pCommands[( dwEye * dwNumDraws ) + dwNumVisible[dwEye]++];
+			vertexShaderCB constants;
+			Mat4fMult( &drawList.pWorld[dwDraw], &eyeViewProjs[dwEye], &constants.mvpMat );
+			constants.nMat = drawList.pNormal[dwDraw];
+			dwFailures += pCommand->draw.InstanceCount == 1 ? 0 : 1;
+			dwFailures += pCommand->draw.IndexCountPerInstance == meshIndices[dwMesh].dwIndexCount ? 0 : 1;
+			dwFailures += memcmp( pCommand->fConstants, &constants, sizeof( pCommand->fConstants ) ) == 0 ? 0 : 1;
+			dwFailures += pCommand->vertexBuffer.BufferLocation == vertexBuffers[dwMesh].BufferLocation && pCommand->indexBuffer.BufferLocation == indexBuffers[dwMesh].BufferLocation ? 0 : 1;
+		}
+		dwFailures += dwNumVisible[dwEye] == (u32)counts[dwEye] ? 0 : 1;
+
+		//the other two appended in their own order, sorted they are the same commands
+		dwFailures += reversedCounts[dwEye] == counts[dwEye] && threadedCounts[dwEye] == counts[dwEye] ? 0 : 1;
+		IndirectCommand *pEyeCommands = &pCommands[dwEye * dwNumDraws];
+		IndirectCommand *pEyeReversed = &pReversed[dwEye * dwNumDraws];
+		IndirectCommand *pEyeThreaded = &pThreaded[dwEye * dwNumDraws];
+		qsort( pEyeCommands, dwNumVisible[dwEye], sizeof( IndirectCommand ), IndirectCompareCommand );
+		qsort( pEyeReversed, dwNumVisible[dwEye], sizeof( IndirectCommand ), IndirectCompareCommand );
+		qsort( pEyeThreaded, dwNumVisible[dwEye], sizeof( IndirectCommand ), IndirectCompareCommand );
+		dwFailures += memcmp( pEyeCommands, pEyeReversed, sizeof( IndirectCommand ) * dwNumVisible[dwEye] ) == 0 ? 0 : 1;
+		dwFailures += memcmp( pEyeCommands, pEyeThreaded, sizeof( IndirectCommand ) * dwNumVisible[dwEye] ) == 0 ? 0 : 1;
+	}
+	//and the visible counts with the masks the cpu cull made
+	dwFailures += dwNumVisible[ovrEye_Left] == CullCountVisible( pLeftVisible, dwNumDraws ) && dwNumVisible[ovrEye_Right] == CullCountVisible( pRightVisible, dwNumDraws ) ? 0 : 1;
+
+	f64 fNsPerTick = 1000000000.0 / (f64)PerfCountFrequency.QuadPart;
+	printf( "Indirect draw: %u static draws, %u/%u visible, cpu per frame: upload %.1fns/draw vs cpu path %.1fns/draw, emulated kernel %.1fns/draw, "
+		"%u failures\n", dwNumDraws, dwNumVisible[ovrEye_Left], dwNumVisible[ovrEye_Right], ( fUploadTicks * fNsPerTick ) / ( (f64)dwIterations * dwNumDraws ),
+		( fCpuPathTicks * fNsPerTick ) / ( (f64)dwIterations * dwNumDraws ), ( fEmulateTicks * fNsPerTick ) / (f64)dwNumDraws, dwFailures );
+	free( pVisible );
+	free( pThreaded );
+	free( pReversed );
+	free( pCommands );
+	free( pUpload );
+	DestroyCullBoxes( &boxes );
+	DestroyRenderQueue( &queue );
+	DestroySceneDrawList( &drawList );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,238 @@
+//Trigger prediction, ovr_GetInputState only gives us the trigger values as of now but the hand poses are
+//predicted out to the display time, so the fingers lag the hands unless we predict the triggers out too
+//https://gery.casiez.net/1euro/
+
+#define INPUT_HISTORY_SIZE 16 //needs to be a power of 2
+#define INPUT_MAX_PREDICTION 0.05 //seconds, don't extrapolate further than this no matter what the compositor says
+
+//one euro filter tuning, values are in trigger units (0 to 1) per second
+#define INPUT_MIN_CUTOFF 10.0f
+#define INPUT_BETA 5.0f
+#define INPUT_VELOCITY_WINDOW 0.025 //seconds of history the velocity is fit over, 3 polls at 90hz
+
+typedef struct TriggerSample
+{
+	f64 fTime;
+	f32 fValue;
+} TriggerSample;
+
+typedef struct TriggerPredictor
+{
+	TriggerSample samples[INPUT_HISTORY_SIZE]; //ring buffer of raw samples
+	u32 dwHead;
+	u32 dwCount;
+	f32 fFiltered;
+	f32 fVelocity; //least squares slope over the last INPUT_VELOCITY_WINDOW of samples
+} TriggerPredictor;
+
+TriggerPredictor indexTriggerPredictors[ovrHand_Count];
+TriggerPredictor handTriggerPredictors[ovrHand_Count];
+
+inline
+f32 OneEuroAlpha( f32 fCutoff, f32 fDeltaTime )
+{
+	f32 fTau = 1.0f / ( 2.0f * PI_F * fCutoff );
+	return 1.0f / ( 1.0f + ( fTau / fDeltaTime ) );
+}
+
+inline
+void InitTriggerPredictor( TriggerPredictor *a_pPredictor )
+{
+	a_pPredictor->dwHead = 0;
+	a_pPredictor->dwCount = 0;
+	a_pPredictor->fFiltered = 0.0f;
+	a_pPredictor->fVelocity = 0.0f;
+}
+
+//least squares line through the samples no older than INPUT_VELOCITY_WINDOW from the newest, returns its slope
+//a fit over a few polls is steadier than the difference of the last two samples
+inline
+f32 TriggerPredictorFitVelocity( TriggerPredictor *a_pPredictor )
+{
+	TriggerSample *pNewest = &a_pPredictor->samples[( a_pPredictor->dwHead - 1 ) & ( INPUT_HISTORY_SIZE - 1 )];
+	//times relative to the newest sample, absolute ovr times are too big to square in anything but f64 anyway
+	f64 fSumT = 0.0, fSumV = 0.0, fSumTT = 0.0, fSumTV = 0.0;
+	u32 dwNumFit = 0;
+	for( u32 dwAge = 0; dwAge < a_pPredictor->dwCount; ++dwAge )
+	{
+		TriggerSample *pSample = &a_pPredictor->samples[( a_pPredictor->dwHead - 1 - dwAge ) & ( INPUT_HISTORY_SIZE - 1 )];
+		f64 fT = pSample->fTime - pNewest->fTime;
+		if( fT < -INPUT_VELOCITY_WINDOW )
+		{
+			break;
+		}
+		fSumT += fT;
+		fSumV += pSample->fValue;
+		fSumTT += fT * fT;
+		fSumTV += fT * pSample->fValue;
+		++dwNumFit;
+	}
+	f64 fDenom = ( dwNumFit * fSumTT ) - ( fSumT * fSumT );
+	if( dwNumFit < 2 || fDenom <= 0.0 )
+	{
+		return 0.0f;
+	}
+	return (f32)( ( ( dwNumFit * fSumTV ) - ( fSumT * fSumV ) ) / fDenom );
+}
+
+inline
+void TriggerPredictorAddSample( TriggerPredictor *a_pPredictor, f64 fTime, f32 fValue )
+{
+	f32 fDeltaTime = 0.0f;
+	if( a_pPredictor->dwCount > 0 )
+	{
+		TriggerSample *pLast = &a_pPredictor->samples[( a_pPredictor->dwHead - 1 ) & ( INPUT_HISTORY_SIZE - 1 )];
+		if( fTime <= pLast->fTime )
+		{
+			return; //same poll as last frame (or time went backwards), nothing new to learn
+		}
+		fDeltaTime = (f32)( fTime - pLast->fTime );
+	}
+	a_pPredictor->samples[a_pPredictor->dwHead].fTime = fTime;
+	a_pPredictor->samples[a_pPredictor->dwHead].fValue = fValue;
+	a_pPredictor->dwHead = ( a_pPredictor->dwHead + 1 ) & ( INPUT_HISTORY_SIZE - 1 );
+	if( a_pPredictor->dwCount < INPUT_HISTORY_SIZE )
+	{
+		++a_pPredictor->dwCount;
+	}
+
+	//the fitted velocity stands in for the one euro filter's low passed derivative, it drives the cutoff and the extrapolation
+	a_pPredictor->fVelocity = TriggerPredictorFitVelocity( a_pPredictor );
+	if( a_pPredictor->dwCount > 1 )
+	{
+		f32 fCutoff = INPUT_MIN_CUTOFF + ( INPUT_BETA * fabsf( a_pPredictor->fVelocity ) );
+		f32 fAlpha = OneEuroAlpha( fCutoff, fDeltaTime );
+		a_pPredictor->fFiltered += fAlpha * ( fValue - a_pPredictor->fFiltered );
+	}
+	else
+	{
+		a_pPredictor->fFiltered = fValue;
+	}
+}
+
+//extrapolate the filtered value out to fDisplayTime (ovr_GetPredictedDisplayTime)
+inline
+f32 TriggerPredict( TriggerPredictor *a_pPredictor, f64 fDisplayTime )
+{
+	if( a_pPredictor->dwCount == 0 )
+	{
+		return 0.0f;
+	}
+	TriggerSample *pLast = &a_pPredictor->samples[( a_pPredictor->dwHead - 1 ) & ( INPUT_HISTORY_SIZE - 1 )];
+	f64 fLead = fDisplayTime - pLast->fTime;
+	fLead = fLead < 0.0 ? 0.0 : ( fLead > INPUT_MAX_PREDICTION ? INPUT_MAX_PREDICTION : fLead );
+	f32 fPredicted = a_pPredictor->fFiltered + ( a_pPredictor->fVelocity * (f32)fLead );
+	//triggers rest at exactly 0 and bottom out at exactly 1, the animation code relies on hitting the ends
+	return clamp( fPredicted, 0.0f, 1.0f );
+}
+
+inline
+void InitInputPrediction()
+{
+	for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
+	{
+		InitTriggerPredictor( &indexTriggerPredictors[dwHand] );
+		InitTriggerPredictor( &handTriggerPredictors[dwHand] );
+	}
+}
+
+//linearly interpolated value of a recording at fTime
+inline
+f32 TriggerRecordingValueAt( TriggerSample *a_pSamples, u32 dwNumSamples, f64 fTime )
+{
+	if( fTime <= a_pSamples[0].fTime )
+	{
+		return a_pSamples[0].fValue;
+	}
+	for( u32 dwSample = 1; dwSample < dwNumSamples; ++dwSample )
+	{
+		if( fTime <= a_pSamples[dwSample].fTime )
+		{
+			f32 fT = (f32)( ( fTime - a_pSamples[dwSample-1].fTime ) / ( a_pSamples[dwSample].fTime - a_pSamples[dwSample-1].fTime ) );
+			return a_pSamples[dwSample-1].fValue + ( fT * ( a_pSamples[dwSample].fValue - a_pSamples[dwSample-1].fValue ) );
+		}
+	}
+	return a_pSamples[dwNumSamples-1].fValue;
+}
+
+//replays a recording through the predictor as if every sample was displayed fLeadTime seconds later,
+//returns the mean absolute error of the prediction vs the recording at display time, a_pRawError gets the error of using the raw sample (what we did before)
+inline
+f32 TriggerPredictorReplay( TriggerSample *a_pSamples, u32 dwNumSamples, f64 fLeadTime, f32 *a_pRawError )
+{
+	TriggerPredictor predictor;
+	InitTriggerPredictor( &predictor );
+	f64 fPredictedError = 0.0;
+	f64 fRawError = 0.0;
+	u32 dwScored = 0;
+	for( u32 dwSample = 0; dwSample < dwNumSamples; ++dwSample )
+	{
+		TriggerPredictorAddSample( &predictor, a_pSamples[dwSample].fTime, a_pSamples[dwSample].fValue );
+		f64 fDisplayTime = a_pSamples[dwSample].fTime + fLeadTime;
+		if( fDisplayTime > a_pSamples[dwNumSamples-1].fTime )
+		{
+			break;
+		}
+		f32 fActual = TriggerRecordingValueAt( a_pSamples, dwNumSamples, fDisplayTime );
+		fPredictedError += fabsf( TriggerPredict( &predictor, fDisplayTime ) - fActual );
+		fRawError += fabsf( a_pSamples[dwSample].fValue - fActual );
+		++dwScored;
+	}
+	if( dwScored == 0 )
+	{
+		*a_pRawError = 0.0f;
+		return 0.0f;
+	}
+	*a_pRawError = (f32)( fRawError / dwScored );
+	return (f32)( fPredictedError / dwScored );
+}
+
+#if BENCHMARK_MODE
+u32 BenchmarkInputPrediction()
+{
+	//recording of a squeeze, a hold, and a release polled at 90hz (eased in and out like a real finger pull)
+	//replayed clean and quantized to 8 bits like the trigger's adc
+	const u32 dwNumSamples = 270;
+	TriggerSample recording[2][dwNumSamples];
+	for( u32 dwSample = 0; dwSample < dwNumSamples; ++dwSample )
+	{
+		f64 fTime = dwSample / 90.0;
+		f32 fValue;
+		if( fTime < 0.5 )       fValue = 0.0f;
+		else if( fTime < 0.75 ) fValue = 0.5f - ( 0.5f * cosf( (f32)( ( fTime - 0.5 ) / 0.25 ) * PI_F ) );
+		else if( fTime < 1.75 ) fValue = 1.0f;
+		else if( fTime < 2.0 )  fValue = 0.5f + ( 0.5f * cosf( (f32)( ( fTime - 1.75 ) / 0.25 ) * PI_F ) );
+		else                    fValue = 0.0f;
+		recording[0][dwSample].fTime = fTime;
+		recording[0][dwSample].fValue = fValue;
+		recording[1][dwSample].fTime = fTime;
+		recording[1][dwSample].fValue = floorf( ( fValue * 255.0f ) + 0.5f ) / 255.0f;
+	}
+
+	const char *szRecordings[] = { "clean", "8 bit" };
+	f64 fLeadTimes[] = { 0.011, 0.022, 0.033 };
+	u32 dwFailures = 0;
+	for( u32 dwRecording = 0; dwRecording < _countof( szRecordings ); ++dwRecording )
+	{
+		for( u32 dwLead = 0; dwLead < _countof( fLeadTimes ); ++dwLead )
+		{
+			f32 fRawError;
+			f32 fPredictedError = TriggerPredictorReplay( recording[dwRecording], dwNumSamples, fLeadTimes[dwLead], &fRawError );
+			//predicting has to beat showing the stale sample or it isn't worth doing
+			dwFailures += fPredictedError < fRawError ? 0 : 1;
+			printf( "Trigger prediction %s %.0fms ahead: raw error %f predicted error %f (%.1f%% less)\n", szRecordings[dwRecording], fLeadTimes[dwLead] * 1000.0, fRawError, fPredictedError, fRawError > 0.0f ? 100.0f * ( 1.0f - ( fPredictedError / fRawError ) ) : 0.0f );
+		}
+	}
+
+	//a ramp at a constant rate has to come back with exactly that rate once the window is full of it
+	TriggerPredictor predictor;
+	InitTriggerPredictor( &predictor );
+	for( u32 dwSample = 0; dwSample < INPUT_HISTORY_SIZE; ++dwSample )
+	{
+		TriggerPredictorAddSample( &predictor, 1000.0 + ( dwSample / 90.0 ), 0.1f + ( 2.0f * ( dwSample / 90.0f ) ) );
+	}
+	dwFailures += fabsf( predictor.fVelocity - 2.0f ) < 0.001f ? 0 : 1;
+	printf( "Trigger prediction: ramp velocity %f (2 expected), %u failures\n", predictor.fVelocity, dwFailures );
+	return dwFailures;
+}
+#endif
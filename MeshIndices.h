@@ -0,0 +1,264 @@
+//Mesh indices, the models are authored with 32 bit indices and packed at upload to the smallest format that reaches every vertex.
+//a mesh under MESH_INDEX_16_SPAN vertices goes to R16_UINT as is, a bigger one is cut into parts along its triangle order, each
+//part's indices relative to the lowest vertex it uses and drawn with that as its base vertex, so it stays 16 bit as well.
+//only a mesh with a single triangle too wide for 16 bits, or needing more than MESH_MAX_PARTS parts, stays R32_UINT.
+//a mesh with a LOD chain (MeshLod.h) gets one MeshIndices per level over the same index buffer, parts index it from its start
+
+#define MESH_INDEX_16_SPAN 0xFFFF //vertices a 16 bit part can reach, 0xFFFF itself is left out as it is the strip cut value
+#define MESH_MAX_PARTS 16
+#define MESH_INDEX_ALIGNMENT 4 //each mesh's packed indices get padded to it so the next vertex buffer stays aligned
+
+//one DrawIndexedInstanced
+typedef struct MeshPart
+{
+	u32 dwFirstIndex;
+	u32 dwIndexCount;
+	s32 iBaseVertex;
+} MeshPart;
+
+typedef struct MeshIndices
+{
+	DXGI_FORMAT format; //DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+	u32 dwIndexSize; //bytes per packed index
+	u32 dwIndexCount; //all parts together
+	u32 dwNumParts;
+	MeshPart parts[MESH_MAX_PARTS];
+} MeshIndices;
+
+inline
+void SetMeshIndicesSinglePart( MeshIndices *a_pMesh, DXGI_FORMAT format, u32 dwIndexCount )
+{
+	a_pMesh->format = format;
+	a_pMesh->dwIndexSize = format == DXGI_FORMAT_R16_UINT ? sizeof( u16 ) : sizeof( u32 );
+	a_pMesh->dwIndexCount = dwIndexCount;
+	a_pMesh->dwNumParts = 1;
+	a_pMesh->parts[0].dwFirstIndex = 0;
+	a_pMesh->parts[0].dwIndexCount = dwIndexCount;
+	a_pMesh->parts[0].iBaseVertex = 0;
+}
+
+//picks the format and, past 16 bits, the parts of the dwIndexCount indices from dwFirstIndex on. a_pIndices is only read when the mesh
+//has to be cut
+inline
+void BuildMeshIndices( MeshIndices *a_pMesh, const u32 *a_pIndices, u32 dwFirstIndex, u32 dwIndexCount, u32 dwVertexCount )
+{
+	if( dwVertexCount <= MESH_INDEX_16_SPAN || dwIndexCount % 3 != 0 )
+	{
+		SetMeshIndicesSinglePart( a_pMesh, dwVertexCount <= MESH_INDEX_16_SPAN ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, dwIndexCount );
+		a_pMesh->parts[0].dwFirstIndex = dwFirstIndex;
+		return;
+	}
+
+	//greedy over the triangles, a part grows until the next triangle would stretch its vertex range past 16 bits
+	u32 dwNumParts = 0;
+	u32 dwPartStart = dwFirstIndex;
+	u32 dwMin = 0xFFFFFFFF;
+	u32 dwMax = 0;
+	for( u32 dwIdx = dwFirstIndex; dwIdx < dwFirstIndex + dwIndexCount; dwIdx += 3 )
+	{
+		u32 dwTriMin = a_pIndices[dwIdx];
+		u32 dwTriMax = a_pIndices[dwIdx];
+		for( u32 dwCorner = 1; dwCorner < 3; ++dwCorner )
+		{
+			u32 dwIndex = a_pIndices[dwIdx + dwCorner];
+			dwTriMin = dwIndex < dwTriMin ? dwIndex : dwTriMin;
+			dwTriMax = dwIndex > dwTriMax ? dwIndex : dwTriMax;
+		}
+		if( dwTriMax - dwTriMin >= MESH_INDEX_16_SPAN )
+		{
+			dwNumParts = MESH_MAX_PARTS + 1;
+			break;
+		}
+		u32 dwNewMin = dwTriMin < dwMin ? dwTriMin : dwMin;
+		u32 dwNewMax = dwTriMax > dwMax ? dwTriMax : dwMax;
+		if( dwNewMax - dwNewMin >= MESH_INDEX_16_SPAN )
+		{
+			if( dwNumParts == MESH_MAX_PARTS )
+			{
+				break;
+			}
+			a_pMesh->parts[dwNumParts].dwFirstIndex = dwPartStart;
+			a_pMesh->parts[dwNumParts].dwIndexCount = dwIdx - dwPartStart;
+			a_pMesh->parts[dwNumParts].iBaseVertex = (s32)dwMin;
+			++dwNumParts;
+			dwPartStart = dwIdx;
+			dwNewMin = dwTriMin;
+			dwNewMax = dwTriMax;
+		}
+		dwMin = dwNewMin;
+		dwMax = dwNewMax;
+	}
+	if( dwNumParts >= MESH_MAX_PARTS )
+	{
+#if MAIN_DEBUG
+		printf( "BuildMeshIndices: %u vertices don't fit %u 16 bit parts, keeping 32 bit indices\n", dwVertexCount, MESH_MAX_PARTS );
+#endif
+		SetMeshIndicesSinglePart( a_pMesh, DXGI_FORMAT_R32_UINT, dwIndexCount );
+		a_pMesh->parts[0].dwFirstIndex = dwFirstIndex;
+		return;
+	}
+	a_pMesh->parts[dwNumParts].dwFirstIndex = dwPartStart;
+	a_pMesh->parts[dwNumParts].dwIndexCount = dwFirstIndex + dwIndexCount - dwPartStart;
+	a_pMesh->parts[dwNumParts].iBaseVertex = dwIndexCount > 0 ? (s32)dwMin : 0;
+	a_pMesh->format = DXGI_FORMAT_R16_UINT;
+	a_pMesh->dwIndexSize = sizeof( u16 );
+	a_pMesh->dwIndexCount = dwIndexCount;
+	a_pMesh->dwNumParts = dwNumParts + 1;
+}
+
+//one MeshIndices per level of a LOD chain, back to back in a_pIndices. the levels share an index buffer so they have to share a format,
+//if one of them can't be 16 bit none of them are
+inline
+void BuildMeshLodIndices( MeshIndices *a_pLevels, const MeshLodLevel *a_pLodLevels, u32 dwNumLevels, const u32 *a_pIndices, u32 dwVertexCount )
+{
+	bool bWide = false;
+	for( u32 dwLevel = 0; dwLevel < dwNumLevels; ++dwLevel )
+	{
+		BuildMeshIndices( &a_pLevels[dwLevel], a_pIndices, a_pLodLevels[dwLevel].dwFirstIndex, a_pLodLevels[dwLevel].dwIndexCount, dwVertexCount );
+		bWide |= a_pLevels[dwLevel].format == DXGI_FORMAT_R32_UINT;
+	}
+	for( u32 dwLevel = 0; bWide && dwLevel < dwNumLevels; ++dwLevel )
+	{
+		SetMeshIndicesSinglePart( &a_pLevels[dwLevel], DXGI_FORMAT_R32_UINT, a_pLodLevels[dwLevel].dwIndexCount );
+		a_pLevels[dwLevel].parts[0].dwFirstIndex = a_pLodLevels[dwLevel].dwFirstIndex;
+	}
+}
+
+//indices in the index buffer of dwNumLevels levels, which are back to back from index 0
+inline
+u32 MeshIndicesCount( MeshIndices *a_pLevels, u32 dwNumLevels )
+{
+	MeshPart *pLast = &a_pLevels[dwNumLevels - 1].parts[a_pLevels[dwNumLevels - 1].dwNumParts - 1];
+	return pLast->dwFirstIndex + pLast->dwIndexCount;
+}
+
+//bytes WriteMeshIndices writes, padding included
+inline
+u32 MeshIndicesSize( MeshIndices *a_pLevels, u32 dwNumLevels )
+{
+	u32 dwSize = MeshIndicesCount( a_pLevels, dwNumLevels ) * a_pLevels[0].dwIndexSize;
+	return ( dwSize + MESH_INDEX_ALIGNMENT - 1 ) & ~(u32)( MESH_INDEX_ALIGNMENT - 1 );
+}
+
+//a mesh without a LOD chain is a single level
+inline
+void WriteMeshIndices( MeshIndices *a_pLevels, u32 dwNumLevels, const u32 *a_pIndices, u8 *a_pOut )
+{
+	u32 dwIndexCount = MeshIndicesCount( a_pLevels, dwNumLevels );
+	u32 dwIndexSize = a_pLevels[0].dwIndexSize;
+	if( a_pLevels[0].format == DXGI_FORMAT_R32_UINT )
+	{
+		memcpy( a_pOut, a_pIndices, dwIndexCount * sizeof( u32 ) );
+	}
+	else
+	{
+		u16 *pOut = (u16*)a_pOut;
+		for( u32 dwLevel = 0; dwLevel < dwNumLevels; ++dwLevel )
+		{
+			for( u32 dwPart = 0; dwPart < a_pLevels[dwLevel].dwNumParts; ++dwPart )
+			{
+				MeshPart *pPart = &a_pLevels[dwLevel].parts[dwPart];
+				u32 dwBase = (u32)pPart->iBaseVertex;
+				for( u32 dwIdx = pPart->dwFirstIndex; dwIdx < pPart->dwFirstIndex + pPart->dwIndexCount; ++dwIdx )
+				{
+					pOut[dwIdx] = (u16)( a_pIndices[dwIdx] - dwBase );
+				}
+			}
+		}
+	}
+	memset( a_pOut + ( dwIndexCount * dwIndexSize ), 0, MeshIndicesSize( a_pLevels, dwNumLevels ) - ( dwIndexCount * dwIndexSize ) );
+}
+
+#if BENCHMARK_MODE
+//a 600x600 vertex grid (360k vertices) has to be cut into parts, every triangle has to come back to the same vertices through its part's
+//base vertex and no packed index may be the strip cut value. the real models have to go to 16 bit in one part
+u32 BenchmarkMeshIndices()
+{
+	const u32 dwGridSize = 600;
+	const u32 dwNumVertices = dwGridSize * dwGridSize;
+	const u32 dwNumIndices = ( dwGridSize - 1 ) * ( dwGridSize - 1 ) * 6;
+	const u32 dwIterations = 20;
+	u32 *pIndices = (u32*)malloc( 2 * sizeof( u32 ) * dwNumIndices ); //packed room for 32 bit too, a grid that didn't get cut is copied as is
+	if( !pIndices )
+	{
+		printf( "Mesh indices: out of memory\n" );
+		return 1;
+	}
+	u8 *pPacked = (u8*)( pIndices + dwNumIndices );
+	u32 dwIdx = 0;
+	for( u32 dwRow = 0; dwRow + 1 < dwGridSize; ++dwRow )
+	{
+		for( u32 dwColumn = 0; dwColumn + 1 < dwGridSize; ++dwColumn )
+		{
+			u32 dwCorner = ( dwRow * dwGridSize ) + dwColumn;
+			pIndices[dwIdx++] = dwCorner;
+			pIndices[dwIdx++] = dwCorner + dwGridSize;
+			pIndices[dwIdx++] = dwCorner + 1;
+			pIndices[dwIdx++] = dwCorner + 1;
+			pIndices[dwIdx++] = dwCorner + dwGridSize;
+			pIndices[dwIdx++] = dwCorner + dwGridSize + 1;
+		}
+	}
+
+	MeshIndices mesh;
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwIteration = 0; dwIteration < dwIterations; ++dwIteration )
+	{
+		BuildMeshIndices( &mesh, pIndices, 0, dwNumIndices, dwNumVertices );
+		WriteMeshIndices( &mesh, 1, pIndices, pPacked );
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fUs = ( 1000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwIterations );
+
+	u32 dwFailures = mesh.format == DXGI_FORMAT_R16_UINT && mesh.dwIndexSize == sizeof( u16 ) && mesh.dwIndexCount == dwNumIndices ? 0 : 1;
+	u16 *pPacked16 = (u16*)pPacked;
+	u32 dwCovered = 0;
+	for( u32 dwPart = 0; dwPart < mesh.dwNumParts; ++dwPart )
+	{
+		MeshPart *pPart = &mesh.parts[dwPart];
+		dwFailures += pPart->dwFirstIndex == dwCovered && pPart->dwIndexCount % 3 == 0 && pPart->iBaseVertex >= 0 ? 0 : 1;
+		for( u32 dwPartIdx = pPart->dwFirstIndex; dwPartIdx < pPart->dwFirstIndex + pPart->dwIndexCount; ++dwPartIdx )
+		{
+			dwFailures += pPacked16[dwPartIdx] != 0xFFFF && (u32)pPart->iBaseVertex + pPacked16[dwPartIdx] == pIndices[dwPartIdx] ? 0 : 1;
+		}
+		dwCovered += pPart->dwIndexCount;
+	}
+	dwFailures += dwCovered == dwNumIndices ? 0 : 1;
+
+	//one triangle wider than 16 bits can't be cut, the whole mesh stays 32 bit
+	u32 dwWide = pIndices[1];
+	pIndices[1] = dwNumVertices - 1;
+	MeshIndices wideMesh;
+	BuildMeshIndices( &wideMesh, pIndices, 0, dwNumIndices, dwNumVertices );
+	dwFailures += wideMesh.format == DXGI_FORMAT_R32_UINT && wideMesh.dwNumParts == 1 && wideMesh.parts[0].dwIndexCount == dwNumIndices ? 0 : 1;
+	pIndices[1] = dwWide;
+
+	//plane, cube and hand, all far under 16 bits
+	const u32 *pModelIndices[3] = { planeIndices, cubeIndicies, handIndices };
+	const u32 dwModelIndexCounts[3] = { planeIndexCount, cubeIndexCount, handIndexCount };
+	const u32 dwModelVertexCounts[3] = { sizeof( planeVertices ) / ( 10 * sizeof( f32 ) ), sizeof( cubeVertices ) / ( 10 * sizeof( f32 ) ), sizeof( handVertices ) / ( 18 * sizeof( u32 ) ) };
+	u32 dwModelBytes32 = 0;
+	u32 dwModelBytes16 = 0;
+	for( u32 dwModel = 0; dwModel < 3; ++dwModel )
+	{
+		MeshIndices modelMesh;
+		BuildMeshIndices( &modelMesh, pModelIndices[dwModel], 0, dwModelIndexCounts[dwModel], dwModelVertexCounts[dwModel] );
+		WriteMeshIndices( &modelMesh, 1, pModelIndices[dwModel], pPacked );
+		dwFailures += modelMesh.format == DXGI_FORMAT_R16_UINT && modelMesh.dwNumParts == 1 ? 0 : 1;
+		for( u32 dwModelIdx = 0; dwModelIdx < dwModelIndexCounts[dwModel]; ++dwModelIdx )
+		{
+			dwFailures += pModelIndices[dwModel][dwModelIdx] < dwModelVertexCounts[dwModel] && pPacked16[dwModelIdx] == pModelIndices[dwModel][dwModelIdx] ? 0 : 1;
+		}
+		dwModelBytes32 += dwModelIndexCounts[dwModel] * sizeof( u32 );
+		dwModelBytes16 += MeshIndicesSize( &modelMesh, 1 );
+	}
+
+	printf( "Mesh indices grid: %u vertices, %u parts, %u -> %u bytes, build+write %.1fus\n", dwNumVertices, mesh.dwNumParts,
+		dwNumIndices * (u32)sizeof( u32 ), MeshIndicesSize( &mesh, 1 ), fUs );
+	printf( "Mesh indices models: %u -> %u bytes, %u failures\n", dwModelBytes32, dwModelBytes16, dwFailures );
+	free( pIndices );
+	return dwFailures;
+}
+#endif
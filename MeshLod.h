@@ -0,0 +1,639 @@
+//Mesh LOD, MeshSimplify.cpp runs MeshLodSimplify offline and writes each mesh's chain to modelLods.h: every level is an index list over
+//the same vertices, back to back in one index buffer, so a coarser level only changes what range gets drawn and skins fewer vertices.
+//the simplifier collapses edges onto one of their vertices by quadric error (Garland and Heckbert, one plane per face plus planes along
+//the open edges so the outline holds), a collapse between differently skinned vertices costs extra so bone boundaries stay put.
+//vertices that share a position with another one (normal or colour seams) never move, that would open a crack.
+//at runtime MeshLodSelect picks a level per object from how many pixels a mesh unit covers in whichever eye sees it biggest
+//shared with MeshSimplify.cpp, so nothing in here touches D3D12 or main.cpp's math
+
+#define MESH_LOD_MAX_LEVELS 4 //the key has 2 bits for it
+#define MESH_LOD_NO_SKIN 0xFFFFFFFF //dwJointOffset of a mesh without skinning
+#define MESH_LOD_BOUNDARY_WEIGHT 10.0 //quadric weight of the planes along open edges
+#define MESH_LOD_SKIN_WEIGHT 4.0 //a collapse between vertices with nothing in common costs this times its squared length on top
+#define MESH_LOD_FLIP_COS 0.25 //a collapse may turn a triangle's normal by at most about 75 degrees
+#define MESH_LOD_MIN_REDUCTION 0.9f //a level has to drop at least 10% of the triangles of the one before or the chain ends
+#define MESH_LOD_MIN_TRIANGLES 16
+#define MESH_LOD_PIXEL_ERROR 1.0f //a level is used while its error covers less than this many pixels
+#define MESH_LOD_HYSTERESIS 0.7f //going coarser needs the next level this far under MESH_LOD_PIXEL_ERROR, so an object on the edge doesn't flicker
+
+//one level of a chain
+typedef struct MeshLodLevel
+{
+	u32 dwFirstIndex; //into the chain's index list
+	u32 dwIndexCount;
+	f32 fError; //mesh units, root of the dearest collapse up to this level so on the high side, 0 for the full mesh
+} MeshLodLevel;
+
+typedef struct MeshLodInput
+{
+	const u8 *pVertices; //a float3 position first
+	u32 dwNumVertices;
+	u32 dwStride; //bytes
+	u32 dwJointOffset; //bytes to 4 u32 joints followed by 4 f32 weights, MESH_LOD_NO_SKIN without
+	const u32 *pIndices; //triangle list
+	u32 dwIndexCount;
+} MeshLodInput;
+
+//a collapse of dwFrom onto dwTo, ordered by cost
+typedef struct MeshLodCollapse
+{
+	f64 fCost;
+	u32 dwFrom;
+	u32 dwTo;
+} MeshLodCollapse;
+
+//a triangle edge by its welded vertices, lower one in the high bits, sorted so the triangles sharing it end up next to each other
+typedef struct MeshLodEdge
+{
+	u64 qwKey;
+	u32 dwTriEdge; //triangle * 3 + edge
+	u32 dwPad;
+} MeshLodEdge;
+
+//upper bound of the indices a chain can have
+inline
+u32 MeshLodIndexCapacity( u32 dwIndexCount, u32 dwMaxLevels )
+{
+	return dwIndexCount * dwMaxLevels;
+}
+
+inline
+void MeshLodPosition( MeshLodInput *a_pInput, u32 dwVertex, f64 *a_pPos )
+{
+	f32 fPos[3];
+	memcpy( fPos, a_pInput->pVertices + ( (u64)dwVertex * a_pInput->dwStride ), sizeof( fPos ) );
+	a_pPos[0] = fPos[0];
+	a_pPos[1] = fPos[1];
+	a_pPos[2] = fPos[2];
+}
+
+//the weight that has to move between bones to skin a like b, 0 for the same weights, 1 for no bone in common
+inline
+f64 MeshLodSkinDistance( MeshLodInput *a_pInput, u32 dwA, u32 dwB )
+{
+	u32 dwJoints[2][4];
+	f32 fWeights[2][4];
+	const u8 *pA = a_pInput->pVertices + ( (u64)dwA * a_pInput->dwStride ) + a_pInput->dwJointOffset;
+	const u8 *pB = a_pInput->pVertices + ( (u64)dwB * a_pInput->dwStride ) + a_pInput->dwJointOffset;
+	memcpy( dwJoints[0], pA, sizeof( dwJoints[0] ) );
+	memcpy( fWeights[0], pA + sizeof( dwJoints[0] ), sizeof( fWeights[0] ) );
+	memcpy( dwJoints[1], pB, sizeof( dwJoints[1] ) );
+	memcpy( fWeights[1], pB + sizeof( dwJoints[1] ), sizeof( fWeights[1] ) );
+	f64 fMoved = 0.0;
+	for( u32 dwSide = 0; dwSide < 2; ++dwSide )
+	{
+		for( u32 dwInfluence = 0; dwInfluence < 4; ++dwInfluence )
+		{
+			f32 fWeight = fWeights[dwSide][dwInfluence];
+			if( fWeight <= 0.0f )
+			{
+				continue;
+			}
+			//a bone both have is counted once from a's side
+			f32 fOther = 0.0f;
+			for( u32 dwOther = 0; dwOther < 4; ++dwOther )
+			{
+				fOther += dwJoints[dwSide ^ 1][dwOther] == dwJoints[dwSide][dwInfluence] ? fWeights[dwSide ^ 1][dwOther] : 0.0f;
+			}
+			if( dwSide == 0 || fOther <= 0.0f )
+			{
+				fMoved += fWeight > fOther ? fWeight - fOther : fOther - fWeight;
+			}
+		}
+	}
+	return fMoved * 0.5;
+}
+
+//symmetric 4x4 as a a, a b, a c, a d, b b, b c, b d, c c, c d, d d
+inline
+void MeshLodAddPlane( f64 *a_pQuadric, f64 fA, f64 fB, f64 fC, f64 fD, f64 fWeight )
+{
+	a_pQuadric[0] += fWeight * fA * fA;
+	a_pQuadric[1] += fWeight * fA * fB;
+	a_pQuadric[2] += fWeight * fA * fC;
+	a_pQuadric[3] += fWeight * fA * fD;
+	a_pQuadric[4] += fWeight * fB * fB;
+	a_pQuadric[5] += fWeight * fB * fC;
+	a_pQuadric[6] += fWeight * fB * fD;
+	a_pQuadric[7] += fWeight * fC * fC;
+	a_pQuadric[8] += fWeight * fC * fD;
+	a_pQuadric[9] += fWeight * fD * fD;
+}
+
+//sum of the weighted squared distances to the quadrics' planes
+inline
+f64 MeshLodQuadricError( f64 *a_pQ, f64 *a_pPos )
+{
+	f64 fX = a_pPos[0];
+	f64 fY = a_pPos[1];
+	f64 fZ = a_pPos[2];
+	f64 fError = ( a_pQ[0] * fX * fX ) + ( 2.0 * a_pQ[1] * fX * fY ) + ( 2.0 * a_pQ[2] * fX * fZ ) + ( 2.0 * a_pQ[3] * fX ) +
+		( a_pQ[4] * fY * fY ) + ( 2.0 * a_pQ[5] * fY * fZ ) + ( 2.0 * a_pQ[6] * fY ) + ( a_pQ[7] * fZ * fZ ) + ( 2.0 * a_pQ[8] * fZ ) + a_pQ[9];
+	return fError > 0.0 ? fError : 0.0;
+}
+
+inline
+void MeshLodCross( f64 *a_pA, f64 *a_pB, f64 *a_pC, f64 *a_pOut )
+{
+	f64 fE0[3] = { a_pB[0] - a_pA[0], a_pB[1] - a_pA[1], a_pB[2] - a_pA[2] };
+	f64 fE1[3] = { a_pC[0] - a_pA[0], a_pC[1] - a_pA[1], a_pC[2] - a_pA[2] };
+	a_pOut[0] = ( fE0[1] * fE1[2] ) - ( fE0[2] * fE1[1] );
+	a_pOut[1] = ( fE0[2] * fE1[0] ) - ( fE0[0] * fE1[2] );
+	a_pOut[2] = ( fE0[0] * fE1[1] ) - ( fE0[1] * fE1[0] );
+}
+
+inline
+int MeshLodCompareEdge( const void *a_pA, const void *a_pB )
+{
+	u64 qwA = ( (const MeshLodEdge*)a_pA )->qwKey;
+	u64 qwB = ( (const MeshLodEdge*)a_pB )->qwKey;
+	return qwA < qwB ? -1 : ( qwA > qwB ? 1 : 0 );
+}
+
+inline
+int MeshLodCompareCollapse( const void *a_pA, const void *a_pB )
+{
+	f64 fA = ( (const MeshLodCollapse*)a_pA )->fCost;
+	f64 fB = ( (const MeshLodCollapse*)a_pB )->fCost;
+	return fA < fB ? -1 : ( fA > fB ? 1 : 0 );
+}
+
+//moving dwFrom onto dwTo must not fold any of dwFrom's other triangles over
+inline
+bool MeshLodCollapseKeepsOrientation( MeshLodInput *a_pInput, u32 *a_pTris, u32 dwNumTris, u32 dwFrom, u32 dwTo )
+{
+	f64 fTo[3];
+	MeshLodPosition( a_pInput, dwTo, fTo );
+	for( u32 dwTri = 0; dwTri < dwNumTris; ++dwTri )
+	{
+		u32 *pTri = &a_pTris[dwTri * 3];
+		if( pTri[0] == 0xFFFFFFFF || ( pTri[0] != dwFrom && pTri[1] != dwFrom && pTri[2] != dwFrom ) ||
+			pTri[0] == dwTo || pTri[1] == dwTo || pTri[2] == dwTo )
+		{
+			continue;
+		}
+		f64 fCorners[3][3];
+		for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+		{
+			MeshLodPosition( a_pInput, pTri[dwCorner], fCorners[dwCorner] );
+		}
+		f64 fBefore[3], fAfter[3];
+		MeshLodCross( fCorners[0], fCorners[1], fCorners[2], fBefore );
+		if( fBefore[0] == 0.0 && fBefore[1] == 0.0 && fBefore[2] == 0.0 )
+		{
+			continue; //already degenerate, nothing to fold
+		}
+		for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+		{
+			if( pTri[dwCorner] == dwFrom )
+			{
+				memcpy( fCorners[dwCorner], fTo, sizeof( fTo ) );
+			}
+		}
+		MeshLodCross( fCorners[0], fCorners[1], fCorners[2], fAfter );
+		f64 fDot = ( fBefore[0] * fAfter[0] ) + ( fBefore[1] * fAfter[1] ) + ( fBefore[2] * fAfter[2] );
+		f64 fLengths = sqrt( ( ( fBefore[0] * fBefore[0] ) + ( fBefore[1] * fBefore[1] ) + ( fBefore[2] * fBefore[2] ) ) *
+			( ( fAfter[0] * fAfter[0] ) + ( fAfter[1] * fAfter[1] ) + ( fAfter[2] * fAfter[2] ) ) );
+		if( fDot <= MESH_LOD_FLIP_COS * fLengths )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//fills up to dwMaxLevels levels, level 0 is the input as is and each one after has about half the triangles of the one before.
+//a_pLodIndices needs MeshLodIndexCapacity indices. returns the level count, 0 when out of memory.
+//every round sorts all the collapses the live triangles allow and works down the list. a collapse only grows the quadric of the vertex it
+//keeps, so a cost involving a vertex kept earlier in the round is stale but never too high: the round ends at the first valid collapse
+//dearer than the cheapest stale one, which makes the order the same as recomputing after every collapse.
+//O(triangles^2) per level in the worst case, it is meant for offline
+inline
+u32 MeshLodSimplify( MeshLodInput *a_pInput, u32 dwMaxLevels, MeshLodLevel *a_pLevels, u32 *a_pLodIndices )
+{
+	u32 dwNumVertices = a_pInput->dwNumVertices;
+	u32 dwNumTris = a_pInput->dwIndexCount / 3;
+	u32 *pWeld = (u32*)malloc( sizeof( u32 ) * ( ( 3 * dwNumVertices ) + ( 3 * dwNumTris ) ) );
+	f64 *pQuadrics = (f64*)malloc( sizeof( f64 ) * 10 * dwNumVertices );
+	MeshLodCollapse *pCollapses = (MeshLodCollapse*)malloc( sizeof( MeshLodCollapse ) * 6 * ( dwNumTris > 0 ? dwNumTris : 1 ) );
+	if( !pWeld || !pQuadrics || !pCollapses )
+	{
+		free( pWeld );
+		free( pQuadrics );
+		free( pCollapses );
+		return 0;
+	}
+	u32 *pWeldCount = pWeld + dwNumVertices;
+	u32 *pRound = pWeldCount + dwNumVertices; //the last round a vertex kept another one in, 0xFFFFFFFF once it collapsed
+	u32 *pTris = pRound + dwNumVertices; //dead triangles start with 0xFFFFFFFF until the round compacts them
+	memcpy( pTris, a_pInput->pIndices, sizeof( u32 ) * 3 * dwNumTris );
+
+	//first vertex at each position, the quadrics and open edges are per position so seams look closed
+	for( u32 dwVertex = 0; dwVertex < dwNumVertices; ++dwVertex )
+	{
+		pWeld[dwVertex] = dwVertex;
+		pWeldCount[dwVertex] = 0;
+		pRound[dwVertex] = 0;
+		const u8 *pVertex = a_pInput->pVertices + ( (u64)dwVertex * a_pInput->dwStride );
+		for( u32 dwOther = 0; dwOther < dwVertex; ++dwOther )
+		{
+			if( memcmp( pVertex, a_pInput->pVertices + ( (u64)dwOther * a_pInput->dwStride ), 3 * sizeof( f32 ) ) == 0 )
+			{
+				pWeld[dwVertex] = pWeld[dwOther];
+				break;
+			}
+		}
+		++pWeldCount[pWeld[dwVertex]];
+	}
+	memset( pQuadrics, 0, sizeof( f64 ) * 10 * dwNumVertices );
+	MeshLodEdge *pEdges = (MeshLodEdge*)pCollapses; //the collapses have room for twice as many, they aren't needed yet
+	f64 *pFaceNormals = (f64*)( pEdges + ( 3 * dwNumTris ) ); //xyz per triangle, 0 for a degenerate one
+	for( u32 dwTri = 0; dwTri < dwNumTris; ++dwTri )
+	{
+		u32 *pTri = &pTris[dwTri * 3];
+		f64 fCorners[3][3];
+		for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+		{
+			MeshLodPosition( a_pInput, pTri[dwCorner], fCorners[dwCorner] );
+			u32 dwA = pWeld[pTri[dwCorner]];
+			u32 dwB = pWeld[pTri[( dwCorner + 1 ) % 3]];
+			pEdges[( dwTri * 3 ) + dwCorner].qwKey = dwA < dwB ? ( (u64)dwA << 32 ) | dwB : ( (u64)dwB << 32 ) | dwA;
+			pEdges[( dwTri * 3 ) + dwCorner].dwTriEdge = ( dwTri * 3 ) + dwCorner;
+		}
+		f64 *pNormal = &pFaceNormals[dwTri * 3];
+		MeshLodCross( fCorners[0], fCorners[1], fCorners[2], pNormal );
+		f64 fLength = sqrt( ( pNormal[0] * pNormal[0] ) + ( pNormal[1] * pNormal[1] ) + ( pNormal[2] * pNormal[2] ) );
+		fLength = fLength > 0.0 ? 1.0 / fLength : 0.0;
+		pNormal[0] *= fLength;
+		pNormal[1] *= fLength;
+		pNormal[2] *= fLength;
+		f64 fD = -( ( pNormal[0] * fCorners[0][0] ) + ( pNormal[1] * fCorners[0][1] ) + ( pNormal[2] * fCorners[0][2] ) );
+		for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+		{
+			MeshLodAddPlane( &pQuadrics[pWeld[pTri[dwCorner]] * 10], pNormal[0], pNormal[1], pNormal[2], fD, 1.0 );
+		}
+	}
+	//an edge no other triangle has (by position) is open, a plane through it at a right angle to the face keeps it in place
+	qsort( pEdges, 3 * dwNumTris, sizeof( MeshLodEdge ), MeshLodCompareEdge );
+	for( u32 dwEdge = 0; dwEdge < 3 * dwNumTris; ++dwEdge )
+	{
+		if( ( dwEdge > 0 && pEdges[dwEdge - 1].qwKey == pEdges[dwEdge].qwKey ) ||
+			( dwEdge + 1 < 3 * dwNumTris && pEdges[dwEdge + 1].qwKey == pEdges[dwEdge].qwKey ) )
+		{
+			continue;
+		}
+		u32 dwTri = pEdges[dwEdge].dwTriEdge / 3;
+		u32 dwCorner = pEdges[dwEdge].dwTriEdge % 3;
+		f64 *pNormal = &pFaceNormals[dwTri * 3];
+		f64 fA[3], fB[3];
+		MeshLodPosition( a_pInput, pTris[( dwTri * 3 ) + dwCorner], fA );
+		MeshLodPosition( a_pInput, pTris[( dwTri * 3 ) + ( ( dwCorner + 1 ) % 3 )], fB );
+		f64 fEdge[3] = { fB[0] - fA[0], fB[1] - fA[1], fB[2] - fA[2] };
+		f64 fSide[3] = { ( fEdge[1] * pNormal[2] ) - ( fEdge[2] * pNormal[1] ), ( fEdge[2] * pNormal[0] ) - ( fEdge[0] * pNormal[2] ),
+			( fEdge[0] * pNormal[1] ) - ( fEdge[1] * pNormal[0] ) };
+		f64 fSideLength = sqrt( ( fSide[0] * fSide[0] ) + ( fSide[1] * fSide[1] ) + ( fSide[2] * fSide[2] ) );
+		if( fSideLength <= 0.0 )
+		{
+			continue;
+		}
+		fSide[0] /= fSideLength;
+		fSide[1] /= fSideLength;
+		fSide[2] /= fSideLength;
+		f64 fSideD = -( ( fSide[0] * fA[0] ) + ( fSide[1] * fA[1] ) + ( fSide[2] * fA[2] ) );
+		MeshLodAddPlane( &pQuadrics[(u64)( pEdges[dwEdge].qwKey >> 32 ) * 10], fSide[0], fSide[1], fSide[2], fSideD, MESH_LOD_BOUNDARY_WEIGHT );
+		MeshLodAddPlane( &pQuadrics[(u64)( pEdges[dwEdge].qwKey & 0xFFFFFFFF ) * 10], fSide[0], fSide[1], fSide[2], fSideD, MESH_LOD_BOUNDARY_WEIGHT );
+	}
+
+	a_pLevels[0].dwFirstIndex = 0;
+	a_pLevels[0].dwIndexCount = dwNumTris * 3;
+	a_pLevels[0].fError = 0.0f;
+	memcpy( a_pLodIndices, a_pInput->pIndices, sizeof( u32 ) * 3 * dwNumTris );
+	u32 dwNumLevels = 1;
+	u32 dwRound = 0;
+	f64 fMaxCost = 0.0;
+	while( dwNumLevels < dwMaxLevels )
+	{
+		u32 dwLevelTris = a_pLevels[dwNumLevels - 1].dwIndexCount / 3;
+		u32 dwTarget = dwLevelTris / 2;
+		if( dwTarget < MESH_LOD_MIN_TRIANGLES )
+		{
+			break;
+		}
+		while( dwNumTris > dwTarget )
+		{
+			++dwRound;
+			u32 dwNumCollapses = 0;
+			for( u32 dwTri = 0; dwTri < dwNumTris; ++dwTri )
+			{
+				u32 *pTri = &pTris[dwTri * 3];
+				for( u32 dwEdge = 0; dwEdge < 6; ++dwEdge )
+				{
+					u32 dwFrom = pTri[dwEdge % 3];
+					u32 dwTo = pTri[( dwEdge + 1 + ( dwEdge / 3 ) ) % 3];
+					if( pWeldCount[pWeld[dwFrom]] > 1 || pWeld[dwFrom] == pWeld[dwTo] )
+					{
+						continue;
+					}
+					f64 fQ[10];
+					f64 fFrom[3], fTo[3];
+					for( u32 dwElement = 0; dwElement < 10; ++dwElement )
+					{
+						fQ[dwElement] = pQuadrics[( pWeld[dwFrom] * 10 ) + dwElement] + pQuadrics[( pWeld[dwTo] * 10 ) + dwElement];
+					}
+					MeshLodPosition( a_pInput, dwFrom, fFrom );
+					MeshLodPosition( a_pInput, dwTo, fTo );
+					f64 fCost = MeshLodQuadricError( fQ, fTo );
+					if( a_pInput->dwJointOffset != MESH_LOD_NO_SKIN )
+					{
+						f64 fLengthSq = ( ( fTo[0] - fFrom[0] ) * ( fTo[0] - fFrom[0] ) ) + ( ( fTo[1] - fFrom[1] ) * ( fTo[1] - fFrom[1] ) ) +
+							( ( fTo[2] - fFrom[2] ) * ( fTo[2] - fFrom[2] ) );
+						fCost += MESH_LOD_SKIN_WEIGHT * MeshLodSkinDistance( a_pInput, dwFrom, dwTo ) * fLengthSq;
+					}
+					pCollapses[dwNumCollapses].fCost = fCost;
+					pCollapses[dwNumCollapses].dwFrom = dwFrom;
+					pCollapses[dwNumCollapses++].dwTo = dwTo;
+				}
+			}
+			qsort( pCollapses, dwNumCollapses, sizeof( MeshLodCollapse ), MeshLodCompareCollapse );
+
+			u32 dwLiveTris = dwNumTris;
+			u32 dwApplied = 0;
+			f64 fStaleCost = INFINITY;
+			for( u32 dwCollapse = 0; dwCollapse < dwNumCollapses && dwLiveTris > dwTarget; ++dwCollapse )
+			{
+				u32 dwFrom = pCollapses[dwCollapse].dwFrom;
+				u32 dwTo = pCollapses[dwCollapse].dwTo;
+				if( pRound[dwFrom] == 0xFFFFFFFF || pRound[dwTo] == 0xFFFFFFFF )
+				{
+					continue;
+				}
+				if( pRound[dwFrom] == dwRound || pRound[dwTo] == dwRound )
+				{
+					fStaleCost = pCollapses[dwCollapse].fCost < fStaleCost ? pCollapses[dwCollapse].fCost : fStaleCost;
+					continue;
+				}
+				if( pCollapses[dwCollapse].fCost > fStaleCost )
+				{
+					break;
+				}
+				if( !MeshLodCollapseKeepsOrientation( a_pInput, pTris, dwNumTris, dwFrom, dwTo ) )
+				{
+					continue;
+				}
+				pRound[dwFrom] = 0xFFFFFFFF;
+				pRound[dwTo] = dwRound;
+				++dwApplied;
+				fMaxCost = pCollapses[dwCollapse].fCost > fMaxCost ? pCollapses[dwCollapse].fCost : fMaxCost;
+				for( u32 dwElement = 0; dwElement < 10; ++dwElement )
+				{
+					pQuadrics[( pWeld[dwTo] * 10 ) + dwElement] += pQuadrics[( pWeld[dwFrom] * 10 ) + dwElement];
+				}
+				for( u32 dwTri = 0; dwTri < dwNumTris; ++dwTri )
+				{
+					u32 *pTri = &pTris[dwTri * 3];
+					if( pTri[0] == 0xFFFFFFFF )
+					{
+						continue;
+					}
+					for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+					{
+						pTri[dwCorner] = pTri[dwCorner] == dwFrom ? dwTo : pTri[dwCorner];
+					}
+					if( pTri[0] == pTri[1] || pTri[1] == pTri[2] || pTri[2] == pTri[0] )
+					{
+						pTri[0] = 0xFFFFFFFF;
+						--dwLiveTris;
+					}
+				}
+			}
+			//compact in order, what was next to each other in the input stays close for the vertex cache
+			u32 dwKept = 0;
+			for( u32 dwTri = 0; dwTri < dwNumTris; ++dwTri )
+			{
+				if( pTris[dwTri * 3] != 0xFFFFFFFF )
+				{
+					memmove( &pTris[dwKept * 3], &pTris[dwTri * 3], sizeof( u32 ) * 3 );
+					++dwKept;
+				}
+			}
+			dwNumTris = dwKept;
+			if( !dwApplied )
+			{
+				break;
+			}
+		}
+		if( (f32)dwNumTris > (f32)dwLevelTris * MESH_LOD_MIN_REDUCTION )
+		{
+			break;
+		}
+		MeshLodLevel *pLevel = &a_pLevels[dwNumLevels];
+		pLevel->dwFirstIndex = a_pLevels[dwNumLevels - 1].dwFirstIndex + a_pLevels[dwNumLevels - 1].dwIndexCount;
+		pLevel->dwIndexCount = dwNumTris * 3;
+		pLevel->fError = (f32)sqrt( fMaxCost );
+		memcpy( &a_pLodIndices[pLevel->dwFirstIndex], pTris, sizeof( u32 ) * 3 * dwNumTris );
+		++dwNumLevels;
+	}
+	free( pWeld );
+	free( pQuadrics );
+	free( pCollapses );
+	return dwNumLevels;
+}
+
+//the level to draw with, starting from last frame's: finer as soon as the current one's error covers more than MESH_LOD_PIXEL_ERROR pixels,
+//coarser only once the next one's is under MESH_LOD_HYSTERESIS of that. fPixelsPerUnit is the largest over the eyes that see the object
+inline
+u32 MeshLodSelect( const MeshLodLevel *a_pLevels, u32 dwNumLevels, u32 dwCurrent, f32 fPixelsPerUnit )
+{
+	u32 dwLevel = dwCurrent < dwNumLevels ? dwCurrent : dwNumLevels - 1;
+	while( dwLevel > 0 && a_pLevels[dwLevel].fError * fPixelsPerUnit > MESH_LOD_PIXEL_ERROR )
+	{
+		--dwLevel;
+	}
+	while( dwLevel + 1 < dwNumLevels && a_pLevels[dwLevel + 1].fError * fPixelsPerUnit < MESH_LOD_PIXEL_ERROR * MESH_LOD_HYSTERESIS )
+	{
+		++dwLevel;
+	}
+	return dwLevel;
+}
+
+#if BENCHMARK_MODE
+//checks a chain: level 0 is the input, every level after drops at least MESH_LOD_MIN_REDUCTION, errors only grow, the levels are back to
+//back and every triangle is a real one over the input's vertices. returns the failures
+u32 MeshLodCheckChain( MeshLodInput *a_pInput, MeshLodLevel *a_pLevels, u32 dwNumLevels, u32 *a_pLodIndices )
+{
+	u32 dwFailures = dwNumLevels >= 2 && a_pLevels[0].dwIndexCount == a_pInput->dwIndexCount && a_pLevels[0].fError == 0.0f ? 0 : 1;
+	dwFailures += memcmp( a_pLodIndices, a_pInput->pIndices, sizeof( u32 ) * a_pInput->dwIndexCount ) == 0 ? 0 : 1;
+	for( u32 dwLevel = 1; dwLevel < dwNumLevels; ++dwLevel )
+	{
+		MeshLodLevel *pLevel = &a_pLevels[dwLevel];
+		MeshLodLevel *pPrev = &a_pLevels[dwLevel - 1];
+		dwFailures += pLevel->dwFirstIndex == pPrev->dwFirstIndex + pPrev->dwIndexCount && pLevel->dwIndexCount % 3 == 0 ? 0 : 1;
+		dwFailures += (f32)pLevel->dwIndexCount <= (f32)pPrev->dwIndexCount * MESH_LOD_MIN_REDUCTION && pLevel->fError >= pPrev->fError ? 0 : 1;
+		for( u32 dwIdx = pLevel->dwFirstIndex; dwIdx < pLevel->dwFirstIndex + pLevel->dwIndexCount; dwIdx += 3 )
+		{
+			u32 *pTri = &a_pLodIndices[dwIdx];
+			dwFailures += pTri[0] < a_pInput->dwNumVertices && pTri[1] < a_pInput->dwNumVertices && pTri[2] < a_pInput->dwNumVertices ? 0 : 1;
+			dwFailures += pTri[0] != pTri[1] && pTri[1] != pTri[2] && pTri[2] != pTri[0] ? 0 : 1;
+		}
+	}
+	return dwFailures;
+}
+
+//vertices the coarsest level still uses that are skinned to more than one bone, what keeps a joint bending smoothly
+u32 MeshLodBlendedVertices( MeshLodInput *a_pInput, MeshLodLevel *a_pLevel, u32 *a_pLodIndices, u8 *a_pUsed )
+{
+	memset( a_pUsed, 0, a_pInput->dwNumVertices );
+	u32 dwBlended = 0;
+	for( u32 dwIdx = a_pLevel->dwFirstIndex; dwIdx < a_pLevel->dwFirstIndex + a_pLevel->dwIndexCount; ++dwIdx )
+	{
+		u32 dwVertex = a_pLodIndices[dwIdx];
+		if( a_pUsed[dwVertex] )
+		{
+			continue;
+		}
+		a_pUsed[dwVertex] = 1;
+		f32 fWeights[4];
+		memcpy( fWeights, a_pInput->pVertices + ( (u64)dwVertex * a_pInput->dwStride ) + a_pInput->dwJointOffset + ( 4 * sizeof( u32 ) ), sizeof( fWeights ) );
+		dwBlended += fWeights[0] > 0.0f && fWeights[0] < 1.0f ? 1 : 0;
+	}
+	return dwBlended;
+}
+
+//the hand and a 2 bone tube (open at both ends, the bones blend over its middle) with and without the skin cost, then a jittered
+//sweep of how big the hand is on screen to check MeshLodSelect never shows an error over MESH_LOD_PIXEL_ERROR and doesn't flicker
+u32 BenchmarkMeshLod()
+{
+	const u32 dwRings = 65;
+	const u32 dwSegments = 24;
+	const u32 dwStride = 18 * sizeof( u32 ); //the hand's layout, position, normal, 4 joints, 4 weights, colour
+	const u32 dwTubeVertices = dwRings * dwSegments;
+	const u32 dwTubeIndices = ( dwRings - 1 ) * dwSegments * 6;
+	const u32 dwHandVertices = sizeof( handVertices ) / dwStride;
+	u32 dwMaxIndices = dwTubeIndices > handIndexCount ? dwTubeIndices : handIndexCount;
+	u8 *pTube = (u8*)malloc( ( dwStride * dwTubeVertices ) + ( sizeof( u32 ) * dwTubeIndices ) +
+		( sizeof( u32 ) * MeshLodIndexCapacity( dwMaxIndices, MESH_LOD_MAX_LEVELS ) ) + dwTubeVertices );
+	if( !pTube )
+	{
+		printf( "Mesh LOD: out of memory\n" );
+		return 1;
+	}
+	u32 *pTubeIndices = (u32*)( pTube + ( dwStride * dwTubeVertices ) );
+	u32 *pLodIndices = pTubeIndices + dwTubeIndices;
+	u8 *pUsed = (u8*)( pLodIndices + MeshLodIndexCapacity( dwMaxIndices, MESH_LOD_MAX_LEVELS ) );
+	memset( pTube, 0, dwStride * dwTubeVertices );
+	for( u32 dwRing = 0; dwRing < dwRings; ++dwRing )
+	{
+		f32 fY = (f32)dwRing / (f32)( dwRings - 1 );
+		f32 fBlend = ( fY - 0.4f ) * 5.0f; //bone 1 takes over between 0.4 and 0.6
+		fBlend = fBlend < 0.0f ? 0.0f : ( fBlend > 1.0f ? 1.0f : fBlend );
+		for( u32 dwSegment = 0; dwSegment < dwSegments; ++dwSegment )
+		{
+			f32 fAngle = (f32)dwSegment * ( 2.0f * PI_F / (f32)dwSegments );
+			f32 fVertex[18];
+			u32 dwJoints[4] = { 0, 1, 0, 0 };
+			memset( fVertex, 0, sizeof( fVertex ) );
+			fVertex[0] = 0.1f * cosf( fAngle );
+			fVertex[1] = fY;
+			fVertex[2] = 0.1f * sinf( fAngle );
+			fVertex[3] = cosf( fAngle );
+			fVertex[5] = sinf( fAngle );
+			memcpy( &fVertex[6], dwJoints, sizeof( dwJoints ) );
+			fVertex[10] = 1.0f - fBlend;
+			fVertex[11] = fBlend;
+			memcpy( pTube + ( (u64)( ( dwRing * dwSegments ) + dwSegment ) * dwStride ), fVertex, sizeof( fVertex ) );
+		}
+	}
+	u32 dwIdx = 0;
+	for( u32 dwRing = 0; dwRing + 1 < dwRings; ++dwRing )
+	{
+		for( u32 dwSegment = 0; dwSegment < dwSegments; ++dwSegment )
+		{
+			u32 dwA = ( dwRing * dwSegments ) + dwSegment;
+			u32 dwB = ( dwRing * dwSegments ) + ( ( dwSegment + 1 ) % dwSegments );
+			pTubeIndices[dwIdx++] = dwA;
+			pTubeIndices[dwIdx++] = dwA + dwSegments;
+			pTubeIndices[dwIdx++] = dwB;
+			pTubeIndices[dwIdx++] = dwB;
+			pTubeIndices[dwIdx++] = dwA + dwSegments;
+			pTubeIndices[dwIdx++] = dwB + dwSegments;
+		}
+	}
+
+	MeshLodInput inputs[2];
+	inputs[0].pVertices = (const u8*)handVertices;
+	inputs[0].dwNumVertices = dwHandVertices;
+	inputs[0].dwStride = dwStride;
+	inputs[0].dwJointOffset = 6 * sizeof( u32 );
+	inputs[0].pIndices = handIndices;
+	inputs[0].dwIndexCount = handIndexCount;
+	inputs[1].pVertices = pTube;
+	inputs[1].dwNumVertices = dwTubeVertices;
+	inputs[1].dwStride = dwStride;
+	inputs[1].dwJointOffset = 6 * sizeof( u32 );
+	inputs[1].pIndices = pTubeIndices;
+	inputs[1].dwIndexCount = dwTubeIndices;
+	const char *pNames[2] = { "hand", "tube" };
+
+	u32 dwFailures = 0;
+	MeshLodLevel levels[MESH_LOD_MAX_LEVELS];
+	MeshLodLevel handLevels[MESH_LOD_MAX_LEVELS];
+	u32 dwHandLevels = 0;
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	for( u32 dwInput = 0; dwInput < 2; ++dwInput )
+	{
+		//without the skin cost first, the tube's blend ring should fare better with it
+		u32 dwBlended[2];
+		for( u32 dwSkin = 0; dwSkin < 2; ++dwSkin )
+		{
+			MeshLodInput input = inputs[dwInput];
+			input.dwJointOffset = dwSkin ? input.dwJointOffset : MESH_LOD_NO_SKIN;
+			QueryPerformanceCounter( &startCounter );
+			u32 dwNumLevels = MeshLodSimplify( &input, MESH_LOD_MAX_LEVELS, levels, pLodIndices );
+			QueryPerformanceCounter( &endCounter );
+			dwFailures += MeshLodCheckChain( &input, levels, dwNumLevels, pLodIndices );
+			dwBlended[dwSkin] = dwNumLevels ? MeshLodBlendedVertices( &inputs[dwInput], &levels[dwNumLevels - 1], pLodIndices, pUsed ) : 0;
+			if( !dwSkin )
+			{
+				continue;
+			}
+			printf( "Mesh LOD %s: %u levels in %.2fms\n", pNames[dwInput], dwNumLevels,
+				( 1000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / (f64)PerfCountFrequency.QuadPart );
+			for( u32 dwLevel = 0; dwLevel < dwNumLevels; ++dwLevel )
+			{
+				printf( "  lod %u: %u triangles (%.1f%%), error %g\n", dwLevel, levels[dwLevel].dwIndexCount / 3,
+					( 100.0 * levels[dwLevel].dwIndexCount ) / levels[0].dwIndexCount, levels[dwLevel].fError );
+			}
+			if( dwInput == 0 )
+			{
+				memcpy( handLevels, levels, sizeof( levels ) );
+				dwHandLevels = dwNumLevels;
+			}
+		}
+		printf( "  blended vertices left in the last level: %u with the skin cost, %u without\n", dwBlended[1], dwBlended[0] );
+		dwFailures += dwInput == 0 || dwBlended[1] > dwBlended[0] ? 0 : 1;
+	}
+
+	//the hand from 1 to 100000 pixels per unit and back, 2% jitter every frame
+	u32 dwLevel = 0;
+	u32 dwSwitches = 0;
+	u32 dwSeed = 4242;
+	const u32 dwFrames = 2000;
+	for( u32 dwFrame = 0; dwFrame < dwFrames && dwHandLevels; ++dwFrame )
+	{
+		f32 fSweep = (f32)( dwFrame < dwFrames / 2 ? dwFrame : dwFrames - 1 - dwFrame ) / (f32)( dwFrames / 2 );
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		f32 fJitter = 1.0f + ( ( (f32)( dwSeed >> 8 ) / (f32)( 1 << 24 ) ) - 0.5f ) * 0.04f;
+		f32 fPixelsPerUnit = powf( 10.0f, 5.0f * ( 1.0f - fSweep ) ) * fJitter;
+		u32 dwNewLevel = MeshLodSelect( handLevels, dwHandLevels, dwLevel, fPixelsPerUnit );
+		dwSwitches += dwNewLevel != dwLevel ? 1 : 0;
+		dwLevel = dwNewLevel;
+		dwFailures += handLevels[dwLevel].fError * fPixelsPerUnit <= MESH_LOD_PIXEL_ERROR ? 0 : 1;
+	}
+	//each level change once on the way out and once on the way back
+	dwFailures += dwSwitches <= 2 * ( dwHandLevels - 1 ) ? 0 : 1;
+	printf( "Mesh LOD select: %u switches over a %u frame sweep, %u failures\n", dwSwitches, dwFrames, dwFailures );
+	free( pTube );
+	return dwFailures;
+}
+#endif
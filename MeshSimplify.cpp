@@ -0,0 +1,90 @@
+//MeshSimplify, offline half of MeshLod.h, built and run by Compile.bat before the app
+//"MeshSimplify.exe <out.h>" builds the LOD chain of every mesh in Models.h worth simplifying, prints triangles against error per level
+//and writes the chains as a header to include
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef float f32;
+typedef double f64;
+
+//just enough of main.cpp's types for Models.h, only the meshes are read
+typedef struct Vec3f { f32 v[3]; } Vec3f;
+typedef struct Quatf { f32 q[4]; } Quatf;
+typedef struct Mat4f { f32 m[4][4]; } Mat4f;
+typedef struct Bone { Quatf qLocalRot; Vec3f vLocalTrans; Vec3f vScale; } Bone;
+typedef struct KeyFrame { Quatf qRot; Vec3f vPos; } KeyFrame;
+
+#include "Models.h"
+#include "MeshLod.h"
+
+int WriteChain( FILE *a_pOut, const char *a_pName, MeshLodInput *a_pInput )
+{
+	MeshLodLevel levels[MESH_LOD_MAX_LEVELS];
+	u32 *pLodIndices = (u32*)malloc( sizeof( u32 ) * MeshLodIndexCapacity( a_pInput->dwIndexCount, MESH_LOD_MAX_LEVELS ) );
+	u32 dwNumLevels = pLodIndices ? MeshLodSimplify( a_pInput, MESH_LOD_MAX_LEVELS, levels, pLodIndices ) : 0;
+	if( !dwNumLevels )
+	{
+		printf( "MeshSimplify: out of memory simplifying %s\n", a_pName );
+		free( pLodIndices );
+		return 1;
+	}
+	u32 dwNumIndices = levels[dwNumLevels - 1].dwFirstIndex + levels[dwNumLevels - 1].dwIndexCount;
+	for( u32 dwLevel = 0; dwLevel < dwNumLevels; ++dwLevel )
+	{
+		printf( "%s lod %u: %u triangles (%.1f%%), error %g\n", a_pName, dwLevel, levels[dwLevel].dwIndexCount / 3,
+			( 100.0 * levels[dwLevel].dwIndexCount ) / levels[0].dwIndexCount, levels[dwLevel].fError );
+	}
+
+	fprintf( a_pOut, "const u32 %sLodCount = %u;\n", a_pName, dwNumLevels );
+	fprintf( a_pOut, "const MeshLodLevel %sLodLevels[MESH_LOD_MAX_LEVELS] =\n{\n", a_pName );
+	for( u32 dwLevel = 0; dwLevel < dwNumLevels; ++dwLevel )
+	{
+		fprintf( a_pOut, "\t{ %u, %u, %.9ef },\n", levels[dwLevel].dwFirstIndex, levels[dwLevel].dwIndexCount, levels[dwLevel].fError );
+	}
+	fprintf( a_pOut, "};\n" );
+	fprintf( a_pOut, "const u32 %sLodIndexCount = %u;\n", a_pName, dwNumIndices );
+	fprintf( a_pOut, "const u32 %sLodIndices[] =\n{", a_pName );
+	for( u32 dwIdx = 0; dwIdx < dwNumIndices; ++dwIdx )
+	{
+		fprintf( a_pOut, "%s%u,", ( dwIdx % 24 ) ? " " : "\n\t", pLodIndices[dwIdx] );
+	}
+	fprintf( a_pOut, "\n};\n" );
+	free( pLodIndices );
+	return 0;
+}
+
+int main( int argc, char **argv )
+{
+	if( argc != 2 )
+	{
+		printf( "usage: MeshSimplify <out.h>\n" );
+		return 1;
+	}
+	FILE *pOut = fopen( argv[1], "w" );
+	if( !pOut )
+	{
+		printf( "MeshSimplify: can't write %s\n", argv[1] );
+		return 1;
+	}
+	fprintf( pOut, "//generated by MeshSimplify.exe from Models.h, see MeshLod.h\n" );
+
+	//the hand, position, normal, 4 joints, 4 weights, colour. the plane and cube are already as simple as they get
+	MeshLodInput hand;
+	hand.pVertices = (const u8*)handVertices;
+	hand.dwStride = 18 * sizeof( u32 );
+	hand.dwNumVertices = sizeof( handVertices ) / hand.dwStride;
+	hand.dwJointOffset = 6 * sizeof( u32 );
+	hand.pIndices = handIndices;
+	hand.dwIndexCount = handIndexCount;
+	int result = WriteChain( pOut, "hand", &hand );
+
+	fclose( pOut );
+	return result;
+}
@@ -0,0 +1,90 @@
+//GPU side of Meshlets.h, one thread per meshlet: its sphere against each eye's mesh space planes and its normal cone against the
+//eye, then every thread that starts a run of visible meshlets in its group walks to the end of the run and appends it to its eye's
+//list as D3D12_DRAW_INDEXED_ARGUMENTS. counts holds each eye's ExecuteIndirect count. a run stops at the group's edge, so the set
+//of ranges is the same whatever order the groups ran in, only where each one lands changes
+
+#define EYE_COUNT 2
+#define CULL_MAX_PLANES 6
+#define MESHLET_CULL_GROUP 64
+#define MESHLET_NO_CONE 1.0f
+#define RANGE_SIZE 20
+
+cbuffer meshletCullCB : register(b0)
+{
+	float4 planes[EYE_COUNT * CULL_MAX_PLANES]; //mesh space, inwards, the unused ones are 0,0,0,1 and always pass
+	float4 eyes[EYE_COUNT]; //mesh space
+	uint numMeshlets;
+	uint rangeCapacity; //ranges per eye, the right eye's start right after
+	uint backface; //0 when the world matrix mirrors
+};
+
+struct Meshlet
+{
+	float3 center;
+	float radius;
+	float3 coneAxis;
+	float coneCutoff;
+	uint firstIndex;
+	uint triangleCount;
+	uint vertexCount;
+	uint pad;
+};
+
+StructuredBuffer<Meshlet> meshlets : register(t0);
+RWByteAddressBuffer ranges : register(u0);
+RWByteAddressBuffer counts : register(u1); //a uint per eye, cleared before the dispatch
+
+groupshared uint visibleMeshlets[EYE_COUNT * MESHLET_CULL_GROUP];
+
+[numthreads(MESHLET_CULL_GROUP, 1, 1)]
+void main( uint3 threadId : SV_DispatchThreadID, uint3 localId : SV_GroupThreadID )
+{
+	if( numMeshlets == 0 )
+	{
+		return; //the same for every thread, nothing below would be in bounds
+	}
+	uint index = threadId.x;
+	uint local = localId.x;
+	Meshlet meshlet = meshlets[min( index, numMeshlets - 1 )];
+
+	for( uint eye = 0; eye < EYE_COUNT; ++eye )
+	{
+		//same as MeshletVisible
+		bool visible = index < numMeshlets;
+		for( uint plane = 0; plane < CULL_MAX_PLANES; ++plane )
+		{
+			float4 p = planes[( eye * CULL_MAX_PLANES ) + plane];
+			visible = visible && ( dot( p.xyz, meshlet.center ) + p.w + meshlet.radius >= 0.0f );
+		}
+		if( backface != 0 && meshlet.coneCutoff < MESHLET_NO_CONE )
+		{
+			float3 toMeshlet = meshlet.center - eyes[eye].xyz;
+			visible = visible && ( dot( toMeshlet, meshlet.coneAxis ) < ( meshlet.coneCutoff * length( toMeshlet ) ) + meshlet.radius );
+		}
+		visibleMeshlets[( eye * MESHLET_CULL_GROUP ) + local] = visible ? 1 : 0;
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	for( uint runEye = 0; runEye < EYE_COUNT; ++runEye )
+	{
+		uint base = runEye * MESHLET_CULL_GROUP;
+		if( visibleMeshlets[base + local] == 0 || ( local > 0 && visibleMeshlets[base + local - 1] != 0 ) )
+		{
+			continue;
+		}
+		uint end = local + 1;
+		while( end < MESHLET_CULL_GROUP && visibleMeshlets[base + end] != 0 )
+		{
+			++end;
+		}
+		Meshlet last = meshlets[index + ( end - 1 - local )];
+		uint slot;
+		counts.InterlockedAdd( runEye * 4, 1, slot );
+		if( slot < rangeCapacity )
+		{
+			uint address = ( ( runEye * rangeCapacity ) + slot ) * RANGE_SIZE;
+			ranges.Store4( address, uint4( last.firstIndex + ( last.triangleCount * 3 ) - meshlet.firstIndex, 1, meshlet.firstIndex, 0 ) );
+			ranges.Store( address + 16, 0 );
+		}
+	}
+}
@@ -0,0 +1,684 @@
+//Meshlets, a dense mesh's triangles regrouped into clusters of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles,
+//each with a bounding sphere and a cone around its triangles' normals, so a whole cluster can be dropped before any of its vertices
+//get shaded: outside an eye's frustum, or every triangle in it facing away from the eye. the build reorders the indices so each
+//meshlet is one contiguous range, visible neighbours merge into one range and an eye draws what is left with a DrawIndexedInstanced each.
+//MeshletCull is the cpu reference, MeshletCull.hlsl does the same with a group per MESHLET_CULL_GROUP meshlets and appends the ranges
+//for ExecuteIndirect. a range never crosses a group, so both produce the same set and only the gpu's order depends on which group
+//finished first, MeshletCullEmulate (the kernel on the cpu) checks that. Compile.bat doesn't build the kernel, nothing the app draws
+//is dense enough to be worth a dispatch yet (the hands are skinned, their bounds move every frame)
+//the tests run in mesh space, MeshletCullSetView brings the eyes and planes in with the inverse world matrix. that is exact under any
+//scale, a triangle's facing only flips under a mirroring matrix and that turns the cone test off
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_CULL_GROUP 64 //numthreads of MeshletCull.hlsl
+#define MESHLET_NO_CONE 1.0f //cone cutoff of a meshlet whose normals spread too far for all of them to ever face away
+
+//a StructuredBuffer element of MeshletCull.hlsl (48 bytes)
+typedef struct Meshlet
+{
+	Vec3f vCenter;
+	f32 fRadius;
+	Vec3f vConeAxis; //average front face normal
+	f32 fConeCutoff; //sin of the cone's half angle, every normal is within 90 degrees of the axis or it is MESHLET_NO_CONE
+	u32 dwFirstIndex; //into MeshletMesh::pIndices
+	u32 dwTriangleCount;
+	u32 dwVertexCount;
+	u32 dwPad;
+} Meshlet;
+
+typedef struct MeshletMesh
+{
+	Meshlet *pMeshlets;
+	u32 *pIndices; //the input's triangles as is, in meshlet order
+	u32 dwNumMeshlets;
+	u32 dwIndexCount;
+	u32 dwCapacity; //indices
+} MeshletMesh;
+
+//a run of visible meshlets, laid out as D3D12_DRAW_INDEXED_ARGUMENTS so the gpu's list goes straight to ExecuteIndirect
+typedef struct MeshletRange
+{
+	u32 dwIndexCount;
+	u32 dwInstanceCount;
+	u32 dwFirstIndex;
+	s32 iBaseVertex;
+	u32 dwFirstInstance;
+} MeshletRange;
+
+//meshletCullCB
+typedef struct MeshletCullParams
+{
+	Vec4f planes[ovrEye_Count][CULL_MAX_PLANES]; //mesh space, normalized, unused planes are 0,0,0,1
+	Vec4f eyes[ovrEye_Count]; //mesh space, w unused
+	u32 dwNumMeshlets;
+	u32 dwRangeCapacity; //ranges per eye, the right eye's start right after
+	u32 dwBackface; //0 when the world matrix mirrors
+	u32 dwPad;
+} MeshletCullParams;
+
+//a mesh of dwIndexCount indices has at most a meshlet per triangle
+inline
+bool InitMeshletMesh( MeshletMesh *a_pMesh, u32 dwIndexCount )
+{
+	u32 dwMaxMeshlets = dwIndexCount / 3 > 0 ? dwIndexCount / 3 : 1;
+	a_pMesh->pMeshlets = (Meshlet*)malloc( ( sizeof( Meshlet ) * dwMaxMeshlets ) + ( sizeof( u32 ) * dwIndexCount ) );
+	if( !a_pMesh->pMeshlets )
+	{
+		return false;
+	}
+	a_pMesh->pIndices = (u32*)( a_pMesh->pMeshlets + dwMaxMeshlets );
+	a_pMesh->dwNumMeshlets = 0;
+	a_pMesh->dwIndexCount = 0;
+	a_pMesh->dwCapacity = dwIndexCount;
+	return true;
+}
+
+inline
+void DestroyMeshletMesh( MeshletMesh *a_pMesh )
+{
+	free( a_pMesh->pMeshlets );
+	a_pMesh->pMeshlets = nullptr;
+}
+
+inline
+void MeshletPosition( const u8 *a_pVertices, u32 dwStride, u32 dwVertex, Vec3f *a_pOut )
+{
+	memcpy( a_pOut, a_pVertices + ( (u64)dwVertex * dwStride ), sizeof( Vec3f ) );
+}
+
+//the outward normal of a front face, the pipeline keeps clockwise triangles (FrontCounterClockwise = 0) so it is ( c - a ) x ( b - a )
+inline
+void MeshletFaceNormal( Vec3f *a_pA, Vec3f *a_pB, Vec3f *a_pC, Vec3f *a_pOut )
+{
+	Vec3f vAB, vAC;
+	Vec3fSub( a_pB, a_pA, &vAB );
+	Vec3fSub( a_pC, a_pA, &vAC );
+	Vec3fCross( &vAC, &vAB, a_pOut );
+}
+
+//sphere around the meshlet's vertices (from their box's center) and the normal cone of its triangles
+inline
+void MeshletBounds( Meshlet *a_pMeshlet, const u8 *a_pVertices, u32 dwStride, const u32 *a_pIndices, u32 *a_pVertexList )
+{
+	Vec3f vMin, vMax;
+	MeshletPosition( a_pVertices, dwStride, a_pVertexList[0], &vMin );
+	vMax = vMin;
+	for( u32 dwVertex = 1; dwVertex < a_pMeshlet->dwVertexCount; ++dwVertex )
+	{
+		Vec3f vPos;
+		MeshletPosition( a_pVertices, dwStride, a_pVertexList[dwVertex], &vPos );
+		vMin.x = vPos.x < vMin.x ? vPos.x : vMin.x;
+		vMin.y = vPos.y < vMin.y ? vPos.y : vMin.y;
+		vMin.z = vPos.z < vMin.z ? vPos.z : vMin.z;
+		vMax.x = vPos.x > vMax.x ? vPos.x : vMax.x;
+		vMax.y = vPos.y > vMax.y ? vPos.y : vMax.y;
+		vMax.z = vPos.z > vMax.z ? vPos.z : vMax.z;
+	}
+	Vec3f vCenter = { ( vMin.x + vMax.x ) * 0.5f, ( vMin.y + vMax.y ) * 0.5f, ( vMin.z + vMax.z ) * 0.5f };
+	f32 fRadiusSq = 0.0f;
+	for( u32 dwVertex = 0; dwVertex < a_pMeshlet->dwVertexCount; ++dwVertex )
+	{
+		Vec3f vPos, vOffset;
+		MeshletPosition( a_pVertices, dwStride, a_pVertexList[dwVertex], &vPos );
+		Vec3fSub( &vPos, &vCenter, &vOffset );
+		f32 fDistSq = Vec3fDot( &vOffset, &vOffset );
+		fRadiusSq = fDistSq > fRadiusSq ? fDistSq : fRadiusSq;
+	}
+	a_pMeshlet->vCenter = vCenter;
+	a_pMeshlet->fRadius = sqrtf( fRadiusSq ) * 1.0001f; //so float rounding in the tests can't leave a corner outside
+
+	//the axis is the average unit normal, the cutoff comes from the normal furthest from it. zero area triangles can't be seen
+	const u32 *pTris = a_pIndices + a_pMeshlet->dwFirstIndex;
+	Vec3f vAxis = { 0.0f, 0.0f, 0.0f };
+	for( u32 dwTri = 0; dwTri < a_pMeshlet->dwTriangleCount; ++dwTri )
+	{
+		Vec3f vA, vB, vC, vNormal;
+		MeshletPosition( a_pVertices, dwStride, pTris[( dwTri * 3 ) + 0], &vA );
+		MeshletPosition( a_pVertices, dwStride, pTris[( dwTri * 3 ) + 1], &vB );
+		MeshletPosition( a_pVertices, dwStride, pTris[( dwTri * 3 ) + 2], &vC );
+		MeshletFaceNormal( &vA, &vB, &vC, &vNormal );
+		f32 fLength = Vec3fLength( &vNormal );
+		if( fLength > 0.0f )
+		{
+			vAxis.x += vNormal.x / fLength;
+			vAxis.y += vNormal.y / fLength;
+			vAxis.z += vNormal.z / fLength;
+		}
+	}
+	f32 fAxisLength = Vec3fLength( &vAxis );
+	a_pMeshlet->fConeCutoff = MESHLET_NO_CONE;
+	a_pMeshlet->vConeAxis.x = 0.0f;
+	a_pMeshlet->vConeAxis.y = 0.0f;
+	a_pMeshlet->vConeAxis.z = 1.0f;
+	if( fAxisLength <= 0.0f )
+	{
+		return;
+	}
+	vAxis.x /= fAxisLength;
+	vAxis.y /= fAxisLength;
+	vAxis.z /= fAxisLength;
+	f32 fMinDot = 1.0f;
+	for( u32 dwTri = 0; dwTri < a_pMeshlet->dwTriangleCount; ++dwTri )
+	{
+		Vec3f vA, vB, vC, vNormal;
+		MeshletPosition( a_pVertices, dwStride, pTris[( dwTri * 3 ) + 0], &vA );
+		MeshletPosition( a_pVertices, dwStride, pTris[( dwTri * 3 ) + 1], &vB );
+		MeshletPosition( a_pVertices, dwStride, pTris[( dwTri * 3 ) + 2], &vC );
+		MeshletFaceNormal( &vA, &vB, &vC, &vNormal );
+		f32 fLength = Vec3fLength( &vNormal );
+		if( fLength > 0.0f )
+		{
+			f32 fDot = Vec3fDot( &vNormal, &vAxis ) / fLength;
+			fMinDot = fDot < fMinDot ? fDot : fMinDot;
+		}
+	}
+	a_pMeshlet->vConeAxis = vAxis;
+	if( fMinDot > 0.01f ) //a cone this close to a half space culls next to nothing and its rounding gets risky
+	{
+		a_pMeshlet->fConeCutoff = sqrtf( 1.0f - ( fMinDot * fMinDot ) ) + 0.0001f;
+	}
+}
+
+//greedy: a meshlet starts at the first triangle not taken yet and keeps taking the neighbouring triangle (sharing a vertex with it)
+//that adds the fewest new vertices, until nothing neighbouring fits. a_pVertices starts with a float3 position.
+//returns false when out of memory or a_pMesh is too small
+inline
+bool BuildMeshlets( MeshletMesh *a_pMesh, const u8 *a_pVertices, u32 dwStride, u32 dwNumVertices, const u32 *a_pIndices, u32 dwIndexCount )
+{
+	u32 dwNumTris = dwIndexCount / 3;
+	if( dwIndexCount % 3 != 0 || dwIndexCount > a_pMesh->dwCapacity )
+	{
+		logError( "BuildMeshlets: not a triangle list or more indices than the mesh was made for\n" );
+		return false;
+	}
+	//vertex to triangle adjacency, then the meshlet each vertex was last added to (+1) and which triangles are taken
+	u32 *pAdjacencyStart = (u32*)malloc( sizeof( u32 ) * ( ( 2 * ( dwNumVertices + 1 ) ) + dwIndexCount + dwNumTris ) );
+	if( !pAdjacencyStart )
+	{
+		logError( "BuildMeshlets: out of memory\n" );
+		return false;
+	}
+	u32 *pVertexMeshlet = pAdjacencyStart + dwNumVertices + 1;
+	u32 *pAdjacency = pVertexMeshlet + dwNumVertices + 1;
+	u32 *pTaken = pAdjacency + dwIndexCount;
+	memset( pAdjacencyStart, 0, sizeof( u32 ) * ( ( 2 * ( dwNumVertices + 1 ) ) + dwIndexCount + dwNumTris ) );
+	for( u32 dwIdx = 0; dwIdx < dwIndexCount; ++dwIdx )
+	{
+		++pAdjacencyStart[a_pIndices[dwIdx] + 1];
+	}
+	for( u32 dwVertex = 0; dwVertex < dwNumVertices; ++dwVertex )
+	{
+		pAdjacencyStart[dwVertex + 1] += pAdjacencyStart[dwVertex];
+	}
+	for( u32 dwIdx = 0; dwIdx < dwIndexCount; ++dwIdx )
+	{
+		u32 dwVertex = a_pIndices[dwIdx];
+		pAdjacency[pAdjacencyStart[dwVertex] + pVertexMeshlet[dwVertex]++] = dwIdx / 3;
+	}
+	memset( pVertexMeshlet, 0, sizeof( u32 ) * ( dwNumVertices + 1 ) );
+
+	u32 dwVertexList[MESHLET_MAX_VERTICES];
+	u32 dwSeed = 0;
+	u32 dwNumMeshlets = 0;
+	u32 dwOut = 0;
+	while( dwOut < dwIndexCount )
+	{
+		Meshlet *pMeshlet = &a_pMesh->pMeshlets[dwNumMeshlets++];
+		u32 dwTag = dwNumMeshlets;
+		pMeshlet->dwFirstIndex = dwOut;
+		pMeshlet->dwTriangleCount = 0;
+		pMeshlet->dwVertexCount = 0;
+		pMeshlet->dwPad = 0;
+		while( pMeshlet->dwTriangleCount < MESHLET_MAX_TRIANGLES )
+		{
+			u32 dwBest = 0xFFFFFFFF;
+			u32 dwBestNew = 4;
+			if( pMeshlet->dwVertexCount == 0 )
+			{
+				while( pTaken[dwSeed] )
+				{
+					++dwSeed;
+				}
+				dwBest = dwSeed;
+				dwBestNew = 3;
+			}
+			for( u32 dwVertex = 0; dwVertex < pMeshlet->dwVertexCount && dwBestNew > 0; ++dwVertex )
+			{
+				u32 dwShared = dwVertexList[dwVertex];
+				for( u32 dwAdjacent = pAdjacencyStart[dwShared]; dwAdjacent < pAdjacencyStart[dwShared + 1] && dwBestNew > 0; ++dwAdjacent )
+				{
+					u32 dwTri = pAdjacency[dwAdjacent];
+					if( pTaken[dwTri] )
+					{
+						continue;
+					}
+					u32 dwNew = 0;
+					for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+					{
+						dwNew += pVertexMeshlet[a_pIndices[( dwTri * 3 ) + dwCorner]] != dwTag ? 1 : 0;
+					}
+					if( dwNew < dwBestNew )
+					{
+						dwBest = dwTri;
+						dwBestNew = dwNew;
+					}
+				}
+			}
+			if( dwBest == 0xFFFFFFFF || pMeshlet->dwVertexCount + dwBestNew > MESHLET_MAX_VERTICES )
+			{
+				break;
+			}
+			for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+			{
+				u32 dwVertex = a_pIndices[( dwBest * 3 ) + dwCorner];
+				if( pVertexMeshlet[dwVertex] != dwTag )
+				{
+					pVertexMeshlet[dwVertex] = dwTag;
+					dwVertexList[pMeshlet->dwVertexCount++] = dwVertex;
+				}
+				a_pMesh->pIndices[dwOut++] = dwVertex;
+			}
+			pTaken[dwBest] = 1;
+			++pMeshlet->dwTriangleCount;
+		}
+		MeshletBounds( pMeshlet, a_pVertices, dwStride, a_pMesh->pIndices, dwVertexList );
+	}
+	a_pMesh->dwNumMeshlets = dwNumMeshlets;
+	a_pMesh->dwIndexCount = dwIndexCount;
+	free( pAdjacencyStart );
+	return true;
+}
+
+//each eye's frustum planes and position into the mesh space of a_pWorld, for the draw of one MeshletMesh
+inline
+void MeshletCullSetView( MeshletCullParams *a_pParams, CullFrustum *a_pFrustums, Vec3f *a_pEyePositions, Mat4f *a_pWorld, u32 dwNumMeshlets,
+	u32 dwRangeCapacity )
+{
+	//a world point is mesh * upper 3x3 + translation, so a plane (n, w) is ( upper 3x3 n, n . translation + w ) in mesh space
+	Mat3x4f mInvTranspose;
+	InverseTransposeUpper3x3Mat4f( a_pWorld, &mInvTranspose );
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		for( u32 dwPlane = 0; dwPlane < CULL_MAX_PLANES; ++dwPlane )
+		{
+			Vec4f *pOut = &a_pParams->planes[dwEye][dwPlane];
+			if( dwPlane >= a_pFrustums[dwEye].dwNumPlanes )
+			{
+				pOut->x = 0.0f;
+				pOut->y = 0.0f;
+				pOut->z = 0.0f;
+				pOut->w = 1.0f;
+				continue;
+			}
+			Vec4f *pPlane = &a_pFrustums[dwEye].planes[dwPlane];
+			f32 fPlane[3];
+			for( u32 dwRow = 0; dwRow < 3; ++dwRow )
+			{
+				fPlane[dwRow] = ( a_pWorld->m[dwRow][0] * pPlane->x ) + ( a_pWorld->m[dwRow][1] * pPlane->y ) + ( a_pWorld->m[dwRow][2] * pPlane->z );
+			}
+			f32 fW = ( a_pWorld->m[3][0] * pPlane->x ) + ( a_pWorld->m[3][1] * pPlane->y ) + ( a_pWorld->m[3][2] * pPlane->z ) + pPlane->w;
+			f32 fInvLength = 1.0f / sqrtf( ( fPlane[0] * fPlane[0] ) + ( fPlane[1] * fPlane[1] ) + ( fPlane[2] * fPlane[2] ) );
+			pOut->x = fPlane[0] * fInvLength;
+			pOut->y = fPlane[1] * fInvLength;
+			pOut->z = fPlane[2] * fInvLength;
+			pOut->w = fW * fInvLength;
+		}
+		//the inverse of the upper 3x3 is the transpose of its inverse transpose
+		f32 fDX = a_pEyePositions[dwEye].x - a_pWorld->m[3][0];
+		f32 fDY = a_pEyePositions[dwEye].y - a_pWorld->m[3][1];
+		f32 fDZ = a_pEyePositions[dwEye].z - a_pWorld->m[3][2];
+		a_pParams->eyes[dwEye].x = ( fDX * mInvTranspose.m[0][0] ) + ( fDY * mInvTranspose.m[0][1] ) + ( fDZ * mInvTranspose.m[0][2] );
+		a_pParams->eyes[dwEye].y = ( fDX * mInvTranspose.m[1][0] ) + ( fDY * mInvTranspose.m[1][1] ) + ( fDZ * mInvTranspose.m[1][2] );
+		a_pParams->eyes[dwEye].z = ( fDX * mInvTranspose.m[2][0] ) + ( fDY * mInvTranspose.m[2][1] ) + ( fDZ * mInvTranspose.m[2][2] );
+		a_pParams->eyes[dwEye].w = 1.0f;
+	}
+	a_pParams->dwNumMeshlets = dwNumMeshlets;
+	a_pParams->dwRangeCapacity = dwRangeCapacity;
+	a_pParams->dwBackface = DeterminantUpper3x3Mat4f( a_pWorld ) > 0.0f ? 1 : 0;
+	a_pParams->dwPad = 0;
+}
+
+//the sphere against the eye's planes, then whether every normal in the cone faces away from every point of the sphere
+inline
+u8 MeshletVisible( Meshlet *a_pMeshlet, MeshletCullParams *a_pParams, u32 dwEye )
+{
+	Vec3f *pCenter = &a_pMeshlet->vCenter;
+	for( u32 dwPlane = 0; dwPlane < CULL_MAX_PLANES; ++dwPlane )
+	{
+		Vec4f *pPlane = &a_pParams->planes[dwEye][dwPlane];
+		if( ( pPlane->x * pCenter->x ) + ( pPlane->y * pCenter->y ) + ( pPlane->z * pCenter->z ) + pPlane->w + a_pMeshlet->fRadius < 0.0f )
+		{
+			return 0;
+		}
+	}
+	if( a_pParams->dwBackface && a_pMeshlet->fConeCutoff < MESHLET_NO_CONE )
+	{
+		Vec3f vToMeshlet = { pCenter->x - a_pParams->eyes[dwEye].x, pCenter->y - a_pParams->eyes[dwEye].y, pCenter->z - a_pParams->eyes[dwEye].z };
+		if( Vec3fDot( &vToMeshlet, &a_pMeshlet->vConeAxis ) >= ( a_pMeshlet->fConeCutoff * Vec3fLength( &vToMeshlet ) ) + a_pMeshlet->fRadius )
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+inline
+void MeshletSetRange( MeshletRange *a_pRange, Meshlet *a_pFirst, Meshlet *a_pLast )
+{
+	a_pRange->dwIndexCount = a_pLast->dwFirstIndex + ( a_pLast->dwTriangleCount * 3 ) - a_pFirst->dwFirstIndex;
+	a_pRange->dwInstanceCount = 1;
+	a_pRange->dwFirstIndex = a_pFirst->dwFirstIndex;
+	a_pRange->iBaseVertex = 0;
+	a_pRange->dwFirstInstance = 0;
+}
+
+//the visible meshlets of one eye as ranges in meshlet order, a_pRanges needs room for one per meshlet. returns the count
+inline
+u32 MeshletCull( MeshletMesh *a_pMesh, MeshletCullParams *a_pParams, u32 dwEye, MeshletRange *a_pRanges )
+{
+	u32 dwNumRanges = 0;
+	u32 dwRunStart = 0xFFFFFFFF;
+	for( u32 dwMeshlet = 0; dwMeshlet <= a_pMesh->dwNumMeshlets; ++dwMeshlet )
+	{
+		u8 bVisible = dwMeshlet < a_pMesh->dwNumMeshlets && MeshletVisible( &a_pMesh->pMeshlets[dwMeshlet], a_pParams, dwEye );
+		if( dwRunStart != 0xFFFFFFFF && ( !bVisible || dwMeshlet % MESHLET_CULL_GROUP == 0 ) )
+		{
+			MeshletSetRange( &a_pRanges[dwNumRanges++], &a_pMesh->pMeshlets[dwRunStart], &a_pMesh->pMeshlets[dwMeshlet - 1] );
+			dwRunStart = 0xFFFFFFFF;
+		}
+		if( bVisible && dwRunStart == 0xFFFFFFFF )
+		{
+			dwRunStart = dwMeshlet;
+		}
+	}
+	return dwNumRanges;
+}
+
+#if BENCHMARK_MODE
+//MeshletCull.hlsl on the cpu, thread by thread. the groups run last to first to stand in for whatever order the gpu picks.
+//a_pRanges holds both eyes' lists, dwRangeCapacity apart, a_pCounts is the count buffer and may go past the capacity like on the gpu
+void MeshletCullEmulate( MeshletMesh *a_pMesh, MeshletCullParams *a_pParams, MeshletRange *a_pRanges, u32 *a_pCounts )
+{
+	u32 dwNumGroups = ( a_pParams->dwNumMeshlets + MESHLET_CULL_GROUP - 1 ) / MESHLET_CULL_GROUP;
+	a_pCounts[0] = 0;
+	a_pCounts[1] = 0;
+	for( u32 dwGroup = dwNumGroups; dwGroup-- > 0; )
+	{
+		u8 visible[ovrEye_Count][MESHLET_CULL_GROUP];
+		for( u32 dwLocal = 0; dwLocal < MESHLET_CULL_GROUP; ++dwLocal )
+		{
+			u32 dwMeshlet = ( dwGroup * MESHLET_CULL_GROUP ) + dwLocal;
+			for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+			{
+				visible[dwEye][dwLocal] = dwMeshlet < a_pParams->dwNumMeshlets && MeshletVisible( &a_pMesh->pMeshlets[dwMeshlet], a_pParams, dwEye );
+			}
+		}
+		//GroupMemoryBarrierWithGroupSync
+		for( u32 dwLocal = 0; dwLocal < MESHLET_CULL_GROUP; ++dwLocal )
+		{
+			for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+			{
+				if( !visible[dwEye][dwLocal] || ( dwLocal > 0 && visible[dwEye][dwLocal - 1] ) )
+				{
+					continue;
+				}
+				u32 dwEnd = dwLocal + 1;
+				while( dwEnd < MESHLET_CULL_GROUP && visible[dwEye][dwEnd] )
+				{
+					++dwEnd;
+				}
+				u32 dwSlot = a_pCounts[dwEye]++;
+				if( dwSlot < a_pParams->dwRangeCapacity )
+				{
+					Meshlet *pFirst = &a_pMesh->pMeshlets[( dwGroup * MESHLET_CULL_GROUP ) + dwLocal];
+					MeshletSetRange( &a_pRanges[( dwEye * a_pParams->dwRangeCapacity ) + dwSlot], pFirst, pFirst + ( dwEnd - 1 - dwLocal ) );
+				}
+			}
+		}
+	}
+}
+
+int MeshletCompareRange( const void *a_pA, const void *a_pB )
+{
+	u32 dwA = ( (const MeshletRange*)a_pA )->dwFirstIndex;
+	u32 dwB = ( (const MeshletRange*)a_pB )->dwFirstIndex;
+	return dwA < dwB ? -1 : ( dwA > dwB ? 1 : 0 );
+}
+
+int MeshletCompareTriangle( const void *a_pA, const void *a_pB )
+{
+	const u32 *pA = (const u32*)a_pA;
+	const u32 *pB = (const u32*)a_pB;
+	for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+	{
+		if( pA[dwCorner] != pB[dwCorner] )
+		{
+			return pA[dwCorner] < pB[dwCorner] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+//a 256x128 torus (65k triangles) scaled, turned and moved out in front of a pair of eyes that see its outside and top.
+//checks the meshlets hold every triangle once within their limits, the spheres hold their vertices and the cones their normals,
+//that in world space no front facing triangle with its centroid inside an eye's frustum was culled, and that the emulated
+//kernel gives the same ranges as MeshletCull. an empty mesh has to build and cull to nothing
+u32 BenchmarkMeshlets()
+{
+	const u32 dwMajor = 256;
+	const u32 dwMinor = 128;
+	const u32 dwNumVertices = dwMajor * dwMinor;
+	const u32 dwIndexCount = dwMajor * dwMinor * 6;
+	const u32 dwIterations = 100;
+	Vec3f *pVertices = (Vec3f*)malloc( ( sizeof( Vec3f ) * dwNumVertices ) + ( 2 * sizeof( u32 ) * dwIndexCount ) );
+	MeshletMesh mesh;
+	if( !pVertices || !InitMeshletMesh( &mesh, dwIndexCount ) )
+	{
+		printf( "Meshlets: out of memory\n" );
+		free( pVertices );
+		return 1;
+	}
+	u32 *pIndices = (u32*)( pVertices + dwNumVertices );
+	u32 *pSorted = pIndices + dwIndexCount;
+	for( u32 dwRing = 0; dwRing < dwMajor; ++dwRing )
+	{
+		f32 fMajor = (f32)dwRing * ( 2.0f * PI_F / (f32)dwMajor );
+		for( u32 dwSide = 0; dwSide < dwMinor; ++dwSide )
+		{
+			f32 fMinor = (f32)dwSide * ( 2.0f * PI_F / (f32)dwMinor );
+			f32 fDistance = 1.0f + ( 0.3f * cosf( fMinor ) );
+			Vec3f *pVertex = &pVertices[( dwRing * dwMinor ) + dwSide];
+			pVertex->x = fDistance * cosf( fMajor );
+			pVertex->y = 0.3f * sinf( fMinor );
+			pVertex->z = fDistance * sinf( fMajor );
+		}
+	}
+	u32 dwIdx = 0;
+	for( u32 dwRing = 0; dwRing < dwMajor; ++dwRing )
+	{
+		for( u32 dwSide = 0; dwSide < dwMinor; ++dwSide )
+		{
+			u32 dwA = ( dwRing * dwMinor ) + dwSide;
+			u32 dwB = ( ( ( dwRing + 1 ) % dwMajor ) * dwMinor ) + dwSide;
+			u32 dwC = ( dwRing * dwMinor ) + ( ( dwSide + 1 ) % dwMinor );
+			u32 dwD = ( ( ( dwRing + 1 ) % dwMajor ) * dwMinor ) + ( ( dwSide + 1 ) % dwMinor );
+			//clockwise seen from outside
+			pIndices[dwIdx++] = dwA;
+			pIndices[dwIdx++] = dwB;
+			pIndices[dwIdx++] = dwC;
+			pIndices[dwIdx++] = dwC;
+			pIndices[dwIdx++] = dwB;
+			pIndices[dwIdx++] = dwD;
+		}
+	}
+
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	QueryPerformanceCounter( &startCounter );
+	bool bBuilt = BuildMeshlets( &mesh, (const u8*)pVertices, sizeof( Vec3f ), dwNumVertices, pIndices, dwIndexCount );
+	QueryPerformanceCounter( &endCounter );
+	f64 fBuildMs = ( 1000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / (f64)PerfCountFrequency.QuadPart;
+	u32 dwFailures = bBuilt ? 0 : 1;
+
+	//the torus is made clockwise seen from outside, the face normal has to agree with the surface's
+	Vec3f vFaceNormal;
+	MeshletFaceNormal( &pVertices[pIndices[0]], &pVertices[pIndices[1]], &pVertices[pIndices[2]], &vFaceNormal );
+	dwFailures += vFaceNormal.x > 0.0f ? 0 : 1;
+
+	u32 dwNumCones = 0;
+	u32 dwCovered = 0;
+	for( u32 dwMeshlet = 0; dwMeshlet < mesh.dwNumMeshlets && bBuilt; ++dwMeshlet )
+	{
+		Meshlet *pMeshlet = &mesh.pMeshlets[dwMeshlet];
+		dwFailures += pMeshlet->dwFirstIndex == dwCovered && pMeshlet->dwTriangleCount > 0 && pMeshlet->dwTriangleCount <= MESHLET_MAX_TRIANGLES &&
+			pMeshlet->dwVertexCount <= MESHLET_MAX_VERTICES ? 0 : 1;
+		dwCovered += pMeshlet->dwTriangleCount * 3;
+		dwNumCones += pMeshlet->fConeCutoff < MESHLET_NO_CONE ? 1 : 0;
+		for( u32 dwTri = 0; dwTri < pMeshlet->dwTriangleCount; ++dwTri )
+		{
+			u32 *pTri = &mesh.pIndices[pMeshlet->dwFirstIndex + ( dwTri * 3 )];
+			for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+			{
+				Vec3f vOffset;
+				Vec3fSub( &pVertices[pTri[dwCorner]], &pMeshlet->vCenter, &vOffset );
+				dwFailures += Vec3fLength( &vOffset ) <= pMeshlet->fRadius ? 0 : 1;
+			}
+			Vec3f vNormal;
+			MeshletFaceNormal( &pVertices[pTri[0]], &pVertices[pTri[1]], &pVertices[pTri[2]], &vNormal );
+			f32 fCos = Vec3fDot( &vNormal, &pMeshlet->vConeAxis ) / Vec3fLength( &vNormal );
+			dwFailures += pMeshlet->fConeCutoff >= MESHLET_NO_CONE || fCos > sqrtf( 1.0f - ( pMeshlet->fConeCutoff * pMeshlet->fConeCutoff ) ) - 0.001f ? 0 : 1;
+		}
+	}
+	dwFailures += dwCovered == dwIndexCount ? 0 : 1;
+	memcpy( pSorted, mesh.pIndices, sizeof( u32 ) * dwIndexCount );
+	qsort( pSorted, dwIndexCount / 3, 3 * sizeof( u32 ), MeshletCompareTriangle );
+	qsort( pIndices, dwIndexCount / 3, 3 * sizeof( u32 ), MeshletCompareTriangle );
+	dwFailures += memcmp( pSorted, pIndices, sizeof( u32 ) * dwIndexCount ) == 0 ? 0 : 1;
+
+	//eyes 64mm apart 3m out and 1m up, looking down -z and a bit down, the torus half size, stood up 30 degrees and 2m in front
+	ovrFovPort fov;
+	fov.UpTan = 0.6f;
+	fov.DownTan = 0.6f;
+	fov.LeftTan = 0.6f;
+	fov.RightTan = 0.6f;
+	Quatf qEyeRot;
+	Vec3f vPitchAxis = { 1.0f, 0.0f, 0.0f };
+	InitUnitQuatf( &qEyeRot, -0.3f, &vPitchAxis );
+	CullFrustum frustums[ovrEye_Count];
+	Vec3f vEyes[ovrEye_Count] = { { -0.032f, 1.0f, 3.0f }, { 0.032f, 1.0f, 3.0f } };
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		InitCullFrustumFromFov( &frustums[dwEye], fov, &qEyeRot, &vEyes[dwEye], EYE_NEAR_PLANE, 0.0f );
+	}
+	Mat4f mWorld, mScale, mRot;
+	Vec3f vTiltAxis = { 1.0f, 0.0f, 0.0f };
+	InitRotArbAxisMat4f( &mRot, &vTiltAxis, 30.0f );
+	InitMat4f( &mScale );
+	mScale.m[0][0] = 0.5f;
+	mScale.m[1][1] = 0.5f;
+	mScale.m[2][2] = 0.5f;
+	Mat4fMult( &mScale, &mRot, &mWorld );
+	mWorld.m[3][0] = 0.0f;
+	mWorld.m[3][1] = 0.0f;
+	mWorld.m[3][2] = 1.0f;
+
+	MeshletCullParams params;
+	u32 dwCapacity = mesh.dwNumMeshlets;
+	MeshletRange *pRanges = (MeshletRange*)malloc( sizeof( MeshletRange ) * 3 * ovrEye_Count * dwCapacity );
+	u8 *pCovered = (u8*)malloc( dwIndexCount / 3 );
+	if( !pRanges || !pCovered )
+	{
+		printf( "Meshlets: out of memory\n" );
+		free( pRanges );
+		free( pCovered );
+		free( pVertices );
+		DestroyMeshletMesh( &mesh );
+		return 1;
+	}
+	MeshletRange *pEmulated = pRanges + ( ovrEye_Count * dwCapacity );
+	u32 dwNumRanges[ovrEye_Count];
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwIteration = 0; dwIteration < dwIterations; ++dwIteration )
+	{
+		MeshletCullSetView( &params, frustums, vEyes, &mWorld, mesh.dwNumMeshlets, dwCapacity );
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			dwNumRanges[dwEye] = MeshletCull( &mesh, &params, dwEye, &pRanges[dwEye * dwCapacity] );
+		}
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fCullUs = ( 1000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwIterations );
+
+	u32 dwCounts[ovrEye_Count];
+	MeshletCullEmulate( &mesh, &params, pEmulated, dwCounts );
+	u32 dwKeptTris[ovrEye_Count];
+	u32 dwFrontTris[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		MeshletRange *pEyeRanges = &pRanges[dwEye * dwCapacity];
+		MeshletRange *pEyeEmulated = &pEmulated[dwEye * dwCapacity];
+		dwFailures += dwCounts[dwEye] == dwNumRanges[dwEye] ? 0 : 1;
+		qsort( pEyeEmulated, dwCounts[dwEye] < dwCapacity ? dwCounts[dwEye] : dwCapacity, sizeof( MeshletRange ), MeshletCompareRange );
+		dwFailures += dwCounts[dwEye] == dwNumRanges[dwEye] && memcmp( pEyeEmulated, pEyeRanges, sizeof( MeshletRange ) * dwNumRanges[dwEye] ) == 0 ? 0 : 1;
+
+		memset( pCovered, 0, dwIndexCount / 3 );
+		dwKeptTris[dwEye] = 0;
+		for( u32 dwRange = 0; dwRange < dwNumRanges[dwEye]; ++dwRange )
+		{
+			dwFailures += pEyeRanges[dwRange].dwIndexCount % 3 == 0 && pEyeRanges[dwRange].dwFirstIndex + pEyeRanges[dwRange].dwIndexCount <= dwIndexCount ? 0 : 1;
+			memset( pCovered + ( pEyeRanges[dwRange].dwFirstIndex / 3 ), 1, pEyeRanges[dwRange].dwIndexCount / 3 );
+			dwKeptTris[dwEye] += pEyeRanges[dwRange].dwIndexCount / 3;
+		}
+		//what the rasterizer would keep of the whole mesh, it all has to be in a range
+		dwFrontTris[dwEye] = 0;
+		for( u32 dwTri = 0; dwTri < dwIndexCount / 3; ++dwTri )
+		{
+			Vec3f vWorld[3];
+			for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+			{
+				Vec3f *pPos = &pVertices[mesh.pIndices[( dwTri * 3 ) + dwCorner]];
+				for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+				{
+					vWorld[dwCorner].v[dwAxis] = ( pPos->x * mWorld.m[0][dwAxis] ) + ( pPos->y * mWorld.m[1][dwAxis] ) + ( pPos->z * mWorld.m[2][dwAxis] ) + mWorld.m[3][dwAxis];
+				}
+			}
+			Vec3f vNormal, vToTri;
+			MeshletFaceNormal( &vWorld[0], &vWorld[1], &vWorld[2], &vNormal );
+			Vec3fSub( &vWorld[0], &vEyes[dwEye], &vToTri );
+			Vec3f vCentroid = { ( vWorld[0].x + vWorld[1].x + vWorld[2].x ) / 3.0f, ( vWorld[0].y + vWorld[1].y + vWorld[2].y ) / 3.0f,
+				( vWorld[0].z + vWorld[1].z + vWorld[2].z ) / 3.0f };
+			if( Vec3fDot( &vNormal, &vToTri ) < 0.0f && CullSphereInFrustum( &frustums[dwEye], vCentroid.x, vCentroid.y, vCentroid.z, 0.0f ) )
+			{
+				++dwFrontTris[dwEye];
+				dwFailures += pCovered[dwTri] ? 0 : 1;
+			}
+		}
+	}
+
+	MeshletMesh emptyMesh;
+	if( InitMeshletMesh( &emptyMesh, 0 ) )
+	{
+		dwFailures += BuildMeshlets( &emptyMesh, (const u8*)pVertices, sizeof( Vec3f ), 0, pIndices, 0 ) && emptyMesh.dwNumMeshlets == 0 ? 0 : 1;
+		MeshletCullSetView( &params, frustums, vEyes, &mWorld, emptyMesh.dwNumMeshlets, dwCapacity );
+		dwCounts[0] = dwCounts[1] = 0xFFFFFFFF;
+		MeshletCullEmulate( &emptyMesh, &params, pEmulated, dwCounts );
+		dwFailures += MeshletCull( &emptyMesh, &params, ovrEye_Left, pRanges ) == 0 && dwCounts[0] == 0 && dwCounts[1] == 0 ? 0 : 1;
+		DestroyMeshletMesh( &emptyMesh );
+	}
+	else
+	{
+		++dwFailures;
+	}
+
+	printf( "Meshlets: %u triangles in %u meshlets (%.1f triangles, %u with a cone), built in %.1fms\n", dwIndexCount / 3, mesh.dwNumMeshlets,
+		(f64)dwIndexCount / ( 3.0 * mesh.dwNumMeshlets ), dwNumCones, fBuildMs );
+	printf( "Meshlets cull: left %u ranges %u triangles, right %u ranges %u triangles (%u/%u front facing in view), both eyes %.1fus, %u failures\n",
+		dwNumRanges[0], dwKeptTris[0], dwNumRanges[1], dwKeptTris[1], dwFrontTris[0], dwFrontTris[1], fCullUs, dwFailures );
+	free( pRanges );
+	free( pCovered );
+	free( pVertices );
+	DestroyMeshletMesh( &mesh );
+	return dwFailures;
+}
+#endif
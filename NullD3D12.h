@@ -0,0 +1,799 @@
+//Null D3D12, just enough of d3d12.h for Tests.cpp to build the modules and run their CPU side without a GPU or the Windows SDK
+//the device hands out objects that only keep the state the tests look at: resources are plain memory, fences are signaled the moment
+//the queue is asked to, and command lists ignore everything except timestamp queries, which read a clock the test moves forward
+//names and layouts follow d3d12.h so the modules build unchanged, methods are plain members instead of COM vtables
+
+#if !_WIN32
+typedef int32_t HRESULT;
+#define S_OK ( (HRESULT)0 )
+#define E_FAIL ( (HRESULT)0x80004005 )
+#define E_OUTOFMEMORY ( (HRESULT)0x8007000E )
+#define E_INVALIDARG ( (HRESULT)0x80070057 )
+#define E_NOINTERFACE ( (HRESULT)0x80004002 )
+#define SUCCEEDED( hr ) ( ( (HRESULT)( hr ) ) >= 0 )
+#define FAILED( hr ) ( ( (HRESULT)( hr ) ) < 0 )
+
+typedef struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+} GUID;
+typedef const GUID &REFIID;
+#endif
+
+#ifdef IID_PPV_ARGS
+#undef IID_PPV_ARGS
+#endif
+#define IID_PPV_ARGS( ppType ) GUID(), reinterpret_cast<void**>( ppType ) //there's only one kind of each object, the iid isn't needed
+
+typedef uint64_t D3D12_GPU_VIRTUAL_ADDRESS;
+
+typedef enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_R8_UINT = 62,
+} DXGI_FORMAT;
+
+typedef struct DXGI_SAMPLE_DESC
+{
+	uint32_t Count;
+	uint32_t Quality;
+} DXGI_SAMPLE_DESC;
+
+typedef struct D3D12_RANGE
+{
+	size_t Begin;
+	size_t End;
+} D3D12_RANGE;
+
+//Queries
+typedef enum D3D12_QUERY_HEAP_TYPE
+{
+	D3D12_QUERY_HEAP_TYPE_OCCLUSION = 0,
+	D3D12_QUERY_HEAP_TYPE_TIMESTAMP = 1,
+} D3D12_QUERY_HEAP_TYPE;
+
+typedef enum D3D12_QUERY_TYPE
+{
+	D3D12_QUERY_TYPE_OCCLUSION = 0,
+	D3D12_QUERY_TYPE_BINARY_OCCLUSION = 1,
+	D3D12_QUERY_TYPE_TIMESTAMP = 2,
+} D3D12_QUERY_TYPE;
+
+typedef struct D3D12_QUERY_HEAP_DESC
+{
+	D3D12_QUERY_HEAP_TYPE Type;
+	uint32_t Count;
+	uint32_t NodeMask;
+} D3D12_QUERY_HEAP_DESC;
+
+//Resources
+typedef enum D3D12_HEAP_TYPE
+{
+	D3D12_HEAP_TYPE_DEFAULT = 1,
+	D3D12_HEAP_TYPE_UPLOAD = 2,
+	D3D12_HEAP_TYPE_READBACK = 3,
+} D3D12_HEAP_TYPE;
+
+typedef enum D3D12_CPU_PAGE_PROPERTY
+{
+	D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0,
+} D3D12_CPU_PAGE_PROPERTY;
+
+typedef enum D3D12_MEMORY_POOL
+{
+	D3D12_MEMORY_POOL_UNKNOWN = 0,
+} D3D12_MEMORY_POOL;
+
+typedef enum D3D12_HEAP_FLAGS
+{
+	D3D12_HEAP_FLAG_NONE = 0,
+} D3D12_HEAP_FLAGS;
+
+typedef struct D3D12_HEAP_PROPERTIES
+{
+	D3D12_HEAP_TYPE Type;
+	D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+	D3D12_MEMORY_POOL MemoryPoolPreference;
+	uint32_t CreationNodeMask;
+	uint32_t VisibleNodeMask;
+} D3D12_HEAP_PROPERTIES;
+
+typedef enum D3D12_RESOURCE_DIMENSION
+{
+	D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D12_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D12_RESOURCE_DIMENSION_TEXTURE2D = 3,
+} D3D12_RESOURCE_DIMENSION;
+
+typedef enum D3D12_TEXTURE_LAYOUT
+{
+	D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+	D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1,
+} D3D12_TEXTURE_LAYOUT;
+
+typedef enum D3D12_RESOURCE_FLAGS
+{
+	D3D12_RESOURCE_FLAG_NONE = 0,
+} D3D12_RESOURCE_FLAGS;
+
+typedef enum D3D12_RESOURCE_STATES
+{
+	D3D12_RESOURCE_STATE_COMMON = 0,
+	D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+	D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3,
+	D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE = 0x1000000,
+} D3D12_RESOURCE_STATES;
+
+typedef struct D3D12_RESOURCE_DESC
+{
+	D3D12_RESOURCE_DIMENSION Dimension;
+	uint64_t Alignment;
+	uint64_t Width;
+	uint32_t Height;
+	uint16_t DepthOrArraySize;
+	uint16_t MipLevels;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D12_TEXTURE_LAYOUT Layout;
+	D3D12_RESOURCE_FLAGS Flags;
+} D3D12_RESOURCE_DESC;
+
+typedef struct D3D12_CLEAR_VALUE D3D12_CLEAR_VALUE; //never filled in, only ever passed as nullptr
+
+struct ID3D12Resource
+{
+	u8 *pMemory;
+	u64 qwSize;
+
+	HRESULT Map( uint32_t dwSubresource, const D3D12_RANGE *a_pReadRange, void **a_ppData ) { *a_ppData = pMemory; return S_OK; }
+	void Unmap( uint32_t dwSubresource, const D3D12_RANGE *a_pWrittenRange ) {}
+	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() { return (D3D12_GPU_VIRTUAL_ADDRESS)(uintptr_t)pMemory; }
+	HRESULT SetName( const wchar_t *pName ) { return S_OK; }
+	uint32_t Release() { free( pMemory ); delete this; return 0; }
+};
+
+typedef struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	uint32_t SizeInBytes;
+	uint32_t StrideInBytes;
+} D3D12_VERTEX_BUFFER_VIEW;
+
+typedef struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	uint32_t SizeInBytes;
+	DXGI_FORMAT Format;
+} D3D12_INDEX_BUFFER_VIEW;
+
+//Indirect draws, a command signature only gets handed back to ExecuteIndirect
+typedef struct D3D12_DRAW_INDEXED_ARGUMENTS
+{
+	uint32_t IndexCountPerInstance;
+	uint32_t InstanceCount;
+	uint32_t StartIndexLocation;
+	int32_t BaseVertexLocation;
+	uint32_t StartInstanceLocation;
+} D3D12_DRAW_INDEXED_ARGUMENTS;
+
+struct ID3D12CommandSignature
+{
+	uint32_t Release() { delete this; return 0; }
+};
+
+//Copies and barriers, recorded into nothing
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 256
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 512
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+
+typedef struct D3D12_SUBRESOURCE_FOOTPRINT
+{
+	DXGI_FORMAT Format;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Depth;
+	uint32_t RowPitch;
+} D3D12_SUBRESOURCE_FOOTPRINT;
+
+typedef struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT
+{
+	uint64_t Offset;
+	D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+} D3D12_PLACED_SUBRESOURCE_FOOTPRINT;
+
+typedef enum D3D12_TEXTURE_COPY_TYPE
+{
+	D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX = 0,
+	D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT = 1,
+} D3D12_TEXTURE_COPY_TYPE;
+
+typedef struct D3D12_TEXTURE_COPY_LOCATION
+{
+	ID3D12Resource *pResource;
+	D3D12_TEXTURE_COPY_TYPE Type;
+	union
+	{
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT PlacedFootprint;
+		uint32_t SubresourceIndex;
+	};
+} D3D12_TEXTURE_COPY_LOCATION;
+
+typedef struct D3D12_BOX D3D12_BOX; //only ever passed as nullptr
+
+typedef enum D3D12_RESOURCE_BARRIER_TYPE
+{
+	D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+} D3D12_RESOURCE_BARRIER_TYPE;
+
+typedef enum D3D12_RESOURCE_BARRIER_FLAGS
+{
+	D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+} D3D12_RESOURCE_BARRIER_FLAGS;
+
+typedef struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+	ID3D12Resource *pResource;
+	uint32_t Subresource;
+	D3D12_RESOURCE_STATES StateBefore;
+	D3D12_RESOURCE_STATES StateAfter;
+} D3D12_RESOURCE_TRANSITION_BARRIER;
+
+typedef struct D3D12_RESOURCE_BARRIER
+{
+	D3D12_RESOURCE_BARRIER_TYPE Type;
+	D3D12_RESOURCE_BARRIER_FLAGS Flags;
+	union
+	{
+		D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+	};
+} D3D12_RESOURCE_BARRIER;
+
+struct ID3D12QueryHeap
+{
+	u64 *pTimestamps;
+
+	HRESULT SetName( const wchar_t *pName ) { return S_OK; }
+	uint32_t Release() { free( pTimestamps ); delete this; return 0; }
+};
+
+typedef enum D3D12_FENCE_FLAGS
+{
+	D3D12_FENCE_FLAG_NONE = 0,
+} D3D12_FENCE_FLAGS;
+
+struct ID3D12Fence
+{
+	u64 qwCompletedValue;
+
+	u64 GetCompletedValue() { return qwCompletedValue; }
+	HRESULT SetName( const wchar_t *pName ) { return S_OK; }
+	uint32_t Release() { delete this; return 0; }
+};
+
+//Rasterizer state
+typedef struct D3D12_VIEWPORT
+{
+	f32 TopLeftX;
+	f32 TopLeftY;
+	f32 Width;
+	f32 Height;
+	f32 MinDepth;
+	f32 MaxDepth;
+} D3D12_VIEWPORT;
+
+typedef struct D3D12_RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+} D3D12_RECT;
+
+//Variable rate shading, the null device reports none so the rates only ever get built and checked on the CPU
+#define D3D12_SHADING_RATE_X_AXIS_SHIFT 2
+#define D3D12_SHADING_RATE_VALID_MASK 3
+#define D3D12_MAKE_COARSE_SHADING_RATE( x, y ) ( ( ( x ) << D3D12_SHADING_RATE_X_AXIS_SHIFT ) | ( y ) )
+#define D3D12_RS_SET_SHADING_RATE_COMBINER_COUNT 2
+
+typedef enum D3D12_SHADING_RATE
+{
+	D3D12_SHADING_RATE_1X1 = 0,
+	D3D12_SHADING_RATE_1X2 = 0x1,
+	D3D12_SHADING_RATE_2X1 = 0x4,
+	D3D12_SHADING_RATE_2X2 = 0x5,
+	D3D12_SHADING_RATE_2X4 = 0x6,
+	D3D12_SHADING_RATE_4X2 = 0x9,
+	D3D12_SHADING_RATE_4X4 = 0xa,
+} D3D12_SHADING_RATE;
+
+typedef enum D3D12_SHADING_RATE_COMBINER
+{
+	D3D12_SHADING_RATE_COMBINER_PASSTHROUGH = 0,
+	D3D12_SHADING_RATE_COMBINER_OVERRIDE = 1,
+} D3D12_SHADING_RATE_COMBINER;
+
+typedef enum D3D12_VARIABLE_SHADING_RATE_TIER
+{
+	D3D12_VARIABLE_SHADING_RATE_TIER_NOT_SUPPORTED = 0,
+	D3D12_VARIABLE_SHADING_RATE_TIER_1 = 1,
+	D3D12_VARIABLE_SHADING_RATE_TIER_2 = 2,
+} D3D12_VARIABLE_SHADING_RATE_TIER;
+
+typedef enum D3D12_FEATURE
+{
+	D3D12_FEATURE_D3D12_OPTIONS6 = 30,
+} D3D12_FEATURE;
+
+typedef struct D3D12_FEATURE_DATA_D3D12_OPTIONS6
+{
+	BOOL AdditionalShadingRatesSupported;
+	BOOL PerPrimitiveShadingRateSupportedWithViewportIndexing;
+	D3D12_VARIABLE_SHADING_RATE_TIER VariableShadingRateTier;
+	uint32_t ShadingRateImageTileSize;
+	BOOL BackgroundProcessingSupported;
+} D3D12_FEATURE_DATA_D3D12_OPTIONS6;
+
+//Pipelines, the descs are only hashed and copied, a pso is an empty object
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D12_DEFAULT_DEPTH_BIAS 0
+#define D3D12_DEFAULT_DEPTH_BIAS_CLAMP 0.0f
+#define D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS 0.0f
+#define D3D12_DEFAULT_STENCIL_READ_MASK 0xff
+#define D3D12_DEFAULT_STENCIL_WRITE_MASK 0xff
+
+typedef enum D3D12_BLEND
+{
+	D3D12_BLEND_ZERO = 1,
+	D3D12_BLEND_ONE = 2,
+	D3D12_BLEND_SRC_ALPHA = 5,
+	D3D12_BLEND_INV_SRC_ALPHA = 6,
+} D3D12_BLEND;
+
+typedef enum D3D12_BLEND_OP
+{
+	D3D12_BLEND_OP_ADD = 1,
+} D3D12_BLEND_OP;
+
+typedef enum D3D12_LOGIC_OP
+{
+	D3D12_LOGIC_OP_CLEAR = 0,
+	D3D12_LOGIC_OP_NOOP = 4,
+} D3D12_LOGIC_OP;
+
+typedef enum D3D12_COLOR_WRITE_ENABLE
+{
+	D3D12_COLOR_WRITE_ENABLE_ALL = 15,
+} D3D12_COLOR_WRITE_ENABLE;
+
+typedef enum D3D12_FILL_MODE
+{
+	D3D12_FILL_MODE_WIREFRAME = 2,
+	D3D12_FILL_MODE_SOLID = 3,
+} D3D12_FILL_MODE;
+
+typedef enum D3D12_CULL_MODE
+{
+	D3D12_CULL_MODE_NONE = 1,
+	D3D12_CULL_MODE_FRONT = 2,
+	D3D12_CULL_MODE_BACK = 3,
+} D3D12_CULL_MODE;
+
+typedef enum D3D12_CONSERVATIVE_RASTERIZATION_MODE
+{
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF = 0,
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON = 1,
+} D3D12_CONSERVATIVE_RASTERIZATION_MODE;
+
+typedef enum D3D12_DEPTH_WRITE_MASK
+{
+	D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D12_DEPTH_WRITE_MASK_ALL = 1,
+} D3D12_DEPTH_WRITE_MASK;
+
+typedef enum D3D12_COMPARISON_FUNC
+{
+	D3D12_COMPARISON_FUNC_NEVER = 1,
+	D3D12_COMPARISON_FUNC_LESS = 2,
+	D3D12_COMPARISON_FUNC_EQUAL = 3,
+	D3D12_COMPARISON_FUNC_LESS_EQUAL = 4,
+	D3D12_COMPARISON_FUNC_GREATER = 5,
+	D3D12_COMPARISON_FUNC_NOT_EQUAL = 6,
+	D3D12_COMPARISON_FUNC_GREATER_EQUAL = 7,
+	D3D12_COMPARISON_FUNC_ALWAYS = 8,
+} D3D12_COMPARISON_FUNC;
+
+typedef enum D3D12_STENCIL_OP
+{
+	D3D12_STENCIL_OP_KEEP = 1,
+} D3D12_STENCIL_OP;
+
+typedef enum D3D12_INPUT_CLASSIFICATION
+{
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1,
+} D3D12_INPUT_CLASSIFICATION;
+
+typedef enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE
+{
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED = 0,
+} D3D12_INDEX_BUFFER_STRIP_CUT_VALUE;
+
+typedef enum D3D12_PRIMITIVE_TOPOLOGY_TYPE
+{
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3,
+} D3D12_PRIMITIVE_TOPOLOGY_TYPE;
+
+typedef enum D3D12_PIPELINE_STATE_FLAGS
+{
+	D3D12_PIPELINE_STATE_FLAG_NONE = 0,
+} D3D12_PIPELINE_STATE_FLAGS;
+
+typedef struct D3D12_SHADER_BYTECODE
+{
+	const void *pShaderBytecode;
+	size_t BytecodeLength;
+} D3D12_SHADER_BYTECODE;
+
+typedef struct D3D12_SO_DECLARATION_ENTRY
+{
+	uint32_t Stream;
+	const char *SemanticName;
+	uint32_t SemanticIndex;
+	uint8_t StartComponent;
+	uint8_t ComponentCount;
+	uint8_t OutputSlot;
+} D3D12_SO_DECLARATION_ENTRY;
+
+typedef struct D3D12_STREAM_OUTPUT_DESC
+{
+	const D3D12_SO_DECLARATION_ENTRY *pSODeclaration;
+	uint32_t NumEntries;
+	const uint32_t *pBufferStrides;
+	uint32_t NumStrides;
+	uint32_t RasterizedStream;
+} D3D12_STREAM_OUTPUT_DESC;
+
+typedef struct D3D12_RENDER_TARGET_BLEND_DESC
+{
+	BOOL BlendEnable;
+	BOOL LogicOpEnable;
+	D3D12_BLEND SrcBlend;
+	D3D12_BLEND DestBlend;
+	D3D12_BLEND_OP BlendOp;
+	D3D12_BLEND SrcBlendAlpha;
+	D3D12_BLEND DestBlendAlpha;
+	D3D12_BLEND_OP BlendOpAlpha;
+	D3D12_LOGIC_OP LogicOp;
+	uint8_t RenderTargetWriteMask;
+} D3D12_RENDER_TARGET_BLEND_DESC;
+
+typedef struct D3D12_BLEND_DESC
+{
+	BOOL AlphaToCoverageEnable;
+	BOOL IndependentBlendEnable;
+	D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+} D3D12_BLEND_DESC;
+
+typedef struct D3D12_RASTERIZER_DESC
+{
+	D3D12_FILL_MODE FillMode;
+	D3D12_CULL_MODE CullMode;
+	BOOL FrontCounterClockwise;
+	int32_t DepthBias;
+	float DepthBiasClamp;
+	float SlopeScaledDepthBias;
+	BOOL DepthClipEnable;
+	BOOL MultisampleEnable;
+	BOOL AntialiasedLineEnable;
+	uint32_t ForcedSampleCount;
+	D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster;
+} D3D12_RASTERIZER_DESC;
+
+typedef struct D3D12_DEPTH_STENCILOP_DESC
+{
+	D3D12_STENCIL_OP StencilFailOp;
+	D3D12_STENCIL_OP StencilDepthFailOp;
+	D3D12_STENCIL_OP StencilPassOp;
+	D3D12_COMPARISON_FUNC StencilFunc;
+} D3D12_DEPTH_STENCILOP_DESC;
+
+typedef struct D3D12_DEPTH_STENCIL_DESC
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	uint8_t StencilReadMask;
+	uint8_t StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+} D3D12_DEPTH_STENCIL_DESC;
+
+typedef struct D3D12_INPUT_ELEMENT_DESC
+{
+	const char *SemanticName;
+	uint32_t SemanticIndex;
+	DXGI_FORMAT Format;
+	uint32_t InputSlot;
+	uint32_t AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	uint32_t InstanceDataStepRate;
+} D3D12_INPUT_ELEMENT_DESC;
+
+typedef struct D3D12_INPUT_LAYOUT_DESC
+{
+	const D3D12_INPUT_ELEMENT_DESC *pInputElementDescs;
+	uint32_t NumElements;
+} D3D12_INPUT_LAYOUT_DESC;
+
+typedef struct D3D12_CACHED_PIPELINE_STATE
+{
+	const void *pCachedBlob;
+	size_t CachedBlobSizeInBytes;
+} D3D12_CACHED_PIPELINE_STATE;
+
+struct ID3D12RootSignature
+{
+	uint32_t Release() { delete this; return 0; }
+};
+
+typedef struct D3D12_GRAPHICS_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature *pRootSignature;
+	D3D12_SHADER_BYTECODE VS;
+	D3D12_SHADER_BYTECODE PS;
+	D3D12_SHADER_BYTECODE DS;
+	D3D12_SHADER_BYTECODE HS;
+	D3D12_SHADER_BYTECODE GS;
+	D3D12_STREAM_OUTPUT_DESC StreamOutput;
+	D3D12_BLEND_DESC BlendState;
+	uint32_t SampleMask;
+	D3D12_RASTERIZER_DESC RasterizerState;
+	D3D12_DEPTH_STENCIL_DESC DepthStencilState;
+	D3D12_INPUT_LAYOUT_DESC InputLayout;
+	D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue;
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType;
+	uint32_t NumRenderTargets;
+	DXGI_FORMAT RTVFormats[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+	DXGI_FORMAT DSVFormat;
+	DXGI_SAMPLE_DESC SampleDesc;
+	uint32_t NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+} D3D12_GRAPHICS_PIPELINE_STATE_DESC;
+
+typedef struct D3D12_COMPUTE_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature *pRootSignature;
+	D3D12_SHADER_BYTECODE CS;
+	uint32_t NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	D3D12_PIPELINE_STATE_FLAGS Flags;
+} D3D12_COMPUTE_PIPELINE_STATE_DESC;
+
+struct ID3D12PipelineState
+{
+	HRESULT SetName( const wchar_t *pName ) { return S_OK; }
+	uint32_t Release() { delete this; return 0; }
+};
+
+//Pipeline libraries, a library is the names stored in it and serializes to their count and the names, a load finds the name
+//but doesn't check the desc against what was stored, a blob that isn't exactly that layout is rejected like another driver's would be
+#define NULL_D3D12_MAX_LIBRARY_PIPELINES 64
+#define NULL_D3D12_LIBRARY_NAME_LENGTH 32
+
+struct ID3D12PipelineLibrary
+{
+	wchar_t names[NULL_D3D12_MAX_LIBRARY_PIPELINES][NULL_D3D12_LIBRARY_NAME_LENGTH];
+	uint32_t dwCount;
+
+	bool Contains( const wchar_t *pName )
+	{
+		for( uint32_t dwPipeline = 0; dwPipeline < dwCount; ++dwPipeline )
+		{
+			if( wcscmp( names[dwPipeline], pName ) == 0 )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	HRESULT StorePipeline( const wchar_t *pName, ID3D12PipelineState *a_pPipeline )
+	{
+		if( !pName || !a_pPipeline || Contains( pName ) || dwCount == NULL_D3D12_MAX_LIBRARY_PIPELINES || wcslen( pName ) >= NULL_D3D12_LIBRARY_NAME_LENGTH )
+		{
+			return E_INVALIDARG;
+		}
+		wcscpy( names[dwCount++], pName );
+		return S_OK;
+	}
+	HRESULT LoadPipeline( const wchar_t *pName, void **a_ppPipelineState )
+	{
+		if( !Contains( pName ) )
+		{
+			return E_INVALIDARG;
+		}
+		*a_ppPipelineState = new ID3D12PipelineState;
+		return S_OK;
+	}
+	HRESULT LoadGraphicsPipeline( const wchar_t *pName, const D3D12_GRAPHICS_PIPELINE_STATE_DESC *a_pDesc, REFIID riid, void **a_ppPipelineState ) { return LoadPipeline( pName, a_ppPipelineState ); }
+	HRESULT LoadComputePipeline( const wchar_t *pName, const D3D12_COMPUTE_PIPELINE_STATE_DESC *a_pDesc, REFIID riid, void **a_ppPipelineState ) { return LoadPipeline( pName, a_ppPipelineState ); }
+	size_t GetSerializedSize() { return sizeof( uint32_t ) + ( dwCount * sizeof( names[0] ) ); }
+	HRESULT Serialize( void *a_pData, size_t qwDataSizeInBytes )
+	{
+		if( qwDataSizeInBytes < GetSerializedSize() )
+		{
+			return E_INVALIDARG;
+		}
+		memcpy( a_pData, &dwCount, sizeof( uint32_t ) );
+		memcpy( (uint8_t*)a_pData + sizeof( uint32_t ), names, dwCount * sizeof( names[0] ) );
+		return S_OK;
+	}
+	uint32_t Release() { delete this; return 0; }
+};
+
+//Command lists, qwTimestamp is the GPU clock as of the commands recorded so far, the test advances it by however long they'd take.
+//state, draws, copies and barriers go nowhere, a list isn't a ID3D12GraphicsCommandList5 since the device has no VRS
+struct ID3D12GraphicsCommandList
+{
+	u64 qwTimestamp;
+
+	HRESULT QueryInterface( REFIID riid, void **a_ppCommandList ) { return E_NOINTERFACE; }
+	void EndQuery( ID3D12QueryHeap *a_pQueryHeap, D3D12_QUERY_TYPE type, uint32_t dwIndex ) { a_pQueryHeap->pTimestamps[dwIndex] = qwTimestamp; }
+	void ResolveQueryData( ID3D12QueryHeap *a_pQueryHeap, D3D12_QUERY_TYPE type, uint32_t dwStartIndex, uint32_t dwNumQueries, ID3D12Resource *a_pDestination, uint64_t qwAlignedDestinationBufferOffset )
+	{
+		memcpy( a_pDestination->pMemory + qwAlignedDestinationBufferOffset, &a_pQueryHeap->pTimestamps[dwStartIndex], sizeof(u64) * dwNumQueries );
+	}
+	void SetPipelineState( ID3D12PipelineState *a_pPipelineState ) {}
+	void SetGraphicsRootSignature( ID3D12RootSignature *a_pRootSignature ) {}
+	void SetGraphicsRoot32BitConstant( uint32_t dwRootParameterIndex, uint32_t dwSrcData, uint32_t dwDestOffsetIn32BitValues ) {}
+	void SetGraphicsRoot32BitConstants( uint32_t dwRootParameterIndex, uint32_t dwNum32BitValuesToSet, const void *a_pSrcData, uint32_t dwDestOffsetIn32BitValues ) {}
+	void SetGraphicsRootConstantBufferView( uint32_t dwRootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS qwBufferLocation ) {}
+	void SetGraphicsRootShaderResourceView( uint32_t dwRootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS qwBufferLocation ) {}
+	void IASetVertexBuffers( uint32_t dwStartSlot, uint32_t dwNumViews, const D3D12_VERTEX_BUFFER_VIEW *a_pViews ) {}
+	void IASetIndexBuffer( const D3D12_INDEX_BUFFER_VIEW *a_pView ) {}
+	void RSSetViewports( uint32_t dwNumViewports, const D3D12_VIEWPORT *a_pViewports ) {}
+	void RSSetScissorRects( uint32_t dwNumRects, const D3D12_RECT *a_pRects ) {}
+	void DrawIndexedInstanced( uint32_t dwIndexCountPerInstance, uint32_t dwInstanceCount, uint32_t dwStartIndexLocation, int32_t iBaseVertexLocation, uint32_t dwStartInstanceLocation ) {}
+	void ExecuteIndirect( ID3D12CommandSignature *a_pCommandSignature, uint32_t dwMaxCommandCount, ID3D12Resource *a_pArgumentBuffer, uint64_t qwArgumentBufferOffset,
+		ID3D12Resource *a_pCountBuffer, uint64_t qwCountBufferOffset ) {}
+	void CopyTextureRegion( const D3D12_TEXTURE_COPY_LOCATION *a_pDst, uint32_t dwDstX, uint32_t dwDstY, uint32_t dwDstZ, const D3D12_TEXTURE_COPY_LOCATION *a_pSrc, const D3D12_BOX *a_pSrcBox ) {}
+	void ResourceBarrier( uint32_t dwNumBarriers, const D3D12_RESOURCE_BARRIER *a_pBarriers ) {}
+};
+
+struct ID3D12GraphicsCommandList5 : ID3D12GraphicsCommandList
+{
+	void RSSetShadingRate( D3D12_SHADING_RATE baseShadingRate, const D3D12_SHADING_RATE_COMBINER *a_pCombiners ) {}
+	void RSSetShadingRateImage( ID3D12Resource *a_pShadingRateImage ) {}
+};
+
+//Queue, everything executed is done by the time the call returns
+struct ID3D12CommandQueue
+{
+	u64 qwTimestampFrequency;
+	u64 qwTimestamp; //the GPU clock GetClockCalibration pairs with the CPU's
+
+	HRESULT GetTimestampFrequency( u64 *a_pFrequency ) { *a_pFrequency = qwTimestampFrequency; return S_OK; }
+	HRESULT GetClockCalibration( u64 *a_pGpuTimestamp, u64 *a_pCpuTimestamp )
+	{
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter( &counter );
+		*a_pGpuTimestamp = qwTimestamp;
+		*a_pCpuTimestamp = (u64)counter.QuadPart;
+		return S_OK;
+	}
+	HRESULT Signal( ID3D12Fence *a_pFence, u64 qwValue ) { a_pFence->qwCompletedValue = qwValue; return S_OK; }
+};
+
+struct ID3D12Device1;
+
+struct ID3D12Device
+{
+	uint8_t bDevice1 = 0; //set by ID3D12Device1, what QueryInterface hands out
+
+	HRESULT QueryInterface( REFIID riid, void **a_ppDevice );
+	//no optional features, every field zero
+	HRESULT CheckFeatureSupport( D3D12_FEATURE feature, void *a_pFeatureSupportData, uint32_t dwFeatureSupportDataSize )
+	{
+		memset( a_pFeatureSupportData, 0, dwFeatureSupportDataSize );
+		return S_OK;
+	}
+	HRESULT CreateQueryHeap( const D3D12_QUERY_HEAP_DESC *a_pDesc, REFIID riid, void **a_ppHeap )
+	{
+		ID3D12QueryHeap *pHeap = new ID3D12QueryHeap;
+		pHeap->pTimestamps = (u64*)calloc( a_pDesc->Count, sizeof(u64) );
+		if( !pHeap->pTimestamps )
+		{
+			delete pHeap;
+			return E_OUTOFMEMORY;
+		}
+		*a_ppHeap = pHeap;
+		return S_OK;
+	}
+	//buffers only
+	HRESULT CreateCommittedResource( const D3D12_HEAP_PROPERTIES *a_pHeapProperties, D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC *a_pDesc, D3D12_RESOURCE_STATES initialState,
+		const D3D12_CLEAR_VALUE *a_pOptimizedClearValue, REFIID riid, void **a_ppResource )
+	{
+		if( a_pDesc->Dimension != D3D12_RESOURCE_DIMENSION_BUFFER )
+		{
+			return E_FAIL;
+		}
+		ID3D12Resource *pResource = new ID3D12Resource;
+		pResource->qwSize = a_pDesc->Width;
+		pResource->pMemory = (u8*)calloc( 1, a_pDesc->Width );
+		if( !pResource->pMemory )
+		{
+			delete pResource;
+			return E_OUTOFMEMORY;
+		}
+		*a_ppResource = pResource;
+		return S_OK;
+	}
+	HRESULT CreateFence( u64 qwInitialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void **a_ppFence )
+	{
+		ID3D12Fence *pFence = new ID3D12Fence;
+		pFence->qwCompletedValue = qwInitialValue;
+		*a_ppFence = pFence;
+		return S_OK;
+	}
+	HRESULT CreateGraphicsPipelineState( const D3D12_GRAPHICS_PIPELINE_STATE_DESC *a_pDesc, REFIID riid, void **a_ppPipelineState )
+	{
+		*a_ppPipelineState = new ID3D12PipelineState;
+		return S_OK;
+	}
+	HRESULT CreateComputePipelineState( const D3D12_COMPUTE_PIPELINE_STATE_DESC *a_pDesc, REFIID riid, void **a_ppPipelineState )
+	{
+		*a_ppPipelineState = new ID3D12PipelineState;
+		return S_OK;
+	}
+};
+
+//the same device, the test owns it so releasing what QueryInterface returned does nothing
+struct ID3D12Device1 : ID3D12Device
+{
+	ID3D12Device1() { bDevice1 = 1; }
+
+	HRESULT CreatePipelineLibrary( const void *a_pLibraryBlob, size_t qwBlobLength, REFIID riid, void **a_ppPipelineLibrary )
+	{
+		ID3D12PipelineLibrary *pLibrary = new ID3D12PipelineLibrary;
+		pLibrary->dwCount = 0;
+		if( qwBlobLength )
+		{
+			if( qwBlobLength >= sizeof( uint32_t ) )
+			{
+				memcpy( &pLibrary->dwCount, a_pLibraryBlob, sizeof( uint32_t ) );
+			}
+			if( qwBlobLength < sizeof( uint32_t ) || pLibrary->dwCount > NULL_D3D12_MAX_LIBRARY_PIPELINES || qwBlobLength != pLibrary->GetSerializedSize() )
+			{
+				delete pLibrary;
+				return E_INVALIDARG;
+			}
+			memcpy( pLibrary->names, (const uint8_t*)a_pLibraryBlob + sizeof( uint32_t ), pLibrary->dwCount * sizeof( pLibrary->names[0] ) );
+		}
+		*a_ppPipelineLibrary = pLibrary;
+		return S_OK;
+	}
+	uint32_t Release() { return 1; }
+};
+
+inline
+HRESULT ID3D12Device::QueryInterface( REFIID riid, void **a_ppDevice )
+{
+	if( !bDevice1 )
+	{
+		return E_NOINTERFACE;
+	}
+	*a_ppDevice = static_cast<ID3D12Device1*>( this );
+	return S_OK;
+}
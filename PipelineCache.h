@@ -0,0 +1,726 @@
+//Pipeline state cache, every pso is named by a hash of what it is built from (root signature blob, shader bytecode, states, input layout)
+//and looked up in an ID3D12PipelineLibrary that gets serialized to disk, so only the first launch (or a new driver) pays for compiling
+//misses are compiled on the workers, the library and the file are only touched from the calling thread
+//without a device (the null backend) it only hashes and reads/writes files, which is all the benchmark needs
+//https://learn.microsoft.com/en-us/windows/win32/direct3d12/pipeline-state-cache
+
+#define PIPELINE_CACHE_MAX_PIPELINES 32
+#define PIPELINE_CACHE_FILE_MAGIC 0x4F53504F //"OPSO"
+#define PIPELINE_CACHE_FILE_VERSION 1
+#define PIPELINE_CACHE_NAME_LENGTH 17 //16 hex digits and the terminator
+#define HASH_FNV_OFFSET 0xcbf29ce484222325ull
+#define HASH_FNV_PRIME 0x100000001b3ull
+
+//field by field, hashing a whole desc would also hash its padding and the pointers in it
+#define PIPELINE_HASH_FIELD( qwHash, field ) ( qwHash ) = HashFnv1a( ( qwHash ), &( field ), sizeof( field ) )
+
+typedef struct PipelineCacheFileHeader
+{
+	u32 dwMagic;
+	u32 dwVersion;
+	u64 qwLibrarySize;
+	u64 qwLibraryHash; //a torn or truncated write is caught here instead of by the driver
+} PipelineCacheFileHeader;
+
+typedef struct PipelineCacheEntry
+{
+	//the desc points into the caller's input layout, bytecode and root signature, they have to live until PipelineCacheBuild
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDesc;
+	D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc;
+	ID3D12PipelineState **ppPipeline;
+	const char *pName; //for errors
+	u64 qwHash;
+	wchar_t name[PIPELINE_CACHE_NAME_LENGTH];
+	HRESULT hr;
+	u8 bCompute;
+	u8 bLoaded;
+} PipelineCacheEntry;
+
+typedef struct PipelineCache
+{
+	ID3D12Device *pDevice; //null is the null backend, nothing gets created
+	ID3D12PipelineLibrary *pLibrary; //null without ID3D12Device1, then every pso is compiled every launch
+	void *pFileData; //the library keeps reading from what it was created with, freed with it
+	PipelineCacheEntry entries[PIPELINE_CACHE_MAX_PIPELINES];
+	u32 dwCount;
+	u32 dwNumBuilt; //entries before this are done, later adds get built by the next PipelineCacheBuild
+	u32 dwNumLoaded;
+	u32 dwNumCompiled;
+	f64 fOpenMs;
+	f64 fLoadMs;
+	f64 fCompileMs;
+	f64 fStoreMs;
+	u8 bFileRejected; //there was a file but it was corrupt or the driver didn't take it
+	u8 bDirty; //the library has pipelines the file doesn't
+} PipelineCache;
+
+PipelineCache pipelineCache;
+
+inline
+u64 HashFnv1a( u64 qwHash, const void *a_pData, u64 qwSize )
+{
+	const u8 *pBytes = (const u8*)a_pData;
+	for( u64 qwByte = 0; qwByte < qwSize; ++qwByte )
+	{
+		qwHash = ( qwHash ^ pBytes[qwByte] ) * HASH_FNV_PRIME;
+	}
+	return qwHash;
+}
+
+inline
+u64 HashString( u64 qwHash, const char *pString )
+{
+	return HashFnv1a( qwHash, pString, pString ? strlen( pString ) + 1 : 0 );
+}
+
+inline
+u64 HashShaderBytecode( u64 qwHash, D3D12_SHADER_BYTECODE *a_pBytecode )
+{
+	PIPELINE_HASH_FIELD( qwHash, a_pBytecode->BytecodeLength );
+	return HashFnv1a( qwHash, a_pBytecode->pShaderBytecode, a_pBytecode->BytecodeLength );
+}
+
+inline
+u64 HashDepthStencilOp( u64 qwHash, D3D12_DEPTH_STENCILOP_DESC *a_pOp )
+{
+	PIPELINE_HASH_FIELD( qwHash, a_pOp->StencilFailOp );
+	PIPELINE_HASH_FIELD( qwHash, a_pOp->StencilDepthFailOp );
+	PIPELINE_HASH_FIELD( qwHash, a_pOp->StencilPassOp );
+	PIPELINE_HASH_FIELD( qwHash, a_pOp->StencilFunc );
+	return qwHash;
+}
+
+//everything but pRootSignature (its serialized blob stands in for it) and CachedPSO
+inline
+u64 HashGraphicsPipelineDesc( D3D12_GRAPHICS_PIPELINE_STATE_DESC *a_pDesc, const void *a_pRootSignatureBlob, u64 qwRootSignatureSize )
+{
+	u64 qwHash = HashFnv1a( HASH_FNV_OFFSET, a_pRootSignatureBlob, qwRootSignatureSize );
+	qwHash = HashShaderBytecode( qwHash, &a_pDesc->VS );
+	qwHash = HashShaderBytecode( qwHash, &a_pDesc->PS );
+	qwHash = HashShaderBytecode( qwHash, &a_pDesc->DS );
+	qwHash = HashShaderBytecode( qwHash, &a_pDesc->HS );
+	qwHash = HashShaderBytecode( qwHash, &a_pDesc->GS );
+
+	D3D12_STREAM_OUTPUT_DESC *pStreamOutput = &a_pDesc->StreamOutput;
+	PIPELINE_HASH_FIELD( qwHash, pStreamOutput->NumEntries );
+	for( u32 dwEntry = 0; dwEntry < pStreamOutput->NumEntries; ++dwEntry )
+	{
+		const D3D12_SO_DECLARATION_ENTRY *pEntry = &pStreamOutput->pSODeclaration[dwEntry];
+		PIPELINE_HASH_FIELD( qwHash, pEntry->Stream );
+		qwHash = HashString( qwHash, pEntry->SemanticName );
+		PIPELINE_HASH_FIELD( qwHash, pEntry->SemanticIndex );
+		PIPELINE_HASH_FIELD( qwHash, pEntry->StartComponent );
+		PIPELINE_HASH_FIELD( qwHash, pEntry->ComponentCount );
+		PIPELINE_HASH_FIELD( qwHash, pEntry->OutputSlot );
+	}
+	PIPELINE_HASH_FIELD( qwHash, pStreamOutput->NumStrides );
+	qwHash = HashFnv1a( qwHash, pStreamOutput->pBufferStrides, pStreamOutput->NumStrides * sizeof( u32 ) );
+	PIPELINE_HASH_FIELD( qwHash, pStreamOutput->RasterizedStream );
+
+	D3D12_BLEND_DESC *pBlend = &a_pDesc->BlendState;
+	PIPELINE_HASH_FIELD( qwHash, pBlend->AlphaToCoverageEnable );
+	PIPELINE_HASH_FIELD( qwHash, pBlend->IndependentBlendEnable );
+	for( u32 dwRenderTarget = 0; dwRenderTarget < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++dwRenderTarget )
+	{
+		D3D12_RENDER_TARGET_BLEND_DESC *pTarget = &pBlend->RenderTarget[dwRenderTarget];
+		PIPELINE_HASH_FIELD( qwHash, pTarget->BlendEnable );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->LogicOpEnable );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->SrcBlend );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->DestBlend );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->BlendOp );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->SrcBlendAlpha );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->DestBlendAlpha );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->BlendOpAlpha );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->LogicOp );
+		PIPELINE_HASH_FIELD( qwHash, pTarget->RenderTargetWriteMask );
+	}
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->SampleMask );
+
+	D3D12_RASTERIZER_DESC *pRasterizer = &a_pDesc->RasterizerState;
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->FillMode );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->CullMode );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->FrontCounterClockwise );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->DepthBias );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->DepthBiasClamp );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->SlopeScaledDepthBias );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->DepthClipEnable );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->MultisampleEnable );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->AntialiasedLineEnable );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->ForcedSampleCount );
+	PIPELINE_HASH_FIELD( qwHash, pRasterizer->ConservativeRaster );
+
+	D3D12_DEPTH_STENCIL_DESC *pDepthStencil = &a_pDesc->DepthStencilState;
+	PIPELINE_HASH_FIELD( qwHash, pDepthStencil->DepthEnable );
+	PIPELINE_HASH_FIELD( qwHash, pDepthStencil->DepthWriteMask );
+	PIPELINE_HASH_FIELD( qwHash, pDepthStencil->DepthFunc );
+	PIPELINE_HASH_FIELD( qwHash, pDepthStencil->StencilEnable );
+	PIPELINE_HASH_FIELD( qwHash, pDepthStencil->StencilReadMask );
+	PIPELINE_HASH_FIELD( qwHash, pDepthStencil->StencilWriteMask );
+	qwHash = HashDepthStencilOp( qwHash, &pDepthStencil->FrontFace );
+	qwHash = HashDepthStencilOp( qwHash, &pDepthStencil->BackFace );
+
+	D3D12_INPUT_LAYOUT_DESC *pInputLayout = &a_pDesc->InputLayout;
+	PIPELINE_HASH_FIELD( qwHash, pInputLayout->NumElements );
+	for( u32 dwElement = 0; dwElement < pInputLayout->NumElements; ++dwElement )
+	{
+		const D3D12_INPUT_ELEMENT_DESC *pElement = &pInputLayout->pInputElementDescs[dwElement];
+		qwHash = HashString( qwHash, pElement->SemanticName );
+		PIPELINE_HASH_FIELD( qwHash, pElement->SemanticIndex );
+		PIPELINE_HASH_FIELD( qwHash, pElement->Format );
+		PIPELINE_HASH_FIELD( qwHash, pElement->InputSlot );
+		PIPELINE_HASH_FIELD( qwHash, pElement->AlignedByteOffset );
+		PIPELINE_HASH_FIELD( qwHash, pElement->InputSlotClass );
+		PIPELINE_HASH_FIELD( qwHash, pElement->InstanceDataStepRate );
+	}
+
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->IBStripCutValue );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->PrimitiveTopologyType );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->NumRenderTargets );
+	for( u32 dwRenderTarget = 0; dwRenderTarget < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++dwRenderTarget )
+	{
+		PIPELINE_HASH_FIELD( qwHash, a_pDesc->RTVFormats[dwRenderTarget] );
+	}
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->DSVFormat );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->SampleDesc.Count );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->SampleDesc.Quality );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->NodeMask );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->Flags );
+	return qwHash;
+}
+
+inline
+u64 HashComputePipelineDesc( D3D12_COMPUTE_PIPELINE_STATE_DESC *a_pDesc, const void *a_pRootSignatureBlob, u64 qwRootSignatureSize )
+{
+	u64 qwHash = HashFnv1a( HASH_FNV_OFFSET, a_pRootSignatureBlob, qwRootSignatureSize );
+	u8 bCompute = 1; //so a compute pso can never share a name with a graphics one
+	PIPELINE_HASH_FIELD( qwHash, bCompute );
+	qwHash = HashShaderBytecode( qwHash, &a_pDesc->CS );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->NodeMask );
+	PIPELINE_HASH_FIELD( qwHash, a_pDesc->Flags );
+	return qwHash;
+}
+
+inline
+void PipelineCacheName( u64 qwHash, wchar_t *a_pName )
+{
+	const char *pDigits = "0123456789abcdef";
+	for( u32 dwDigit = 0; dwDigit < PIPELINE_CACHE_NAME_LENGTH - 1; ++dwDigit )
+	{
+		a_pName[dwDigit] = (wchar_t)pDigits[( qwHash >> ( 60 - ( dwDigit * 4 ) ) ) & 0xf];
+	}
+	a_pName[PIPELINE_CACHE_NAME_LENGTH - 1] = 0;
+}
+
+//header then the serialized library, no crt needed like TelemetryWriteBinary
+inline
+bool PipelineCacheWriteFile( const char *pFileName, const void *a_pLibrary, u64 qwLibrarySize )
+{
+	HANDLE hFile = CreateFileA( pFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( hFile == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	PipelineCacheFileHeader header;
+	header.dwMagic = PIPELINE_CACHE_FILE_MAGIC;
+	header.dwVersion = PIPELINE_CACHE_FILE_VERSION;
+	header.qwLibrarySize = qwLibrarySize;
+	header.qwLibraryHash = HashFnv1a( HASH_FNV_OFFSET, a_pLibrary, qwLibrarySize );
+	DWORD dwWritten;
+	bool bSuccess = WriteFile( hFile, &header, sizeof(header), &dwWritten, nullptr ) != 0;
+	bSuccess = bSuccess && WriteFile( hFile, a_pLibrary, (DWORD)qwLibrarySize, &dwWritten, nullptr ) != 0;
+	CloseHandle( hFile );
+	return bSuccess;
+}
+
+//the library part of the file, or null if there is no file or it fails any check, free() it when done
+inline
+void* PipelineCacheReadFile( const char *pFileName, u64 *a_pLibrarySize, u8 *a_pRejected )
+{
+	*a_pLibrarySize = 0;
+	*a_pRejected = 0;
+	HANDLE hFile = CreateFileA( pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( hFile == INVALID_HANDLE_VALUE )
+	{
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize;
+	PipelineCacheFileHeader header;
+	DWORD dwRead;
+	void *pLibrary = nullptr;
+	if( GetFileSizeEx( hFile, &fileSize ) && (u64)fileSize.QuadPart >= sizeof(header) &&
+		ReadFile( hFile, &header, sizeof(header), &dwRead, nullptr ) && dwRead == sizeof(header) &&
+		header.dwMagic == PIPELINE_CACHE_FILE_MAGIC && header.dwVersion == PIPELINE_CACHE_FILE_VERSION &&
+		header.qwLibrarySize == (u64)fileSize.QuadPart - sizeof(header) && header.qwLibrarySize < 0x80000000 )
+	{
+		pLibrary = malloc( header.qwLibrarySize ? header.qwLibrarySize : 1 );
+		if( pLibrary && ( !ReadFile( hFile, pLibrary, (DWORD)header.qwLibrarySize, &dwRead, nullptr ) || dwRead != header.qwLibrarySize ||
+			HashFnv1a( HASH_FNV_OFFSET, pLibrary, header.qwLibrarySize ) != header.qwLibraryHash ) )
+		{
+			free( pLibrary );
+			pLibrary = nullptr;
+		}
+	}
+	CloseHandle( hFile );
+	*a_pRejected = pLibrary ? 0 : 1;
+	*a_pLibrarySize = pLibrary ? header.qwLibrarySize : 0;
+	return pLibrary;
+}
+
+//a null device is the null backend, otherwise the library comes from the file when the driver still takes it, else it starts empty
+inline
+void InitPipelineCache( PipelineCache *a_pCache, ID3D12Device *a_pDevice, const char *pFileName )
+{
+	memset( a_pCache, 0, sizeof( PipelineCache ) );
+	a_pCache->pDevice = a_pDevice;
+	if( !a_pDevice )
+	{
+		return;
+	}
+	LARGE_INTEGER PerfCountFrequency, startCounter, endCounter;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	QueryPerformanceCounter( &startCounter );
+	ID3D12Device1 *pDevice1;
+	if( SUCCEEDED( a_pDevice->QueryInterface( IID_PPV_ARGS( &pDevice1 ) ) ) )
+	{
+		u64 qwLibrarySize;
+		a_pCache->pFileData = PipelineCacheReadFile( pFileName, &qwLibrarySize, &a_pCache->bFileRejected );
+		//another driver or adapter than the one that wrote it fails here, as does anything the file checks missed
+		if( a_pCache->pFileData && FAILED( pDevice1->CreatePipelineLibrary( a_pCache->pFileData, qwLibrarySize, IID_PPV_ARGS( &a_pCache->pLibrary ) ) ) )
+		{
+			free( a_pCache->pFileData );
+			a_pCache->pFileData = nullptr;
+			a_pCache->pLibrary = nullptr;
+			a_pCache->bFileRejected = 1;
+		}
+		if( !a_pCache->pLibrary && FAILED( pDevice1->CreatePipelineLibrary( nullptr, 0, IID_PPV_ARGS( &a_pCache->pLibrary ) ) ) )
+		{
+			a_pCache->pLibrary = nullptr; //no cache, everything still gets compiled
+		}
+		pDevice1->Release();
+	}
+	QueryPerformanceCounter( &endCounter );
+	a_pCache->fOpenMs = (f64)( endCounter.QuadPart - startCounter.QuadPart ) * 1000.0 / (f64)PerfCountFrequency.QuadPart;
+}
+
+inline
+void DestroyPipelineCache( PipelineCache *a_pCache )
+{
+	if( a_pCache->pLibrary )
+	{
+		a_pCache->pLibrary->Release();
+		a_pCache->pLibrary = nullptr;
+	}
+	free( a_pCache->pFileData );
+	a_pCache->pFileData = nullptr;
+}
+
+inline
+PipelineCacheEntry* PipelineCacheAddEntry( PipelineCache *a_pCache, ID3D12PipelineState **a_ppPipeline, const char *pName, u64 qwHash )
+{
+#if MAIN_DEBUG
+	assert( a_pCache->dwCount < PIPELINE_CACHE_MAX_PIPELINES );
+#endif
+	PipelineCacheEntry *pEntry = &a_pCache->entries[a_pCache->dwCount++];
+	pEntry->ppPipeline = a_ppPipeline;
+	pEntry->pName = pName;
+	pEntry->qwHash = qwHash;
+	PipelineCacheName( qwHash, pEntry->name );
+	pEntry->hr = 0;
+	pEntry->bLoaded = 0;
+	*a_ppPipeline = nullptr;
+	return pEntry;
+}
+
+//queues a pso, *a_ppPipeline is set by the next PipelineCacheBuild
+inline
+void PipelineCacheAddGraphics( PipelineCache *a_pCache, D3D12_GRAPHICS_PIPELINE_STATE_DESC *a_pDesc, const void *a_pRootSignatureBlob, u64 qwRootSignatureSize,
+	ID3D12PipelineState **a_ppPipeline, const char *pName )
+{
+	PipelineCacheEntry *pEntry = PipelineCacheAddEntry( a_pCache, a_ppPipeline, pName, HashGraphicsPipelineDesc( a_pDesc, a_pRootSignatureBlob, qwRootSignatureSize ) );
+	pEntry->graphicsDesc = *a_pDesc;
+	pEntry->bCompute = 0;
+}
+
+inline
+void PipelineCacheAddCompute( PipelineCache *a_pCache, D3D12_COMPUTE_PIPELINE_STATE_DESC *a_pDesc, const void *a_pRootSignatureBlob, u64 qwRootSignatureSize,
+	ID3D12PipelineState **a_ppPipeline, const char *pName )
+{
+	PipelineCacheEntry *pEntry = PipelineCacheAddEntry( a_pCache, a_ppPipeline, pName, HashComputePipelineDesc( a_pDesc, a_pRootSignatureBlob, qwRootSignatureSize ) );
+	pEntry->computeDesc = *a_pDesc;
+	pEntry->bCompute = 1;
+}
+
+typedef struct PipelineCompileJob
+{
+	PipelineCache *pCache;
+	u32 *pMisses; //entry indices
+} PipelineCompileJob;
+
+//the device is free threaded, each chunk only writes its own entries
+void PipelineCompileRange( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	PipelineCompileJob *pJob = (PipelineCompileJob*)pContext;
+	for( u32 dwMiss = dwBegin; dwMiss < dwEnd; ++dwMiss )
+	{
+		PipelineCacheEntry *pEntry = &pJob->pCache->entries[pJob->pMisses[dwMiss]];
+		ID3D12Device *pDevice = pJob->pCache->pDevice;
+		if( !pDevice )
+		{
+			pEntry->hr = 0;
+		}
+		else if( pEntry->bCompute )
+		{
+			pEntry->hr = pDevice->CreateComputePipelineState( &pEntry->computeDesc, IID_PPV_ARGS( pEntry->ppPipeline ) );
+		}
+		else
+		{
+			pEntry->hr = pDevice->CreateGraphicsPipelineState( &pEntry->graphicsDesc, IID_PPV_ARGS( pEntry->ppPipeline ) );
+		}
+	}
+}
+
+//everything added since the last build: loads what the library has, compiles the rest on the workers, then stores those
+inline
+bool PipelineCacheBuild( PipelineCache *a_pCache, WorkerPool *a_pPool )
+{
+	LARGE_INTEGER PerfCountFrequency, startCounter, endCounter;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	f64 fMsPerCount = 1000.0 / (f64)PerfCountFrequency.QuadPart;
+
+	QueryPerformanceCounter( &startCounter );
+	u32 misses[PIPELINE_CACHE_MAX_PIPELINES];
+	u32 dwNumMisses = 0;
+	for( u32 dwEntry = a_pCache->dwNumBuilt; dwEntry < a_pCache->dwCount; ++dwEntry )
+	{
+		PipelineCacheEntry *pEntry = &a_pCache->entries[dwEntry];
+		if( a_pCache->pLibrary )
+		{
+			//E_INVALIDARG when the name isn't there or the desc doesn't match what was stored under it
+			pEntry->hr = pEntry->bCompute ? a_pCache->pLibrary->LoadComputePipeline( pEntry->name, &pEntry->computeDesc, IID_PPV_ARGS( pEntry->ppPipeline ) ) :
+				a_pCache->pLibrary->LoadGraphicsPipeline( pEntry->name, &pEntry->graphicsDesc, IID_PPV_ARGS( pEntry->ppPipeline ) );
+			pEntry->bLoaded = SUCCEEDED( pEntry->hr ) ? 1 : 0;
+		}
+		if( pEntry->bLoaded )
+		{
+			++a_pCache->dwNumLoaded;
+		}
+		else
+		{
+			*pEntry->ppPipeline = nullptr;
+			misses[dwNumMisses++] = dwEntry;
+		}
+	}
+	QueryPerformanceCounter( &endCounter );
+	a_pCache->fLoadMs += (f64)( endCounter.QuadPart - startCounter.QuadPart ) * fMsPerCount;
+
+	startCounter = endCounter;
+	PipelineCompileJob job = { a_pCache, misses };
+	ParallelFor( a_pPool, dwNumMisses, 1, PipelineCompileRange, &job );
+	a_pCache->dwNumCompiled += dwNumMisses;
+	QueryPerformanceCounter( &endCounter );
+	a_pCache->fCompileMs += (f64)( endCounter.QuadPart - startCounter.QuadPart ) * fMsPerCount;
+
+	startCounter = endCounter;
+	bool bSuccess = true;
+	for( u32 dwMiss = 0; dwMiss < dwNumMisses; ++dwMiss )
+	{
+		PipelineCacheEntry *pEntry = &a_pCache->entries[misses[dwMiss]];
+		if( FAILED( pEntry->hr ) )
+		{
+#if MAIN_DEBUG
+			printf( "%s pipeline state object failed to create\n", pEntry->pName );
+#endif
+			logError( "Failed to create pipeline state object!\n" );
+			bSuccess = false;
+		}
+		//a second pso with the same hash is already stored under its name, that one fails and is fine to ignore
+		else if( a_pCache->pLibrary && SUCCEEDED( a_pCache->pLibrary->StorePipeline( pEntry->name, *pEntry->ppPipeline ) ) )
+		{
+			a_pCache->bDirty = 1;
+		}
+	}
+	QueryPerformanceCounter( &endCounter );
+	a_pCache->fStoreMs += (f64)( endCounter.QuadPart - startCounter.QuadPart ) * fMsPerCount;
+	a_pCache->dwNumBuilt = a_pCache->dwCount;
+	return bSuccess;
+}
+
+//writes the library out if this launch added to it, a failed write only costs the next launch its hits
+inline
+bool PipelineCacheSave( PipelineCache *a_pCache, const char *pFileName )
+{
+	if( !a_pCache->pLibrary || !a_pCache->bDirty )
+	{
+		return true;
+	}
+	u64 qwSize = a_pCache->pLibrary->GetSerializedSize();
+	void *pData = malloc( qwSize ? qwSize : 1 );
+	bool bSuccess = pData && SUCCEEDED( a_pCache->pLibrary->Serialize( pData, qwSize ) ) && PipelineCacheWriteFile( pFileName, pData, qwSize );
+	free( pData );
+	a_pCache->bDirty = bSuccess ? 0 : 1;
+	return bSuccess;
+}
+
+#if MAIN_DEBUG
+inline
+void PipelineCachePrintReport( PipelineCache *a_pCache, f64 fStartupMs )
+{
+	printf( "startup %.1fms, pipelines: %u loaded %u compiled (%s), open %.2fms load %.2fms compile %.2fms store %.2fms\n", fStartupMs,
+		a_pCache->dwNumLoaded, a_pCache->dwNumCompiled, !a_pCache->pLibrary ? "no library" : a_pCache->bFileRejected ? "cache file rejected" : "library",
+		a_pCache->fOpenMs, a_pCache->fLoadMs, a_pCache->fCompileMs, a_pCache->fStoreMs );
+}
+#endif
+
+#if BENCHMARK_MODE
+inline
+u32 BenchmarkPipelineCache()
+{
+	u32 dwFailures = 0;
+	u8 vertexBytecode[2048];
+	u8 pixelBytecode[1024];
+	u8 rootSignatureBlob[64];
+	u32 dwSeed = 777;
+	for( u32 dwByte = 0; dwByte < sizeof( vertexBytecode ); ++dwByte )
+	{
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		vertexBytecode[dwByte] = (u8)( dwSeed >> 24 );
+		pixelBytecode[dwByte & ( sizeof( pixelBytecode ) - 1 )] = (u8)( dwSeed >> 16 );
+		rootSignatureBlob[dwByte & ( sizeof( rootSignatureBlob ) - 1 )] = (u8)( dwSeed >> 8 );
+	}
+
+	D3D12_INPUT_ELEMENT_DESC inputLayout[] =
+	{
+		{ "POS", 0, DXGI_FORMAT_R32G32B32_FLOAT, MAIN_VB_SLOT, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, MAIN_VB_SLOT, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, MAIN_VB_SLOT, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+	};
+	//one desc built on garbage and one on zeroes, the same fields have to give the same hash whatever the padding holds
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC descs[2];
+	memset( &descs[0], 0xcd, sizeof( descs[0] ) );
+	memset( &descs[1], 0, sizeof( descs[1] ) );
+	for( u32 dwDesc = 0; dwDesc < 2; ++dwDesc )
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC *pDesc = &descs[dwDesc];
+		pDesc->pRootSignature = (ID3D12RootSignature*)(u64)( 0x1000 * ( dwDesc + 1 ) ); //a different object, the blob is what counts
+		pDesc->VS.pShaderBytecode = vertexBytecode;
+		pDesc->VS.BytecodeLength = sizeof( vertexBytecode );
+		pDesc->PS.pShaderBytecode = pixelBytecode;
+		pDesc->PS.BytecodeLength = sizeof( pixelBytecode );
+		pDesc->DS.pShaderBytecode = nullptr;
+		pDesc->DS.BytecodeLength = 0;
+		pDesc->HS = pDesc->DS;
+		pDesc->GS = pDesc->DS;
+		pDesc->StreamOutput.pSODeclaration = nullptr;
+		pDesc->StreamOutput.NumEntries = 0;
+		pDesc->StreamOutput.pBufferStrides = nullptr;
+		pDesc->StreamOutput.NumStrides = 0;
+		pDesc->StreamOutput.RasterizedStream = 0;
+		pDesc->BlendState.AlphaToCoverageEnable = 0;
+		pDesc->BlendState.IndependentBlendEnable = 0;
+		for( u32 dwRenderTarget = 0; dwRenderTarget < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++dwRenderTarget )
+		{
+			D3D12_RENDER_TARGET_BLEND_DESC *pTarget = &pDesc->BlendState.RenderTarget[dwRenderTarget];
+			pTarget->BlendEnable = 0;
+			pTarget->LogicOpEnable = 0;
+			pTarget->SrcBlend = D3D12_BLEND_ONE;
+			pTarget->DestBlend = D3D12_BLEND_ZERO;
+			pTarget->BlendOp = D3D12_BLEND_OP_ADD;
+			pTarget->SrcBlendAlpha = D3D12_BLEND_ONE;
+			pTarget->DestBlendAlpha = D3D12_BLEND_ZERO;
+			pTarget->BlendOpAlpha = D3D12_BLEND_OP_ADD;
+			pTarget->LogicOp = D3D12_LOGIC_OP_NOOP;
+			pTarget->RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+		}
+		pDesc->SampleMask = 0xffffffff;
+		pDesc->RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+		pDesc->RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+		pDesc->RasterizerState.FrontCounterClockwise = 0;
+		pDesc->RasterizerState.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
+		pDesc->RasterizerState.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+		pDesc->RasterizerState.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+		pDesc->RasterizerState.DepthClipEnable = 1;
+		pDesc->RasterizerState.MultisampleEnable = 0;
+		pDesc->RasterizerState.AntialiasedLineEnable = 0;
+		pDesc->RasterizerState.ForcedSampleCount = 0;
+		pDesc->RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+		pDesc->DepthStencilState.DepthEnable = 1;
+		pDesc->DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+		pDesc->DepthStencilState.DepthFunc = EYE_DEPTH_FUNC;
+		pDesc->DepthStencilState.StencilEnable = 0;
+		pDesc->DepthStencilState.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
+		pDesc->DepthStencilState.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+		pDesc->DepthStencilState.FrontFace.StencilFailOp = D3D12_STENCIL_OP_KEEP;
+		pDesc->DepthStencilState.FrontFace.StencilDepthFailOp = D3D12_STENCIL_OP_KEEP;
+		pDesc->DepthStencilState.FrontFace.StencilPassOp = D3D12_STENCIL_OP_KEEP;
+		pDesc->DepthStencilState.FrontFace.StencilFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+		pDesc->DepthStencilState.BackFace = pDesc->DepthStencilState.FrontFace;
+		pDesc->InputLayout.pInputElementDescs = inputLayout;
+		pDesc->InputLayout.NumElements = _countof( inputLayout );
+		pDesc->IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+		pDesc->PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+		pDesc->NumRenderTargets = 1;
+		pDesc->RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+		for( u32 dwRenderTargetFormat = 1; dwRenderTargetFormat < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++dwRenderTargetFormat )
+		{
+			pDesc->RTVFormats[dwRenderTargetFormat] = DXGI_FORMAT_UNKNOWN;
+		}
+		pDesc->DSVFormat = DXGI_FORMAT_D32_FLOAT;
+		pDesc->SampleDesc.Count = 1;
+		pDesc->SampleDesc.Quality = 0;
+		pDesc->NodeMask = 0;
+		pDesc->CachedPSO.pCachedBlob = (void*)(u64)dwDesc; //ignored
+		pDesc->CachedPSO.CachedBlobSizeInBytes = dwDesc;
+		pDesc->Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+	}
+	u64 qwBaseHash = HashGraphicsPipelineDesc( &descs[0], rootSignatureBlob, sizeof( rootSignatureBlob ) );
+	if( HashGraphicsPipelineDesc( &descs[1], rootSignatureBlob, sizeof( rootSignatureBlob ) ) != qwBaseHash )
+	{
+		++dwFailures;
+	}
+
+	//every one of these has to move the hash, and no two the same way
+	const u32 dwNumChanges = 9;
+	u64 changedHashes[dwNumChanges];
+	D3D12_INPUT_ELEMENT_DESC changedLayout[_countof( inputLayout )];
+	for( u32 dwChange = 0; dwChange < dwNumChanges; ++dwChange )
+	{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = descs[1];
+		u8 changedVertex[sizeof( vertexBytecode )];
+		u8 changedRootSignature[sizeof( rootSignatureBlob )];
+		memcpy( changedVertex, vertexBytecode, sizeof( vertexBytecode ) );
+		memcpy( changedRootSignature, rootSignatureBlob, sizeof( rootSignatureBlob ) );
+		memcpy( changedLayout, inputLayout, sizeof( inputLayout ) );
+		desc.VS.pShaderBytecode = changedVertex;
+		desc.InputLayout.pInputElementDescs = changedLayout;
+		switch( dwChange )
+		{
+			case 0: changedVertex[sizeof( vertexBytecode ) - 1] ^= 1; break;
+			case 1: desc.VS.BytecodeLength -= 1; break;
+			case 2: changedRootSignature[3] ^= 0x80; break;
+			case 3: changedLayout[1].AlignedByteOffset = 16; break;
+			case 4: changedLayout[2].SemanticName = "COLOUR"; break;
+			case 5: desc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE; break;
+			case 6: desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS; break;
+			case 7: desc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0x7; break;
+			case 8: desc.SampleDesc.Count = 4; break;
+		}
+		changedHashes[dwChange] = HashGraphicsPipelineDesc( &desc, changedRootSignature, sizeof( changedRootSignature ) );
+		if( changedHashes[dwChange] == qwBaseHash )
+		{
+			++dwFailures;
+		}
+		for( u32 dwOther = 0; dwOther < dwChange; ++dwOther )
+		{
+			dwFailures += changedHashes[dwOther] == changedHashes[dwChange] ? 1 : 0;
+		}
+	}
+	D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc;
+	memset( &computeDesc, 0, sizeof( computeDesc ) );
+	computeDesc.CS = descs[1].VS;
+	if( HashComputePipelineDesc( &computeDesc, rootSignatureBlob, sizeof( rootSignatureBlob ) ) == qwBaseHash )
+	{
+		++dwFailures;
+	}
+
+	LARGE_INTEGER PerfCountFrequency, startCounter, endCounter;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	const u32 dwIterations = 2000;
+	u64 qwSink = 0;
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwIteration = 0; dwIteration < dwIterations; ++dwIteration )
+	{
+		qwSink += HashGraphicsPipelineDesc( &descs[dwIteration & 1], rootSignatureBlob, sizeof( rootSignatureBlob ) );
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fHashUs = (f64)( endCounter.QuadPart - startCounter.QuadPart ) * 1000000.0 / (f64)PerfCountFrequency.QuadPart / dwIterations;
+	dwFailures += qwSink == 0 ? 1 : 0;
+
+	//the null backend: nothing is created, every pso is a miss and the names are the hashes
+	PipelineCache *pCache = (PipelineCache*)malloc( sizeof( PipelineCache ) );
+	WorkerPool pool;
+	if( !pCache || !InitWorkerPool( &pool, 3 ) )
+	{
+		printf( "Pipeline cache: out of memory\n" );
+		free( pCache );
+		return 1;
+	}
+	InitPipelineCache( pCache, nullptr, nullptr );
+	ID3D12PipelineState *pipelines[3];
+	PipelineCacheAddGraphics( pCache, &descs[0], rootSignatureBlob, sizeof( rootSignatureBlob ), &pipelines[0], "base" );
+	PipelineCacheAddGraphics( pCache, &descs[1], rootSignatureBlob, sizeof( rootSignatureBlob ), &pipelines[1], "same" );
+	PipelineCacheAddCompute( pCache, &computeDesc, rootSignatureBlob, sizeof( rootSignatureBlob ), &pipelines[2], "compute" );
+	if( !PipelineCacheBuild( pCache, &pool ) || pCache->dwNumCompiled != 3 || pCache->dwNumLoaded != 0 || pCache->dwNumBuilt != 3 ||
+		memcmp( pCache->entries[0].name, pCache->entries[1].name, sizeof( pCache->entries[0].name ) ) != 0 ||
+		memcmp( pCache->entries[0].name, pCache->entries[2].name, sizeof( pCache->entries[0].name ) ) == 0 || !PipelineCacheSave( pCache, nullptr ) )
+	{
+		++dwFailures;
+	}
+	wchar_t expectedName[PIPELINE_CACHE_NAME_LENGTH];
+	PipelineCacheName( 0x0123456789abcdefull, expectedName );
+	for( u32 dwDigit = 0; dwDigit < PIPELINE_CACHE_NAME_LENGTH; ++dwDigit )
+	{
+		dwFailures += expectedName[dwDigit] != (wchar_t)"0123456789abcdef"[dwDigit] ? 1 : 0;
+	}
+	DestroyPipelineCache( pCache );
+	DestroyWorkerPool( &pool );
+	free( pCache );
+
+	//the file round trips, and anything short of an intact file of this version is rejected rather than handed to the driver
+	const char *pFileName = "BasicOVRBenchmark.pipelines.bin";
+	const u32 dwLibrarySize = 64 * 1024;
+	u8 *pLibrary = (u8*)malloc( dwLibrarySize + sizeof( PipelineCacheFileHeader ) );
+	if( !pLibrary )
+	{
+		printf( "Pipeline cache: out of memory\n" );
+		return 1;
+	}
+	for( u32 dwByte = 0; dwByte < dwLibrarySize; ++dwByte )
+	{
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		pLibrary[dwByte] = (u8)( dwSeed >> 24 );
+	}
+	u64 qwReadSize;
+	u8 bRejected;
+	u8 *pRead = (u8*)PipelineCacheReadFile( "BasicOVRBenchmark.missing.bin", &qwReadSize, &bRejected );
+	dwFailures += ( pRead || bRejected ) ? 1 : 0; //no file is not a bad file
+	free( pRead );
+	if( !PipelineCacheWriteFile( pFileName, pLibrary, dwLibrarySize ) )
+	{
+		++dwFailures;
+	}
+	pRead = (u8*)PipelineCacheReadFile( pFileName, &qwReadSize, &bRejected );
+	if( !pRead || bRejected || qwReadSize != dwLibrarySize || memcmp( pRead, pLibrary, dwLibrarySize ) != 0 )
+	{
+		++dwFailures;
+	}
+	free( pRead );
+	//0 flips a library byte, 1 truncates, 2 bumps the version, 3 breaks the magic
+	for( u32 dwDamage = 0; dwDamage < 4; ++dwDamage )
+	{
+		PipelineCacheFileHeader header;
+		header.dwMagic = PIPELINE_CACHE_FILE_MAGIC ^ ( dwDamage == 3 ? 0x20 : 0 ); //"oPSO"
+		header.dwVersion = PIPELINE_CACHE_FILE_VERSION + ( dwDamage == 2 ? 1 : 0 );
+		header.qwLibrarySize = dwLibrarySize;
+		header.qwLibraryHash = HashFnv1a( HASH_FNV_OFFSET, pLibrary, dwLibrarySize );
+		HANDLE hFile = CreateFileA( pFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if( hFile == INVALID_HANDLE_VALUE )
+		{
+			++dwFailures;
+			continue;
+		}
+		pLibrary[dwLibrarySize / 2] ^= dwDamage == 0 ? 0x10 : 0;
+		DWORD dwWritten;
+		WriteFile( hFile, &header, sizeof( header ), &dwWritten, nullptr );
+		WriteFile( hFile, pLibrary, dwDamage == 1 ? dwLibrarySize - 100 : dwLibrarySize, &dwWritten, nullptr );
+		CloseHandle( hFile );
+		pLibrary[dwLibrarySize / 2] ^= dwDamage == 0 ? 0x10 : 0;
+		pRead = (u8*)PipelineCacheReadFile( pFileName, &qwReadSize, &bRejected );
+		dwFailures += ( pRead || !bRejected || qwReadSize ) ? 1 : 0;
+		free( pRead );
+	}
+	free( pLibrary );
+
+	printf( "Pipeline cache: hash %.2fus/pso (%u bytes of bytecode), %u failures\n", fHashUs, (u32)( sizeof( vertexBytecode ) + sizeof( pixelBytecode ) ), dwFailures );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,351 @@
+//Platform, the few Win32 calls the modules make, for Tests.cpp to build them where there's no windows.h
+//the app includes windows.h itself, on _WIN32 this is just that. anywhere else each call gets a POSIX stand in with the same
+//signature so the modules don't change, only what the modules use is here and only as far as they use it
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#if _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <intrin.h>
+
+#else
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/stat.h>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#endif
+
+typedef int32_t LONG;
+typedef uint32_t DWORD;
+typedef int BOOL;
+#define TRUE 1
+#define FALSE 0
+
+typedef union LARGE_INTEGER
+{
+	struct
+	{
+		DWORD LowPart;
+		LONG HighPart;
+	};
+	int64_t QuadPart;
+} LARGE_INTEGER;
+
+#define _countof( a ) ( sizeof( a ) / sizeof( ( a )[0] ) )
+
+#define WINAPI
+typedef void *LPVOID;
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)( LPVOID lpParameter );
+
+//Handles, one struct for the three kinds the modules open (files, threads, semaphores) so CloseHandle and WaitForSingleObject take any of them
+#define PLATFORM_HANDLE_FILE 0
+#define PLATFORM_HANDLE_THREAD 1
+#define PLATFORM_HANDLE_SEMAPHORE 2
+
+typedef struct PlatformHandle
+{
+	uint32_t dwKind;
+	int iFile;
+	pthread_t thread;
+	LPTHREAD_START_ROUTINE pThreadProc;
+	LPVOID pThreadParameter;
+	uint8_t bJoined;
+	sem_t semaphore;
+} PlatformHandle;
+
+typedef PlatformHandle *HANDLE;
+
+#define INVALID_HANDLE_VALUE ( (HANDLE)(intptr_t)-1 )
+#define INFINITE 0xFFFFFFFF
+
+//Timing, the counter is CLOCK_MONOTONIC in nanoseconds
+inline
+BOOL QueryPerformanceFrequency( LARGE_INTEGER *a_pFrequency )
+{
+	a_pFrequency->QuadPart = 1000000000;
+	return 1;
+}
+
+inline
+BOOL QueryPerformanceCounter( LARGE_INTEGER *a_pCounter )
+{
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	a_pCounter->QuadPart = ( (int64_t)now.tv_sec * 1000000000 ) + now.tv_nsec;
+	return 1;
+}
+
+#if !defined( __x86_64__ ) && !defined( __i386__ )
+//no tsc, the profiler calibrates whatever this counts against QueryPerformanceCounter anyway
+inline
+uint64_t __rdtsc()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter( &counter );
+	return (uint64_t)counter.QuadPart;
+}
+#endif
+
+inline
+void Sleep( DWORD dwMilliseconds )
+{
+	usleep( dwMilliseconds * 1000 );
+}
+
+//Atomics, full barriers like the Interlocked functions
+#define _ReadWriteBarrier() __asm__ __volatile__( "" ::: "memory" )
+
+inline
+LONG InterlockedIncrement( volatile LONG *a_pValue )
+{
+	return __atomic_add_fetch( a_pValue, 1, __ATOMIC_SEQ_CST );
+}
+
+inline
+LONG InterlockedDecrement( volatile LONG *a_pValue )
+{
+	return __atomic_sub_fetch( a_pValue, 1, __ATOMIC_SEQ_CST );
+}
+
+inline
+LONG InterlockedExchangeAdd( volatile LONG *a_pAddend, LONG value )
+{
+	return __atomic_fetch_add( a_pAddend, value, __ATOMIC_SEQ_CST );
+}
+
+inline
+LONG InterlockedExchange( volatile LONG *a_pTarget, LONG value )
+{
+	return __atomic_exchange_n( a_pTarget, value, __ATOMIC_SEQ_CST );
+}
+
+inline
+LONG InterlockedCompareExchange( volatile LONG *a_pDestination, LONG exchange, LONG comparand )
+{
+	__atomic_compare_exchange_n( a_pDestination, &comparand, exchange, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+	return comparand; //the value it held, whether or not it was swapped
+}
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define YieldProcessor() _mm_pause()
+#else
+#define YieldProcessor() __asm__ __volatile__( "" ::: "memory" )
+#endif
+
+//System, only the processor count is filled in
+typedef struct SYSTEM_INFO
+{
+	DWORD dwNumberOfProcessors;
+} SYSTEM_INFO;
+
+inline
+void GetSystemInfo( SYSTEM_INFO *a_pSystemInfo )
+{
+	long iNumProcessors = sysconf( _SC_NPROCESSORS_ONLN );
+	a_pSystemInfo->dwNumberOfProcessors = iNumProcessors > 0 ? (DWORD)iNumProcessors : 1;
+}
+
+//Threads, a thread is waited on by joining it, one that's closed without a wait is detached
+inline
+void* PlatformThreadStart( void *pHandle )
+{
+	HANDLE hThread = (HANDLE)pHandle;
+	hThread->pThreadProc( hThread->pThreadParameter );
+	return nullptr;
+}
+
+inline
+HANDLE CreateThread( void *a_pThreadAttributes, size_t qwStackSize, LPTHREAD_START_ROUTINE pStartAddress, LPVOID pParameter, DWORD dwCreationFlags, DWORD *a_pThreadId )
+{
+	HANDLE hThread = (HANDLE)calloc( 1, sizeof( PlatformHandle ) );
+	if( !hThread )
+	{
+		return nullptr;
+	}
+	hThread->dwKind = PLATFORM_HANDLE_THREAD;
+	hThread->pThreadProc = pStartAddress;
+	hThread->pThreadParameter = pParameter;
+	if( pthread_create( &hThread->thread, nullptr, PlatformThreadStart, hThread ) != 0 )
+	{
+		free( hThread );
+		return nullptr;
+	}
+	return hThread;
+}
+
+//only the counting the modules use, the maximum isn't enforced
+inline
+HANDLE CreateSemaphore( void *a_pSemaphoreAttributes, LONG initialCount, LONG maximumCount, const char *pName )
+{
+	HANDLE hSemaphore = (HANDLE)calloc( 1, sizeof( PlatformHandle ) );
+	if( !hSemaphore )
+	{
+		return nullptr;
+	}
+	hSemaphore->dwKind = PLATFORM_HANDLE_SEMAPHORE;
+	if( sem_init( &hSemaphore->semaphore, 0, (unsigned int)initialCount ) != 0 )
+	{
+		free( hSemaphore );
+		return nullptr;
+	}
+	return hSemaphore;
+}
+
+inline
+BOOL ReleaseSemaphore( HANDLE hSemaphore, LONG releaseCount, LONG *a_pPreviousCount )
+{
+	for( LONG release = 0; release < releaseCount; ++release )
+	{
+		sem_post( &hSemaphore->semaphore );
+	}
+	return 1;
+}
+
+//INFINITE only
+inline
+DWORD WaitForSingleObject( HANDLE hHandle, DWORD dwMilliseconds )
+{
+	if( hHandle->dwKind == PLATFORM_HANDLE_THREAD )
+	{
+		if( !hHandle->bJoined )
+		{
+			pthread_join( hHandle->thread, nullptr );
+			hHandle->bJoined = 1;
+		}
+		return 0;
+	}
+	while( sem_wait( &hHandle->semaphore ) != 0 && errno == EINTR )
+	{
+	}
+	return 0;
+}
+
+//Files, a plain descriptor, sharing modes and attributes don't mean anything here
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_SHARE_READ 0x00000001
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+
+inline
+HANDLE CreateFileA( const char *pFileName, DWORD dwDesiredAccess, DWORD dwShareMode, void *a_pSecurityAttributes, DWORD dwCreationDisposition,
+	DWORD dwFlagsAndAttributes, HANDLE hTemplateFile )
+{
+	int iFlags = ( dwDesiredAccess & GENERIC_READ ) && ( dwDesiredAccess & GENERIC_WRITE ) ? O_RDWR : ( dwDesiredAccess & GENERIC_WRITE ) ? O_WRONLY : O_RDONLY;
+	iFlags |= dwCreationDisposition == CREATE_ALWAYS ? O_CREAT | O_TRUNC : 0;
+	int iFile = pFileName ? open( pFileName, iFlags, 0644 ) : -1;
+	if( iFile < 0 )
+	{
+		return INVALID_HANDLE_VALUE;
+	}
+	HANDLE hFile = (HANDLE)calloc( 1, sizeof( PlatformHandle ) );
+	if( !hFile )
+	{
+		close( iFile );
+		return INVALID_HANDLE_VALUE;
+	}
+	hFile->dwKind = PLATFORM_HANDLE_FILE;
+	hFile->iFile = iFile;
+	return hFile;
+}
+
+inline
+BOOL ReadFile( HANDLE hFile, void *a_pBuffer, DWORD dwNumberOfBytesToRead, DWORD *a_pNumberOfBytesRead, void *a_pOverlapped )
+{
+	*a_pNumberOfBytesRead = 0;
+	while( *a_pNumberOfBytesRead < dwNumberOfBytesToRead )
+	{
+		ssize_t qwRead = read( hFile->iFile, (uint8_t*)a_pBuffer + *a_pNumberOfBytesRead, dwNumberOfBytesToRead - *a_pNumberOfBytesRead );
+		if( qwRead < 0 && errno == EINTR )
+		{
+			continue;
+		}
+		if( qwRead < 0 )
+		{
+			return 0;
+		}
+		if( qwRead == 0 )
+		{
+			break; //end of file, ReadFile succeeds short
+		}
+		*a_pNumberOfBytesRead += (DWORD)qwRead;
+	}
+	return 1;
+}
+
+inline
+BOOL WriteFile( HANDLE hFile, const void *a_pBuffer, DWORD dwNumberOfBytesToWrite, DWORD *a_pNumberOfBytesWritten, void *a_pOverlapped )
+{
+	*a_pNumberOfBytesWritten = 0;
+	while( *a_pNumberOfBytesWritten < dwNumberOfBytesToWrite )
+	{
+		ssize_t qwWritten = write( hFile->iFile, (const uint8_t*)a_pBuffer + *a_pNumberOfBytesWritten, dwNumberOfBytesToWrite - *a_pNumberOfBytesWritten );
+		if( qwWritten < 0 && errno == EINTR )
+		{
+			continue;
+		}
+		if( qwWritten <= 0 )
+		{
+			return 0;
+		}
+		*a_pNumberOfBytesWritten += (DWORD)qwWritten;
+	}
+	return 1;
+}
+
+inline
+BOOL GetFileSizeEx( HANDLE hFile, LARGE_INTEGER *a_pFileSize )
+{
+	struct stat fileStat;
+	if( fstat( hFile->iFile, &fileStat ) != 0 )
+	{
+		return 0;
+	}
+	a_pFileSize->QuadPart = (int64_t)fileStat.st_size;
+	return 1;
+}
+
+inline
+BOOL CloseHandle( HANDLE hObject )
+{
+	if( hObject->dwKind == PLATFORM_HANDLE_FILE )
+	{
+		close( hObject->iFile );
+	}
+	else if( hObject->dwKind == PLATFORM_HANDLE_THREAD && !hObject->bJoined )
+	{
+		pthread_detach( hObject->thread );
+	}
+	else if( hObject->dwKind == PLATFORM_HANDLE_SEMAPHORE )
+	{
+		sem_destroy( &hObject->semaphore );
+	}
+	free( hObject );
+	return 1;
+}
+
+//CRT
+inline
+int fopen_s( FILE **a_ppFile, const char *pFileName, const char *pMode )
+{
+	*a_ppFile = fopen( pFileName, pMode );
+	return *a_ppFile ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,326 @@
+//CPU profiler, PROFILE_SCOPE("name") records a begin/end rdtsc pair into the calling thread's ring buffer
+//each thread only ever writes its own ring so there are no locks or atomics on the hot path,
+//readers (report/trace export) copy a ring and throw away anything the writer may have lapped while copying
+//rdtsc is invariant on anything that can run a rift, it gets calibrated against QueryPerformanceCounter for wall time
+//view the exported trace in chrome://tracing or https://ui.perfetto.dev
+
+#define PROFILER_MAX_THREADS 16 //sim, render, the GPU track and every worker, Workers.h asserts it has room for a full pool
+#define PROFILER_RING_SIZE 8192 //needs to be a power of 2, ~9 seconds of history at 90hz with 10 scopes a frame
+#define PROFILER_MAX_SCOPES 64 //distinct scope names in a report
+
+typedef struct ProfileEvent
+{
+	const char *pName; //must be a string literal, scopes are grouped by pointer
+	u64 qwStartTsc;
+	u64 qwEndTsc;
+} ProfileEvent;
+
+typedef struct ProfilerThreadRing
+{
+	ProfileEvent events[PROFILER_RING_SIZE];
+	volatile u64 qwHead; //total events ever written, only the owning thread writes it
+	const char *pThreadName;
+	u32 dwThreadIdx;
+} ProfilerThreadRing;
+
+typedef struct Profiler
+{
+	ProfilerThreadRing threadRings[PROFILER_MAX_THREADS];
+	volatile LONG dwNumThreads;
+	volatile LONG bOverflowReported;
+	u64 qwStartTsc;
+	LARGE_INTEGER startCounter;
+	f64 fTscPerUs; //from ProfilerCalibrate
+} Profiler;
+
+typedef struct ProfileScopeStats
+{
+	const char *pName;
+	u32 dwCount;
+	f64 fAvgUs;
+	f64 fP50Us;
+	f64 fP99Us;
+	f64 fMaxUs;
+} ProfileScopeStats;
+
+Profiler profiler;
+thread_local ProfilerThreadRing *pProfilerThreadRing; //null until the thread calls ProfilerRegisterThread, its scopes are dropped till then
+
+inline
+void InitProfiler()
+{
+	profiler.dwNumThreads = 0;
+	profiler.bOverflowReported = 0;
+	QueryPerformanceCounter( &profiler.startCounter );
+	profiler.qwStartTsc = __rdtsc();
+	profiler.fTscPerUs = 0.0;
+}
+
+//a ring that isn't tied to the calling thread (e.g. the GPU track), whoever records into it must be its only writer
+inline
+ProfilerThreadRing* ProfilerAddRing( const char *pThreadName )
+{
+	LONG dwThreadIdx = InterlockedIncrement( &profiler.dwNumThreads ) - 1;
+	if( dwThreadIdx >= PROFILER_MAX_THREADS )
+	{
+		InterlockedDecrement( &profiler.dwNumThreads );
+		if( !InterlockedExchange( &profiler.bOverflowReported, 1 ) ) //once, every later thread would say the same
+		{
+			printf( "Profiler: out of thread slots, scopes from \"%s\" and any later threads are dropped\n", pThreadName );
+		}
+		return nullptr;
+	}
+	ProfilerThreadRing *pRing = &profiler.threadRings[dwThreadIdx];
+	pRing->qwHead = 0;
+	pRing->pThreadName = pThreadName;
+	pRing->dwThreadIdx = (u32)dwThreadIdx;
+	return pRing;
+}
+
+//call once at the top of every thread that has scopes in it
+inline
+bool ProfilerRegisterThread( const char *pThreadName )
+{
+	pProfilerThreadRing = ProfilerAddRing( pThreadName );
+	return pProfilerThreadRing != nullptr;
+}
+
+inline
+void ProfilerRecordToRing( ProfilerThreadRing *pRing, const char *pName, u64 qwStartTsc, u64 qwEndTsc )
+{
+	u64 qwHead = pRing->qwHead;
+	ProfileEvent *pEvent = &pRing->events[qwHead & ( PROFILER_RING_SIZE - 1 )];
+	pEvent->pName = pName;
+	pEvent->qwStartTsc = qwStartTsc;
+	pEvent->qwEndTsc = qwEndTsc;
+	_ReadWriteBarrier(); //x64 doesn't reorder stores, just keep the compiler from publishing the head before the event
+	pRing->qwHead = qwHead + 1;
+}
+
+inline
+void ProfilerRecord( const char *pName, u64 qwStartTsc, u64 qwEndTsc )
+{
+	ProfilerThreadRing *pRing = pProfilerThreadRing;
+	if( !pRing )
+	{
+		return;
+	}
+	ProfilerRecordToRing( pRing, pName, qwStartTsc, qwEndTsc );
+}
+
+struct ProfileScope
+{
+	const char *m_pName;
+	u64 m_qwStartTsc;
+	ProfileScope( const char *pName ) : m_pName( pName ), m_qwStartTsc( __rdtsc() ) {}
+	~ProfileScope() { ProfilerRecord( m_pName, m_qwStartTsc, __rdtsc() ); }
+};
+
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+#define PROFILE_SCOPE( name ) ProfileScope PROFILE_CONCAT( profileScope, __LINE__ )( name )
+
+inline
+u32 ProfilerNumThreads()
+{
+	u32 dwNumThreads = (u32)profiler.dwNumThreads;
+	return dwNumThreads < PROFILER_MAX_THREADS ? dwNumThreads : PROFILER_MAX_THREADS;
+}
+
+//rdtsc ticks per microsecond measured against QPC since InitProfiler, gets more accurate the longer the program has been running
+inline
+f64 ProfilerCalibrate()
+{
+	LARGE_INTEGER nowCounter;
+	QueryPerformanceCounter( &nowCounter );
+	u64 qwNowTsc = __rdtsc();
+	LARGE_INTEGER PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	f64 fElapsedUs = ( 1000000.0 * ( nowCounter.QuadPart - profiler.startCounter.QuadPart ) ) / (f64)PerfCountFrequency.QuadPart;
+	if( fElapsedUs > 0.0 )
+	{
+		profiler.fTscPerUs = ( qwNowTsc - profiler.qwStartTsc ) / fElapsedUs;
+	}
+	return profiler.fTscPerUs;
+}
+
+//copies whatever is still valid in a ring into a_pEvents (oldest first), returns how many
+inline
+u32 ProfilerSnapshotRing( ProfilerThreadRing *a_pRing, ProfileEvent *a_pEvents )
+{
+	u64 qwHead = a_pRing->qwHead;
+	_ReadWriteBarrier();
+	u64 qwFirst = qwHead > PROFILER_RING_SIZE ? qwHead - PROFILER_RING_SIZE : 0;
+	for( u64 qwEvent = qwFirst; qwEvent < qwHead; ++qwEvent )
+	{
+		a_pEvents[qwEvent - qwFirst] = a_pRing->events[qwEvent & ( PROFILER_RING_SIZE - 1 )];
+	}
+	_ReadWriteBarrier();
+	//anything the writer got to while we were copying may be torn, drop it
+	//+1 for the slot of event qwNewHead, which the writer may be in the middle of filling without having bumped qwHead yet
+	u64 qwNewHead = a_pRing->qwHead;
+	u64 qwSafeFirst = qwNewHead + 1 > PROFILER_RING_SIZE ? qwNewHead + 1 - PROFILER_RING_SIZE : 0;
+	if( qwSafeFirst >= qwHead )
+	{
+		return 0;
+	}
+	if( qwSafeFirst > qwFirst )
+	{
+		u64 qwDropped = qwSafeFirst - qwFirst;
+		memmove( a_pEvents, a_pEvents + qwDropped, (size_t)( ( qwHead - qwSafeFirst ) * sizeof(ProfileEvent) ) );
+		return (u32)( qwHead - qwSafeFirst );
+	}
+	return (u32)( qwHead - qwFirst );
+}
+
+inline
+int CompareProfileEvents( const void *a, const void *b )
+{
+	const ProfileEvent *pA = (const ProfileEvent*)a;
+	const ProfileEvent *pB = (const ProfileEvent*)b;
+	if( pA->pName != pB->pName )
+	{
+		return pA->pName < pB->pName ? -1 : 1;
+	}
+	u64 qwDurA = pA->qwEndTsc - pA->qwStartTsc;
+	u64 qwDurB = pB->qwEndTsc - pB->qwStartTsc;
+	return qwDurA < qwDurB ? -1 : ( qwDurA > qwDurB ? 1 : 0 );
+}
+
+//per scope stats over everything still in the rings (so a rolling window of the last PROFILER_RING_SIZE events per thread)
+//returns the number of scopes written to a_pStats
+inline
+u32 ProfilerGetScopeStats( ProfileScopeStats *a_pStats, u32 dwMaxStats )
+{
+	u32 dwNumThreads = ProfilerNumThreads();
+	ProfileEvent *pEvents = (ProfileEvent*)malloc( sizeof(ProfileEvent) * PROFILER_RING_SIZE * PROFILER_MAX_THREADS );
+	if( !pEvents )
+	{
+		return 0;
+	}
+	u32 dwNumEvents = 0;
+	for( u32 dwThread = 0; dwThread < dwNumThreads; ++dwThread )
+	{
+		dwNumEvents += ProfilerSnapshotRing( &profiler.threadRings[dwThread], pEvents + dwNumEvents );
+	}
+	qsort( pEvents, dwNumEvents, sizeof(ProfileEvent), CompareProfileEvents );
+
+	f64 fTscPerUs = ProfilerCalibrate();
+	u32 dwNumStats = 0;
+	u32 dwGroupStart = 0;
+	while( dwGroupStart < dwNumEvents && dwNumStats < dwMaxStats )
+	{
+		u32 dwGroupEnd = dwGroupStart;
+		u64 qwSum = 0;
+		while( dwGroupEnd < dwNumEvents && pEvents[dwGroupEnd].pName == pEvents[dwGroupStart].pName )
+		{
+			qwSum += pEvents[dwGroupEnd].qwEndTsc - pEvents[dwGroupEnd].qwStartTsc;
+			++dwGroupEnd;
+		}
+		u32 dwCount = dwGroupEnd - dwGroupStart;
+		ProfileEvent *pGroup = &pEvents[dwGroupStart]; //sorted by duration within the group
+		ProfileScopeStats *pStats = &a_pStats[dwNumStats++];
+		pStats->pName = pGroup->pName;
+		pStats->dwCount = dwCount;
+		pStats->fAvgUs = ( qwSum / (f64)dwCount ) / fTscPerUs;
+		pStats->fP50Us = ( pGroup[( dwCount - 1 ) / 2].qwEndTsc - pGroup[( dwCount - 1 ) / 2].qwStartTsc ) / fTscPerUs;
+		pStats->fP99Us = ( pGroup[( ( dwCount - 1 ) * 99 ) / 100].qwEndTsc - pGroup[( ( dwCount - 1 ) * 99 ) / 100].qwStartTsc ) / fTscPerUs;
+		pStats->fMaxUs = ( pGroup[dwCount - 1].qwEndTsc - pGroup[dwCount - 1].qwStartTsc ) / fTscPerUs;
+		dwGroupStart = dwGroupEnd;
+	}
+	free( pEvents );
+	return dwNumStats;
+}
+
+#if MAIN_DEBUG
+inline
+void ProfilerPrintReport()
+{
+	ProfileScopeStats stats[PROFILER_MAX_SCOPES];
+	u32 dwNumStats = ProfilerGetScopeStats( stats, PROFILER_MAX_SCOPES );
+	printf( "%-24s %8s %10s %10s %10s %10s\n", "scope", "count", "avg us", "p50 us", "p99 us", "max us" );
+	for( u32 dwStat = 0; dwStat < dwNumStats; ++dwStat )
+	{
+		printf( "%-24s %8u %10.2f %10.2f %10.2f %10.2f\n", stats[dwStat].pName, stats[dwStat].dwCount, stats[dwStat].fAvgUs, stats[dwStat].fP50Us, stats[dwStat].fP99Us, stats[dwStat].fMaxUs );
+	}
+}
+
+//chrome trace event format, one complete ("X") event per scope, one tid per registered thread
+inline
+bool ProfilerWriteChromeTrace( const char *pFileName )
+{
+	FILE *pFile;
+	if( fopen_s( &pFile, pFileName, "w" ) != 0 )
+	{
+		return false;
+	}
+	ProfileEvent *pEvents = (ProfileEvent*)malloc( sizeof(ProfileEvent) * PROFILER_RING_SIZE );
+	if( !pEvents )
+	{
+		fclose( pFile );
+		return false;
+	}
+	f64 fTscPerUs = ProfilerCalibrate();
+	fprintf( pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+	bool bFirst = true;
+	u32 dwNumThreads = ProfilerNumThreads();
+	for( u32 dwThread = 0; dwThread < dwNumThreads; ++dwThread )
+	{
+		ProfilerThreadRing *pRing = &profiler.threadRings[dwThread];
+		fprintf( pFile, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", bFirst ? "" : ",\n", pRing->dwThreadIdx, pRing->pThreadName );
+		bFirst = false;
+		u32 dwNumEvents = ProfilerSnapshotRing( pRing, pEvents );
+		for( u32 dwEvent = 0; dwEvent < dwNumEvents; ++dwEvent )
+		{
+			f64 fStartUs = ( (s64)( pEvents[dwEvent].qwStartTsc - profiler.qwStartTsc ) ) / fTscPerUs;
+			f64 fDurUs = ( pEvents[dwEvent].qwEndTsc - pEvents[dwEvent].qwStartTsc ) / fTscPerUs;
+			fprintf( pFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", pEvents[dwEvent].pName, pRing->dwThreadIdx, fStartUs, fDurUs );
+		}
+	}
+	fprintf( pFile, "\n]}\n" );
+	free( pEvents );
+	fclose( pFile );
+	return true;
+}
+#endif
+
+#if BENCHMARK_MODE
+void BenchmarkProfiler()
+{
+	ProfilerRegisterThread( "Benchmark" );
+	const u32 dwNumScopes = 1000000;
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwScope = 0; dwScope < dwNumScopes; ++dwScope )
+	{
+		PROFILE_SCOPE( "Empty" );
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fNsPerScope = ( 1000000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwNumScopes );
+
+	//rdtsc is most of the cost and is much slower under a hypervisor, so print it too
+	volatile u64 qwTscSink = 0;
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwScope = 0; dwScope < dwNumScopes; ++dwScope )
+	{
+		qwTscSink += __rdtsc();
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fNsPerTsc = ( 1000000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwNumScopes );
+	printf( "Profiler: %.1fns per scope (begin+end marker), %.1fns per rdtsc\n", fNsPerScope, fNsPerTsc );
+
+	//something with a known length to sanity check the calibration against
+	for( u32 dwFrame = 0; dwFrame < 20; ++dwFrame )
+	{
+		PROFILE_SCOPE( "Sleep1ms" );
+		Sleep( 1 );
+	}
+	ProfilerPrintReport();
+	if( ProfilerWriteChromeTrace( "BasicOVRBenchmark.trace.json" ) )
+	{
+		printf( "Profiler: wrote BasicOVRBenchmark.trace.json\n" );
+	}
+}
+#endif
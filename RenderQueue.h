@@ -0,0 +1,1275 @@
+//Render queue, every draw becomes a 64 bit sort key (pass, pipeline, root signature, geometry and its LOD level, palette, depth) plus its draw list index,
+//a radix sort per frame puts draws that share state next to each other and submission goes through a backend that remembers
+//what is bound and skips setting it again. a backend without a command list is the null backend, it counts everything so the
+//benchmark can measure state changes and API calls saved without a device, and given a RenderCommandStream it also records what it
+//would have sent, which SoftRaster.h replays to render a frame without a gpu.
+//a mesh queued at least RENDER_INSTANCE_MIN_DRAWS times goes through the instanced pipelines instead, its sorted run becomes one
+//DrawIndexedInstanced reading a RenderInstance per draw from this frame's instance buffer
+//the transforms of the remaining static draws go one of three ways (RenderDrawDataMode): 27 root constants per draw, or a RenderDrawData
+//written once per frame for both eyes that each draw points at with a root cbv or a single root constant indexing a structured buffer
+
+#if AVX_ACTIVE
+#include <immintrin.h>
+#endif
+
+#define RENDER_KEY_PASS_SHIFT 62
+#define RENDER_KEY_PIPELINE_SHIFT 56
+#define RENDER_KEY_ROOT_SIGNATURE_SHIFT 52
+#define RENDER_KEY_MESH_SHIFT 42
+#define RENDER_KEY_LOD_SHIFT 40
+#define RENDER_KEY_PALETTE_SHIFT 32
+#define RENDER_KEY_DEPTH_SHIFT 16 //the low 16 bits are spare, the radix sort skips digits that never change anyway
+#define RENDER_CONSTANTS_NONE 0
+#define RENDER_CONSTANTS_VIEW_PROJ 1 //the vertex constants hold just the view projection, what every skinned or instanced draw wants
+#define RENDER_MAX_MESHES 1024 //what the key's mesh bits hold
+#define RENDER_INSTANCE_MIN_DRAWS 2
+#define RENDER_DRAW_DATA_MIN_DRAWS 8 //RenderDrawDataPickMode stays on root constants below this, a buffer isn't worth binding for a few draws
+#define RENDER_DRAW_DATA_CBV_SIZE 256 //D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, each root cbv draw gets a whole one
+#define RENDER_VERTEX_CONSTANTS_SIZE ( ( ( 4 * 4 ) + ( ( 4 * 2 ) + 3 ) ) * 4 ) //vertexShaderCB as root constants
+#define RENDER_DRAW_INDEX_OFFSET ( 4 * 4 ) //32 bit value after the view projection, the draw's RenderDrawData index
+
+enum RenderPass
+{
+	RENDER_PASS_OPAQUE,
+	RENDER_PASS_COUNT
+};
+
+enum RenderPipeline
+{
+	//each instanced pipeline follows its plain one, BuildSceneRenderQueue just adds 1 to switch a draw over
+	RENDER_PIPELINE_STATIC,
+	RENDER_PIPELINE_STATIC_INSTANCED,
+	RENDER_PIPELINE_SKINNED,
+	RENDER_PIPELINE_SKINNED_INSTANCED,
+	RENDER_PIPELINE_COUNT
+};
+
+//the VertexShader.hlsl DRAW_DATA each static pipeline is compiled with
+enum RenderDrawDataMode
+{
+	RENDER_DRAW_DATA_ROOT_CONSTANTS, //mvp and normal matrix pushed per draw, no memory behind them
+	RENDER_DRAW_DATA_ROOT_CBV, //a root cbv per draw into the frame's draw data, RENDER_DRAW_DATA_CBV_SIZE apart
+	RENDER_DRAW_DATA_INDEX, //one root constant per draw indexing the frame's draw data as a structured buffer
+	RENDER_DRAW_DATA_MODE_COUNT
+};
+
+enum RenderRootSignature
+{
+	RENDER_ROOT_SIGNATURE_STATIC,
+	RENDER_ROOT_SIGNATURE_SKINNED,
+	RENDER_ROOT_SIGNATURE_COUNT
+};
+
+//per instance vertex data (INSTANCE_VB_SLOT), 128 bytes so the stride stays a power of 2
+typedef struct RenderInstance
+{
+	Mat4f mWorld; //WORLD0-3
+	Mat3x4f mNormal; //NORMALMAT0-2, the 4th column is padding
+	u32 dwPalette; //PALETTE, skinned instances index the frame's bone buffer with it and ignore the matrices
+	u32 dwPad[3];
+} RenderInstance;
+
+//per draw transforms in the frame's draw data buffer, the same 80 bytes read as a cbv (b2) or structured buffer element (t0), the view
+//projection stays in the root constants so one copy serves both eyes. the normal matrix only needs its direction (the pixel shader
+//normalizes), so it is scaled to a largest element of 1 and stored as 9 halves
+typedef struct RenderDrawData
+{
+	Vec4f vWorldColumns[3]; //x, y and z columns of the world matrix, the w column is always 0,0,0,1
+	u32 dwNormalHalves[5]; //rows of the normal matrix, 2 halves per u32 with the low one first
+	u32 dwPad[3];
+} RenderDrawData;
+
+typedef struct RenderQueue
+{
+	u64 *pKeys;
+	u32 *pItems; //draw list index of each key
+	u64 *pTempKeys; //radix sort ping pong
+	u32 *pTempItems;
+	u32 *pInstances; //instance buffer index of each sorted instanced entry (RenderQueueWriteInstances), draw data index of the others (RenderQueueWriteDrawData)
+	u32 dwCount;
+	u32 dwCapacity;
+} RenderQueue;
+
+typedef struct RenderStats
+{
+	u32 dwNumDraws; //draw calls
+	u32 dwNumInstances; //what those draw calls drew, the same as dwNumDraws without instancing
+	u32 dwNumStateChanges; //pipeline, root signature, vertex/index buffer or palette actually bound
+	u32 dwNumApiCalls; //everything recorded, draws and constants included
+	u32 dwNumApiCallsSaved; //binds skipped because that state was already bound
+	u32 dwNumRootBytes; //root arguments pushed, constants at 4 bytes a value and root views at 8
+} RenderStats;
+
+//everything a key or draw index refers to, filled in by whoever owns the D3D objects
+typedef struct RenderResources
+{
+	ID3D12PipelineState *pPipelines[RENDER_PIPELINE_COUNT];
+	ID3D12RootSignature *pRootSignatures[RENDER_ROOT_SIGNATURE_COUNT];
+	D3D12_VERTEX_BUFFER_VIEW **ppVertexBuffers; //per mesh
+	D3D12_INDEX_BUFFER_VIEW **ppIndexBuffers;
+	MeshIndices **ppMeshIndices; //the parts each draw of the mesh becomes, see MeshIndices.h
+	D3D12_GPU_VIRTUAL_ADDRESS *pPalettes; //this frame's bone buffer per palette, back to back so instanced draws index from pPalettes[0]
+	D3D12_VERTEX_BUFFER_VIEW *pInstanceBuffer; //this frame's RenderInstances
+	pixelShaderCB *pPixelConstants;
+	u32 dwDrawDataMode; //RenderDrawDataMode of the plain static draws, the indirect and instanced ones always use pPipelines
+	ID3D12PipelineState *pDrawDataPipelines[RENDER_DRAW_DATA_MODE_COUNT]; //the static pipeline for each mode, [0] is pPipelines[RENDER_PIPELINE_STATIC]
+	D3D12_GPU_VIRTUAL_ADDRESS qwDrawData; //this frame's RenderDrawData, from RenderQueueWriteDrawData
+} RenderResources;
+
+//what the null backend records, one per call the command list would have gotten
+enum RenderCommandType
+{
+	RENDER_COMMAND_PIPELINE, //qwArg is the ID3D12PipelineState
+	RENDER_COMMAND_ROOT_SIGNATURE, //qwArg is the ID3D12RootSignature, dwArgs[0] where the pixel constants set with it are in the data
+	RENDER_COMMAND_VERTEX_BUFFER, //qwArg BufferLocation, dwArgs SizeInBytes, StrideInBytes and the slot
+	RENDER_COMMAND_INDEX_BUFFER, //qwArg BufferLocation, dwArgs SizeInBytes and Format
+	RENDER_COMMAND_SHADER_RESOURCE, //qwArg is the VERTEX_SB_ROOT_SLOT address
+	RENDER_COMMAND_CONSTANT_BUFFER, //qwArg is the VERTEX_DRAW_CBV_ROOT_SLOT address
+	RENDER_COMMAND_VERTEX_CONSTANTS, //dwArgs where the values are in the data, how many and the first one they overwrite
+	RENDER_COMMAND_VIEWPORT, //dwArgs[0] where a D3D12_VIEWPORT and its D3D12_RECT scissor are in the data
+	RENDER_COMMAND_DRAW_INDEXED //dwArgs are DrawIndexedInstanced's in order
+};
+
+typedef struct RenderCommand
+{
+	u32 dwType; //RenderCommandType
+	u32 dwArgs[5];
+	u64 qwArg;
+} RenderCommand;
+
+//fixed size, a frame that doesn't fit sets bOverflow and whatever didn't fit is dropped
+typedef struct RenderCommandStream
+{
+	RenderCommand *pCommands;
+	u8 *pData; //root constants and viewports by value, the commands point into it
+	u32 dwNumCommands;
+	u32 dwCommandCapacity;
+	u32 dwDataSize;
+	u32 dwDataCapacity;
+	u8 bOverflow;
+} RenderCommandStream;
+
+typedef struct RenderBackend
+{
+	ID3D12GraphicsCommandList *pCommandList; //null for the null backend
+	RenderCommandStream *pStream; //null backend only, where it records to if anywhere
+	//what is bound right now
+	ID3D12PipelineState *pPipeline;
+	ID3D12RootSignature *pRootSignature;
+	D3D12_VERTEX_BUFFER_VIEW *pVertexBuffer;
+	D3D12_INDEX_BUFFER_VIEW *pIndexBuffer;
+	D3D12_VERTEX_BUFFER_VIEW *pInstanceBuffer;
+	D3D12_GPU_VIRTUAL_ADDRESS qwPalette;
+	u32 dwConstants; //RENDER_CONSTANTS_*, per draw constants are never reused
+	RenderStats stats;
+} RenderBackend;
+
+inline
+bool InitRenderQueue( RenderQueue *a_pQueue, u32 dwCapacity )
+{
+	a_pQueue->dwCapacity = dwCapacity;
+	a_pQueue->dwCount = 0;
+	a_pQueue->pKeys = (u64*)malloc( ( ( 2 * sizeof(u64) ) + ( 3 * sizeof(u32) ) ) * dwCapacity );
+	if( !a_pQueue->pKeys )
+	{
+		return false;
+	}
+	a_pQueue->pTempKeys = a_pQueue->pKeys + dwCapacity;
+	a_pQueue->pItems = (u32*)( a_pQueue->pTempKeys + dwCapacity );
+	a_pQueue->pTempItems = a_pQueue->pItems + dwCapacity;
+	a_pQueue->pInstances = a_pQueue->pTempItems + dwCapacity;
+	return true;
+}
+
+inline
+void DestroyRenderQueue( RenderQueue *a_pQueue )
+{
+	//the sort swaps the key and temp arrays, the allocation starts at whichever is lower
+	free( a_pQueue->pKeys < a_pQueue->pTempKeys ? a_pQueue->pKeys : a_pQueue->pTempKeys );
+	a_pQueue->pKeys = nullptr;
+}
+
+inline
+u64 RenderSortKey( u32 dwPass, u32 dwPipeline, u32 dwRootSignature, u32 dwMesh, u32 dwLod, u32 dwPalette, u32 dwDepth )
+{
+	return ( (u64)dwPass << RENDER_KEY_PASS_SHIFT ) | ( (u64)( dwPipeline & 0x3f ) << RENDER_KEY_PIPELINE_SHIFT ) |
+		( (u64)( dwRootSignature & 0xf ) << RENDER_KEY_ROOT_SIGNATURE_SHIFT ) | ( (u64)( dwMesh & 0x3ff ) << RENDER_KEY_MESH_SHIFT ) |
+		( (u64)( dwLod & 0x3 ) << RENDER_KEY_LOD_SHIFT ) | ( (u64)( dwPalette & 0xff ) << RENDER_KEY_PALETTE_SHIFT ) |
+		( (u64)( dwDepth & 0xffff ) << RENDER_KEY_DEPTH_SHIFT );
+}
+
+inline
+u32 RenderKeyPipeline( u64 qwKey )
+{
+	return (u32)( qwKey >> RENDER_KEY_PIPELINE_SHIFT ) & 0x3f;
+}
+
+inline
+u32 RenderKeyRootSignature( u64 qwKey )
+{
+	return (u32)( qwKey >> RENDER_KEY_ROOT_SIGNATURE_SHIFT ) & 0xf;
+}
+
+inline
+u32 RenderKeyMesh( u64 qwKey )
+{
+	return (u32)( qwKey >> RENDER_KEY_MESH_SHIFT ) & 0x3ff;
+}
+
+inline
+u32 RenderKeyLod( u64 qwKey )
+{
+	return (u32)( qwKey >> RENDER_KEY_LOD_SHIFT ) & 0x3;
+}
+
+inline
+bool RenderPipelineInstanced( u32 dwPipeline )
+{
+	return dwPipeline == RENDER_PIPELINE_STATIC_INSTANCED || dwPipeline == RENDER_PIPELINE_SKINNED_INSTANCED;
+}
+
+//positive floats order the same as their bits, the top 16 of the 31 that aren't sign keep about 3 digits of precision
+inline
+u32 RenderDepthKey( f32 fDistSq )
+{
+	u32 dwBits;
+	memcpy( &dwBits, &fDistSq, sizeof(u32) );
+	return dwBits >> 15;
+}
+
+inline
+void RenderQueuePush( RenderQueue *a_pQueue, u64 qwKey, u32 dwItem )
+{
+#if MAIN_DEBUG
+	assert( a_pQueue->dwCount < a_pQueue->dwCapacity );
+#endif
+	a_pQueue->pKeys[a_pQueue->dwCount] = qwKey;
+	a_pQueue->pItems[a_pQueue->dwCount++] = dwItem;
+}
+
+//LSD radix sort on bytes, all 8 histograms come from one pass over the keys and bytes every key agrees on are skipped,
+//which with a handful of pipelines and meshes leaves 3 or 4 scatter passes. stable, so equal keys keep push order
+inline
+void RenderQueueSort( RenderQueue *a_pQueue )
+{
+	u32 dwCount = a_pQueue->dwCount;
+	if( dwCount < 2 )
+	{
+		return;
+	}
+	u32 dwHistograms[8][256];
+	memset( dwHistograms, 0, sizeof( dwHistograms ) );
+	for( u32 dwIdx = 0; dwIdx < dwCount; ++dwIdx )
+	{
+		u64 qwKey = a_pQueue->pKeys[dwIdx];
+		for( u32 dwByte = 0; dwByte < 8; ++dwByte )
+		{
+			++dwHistograms[dwByte][( qwKey >> ( dwByte * 8 ) ) & 0xff];
+		}
+	}
+	for( u32 dwByte = 0; dwByte < 8; ++dwByte )
+	{
+		u32 *pHistogram = dwHistograms[dwByte];
+		u32 dwShift = dwByte * 8;
+		if( pHistogram[( a_pQueue->pKeys[0] >> dwShift ) & 0xff] == dwCount )
+		{
+			continue;
+		}
+		u32 dwSum = 0;
+		for( u32 dwDigit = 0; dwDigit < 256; ++dwDigit )
+		{
+			u32 dwDigitCount = pHistogram[dwDigit];
+			pHistogram[dwDigit] = dwSum;
+			dwSum += dwDigitCount;
+		}
+		u64 *pKeys = a_pQueue->pKeys;
+		u32 *pItems = a_pQueue->pItems;
+		u64 *pTempKeys = a_pQueue->pTempKeys;
+		u32 *pTempItems = a_pQueue->pTempItems;
+		for( u32 dwIdx = 0; dwIdx < dwCount; ++dwIdx )
+		{
+			u32 dwDst = pHistogram[( pKeys[dwIdx] >> dwShift ) & 0xff]++;
+			pTempKeys[dwDst] = pKeys[dwIdx];
+			pTempItems[dwDst] = pItems[dwIdx];
+		}
+		a_pQueue->pKeys = pTempKeys;
+		a_pQueue->pItems = pTempItems;
+		a_pQueue->pTempKeys = pKeys;
+		a_pQueue->pTempItems = pItems;
+	}
+}
+
+//first sorted entry with a key >= qwKey, RenderSortKey( pass, pipeline, 0, 0, 0, 0 ) finds where a pipeline starts
+inline
+u32 RenderQueueLowerBound( RenderQueue *a_pQueue, u64 qwKey )
+{
+	u32 dwLow = 0;
+	u32 dwHigh = a_pQueue->dwCount;
+	while( dwLow < dwHigh )
+	{
+		u32 dwMid = ( dwLow + dwHigh ) >> 1;
+		if( a_pQueue->pKeys[dwMid] < qwKey )
+		{
+			dwLow = dwMid + 1;
+		}
+		else
+		{
+			dwHigh = dwMid;
+		}
+	}
+	return dwLow;
+}
+
+//one queue for both eyes, a draw goes in if either eye sees it (each eye skips the rest at submit) and its palette is tracked,
+//opaque draws sort front to back from the center eye within the same state. with bInstancing every mesh that got enough draws
+//is moved to its instanced pipeline, those draws are submitted to both eyes and the rasterizer drops what one eye doesn't see
+inline
+void BuildSceneRenderQueue( RenderQueue *a_pQueue, SceneDrawList *a_pDraws, u8 *a_pLeftVisible, u8 *a_pRightVisible, u8 *a_pPalettePresent, Vec3f *a_pEye,
+	u8 bInstancing )
+{
+	a_pQueue->dwCount = 0;
+	for( u32 dwDraw = 0; dwDraw < a_pDraws->dwCount; ++dwDraw )
+	{
+		if( !CullIsVisible( a_pLeftVisible, dwDraw ) && !CullIsVisible( a_pRightVisible, dwDraw ) )
+		{
+			continue;
+		}
+		u32 dwPalette = a_pDraws->pPalette[dwDraw];
+		if( dwPalette != ENTITY_NONE && !a_pPalettePresent[dwPalette] )
+		{
+			continue;
+		}
+		Mat4f *pWorld = &a_pDraws->pWorld[dwDraw];
+		f32 fDX = pWorld->m[3][0] - a_pEye->x;
+		f32 fDY = pWorld->m[3][1] - a_pEye->y;
+		f32 fDZ = pWorld->m[3][2] - a_pEye->z;
+		u32 dwDepth = RenderDepthKey( ( fDX * fDX ) + ( fDY * fDY ) + ( fDZ * fDZ ) );
+		u64 qwKey = dwPalette == ENTITY_NONE ?
+			RenderSortKey( RENDER_PASS_OPAQUE, RENDER_PIPELINE_STATIC, RENDER_ROOT_SIGNATURE_STATIC, a_pDraws->pMesh[dwDraw], a_pDraws->pLod[dwDraw], 0, dwDepth ) :
+			RenderSortKey( RENDER_PASS_OPAQUE, RENDER_PIPELINE_SKINNED, RENDER_ROOT_SIGNATURE_SKINNED, a_pDraws->pMesh[dwDraw], a_pDraws->pLod[dwDraw], dwPalette, dwDepth );
+		RenderQueuePush( a_pQueue, qwKey, dwDraw );
+	}
+	if( !bInstancing )
+	{
+		return;
+	}
+	//counted per mesh and level, different levels are different index ranges and can't share a draw
+	u32 dwMeshDraws[RENDER_MAX_MESHES * MESH_LOD_MAX_LEVELS];
+	memset( dwMeshDraws, 0, sizeof( dwMeshDraws ) );
+	for( u32 dwIdx = 0; dwIdx < a_pQueue->dwCount; ++dwIdx )
+	{
+		++dwMeshDraws[(u32)( a_pQueue->pKeys[dwIdx] >> RENDER_KEY_LOD_SHIFT ) & 0xfff];
+	}
+	for( u32 dwIdx = 0; dwIdx < a_pQueue->dwCount; ++dwIdx )
+	{
+		if( dwMeshDraws[(u32)( a_pQueue->pKeys[dwIdx] >> RENDER_KEY_LOD_SHIFT ) & 0xfff] >= RENDER_INSTANCE_MIN_DRAWS )
+		{
+			a_pQueue->pKeys[dwIdx] += 1ull << RENDER_KEY_PIPELINE_SHIFT;
+		}
+	}
+}
+
+//after the sort, writes a RenderInstance per instanced entry in sorted order so each run's instances are contiguous, once per
+//frame for both eyes. a_pInstances is write combined upload memory, every instance goes out whole and in order. returns the count
+inline
+u32 RenderQueueWriteInstances( RenderQueue *a_pQueue, SceneDrawList *a_pDraws, RenderInstance *a_pInstances )
+{
+	u32 dwNumInstances = 0;
+	RenderInstance instance;
+	memset( &instance, 0, sizeof( RenderInstance ) );
+	for( u32 dwIdx = 0; dwIdx < a_pQueue->dwCount; ++dwIdx )
+	{
+		if( !RenderPipelineInstanced( RenderKeyPipeline( a_pQueue->pKeys[dwIdx] ) ) )
+		{
+			continue;
+		}
+		u32 dwDraw = a_pQueue->pItems[dwIdx];
+		instance.mWorld = a_pDraws->pWorld[dwDraw];
+		instance.mNormal = a_pDraws->pNormal[dwDraw];
+		instance.dwPalette = a_pDraws->pPalette[dwDraw] == ENTITY_NONE ? 0 : a_pDraws->pPalette[dwDraw];
+		a_pQueue->pInstances[dwIdx] = dwNumInstances;
+		a_pInstances[dwNumInstances++] = instance;
+	}
+	return dwNumInstances;
+}
+
+//round to nearest even, too small for a normal half flushes to 0 and too big becomes infinity
+inline
+u16 F32ToF16( f32 fValue )
+{
+	u32 dwBits;
+	memcpy( &dwBits, &fValue, sizeof( u32 ) );
+	u32 dwSign = ( dwBits >> 16 ) & 0x8000;
+	s32 iExponent = (s32)( ( dwBits >> 23 ) & 0xff ) - 127 + 15;
+	u32 dwMantissa = dwBits & 0x7fffff;
+	if( iExponent <= 0 )
+	{
+		return (u16)dwSign;
+	}
+	if( iExponent >= 31 )
+	{
+		return (u16)( dwSign | 0x7c00 );
+	}
+	u32 dwHalf = dwSign | ( (u32)iExponent << 10 ) | ( dwMantissa >> 13 );
+	u32 dwRest = dwMantissa & 0x1fff;
+	if( dwRest > 0x1000 || ( dwRest == 0x1000 && ( dwHalf & 1 ) ) )
+	{
+		++dwHalf; //a carry out of the mantissa bumps the exponent, which is what rounding up wants
+	}
+	return (u16)dwHalf;
+}
+
+//what the shader's f16tof32 gives for anything F32ToF16 makes
+inline
+f32 F16ToF32( u16 wHalf )
+{
+	u32 dwSign = (u32)( wHalf & 0x8000 ) << 16;
+	u32 dwExponent = ( wHalf >> 10 ) & 0x1f;
+	u32 dwMantissa = wHalf & 0x3ff;
+	u32 dwBits = dwSign;
+	if( dwExponent == 31 )
+	{
+		dwBits |= 0x7f800000 | ( dwMantissa << 13 );
+	}
+	else if( dwExponent )
+	{
+		dwBits |= ( ( dwExponent - 15 + 127 ) << 23 ) | ( dwMantissa << 13 );
+	}
+	f32 fValue;
+	memcpy( &fValue, &dwBits, sizeof( f32 ) );
+	return fValue;
+}
+
+inline
+void PackRenderDrawData( Mat4f *a_pWorld, Mat3x4f *a_pNormal, RenderDrawData *a_pData )
+{
+	for( u32 dwColumn = 0; dwColumn < 3; ++dwColumn )
+	{
+		for( u32 dwRow = 0; dwRow < 4; ++dwRow )
+		{
+			a_pData->vWorldColumns[dwColumn].v[dwRow] = a_pWorld->m[dwRow][dwColumn];
+		}
+	}
+	f32 fElements[9];
+	f32 fLargest = 0.0f;
+	for( u32 dwElement = 0; dwElement < 9; ++dwElement )
+	{
+		fElements[dwElement] = a_pNormal->m[dwElement / 3][dwElement % 3];
+		f32 fAbs = fabsf( fElements[dwElement] );
+		fLargest = fAbs > fLargest ? fAbs : fLargest;
+	}
+	f32 fScale = fLargest > 0.0f ? 1.0f / fLargest : 0.0f;
+#if AVX_ACTIVE
+	//F16C rounds the same way, but keeps what is too small for a normal half as a denormal instead of flushing it
+	__m256 vScale = _mm256_set1_ps( fScale );
+	_mm_storeu_si128( (__m128i*)a_pData->dwNormalHalves, _mm256_cvtps_ph( _mm256_mul_ps( _mm256_loadu_ps( fElements ), vScale ), _MM_FROUND_TO_NEAREST_INT ) );
+	a_pData->dwNormalHalves[4] = (u32)_mm_extract_epi16( _mm_cvtps_ph( _mm_set_ss( fElements[8] * fScale ), _MM_FROUND_TO_NEAREST_INT ), 0 );
+#else
+	u16 wHalves[10];
+	for( u32 dwElement = 0; dwElement < 9; ++dwElement )
+	{
+		wHalves[dwElement] = F32ToF16( fElements[dwElement] * fScale );
+	}
+	wHalves[9] = 0;
+	for( u32 dwPair = 0; dwPair < 5; ++dwPair )
+	{
+		a_pData->dwNormalHalves[dwPair] = (u32)wHalves[dwPair * 2] | ( (u32)wHalves[( dwPair * 2 ) + 1] << 16 );
+	}
+#endif
+	a_pData->dwPad[0] = 0;
+	a_pData->dwPad[1] = 0;
+	a_pData->dwPad[2] = 0;
+}
+
+//the plain static draws in the queue, the only ones with per draw transforms
+inline
+u32 RenderQueueCountDrawData( RenderQueue *a_pQueue )
+{
+	u32 dwCount = 0;
+	for( u32 dwIdx = 0; dwIdx < a_pQueue->dwCount; ++dwIdx )
+	{
+		dwCount += RenderKeyPipeline( a_pQueue->pKeys[dwIdx] ) == RENDER_PIPELINE_STATIC ? 1 : 0;
+	}
+	return dwCount;
+}
+
+//buffers have a fixed cost per eye (binding one, and the cbv's 256 byte stride), root constants cost RENDER_VERTEX_CONSTANTS_SIZE every draw
+inline
+u32 RenderDrawDataPickMode( u32 dwNumDrawData )
+{
+	return dwNumDrawData < RENDER_DRAW_DATA_MIN_DRAWS ? RENDER_DRAW_DATA_ROOT_CONSTANTS : RENDER_DRAW_DATA_INDEX;
+}
+
+//after the sort, like RenderQueueWriteInstances: a RenderDrawData per plain static entry dwStride apart (RENDER_DRAW_DATA_CBV_SIZE for
+//root cbvs, sizeof( RenderDrawData ) for the structured buffer), once per frame for both eyes. returns the count
+inline
+u32 RenderQueueWriteDrawData( RenderQueue *a_pQueue, SceneDrawList *a_pDraws, u8 *a_pDrawData, u32 dwStride )
+{
+	u32 dwNumDrawData = 0;
+	RenderDrawData drawData;
+	for( u32 dwIdx = 0; dwIdx < a_pQueue->dwCount; ++dwIdx )
+	{
+		if( RenderKeyPipeline( a_pQueue->pKeys[dwIdx] ) != RENDER_PIPELINE_STATIC )
+		{
+			continue;
+		}
+		u32 dwDraw = a_pQueue->pItems[dwIdx];
+		PackRenderDrawData( &a_pDraws->pWorld[dwDraw], &a_pDraws->pNormal[dwDraw], &drawData );
+		a_pQueue->pInstances[dwIdx] = dwNumDrawData;
+		memcpy( a_pDrawData + ( (u64)dwNumDrawData * dwStride ), &drawData, sizeof( RenderDrawData ) );
+		++dwNumDrawData;
+	}
+	return dwNumDrawData;
+}
+
+inline
+bool InitRenderCommandStream( RenderCommandStream *a_pStream, u32 dwCommandCapacity, u32 dwDataCapacity )
+{
+	a_pStream->pCommands = (RenderCommand*)malloc( ( sizeof( RenderCommand ) * dwCommandCapacity ) + dwDataCapacity );
+	if( !a_pStream->pCommands )
+	{
+		return false;
+	}
+	a_pStream->pData = (u8*)( a_pStream->pCommands + dwCommandCapacity );
+	a_pStream->dwCommandCapacity = dwCommandCapacity;
+	a_pStream->dwDataCapacity = dwDataCapacity;
+	a_pStream->dwNumCommands = 0;
+	a_pStream->dwDataSize = 0;
+	a_pStream->bOverflow = 0;
+	return true;
+}
+
+inline
+void DestroyRenderCommandStream( RenderCommandStream *a_pStream )
+{
+	free( a_pStream->pCommands );
+	a_pStream->pCommands = nullptr;
+}
+
+//the next command of a recording null backend, null when it isn't recording or the stream is full
+inline
+RenderCommand *RenderRecord( RenderBackend *a_pBackend, u32 dwType, u64 qwArg )
+{
+	RenderCommandStream *pStream = a_pBackend->pStream;
+	if( !pStream )
+	{
+		return nullptr;
+	}
+	if( pStream->dwNumCommands == pStream->dwCommandCapacity )
+	{
+		pStream->bOverflow = 1;
+		return nullptr;
+	}
+	RenderCommand *pCommand = &pStream->pCommands[pStream->dwNumCommands++];
+	memset( pCommand, 0, sizeof( RenderCommand ) );
+	pCommand->dwType = dwType;
+	pCommand->qwArg = qwArg;
+	return pCommand;
+}
+
+//copies what a command points at into the stream, returns where it went
+inline
+u32 RenderRecordData( RenderCommandStream *a_pStream, const void *a_pData, u32 dwSize )
+{
+	u32 dwOffset = ( a_pStream->dwDataSize + 3 ) & ~3u;
+	if( dwOffset + dwSize > a_pStream->dwDataCapacity )
+	{
+		a_pStream->bOverflow = 1;
+		return 0;
+	}
+	memcpy( a_pStream->pData + dwOffset, a_pData, dwSize );
+	a_pStream->dwDataSize = dwOffset + dwSize;
+	return dwOffset;
+}
+
+//the command list's Reset already bound pInitialPipeline, nothing else is bound yet
+inline
+void RenderBackendBegin( RenderBackend *a_pBackend, ID3D12GraphicsCommandList *a_pCommandList, ID3D12PipelineState *a_pInitialPipeline )
+{
+	a_pBackend->pCommandList = a_pCommandList;
+	a_pBackend->pStream = nullptr;
+	a_pBackend->pPipeline = a_pInitialPipeline;
+	a_pBackend->pRootSignature = nullptr;
+	a_pBackend->pVertexBuffer = nullptr;
+	a_pBackend->pIndexBuffer = nullptr;
+	a_pBackend->pInstanceBuffer = nullptr;
+	a_pBackend->qwPalette = 0;
+	a_pBackend->dwConstants = RENDER_CONSTANTS_NONE;
+	memset( &a_pBackend->stats, 0, sizeof( RenderStats ) );
+}
+
+//a null backend that records into a_pStream from its start, the initial pipeline goes in first like the Reset that would have bound it
+inline
+void RenderBackendBeginRecording( RenderBackend *a_pBackend, RenderCommandStream *a_pStream, ID3D12PipelineState *a_pInitialPipeline )
+{
+	RenderBackendBegin( a_pBackend, nullptr, a_pInitialPipeline );
+	a_pStream->dwNumCommands = 0;
+	a_pStream->dwDataSize = 0;
+	a_pStream->bOverflow = 0;
+	a_pBackend->pStream = a_pStream;
+	RenderRecord( a_pBackend, RENDER_COMMAND_PIPELINE, (u64)a_pInitialPipeline );
+}
+
+inline
+void RenderSetPipeline( RenderBackend *a_pBackend, ID3D12PipelineState *a_pPipeline )
+{
+	if( a_pBackend->pPipeline == a_pPipeline )
+	{
+		++a_pBackend->stats.dwNumApiCallsSaved;
+		return;
+	}
+	a_pBackend->pPipeline = a_pPipeline;
+	++a_pBackend->stats.dwNumStateChanges;
+	++a_pBackend->stats.dwNumApiCalls;
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->SetPipelineState( a_pPipeline );
+	}
+	else
+	{
+		RenderRecord( a_pBackend, RENDER_COMMAND_PIPELINE, (u64)a_pPipeline );
+	}
+}
+
+//root arguments don't survive a root signature change, so the pixel constants go right back in and the rest is forgotten
+inline
+void RenderSetRootSignature( RenderBackend *a_pBackend, RenderResources *a_pResources, ID3D12RootSignature *a_pRootSignature )
+{
+	if( a_pBackend->pRootSignature == a_pRootSignature )
+	{
+		++a_pBackend->stats.dwNumApiCallsSaved;
+		return;
+	}
+	a_pBackend->pRootSignature = a_pRootSignature;
+	a_pBackend->qwPalette = 0;
+	a_pBackend->dwConstants = RENDER_CONSTANTS_NONE;
+	++a_pBackend->stats.dwNumStateChanges;
+	a_pBackend->stats.dwNumApiCalls += 2;
+	a_pBackend->stats.dwNumRootBytes += ( 4 + 3 ) * 4;
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->SetGraphicsRootSignature( a_pRootSignature );
+		a_pBackend->pCommandList->SetGraphicsRoot32BitConstants( PIXEL_CB_ROOT_SLOT, 4 + 3, a_pResources->pPixelConstants, 0 );
+	}
+	else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_ROOT_SIGNATURE, (u64)a_pRootSignature ) )
+	{
+		pCommand->dwArgs[0] = RenderRecordData( a_pBackend->pStream, a_pResources->pPixelConstants, ( 4 + 3 ) * 4 );
+	}
+}
+
+inline
+void RenderSetGeometry( RenderBackend *a_pBackend, D3D12_VERTEX_BUFFER_VIEW *a_pVertexBuffer, D3D12_INDEX_BUFFER_VIEW *a_pIndexBuffer )
+{
+	if( a_pBackend->pVertexBuffer == a_pVertexBuffer )
+	{
+		++a_pBackend->stats.dwNumApiCallsSaved;
+	}
+	else
+	{
+		a_pBackend->pVertexBuffer = a_pVertexBuffer;
+		++a_pBackend->stats.dwNumStateChanges;
+		++a_pBackend->stats.dwNumApiCalls;
+		if( a_pBackend->pCommandList )
+		{
+			a_pBackend->pCommandList->IASetVertexBuffers( MAIN_VB_SLOT, 1, a_pVertexBuffer );
+		}
+		else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_VERTEX_BUFFER, a_pVertexBuffer->BufferLocation ) )
+		{
+			pCommand->dwArgs[0] = a_pVertexBuffer->SizeInBytes;
+			pCommand->dwArgs[1] = a_pVertexBuffer->StrideInBytes;
+			pCommand->dwArgs[2] = MAIN_VB_SLOT;
+		}
+	}
+	if( a_pBackend->pIndexBuffer == a_pIndexBuffer )
+	{
+		++a_pBackend->stats.dwNumApiCallsSaved;
+	}
+	else
+	{
+		a_pBackend->pIndexBuffer = a_pIndexBuffer;
+		++a_pBackend->stats.dwNumStateChanges;
+		++a_pBackend->stats.dwNumApiCalls;
+		if( a_pBackend->pCommandList )
+		{
+			a_pBackend->pCommandList->IASetIndexBuffer( a_pIndexBuffer );
+		}
+		else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_INDEX_BUFFER, a_pIndexBuffer->BufferLocation ) )
+		{
+			pCommand->dwArgs[0] = a_pIndexBuffer->SizeInBytes;
+			pCommand->dwArgs[1] = (u32)a_pIndexBuffer->Format;
+		}
+	}
+}
+
+inline
+void RenderSetInstanceBuffer( RenderBackend *a_pBackend, D3D12_VERTEX_BUFFER_VIEW *a_pInstanceBuffer )
+{
+	if( a_pBackend->pInstanceBuffer == a_pInstanceBuffer )
+	{
+		++a_pBackend->stats.dwNumApiCallsSaved;
+		return;
+	}
+	a_pBackend->pInstanceBuffer = a_pInstanceBuffer;
+	++a_pBackend->stats.dwNumStateChanges;
+	++a_pBackend->stats.dwNumApiCalls;
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->IASetVertexBuffers( INSTANCE_VB_SLOT, 1, a_pInstanceBuffer );
+	}
+	else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_VERTEX_BUFFER, a_pInstanceBuffer->BufferLocation ) )
+	{
+		pCommand->dwArgs[0] = a_pInstanceBuffer->SizeInBytes;
+		pCommand->dwArgs[1] = a_pInstanceBuffer->StrideInBytes;
+		pCommand->dwArgs[2] = INSTANCE_VB_SLOT;
+	}
+}
+
+//VERTEX_SB_ROOT_SLOT, the bone palettes in the skinned root signature and the RENDER_DRAW_DATA_INDEX draw data in the static one
+inline
+void RenderSetPalette( RenderBackend *a_pBackend, D3D12_GPU_VIRTUAL_ADDRESS qwPalette )
+{
+	if( a_pBackend->qwPalette == qwPalette )
+	{
+		++a_pBackend->stats.dwNumApiCallsSaved;
+		return;
+	}
+	a_pBackend->qwPalette = qwPalette;
+	++a_pBackend->stats.dwNumStateChanges;
+	++a_pBackend->stats.dwNumApiCalls;
+	a_pBackend->stats.dwNumRootBytes += sizeof( D3D12_GPU_VIRTUAL_ADDRESS );
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->SetGraphicsRootShaderResourceView( VERTEX_SB_ROOT_SLOT, qwPalette );
+	}
+	else
+	{
+		RenderRecord( a_pBackend, RENDER_COMMAND_SHADER_RESOURCE, qwPalette );
+	}
+}
+
+//dwConstants is RENDER_CONSTANTS_NONE for per draw constants, anything else can be skipped when it is already bound
+inline
+void RenderSetVertexConstants( RenderBackend *a_pBackend, vertexShaderCB *a_pConstants, u32 dwConstants )
+{
+	if( dwConstants != RENDER_CONSTANTS_NONE && a_pBackend->dwConstants == dwConstants )
+	{
+		++a_pBackend->stats.dwNumApiCallsSaved;
+		return;
+	}
+	a_pBackend->dwConstants = dwConstants;
+	++a_pBackend->stats.dwNumApiCalls;
+	a_pBackend->stats.dwNumRootBytes += RENDER_VERTEX_CONSTANTS_SIZE;
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->SetGraphicsRoot32BitConstants( VERTEX_CB_ROOT_SLOT, RENDER_VERTEX_CONSTANTS_SIZE / 4, a_pConstants, 0 );
+	}
+	else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_VERTEX_CONSTANTS, 0 ) )
+	{
+		pCommand->dwArgs[0] = RenderRecordData( a_pBackend->pStream, a_pConstants, RENDER_VERTEX_CONSTANTS_SIZE );
+		pCommand->dwArgs[1] = RENDER_VERTEX_CONSTANTS_SIZE / 4;
+	}
+}
+
+//per draw, never skipped
+inline
+void RenderSetDrawConstantBuffer( RenderBackend *a_pBackend, D3D12_GPU_VIRTUAL_ADDRESS qwDrawData )
+{
+	++a_pBackend->stats.dwNumApiCalls;
+	a_pBackend->stats.dwNumRootBytes += sizeof( D3D12_GPU_VIRTUAL_ADDRESS );
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->SetGraphicsRootConstantBufferView( VERTEX_DRAW_CBV_ROOT_SLOT, qwDrawData );
+	}
+	else
+	{
+		RenderRecord( a_pBackend, RENDER_COMMAND_CONSTANT_BUFFER, qwDrawData );
+	}
+}
+
+//per draw, only the value after the view projection changes so RENDER_CONSTANTS_VIEW_PROJ stays bound
+inline
+void RenderSetDrawIndex( RenderBackend *a_pBackend, u32 dwDrawIndex )
+{
+	++a_pBackend->stats.dwNumApiCalls;
+	a_pBackend->stats.dwNumRootBytes += sizeof( u32 );
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->SetGraphicsRoot32BitConstant( VERTEX_CB_ROOT_SLOT, dwDrawIndex, RENDER_DRAW_INDEX_OFFSET );
+	}
+	else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_VERTEX_CONSTANTS, 0 ) )
+	{
+		pCommand->dwArgs[0] = RenderRecordData( a_pBackend->pStream, &dwDrawIndex, sizeof( u32 ) );
+		pCommand->dwArgs[1] = 1;
+		pCommand->dwArgs[2] = RENDER_DRAW_INDEX_OFFSET;
+	}
+}
+
+//not state the backend tracks, the quadrants of FoveationBindQuadrant and each eye's scaled viewport go through here to be recorded
+inline
+void RenderSetViewport( RenderBackend *a_pBackend, D3D12_VIEWPORT *a_pViewport, D3D12_RECT *a_pScissorRect )
+{
+	a_pBackend->stats.dwNumApiCalls += 2;
+	if( a_pBackend->pCommandList )
+	{
+		a_pBackend->pCommandList->RSSetViewports( 1, a_pViewport );
+		a_pBackend->pCommandList->RSSetScissorRects( 1, a_pScissorRect );
+	}
+	else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_VIEWPORT, 0 ) )
+	{
+		pCommand->dwArgs[0] = RenderRecordData( a_pBackend->pStream, a_pViewport, sizeof( D3D12_VIEWPORT ) );
+		RenderRecordData( a_pBackend->pStream, a_pScissorRect, sizeof( D3D12_RECT ) );
+	}
+}
+
+//a call per part, a mesh only has more than one when it was too big for 16 bit indices
+inline
+void RenderDrawIndexed( RenderBackend *a_pBackend, MeshIndices *a_pMesh, u32 dwInstanceCount, u32 dwFirstInstance )
+{
+	a_pBackend->stats.dwNumDraws += a_pMesh->dwNumParts;
+	a_pBackend->stats.dwNumInstances += dwInstanceCount;
+	a_pBackend->stats.dwNumApiCalls += a_pMesh->dwNumParts;
+	for( u32 dwPart = 0; dwPart < a_pMesh->dwNumParts; ++dwPart )
+	{
+		MeshPart *pPart = &a_pMesh->parts[dwPart];
+		if( a_pBackend->pCommandList )
+		{
+			a_pBackend->pCommandList->DrawIndexedInstanced( pPart->dwIndexCount, dwInstanceCount, pPart->dwFirstIndex, pPart->iBaseVertex, dwFirstInstance );
+		}
+		else if( RenderCommand *pCommand = RenderRecord( a_pBackend, RENDER_COMMAND_DRAW_INDEXED, 0 ) )
+		{
+			pCommand->dwArgs[0] = pPart->dwIndexCount;
+			pCommand->dwArgs[1] = dwInstanceCount;
+			pCommand->dwArgs[2] = pPart->dwFirstIndex;
+			pCommand->dwArgs[3] = (u32)pPart->iBaseVertex;
+			pCommand->dwArgs[4] = dwFirstInstance;
+		}
+	}
+}
+
+//records the sorted entries [dwBegin, dwEnd) that pVisible has set, static draws get their own mvp and normal matrix (or with a
+//buffer dwDrawDataMode the shared view projection and where their RenderDrawData is, see RenderQueueWriteDrawData),
+//skinned ones have their model matrix baked into the palette so they share the view projection and only swap palettes.
+//an instanced entry starts a run of every following entry with the same state up to the palette, drawn with one call
+inline
+void RenderQueueSubmit( RenderQueue *a_pQueue, RenderBackend *a_pBackend, RenderResources *a_pResources, SceneDrawList *a_pDraws,
+	Mat4f *a_pViewProj, u8 *a_pVisible, u32 dwBegin, u32 dwEnd )
+{
+	vertexShaderCB constants;
+	for( u32 dwIdx = dwBegin; dwIdx < dwEnd; ++dwIdx )
+	{
+		u32 dwDraw = a_pQueue->pItems[dwIdx];
+		u64 qwKey = a_pQueue->pKeys[dwIdx];
+		u32 dwPipeline = RenderKeyPipeline( qwKey );
+		if( RenderPipelineInstanced( dwPipeline ) )
+		{
+			u32 dwRunEnd = dwIdx + 1;
+			while( dwRunEnd < dwEnd && ( a_pQueue->pKeys[dwRunEnd] >> RENDER_KEY_LOD_SHIFT ) == ( qwKey >> RENDER_KEY_LOD_SHIFT ) )
+			{
+				++dwRunEnd;
+			}
+			RenderSetRootSignature( a_pBackend, a_pResources, a_pResources->pRootSignatures[RenderKeyRootSignature( qwKey )] );
+			RenderSetPipeline( a_pBackend, a_pResources->pPipelines[dwPipeline] );
+			if( a_pBackend->dwConstants != RENDER_CONSTANTS_VIEW_PROJ )
+			{
+				constants.mvpMat = *a_pViewProj;
+			}
+			RenderSetVertexConstants( a_pBackend, &constants, RENDER_CONSTANTS_VIEW_PROJ );
+			if( dwPipeline == RENDER_PIPELINE_SKINNED_INSTANCED )
+			{
+				RenderSetPalette( a_pBackend, a_pResources->pPalettes[0] );
+			}
+			u32 dwMesh = RenderKeyMesh( qwKey );
+			RenderSetGeometry( a_pBackend, a_pResources->ppVertexBuffers[dwMesh], a_pResources->ppIndexBuffers[dwMesh] );
+			RenderSetInstanceBuffer( a_pBackend, a_pResources->pInstanceBuffer );
+			RenderDrawIndexed( a_pBackend, a_pResources->ppMeshIndices[dwMesh] + RenderKeyLod( qwKey ), dwRunEnd - dwIdx, a_pQueue->pInstances[dwIdx] );
+			dwIdx = dwRunEnd - 1;
+			continue;
+		}
+		if( !CullIsVisible( a_pVisible, dwDraw ) )
+		{
+			continue;
+		}
+		RenderSetRootSignature( a_pBackend, a_pResources, a_pResources->pRootSignatures[RenderKeyRootSignature( qwKey )] );
+		u32 dwPalette = a_pDraws->pPalette[dwDraw];
+		u32 dwDrawDataMode = dwPalette == ENTITY_NONE ? a_pResources->dwDrawDataMode : RENDER_DRAW_DATA_ROOT_CONSTANTS;
+		RenderSetPipeline( a_pBackend, dwDrawDataMode == RENDER_DRAW_DATA_ROOT_CONSTANTS ? a_pResources->pPipelines[dwPipeline] : a_pResources->pDrawDataPipelines[dwDrawDataMode] );
+		if( dwDrawDataMode != RENDER_DRAW_DATA_ROOT_CONSTANTS )
+		{
+			if( a_pBackend->dwConstants != RENDER_CONSTANTS_VIEW_PROJ )
+			{
+				constants.mvpMat = *a_pViewProj;
+			}
+			RenderSetVertexConstants( a_pBackend, &constants, RENDER_CONSTANTS_VIEW_PROJ );
+			if( dwDrawDataMode == RENDER_DRAW_DATA_ROOT_CBV )
+			{
+				RenderSetDrawConstantBuffer( a_pBackend, a_pResources->qwDrawData + ( (u64)a_pQueue->pInstances[dwIdx] * RENDER_DRAW_DATA_CBV_SIZE ) );
+			}
+			else
+			{
+				RenderSetPalette( a_pBackend, a_pResources->qwDrawData );
+				RenderSetDrawIndex( a_pBackend, a_pQueue->pInstances[dwIdx] );
+			}
+		}
+		else if( dwPalette == ENTITY_NONE )
+		{
+			Mat4fMult( &a_pDraws->pWorld[dwDraw], a_pViewProj, &constants.mvpMat );
+			constants.nMat = a_pDraws->pNormal[dwDraw];
+			RenderSetVertexConstants( a_pBackend, &constants, RENDER_CONSTANTS_NONE );
+		}
+		else
+		{
+			if( a_pBackend->dwConstants != RENDER_CONSTANTS_VIEW_PROJ )
+			{
+				constants.mvpMat = *a_pViewProj; //nMat is unused by the skinned shader
+			}
+			RenderSetVertexConstants( a_pBackend, &constants, RENDER_CONSTANTS_VIEW_PROJ );
+			RenderSetPalette( a_pBackend, a_pResources->pPalettes[dwPalette] );
+		}
+		u32 dwMesh = RenderKeyMesh( qwKey );
+		RenderSetGeometry( a_pBackend, a_pResources->ppVertexBuffers[dwMesh], a_pResources->ppIndexBuffers[dwMesh] );
+		RenderDrawIndexed( a_pBackend, a_pResources->ppMeshIndices[dwMesh] + RenderKeyLod( qwKey ), 1, 0 );
+	}
+}
+
+#if BENCHMARK_MODE
+//10k draws over 8 meshes, a tenth of them skinned over 4 palettes, through the null backend: the same queue submitted
+//in draw list order, sorted and sorted with instancing, checks the sort is a sorted permutation, every way submits every draw
+//and every instance carries its draw's transform and palette
+u32 BenchmarkRenderQueue()
+{
+	const u32 dwNumDraws = 10000;
+	const u32 dwNumMeshes = 8;
+	const u32 dwNumPalettes = 4;
+	const u32 dwIterations = 50;
+	RenderQueue queue;
+	SceneDrawList drawList;
+	if( !InitRenderQueue( &queue, dwNumDraws ) || !InitSceneDrawList( &drawList, dwNumDraws ) )
+	{
+		printf( "Render queue: out of memory\n" );
+		return 1;
+	}
+	//the null backend only compares these, they never get dereferenced
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffers[dwNumMeshes];
+	D3D12_INDEX_BUFFER_VIEW indexBuffers[dwNumMeshes];
+	D3D12_VERTEX_BUFFER_VIEW *pVertexBuffers[dwNumMeshes];
+	D3D12_INDEX_BUFFER_VIEW *pIndexBuffers[dwNumMeshes];
+	MeshIndices meshIndices[dwNumMeshes];
+	MeshIndices *pMeshIndices[dwNumMeshes];
+	D3D12_GPU_VIRTUAL_ADDRESS palettes[dwNumPalettes];
+	u8 palettePresent[dwNumPalettes];
+	for( u32 dwMesh = 0; dwMesh < dwNumMeshes; ++dwMesh )
+	{
+		pVertexBuffers[dwMesh] = &vertexBuffers[dwMesh];
+		pIndexBuffers[dwMesh] = &indexBuffers[dwMesh];
+		SetMeshIndicesSinglePart( &meshIndices[dwMesh], DXGI_FORMAT_R16_UINT, 36 * ( dwMesh + 1 ) );
+		pMeshIndices[dwMesh] = &meshIndices[dwMesh];
+	}
+	for( u32 dwPalette = 0; dwPalette < dwNumPalettes; ++dwPalette )
+	{
+		palettes[dwPalette] = 0x10000 * ( dwPalette + 1 );
+		palettePresent[dwPalette] = 1;
+	}
+	pixelShaderCB pixelConstants = {};
+	RenderResources resources;
+	D3D12_VERTEX_BUFFER_VIEW instanceBuffer;
+	resources.pPipelines[RENDER_PIPELINE_STATIC] = (ID3D12PipelineState*)&vertexBuffers[0];
+	resources.pPipelines[RENDER_PIPELINE_STATIC_INSTANCED] = (ID3D12PipelineState*)&vertexBuffers[1];
+	resources.pPipelines[RENDER_PIPELINE_SKINNED] = (ID3D12PipelineState*)&vertexBuffers[2];
+	resources.pPipelines[RENDER_PIPELINE_SKINNED_INSTANCED] = (ID3D12PipelineState*)&vertexBuffers[3];
+	resources.pRootSignatures[RENDER_ROOT_SIGNATURE_STATIC] = (ID3D12RootSignature*)&indexBuffers[0];
+	resources.pRootSignatures[RENDER_ROOT_SIGNATURE_SKINNED] = (ID3D12RootSignature*)&indexBuffers[1];
+	resources.ppVertexBuffers = pVertexBuffers;
+	resources.ppIndexBuffers = pIndexBuffers;
+	resources.ppMeshIndices = pMeshIndices;
+	resources.pPalettes = palettes;
+	resources.pInstanceBuffer = &instanceBuffer;
+	resources.pPixelConstants = &pixelConstants;
+	resources.dwDrawDataMode = RENDER_DRAW_DATA_ROOT_CONSTANTS;
+
+	u32 dwSeed = 777;
+	drawList.dwCount = dwNumDraws;
+	drawList.dwNumStatic = 0;
+	for( u32 dwDraw = 0; dwDraw < dwNumDraws; ++dwDraw )
+	{
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		InitTransMat4f( &drawList.pWorld[dwDraw], (f32)( ( dwSeed >> 8 ) & 63 ) - 32.0f, (f32)( ( dwSeed >> 14 ) & 15 ), -(f32)( ( dwSeed >> 18 ) & 63 ) );
+		InverseTransposeUpper3x3Mat4f( &drawList.pWorld[dwDraw], &drawList.pNormal[dwDraw] );
+		u8 bSkinned = ( ( dwSeed >> 24 ) % 10 ) == 0;
+		drawList.pMesh[dwDraw] = bSkinned ? dwNumMeshes - 1 : ( dwSeed >> 4 ) % ( dwNumMeshes - 1 );
+		drawList.pPalette[dwDraw] = bSkinned ? ( dwSeed >> 2 ) % dwNumPalettes : ENTITY_NONE;
+		drawList.pLod[dwDraw] = 0;
+	}
+	u8 *pVisible = (u8*)malloc( CullMaskBytes( dwNumDraws ) );
+	memset( pVisible, 0xff, CullMaskBytes( dwNumDraws ) );
+	Vec3f vEye = { 0.0f, 1.6f, 0.0f };
+	Mat4f mViewProj;
+	InitMat4f( &mViewProj );
+
+	RenderBackend backend;
+	RenderStats unsortedStats;
+	BuildSceneRenderQueue( &queue, &drawList, pVisible, pVisible, palettePresent, &vEye, 0 );
+	RenderBackendBegin( &backend, nullptr, nullptr );
+	RenderQueueSubmit( &queue, &backend, &resources, &drawList, &mViewProj, pVisible, 0, queue.dwCount );
+	unsortedStats = backend.stats;
+
+	//instanced first, the timed loop below leaves the plain sorted queue behind for the checks after it
+	RenderInstance *pInstances = (RenderInstance*)malloc( sizeof( RenderInstance ) * dwNumDraws );
+	LARGE_INTEGER startCounter, sortedCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	f64 fInstancedTicks = 0.0;
+	RenderStats instancedStats;
+	u32 dwNumInstances = 0;
+	for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+	{
+		QueryPerformanceCounter( &startCounter );
+		BuildSceneRenderQueue( &queue, &drawList, pVisible, pVisible, palettePresent, &vEye, 1 );
+		RenderQueueSort( &queue );
+		dwNumInstances = RenderQueueWriteInstances( &queue, &drawList, pInstances );
+		RenderBackendBegin( &backend, nullptr, nullptr );
+		RenderQueueSubmit( &queue, &backend, &resources, &drawList, &mViewProj, pVisible, 0, queue.dwCount );
+		QueryPerformanceCounter( &endCounter );
+		fInstancedTicks += (f64)( endCounter.QuadPart - startCounter.QuadPart );
+	}
+	instancedStats = backend.stats;
+	u32 dwFailures = dwNumInstances == dwNumDraws && instancedStats.dwNumInstances == dwNumDraws ? 0 : 1;
+	for( u32 dwIdx = 0; dwIdx < queue.dwCount; ++dwIdx )
+	{
+		u32 dwDraw = queue.pItems[dwIdx];
+		RenderInstance *pInstance = &pInstances[queue.pInstances[dwIdx]];
+		dwFailures += RenderPipelineInstanced( RenderKeyPipeline( queue.pKeys[dwIdx] ) ) ? 0 : 1;
+		dwFailures += dwIdx == 0 || queue.pInstances[dwIdx] == queue.pInstances[dwIdx - 1] + 1 ? 0 : 1;
+		dwFailures += memcmp( &pInstance->mWorld, &drawList.pWorld[dwDraw], sizeof( Mat4f ) ) == 0 ? 0 : 1;
+		dwFailures += pInstance->dwPalette == ( drawList.pPalette[dwDraw] == ENTITY_NONE ? 0 : drawList.pPalette[dwDraw] ) ? 0 : 1;
+	}
+	//a draw call per mesh, every mesh here has enough draws to be instanced
+	dwFailures += instancedStats.dwNumDraws == dwNumMeshes ? 0 : 1;
+
+	f64 fSortTicks = 0.0;
+	f64 fSubmitTicks = 0.0;
+	for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+	{
+		QueryPerformanceCounter( &startCounter );
+		BuildSceneRenderQueue( &queue, &drawList, pVisible, pVisible, palettePresent, &vEye, 0 );
+		RenderQueueSort( &queue );
+		QueryPerformanceCounter( &sortedCounter );
+		RenderBackendBegin( &backend, nullptr, nullptr );
+		RenderQueueSubmit( &queue, &backend, &resources, &drawList, &mViewProj, pVisible, 0, queue.dwCount );
+		QueryPerformanceCounter( &endCounter );
+		fSortTicks += (f64)( sortedCounter.QuadPart - startCounter.QuadPart );
+		fSubmitTicks += (f64)( endCounter.QuadPart - sortedCounter.QuadPart );
+	}
+	f64 fNsPerTick = 1000000000.0 / (f64)PerfCountFrequency.QuadPart;
+
+	//sorted, every draw exactly once, and the pipeline ranges only hold their own pipeline
+	dwFailures += queue.dwCount == dwNumDraws && backend.stats.dwNumDraws == dwNumDraws && unsortedStats.dwNumDraws == dwNumDraws ? 0 : 1;
+	u8 *pSeen = (u8*)calloc( dwNumDraws, 1 );
+	for( u32 dwIdx = 0; dwIdx < queue.dwCount; ++dwIdx )
+	{
+		dwFailures += dwIdx == 0 || queue.pKeys[dwIdx - 1] <= queue.pKeys[dwIdx] ? 0 : 1;
+		dwFailures += pSeen[queue.pItems[dwIdx]]++ ? 1 : 0;
+		dwFailures += ( RenderKeyPipeline( queue.pKeys[dwIdx] ) == RENDER_PIPELINE_SKINNED ) == ( drawList.pPalette[queue.pItems[dwIdx]] != ENTITY_NONE ) ? 0 : 1;
+	}
+	for( u32 dwPipeline = 0; dwPipeline < RENDER_PIPELINE_COUNT; dwPipeline += 2 )
+	{
+		u32 dwBegin = RenderQueueLowerBound( &queue, RenderSortKey( RENDER_PASS_OPAQUE, dwPipeline, 0, 0, 0, 0, 0 ) );
+		u32 dwEnd = RenderQueueLowerBound( &queue, RenderSortKey( RENDER_PASS_OPAQUE, dwPipeline + 2, 0, 0, 0, 0, 0 ) );
+		for( u32 dwIdx = dwBegin; dwIdx < dwEnd; ++dwIdx )
+		{
+			dwFailures += RenderKeyPipeline( queue.pKeys[dwIdx] ) == dwPipeline ? 0 : 1;
+		}
+	}
+	//with 2 pipelines, 8 meshes and 4 palettes sorting has to get state changes down to about that
+	dwFailures += backend.stats.dwNumStateChanges <= 2 + 2 + ( 2 * dwNumMeshes ) + dwNumPalettes ? 0 : 1;
+	printf( "Render queue: %u draws, build+sort %.1fns/draw, submit %.1fns/draw, unsorted %u state changes %u api calls (%u saved), "
+		"sorted %u state changes %u api calls (%u saved), instanced %u draw calls %u api calls in %.1fns/draw, %u failures\n",
+		dwNumDraws, ( fSortTicks * fNsPerTick ) / ( (f64)dwIterations * dwNumDraws ), ( fSubmitTicks * fNsPerTick ) / ( (f64)dwIterations * dwNumDraws ),
+		unsortedStats.dwNumStateChanges, unsortedStats.dwNumApiCalls, unsortedStats.dwNumApiCallsSaved,
+		backend.stats.dwNumStateChanges, backend.stats.dwNumApiCalls, backend.stats.dwNumApiCallsSaved,
+		instancedStats.dwNumDraws, instancedStats.dwNumApiCalls, ( fInstancedTicks * fNsPerTick ) / ( (f64)dwIterations * dwNumDraws ), dwFailures );
+	free( pInstances );
+	free( pSeen );
+	free( pVisible );
+	DestroySceneDrawList( &drawList );
+	DestroyRenderQueue( &queue );
+	return dwFailures;
+}
+
+//10k static draws with random rotations and non uniform scales submitted per eye in every RenderDrawDataMode through the null backend:
+//half conversion against known values and every finite half, each mode draws everything, and decoding what a buffer mode wrote
+//has to give the root constant path's world position and normal direction
+u32 BenchmarkDrawData()
+{
+	u32 dwFailures = 0;
+	const f32 fHalfInputs[] = { 1.0f, -2.0f, 65504.0f, 70000.0f, 1e-8f, 0.0f, 1.0f + ( 1.0f / 2048.0f ), 1.0f + ( 3.0f / 2048.0f ), 0.099975586f };
+	const u16 wHalfOutputs[] = { 0x3c00, 0xc000, 0x7bff, 0x7c00, 0x0000, 0x0000, 0x3c00, 0x3c02, 0x2e66 };
+	for( u32 dwCase = 0; dwCase < _countof( fHalfInputs ); ++dwCase )
+	{
+		dwFailures += F32ToF16( fHalfInputs[dwCase] ) == wHalfOutputs[dwCase] ? 0 : 1;
+	}
+	for( u32 dwHalf = 0x0400; dwHalf < 0x7c00; ++dwHalf )
+	{
+		dwFailures += F32ToF16( F16ToF32( (u16)dwHalf ) ) == dwHalf && F32ToF16( -F16ToF32( (u16)dwHalf ) ) == ( dwHalf | 0x8000 ) ? 0 : 1;
+	}
+	dwFailures += RenderDrawDataPickMode( 0 ) == RENDER_DRAW_DATA_ROOT_CONSTANTS && RenderDrawDataPickMode( RENDER_DRAW_DATA_MIN_DRAWS ) == RENDER_DRAW_DATA_INDEX ? 0 : 1;
+
+	const u32 dwNumDraws = 10000;
+	const u32 dwNumMeshes = 8;
+	const u32 dwIterations = 20;
+	RenderQueue queue;
+	SceneDrawList drawList;
+	if( !InitRenderQueue( &queue, dwNumDraws ) || !InitSceneDrawList( &drawList, dwNumDraws ) )
+	{
+		printf( "Draw data: out of memory\n" );
+		return 1;
+	}
+	//the null backend only compares these, they never get dereferenced
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffers[dwNumMeshes];
+	D3D12_INDEX_BUFFER_VIEW indexBuffers[dwNumMeshes];
+	D3D12_VERTEX_BUFFER_VIEW *pVertexBuffers[dwNumMeshes];
+	D3D12_INDEX_BUFFER_VIEW *pIndexBuffers[dwNumMeshes];
+	MeshIndices meshIndices[dwNumMeshes];
+	MeshIndices *pMeshIndices[dwNumMeshes];
+	for( u32 dwMesh = 0; dwMesh < dwNumMeshes; ++dwMesh )
+	{
+		pVertexBuffers[dwMesh] = &vertexBuffers[dwMesh];
+		pIndexBuffers[dwMesh] = &indexBuffers[dwMesh];
+		SetMeshIndicesSinglePart( &meshIndices[dwMesh], DXGI_FORMAT_R16_UINT, 36 );
+		pMeshIndices[dwMesh] = &meshIndices[dwMesh];
+	}
+	pixelShaderCB pixelConstants = {};
+	RenderResources resources;
+	memset( &resources, 0, sizeof( RenderResources ) );
+	resources.pPipelines[RENDER_PIPELINE_STATIC] = (ID3D12PipelineState*)&vertexBuffers[0];
+	resources.pDrawDataPipelines[RENDER_DRAW_DATA_ROOT_CONSTANTS] = (ID3D12PipelineState*)&vertexBuffers[0];
+	resources.pDrawDataPipelines[RENDER_DRAW_DATA_ROOT_CBV] = (ID3D12PipelineState*)&vertexBuffers[1];
+	resources.pDrawDataPipelines[RENDER_DRAW_DATA_INDEX] = (ID3D12PipelineState*)&vertexBuffers[2];
+	resources.pRootSignatures[RENDER_ROOT_SIGNATURE_STATIC] = (ID3D12RootSignature*)&indexBuffers[0];
+	resources.ppVertexBuffers = pVertexBuffers;
+	resources.ppIndexBuffers = pIndexBuffers;
+	resources.ppMeshIndices = pMeshIndices;
+	resources.pPixelConstants = &pixelConstants;
+	resources.qwDrawData = 0x100000;
+
+	u32 dwSeed = 4321;
+	drawList.dwCount = dwNumDraws;
+	drawList.dwNumStatic = dwNumDraws;
+	for( u32 dwDraw = 0; dwDraw < dwNumDraws; ++dwDraw )
+	{
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		Vec3f vAxis = { (f32)( dwSeed & 255 ) - 127.5f, (f32)( ( dwSeed >> 8 ) & 255 ) - 127.5f, (f32)( ( dwSeed >> 16 ) & 255 ) - 127.5f };
+		Vec3fNormalize( &vAxis, &vAxis );
+		Mat4f mRot, mScale;
+		InitRotArbAxisMat4f( &mRot, &vAxis, (f32)( dwSeed >> 23 ) ); //degrees
+		InitMat4f( &mScale );
+		mScale.m[0][0] = 0.25f + (f32)( ( dwSeed >> 3 ) & 15 ); //up to 60:1 between axes
+		mScale.m[1][1] = 0.25f + (f32)( ( dwSeed >> 9 ) & 3 );
+		mScale.m[2][2] = 0.25f;
+		Mat4fMult( &mScale, &mRot, &drawList.pWorld[dwDraw] );
+		drawList.pWorld[dwDraw].m[3][0] = (f32)( ( dwSeed >> 5 ) & 127 ) - 64.0f;
+		drawList.pWorld[dwDraw].m[3][1] = (f32)( ( dwSeed >> 12 ) & 15 );
+		drawList.pWorld[dwDraw].m[3][2] = -(f32)( ( dwSeed >> 18 ) & 127 );
+		InverseTransposeUpper3x3Mat4f( &drawList.pWorld[dwDraw], &drawList.pNormal[dwDraw] );
+		drawList.pMesh[dwDraw] = dwSeed % dwNumMeshes;
+		drawList.pPalette[dwDraw] = ENTITY_NONE;
+		drawList.pLod[dwDraw] = 0;
+	}
+	u8 *pVisible = (u8*)malloc( CullMaskBytes( dwNumDraws ) );
+	memset( pVisible, 0xff, CullMaskBytes( dwNumDraws ) );
+	u8 palettePresent[1] = { 0 };
+	Vec3f vEye = { 0.0f, 1.6f, 0.0f };
+	Mat4f mViewProj;
+	InitMat4f( &mViewProj );
+	u8 *pDrawData = (u8*)malloc( (u64)dwNumDraws * RENDER_DRAW_DATA_CBV_SIZE );
+
+	BuildSceneRenderQueue( &queue, &drawList, pVisible, pVisible, palettePresent, &vEye, 0 );
+	RenderQueueSort( &queue );
+	dwFailures += RenderQueueCountDrawData( &queue ) == dwNumDraws ? 0 : 1;
+	const u32 dwStrides[RENDER_DRAW_DATA_MODE_COUNT] = { 0, RENDER_DRAW_DATA_CBV_SIZE, sizeof( RenderDrawData ) };
+	RenderStats stats[RENDER_DRAW_DATA_MODE_COUNT];
+	f64 fUsPerFrame[RENDER_DRAW_DATA_MODE_COUNT];
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	RenderBackend backend;
+	for( u32 dwMode = 0; dwMode < RENDER_DRAW_DATA_MODE_COUNT; ++dwMode )
+	{
+		resources.dwDrawDataMode = dwMode;
+		QueryPerformanceCounter( &startCounter );
+		for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+		{
+			if( dwMode != RENDER_DRAW_DATA_ROOT_CONSTANTS )
+			{
+				dwFailures += RenderQueueWriteDrawData( &queue, &drawList, pDrawData, dwStrides[dwMode] ) == dwNumDraws ? 0 : 1;
+			}
+			memset( &stats[dwMode], 0, sizeof( RenderStats ) );
+			for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+			{
+				RenderBackendBegin( &backend, nullptr, nullptr );
+				RenderQueueSubmit( &queue, &backend, &resources, &drawList, &mViewProj, pVisible, 0, queue.dwCount );
+				stats[dwMode].dwNumDraws += backend.stats.dwNumDraws;
+				stats[dwMode].dwNumApiCalls += backend.stats.dwNumApiCalls;
+				stats[dwMode].dwNumRootBytes += backend.stats.dwNumRootBytes;
+			}
+		}
+		QueryPerformanceCounter( &endCounter );
+		fUsPerFrame[dwMode] = ( 1000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwIterations );
+		dwFailures += stats[dwMode].dwNumDraws == dwNumDraws * ovrEye_Count ? 0 : 1;
+
+		if( dwMode == RENDER_DRAW_DATA_ROOT_CONSTANTS )
+		{
+			continue;
+		}
+		//a corner of a unit cube through the decoded draw data, the normal only by direction
+		f32 fWorstPos = 0.0f;
+		f32 fWorstNormalDot = 1.0f;
+		for( u32 dwIdx = 0; dwIdx < queue.dwCount; ++dwIdx )
+		{
+			u32 dwDraw = queue.pItems[dwIdx];
+			RenderDrawData *pData = (RenderDrawData*)( pDrawData + ( (u64)queue.pInstances[dwIdx] * dwStrides[dwMode] ) );
+			Mat4f *pWorld = &drawList.pWorld[dwDraw];
+			Mat3x4f *pNormal = &drawList.pNormal[dwDraw];
+			Vec4f vLocal = { 0.5f, -0.5f, 0.5f, 1.0f };
+			Vec3f vNormal = { 0.0f, 0.0f, 0.0f };
+			Vec3f vDecodedNormal = { 0.0f, 0.0f, 0.0f };
+			u16 *pHalves = (u16*)pData->dwNormalHalves;
+			for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+			{
+				f32 fExpected = 0.0f;
+				f32 fDecoded = 0.0f;
+				for( u32 dwRow = 0; dwRow < 4; ++dwRow )
+				{
+					fExpected += vLocal.v[dwRow] * pWorld->m[dwRow][dwAxis];
+					fDecoded += vLocal.v[dwRow] * pData->vWorldColumns[dwAxis].v[dwRow];
+				}
+				f32 fError = fabsf( fExpected - fDecoded );
+				fWorstPos = fError > fWorstPos ? fError : fWorstPos;
+				for( u32 dwRow = 0; dwRow < 3; ++dwRow )
+				{
+					vNormal.v[dwAxis] += vLocal.v[dwRow] * pNormal->m[dwRow][dwAxis];
+					vDecodedNormal.v[dwAxis] += vLocal.v[dwRow] * F16ToF32( pHalves[( dwRow * 3 ) + dwAxis] );
+				}
+			}
+			Vec3fNormalize( &vNormal, &vNormal );
+			Vec3fNormalize( &vDecodedNormal, &vDecodedNormal );
+			f32 fDot = Vec3fDot( &vNormal, &vDecodedNormal );
+			fWorstNormalDot = fDot < fWorstNormalDot ? fDot : fWorstNormalDot;
+		}
+		dwFailures += fWorstPos == 0.0f && fWorstNormalDot > 0.99999f ? 0 : 1; //positions are copied as is, a half is good to about 0.05% per element
+	}
+	for( u32 dwMode = 0; dwMode < RENDER_DRAW_DATA_MODE_COUNT; ++dwMode )
+	{
+		printf( "Draw data %s: %.1f root bytes/draw, %u buffer bytes/draw, %.1f api calls/draw, write+submit both eyes %.1fus\n",
+			dwMode == RENDER_DRAW_DATA_ROOT_CONSTANTS ? "root constants" : dwMode == RENDER_DRAW_DATA_ROOT_CBV ? "root cbv" : "structured index",
+			(f64)stats[dwMode].dwNumRootBytes / stats[dwMode].dwNumDraws, dwMode == RENDER_DRAW_DATA_ROOT_CONSTANTS ? 0 : (u32)sizeof( RenderDrawData ),
+			(f64)stats[dwMode].dwNumApiCalls / stats[dwMode].dwNumDraws, fUsPerFrame[dwMode] );
+	}
+	//the buffer modes have to push a fraction of what root constants do
+	dwFailures += stats[RENDER_DRAW_DATA_ROOT_CBV].dwNumRootBytes * 8 < stats[RENDER_DRAW_DATA_ROOT_CONSTANTS].dwNumRootBytes &&
+		stats[RENDER_DRAW_DATA_INDEX].dwNumRootBytes * 16 < stats[RENDER_DRAW_DATA_ROOT_CONSTANTS].dwNumRootBytes ? 0 : 1;
+	printf( "Draw data: %u draws per eye, %u failures\n", dwNumDraws, dwFailures );
+	free( pDrawData );
+	free( pVisible );
+	DestroySceneDrawList( &drawList );
+	DestroyRenderQueue( &queue );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,1035 @@
+//Entity storage, every component lives in dense SoA arrays so per frame passes walk memory linearly
+//each component table is a sparse set: entity slot -> dense index and dense index -> entity slot,
+//removing swaps the last entry into the hole so the dense arrays never have gaps
+//handles are the slot plus a generation that is bumped when the entity is destroyed, so stale handles stop resolving
+//transforms can be parented, the transform table is kept sorted by depth (parents always before their children)
+//and world matrices are cached, an update only redoes what was set since the last one and everything below it
+
+#define ENTITY_SLOT_BITS 20 //up to 1M entities, the rest of the handle is the generation
+#define ENTITY_SLOT_MASK ( ( 1 << ENTITY_SLOT_BITS ) - 1 )
+#define ENTITY_NONE 0xffffffff //invalid handle, also the dense index of a component an entity doesn't have
+#define SCENE_MAX_ENTITIES 4096 //what the app's store and frame packet draw lists get allocated for
+#define TRANSFORM_PARALLEL_MIN 4096 //levels with fewer transforms than this aren't worth waking the workers for
+#define TRANSFORM_CHUNK_SIZE 1024
+
+typedef u32 EntityHandle;
+
+enum MeshId
+{
+	MESH_PLANE,
+	MESH_CUBE,
+	MESH_HAND, //skinned
+	MESH_COUNT
+};
+
+typedef struct ComponentTable
+{
+	u32 *pDenseOf; //per entity slot, ENTITY_NONE if it doesn't have the component
+	u32 *pSlotOf; //per dense entry
+	u32 dwCount;
+} ComponentTable;
+
+typedef struct EntityStore
+{
+	u32 *pGenerations; //per slot
+	u32 *pFreeSlots;
+	u32 dwNumFree;
+	u32 dwNumSlots; //slots handed out so far, freed ones get reused first
+	u32 dwMaxEntities;
+
+	//every entity has a transform
+	ComponentTable transforms;
+	f32 *pPosX, *pPosY, *pPosZ;
+	f32 *pRotW, *pRotX, *pRotY, *pRotZ;
+	f32 *pScale; //uniform, so the normal matrix is only needed for the rotation part but is built generally anyway
+	//hierarchy, the columns above are local to the parent
+	u32 *pParentSlot; //ENTITY_NONE for roots
+	u32 *pParentDense; //only valid after UpdateEntityTransforms
+	u32 *pLevel; //depth, roots are 0
+	u32 *pNumChildren;
+	u8 *pDirty; //set since the last update
+	Mat4f *pWorld; //cached, valid after UpdateEntityTransforms
+	Mat3x4f *pNormal;
+	u32 *pLevelStart; //first dense transform of each level, plus one past the end
+	u8 *pLevelDirty; //per level, anything in it was set
+	u32 dwNumLevels;
+	u8 bHierarchyChanged; //parents or table order changed, the next update re-sorts by level first
+	void *pScratch; //sort index and a column's worth of room for re-sorting
+	u32 *pSortIndex;
+
+	ComponentTable renderables;
+	u32 *pRenderMesh;
+
+	//renderables that are drawn with a bone palette
+	ComponentTable skinned;
+	u32 *pSkinPalette; //which palette (boneBuffer set) the instance is skinned with
+} EntityStore;
+
+//what the render thread draws this frame, static draws first then the skinned ones so each pipeline is set once
+typedef struct SceneDrawList
+{
+	Mat4f *pWorld;
+	Mat3x4f *pNormal; //static draws only, the skinned shader skins its normals with the palette
+	u32 *pMesh;
+	u32 *pPalette; //skinned draws only
+	u32 *pSlot; //the entity's, stays the same across frames unlike the draw index
+	u8 *pLod; //MeshLod.h level, 0 until the render thread picks one
+	u32 dwNumStatic;
+	u32 dwCount;
+	u32 dwCapacity;
+} SceneDrawList;
+
+inline
+u32 EntitySlot( EntityHandle hEntity )
+{
+	return hEntity & ENTITY_SLOT_MASK;
+}
+
+inline
+bool InitComponentTable( ComponentTable *a_pTable, u32 dwMaxEntities )
+{
+	a_pTable->pDenseOf = (u32*)malloc( sizeof(u32) * 2 * dwMaxEntities );
+	if( !a_pTable->pDenseOf )
+	{
+		return false;
+	}
+	a_pTable->pSlotOf = a_pTable->pDenseOf + dwMaxEntities;
+	memset( a_pTable->pDenseOf, 0xff, sizeof(u32) * dwMaxEntities );
+	a_pTable->dwCount = 0;
+	return true;
+}
+
+inline
+u32 ComponentTableAdd( ComponentTable *a_pTable, u32 dwSlot )
+{
+#if MAIN_DEBUG
+	assert( a_pTable->pDenseOf[dwSlot] == ENTITY_NONE );
+#endif
+	u32 dwDense = a_pTable->dwCount++;
+	a_pTable->pDenseOf[dwSlot] = dwDense;
+	a_pTable->pSlotOf[dwDense] = dwSlot;
+	return dwDense;
+}
+
+//returns the dense index that was freed, the caller moves the last entry's columns (now at dwCount) into it
+inline
+u32 ComponentTableRemove( ComponentTable *a_pTable, u32 dwSlot )
+{
+	u32 dwDense = a_pTable->pDenseOf[dwSlot];
+	u32 dwLast = --a_pTable->dwCount;
+	u32 dwLastSlot = a_pTable->pSlotOf[dwLast];
+	a_pTable->pSlotOf[dwDense] = dwLastSlot;
+	a_pTable->pDenseOf[dwLastSlot] = dwDense;
+	a_pTable->pDenseOf[dwSlot] = ENTITY_NONE;
+	return dwDense;
+}
+
+inline
+void DestroyEntityStore( EntityStore *a_pStore )
+{
+	free( a_pStore->pPosX );
+	free( a_pStore->pWorld );
+	free( a_pStore->transforms.pDenseOf );
+	free( a_pStore->renderables.pDenseOf );
+	free( a_pStore->skinned.pDenseOf );
+	a_pStore->pPosX = nullptr;
+	a_pStore->pWorld = nullptr;
+}
+
+inline
+bool InitEntityStore( EntityStore *a_pStore, u32 dwMaxEntities )
+{
+#if MAIN_DEBUG
+	assert( dwMaxEntities <= ENTITY_SLOT_MASK );
+#endif
+	a_pStore->dwMaxEntities = dwMaxEntities;
+	a_pStore->dwNumFree = 0;
+	a_pStore->dwNumSlots = 0;
+	//8 transform columns, mesh, palette, generation, free list
+	a_pStore->pPosX = (f32*)malloc( sizeof(f32) * 12 * dwMaxEntities );
+	//world, normal and scratch matrices, parent slot, parent dense, level, child count, sort index, level start (+1), dirty, level dirty
+	a_pStore->pWorld = (Mat4f*)malloc( ( ( ( 2 * sizeof(Mat4f) ) + sizeof(Mat3x4f) + ( 6 * sizeof(u32) ) + 2 ) * dwMaxEntities ) + sizeof(u32) );
+	a_pStore->transforms.pDenseOf = nullptr;
+	a_pStore->renderables.pDenseOf = nullptr;
+	a_pStore->skinned.pDenseOf = nullptr;
+	if( !a_pStore->pPosX || !a_pStore->pWorld || !InitComponentTable( &a_pStore->transforms, dwMaxEntities ) ||
+		!InitComponentTable( &a_pStore->renderables, dwMaxEntities ) || !InitComponentTable( &a_pStore->skinned, dwMaxEntities ) )
+	{
+		DestroyEntityStore( a_pStore );
+		return false;
+	}
+	a_pStore->pPosY = a_pStore->pPosX + dwMaxEntities;
+	a_pStore->pPosZ = a_pStore->pPosY + dwMaxEntities;
+	a_pStore->pRotW = a_pStore->pPosZ + dwMaxEntities;
+	a_pStore->pRotX = a_pStore->pRotW + dwMaxEntities;
+	a_pStore->pRotY = a_pStore->pRotX + dwMaxEntities;
+	a_pStore->pRotZ = a_pStore->pRotY + dwMaxEntities;
+	a_pStore->pScale = a_pStore->pRotZ + dwMaxEntities;
+	a_pStore->pRenderMesh = (u32*)( a_pStore->pScale + dwMaxEntities );
+	a_pStore->pSkinPalette = a_pStore->pRenderMesh + dwMaxEntities;
+	a_pStore->pGenerations = a_pStore->pSkinPalette + dwMaxEntities;
+	a_pStore->pFreeSlots = a_pStore->pGenerations + dwMaxEntities;
+	memset( a_pStore->pGenerations, 0, sizeof(u32) * dwMaxEntities );
+	a_pStore->pNormal = (Mat3x4f*)( a_pStore->pWorld + dwMaxEntities );
+	a_pStore->pScratch = a_pStore->pNormal + dwMaxEntities;
+	a_pStore->pParentSlot = (u32*)( (Mat4f*)a_pStore->pScratch + dwMaxEntities );
+	a_pStore->pParentDense = a_pStore->pParentSlot + dwMaxEntities;
+	a_pStore->pLevel = a_pStore->pParentDense + dwMaxEntities;
+	a_pStore->pNumChildren = a_pStore->pLevel + dwMaxEntities;
+	a_pStore->pSortIndex = a_pStore->pNumChildren + dwMaxEntities;
+	a_pStore->pLevelStart = a_pStore->pSortIndex + dwMaxEntities;
+	a_pStore->pDirty = (u8*)( a_pStore->pLevelStart + dwMaxEntities + 1 );
+	a_pStore->pLevelDirty = a_pStore->pDirty + dwMaxEntities;
+	memset( a_pStore->pLevelDirty, 0, dwMaxEntities );
+	a_pStore->pLevelStart[0] = 0;
+	a_pStore->dwNumLevels = 0;
+	a_pStore->bHierarchyChanged = 0;
+	return true;
+}
+
+inline
+bool EntityAlive( EntityStore *a_pStore, EntityHandle hEntity )
+{
+	u32 dwSlot = EntitySlot( hEntity );
+	return hEntity != ENTITY_NONE && dwSlot < a_pStore->dwNumSlots && a_pStore->pGenerations[dwSlot] == ( hEntity >> ENTITY_SLOT_BITS );
+}
+
+//pLevel is stale while bHierarchyChanged is set, the re-sort rebuilds the level flags from pDirty anyway
+inline
+void MarkTransformDirty( EntityStore *a_pStore, u32 dwTransform )
+{
+	a_pStore->pDirty[dwTransform] = 1;
+	a_pStore->pLevelDirty[a_pStore->pLevel[dwTransform]] = 1;
+}
+
+//new entities are roots at the origin unrotated, returns ENTITY_NONE when the store is full
+inline
+EntityHandle CreateEntity( EntityStore *a_pStore )
+{
+	u32 dwSlot;
+	if( a_pStore->dwNumFree )
+	{
+		dwSlot = a_pStore->pFreeSlots[--a_pStore->dwNumFree];
+	}
+	else if( a_pStore->dwNumSlots < a_pStore->dwMaxEntities )
+	{
+		dwSlot = a_pStore->dwNumSlots++;
+	}
+	else
+	{
+		return ENTITY_NONE;
+	}
+	u32 dwTransform = ComponentTableAdd( &a_pStore->transforms, dwSlot );
+	a_pStore->pPosX[dwTransform] = 0.0f;
+	a_pStore->pPosY[dwTransform] = 0.0f;
+	a_pStore->pPosZ[dwTransform] = 0.0f;
+	a_pStore->pRotW[dwTransform] = 1.0f;
+	a_pStore->pRotX[dwTransform] = 0.0f;
+	a_pStore->pRotY[dwTransform] = 0.0f;
+	a_pStore->pRotZ[dwTransform] = 0.0f;
+	a_pStore->pScale[dwTransform] = 1.0f;
+	a_pStore->pParentSlot[dwTransform] = ENTITY_NONE;
+	a_pStore->pNumChildren[dwTransform] = 0;
+	a_pStore->pLevel[dwTransform] = 0;
+	a_pStore->bHierarchyChanged = 1; //appended after the deepest level
+	MarkTransformDirty( a_pStore, dwTransform );
+	return dwSlot | ( a_pStore->pGenerations[dwSlot] << ENTITY_SLOT_BITS );
+}
+
+inline
+void RemoveSkinnedInstance( EntityStore *a_pStore, EntityHandle hEntity )
+{
+	u32 dwSlot = EntitySlot( hEntity );
+	if( a_pStore->skinned.pDenseOf[dwSlot] == ENTITY_NONE )
+	{
+		return;
+	}
+	u32 dwDense = ComponentTableRemove( &a_pStore->skinned, dwSlot );
+	a_pStore->pSkinPalette[dwDense] = a_pStore->pSkinPalette[a_pStore->skinned.dwCount];
+}
+
+inline
+void RemoveRenderable( EntityStore *a_pStore, EntityHandle hEntity )
+{
+	u32 dwSlot = EntitySlot( hEntity );
+	if( a_pStore->renderables.pDenseOf[dwSlot] == ENTITY_NONE )
+	{
+		return;
+	}
+	RemoveSkinnedInstance( a_pStore, hEntity ); //can't be skinned without being drawn
+	u32 dwDense = ComponentTableRemove( &a_pStore->renderables, dwSlot );
+	a_pStore->pRenderMesh[dwDense] = a_pStore->pRenderMesh[a_pStore->renderables.dwCount];
+}
+
+//children of the entity become roots, their local transform is taken as their world one from then on
+inline
+void DestroyEntity( EntityStore *a_pStore, EntityHandle hEntity )
+{
+	if( !EntityAlive( a_pStore, hEntity ) )
+	{
+		return;
+	}
+	u32 dwSlot = EntitySlot( hEntity );
+	RemoveRenderable( a_pStore, hEntity );
+	u32 dwTransform = a_pStore->transforms.pDenseOf[dwSlot];
+	if( a_pStore->pNumChildren[dwTransform] )
+	{
+		for( u32 dwChild = 0; dwChild < a_pStore->transforms.dwCount; ++dwChild )
+		{
+			if( a_pStore->pParentSlot[dwChild] == dwSlot )
+			{
+				a_pStore->pParentSlot[dwChild] = ENTITY_NONE;
+				MarkTransformDirty( a_pStore, dwChild );
+			}
+		}
+	}
+	if( a_pStore->pParentSlot[dwTransform] != ENTITY_NONE )
+	{
+		--a_pStore->pNumChildren[a_pStore->transforms.pDenseOf[a_pStore->pParentSlot[dwTransform]]];
+	}
+	a_pStore->bHierarchyChanged = 1; //the last transform was moved out of its level
+	u32 dwDense = ComponentTableRemove( &a_pStore->transforms, dwSlot );
+	u32 dwLast = a_pStore->transforms.dwCount;
+	a_pStore->pPosX[dwDense] = a_pStore->pPosX[dwLast];
+	a_pStore->pPosY[dwDense] = a_pStore->pPosY[dwLast];
+	a_pStore->pPosZ[dwDense] = a_pStore->pPosZ[dwLast];
+	a_pStore->pRotW[dwDense] = a_pStore->pRotW[dwLast];
+	a_pStore->pRotX[dwDense] = a_pStore->pRotX[dwLast];
+	a_pStore->pRotY[dwDense] = a_pStore->pRotY[dwLast];
+	a_pStore->pRotZ[dwDense] = a_pStore->pRotZ[dwLast];
+	a_pStore->pScale[dwDense] = a_pStore->pScale[dwLast];
+	a_pStore->pParentSlot[dwDense] = a_pStore->pParentSlot[dwLast];
+	a_pStore->pLevel[dwDense] = a_pStore->pLevel[dwLast];
+	a_pStore->pNumChildren[dwDense] = a_pStore->pNumChildren[dwLast];
+	a_pStore->pDirty[dwDense] = a_pStore->pDirty[dwLast];
+	a_pStore->pWorld[dwDense] = a_pStore->pWorld[dwLast];
+	a_pStore->pNormal[dwDense] = a_pStore->pNormal[dwLast];
+	a_pStore->pGenerations[dwSlot] = ( a_pStore->pGenerations[dwSlot] + 1 ) & ( ENTITY_NONE >> ENTITY_SLOT_BITS );
+	a_pStore->pFreeSlots[a_pStore->dwNumFree++] = dwSlot;
+}
+
+inline
+void AddRenderable( EntityStore *a_pStore, EntityHandle hEntity, u32 dwMesh )
+{
+	u32 dwDense = ComponentTableAdd( &a_pStore->renderables, EntitySlot( hEntity ) );
+	a_pStore->pRenderMesh[dwDense] = dwMesh;
+}
+
+inline
+void AddSkinnedInstance( EntityStore *a_pStore, EntityHandle hEntity, u32 dwPalette )
+{
+#if MAIN_DEBUG
+	assert( a_pStore->renderables.pDenseOf[EntitySlot( hEntity )] != ENTITY_NONE );
+#endif
+	u32 dwDense = ComponentTableAdd( &a_pStore->skinned, EntitySlot( hEntity ) );
+	a_pStore->pSkinPalette[dwDense] = dwPalette;
+}
+
+inline
+void SetEntityTransform( EntityStore *a_pStore, EntityHandle hEntity, Vec3f *a_pPos, Quatf *a_pRot, f32 fScale )
+{
+	u32 dwDense = a_pStore->transforms.pDenseOf[EntitySlot( hEntity )];
+	a_pStore->pPosX[dwDense] = a_pPos->x;
+	a_pStore->pPosY[dwDense] = a_pPos->y;
+	a_pStore->pPosZ[dwDense] = a_pPos->z;
+	a_pStore->pRotW[dwDense] = a_pRot->w;
+	a_pStore->pRotX[dwDense] = a_pRot->x;
+	a_pStore->pRotY[dwDense] = a_pRot->y;
+	a_pStore->pRotZ[dwDense] = a_pRot->z;
+	a_pStore->pScale[dwDense] = fScale;
+	MarkTransformDirty( a_pStore, dwDense );
+}
+
+inline
+void GetEntityRotation( EntityStore *a_pStore, EntityHandle hEntity, Quatf *a_pRot )
+{
+	u32 dwDense = a_pStore->transforms.pDenseOf[EntitySlot( hEntity )];
+	a_pRot->w = a_pStore->pRotW[dwDense];
+	a_pRot->x = a_pStore->pRotX[dwDense];
+	a_pRot->y = a_pStore->pRotY[dwDense];
+	a_pRot->z = a_pStore->pRotZ[dwDense];
+}
+
+inline
+void SetEntityRotation( EntityStore *a_pStore, EntityHandle hEntity, Quatf *a_pRot )
+{
+	u32 dwDense = a_pStore->transforms.pDenseOf[EntitySlot( hEntity )];
+	a_pStore->pRotW[dwDense] = a_pRot->w;
+	a_pStore->pRotX[dwDense] = a_pRot->x;
+	a_pStore->pRotY[dwDense] = a_pRot->y;
+	a_pStore->pRotZ[dwDense] = a_pRot->z;
+	MarkTransformDirty( a_pStore, dwDense );
+}
+
+//attaches hChild under hParent (ENTITY_NONE detaches it), the child's transform is relative to its parent from then on
+//so a prop held in a hand keeps its grip offset and just follows the hand
+inline
+void SetEntityParent( EntityStore *a_pStore, EntityHandle hChild, EntityHandle hParent )
+{
+	u32 dwChildSlot = EntitySlot( hChild );
+	u32 dwChild = a_pStore->transforms.pDenseOf[dwChildSlot];
+	u32 dwParentSlot = hParent == ENTITY_NONE ? ENTITY_NONE : EntitySlot( hParent );
+#if MAIN_DEBUG
+	//the new parent can't be the child or anything below it
+	for( u32 dwAncestor = dwParentSlot; dwAncestor != ENTITY_NONE; dwAncestor = a_pStore->pParentSlot[a_pStore->transforms.pDenseOf[dwAncestor]] )
+	{
+		assert( dwAncestor != dwChildSlot );
+	}
+#endif
+	u32 dwOldParentSlot = a_pStore->pParentSlot[dwChild];
+	if( dwOldParentSlot == dwParentSlot )
+	{
+		return;
+	}
+	if( dwOldParentSlot != ENTITY_NONE )
+	{
+		--a_pStore->pNumChildren[a_pStore->transforms.pDenseOf[dwOldParentSlot]];
+	}
+	if( dwParentSlot != ENTITY_NONE )
+	{
+		++a_pStore->pNumChildren[a_pStore->transforms.pDenseOf[dwParentSlot]];
+	}
+	a_pStore->pParentSlot[dwChild] = dwParentSlot;
+	a_pStore->bHierarchyChanged = 1;
+	MarkTransformDirty( a_pStore, dwChild );
+}
+
+inline
+void EntityLocalMatrix( EntityStore *a_pStore, u32 dwTransform, Mat4f *a_pWorld )
+{
+	Quatf qRot = { a_pStore->pRotW[dwTransform], a_pStore->pRotX[dwTransform], a_pStore->pRotY[dwTransform], a_pStore->pRotZ[dwTransform] };
+	Vec3f vPos = { a_pStore->pPosX[dwTransform], a_pStore->pPosY[dwTransform], a_pStore->pPosZ[dwTransform] };
+	InitModelMat4ByQuatf( a_pWorld, &qRot, &vPos );
+	f32 fScale = a_pStore->pScale[dwTransform];
+	for( u32 dwRow = 0; dwRow < 3; ++dwRow )
+	{
+		a_pWorld->m[dwRow][0] *= fScale;
+		a_pWorld->m[dwRow][1] *= fScale;
+		a_pWorld->m[dwRow][2] *= fScale;
+	}
+}
+
+//moves element dwDense of a transform column to pSortIndex[dwDense]
+inline
+void PermuteTransformColumn( EntityStore *a_pStore, void *pColumn, u32 dwElementSize )
+{
+	u8 *pSrc = (u8*)pColumn;
+	u8 *pDst = (u8*)a_pStore->pScratch;
+	for( u32 dwDense = 0; dwDense < a_pStore->transforms.dwCount; ++dwDense )
+	{
+		memcpy( pDst + ( a_pStore->pSortIndex[dwDense] * dwElementSize ), pSrc + ( dwDense * dwElementSize ), dwElementSize );
+	}
+	memcpy( pSrc, pDst, dwElementSize * a_pStore->transforms.dwCount );
+}
+
+//counting sort of the transform table by depth, stable so siblings keep their relative order
+//O(n) and only runs after parents or the table changed, not every frame
+inline
+void SortTransformsByLevel( EntityStore *a_pStore )
+{
+	u32 dwCount = a_pStore->transforms.dwCount;
+	u32 *pLevel = a_pStore->pLevel;
+	u32 *pLevelStart = a_pStore->pLevelStart;
+	u32 *pPath = a_pStore->pSortIndex;
+	memset( pLevel, 0xff, sizeof(u32) * dwCount );
+	u32 dwNumLevels = 0;
+	for( u32 dwDense = 0; dwDense < dwCount; ++dwDense )
+	{
+		//walk up to the first ancestor that already has a level, then hand levels back down the path
+		u32 dwPathLength = 0;
+		u32 dwNode = dwDense;
+		while( dwNode != ENTITY_NONE && pLevel[dwNode] == ENTITY_NONE )
+		{
+			pPath[dwPathLength++] = dwNode;
+			u32 dwParentSlot = a_pStore->pParentSlot[dwNode];
+			dwNode = dwParentSlot == ENTITY_NONE ? ENTITY_NONE : a_pStore->transforms.pDenseOf[dwParentSlot];
+		}
+		u32 dwLevel = dwNode == ENTITY_NONE ? 0 : pLevel[dwNode] + 1;
+		while( dwPathLength )
+		{
+			pLevel[pPath[--dwPathLength]] = dwLevel++;
+		}
+		dwNumLevels = dwLevel > dwNumLevels ? dwLevel : dwNumLevels;
+	}
+
+	memset( pLevelStart, 0, sizeof(u32) * ( dwNumLevels + 1 ) );
+	for( u32 dwDense = 0; dwDense < dwCount; ++dwDense )
+	{
+		++pLevelStart[pLevel[dwDense] + 1];
+	}
+	for( u32 dwLevel = 1; dwLevel <= dwNumLevels; ++dwLevel )
+	{
+		pLevelStart[dwLevel] += pLevelStart[dwLevel - 1];
+	}
+	u32 *pNewIndex = a_pStore->pSortIndex;
+	u8 bMoved = 0;
+	for( u32 dwDense = 0; dwDense < dwCount; ++dwDense )
+	{
+		pNewIndex[dwDense] = pLevelStart[pLevel[dwDense]]++;
+		bMoved |= pNewIndex[dwDense] != dwDense;
+	}
+	//placing left every start at the next level's, shift them back
+	for( u32 dwLevel = dwNumLevels; dwLevel > 0; --dwLevel )
+	{
+		pLevelStart[dwLevel] = pLevelStart[dwLevel - 1];
+	}
+	pLevelStart[0] = 0;
+
+	if( bMoved ) //usually already in order, e.g. a new root when everything else is one
+	{
+		f32 *pFloatColumns[8] = { a_pStore->pPosX, a_pStore->pPosY, a_pStore->pPosZ, a_pStore->pRotW, a_pStore->pRotX, a_pStore->pRotY, a_pStore->pRotZ, a_pStore->pScale };
+		for( u32 dwColumn = 0; dwColumn < 8; ++dwColumn )
+		{
+			PermuteTransformColumn( a_pStore, pFloatColumns[dwColumn], sizeof(f32) );
+		}
+		PermuteTransformColumn( a_pStore, a_pStore->pParentSlot, sizeof(u32) );
+		PermuteTransformColumn( a_pStore, a_pStore->pLevel, sizeof(u32) );
+		PermuteTransformColumn( a_pStore, a_pStore->pNumChildren, sizeof(u32) );
+		PermuteTransformColumn( a_pStore, a_pStore->pDirty, sizeof(u8) );
+		PermuteTransformColumn( a_pStore, a_pStore->pWorld, sizeof(Mat4f) );
+		PermuteTransformColumn( a_pStore, a_pStore->pNormal, sizeof(Mat3x4f) );
+		PermuteTransformColumn( a_pStore, a_pStore->transforms.pSlotOf, sizeof(u32) );
+		for( u32 dwDense = 0; dwDense < dwCount; ++dwDense )
+		{
+			a_pStore->transforms.pDenseOf[a_pStore->transforms.pSlotOf[dwDense]] = dwDense;
+		}
+	}
+	for( u32 dwDense = 0; dwDense < dwCount; ++dwDense )
+	{
+		u32 dwParentSlot = a_pStore->pParentSlot[dwDense];
+		a_pStore->pParentDense[dwDense] = dwParentSlot == ENTITY_NONE ? ENTITY_NONE : a_pStore->transforms.pDenseOf[dwParentSlot];
+	}
+	//levels were stale while marking, redo their flags from the transforms'
+	memset( a_pStore->pLevelDirty, 0, a_pStore->dwMaxEntities );
+	for( u32 dwDense = 0; dwDense < dwCount; ++dwDense )
+	{
+		a_pStore->pLevelDirty[a_pStore->pLevel[dwDense]] |= a_pStore->pDirty[dwDense];
+	}
+	a_pStore->dwNumLevels = dwNumLevels;
+	a_pStore->bHierarchyChanged = 0;
+}
+
+//redoes world and normal matrices in [dwBegin, dwEnd) of one level for transforms that were set or whose parent was redone,
+//the dirty flag is left set so the next level sees it, returns how many were redone
+inline
+u32 UpdateTransformRange( EntityStore *a_pStore, u32 dwBegin, u32 dwEnd )
+{
+	u32 dwNumUpdated = 0;
+	for( u32 dwTransform = dwBegin; dwTransform < dwEnd; ++dwTransform )
+	{
+		u32 dwParent = a_pStore->pParentDense[dwTransform];
+		if( !a_pStore->pDirty[dwTransform] && ( dwParent == ENTITY_NONE || !a_pStore->pDirty[dwParent] ) )
+		{
+			continue;
+		}
+		a_pStore->pDirty[dwTransform] = 1;
+		if( dwParent == ENTITY_NONE )
+		{
+			EntityLocalMatrix( a_pStore, dwTransform, &a_pStore->pWorld[dwTransform] );
+		}
+		else
+		{
+			Mat4f mLocal;
+			EntityLocalMatrix( a_pStore, dwTransform, &mLocal );
+			Mat4fMult( &mLocal, &a_pStore->pWorld[dwParent], &a_pStore->pWorld[dwTransform] );
+		}
+		InverseTransposeUpper3x3Mat4f( &a_pStore->pWorld[dwTransform], &a_pStore->pNormal[dwTransform] );
+		++dwNumUpdated;
+	}
+	return dwNumUpdated;
+}
+
+typedef struct TransformUpdateJob
+{
+	EntityStore *pStore;
+	u32 dwLevelBegin;
+	volatile LONG dwNumUpdated;
+} TransformUpdateJob;
+
+void UpdateTransformRangeJob( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	TransformUpdateJob *pJob = (TransformUpdateJob*)pContext;
+	u32 dwNumUpdated = UpdateTransformRange( pJob->pStore, pJob->dwLevelBegin + dwBegin, pJob->dwLevelBegin + dwEnd );
+	InterlockedExchangeAdd( &pJob->dwNumUpdated, (LONG)dwNumUpdated );
+}
+
+//brings every cached world matrix up to date, one level at a time so a level only reads parents the previous one finished,
+//levels with nothing set in them and nothing redone above them are skipped without being looked at
+//big levels are split over the workers, a_pPool can be null to stay on the calling thread, returns how many were redone
+inline
+u32 UpdateEntityTransforms( EntityStore *a_pStore, WorkerPool *a_pPool )
+{
+	if( a_pStore->bHierarchyChanged )
+	{
+		SortTransformsByLevel( a_pStore );
+	}
+	u32 dwNumUpdated = 0;
+	u32 dwUpdatedAbove = 0;
+	for( u32 dwLevel = 0; dwLevel < a_pStore->dwNumLevels; ++dwLevel )
+	{
+		if( !a_pStore->pLevelDirty[dwLevel] && !dwUpdatedAbove )
+		{
+			continue;
+		}
+		a_pStore->pLevelDirty[dwLevel] = 1; //the clear below has to visit the flags this level passed down too
+		u32 dwBegin = a_pStore->pLevelStart[dwLevel];
+		u32 dwCount = a_pStore->pLevelStart[dwLevel + 1] - dwBegin;
+		if( a_pPool && dwCount >= TRANSFORM_PARALLEL_MIN )
+		{
+			TransformUpdateJob job = { a_pStore, dwBegin, 0 };
+			ParallelFor( a_pPool, dwCount, TRANSFORM_CHUNK_SIZE, UpdateTransformRangeJob, &job );
+			dwUpdatedAbove = (u32)job.dwNumUpdated;
+		}
+		else
+		{
+			dwUpdatedAbove = UpdateTransformRange( a_pStore, dwBegin, dwBegin + dwCount );
+		}
+		dwNumUpdated += dwUpdatedAbove;
+	}
+	for( u32 dwLevel = 0; dwLevel < a_pStore->dwNumLevels; ++dwLevel )
+	{
+		if( a_pStore->pLevelDirty[dwLevel] )
+		{
+			memset( a_pStore->pDirty + a_pStore->pLevelStart[dwLevel], 0, a_pStore->pLevelStart[dwLevel + 1] - a_pStore->pLevelStart[dwLevel] );
+			a_pStore->pLevelDirty[dwLevel] = 0;
+		}
+	}
+	return dwNumUpdated;
+}
+
+inline
+bool InitSceneDrawList( SceneDrawList *a_pList, u32 dwCapacity )
+{
+	a_pList->dwCapacity = dwCapacity;
+	a_pList->dwCount = 0;
+	a_pList->dwNumStatic = 0;
+	a_pList->pWorld = (Mat4f*)malloc( ( sizeof(Mat4f) + sizeof(Mat3x4f) + ( 3 * sizeof(u32) ) + sizeof(u8) ) * dwCapacity );
+	if( !a_pList->pWorld )
+	{
+		return false;
+	}
+	a_pList->pNormal = (Mat3x4f*)( a_pList->pWorld + dwCapacity );
+	a_pList->pMesh = (u32*)( a_pList->pNormal + dwCapacity );
+	a_pList->pPalette = a_pList->pMesh + dwCapacity;
+	a_pList->pSlot = a_pList->pPalette + dwCapacity;
+	a_pList->pLod = (u8*)( a_pList->pSlot + dwCapacity );
+	return true;
+}
+
+inline
+void DestroySceneDrawList( SceneDrawList *a_pList )
+{
+	free( a_pList->pWorld );
+	a_pList->pWorld = nullptr;
+}
+
+//the one per frame pass over every renderable, gathers the cached world matrix and for static meshes the normal matrix,
+//so UpdateEntityTransforms has to have run since the last change
+//static draws are written from the front, skinned ones after them, both keep the renderable table's order
+inline
+void BuildSceneDrawList( EntityStore *a_pStore, SceneDrawList *a_pList )
+{
+#if MAIN_DEBUG
+	assert( a_pStore->renderables.dwCount <= a_pList->dwCapacity );
+	assert( !a_pStore->bHierarchyChanged );
+#endif
+	u32 dwStatic = 0;
+	u32 dwSkinned = a_pStore->renderables.dwCount - a_pStore->skinned.dwCount;
+	a_pList->dwNumStatic = dwSkinned;
+	a_pList->dwCount = a_pStore->renderables.dwCount;
+	for( u32 dwRenderable = 0; dwRenderable < a_pStore->renderables.dwCount; ++dwRenderable )
+	{
+		u32 dwSlot = a_pStore->renderables.pSlotOf[dwRenderable];
+		u32 dwSkin = a_pStore->skinned.pDenseOf[dwSlot];
+		u32 dwDraw = dwSkin == ENTITY_NONE ? dwStatic++ : dwSkinned++;
+		u32 dwTransform = a_pStore->transforms.pDenseOf[dwSlot];
+		a_pList->pWorld[dwDraw] = a_pStore->pWorld[dwTransform];
+		a_pList->pMesh[dwDraw] = a_pStore->pRenderMesh[dwRenderable];
+		a_pList->pSlot[dwDraw] = dwSlot;
+		a_pList->pLod[dwDraw] = 0;
+		if( dwSkin == ENTITY_NONE )
+		{
+			a_pList->pNormal[dwDraw] = a_pStore->pNormal[dwTransform];
+			a_pList->pPalette[dwDraw] = ENTITY_NONE;
+		}
+		else
+		{
+			a_pList->pPalette[dwDraw] = a_pStore->pSkinPalette[dwSkin];
+		}
+	}
+}
+
+//the skinned draws of a list as a list of their own over the same storage, for passes that leave the static ones to the gpu
+inline
+void SceneSkinnedDraws( SceneDrawList *a_pList, SceneDrawList *a_pOut )
+{
+	u32 dwNumStatic = a_pList->dwNumStatic;
+	a_pOut->pWorld = a_pList->pWorld + dwNumStatic;
+	a_pOut->pNormal = a_pList->pNormal + dwNumStatic;
+	a_pOut->pMesh = a_pList->pMesh + dwNumStatic;
+	a_pOut->pPalette = a_pList->pPalette + dwNumStatic;
+	a_pOut->pSlot = a_pList->pSlot + dwNumStatic;
+	a_pOut->pLod = a_pList->pLod + dwNumStatic;
+	a_pOut->dwNumStatic = 0;
+	a_pOut->dwCount = a_pList->dwCount - dwNumStatic;
+	a_pOut->dwCapacity = a_pList->dwCapacity - dwNumStatic;
+}
+
+#if BENCHMARK_MODE
+//100k entities with churn: checks handles, the dense tables staying consistent, and the batch matrices against the
+//matrix path DrawScene used to take for the cube (InitRotArbAxisMat4f then translate)
+u32 BenchmarkEntityStore()
+{
+	const u32 dwNumEntities = 100000;
+	const u32 dwIterations = 20;
+	EntityStore store;
+	SceneDrawList drawList;
+	if( !InitEntityStore( &store, dwNumEntities ) || !InitSceneDrawList( &drawList, dwNumEntities ) )
+	{
+		printf( "Entity store: out of memory\n" );
+		return 1;
+	}
+	EntityHandle *pHandles = (EntityHandle*)malloc( sizeof(EntityHandle) * dwNumEntities );
+	f32 *pAngles = (f32*)malloc( sizeof(f32) * dwNumEntities );
+	if( !pHandles || !pAngles )
+	{
+		printf( "Entity store: out of memory\n" );
+		free( pAngles );
+		free( pHandles );
+		DestroySceneDrawList( &drawList );
+		DestroyEntityStore( &store );
+		return 1;
+	}
+	Vec3f vAxis = { 0.57735026919f, 0.57735026919f, 0.57735026919f };
+	u32 dwSeed = 31337;
+	for( u32 dwIdx = 0; dwIdx < dwNumEntities; ++dwIdx )
+	{
+		pHandles[dwIdx] = CreateEntity( &store );
+		dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+		pAngles[dwIdx] = ( ( dwSeed >> 8 ) / (f32)( 1 << 24 ) ) * 360.0f;
+		Quatf qRot;
+		InitUnitQuatf( &qRot, pAngles[dwIdx], &vAxis );
+		Vec3f vPos = { (f32)( dwIdx % 100 ), (f32)( ( dwIdx / 100 ) % 100 ), -5.0f - (f32)( dwIdx / 10000 ) };
+		SetEntityTransform( &store, pHandles[dwIdx], &vPos, &qRot, 1.0f );
+		if( dwIdx % 4 ) //a quarter are invisible (triggers, attachment points)
+		{
+			AddRenderable( &store, pHandles[dwIdx], dwIdx % 10 == 1 ? MESH_HAND : MESH_CUBE );
+			if( dwIdx % 10 == 1 )
+			{
+				AddSkinnedInstance( &store, pHandles[dwIdx], dwIdx % ovrHand_Count );
+			}
+		}
+	}
+
+	//destroy every 7th, stale handles must stop resolving and the reused slots must hand out new generations
+	u32 dwFailures = 0;
+	for( u32 dwIdx = 0; dwIdx < dwNumEntities; dwIdx += 7 )
+	{
+		EntityHandle hOld = pHandles[dwIdx];
+		DestroyEntity( &store, hOld );
+		pHandles[dwIdx] = CreateEntity( &store );
+		dwFailures += EntityAlive( &store, hOld ) ? 1 : 0;
+		dwFailures += EntitySlot( hOld ) == EntitySlot( pHandles[dwIdx] ) && EntityAlive( &store, pHandles[dwIdx] ) ? 0 : 1;
+		Quatf qRot;
+		InitUnitQuatf( &qRot, pAngles[dwIdx], &vAxis );
+		Vec3f vPos = { (f32)( dwIdx % 100 ), (f32)( ( dwIdx / 100 ) % 100 ), -5.0f - (f32)( dwIdx / 10000 ) };
+		SetEntityTransform( &store, pHandles[dwIdx], &vPos, &qRot, 1.0f );
+		AddRenderable( &store, pHandles[dwIdx], MESH_PLANE ); //comes back as a static renderable
+	}
+	//sparse sets have to map both ways
+	ComponentTable *pTables[3] = { &store.transforms, &store.renderables, &store.skinned };
+	for( u32 dwTable = 0; dwTable < 3; ++dwTable )
+	{
+		for( u32 dwDense = 0; dwDense < pTables[dwTable]->dwCount; ++dwDense )
+		{
+			dwFailures += pTables[dwTable]->pDenseOf[pTables[dwTable]->pSlotOf[dwDense]] == dwDense ? 0 : 1;
+		}
+	}
+
+	//every transform was set, so the first update does them all and the rest find nothing to do
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	QueryPerformanceCounter( &startCounter );
+	u32 dwNumUpdated = UpdateEntityTransforms( &store, nullptr );
+	QueryPerformanceCounter( &endCounter );
+	f64 fNsPerTransform = ( 1000000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * store.transforms.dwCount );
+	dwFailures += dwNumUpdated == store.transforms.dwCount && !UpdateEntityTransforms( &store, nullptr ) ? 0 : 1;
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+	{
+		BuildSceneDrawList( &store, &drawList );
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fNsPerDraw = ( 1000000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwIterations * drawList.dwCount );
+
+	//every entity's draw, found through its handle, has to match the old matrix path
+	f32 fMaxError = 0.0f;
+	u32 dwChecked = 0;
+	for( u32 dwDraw = 0; dwDraw < drawList.dwCount; ++dwDraw )
+	{
+		dwFailures += ( dwDraw < drawList.dwNumStatic ) == ( drawList.pPalette[dwDraw] == ENTITY_NONE ) ? 0 : 1;
+		dwFailures += ( drawList.pMesh[dwDraw] == MESH_HAND ) == ( drawList.pPalette[dwDraw] != ENTITY_NONE ) ? 0 : 1;
+	}
+	for( u32 dwIdx = 0; dwIdx < dwNumEntities; ++dwIdx )
+	{
+		u32 dwSlot = EntitySlot( pHandles[dwIdx] );
+		if( store.renderables.pDenseOf[dwSlot] == ENTITY_NONE )
+		{
+			continue;
+		}
+		if( dwChecked++ == 2000 )
+		{
+			break; //the prefix count below is quadratic, this many is plenty
+		}
+		//draws keep the renderable order within their half
+		u32 dwRenderable = store.renderables.pDenseOf[dwSlot];
+		u32 dwDraw = 0;
+		u8 bSkinned = store.skinned.pDenseOf[dwSlot] != ENTITY_NONE;
+		for( u32 dwPrev = 0; dwPrev < dwRenderable; ++dwPrev )
+		{
+			dwDraw += ( store.skinned.pDenseOf[store.renderables.pSlotOf[dwPrev]] != ENTITY_NONE ) == bSkinned ? 1 : 0;
+		}
+		dwDraw += bSkinned ? drawList.dwNumStatic : 0;
+
+		Mat4f mRot, mTrans, mExpected;
+		InitRotArbAxisMat4f( &mRot, &vAxis, pAngles[dwIdx] );
+		InitTransMat4f( &mTrans, (f32)( dwIdx % 100 ), (f32)( ( dwIdx / 100 ) % 100 ), -5.0f - (f32)( dwIdx / 10000 ) );
+		Mat4fMult( &mRot, &mTrans, &mExpected );
+		for( u32 dwRow = 0; dwRow < 4; ++dwRow )
+		{
+			for( u32 dwCol = 0; dwCol < 4; ++dwCol )
+			{
+				f32 fError = fabsf( mExpected.m[dwRow][dwCol] - drawList.pWorld[dwDraw].m[dwRow][dwCol] );
+				fMaxError = fError > fMaxError ? fError : fMaxError;
+			}
+		}
+		if( !bSkinned )
+		{
+			Mat3x4f mExpectedNormal;
+			InverseTransposeUpper3x3Mat4f( &mExpected, &mExpectedNormal );
+			for( u32 dwRow = 0; dwRow < 3; ++dwRow )
+			{
+				for( u32 dwCol = 0; dwCol < 3; ++dwCol )
+				{
+					f32 fError = fabsf( mExpectedNormal.m[dwRow][dwCol] - drawList.pNormal[dwDraw].m[dwRow][dwCol] );
+					fMaxError = fError > fMaxError ? fError : fMaxError;
+				}
+			}
+		}
+	}
+	dwFailures += fMaxError < 1e-4f ? 0 : 1;
+	printf( "Entity store: %u entities, %u draws (%u skinned), %.1fns/transform for world+normal matrices, %.1fns/draw to gather, max error %g, %u failures\n",
+		store.transforms.dwCount, drawList.dwCount, drawList.dwCount - drawList.dwNumStatic, fNsPerTransform, fNsPerDraw, fMaxError, dwFailures );
+	free( pAngles );
+	free( pHandles );
+	DestroySceneDrawList( &drawList );
+	DestroyEntityStore( &store );
+	return dwFailures;
+}
+
+//reference for the hierarchy benchmark, parents come before children in the handle array so one forward pass builds every world matrix,
+//destroyed entries have ENTITY_NONE handles
+inline
+u32 CheckTransformHierarchy( EntityStore *a_pStore, EntityHandle *pHandles, u32 *pParents, u32 dwNumEntities, Mat4f *pExpected, f32 *a_pMaxError )
+{
+	u32 dwFailures = 0;
+	for( u32 dwIdx = 0; dwIdx < dwNumEntities; ++dwIdx )
+	{
+		if( pHandles[dwIdx] == ENTITY_NONE )
+		{
+			continue;
+		}
+		u32 dwTransform = a_pStore->transforms.pDenseOf[EntitySlot( pHandles[dwIdx] )];
+		Mat4f mLocal;
+		EntityLocalMatrix( a_pStore, dwTransform, &mLocal );
+		if( pParents[dwIdx] == ENTITY_NONE )
+		{
+			pExpected[dwIdx] = mLocal;
+		}
+		else
+		{
+			Mat4fMult( &mLocal, &pExpected[pParents[dwIdx]], &pExpected[dwIdx] );
+		}
+		u32 dwParent = a_pStore->pParentDense[dwTransform];
+		dwFailures += ( pParents[dwIdx] == ENTITY_NONE ) == ( dwParent == ENTITY_NONE ) ? 0 : 1;
+		dwFailures += dwParent == ENTITY_NONE || ( dwParent < dwTransform && a_pStore->pLevel[dwParent] + 1 == a_pStore->pLevel[dwTransform] ) ? 0 : 1;
+		for( u32 dwRow = 0; dwRow < 4; ++dwRow )
+		{
+			for( u32 dwCol = 0; dwCol < 4; ++dwCol )
+			{
+				f32 fError = fabsf( pExpected[dwIdx].m[dwRow][dwCol] - a_pStore->pWorld[dwTransform].m[dwRow][dwCol] );
+				*a_pMaxError = fError > *a_pMaxError ? fError : *a_pMaxError;
+			}
+		}
+		if( !( dwIdx & 15 ) )
+		{
+			Mat3x4f mExpectedNormal;
+			InverseTransposeUpper3x3Mat4f( &pExpected[dwIdx], &mExpectedNormal );
+			for( u32 dwRow = 0; dwRow < 3; ++dwRow )
+			{
+				for( u32 dwCol = 0; dwCol < 3; ++dwCol )
+				{
+					f32 fError = fabsf( mExpectedNormal.m[dwRow][dwCol] - a_pStore->pNormal[dwTransform].m[dwRow][dwCol] );
+					*a_pMaxError = fError > *a_pMaxError ? fError : *a_pMaxError;
+				}
+			}
+		}
+	}
+	return dwFailures;
+}
+
+//a wide tree (16 roots, 256 children each, 32 below each of those) and 256 chains 512 deep, ~130k transforms each:
+//full updates on one thread and on the workers, then a sparse update, a clean one, and one after reparenting and destroying,
+//every world and normal matrix checked against a plain forward pass
+u32 BenchmarkTransformHierarchy()
+{
+	const u32 dwNumWideEntities = 16 + ( 16 * 256 ) + ( 16 * 256 * 32 );
+	const u32 dwNumDeepEntities = 256 * 512;
+	const u32 dwMaxEntities = dwNumWideEntities > dwNumDeepEntities ? dwNumWideEntities : dwNumDeepEntities;
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo( &systemInfo );
+	WorkerPool pool;
+	EntityStore store;
+	store.pPosX = nullptr;
+	EntityHandle *pHandles = (EntityHandle*)malloc( ( sizeof(EntityHandle) + sizeof(u32) ) * dwMaxEntities );
+	u32 *pParents = (u32*)( pHandles + dwMaxEntities );
+	Mat4f *pExpected = (Mat4f*)malloc( sizeof(Mat4f) * dwMaxEntities );
+	if( !pHandles || !pExpected || !InitWorkerPool( &pool, systemInfo.dwNumberOfProcessors - 1 ) )
+	{
+		printf( "Transform hierarchy: out of memory\n" );
+		free( pExpected );
+		free( pHandles );
+		return 1;
+	}
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	f64 fMsPerCount = 1000.0 / (f64)PerfCountFrequency.QuadPart;
+	Vec3f vAxis = { 0.57735026919f, 0.57735026919f, 0.57735026919f };
+	u32 dwSeed = 4242;
+	const char *pShapeNames[2] = { "wide", "deep" };
+	u32 dwTotalFailures = 0;
+	for( u32 dwShape = 0; dwShape < 2; ++dwShape )
+	{
+		u32 dwNumEntities = dwShape == 0 ? dwNumWideEntities : dwNumDeepEntities;
+		u32 dwNumRoots = dwShape == 0 ? 16 : 256;
+		if( !InitEntityStore( &store, dwNumEntities ) )
+		{
+			printf( "Transform hierarchy: out of memory\n" );
+			++dwTotalFailures;
+			break;
+		}
+		for( u32 dwIdx = 0; dwIdx < dwNumEntities; ++dwIdx )
+		{
+			if( dwShape == 0 )
+			{
+				pParents[dwIdx] = dwIdx < 16 ? ENTITY_NONE : dwIdx < 16 + 4096 ? ( dwIdx - 16 ) / 256 : 16 + ( ( dwIdx - 16 - 4096 ) / 32 );
+			}
+			else
+			{
+				pParents[dwIdx] = dwIdx < 256 ? ENTITY_NONE : dwIdx - 256;
+			}
+		}
+		//create in a scrambled order and attach children before their parents are attached so the level sort has real work
+		for( u32 dwCreated = 0; dwCreated < dwNumEntities; ++dwCreated )
+		{
+			pHandles[( (u64)dwCreated * 7919 ) % dwNumEntities] = CreateEntity( &store );
+		}
+		for( u32 dwIdx = dwNumEntities; dwIdx-- > 0; )
+		{
+			dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+			Quatf qRot;
+			InitUnitQuatf( &qRot, ( ( dwSeed >> 8 ) / (f32)( 1 << 24 ) ) * 20.0f, &vAxis );
+			Vec3f vPos = { 0.01f * (f32)( dwIdx % 7 ), 0.01f, -0.01f * (f32)( dwIdx % 3 ) };
+			SetEntityTransform( &store, pHandles[dwIdx], &vPos, &qRot, 1.0f );
+			if( pParents[dwIdx] != ENTITY_NONE )
+			{
+				SetEntityParent( &store, pHandles[dwIdx], pHandles[pParents[dwIdx]] );
+			}
+		}
+		QueryPerformanceCounter( &startCounter );
+		u32 dwNumUpdated = UpdateEntityTransforms( &store, &pool );
+		QueryPerformanceCounter( &endCounter );
+		f64 fSortAndUpdateMs = fMsPerCount * ( endCounter.QuadPart - startCounter.QuadPart );
+		f32 fMaxError = 0.0f;
+		u32 dwFailures = dwNumUpdated == dwNumEntities ? 0 : 1;
+		dwFailures += CheckTransformHierarchy( &store, pHandles, pParents, dwNumEntities, pExpected, &fMaxError );
+
+		//setting just the roots redoes everything below them
+		f64 fFullMs[2];
+		for( u32 dwParallel = 0; dwParallel < 2; ++dwParallel )
+		{
+			for( u32 dwRoot = 0; dwRoot < dwNumRoots; ++dwRoot )
+			{
+				Quatf qRot;
+				GetEntityRotation( &store, pHandles[dwRoot], &qRot );
+				SetEntityRotation( &store, pHandles[dwRoot], &qRot );
+			}
+			QueryPerformanceCounter( &startCounter );
+			dwNumUpdated = UpdateEntityTransforms( &store, dwParallel ? &pool : nullptr );
+			QueryPerformanceCounter( &endCounter );
+			fFullMs[dwParallel] = fMsPerCount * ( endCounter.QuadPart - startCounter.QuadPart );
+			dwFailures += dwNumUpdated == dwNumEntities ? 0 : 1;
+		}
+		dwFailures += CheckTransformHierarchy( &store, pHandles, pParents, dwNumEntities, pExpected, &fMaxError );
+
+		//a few props moving, only their subtrees get redone
+		for( u32 dwSet = 0; dwSet < dwNumEntities / 1000; ++dwSet )
+		{
+			dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+			Quatf qRot;
+			InitUnitQuatf( &qRot, ( ( dwSeed >> 8 ) / (f32)( 1 << 24 ) ) * 20.0f, &vAxis );
+			SetEntityRotation( &store, pHandles[( dwSeed >> 4 ) % dwNumEntities], &qRot );
+		}
+		QueryPerformanceCounter( &startCounter );
+		u32 dwNumSparseUpdated = UpdateEntityTransforms( &store, &pool );
+		QueryPerformanceCounter( &endCounter );
+		f64 fSparseMs = fMsPerCount * ( endCounter.QuadPart - startCounter.QuadPart );
+		dwFailures += dwNumSparseUpdated < dwNumEntities ? 0 : 1;
+		dwFailures += CheckTransformHierarchy( &store, pHandles, pParents, dwNumEntities, pExpected, &fMaxError );
+
+		QueryPerformanceCounter( &startCounter );
+		dwNumUpdated = UpdateEntityTransforms( &store, &pool );
+		QueryPerformanceCounter( &endCounter );
+		f64 fCleanMs = fMsPerCount * ( endCounter.QuadPart - startCounter.QuadPart );
+		dwFailures += dwNumUpdated == 0 ? 0 : 1;
+
+		//move some subtrees onto the first root and destroy some inner transforms, their children become roots
+		for( u32 dwMove = 0; dwMove < 100; ++dwMove )
+		{
+			dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+			u32 dwIdx = dwNumRoots + ( ( dwSeed >> 4 ) % ( dwNumEntities - dwNumRoots ) );
+			if( pHandles[dwIdx] == ENTITY_NONE )
+			{
+				continue;
+			}
+			if( dwMove & 1 )
+			{
+				SetEntityParent( &store, pHandles[dwIdx], pHandles[0] );
+				pParents[dwIdx] = 0;
+			}
+			else
+			{
+				DestroyEntity( &store, pHandles[dwIdx] );
+				pHandles[dwIdx] = ENTITY_NONE;
+				for( u32 dwChild = dwIdx + 1; dwChild < dwNumEntities; ++dwChild )
+				{
+					pParents[dwChild] = pParents[dwChild] == dwIdx ? ENTITY_NONE : pParents[dwChild];
+				}
+			}
+		}
+		UpdateEntityTransforms( &store, &pool );
+		dwFailures += CheckTransformHierarchy( &store, pHandles, pParents, dwNumEntities, pExpected, &fMaxError );
+		dwFailures += fMaxError < 1e-3f ? 0 : 1;
+		printf( "Transform hierarchy %s: %u transforms in %u levels, sort+update %.2fms, full update %.2fms serial %.2fms on %u workers, "
+			"%u set %.3fms (%u redone), clean %.3fms, max error %g, %u failures\n",
+			pShapeNames[dwShape], dwNumEntities, store.dwNumLevels, fSortAndUpdateMs, fFullMs[0], fFullMs[1], pool.dwNumThreads,
+			dwNumEntities / 1000, fSparseMs, dwNumSparseUpdated, fCleanMs, fMaxError, dwFailures );
+		DestroyEntityStore( &store );
+		dwTotalFailures += dwFailures;
+	}
+	DestroyWorkerPool( &pool );
+	free( pExpected );
+	free( pHandles );
+	return dwTotalFailures;
+}
+#endif
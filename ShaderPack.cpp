@@ -0,0 +1,99 @@
+//ShaderPack, offline half of ShaderPermutations.h, built and run by Compile.bat before the app
+//"ShaderPack.exe list <prefix>" prints a "<prefix>_<key>.cso <fxc defines>" line per permutation for a for /f loop to compile
+//"ShaderPack.exe pack <prefix> <out.h> <arrayName>" reads those .cso files back and writes the archive as a header to include
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+typedef uint8_t u8;
+typedef uint32_t u32;
+
+#include "ShaderPermutations.h"
+
+int List( const char *a_pPrefix )
+{
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT; ++dwKey )
+	{
+		printf( "%s_%u.cso /DMAX_BONES=%u /DARRAY_IN_STRUCTURED_BUFFER=%u /DINSTANCED=%u\n", a_pPrefix, dwKey, SkinPermutationBones( dwKey ),
+			SkinPermutationLayout( dwKey ) == SKIN_LAYOUT_PALETTE_ARRAY ? 1 : 0, dwKey & 1 );
+	}
+	return 0;
+}
+
+int Pack( const char *a_pPrefix, const char *a_pOutName, const char *a_pArrayName )
+{
+	ShaderBlob blobs[SKIN_PERMUTATION_COUNT] = {};
+	int result = 0;
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT && !result; ++dwKey )
+	{
+		char name[256];
+		snprintf( name, sizeof( name ), "%s_%u.cso", a_pPrefix, dwKey );
+		FILE *pFile = fopen( name, "rb" );
+		if( !pFile )
+		{
+			printf( "ShaderPack: can't open %s\n", name );
+			result = 1;
+			break;
+		}
+		fseek( pFile, 0, SEEK_END );
+		long size = ftell( pFile );
+		fseek( pFile, 0, SEEK_SET );
+		void *pData = malloc( size > 0 ? size : 1 );
+		if( size <= 0 || fread( pData, 1, size, pFile ) != (size_t)size )
+		{
+			printf( "ShaderPack: can't read %s\n", name );
+			result = 1;
+		}
+		fclose( pFile );
+		blobs[dwKey].pData = pData;
+		blobs[dwKey].dwSize = result ? 0 : (u32)size;
+	}
+
+	if( !result )
+	{
+		u32 dwArchiveSize = ShaderArchiveWrite( blobs, SKIN_PERMUTATION_COUNT, nullptr );
+		u8 *pArchive = (u8*)malloc( dwArchiveSize );
+		ShaderArchiveWrite( blobs, SKIN_PERMUTATION_COUNT, pArchive );
+
+		FILE *pOut = fopen( a_pOutName, "w" );
+		if( !pOut )
+		{
+			printf( "ShaderPack: can't write %s\n", a_pOutName );
+			result = 1;
+		}
+		else
+		{
+			fprintf( pOut, "//generated by ShaderPack.exe from %s_*.cso, see ShaderPermutations.h\n", a_pPrefix );
+			fprintf( pOut, "alignas( 16 ) const unsigned char %s[] =\n{", a_pArrayName );
+			for( u32 dwByte = 0; dwByte < dwArchiveSize; ++dwByte )
+			{
+				fprintf( pOut, "%s%3u,", ( dwByte % 16 ) ? " " : "\n\t", pArchive[dwByte] );
+			}
+			fprintf( pOut, "\n};\n" );
+			fclose( pOut );
+		}
+		free( pArchive );
+	}
+
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT; ++dwKey )
+	{
+		free( (void*)blobs[dwKey].pData );
+	}
+	return result;
+}
+
+int main( int argc, char **argv )
+{
+	if( argc == 3 && strcmp( argv[1], "list" ) == 0 )
+	{
+		return List( argv[2] );
+	}
+	if( argc == 5 && strcmp( argv[1], "pack" ) == 0 )
+	{
+		return Pack( argv[2], argv[3], argv[4] );
+	}
+	printf( "usage: ShaderPack list <prefix>\n       ShaderPack pack <prefix> <out.h> <arrayName>\n" );
+	return 1;
+}
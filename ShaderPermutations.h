@@ -0,0 +1,327 @@
+//Shader permutations, the skinned vertex shader gets compiled offline for every combination of the axes below: ShaderPack.cpp lists
+//the fxc defines of each one for Compile.bat, then packs the compiled .cso files into one indexed archive header (identical blobs stored once)
+//at startup the smallest MAX_BONES variant the skeleton fits in is picked, so a 7 bone hand doesn't pay for 32 bone palettes
+//STRUCTURED_BUFFER=0 isn't an axis, its constant buffer array needs a descriptor table the skinned root signature doesn't have
+//shared with ShaderPack.cpp, so nothing in here touches D3D12
+
+#define SHADER_ARCHIVE_MAGIC 0x52414853 //"SHAR"
+#define SHADER_ARCHIVE_VERSION 1
+#define SHADER_ARCHIVE_ALIGNMENT 4 //every blob starts on one
+
+//the manifest, each axis is a digit of the permutation key: ( ( ( boneVariant * SKIN_LAYOUT_COUNT ) + layout ) * 2 ) + instanced
+#define SKIN_BONE_VARIANTS 3
+const u32 skinBoneCounts[SKIN_BONE_VARIANTS] = { 8, 16, 32 }; //ascending, the last one has to be MAX_BONES
+
+enum SkinLayout
+{
+	SKIN_LAYOUT_PALETTE_ARRAY, //ARRAY_IN_STRUCTURED_BUFFER=1, one structured buffer element per palette
+	SKIN_LAYOUT_FLAT, //ARRAY_IN_STRUCTURED_BUFFER=0, one element per bone, palettes MAX_BONES elements apart
+	SKIN_LAYOUT_COUNT
+};
+
+#define SKIN_LAYOUT_DEFAULT SKIN_LAYOUT_PALETTE_ARRAY
+#define SKIN_PERMUTATION_COUNT ( SKIN_BONE_VARIANTS * SKIN_LAYOUT_COUNT * 2 )
+
+typedef struct ShaderArchiveHeader
+{
+	u32 dwMagic;
+	u32 dwVersion;
+	u32 dwNumEntries;
+	u32 dwSize; //whole archive, header included
+} ShaderArchiveHeader;
+
+//sorted by key, right after the header
+typedef struct ShaderArchiveEntry
+{
+	u32 dwKey;
+	u32 dwOffset; //from the start of the archive
+	u32 dwSize;
+	u32 dwPad;
+} ShaderArchiveEntry;
+
+typedef struct ShaderBlob
+{
+	const void *pData;
+	u32 dwSize;
+} ShaderBlob;
+
+inline
+u32 SkinPermutationKey( u32 dwBoneVariant, u32 dwLayout, u32 bInstanced )
+{
+	return ( ( ( dwBoneVariant * SKIN_LAYOUT_COUNT ) + dwLayout ) * 2 ) + ( bInstanced ? 1 : 0 );
+}
+
+inline
+u32 SkinPermutationBones( u32 dwKey )
+{
+	return skinBoneCounts[( dwKey / 2 ) / SKIN_LAYOUT_COUNT];
+}
+
+inline
+u32 SkinPermutationLayout( u32 dwKey )
+{
+	return ( dwKey / 2 ) % SKIN_LAYOUT_COUNT;
+}
+
+//smallest variant with room for the skeleton, SKIN_BONE_VARIANTS if none has
+inline
+u32 SkinBoneVariantForSkeleton( u32 dwNumBones )
+{
+	u32 dwBoneVariant = 0;
+	while( dwBoneVariant < SKIN_BONE_VARIANTS && skinBoneCounts[dwBoneVariant] < dwNumBones )
+	{
+		++dwBoneVariant;
+	}
+	return dwBoneVariant;
+}
+
+//binary search of the entry table, anything out of bounds counts as not found so a bad archive can't be read past its end
+inline
+bool ShaderArchiveFind( const u8 *a_pArchive, u32 dwArchiveSize, u32 dwKey, ShaderBlob *a_pBlob )
+{
+	const ShaderArchiveHeader *pHeader = (const ShaderArchiveHeader*)a_pArchive;
+	if( dwArchiveSize < sizeof( ShaderArchiveHeader ) || pHeader->dwMagic != SHADER_ARCHIVE_MAGIC || pHeader->dwVersion != SHADER_ARCHIVE_VERSION ||
+		pHeader->dwSize != dwArchiveSize || pHeader->dwNumEntries > ( dwArchiveSize - sizeof( ShaderArchiveHeader ) ) / sizeof( ShaderArchiveEntry ) )
+	{
+		return false;
+	}
+	const ShaderArchiveEntry *pEntries = (const ShaderArchiveEntry*)( a_pArchive + sizeof( ShaderArchiveHeader ) );
+	u32 dwLow = 0;
+	u32 dwHigh = pHeader->dwNumEntries;
+	while( dwLow < dwHigh )
+	{
+		u32 dwMid = ( dwLow + dwHigh ) / 2;
+		if( pEntries[dwMid].dwKey < dwKey )
+		{
+			dwLow = dwMid + 1;
+		}
+		else
+		{
+			dwHigh = dwMid;
+		}
+	}
+	if( dwLow == pHeader->dwNumEntries || pEntries[dwLow].dwKey != dwKey || pEntries[dwLow].dwOffset > dwArchiveSize ||
+		pEntries[dwLow].dwSize > dwArchiveSize - pEntries[dwLow].dwOffset )
+	{
+		return false;
+	}
+	a_pBlob->pData = a_pArchive + pEntries[dwLow].dwOffset;
+	a_pBlob->dwSize = pEntries[dwLow].dwSize;
+	return true;
+}
+
+//a_pBlobs is indexed by key, a 0 size skips the key, returns the archive size (a_pArchive can be null to just get that)
+inline
+u32 ShaderArchiveWrite( ShaderBlob *a_pBlobs, u32 dwNumKeys, u8 *a_pArchive )
+{
+	u32 dwNumEntries = 0;
+	for( u32 dwKey = 0; dwKey < dwNumKeys; ++dwKey )
+	{
+		dwNumEntries += a_pBlobs[dwKey].dwSize ? 1 : 0;
+	}
+	u32 dwOffset = sizeof( ShaderArchiveHeader ) + ( dwNumEntries * sizeof( ShaderArchiveEntry ) );
+	ShaderArchiveEntry *pEntries = a_pArchive ? (ShaderArchiveEntry*)( a_pArchive + sizeof( ShaderArchiveHeader ) ) : nullptr;
+	u32 dwEntry = 0;
+	for( u32 dwKey = 0; dwKey < dwNumKeys; ++dwKey )
+	{
+		ShaderBlob *pBlob = &a_pBlobs[dwKey];
+		if( !pBlob->dwSize )
+		{
+			continue;
+		}
+		//blobs with the same bytes as an earlier one point at its copy, that one's entry index is the non empty keys before it
+		u32 dwEarlierEntry = 0;
+		bool bDuplicate = false;
+		for( u32 dwEarlier = 0; dwEarlier < dwKey && !bDuplicate; ++dwEarlier )
+		{
+			ShaderBlob *pEarlier = &a_pBlobs[dwEarlier];
+			if( pEarlier->dwSize == pBlob->dwSize && memcmp( pEarlier->pData, pBlob->pData, pBlob->dwSize ) == 0 )
+			{
+				bDuplicate = true;
+			}
+			else if( pEarlier->dwSize )
+			{
+				++dwEarlierEntry;
+			}
+		}
+		u32 dwBlobOffset = dwOffset;
+		if( bDuplicate )
+		{
+			dwBlobOffset = a_pArchive ? pEntries[dwEarlierEntry].dwOffset : 0;
+		}
+		else
+		{
+			if( a_pArchive )
+			{
+				memcpy( a_pArchive + dwOffset, pBlob->pData, pBlob->dwSize );
+				memset( a_pArchive + dwOffset + pBlob->dwSize, 0, ( SHADER_ARCHIVE_ALIGNMENT - ( pBlob->dwSize % SHADER_ARCHIVE_ALIGNMENT ) ) % SHADER_ARCHIVE_ALIGNMENT );
+			}
+			dwOffset += ( pBlob->dwSize + SHADER_ARCHIVE_ALIGNMENT - 1 ) & ~( SHADER_ARCHIVE_ALIGNMENT - 1 );
+		}
+		if( a_pArchive )
+		{
+			pEntries[dwEntry].dwKey = dwKey;
+			pEntries[dwEntry].dwOffset = dwBlobOffset;
+			pEntries[dwEntry].dwSize = pBlob->dwSize;
+			pEntries[dwEntry].dwPad = 0;
+		}
+		++dwEntry;
+	}
+	if( a_pArchive )
+	{
+		ShaderArchiveHeader *pHeader = (ShaderArchiveHeader*)a_pArchive;
+		pHeader->dwMagic = SHADER_ARCHIVE_MAGIC;
+		pHeader->dwVersion = SHADER_ARCHIVE_VERSION;
+		pHeader->dwNumEntries = dwNumEntries;
+		pHeader->dwSize = dwOffset;
+	}
+	return dwOffset;
+}
+
+typedef struct SkinShaders
+{
+	u32 dwBones; //MAX_BONES of the picked variant, also how many bones apart the palettes are in the bone buffer
+	u32 dwBoneVariant;
+	ShaderBlob blobs[SKIN_LAYOUT_COUNT][2]; //[layout][instanced], every layout reads the same palettes so they can be swapped per frame
+} SkinShaders;
+
+SkinShaders skinShaders;
+
+//fails if no variant has room for the skeleton or the archive is missing one of its permutations
+inline
+bool InitSkinShaders( SkinShaders *a_pShaders, const u8 *a_pArchive, u32 dwArchiveSize, u32 dwNumBones )
+{
+	a_pShaders->dwBoneVariant = SkinBoneVariantForSkeleton( dwNumBones );
+	if( a_pShaders->dwBoneVariant == SKIN_BONE_VARIANTS )
+	{
+		return false;
+	}
+	a_pShaders->dwBones = skinBoneCounts[a_pShaders->dwBoneVariant];
+	for( u32 dwLayout = 0; dwLayout < SKIN_LAYOUT_COUNT; ++dwLayout )
+	{
+		for( u32 bInstanced = 0; bInstanced < 2; ++bInstanced )
+		{
+			if( !ShaderArchiveFind( a_pArchive, dwArchiveSize, SkinPermutationKey( a_pShaders->dwBoneVariant, dwLayout, bInstanced ), &a_pShaders->blobs[dwLayout][bInstanced] ) )
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+#if BENCHMARK_MODE
+//fake blobs for every key with a few duplicates, then a full archive for the manifest: the app passes the one Compile.bat built,
+//Tests.cpp packs its own since there's no fxc there
+inline
+u32 BenchmarkShaderPermutations( const u8 *a_pSkinnedArchive, u32 dwSkinnedArchiveSize )
+{
+	u32 dwFailures = 0;
+	u8 bytes[SKIN_PERMUTATION_COUNT][300];
+	ShaderBlob blobs[SKIN_PERMUTATION_COUNT];
+	u32 dwSeed = 4242;
+	u32 dwUniqueSize = 0;
+	u32 dwFoldedSize = 0;
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT; ++dwKey )
+	{
+		for( u32 dwByte = 0; dwByte < sizeof( bytes[0] ); ++dwByte )
+		{
+			dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+			bytes[dwKey][dwByte] = (u8)( dwSeed >> 24 );
+		}
+		blobs[dwKey].pData = bytes[dwKey];
+		blobs[dwKey].dwSize = 200 + ( dwKey * 7 ); //mostly unaligned sizes
+		if( dwKey % 5 == 4 )
+		{
+			memcpy( bytes[dwKey], bytes[dwKey - 3], sizeof( bytes[0] ) ); //same bytes and size as an earlier key, like permutations fxc folds together
+			blobs[dwKey].dwSize = blobs[dwKey - 3].dwSize;
+		}
+	}
+	blobs[SKIN_PERMUTATION_COUNT - 1].dwSize = 0; //skipped key
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT; ++dwKey )
+	{
+		if( dwKey % 5 == 4 )
+		{
+			dwFoldedSize += blobs[dwKey].dwSize;
+		}
+		else
+		{
+			dwUniqueSize += ( blobs[dwKey].dwSize + SHADER_ARCHIVE_ALIGNMENT - 1 ) & ~( SHADER_ARCHIVE_ALIGNMENT - 1 );
+		}
+	}
+
+	u32 dwArchiveSize = ShaderArchiveWrite( blobs, SKIN_PERMUTATION_COUNT, nullptr );
+	u8 *pArchive = (u8*)malloc( dwArchiveSize );
+	if( !pArchive )
+	{
+		printf( "Shader permutations: out of memory\n" );
+		return 1;
+	}
+	dwFailures += ShaderArchiveWrite( blobs, SKIN_PERMUTATION_COUNT, pArchive ) == dwArchiveSize ? 0 : 1;
+	dwFailures += dwArchiveSize == sizeof( ShaderArchiveHeader ) + ( ( SKIN_PERMUTATION_COUNT - 1 ) * sizeof( ShaderArchiveEntry ) ) + dwUniqueSize ? 0 : 1;
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT; ++dwKey )
+	{
+		ShaderBlob found;
+		bool bFound = ShaderArchiveFind( pArchive, dwArchiveSize, dwKey, &found );
+		if( !blobs[dwKey].dwSize )
+		{
+			dwFailures += bFound ? 1 : 0;
+			continue;
+		}
+		dwFailures += ( bFound && found.dwSize == blobs[dwKey].dwSize && memcmp( found.pData, blobs[dwKey].pData, found.dwSize ) == 0 &&
+			( ( (const u8*)found.pData - pArchive ) % SHADER_ARCHIVE_ALIGNMENT ) == 0 ) ? 0 : 1;
+	}
+	ShaderBlob missing;
+	dwFailures += ShaderArchiveFind( pArchive, dwArchiveSize, SKIN_PERMUTATION_COUNT + 3, &missing ) ? 1 : 0;
+	dwFailures += ShaderArchiveFind( pArchive, dwArchiveSize - 4, 0, &missing ) ? 1 : 0; //truncated
+	dwFailures += ShaderArchiveFind( nullptr, 0, 0, &missing ) ? 1 : 0;
+	( (ShaderArchiveHeader*)pArchive )->dwMagic ^= 1;
+	dwFailures += ShaderArchiveFind( pArchive, dwArchiveSize, 0, &missing ) ? 1 : 0;
+	( (ShaderArchiveHeader*)pArchive )->dwMagic ^= 1;
+	ShaderArchiveEntry *pFirstEntry = (ShaderArchiveEntry*)( pArchive + sizeof( ShaderArchiveHeader ) );
+	pFirstEntry->dwOffset = dwArchiveSize - 8; //runs past the end
+	dwFailures += ShaderArchiveFind( pArchive, dwArchiveSize, pFirstEntry->dwKey, &missing ) ? 1 : 0;
+
+	//smallest fitting bone count
+	for( u32 dwBones = 1; dwBones <= skinBoneCounts[SKIN_BONE_VARIANTS - 1] + 1; ++dwBones )
+	{
+		u32 dwBoneVariant = SkinBoneVariantForSkeleton( dwBones );
+		bool bFits = dwBoneVariant < SKIN_BONE_VARIANTS && skinBoneCounts[dwBoneVariant] >= dwBones;
+		bool bSmallest = dwBoneVariant == 0 || skinBoneCounts[dwBoneVariant - 1] < dwBones;
+		dwFailures += ( ( dwBones > skinBoneCounts[SKIN_BONE_VARIANTS - 1] ) ? dwBoneVariant == SKIN_BONE_VARIANTS : ( bFits && bSmallest ) ) ? 0 : 1;
+	}
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT; ++dwKey )
+	{
+		u32 dwBoneVariant = SkinBoneVariantForSkeleton( SkinPermutationBones( dwKey ) );
+		dwFailures += SkinPermutationKey( dwBoneVariant, SkinPermutationLayout( dwKey ), dwKey & 1 ) == dwKey ? 0 : 1;
+	}
+
+	//every permutation the hands can pick has to be in the real archive
+	SkinShaders shaders;
+	for( u32 dwBoneVariant = 0; dwBoneVariant < SKIN_BONE_VARIANTS; ++dwBoneVariant )
+	{
+		dwFailures += ( InitSkinShaders( &shaders, a_pSkinnedArchive, dwSkinnedArchiveSize, skinBoneCounts[dwBoneVariant] ) &&
+			shaders.dwBoneVariant == dwBoneVariant && shaders.dwBones == skinBoneCounts[dwBoneVariant] ) ? 0 : 1;
+	}
+	dwFailures += InitSkinShaders( &shaders, a_pSkinnedArchive, dwSkinnedArchiveSize, skinBoneCounts[SKIN_BONE_VARIANTS - 1] + 1 ) ? 1 : 0;
+
+	const u32 dwLookups = 1000000;
+	u32 dwFound = 0;
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwLookup = 0; dwLookup < dwLookups; ++dwLookup )
+	{
+		ShaderBlob found;
+		dwFound += ShaderArchiveFind( a_pSkinnedArchive, dwSkinnedArchiveSize, dwLookup % SKIN_PERMUTATION_COUNT, &found ) ? 1 : 0;
+	}
+	QueryPerformanceCounter( &endCounter );
+	dwFailures += dwFound == dwLookups ? 0 : 1;
+	f64 fLookupNs = ( 1000000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwLookups );
+	free( pArchive );
+
+	printf( "Shader permutations: %u keys, lookup %.1fns, skinned archive %u bytes, test archive folded %u duplicate bytes, %u failures\n", SKIN_PERMUTATION_COUNT,
+		fLookupNs, dwSkinnedArchiveSize, dwFoldedSize, dwFailures );
+	return dwFailures;
+}
+#endif
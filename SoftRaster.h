@@ -0,0 +1,1818 @@
+//Software rasterizer, the reference renderer for image tests on machines without a gpu. it replays the RenderCommandStream a recording
+//null backend (RenderQueue.h) made of a frame with the input layouts of InitDirectX12's pipelines, VertexShader.hlsl in each of its
+//variants, VertexShaderSkinned.hlsl and PixelShader.hlsl ported to C++, and their rasterizer state (back faces culled with clockwise
+//as front, GREATER depth with REVERSE_Z and LESS without, an srgb target). the rest follows D3D's rules: positions snapped to 8 bits of
+//subpixel precision, the top left fill rule, depth clipping and perspective correct attributes.
+//a frame goes through 3 parallel passes on a WorkerPool: vertices per draw instance, triangle setup that bins every triangle into the
+//SOFT_RASTER_TILE_SIZE tiles it touches in submission order, then the tiles, each owned by one thread so the image doesn't depend on
+//the thread count. with AVX_ACTIVE pixels go 8 at a time, the scalar path does the same math one pixel at a time.
+//buffers are read straight from their gpu virtual address, so only a stream whose buffers are cpu memory with their address as the VA
+//can be replayed, which is how a headless frame sets them up (see BenchmarkSoftRaster). ExecuteIndirect isn't recorded, a headless
+//frame culls on the cpu. images go out as PNG in stored deflate blocks, nothing to link against, for golden image diffs
+//https://microsoft.github.io/DirectX-Specs/d3d/archive/D3D11_3_FunctionalSpec.htm#15.13%20Rasterization%20Rules
+//https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/
+
+#if AVX_ACTIVE
+#include <immintrin.h>
+#endif
+
+#define SOFT_RASTER_TILE_SIZE 64
+#define SOFT_RASTER_SUBPIXEL 256.0f //D3D's 8 bits of subpixel precision, screen positions snap to it
+#define SOFT_RASTER_GUARD_BAND 4.0f //x and y get clipped to this many w, which keeps snapped positions exact in a float up to 4096 pixel targets
+#define SOFT_RASTER_NUM_PLANES 6 //near and far (depth 0 to 1) then the guard band's left, right, bottom and top
+#define SOFT_RASTER_MAX_CLIPPED ( SOFT_RASTER_NUM_PLANES + 1 ) //triangles a clipped triangle can turn into
+#define SOFT_RASTER_VERTEX_CHUNK 1024
+#define SOFT_RASTER_SETUP_CHUNK 256 //input triangles per setup job, bins are kept in submission order by these ranges
+#define SOFT_RASTER_ATTRIBUTES 7 //VertexOutput's worldNormal then color
+#define SOFT_RASTER_SRGB_LUT_SIZE 16384 //linear to srgb 8 bit, fine enough to land within half a step of the exact conversion
+#define SOFT_RASTER_PNG_BLOCK 65535 //largest stored deflate block
+
+enum SoftRasterShader
+{
+	SOFT_RASTER_STATIC, //VertexShader.hlsl
+	SOFT_RASTER_STATIC_INSTANCED, //INSTANCED=1
+	SOFT_RASTER_STATIC_DRAW_CBV, //DRAW_DATA=1
+	SOFT_RASTER_STATIC_DRAW_INDEX, //DRAW_DATA=2
+	SOFT_RASTER_SKINNED, //VertexShaderSkinned.hlsl, both palette layouts read the same memory
+	SOFT_RASTER_SKINNED_INSTANCED,
+	SOFT_RASTER_SHADER_NONE //a pipeline RenderResources doesn't have, its draws are dropped and counted
+};
+
+//the input layouts of InitDirectX12's pipelines
+typedef struct SoftRasterStaticVertex
+{
+	f32 fPos[3];
+	f32 fNormal[3];
+	f32 fColor[4];
+} SoftRasterStaticVertex;
+
+typedef struct SoftRasterSkinnedVertex
+{
+	f32 fPos[3];
+	f32 fNormal[3];
+	u32 dwJoints[4];
+	f32 fWeights[4];
+	f32 fColor[4];
+} SoftRasterSkinnedVertex;
+
+//VertexOutput
+typedef struct SoftRasterVertex
+{
+	Vec4f vPos; //clip space
+	f32 fAttributes[SOFT_RASTER_ATTRIBUTES];
+} SoftRasterVertex;
+
+//a DrawIndexedInstanced and everything that was bound for it
+typedef struct SoftRasterDraw
+{
+	u32 dwShader; //SoftRasterShader
+	u32 dwIndexCount;
+	u32 dwInstanceCount;
+	u32 dwFirstIndex;
+	s32 iBaseVertex;
+	u32 dwFirstInstance;
+	u64 qwVertices;
+	u32 dwVertexBufferSize;
+	u32 dwVertexStride;
+	u64 qwInstances;
+	u32 dwInstanceBufferSize;
+	u32 dwInstanceStride;
+	u64 qwIndices;
+	u32 dwIndexBufferSize;
+	u32 dwIndexSize;
+	u64 qwShaderResource; //VERTEX_SB_ROOT_SLOT
+	u64 qwConstantBuffer; //VERTEX_DRAW_CBV_ROOT_SLOT
+	u32 dwVertexConstants[RENDER_VERTEX_CONSTANTS_SIZE / 4];
+	f32 fPixelConstants[4 + 3];
+	D3D12_VIEWPORT viewport;
+	s32 iRect[4]; //pixels it may touch, the viewport and scissor within the target, exclusive max
+	u32 dwMinVertex; //lowest vertex its indices reach, base vertex included
+	u32 dwNumVertices; //per instance from dwMinVertex on
+} SoftRasterDraw;
+
+//one instance of a draw
+typedef struct SoftRasterBatch
+{
+	u32 dwDraw;
+	u32 dwInstance;
+	u32 dwFirstVertex; //in the frame's shaded vertices
+	u32 dwFirstTriangle; //in the frame's input triangles
+} SoftRasterBatch;
+
+//a triangle after clipping, culling and setup, what the tiles rasterize
+typedef struct SoftRasterTriangle
+{
+	//edge k is opposite vertex k, its function is taken relative to its lower endpoint so the neighbor sharing it gets exactly the negation
+	f32 fOriginX[3];
+	f32 fOriginY[3];
+	f32 fEdgeX[3];
+	f32 fEdgeY[3];
+	f32 fInvArea;
+	f32 fZ[3]; //viewport depth
+	f32 fInvW[3];
+	f32 fAttributes[3][SOFT_RASTER_ATTRIBUTES]; //over w
+	s32 iRect[4]; //pixels it may touch, exclusive max
+	u32 dwTopLeft; //a bit per edge that owns the pixel centers exactly on it
+	u32 dwDraw;
+} SoftRasterTriangle;
+
+typedef struct SoftRasterStats
+{
+	u32 dwNumDraws; //DrawIndexedInstanced calls replayed
+	u32 dwNumInstances;
+	u32 dwNumDropped; //draws of a pipeline RenderResources doesn't have
+	u32 dwNumVertices; //vertex shader invocations
+	u32 dwNumTriangles; //input triangles
+	u32 dwNumClipped; //ones that needed the clipper
+	u32 dwNumSetup; //what went to the tiles after clipping and culling
+	u32 dwNumBinned; //triangle and tile pairs
+	u64 qwNumCovered; //pixel centers inside a triangle
+	u64 qwNumPixels; //pixel shader invocations, what passed the depth test
+	u64 qwVertexTicks; //QueryPerformanceCounter per pass
+	u64 qwSetupTicks;
+	u64 qwRasterTicks;
+} SoftRasterStats;
+
+typedef struct SoftRasterTarget
+{
+	u32 *pColor; //RGBA8 with red in the low byte, srgb like the eye swap chains
+	f32 *pDepth;
+	u32 dwWidth;
+	u32 dwHeight;
+} SoftRasterTarget;
+
+typedef struct SoftRaster
+{
+	WorkerPool *pPool;
+	u32 dwPaletteBones; //matrices from one palette to the next in the bone buffer, skinShaders.dwBones in the app
+	SoftRasterStats stats; //of the last SoftRasterExecute
+	SoftRasterTarget *pTarget; //of the frame being rendered
+
+	//scratch, grown as needed and kept for the next frame
+	SoftRasterDraw *pDraws;
+	SoftRasterBatch *pBatches;
+	SoftRasterVertex *pVertices;
+	SoftRasterTriangle *pTriangles;
+	u32 *pChunkTriangles; //setup triangles per setup chunk, then where each chunk's start
+	u32 *pBinCounts; //per setup chunk and tile, then where the chunk's part of the tile's bin starts
+	u32 *pBins; //setup triangles by tile, in submission order within each
+	u32 *pTileStarts; //where each tile's bin starts, one past the last for the end
+	u64 *pTileCounts; //covered then shaded pixels per tile
+	u32 dwDrawCapacity;
+	u32 dwBatchCapacity;
+	u32 dwVertexCapacity;
+	u32 dwTriangleCapacity;
+	u32 dwChunkCapacity;
+	u32 dwBinCountCapacity;
+	u32 dwBinCapacity;
+	u32 dwTileCapacity;
+	u32 dwTileCountCapacity;
+	u32 dwNumDraws;
+	u32 dwNumBatches;
+	u32 dwNumChunks;
+	u32 dwTilesX;
+	u32 dwTilesY;
+} SoftRaster;
+
+u8 softRasterSrgb[SOFT_RASTER_SRGB_LUT_SIZE + 3]; //the AVX path gathers 4 bytes at a time
+u32 softRasterCrcTable[256];
+
+inline
+void InitSoftRaster( SoftRaster *a_pRaster, WorkerPool *a_pPool, u32 dwPaletteBones )
+{
+	memset( a_pRaster, 0, sizeof( SoftRaster ) );
+	a_pRaster->pPool = a_pPool;
+	a_pRaster->dwPaletteBones = dwPaletteBones;
+	for( u32 dwEntry = 0; dwEntry < SOFT_RASTER_SRGB_LUT_SIZE; ++dwEntry )
+	{
+		f32 fLinear = (f32)dwEntry / (f32)( SOFT_RASTER_SRGB_LUT_SIZE - 1 );
+		f32 fSrgb = fLinear <= 0.0031308f ? fLinear * 12.92f : ( 1.055f * powf( fLinear, 1.0f / 2.4f ) ) - 0.055f;
+		softRasterSrgb[dwEntry] = (u8)( ( fSrgb * 255.0f ) + 0.5f );
+	}
+	for( u32 dwByte = 0; dwByte < 256; ++dwByte )
+	{
+		u32 dwCrc = dwByte;
+		for( u32 dwBit = 0; dwBit < 8; ++dwBit )
+		{
+			dwCrc = ( dwCrc & 1 ) ? 0xEDB88320 ^ ( dwCrc >> 1 ) : dwCrc >> 1;
+		}
+		softRasterCrcTable[dwByte] = dwCrc;
+	}
+}
+
+inline
+void DestroySoftRaster( SoftRaster *a_pRaster )
+{
+	free( a_pRaster->pDraws );
+	free( a_pRaster->pBatches );
+	free( a_pRaster->pVertices );
+	free( a_pRaster->pTriangles );
+	free( a_pRaster->pChunkTriangles );
+	free( a_pRaster->pBinCounts );
+	free( a_pRaster->pBins );
+	free( a_pRaster->pTileStarts );
+	free( a_pRaster->pTileCounts );
+	memset( a_pRaster, 0, sizeof( SoftRaster ) );
+}
+
+inline
+bool SoftRasterReserve( void **a_ppArray, u32 *a_pCapacity, u32 dwCount, u32 dwElementSize )
+{
+	if( dwCount <= *a_pCapacity )
+	{
+		return true;
+	}
+	u32 dwCapacity = dwCount + ( dwCount >> 1 );
+	void *pArray = realloc( *a_ppArray, (size_t)dwCapacity * dwElementSize );
+	if( !pArray )
+	{
+		return false;
+	}
+	*a_ppArray = pArray;
+	*a_pCapacity = dwCapacity;
+	return true;
+}
+
+//the srgb target's write of a linear color, already saturated
+inline
+u32 SoftRasterEncodeColor( f32 fRed, f32 fGreen, f32 fBlue, f32 fAlpha )
+{
+	const f32 fScale = (f32)( SOFT_RASTER_SRGB_LUT_SIZE - 1 );
+	return (u32)softRasterSrgb[(u32)( ( fRed * fScale ) + 0.5f )] | ( (u32)softRasterSrgb[(u32)( ( fGreen * fScale ) + 0.5f )] << 8 ) |
+		( (u32)softRasterSrgb[(u32)( ( fBlue * fScale ) + 0.5f )] << 16 ) | ( (u32)( ( fAlpha * 255.0f ) + 0.5f ) << 24 );
+}
+
+//the whole target, RenderFrame clears the scaled scissor rect which a headless target is sized to
+inline
+void SoftRasterClear( SoftRasterTarget *a_pTarget, const f32 *a_pColor, f32 fDepth )
+{
+	u32 dwColor = SoftRasterEncodeColor( a_pColor[0], a_pColor[1], a_pColor[2], a_pColor[3] );
+	u32 dwNumPixels = a_pTarget->dwWidth * a_pTarget->dwHeight;
+	for( u32 dwPixel = 0; dwPixel < dwNumPixels; ++dwPixel )
+	{
+		a_pTarget->pColor[dwPixel] = dwColor;
+		a_pTarget->pDepth[dwPixel] = fDepth;
+	}
+}
+
+//which shader a recorded pipeline runs, by which of the resources' pipelines it is
+inline
+u32 SoftRasterShaderOf( RenderResources *a_pResources, u64 qwPipeline )
+{
+	if( qwPipeline == (u64)a_pResources->pDrawDataPipelines[RENDER_DRAW_DATA_ROOT_CBV] )
+	{
+		return SOFT_RASTER_STATIC_DRAW_CBV;
+	}
+	if( qwPipeline == (u64)a_pResources->pDrawDataPipelines[RENDER_DRAW_DATA_INDEX] )
+	{
+		return SOFT_RASTER_STATIC_DRAW_INDEX;
+	}
+	const u32 dwShaders[RENDER_PIPELINE_COUNT] = { SOFT_RASTER_STATIC, SOFT_RASTER_STATIC_INSTANCED, SOFT_RASTER_SKINNED, SOFT_RASTER_SKINNED_INSTANCED };
+	for( u32 dwPipeline = 0; dwPipeline < RENDER_PIPELINE_COUNT; ++dwPipeline )
+	{
+		if( qwPipeline == (u64)a_pResources->pPipelines[dwPipeline] )
+		{
+			return dwShaders[dwPipeline];
+		}
+	}
+	return SOFT_RASTER_SHADER_NONE;
+}
+
+//dwSize bytes at dwOffset into a buffer, what lies past its end reads as 0 like an out of bounds fetch
+inline
+void SoftRasterFetch( u64 qwAddress, u64 qwOffset, u32 dwBufferSize, void *a_pOut, u32 dwSize )
+{
+	if( qwOffset + dwSize > dwBufferSize )
+	{
+		memset( a_pOut, 0, dwSize );
+		return;
+	}
+	memcpy( a_pOut, (const u8*)qwAddress + qwOffset, dwSize );
+}
+
+//the vertex dwIndex of the draw's indices refers to, base vertex included
+inline
+u32 SoftRasterIndex( SoftRasterDraw *a_pDraw, u32 dwIndex )
+{
+	u32 dwValue = 0;
+	SoftRasterFetch( a_pDraw->qwIndices, (u64)( a_pDraw->dwFirstIndex + dwIndex ) * a_pDraw->dwIndexSize, a_pDraw->dwIndexBufferSize, &dwValue, a_pDraw->dwIndexSize );
+	return dwValue + (u32)a_pDraw->iBaseVertex;
+}
+
+//a row vector times one of the cpu side's row major matrices, what the shaders' mul( matrix, vector ) does with them
+inline
+void SoftRasterMul( const f32 *a_pVector, const f32 *a_pMatrix, f32 *a_pOut )
+{
+	for( u32 dwColumn = 0; dwColumn < 4; ++dwColumn )
+	{
+		a_pOut[dwColumn] = ( a_pVector[0] * a_pMatrix[dwColumn] ) + ( a_pVector[1] * a_pMatrix[4 + dwColumn] ) +
+			( a_pVector[2] * a_pMatrix[8 + dwColumn] ) + ( a_pVector[3] * a_pMatrix[12 + dwColumn] );
+	}
+}
+
+//a 3 vector times 3 rows dwStride floats apart
+inline
+void SoftRasterMulRows3( const f32 *a_pVector, const f32 *a_pRows, u32 dwStride, f32 *a_pOut )
+{
+	for( u32 dwColumn = 0; dwColumn < 3; ++dwColumn )
+	{
+		a_pOut[dwColumn] = ( a_pVector[0] * a_pRows[dwColumn] ) + ( a_pVector[1] * a_pRows[dwStride + dwColumn] ) +
+			( a_pVector[2] * a_pRows[( 2 * dwStride ) + dwColumn] );
+	}
+}
+
+//the vertex shader for vertices [dwBegin, dwEnd) of a batch, counted from the draw's dwMinVertex
+inline
+void SoftRasterShadeVertices( SoftRaster *a_pRaster, SoftRasterBatch *a_pBatch, u32 dwBegin, u32 dwEnd )
+{
+	SoftRasterDraw *pDraw = &a_pRaster->pDraws[a_pBatch->dwDraw];
+	const f32 *pViewProj = (const f32*)pDraw->dwVertexConstants; //mvpMat, all but the plain static shader only have the view projection in it
+	const f32 *pNormalMat = (const f32*)pDraw->dwVertexConstants + 16; //nMat, rows of 4 with the last row's padding cut off
+	u32 dwShader = pDraw->dwShader;
+
+	//what is the same for every vertex of the instance
+	RenderInstance instance;
+	memset( &instance, 0, sizeof( RenderInstance ) );
+	if( dwShader == SOFT_RASTER_STATIC_INSTANCED || dwShader == SOFT_RASTER_SKINNED_INSTANCED )
+	{
+		u32 dwSize = pDraw->dwInstanceStride < sizeof( RenderInstance ) ? pDraw->dwInstanceStride : sizeof( RenderInstance );
+		SoftRasterFetch( pDraw->qwInstances, (u64)( pDraw->dwFirstInstance + a_pBatch->dwInstance ) * pDraw->dwInstanceStride, pDraw->dwInstanceBufferSize, &instance, dwSize );
+	}
+	RenderDrawData drawData;
+	f32 fDrawNormal[9];
+	if( dwShader == SOFT_RASTER_STATIC_DRAW_CBV || dwShader == SOFT_RASTER_STATIC_DRAW_INDEX )
+	{
+		//root views have no size, the address is trusted like the gpu would
+		u64 qwDrawData = dwShader == SOFT_RASTER_STATIC_DRAW_CBV ? pDraw->qwConstantBuffer :
+			pDraw->qwShaderResource + ( (u64)pDraw->dwVertexConstants[RENDER_DRAW_INDEX_OFFSET] * sizeof( RenderDrawData ) );
+		memcpy( &drawData, (const void*)qwDrawData, sizeof( RenderDrawData ) );
+		for( u32 dwElement = 0; dwElement < 9; ++dwElement )
+		{
+			fDrawNormal[dwElement] = F16ToF32( (u16)( drawData.dwNormalHalves[dwElement >> 1] >> ( ( dwElement & 1 ) * 16 ) ) );
+		}
+	}
+	const Mat4f *pPalette = (const Mat4f*)( pDraw->qwShaderResource +
+		( dwShader == SOFT_RASTER_SKINNED_INSTANCED ? (u64)instance.dwPalette * a_pRaster->dwPaletteBones * sizeof( Mat4f ) : 0 ) );
+
+	for( u32 dwVertex = dwBegin; dwVertex < dwEnd; ++dwVertex )
+	{
+		SoftRasterVertex *pOut = &a_pRaster->pVertices[a_pBatch->dwFirstVertex + dwVertex];
+		u64 qwOffset = (u64)( pDraw->dwMinVertex + dwVertex ) * pDraw->dwVertexStride;
+		f32 fWorld[4];
+		f32 *pNormal = pOut->fAttributes;
+		f32 *pColor = pOut->fAttributes + 3;
+		if( dwShader == SOFT_RASTER_SKINNED || dwShader == SOFT_RASTER_SKINNED_INSTANCED )
+		{
+			SoftRasterSkinnedVertex vertex;
+			SoftRasterFetch( pDraw->qwVertices, qwOffset, pDraw->dwVertexBufferSize, &vertex, sizeof( SoftRasterSkinnedVertex ) );
+			//the palettes have the model matrix baked in, so this lands in world space
+			f32 fPos[4] = { vertex.fPos[0], vertex.fPos[1], vertex.fPos[2], 1.0f };
+			memset( fWorld, 0, sizeof( fWorld ) );
+			memset( pNormal, 0, 3 * sizeof( f32 ) );
+			for( u32 dwInfluence = 0; dwInfluence < 4; ++dwInfluence )
+			{
+				u32 dwJoint = vertex.dwJoints[dwInfluence];
+				if( dwJoint >= a_pRaster->dwPaletteBones )
+				{
+					continue; //past the palette, reads as a zero matrix
+				}
+				const f32 *pBone = &pPalette[dwJoint].m[0][0];
+				f32 fSkinned[4];
+				f32 fSkinnedNormal[3];
+				SoftRasterMul( fPos, pBone, fSkinned );
+				SoftRasterMulRows3( vertex.fNormal, pBone, 4, fSkinnedNormal );
+				f32 fWeight = vertex.fWeights[dwInfluence];
+				for( u32 dwAxis = 0; dwAxis < 4; ++dwAxis )
+				{
+					fWorld[dwAxis] += fSkinned[dwAxis] * fWeight;
+				}
+				for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+				{
+					pNormal[dwAxis] += fSkinnedNormal[dwAxis] * fWeight;
+				}
+			}
+			SoftRasterMul( fWorld, pViewProj, pOut->vPos.v );
+			memcpy( pColor, vertex.fColor, 4 * sizeof( f32 ) );
+			continue;
+		}
+
+		SoftRasterStaticVertex vertex;
+		SoftRasterFetch( pDraw->qwVertices, qwOffset, pDraw->dwVertexBufferSize, &vertex, sizeof( SoftRasterStaticVertex ) );
+		f32 fPos[4] = { vertex.fPos[0], vertex.fPos[1], vertex.fPos[2], 1.0f };
+		if( dwShader == SOFT_RASTER_STATIC_INSTANCED )
+		{
+			SoftRasterMul( fPos, &instance.mWorld.m[0][0], fWorld );
+			SoftRasterMul( fWorld, pViewProj, pOut->vPos.v );
+			SoftRasterMulRows3( vertex.fNormal, &instance.mNormal.m[0][0], 4, pNormal );
+		}
+		else if( dwShader == SOFT_RASTER_STATIC )
+		{
+			SoftRasterMul( fPos, pViewProj, pOut->vPos.v );
+			SoftRasterMulRows3( vertex.fNormal, pNormalMat, 4, pNormal );
+		}
+		else
+		{
+			for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+			{
+				Vec4f *pColumn = &drawData.vWorldColumns[dwAxis];
+				fWorld[dwAxis] = ( pColumn->x * fPos[0] ) + ( pColumn->y * fPos[1] ) + ( pColumn->z * fPos[2] ) + pColumn->w;
+			}
+			fWorld[3] = 1.0f;
+			SoftRasterMul( fWorld, pViewProj, pOut->vPos.v );
+			SoftRasterMulRows3( vertex.fNormal, fDrawNormal, 3, pNormal );
+		}
+		memcpy( pColor, vertex.fColor, 4 * sizeof( f32 ) );
+	}
+}
+
+//last batch starting at or before a vertex or triangle, the batches are in order of both
+inline
+u32 SoftRasterFindBatch( SoftRaster *a_pRaster, u32 dwItem, bool bTriangles )
+{
+	u32 dwLow = 0;
+	u32 dwHigh = a_pRaster->dwNumBatches;
+	while( dwHigh - dwLow > 1 )
+	{
+		u32 dwMid = ( dwLow + dwHigh ) >> 1;
+		u32 dwFirst = bTriangles ? a_pRaster->pBatches[dwMid].dwFirstTriangle : a_pRaster->pBatches[dwMid].dwFirstVertex;
+		if( dwFirst <= dwItem )
+		{
+			dwLow = dwMid;
+		}
+		else
+		{
+			dwHigh = dwMid;
+		}
+	}
+	return dwLow;
+}
+
+void SoftRasterVertexRange( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	SoftRaster *pRaster = (SoftRaster*)pContext;
+	for( u32 dwBatch = SoftRasterFindBatch( pRaster, dwBegin, false ); dwBegin < dwEnd; ++dwBatch )
+	{
+		SoftRasterBatch *pBatch = &pRaster->pBatches[dwBatch];
+		u32 dwBatchEnd = pBatch->dwFirstVertex + pRaster->pDraws[pBatch->dwDraw].dwNumVertices;
+		u32 dwRangeEnd = dwBatchEnd < dwEnd ? dwBatchEnd : dwEnd;
+		SoftRasterShadeVertices( pRaster, pBatch, dwBegin - pBatch->dwFirstVertex, dwRangeEnd - pBatch->dwFirstVertex );
+		dwBegin = dwRangeEnd;
+	}
+}
+
+//inside is >= 0
+inline
+f32 SoftRasterPlaneDistance( Vec4f *a_pPos, u32 dwPlane )
+{
+	switch( dwPlane )
+	{
+		case 0: return a_pPos->z;
+		case 1: return a_pPos->w - a_pPos->z;
+		case 2: return ( SOFT_RASTER_GUARD_BAND * a_pPos->w ) + a_pPos->x;
+		case 3: return ( SOFT_RASTER_GUARD_BAND * a_pPos->w ) - a_pPos->x;
+		case 4: return ( SOFT_RASTER_GUARD_BAND * a_pPos->w ) + a_pPos->y;
+		default: return ( SOFT_RASTER_GUARD_BAND * a_pPos->w ) - a_pPos->y;
+	}
+}
+
+//bits 0-5 for the planes a vertex is outside of, 8-11 for the sides of the frustum itself, which only reject
+inline
+u32 SoftRasterOutcode( Vec4f *a_pPos )
+{
+	u32 dwCode = 0;
+	for( u32 dwPlane = 0; dwPlane < SOFT_RASTER_NUM_PLANES; ++dwPlane )
+	{
+		dwCode |= SoftRasterPlaneDistance( a_pPos, dwPlane ) < 0.0f ? 1u << dwPlane : 0;
+	}
+	dwCode |= a_pPos->x < -a_pPos->w ? 0x100 : 0;
+	dwCode |= a_pPos->x > a_pPos->w ? 0x200 : 0;
+	dwCode |= a_pPos->y < -a_pPos->w ? 0x400 : 0;
+	dwCode |= a_pPos->y > a_pPos->w ? 0x800 : 0;
+	return dwCode;
+}
+
+//Sutherland Hodgman against one plane, an edge crossing it is always cut from its inside end so neighbors get the same point
+inline
+u32 SoftRasterClipPlane( SoftRasterVertex *a_pIn, u32 dwCount, SoftRasterVertex *a_pOut, u32 dwPlane )
+{
+	u32 dwOut = 0;
+	for( u32 dwVertex = 0; dwVertex < dwCount; ++dwVertex )
+	{
+		SoftRasterVertex *pA = &a_pIn[dwVertex];
+		SoftRasterVertex *pB = &a_pIn[( dwVertex + 1 ) % dwCount];
+		f32 fA = SoftRasterPlaneDistance( &pA->vPos, dwPlane );
+		f32 fB = SoftRasterPlaneDistance( &pB->vPos, dwPlane );
+		if( fA >= 0.0f )
+		{
+			a_pOut[dwOut++] = *pA;
+		}
+		if( ( fA >= 0.0f ) != ( fB >= 0.0f ) )
+		{
+			SoftRasterVertex *pInside = fA >= 0.0f ? pA : pB;
+			SoftRasterVertex *pOutside = fA >= 0.0f ? pB : pA;
+			f32 fInside = fA >= 0.0f ? fA : fB;
+			f32 fT = fInside / ( fInside - ( fA >= 0.0f ? fB : fA ) );
+			const f32 *pFrom = pInside->vPos.v;
+			const f32 *pTo = pOutside->vPos.v;
+			f32 *pCut = a_pOut[dwOut++].vPos.v;
+			//vPos and the attributes are contiguous
+			for( u32 dwValue = 0; dwValue < 4 + SOFT_RASTER_ATTRIBUTES; ++dwValue )
+			{
+				pCut[dwValue] = pFrom[dwValue] + ( fT * ( pTo[dwValue] - pFrom[dwValue] ) );
+			}
+		}
+	}
+	return dwOut;
+}
+
+inline
+f32 SoftRasterSnap( f32 fValue )
+{
+	return floorf( ( fValue * SOFT_RASTER_SUBPIXEL ) + 0.5f ) / SOFT_RASTER_SUBPIXEL;
+}
+
+//viewport transform, snapping, culling and the edge functions of one clipped triangle, false when nothing of it is left to draw
+inline
+bool SoftRasterSetupTriangle( SoftRasterDraw *a_pDraw, u32 dwDraw, SoftRasterVertex **a_ppVertices, SoftRasterTriangle *a_pTri )
+{
+	D3D12_VIEWPORT *pViewport = &a_pDraw->viewport;
+	f32 fX[3];
+	f32 fY[3];
+	for( u32 dwVertex = 0; dwVertex < 3; ++dwVertex )
+	{
+		Vec4f *pPos = &a_ppVertices[dwVertex]->vPos;
+		if( pPos->w <= 0.0f )
+		{
+			return false; //only the eye point itself survives the clip planes with this
+		}
+		f32 fInvW = 1.0f / pPos->w;
+		fX[dwVertex] = SoftRasterSnap( pViewport->TopLeftX + ( ( ( pPos->x * fInvW ) + 1.0f ) * 0.5f * pViewport->Width ) );
+		fY[dwVertex] = SoftRasterSnap( pViewport->TopLeftY + ( ( 1.0f - ( pPos->y * fInvW ) ) * 0.5f * pViewport->Height ) );
+		a_pTri->fZ[dwVertex] = pViewport->MinDepth + ( pPos->z * fInvW * ( pViewport->MaxDepth - pViewport->MinDepth ) );
+		a_pTri->fInvW[dwVertex] = fInvW;
+		for( u32 dwAttribute = 0; dwAttribute < SOFT_RASTER_ATTRIBUTES; ++dwAttribute )
+		{
+			a_pTri->fAttributes[dwVertex][dwAttribute] = a_ppVertices[dwVertex]->fAttributes[dwAttribute] * fInvW;
+		}
+	}
+	//y points down, so clockwise (the front face) is a positive area. doubles keep it exact for snapped positions
+	f64 fArea = ( (f64)( fX[1] - fX[0] ) * (f64)( fY[2] - fY[0] ) ) - ( (f64)( fX[2] - fX[0] ) * (f64)( fY[1] - fY[0] ) );
+	if( fArea <= 0.0 )
+	{
+		return false;
+	}
+	f32 fMinX = fX[0] < fX[1] ? ( fX[0] < fX[2] ? fX[0] : fX[2] ) : ( fX[1] < fX[2] ? fX[1] : fX[2] );
+	f32 fMaxX = fX[0] > fX[1] ? ( fX[0] > fX[2] ? fX[0] : fX[2] ) : ( fX[1] > fX[2] ? fX[1] : fX[2] );
+	f32 fMinY = fY[0] < fY[1] ? ( fY[0] < fY[2] ? fY[0] : fY[2] ) : ( fY[1] < fY[2] ? fY[1] : fY[2] );
+	f32 fMaxY = fY[0] > fY[1] ? ( fY[0] > fY[2] ? fY[0] : fY[2] ) : ( fY[1] > fY[2] ? fY[1] : fY[2] );
+	//pixels whose centers can be inside
+	s32 iMinX = (s32)ceilf( fMinX - 0.5f );
+	s32 iMinY = (s32)ceilf( fMinY - 0.5f );
+	s32 iMaxX = (s32)floorf( fMaxX - 0.5f ) + 1;
+	s32 iMaxY = (s32)floorf( fMaxY - 0.5f ) + 1;
+	a_pTri->iRect[0] = iMinX > a_pDraw->iRect[0] ? iMinX : a_pDraw->iRect[0];
+	a_pTri->iRect[1] = iMinY > a_pDraw->iRect[1] ? iMinY : a_pDraw->iRect[1];
+	a_pTri->iRect[2] = iMaxX < a_pDraw->iRect[2] ? iMaxX : a_pDraw->iRect[2];
+	a_pTri->iRect[3] = iMaxY < a_pDraw->iRect[3] ? iMaxY : a_pDraw->iRect[3];
+	if( a_pTri->iRect[0] >= a_pTri->iRect[2] || a_pTri->iRect[1] >= a_pTri->iRect[3] )
+	{
+		return false;
+	}
+	a_pTri->dwTopLeft = 0;
+	for( u32 dwEdge = 0; dwEdge < 3; ++dwEdge )
+	{
+		u32 dwA = dwEdge == 2 ? 0 : dwEdge + 1;
+		u32 dwB = dwA == 2 ? 0 : dwA + 1;
+		bool bALower = fY[dwA] < fY[dwB] || ( fY[dwA] == fY[dwB] && fX[dwA] < fX[dwB] );
+		a_pTri->fOriginX[dwEdge] = bALower ? fX[dwA] : fX[dwB];
+		a_pTri->fOriginY[dwEdge] = bALower ? fY[dwA] : fY[dwB];
+		a_pTri->fEdgeX[dwEdge] = fX[dwB] - fX[dwA];
+		a_pTri->fEdgeY[dwEdge] = fY[dwB] - fY[dwA];
+		//going clockwise with y down, left edges go up and the top edge goes right
+		bool bTopLeft = a_pTri->fEdgeY[dwEdge] < 0.0f || ( a_pTri->fEdgeY[dwEdge] == 0.0f && a_pTri->fEdgeX[dwEdge] > 0.0f );
+		a_pTri->dwTopLeft |= bTopLeft ? 1u << dwEdge : 0;
+	}
+	a_pTri->fInvArea = (f32)( 1.0 / fArea );
+	a_pTri->dwDraw = dwDraw;
+	return true;
+}
+
+//clips and sets up input triangle dwTriangle of a batch, writing what survives to a_pOut when it isn't null. returns how many
+inline
+u32 SoftRasterTriangleSetup( SoftRaster *a_pRaster, SoftRasterBatch *a_pBatch, u32 dwTriangle, SoftRasterTriangle *a_pOut, u32 *a_pNumClipped )
+{
+	SoftRasterDraw *pDraw = &a_pRaster->pDraws[a_pBatch->dwDraw];
+	SoftRasterVertex *pVertices[3];
+	u32 dwAnd = 0xffffffff;
+	u32 dwOr = 0;
+	for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+	{
+		u32 dwVertex = SoftRasterIndex( pDraw, ( dwTriangle * 3 ) + dwCorner ) - pDraw->dwMinVertex;
+		pVertices[dwCorner] = &a_pRaster->pVertices[a_pBatch->dwFirstVertex + dwVertex];
+		u32 dwCode = SoftRasterOutcode( &pVertices[dwCorner]->vPos );
+		dwAnd &= dwCode;
+		dwOr |= dwCode;
+	}
+	//all outside the same side of the frustum or a clip plane
+	if( dwAnd & ( 0xf00 | 0x3 ) )
+	{
+		return 0;
+	}
+	SoftRasterTriangle triangle;
+	SoftRasterTriangle *pTri = a_pOut ? a_pOut : &triangle;
+	if( !( dwOr & 0x3f ) )
+	{
+		return SoftRasterSetupTriangle( pDraw, a_pBatch->dwDraw, pVertices, pTri ) ? 1 : 0;
+	}
+	++*a_pNumClipped;
+	SoftRasterVertex polygons[2][3 + SOFT_RASTER_NUM_PLANES];
+	u32 dwCount = 3;
+	for( u32 dwCorner = 0; dwCorner < 3; ++dwCorner )
+	{
+		polygons[0][dwCorner] = *pVertices[dwCorner];
+	}
+	u32 dwCurrent = 0;
+	for( u32 dwPlane = 0; dwPlane < SOFT_RASTER_NUM_PLANES && dwCount >= 3; ++dwPlane )
+	{
+		if( dwOr & ( 1u << dwPlane ) )
+		{
+			dwCount = SoftRasterClipPlane( polygons[dwCurrent], dwCount, polygons[dwCurrent ^ 1], dwPlane );
+			dwCurrent ^= 1;
+		}
+	}
+	u32 dwNumSetup = 0;
+	for( u32 dwFan = 2; dwFan < dwCount; ++dwFan )
+	{
+		SoftRasterVertex *pFan[3] = { &polygons[dwCurrent][0], &polygons[dwCurrent][dwFan - 1], &polygons[dwCurrent][dwFan] };
+		if( SoftRasterSetupTriangle( pDraw, a_pBatch->dwDraw, pFan, a_pOut ? &a_pOut[dwNumSetup] : &triangle ) )
+		{
+			++dwNumSetup;
+		}
+	}
+	return dwNumSetup;
+}
+
+//runs the setup of one chunk of input triangles, counting (a_pOut null) or writing
+inline
+u32 SoftRasterSetupChunk( SoftRaster *a_pRaster, u32 dwChunk, SoftRasterTriangle *a_pOut, u32 *a_pNumClipped )
+{
+	u32 dwBegin = dwChunk * SOFT_RASTER_SETUP_CHUNK;
+	u32 dwEnd = dwBegin + SOFT_RASTER_SETUP_CHUNK;
+	u32 dwNumSetup = 0;
+	for( u32 dwBatch = SoftRasterFindBatch( a_pRaster, dwBegin, true ); dwBatch < a_pRaster->dwNumBatches; ++dwBatch )
+	{
+		SoftRasterBatch *pBatch = &a_pRaster->pBatches[dwBatch];
+		if( pBatch->dwFirstTriangle >= dwEnd )
+		{
+			break;
+		}
+		u32 dwBatchEnd = pBatch->dwFirstTriangle + ( a_pRaster->pDraws[pBatch->dwDraw].dwIndexCount / 3 );
+		u32 dwFirst = dwBegin > pBatch->dwFirstTriangle ? dwBegin : pBatch->dwFirstTriangle;
+		u32 dwLast = dwBatchEnd < dwEnd ? dwBatchEnd : dwEnd;
+		for( u32 dwTriangle = dwFirst; dwTriangle < dwLast; ++dwTriangle )
+		{
+			dwNumSetup += SoftRasterTriangleSetup( a_pRaster, pBatch, dwTriangle - pBatch->dwFirstTriangle, a_pOut ? a_pOut + dwNumSetup : nullptr, a_pNumClipped );
+		}
+	}
+	return dwNumSetup;
+}
+
+void SoftRasterCountRange( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	SoftRaster *pRaster = (SoftRaster*)pContext;
+	for( u32 dwChunk = dwBegin; dwChunk < dwEnd; ++dwChunk )
+	{
+		u32 dwNumClipped = 0;
+		pRaster->pChunkTriangles[dwChunk] = SoftRasterSetupChunk( pRaster, dwChunk, nullptr, &dwNumClipped );
+	}
+}
+
+//writes the chunk's triangles and counts what each tile gets from it
+void SoftRasterSetupRange( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	SoftRaster *pRaster = (SoftRaster*)pContext;
+	u32 dwNumTiles = pRaster->dwTilesX * pRaster->dwTilesY;
+	for( u32 dwChunk = dwBegin; dwChunk < dwEnd; ++dwChunk )
+	{
+		u32 dwNumClipped = 0;
+		u32 dwFirst = pRaster->pChunkTriangles[dwChunk];
+		u32 dwNumSetup = SoftRasterSetupChunk( pRaster, dwChunk, pRaster->pTriangles + dwFirst, &dwNumClipped );
+		u32 *pCounts = pRaster->pBinCounts + ( (u64)dwChunk * dwNumTiles );
+		memset( pCounts, 0, dwNumTiles * sizeof( u32 ) );
+		for( u32 dwTri = dwFirst; dwTri < dwFirst + dwNumSetup; ++dwTri )
+		{
+			s32 *pRect = pRaster->pTriangles[dwTri].iRect;
+			for( s32 iTileY = pRect[1] / SOFT_RASTER_TILE_SIZE; iTileY <= ( pRect[3] - 1 ) / SOFT_RASTER_TILE_SIZE; ++iTileY )
+			{
+				for( s32 iTileX = pRect[0] / SOFT_RASTER_TILE_SIZE; iTileX <= ( pRect[2] - 1 ) / SOFT_RASTER_TILE_SIZE; ++iTileX )
+				{
+					++pCounts[( (u32)iTileY * pRaster->dwTilesX ) + (u32)iTileX];
+				}
+			}
+		}
+		//the clipped count rides along in the spare chunk slot the prefix sum left, see SoftRasterExecute
+		pRaster->pChunkTriangles[pRaster->dwNumChunks + 1 + dwChunk] = dwNumClipped;
+	}
+}
+
+void SoftRasterBinRange( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	SoftRaster *pRaster = (SoftRaster*)pContext;
+	u32 dwNumTiles = pRaster->dwTilesX * pRaster->dwTilesY;
+	for( u32 dwChunk = dwBegin; dwChunk < dwEnd; ++dwChunk )
+	{
+		u32 *pNext = pRaster->pBinCounts + ( (u64)dwChunk * dwNumTiles );
+		for( u32 dwTri = pRaster->pChunkTriangles[dwChunk]; dwTri < pRaster->pChunkTriangles[dwChunk + 1]; ++dwTri )
+		{
+			s32 *pRect = pRaster->pTriangles[dwTri].iRect;
+			for( s32 iTileY = pRect[1] / SOFT_RASTER_TILE_SIZE; iTileY <= ( pRect[3] - 1 ) / SOFT_RASTER_TILE_SIZE; ++iTileY )
+			{
+				for( s32 iTileX = pRect[0] / SOFT_RASTER_TILE_SIZE; iTileX <= ( pRect[2] - 1 ) / SOFT_RASTER_TILE_SIZE; ++iTileX )
+				{
+					pRaster->pBins[pNext[( (u32)iTileY * pRaster->dwTilesX ) + (u32)iTileX]++] = dwTri;
+				}
+			}
+		}
+	}
+}
+
+//one triangle over pixels [iX0, iX1) x [iY0, iY1) of the target, returns covered pixels in the low 32 bits and shaded ones in the high.
+//the edge functions are taken in doubles, where snapped positions make them exact, then go to floats which keep their sign and zeros
+inline
+u64 SoftRasterRasterize( SoftRaster *a_pRaster, SoftRasterTriangle *a_pTri, s32 iX0, s32 iY0, s32 iX1, s32 iY1 )
+{
+	SoftRasterTarget *pTarget = a_pRaster->pTarget;
+	SoftRasterDraw *pDraw = &a_pRaster->pDraws[a_pTri->dwDraw];
+	const f32 *pLight = pDraw->fPixelConstants; //vLightColor then vInvLightDir
+	f32 fMinDepth = pDraw->viewport.MinDepth < pDraw->viewport.MaxDepth ? pDraw->viewport.MinDepth : pDraw->viewport.MaxDepth;
+	f32 fMaxDepth = pDraw->viewport.MinDepth < pDraw->viewport.MaxDepth ? pDraw->viewport.MaxDepth : pDraw->viewport.MinDepth;
+	u32 dwCovered = 0;
+	u32 dwShaded = 0;
+#if AVX_ACTIVE
+	const f32 fLutScale = (f32)( SOFT_RASTER_SRGB_LUT_SIZE - 1 );
+	__m256 vZero = _mm256_setzero_ps();
+	__m256 vOne = _mm256_set1_ps( 1.0f );
+	__m256 vHalf = _mm256_set1_ps( 0.5f );
+	__m256d vLanesLow = _mm256_setr_pd( 0.5, 1.5, 2.5, 3.5 );
+	__m256d vLanesHigh = _mm256_setr_pd( 4.5, 5.5, 6.5, 7.5 );
+	__m256i vLaneIndices = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	__m256d vEdgeY[3];
+	__m256d vOriginX[3];
+	__m256 vTopLeft[3];
+	for( u32 dwEdge = 0; dwEdge < 3; ++dwEdge )
+	{
+		vEdgeY[dwEdge] = _mm256_set1_pd( a_pTri->fEdgeY[dwEdge] );
+		vOriginX[dwEdge] = _mm256_set1_pd( a_pTri->fOriginX[dwEdge] );
+		vTopLeft[dwEdge] = _mm256_castsi256_ps( _mm256_set1_epi32( ( a_pTri->dwTopLeft >> dwEdge ) & 1 ? -1 : 0 ) );
+	}
+	__m256 vInvArea = _mm256_set1_ps( a_pTri->fInvArea );
+	__m256 vMinDepth = _mm256_set1_ps( fMinDepth );
+	__m256 vMaxDepth = _mm256_set1_ps( fMaxDepth );
+	for( s32 iY = iY0; iY < iY1; ++iY )
+	{
+		f64 fPixelY = (f64)iY + 0.5;
+		__m256d vRow[3];
+		for( u32 dwEdge = 0; dwEdge < 3; ++dwEdge )
+		{
+			vRow[dwEdge] = _mm256_set1_pd( (f64)a_pTri->fEdgeX[dwEdge] * ( fPixelY - (f64)a_pTri->fOriginY[dwEdge] ) );
+		}
+		u32 *pColorRow = pTarget->pColor + ( (u64)iY * pTarget->dwWidth );
+		f32 *pDepthRow = pTarget->pDepth + ( (u64)iY * pTarget->dwWidth );
+		for( s32 iX = iX0; iX < iX1; iX += 8 )
+		{
+			__m256d vPixelLow = _mm256_add_pd( _mm256_set1_pd( (f64)iX ), vLanesLow );
+			__m256d vPixelHigh = _mm256_add_pd( _mm256_set1_pd( (f64)iX ), vLanesHigh );
+			__m256 vMask = _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_set1_epi32( iX1 - iX ), vLaneIndices ) );
+			__m256 vEdges[3];
+			for( u32 dwEdge = 0; dwEdge < 3; ++dwEdge )
+			{
+				__m256d vLow = _mm256_sub_pd( vRow[dwEdge], _mm256_mul_pd( vEdgeY[dwEdge], _mm256_sub_pd( vPixelLow, vOriginX[dwEdge] ) ) );
+				__m256d vHigh = _mm256_sub_pd( vRow[dwEdge], _mm256_mul_pd( vEdgeY[dwEdge], _mm256_sub_pd( vPixelHigh, vOriginX[dwEdge] ) ) );
+				vEdges[dwEdge] = _mm256_insertf128_ps( _mm256_castps128_ps256( _mm256_cvtpd_ps( vLow ) ), _mm256_cvtpd_ps( vHigh ), 1 );
+				__m256 vInside = _mm256_or_ps( _mm256_cmp_ps( vEdges[dwEdge], vZero, _CMP_GT_OQ ),
+					_mm256_and_ps( _mm256_cmp_ps( vEdges[dwEdge], vZero, _CMP_EQ_OQ ), vTopLeft[dwEdge] ) );
+				vMask = _mm256_and_ps( vMask, vInside );
+			}
+			u32 dwMask = (u32)_mm256_movemask_ps( vMask );
+			if( !dwMask )
+			{
+				continue;
+			}
+			for( u32 dwBits = dwMask; dwBits; dwBits &= dwBits - 1 )
+			{
+				++dwCovered;
+			}
+			__m256 vL0 = _mm256_mul_ps( vEdges[0], vInvArea );
+			__m256 vL1 = _mm256_mul_ps( vEdges[1], vInvArea );
+			__m256 vL2 = _mm256_mul_ps( vEdges[2], vInvArea );
+			__m256 vZ = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vL0, _mm256_set1_ps( a_pTri->fZ[0] ) ), _mm256_mul_ps( vL1, _mm256_set1_ps( a_pTri->fZ[1] ) ) ),
+				_mm256_mul_ps( vL2, _mm256_set1_ps( a_pTri->fZ[2] ) ) );
+			vZ = _mm256_min_ps( _mm256_max_ps( vZ, vMinDepth ), vMaxDepth );
+			__m256 vDepth = _mm256_maskload_ps( pDepthRow + iX, _mm256_castps_si256( vMask ) );
+#if REVERSE_Z
+			vMask = _mm256_and_ps( vMask, _mm256_cmp_ps( vZ, vDepth, _CMP_GT_OQ ) );
+#else
+			vMask = _mm256_and_ps( vMask, _mm256_cmp_ps( vZ, vDepth, _CMP_LT_OQ ) );
+#endif
+			dwMask = (u32)_mm256_movemask_ps( vMask );
+			if( !dwMask )
+			{
+				continue;
+			}
+			for( u32 dwBits = dwMask; dwBits; dwBits &= dwBits - 1 )
+			{
+				++dwShaded;
+			}
+			__m256i vStoreMask = _mm256_castps_si256( vMask );
+			_mm256_maskstore_ps( pDepthRow + iX, vStoreMask, vZ );
+
+			//perspective correct attributes
+			__m256 vInvW = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vL0, _mm256_set1_ps( a_pTri->fInvW[0] ) ), _mm256_mul_ps( vL1, _mm256_set1_ps( a_pTri->fInvW[1] ) ) ),
+				_mm256_mul_ps( vL2, _mm256_set1_ps( a_pTri->fInvW[2] ) ) );
+			__m256 vW = _mm256_div_ps( vOne, vInvW );
+			__m256 vAttributes[SOFT_RASTER_ATTRIBUTES];
+			for( u32 dwAttribute = 0; dwAttribute < SOFT_RASTER_ATTRIBUTES; ++dwAttribute )
+			{
+				__m256 vSum = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vL0, _mm256_set1_ps( a_pTri->fAttributes[0][dwAttribute] ) ),
+					_mm256_mul_ps( vL1, _mm256_set1_ps( a_pTri->fAttributes[1][dwAttribute] ) ) ), _mm256_mul_ps( vL2, _mm256_set1_ps( a_pTri->fAttributes[2][dwAttribute] ) ) );
+				vAttributes[dwAttribute] = _mm256_mul_ps( vSum, vW );
+			}
+
+			//PixelShader.hlsl, a zero normal normalizes to NaN and max then gives 0 like on the gpu
+			__m256 vLengthSq = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( vAttributes[0], vAttributes[0] ), _mm256_mul_ps( vAttributes[1], vAttributes[1] ) ),
+				_mm256_mul_ps( vAttributes[2], vAttributes[2] ) );
+			__m256 vInvLength = _mm256_div_ps( vOne, _mm256_sqrt_ps( vLengthSq ) );
+			__m256 vDot = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_mul_ps( vAttributes[0], vInvLength ), _mm256_set1_ps( pLight[4] ) ),
+				_mm256_mul_ps( _mm256_mul_ps( vAttributes[1], vInvLength ), _mm256_set1_ps( pLight[5] ) ) ),
+				_mm256_mul_ps( _mm256_mul_ps( vAttributes[2], vInvLength ), _mm256_set1_ps( pLight[6] ) ) );
+			__m256 vDiffuse = _mm256_max_ps( vDot, vZero );
+			__m256i vChannels[4];
+			for( u32 dwChannel = 0; dwChannel < 4; ++dwChannel )
+			{
+				__m256 vLit = _mm256_add_ps( vDiffuse, _mm256_set1_ps( dwChannel == 3 ? 1.0f : 0.45f ) );
+				__m256 vValue = _mm256_mul_ps( _mm256_mul_ps( vAttributes[3 + dwChannel], _mm256_set1_ps( pLight[dwChannel] ) ), vLit );
+				vValue = _mm256_min_ps( _mm256_max_ps( vValue, vZero ), vOne );
+				if( dwChannel == 3 )
+				{
+					vChannels[dwChannel] = _mm256_cvttps_epi32( _mm256_add_ps( _mm256_mul_ps( vValue, _mm256_set1_ps( 255.0f ) ), vHalf ) );
+				}
+				else
+				{
+					__m256i vEntry = _mm256_cvttps_epi32( _mm256_add_ps( _mm256_mul_ps( vValue, _mm256_set1_ps( fLutScale ) ), vHalf ) );
+					vChannels[dwChannel] = _mm256_and_si256( _mm256_i32gather_epi32( (const int*)softRasterSrgb, vEntry, 1 ), _mm256_set1_epi32( 0xff ) );
+				}
+			}
+			__m256i vColor = _mm256_or_si256( _mm256_or_si256( vChannels[0], _mm256_slli_epi32( vChannels[1], 8 ) ),
+				_mm256_or_si256( _mm256_slli_epi32( vChannels[2], 16 ), _mm256_slli_epi32( vChannels[3], 24 ) ) );
+			_mm256_maskstore_epi32( (int*)( pColorRow + iX ), vStoreMask, vColor );
+		}
+	}
+#else
+	for( s32 iY = iY0; iY < iY1; ++iY )
+	{
+		f64 fPixelY = (f64)iY + 0.5;
+		f64 fRow[3];
+		for( u32 dwEdge = 0; dwEdge < 3; ++dwEdge )
+		{
+			fRow[dwEdge] = (f64)a_pTri->fEdgeX[dwEdge] * ( fPixelY - (f64)a_pTri->fOriginY[dwEdge] );
+		}
+		u32 *pColorRow = pTarget->pColor + ( (u64)iY * pTarget->dwWidth );
+		f32 *pDepthRow = pTarget->pDepth + ( (u64)iY * pTarget->dwWidth );
+		for( s32 iX = iX0; iX < iX1; ++iX )
+		{
+			f64 fPixelX = (f64)iX + 0.5;
+			f32 fEdges[3];
+			bool bInside = true;
+			for( u32 dwEdge = 0; dwEdge < 3; ++dwEdge )
+			{
+				fEdges[dwEdge] = (f32)( fRow[dwEdge] - ( (f64)a_pTri->fEdgeY[dwEdge] * ( fPixelX - (f64)a_pTri->fOriginX[dwEdge] ) ) );
+				bInside = bInside && ( fEdges[dwEdge] > 0.0f || ( fEdges[dwEdge] == 0.0f && ( ( a_pTri->dwTopLeft >> dwEdge ) & 1 ) ) );
+			}
+			if( !bInside )
+			{
+				continue;
+			}
+			++dwCovered;
+			f32 fL0 = fEdges[0] * a_pTri->fInvArea;
+			f32 fL1 = fEdges[1] * a_pTri->fInvArea;
+			f32 fL2 = fEdges[2] * a_pTri->fInvArea;
+			f32 fZ = ( ( fL0 * a_pTri->fZ[0] ) + ( fL1 * a_pTri->fZ[1] ) ) + ( fL2 * a_pTri->fZ[2] );
+			fZ = fZ > fMinDepth ? fZ : fMinDepth;
+			fZ = fZ < fMaxDepth ? fZ : fMaxDepth;
+#if REVERSE_Z
+			if( !( fZ > pDepthRow[iX] ) )
+#else
+			if( !( fZ < pDepthRow[iX] ) )
+#endif
+			{
+				continue;
+			}
+			++dwShaded;
+			pDepthRow[iX] = fZ;
+
+			f32 fW = 1.0f / ( ( ( fL0 * a_pTri->fInvW[0] ) + ( fL1 * a_pTri->fInvW[1] ) ) + ( fL2 * a_pTri->fInvW[2] ) );
+			f32 fAttributes[SOFT_RASTER_ATTRIBUTES];
+			for( u32 dwAttribute = 0; dwAttribute < SOFT_RASTER_ATTRIBUTES; ++dwAttribute )
+			{
+				fAttributes[dwAttribute] = ( ( ( fL0 * a_pTri->fAttributes[0][dwAttribute] ) + ( fL1 * a_pTri->fAttributes[1][dwAttribute] ) ) +
+					( fL2 * a_pTri->fAttributes[2][dwAttribute] ) ) * fW;
+			}
+
+			//PixelShader.hlsl, a zero normal normalizes to NaN and max then gives 0 like on the gpu
+			f32 fInvLength = 1.0f / sqrtf( ( ( fAttributes[0] * fAttributes[0] ) + ( fAttributes[1] * fAttributes[1] ) ) + ( fAttributes[2] * fAttributes[2] ) );
+			f32 fDot = ( ( ( fAttributes[0] * fInvLength ) * pLight[4] ) + ( ( fAttributes[1] * fInvLength ) * pLight[5] ) ) + ( ( fAttributes[2] * fInvLength ) * pLight[6] );
+			f32 fDiffuse = fDot > 0.0f ? fDot : 0.0f;
+			f32 fValues[4];
+			for( u32 dwChannel = 0; dwChannel < 4; ++dwChannel )
+			{
+				f32 fValue = ( fAttributes[3 + dwChannel] * pLight[dwChannel] ) * ( fDiffuse + ( dwChannel == 3 ? 1.0f : 0.45f ) );
+				fValue = fValue > 0.0f ? fValue : 0.0f;
+				fValues[dwChannel] = fValue < 1.0f ? fValue : 1.0f;
+			}
+			pColorRow[iX] = SoftRasterEncodeColor( fValues[0], fValues[1], fValues[2], fValues[3] );
+		}
+	}
+#endif
+	return (u64)dwCovered | ( (u64)dwShaded << 32 );
+}
+
+void SoftRasterTileRange( void *pContext, u32 dwBegin, u32 dwEnd )
+{
+	SoftRaster *pRaster = (SoftRaster*)pContext;
+	for( u32 dwTile = dwBegin; dwTile < dwEnd; ++dwTile )
+	{
+		s32 iTileX0 = (s32)( ( dwTile % pRaster->dwTilesX ) * SOFT_RASTER_TILE_SIZE );
+		s32 iTileY0 = (s32)( ( dwTile / pRaster->dwTilesX ) * SOFT_RASTER_TILE_SIZE );
+		s32 iTileX1 = iTileX0 + SOFT_RASTER_TILE_SIZE;
+		s32 iTileY1 = iTileY0 + SOFT_RASTER_TILE_SIZE;
+		u64 qwCovered = 0;
+		u64 qwShaded = 0;
+		for( u32 dwBin = pRaster->pTileStarts[dwTile]; dwBin < pRaster->pTileStarts[dwTile + 1]; ++dwBin )
+		{
+			SoftRasterTriangle *pTri = &pRaster->pTriangles[pRaster->pBins[dwBin]];
+			u64 qwCounts = SoftRasterRasterize( pRaster, pTri, pTri->iRect[0] > iTileX0 ? pTri->iRect[0] : iTileX0, pTri->iRect[1] > iTileY0 ? pTri->iRect[1] : iTileY0,
+				pTri->iRect[2] < iTileX1 ? pTri->iRect[2] : iTileX1, pTri->iRect[3] < iTileY1 ? pTri->iRect[3] : iTileY1 );
+			qwCovered += qwCounts & 0xffffffff;
+			qwShaded += qwCounts >> 32;
+		}
+		pRaster->pTileCounts[dwTile * 2] = qwCovered;
+		pRaster->pTileCounts[( dwTile * 2 ) + 1] = qwShaded;
+	}
+}
+
+//replays a recorded frame into a_pTarget, which is drawn over as it is (clear it first like RenderFrame does). false if the stream
+//overflowed or the scratch memory couldn't grow, the pipelines are told apart by which of a_pResources' they are
+inline
+bool SoftRasterExecute( SoftRaster *a_pRaster, RenderCommandStream *a_pStream, RenderResources *a_pResources, SoftRasterTarget *a_pTarget )
+{
+	memset( &a_pRaster->stats, 0, sizeof( SoftRasterStats ) );
+	if( a_pStream->bOverflow )
+	{
+		logError( "Command stream overflowed, it can't be replayed!\n" );
+		return false;
+	}
+	LARGE_INTEGER startCounter, vertexCounter, setupCounter, endCounter;
+	QueryPerformanceCounter( &startCounter );
+	a_pRaster->pTarget = a_pTarget;
+
+	//what is bound, a stream without a viewport command draws to the whole target
+	SoftRasterDraw state;
+	memset( &state, 0, sizeof( SoftRasterDraw ) );
+	state.dwShader = SOFT_RASTER_SHADER_NONE;
+	state.viewport.Width = (f32)a_pTarget->dwWidth;
+	state.viewport.Height = (f32)a_pTarget->dwHeight;
+	state.viewport.MaxDepth = 1.0f;
+	D3D12_RECT scissorRect = { 0, 0, (LONG)a_pTarget->dwWidth, (LONG)a_pTarget->dwHeight };
+	a_pRaster->dwNumDraws = 0;
+	a_pRaster->dwNumBatches = 0;
+	u32 dwNumVertices = 0;
+	u32 dwNumTriangles = 0;
+	for( u32 dwCommand = 0; dwCommand < a_pStream->dwNumCommands; ++dwCommand )
+	{
+		RenderCommand *pCommand = &a_pStream->pCommands[dwCommand];
+		switch( pCommand->dwType )
+		{
+			case RENDER_COMMAND_PIPELINE:
+				state.dwShader = SoftRasterShaderOf( a_pResources, pCommand->qwArg );
+				break;
+			case RENDER_COMMAND_ROOT_SIGNATURE:
+				memcpy( state.fPixelConstants, a_pStream->pData + pCommand->dwArgs[0], sizeof( state.fPixelConstants ) );
+				break;
+			case RENDER_COMMAND_VERTEX_BUFFER:
+				if( pCommand->dwArgs[2] == MAIN_VB_SLOT )
+				{
+					state.qwVertices = pCommand->qwArg;
+					state.dwVertexBufferSize = pCommand->dwArgs[0];
+					state.dwVertexStride = pCommand->dwArgs[1];
+				}
+				else
+				{
+					state.qwInstances = pCommand->qwArg;
+					state.dwInstanceBufferSize = pCommand->dwArgs[0];
+					state.dwInstanceStride = pCommand->dwArgs[1];
+				}
+				break;
+			case RENDER_COMMAND_INDEX_BUFFER:
+				state.qwIndices = pCommand->qwArg;
+				state.dwIndexBufferSize = pCommand->dwArgs[0];
+				state.dwIndexSize = pCommand->dwArgs[1] == DXGI_FORMAT_R16_UINT ? sizeof( u16 ) : sizeof( u32 );
+				break;
+			case RENDER_COMMAND_SHADER_RESOURCE:
+				state.qwShaderResource = pCommand->qwArg;
+				break;
+			case RENDER_COMMAND_CONSTANT_BUFFER:
+				state.qwConstantBuffer = pCommand->qwArg;
+				break;
+			case RENDER_COMMAND_VERTEX_CONSTANTS:
+				if( pCommand->dwArgs[2] + pCommand->dwArgs[1] > RENDER_VERTEX_CONSTANTS_SIZE / 4 )
+				{
+					break;
+				}
+				memcpy( state.dwVertexConstants + pCommand->dwArgs[2], a_pStream->pData + pCommand->dwArgs[0], pCommand->dwArgs[1] * sizeof( u32 ) );
+				break;
+			case RENDER_COMMAND_VIEWPORT:
+				memcpy( &state.viewport, a_pStream->pData + pCommand->dwArgs[0], sizeof( D3D12_VIEWPORT ) );
+				memcpy( &scissorRect, a_pStream->pData + pCommand->dwArgs[0] + sizeof( D3D12_VIEWPORT ), sizeof( D3D12_RECT ) );
+				break;
+			case RENDER_COMMAND_DRAW_INDEXED:
+			{
+				++a_pRaster->stats.dwNumDraws;
+				if( state.dwShader == SOFT_RASTER_SHADER_NONE )
+				{
+					++a_pRaster->stats.dwNumDropped;
+					break;
+				}
+				if( !pCommand->dwArgs[1] || pCommand->dwArgs[0] < 3 )
+				{
+					break;
+				}
+				if( !SoftRasterReserve( (void**)&a_pRaster->pDraws, &a_pRaster->dwDrawCapacity, a_pRaster->dwNumDraws + 1, sizeof( SoftRasterDraw ) ) ||
+					!SoftRasterReserve( (void**)&a_pRaster->pBatches, &a_pRaster->dwBatchCapacity, a_pRaster->dwNumBatches + pCommand->dwArgs[1], sizeof( SoftRasterBatch ) ) )
+				{
+					logError( "Software rasterizer out of memory!\n" );
+					return false;
+				}
+				u32 dwDraw = a_pRaster->dwNumDraws++;
+				SoftRasterDraw *pDraw = &a_pRaster->pDraws[dwDraw];
+				*pDraw = state;
+				pDraw->dwIndexCount = pCommand->dwArgs[0];
+				pDraw->dwInstanceCount = pCommand->dwArgs[1];
+				pDraw->dwFirstIndex = pCommand->dwArgs[2];
+				pDraw->iBaseVertex = (s32)pCommand->dwArgs[3];
+				pDraw->dwFirstInstance = pCommand->dwArgs[4];
+				//the viewport's pixels within the scissor and the target
+				s32 iViewport[4] = { (s32)ceilf( state.viewport.TopLeftX - 0.5f ), (s32)ceilf( state.viewport.TopLeftY - 0.5f ),
+					(s32)ceilf( state.viewport.TopLeftX + state.viewport.Width - 0.5f ), (s32)ceilf( state.viewport.TopLeftY + state.viewport.Height - 0.5f ) };
+				s32 iScissor[4] = { (s32)scissorRect.left, (s32)scissorRect.top, (s32)scissorRect.right, (s32)scissorRect.bottom };
+				s32 iTarget[4] = { 0, 0, (s32)a_pTarget->dwWidth, (s32)a_pTarget->dwHeight };
+				for( u32 dwSide = 0; dwSide < 4; ++dwSide )
+				{
+					s32 iValue = iViewport[dwSide];
+					iValue = dwSide < 2 ? ( iScissor[dwSide] > iValue ? iScissor[dwSide] : iValue ) : ( iScissor[dwSide] < iValue ? iScissor[dwSide] : iValue );
+					pDraw->iRect[dwSide] = dwSide < 2 ? ( iTarget[dwSide] > iValue ? iTarget[dwSide] : iValue ) : ( iTarget[dwSide] < iValue ? iTarget[dwSide] : iValue );
+				}
+				pDraw->dwIndexCount -= pDraw->dwIndexCount % 3;
+				u32 dwMin = 0xffffffff;
+				u32 dwMax = 0;
+				for( u32 dwIndex = 0; dwIndex < pDraw->dwIndexCount; ++dwIndex )
+				{
+					u32 dwVertex = SoftRasterIndex( pDraw, dwIndex );
+					dwMin = dwVertex < dwMin ? dwVertex : dwMin;
+					dwMax = dwVertex > dwMax ? dwVertex : dwMax;
+				}
+				pDraw->dwMinVertex = dwMin;
+				pDraw->dwNumVertices = dwMax - dwMin + 1;
+				for( u32 dwInstance = 0; dwInstance < pDraw->dwInstanceCount; ++dwInstance )
+				{
+					SoftRasterBatch *pBatch = &a_pRaster->pBatches[a_pRaster->dwNumBatches++];
+					pBatch->dwDraw = dwDraw;
+					pBatch->dwInstance = dwInstance;
+					pBatch->dwFirstVertex = dwNumVertices;
+					pBatch->dwFirstTriangle = dwNumTriangles;
+					dwNumVertices += pDraw->dwNumVertices;
+					dwNumTriangles += pDraw->dwIndexCount / 3;
+				}
+				a_pRaster->stats.dwNumInstances += pDraw->dwInstanceCount;
+				break;
+			}
+		}
+	}
+	a_pRaster->stats.dwNumVertices = dwNumVertices;
+	a_pRaster->stats.dwNumTriangles = dwNumTriangles;
+
+	a_pRaster->dwTilesX = ( a_pTarget->dwWidth + SOFT_RASTER_TILE_SIZE - 1 ) / SOFT_RASTER_TILE_SIZE;
+	a_pRaster->dwTilesY = ( a_pTarget->dwHeight + SOFT_RASTER_TILE_SIZE - 1 ) / SOFT_RASTER_TILE_SIZE;
+	u32 dwNumTiles = a_pRaster->dwTilesX * a_pRaster->dwTilesY;
+	a_pRaster->dwNumChunks = ( dwNumTriangles + SOFT_RASTER_SETUP_CHUNK - 1 ) / SOFT_RASTER_SETUP_CHUNK;
+	u32 dwNumChunks = a_pRaster->dwNumChunks;
+	if( !SoftRasterReserve( (void**)&a_pRaster->pVertices, &a_pRaster->dwVertexCapacity, dwNumVertices, sizeof( SoftRasterVertex ) ) ||
+		!SoftRasterReserve( (void**)&a_pRaster->pChunkTriangles, &a_pRaster->dwChunkCapacity, ( 2 * dwNumChunks ) + 1, sizeof( u32 ) ) ||
+		!SoftRasterReserve( (void**)&a_pRaster->pBinCounts, &a_pRaster->dwBinCountCapacity, ( dwNumChunks * dwNumTiles ) + 1, sizeof( u32 ) ) ||
+		!SoftRasterReserve( (void**)&a_pRaster->pTileStarts, &a_pRaster->dwTileCapacity, dwNumTiles + 1, sizeof( u32 ) ) ||
+		!SoftRasterReserve( (void**)&a_pRaster->pTileCounts, &a_pRaster->dwTileCountCapacity, 2 * dwNumTiles, sizeof( u64 ) ) )
+	{
+		logError( "Software rasterizer out of memory!\n" );
+		return false;
+	}
+	ParallelFor( a_pRaster->pPool, dwNumVertices, SOFT_RASTER_VERTEX_CHUNK, SoftRasterVertexRange, a_pRaster );
+	QueryPerformanceCounter( &vertexCounter );
+
+	//count what each chunk sets up so every chunk knows where its triangles go, then set them up and count what each tile gets from
+	//each chunk, then bin. the bins are tile by tile and chunk by chunk within a tile, which keeps every tile's triangles in submission order
+	ParallelFor( a_pRaster->pPool, dwNumChunks, 1, SoftRasterCountRange, a_pRaster );
+	u32 dwNumSetup = 0;
+	for( u32 dwChunk = 0; dwChunk < dwNumChunks; ++dwChunk )
+	{
+		u32 dwCount = a_pRaster->pChunkTriangles[dwChunk];
+		a_pRaster->pChunkTriangles[dwChunk] = dwNumSetup;
+		dwNumSetup += dwCount;
+	}
+	a_pRaster->pChunkTriangles[dwNumChunks] = dwNumSetup;
+	if( !SoftRasterReserve( (void**)&a_pRaster->pTriangles, &a_pRaster->dwTriangleCapacity, dwNumSetup, sizeof( SoftRasterTriangle ) ) )
+	{
+		logError( "Software rasterizer out of memory!\n" );
+		return false;
+	}
+	ParallelFor( a_pRaster->pPool, dwNumChunks, 1, SoftRasterSetupRange, a_pRaster );
+	u32 dwNumBinned = 0;
+	for( u32 dwTile = 0; dwTile < dwNumTiles; ++dwTile )
+	{
+		a_pRaster->pTileStarts[dwTile] = dwNumBinned;
+		for( u32 dwChunk = 0; dwChunk < dwNumChunks; ++dwChunk )
+		{
+			u32 *pCount = &a_pRaster->pBinCounts[( (u64)dwChunk * dwNumTiles ) + dwTile];
+			u32 dwCount = *pCount;
+			*pCount = dwNumBinned;
+			dwNumBinned += dwCount;
+		}
+	}
+	a_pRaster->pTileStarts[dwNumTiles] = dwNumBinned;
+	if( !SoftRasterReserve( (void**)&a_pRaster->pBins, &a_pRaster->dwBinCapacity, dwNumBinned, sizeof( u32 ) ) )
+	{
+		logError( "Software rasterizer out of memory!\n" );
+		return false;
+	}
+	ParallelFor( a_pRaster->pPool, dwNumChunks, 1, SoftRasterBinRange, a_pRaster );
+	for( u32 dwChunk = 0; dwChunk < dwNumChunks; ++dwChunk )
+	{
+		a_pRaster->stats.dwNumClipped += a_pRaster->pChunkTriangles[dwNumChunks + 1 + dwChunk];
+	}
+	a_pRaster->stats.dwNumSetup = dwNumSetup;
+	a_pRaster->stats.dwNumBinned = dwNumBinned;
+	QueryPerformanceCounter( &setupCounter );
+
+	ParallelFor( a_pRaster->pPool, dwNumTiles, 1, SoftRasterTileRange, a_pRaster );
+	for( u32 dwTile = 0; dwTile < dwNumTiles; ++dwTile )
+	{
+		a_pRaster->stats.qwNumCovered += a_pRaster->pTileCounts[dwTile * 2];
+		a_pRaster->stats.qwNumPixels += a_pRaster->pTileCounts[( dwTile * 2 ) + 1];
+	}
+	QueryPerformanceCounter( &endCounter );
+	a_pRaster->stats.qwVertexTicks = (u64)( vertexCounter.QuadPart - startCounter.QuadPart );
+	a_pRaster->stats.qwSetupTicks = (u64)( setupCounter.QuadPart - vertexCounter.QuadPart );
+	a_pRaster->stats.qwRasterTicks = (u64)( endCounter.QuadPart - setupCounter.QuadPart );
+	return true;
+}
+
+inline
+u32 SoftRasterCrc32( u32 dwCrc, const u8 *a_pData, u32 dwSize )
+{
+	dwCrc = ~dwCrc;
+	for( u32 dwByte = 0; dwByte < dwSize; ++dwByte )
+	{
+		dwCrc = softRasterCrcTable[( dwCrc ^ a_pData[dwByte] ) & 0xff] ^ ( dwCrc >> 8 );
+	}
+	return ~dwCrc;
+}
+
+//5552 bytes is as many as the sums can take before they have to be reduced
+inline
+u32 SoftRasterAdler32( const u8 *a_pData, u32 dwSize )
+{
+	u32 dwA = 1;
+	u32 dwB = 0;
+	while( dwSize )
+	{
+		u32 dwRun = dwSize < 5552 ? dwSize : 5552;
+		dwSize -= dwRun;
+		for( u32 dwByte = 0; dwByte < dwRun; ++dwByte )
+		{
+			dwA += *a_pData++;
+			dwB += dwA;
+		}
+		dwA %= 65521;
+		dwB %= 65521;
+	}
+	return ( dwB << 16 ) | dwA;
+}
+
+inline
+u8 *SoftRasterPutU32( u8 *a_pOut, u32 dwValue )
+{
+	a_pOut[0] = (u8)( dwValue >> 24 );
+	a_pOut[1] = (u8)( dwValue >> 16 );
+	a_pOut[2] = (u8)( dwValue >> 8 );
+	a_pOut[3] = (u8)dwValue;
+	return a_pOut + 4;
+}
+
+inline
+u32 SoftRasterGetU32( const u8 *a_pIn )
+{
+	return ( (u32)a_pIn[0] << 24 ) | ( (u32)a_pIn[1] << 16 ) | ( (u32)a_pIn[2] << 8 ) | (u32)a_pIn[3];
+}
+
+//a chunk whose type and data are already in place after the length, fills in the length and the crc after the data, returns the end
+inline
+u8 *SoftRasterPngChunk( u8 *a_pChunk, u32 dwSize )
+{
+	SoftRasterPutU32( a_pChunk, dwSize );
+	return SoftRasterPutU32( a_pChunk + 8 + dwSize, SoftRasterCrc32( 0, a_pChunk + 4, dwSize + 4 ) );
+}
+
+//8 bit RGBA rows top down like SoftRasterTarget's color, tagged srgb since that is what the eye targets hold. the image goes in stored
+//deflate blocks, so nothing has to be linked in and SoftRasterReadPng can read it back exactly
+inline
+bool SoftRasterWritePng( const char *pFileName, const u32 *a_pPixels, u32 dwWidth, u32 dwHeight )
+{
+	const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	u64 qwRowSize = 1 + ( (u64)dwWidth * 4 );
+	u64 qwRawSize = qwRowSize * dwHeight;
+	u64 qwNumBlocks = qwRawSize ? ( qwRawSize + SOFT_RASTER_PNG_BLOCK - 1 ) / SOFT_RASTER_PNG_BLOCK : 1;
+	u64 qwZlibSize = 2 + ( qwNumBlocks * 5 ) + qwRawSize + 4;
+	u64 qwFileSize = sizeof( signature ) + ( 12 + 13 ) + ( 12 + 1 ) + ( 12 + qwZlibSize ) + 12;
+	if( qwFileSize >= 0x80000000 )
+	{
+		return false;
+	}
+	u8 *pRaw = (u8*)malloc( (size_t)( qwRawSize + qwFileSize ) );
+	if( !pRaw )
+	{
+		return false;
+	}
+	u8 *pFile = pRaw + qwRawSize;
+	//every row unfiltered
+	for( u32 dwRow = 0; dwRow < dwHeight; ++dwRow )
+	{
+		pRaw[dwRow * qwRowSize] = 0;
+		memcpy( pRaw + ( dwRow * qwRowSize ) + 1, a_pPixels + ( (u64)dwRow * dwWidth ), (size_t)dwWidth * 4 );
+	}
+
+	u8 *pOut = pFile;
+	memcpy( pOut, signature, sizeof( signature ) );
+	pOut += sizeof( signature );
+	memcpy( pOut + 4, "IHDR", 4 );
+	SoftRasterPutU32( pOut + 8, dwWidth );
+	SoftRasterPutU32( pOut + 12, dwHeight );
+	pOut[16] = 8; //bits per channel
+	pOut[17] = 6; //RGBA
+	pOut[18] = 0; //deflate
+	pOut[19] = 0; //adaptive filters, all none here
+	pOut[20] = 0; //not interlaced
+	pOut = SoftRasterPngChunk( pOut, 13 );
+	memcpy( pOut + 4, "sRGB", 4 );
+	pOut[8] = 0; //perceptual
+	pOut = SoftRasterPngChunk( pOut, 1 );
+
+	u8 *pChunk = pOut;
+	memcpy( pChunk + 4, "IDAT", 4 );
+	pOut = pChunk + 8;
+	*pOut++ = 0x78; //deflate with a 32k window
+	*pOut++ = 0x01; //no dictionary, check bits
+	u64 qwLeft = qwRawSize;
+	const u8 *pIn = pRaw;
+	do
+	{
+		u32 dwBlock = qwLeft < SOFT_RASTER_PNG_BLOCK ? (u32)qwLeft : SOFT_RASTER_PNG_BLOCK;
+		qwLeft -= dwBlock;
+		*pOut++ = qwLeft ? 0 : 1; //stored, final on the last one
+		*pOut++ = (u8)dwBlock;
+		*pOut++ = (u8)( dwBlock >> 8 );
+		*pOut++ = (u8)~dwBlock;
+		*pOut++ = (u8)( ~dwBlock >> 8 );
+		memcpy( pOut, pIn, dwBlock );
+		pOut += dwBlock;
+		pIn += dwBlock;
+	} while( qwLeft );
+	pOut = SoftRasterPutU32( pOut, SoftRasterAdler32( pRaw, (u32)qwRawSize ) );
+	pOut = SoftRasterPngChunk( pChunk, (u32)qwZlibSize );
+	memcpy( pOut + 4, "IEND", 4 );
+	pOut = SoftRasterPngChunk( pOut, 0 );
+
+	HANDLE hFile = CreateFileA( pFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	bool bSuccess = false;
+	if( hFile != INVALID_HANDLE_VALUE )
+	{
+		DWORD dwWritten;
+		bSuccess = WriteFile( hFile, pFile, (DWORD)( pOut - pFile ), &dwWritten, nullptr ) != 0 && dwWritten == (DWORD)( pOut - pFile );
+		CloseHandle( hFile );
+	}
+	free( pRaw );
+	return bSuccess;
+}
+
+//reads back what SoftRasterWritePng writes (8 bit RGBA, unfiltered rows in stored blocks), anything else is refused.
+//null if there is no such file, free() the pixels when done
+inline
+u32 *SoftRasterReadPng( const char *pFileName, u32 *a_pWidth, u32 *a_pHeight )
+{
+	HANDLE hFile = CreateFileA( pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( hFile == INVALID_HANDLE_VALUE || !hFile )
+	{
+		return nullptr;
+	}
+	LARGE_INTEGER fileSize;
+	u8 *pFile = nullptr;
+	DWORD dwRead = 0;
+	if( GetFileSizeEx( hFile, &fileSize ) && fileSize.QuadPart > 8 && fileSize.QuadPart < 0x80000000 )
+	{
+		pFile = (u8*)malloc( (size_t)fileSize.QuadPart * 2 ); //the file, then its IDAT data put back together
+		if( pFile && ( !ReadFile( hFile, pFile, (DWORD)fileSize.QuadPart, &dwRead, nullptr ) || dwRead != (DWORD)fileSize.QuadPart ) )
+		{
+			free( pFile );
+			pFile = nullptr;
+		}
+	}
+	CloseHandle( hFile );
+	if( !pFile )
+	{
+		return nullptr;
+	}
+	u32 dwFileSize = (u32)fileSize.QuadPart;
+	u8 *pZlib = pFile + dwFileSize;
+	u32 dwZlibSize = 0;
+	u32 dwWidth = 0;
+	u32 dwHeight = 0;
+	bool bValid = memcmp( pFile, "\x89PNG\r\n\x1a\n", 8 ) == 0;
+	bool bEnd = false;
+	for( u32 dwOffset = 8; bValid && !bEnd; )
+	{
+		u32 dwSize = dwOffset + 12 <= dwFileSize ? SoftRasterGetU32( pFile + dwOffset ) : 0xffffffff;
+		if( dwSize > dwFileSize - dwOffset - 12 || SoftRasterCrc32( 0, pFile + dwOffset + 4, dwSize + 4 ) != SoftRasterGetU32( pFile + dwOffset + 8 + dwSize ) )
+		{
+			bValid = false;
+			break;
+		}
+		const u8 *pData = pFile + dwOffset + 8;
+		if( memcmp( pFile + dwOffset + 4, "IHDR", 4 ) == 0 )
+		{
+			dwWidth = dwSize == 13 ? SoftRasterGetU32( pData ) : 0;
+			dwHeight = dwSize == 13 ? SoftRasterGetU32( pData + 4 ) : 0;
+			bValid = dwSize == 13 && pData[8] == 8 && pData[9] == 6 && pData[10] == 0 && pData[11] == 0 && pData[12] == 0;
+		}
+		else if( memcmp( pFile + dwOffset + 4, "IDAT", 4 ) == 0 )
+		{
+			memcpy( pZlib + dwZlibSize, pData, dwSize );
+			dwZlibSize += dwSize;
+		}
+		bEnd = memcmp( pFile + dwOffset + 4, "IEND", 4 ) == 0;
+		dwOffset += 12 + dwSize;
+	}
+
+	//the deflate stream is read in place, stored blocks just get their headers taken out
+	u64 qwRowSize = 1 + ( (u64)dwWidth * 4 );
+	u64 qwRawSize = qwRowSize * dwHeight;
+	u32 dwRawSize = 0;
+	bValid = bValid && bEnd && dwWidth && dwHeight && qwRawSize <= dwZlibSize && dwZlibSize >= 6 && ( pZlib[0] & 0x0f ) == 8 &&
+		!( pZlib[1] & 0x20 ) && ( ( ( (u32)pZlib[0] << 8 ) | pZlib[1] ) % 31 ) == 0;
+	for( u32 dwOffset = 2; bValid; )
+	{
+		if( dwOffset + 5 > dwZlibSize || ( pZlib[dwOffset] & 0x06 ) != 0 )
+		{
+			bValid = false; //compressed blocks aren't ours
+			break;
+		}
+		u8 bFinal = pZlib[dwOffset] & 1;
+		u32 dwBlock = (u32)pZlib[dwOffset + 1] | ( (u32)pZlib[dwOffset + 2] << 8 );
+		u32 dwCheck = (u32)pZlib[dwOffset + 3] | ( (u32)pZlib[dwOffset + 4] << 8 );
+		if( ( dwBlock ^ 0xffff ) != dwCheck || dwOffset + 5 + dwBlock > dwZlibSize )
+		{
+			bValid = false;
+			break;
+		}
+		memmove( pZlib + dwRawSize, pZlib + dwOffset + 5, dwBlock );
+		dwRawSize += dwBlock;
+		dwOffset += 5 + dwBlock;
+		if( bFinal )
+		{
+			bValid = dwOffset + 4 <= dwZlibSize && SoftRasterGetU32( pZlib + dwOffset ) == SoftRasterAdler32( pZlib, dwRawSize );
+			break;
+		}
+	}
+	bValid = bValid && dwRawSize == qwRawSize;
+	u32 *pPixels = bValid ? (u32*)malloc( (size_t)dwWidth * dwHeight * 4 ) : nullptr;
+	for( u32 dwRow = 0; pPixels && dwRow < dwHeight; ++dwRow )
+	{
+		if( pZlib[dwRow * qwRowSize] != 0 )
+		{
+			free( pPixels );
+			pPixels = nullptr;
+			break;
+		}
+		memcpy( pPixels + ( (u64)dwRow * dwWidth ), pZlib + ( dwRow * qwRowSize ) + 1, (size_t)dwWidth * 4 );
+	}
+	free( pFile );
+	*a_pWidth = pPixels ? dwWidth : 0;
+	*a_pHeight = pPixels ? dwHeight : 0;
+	return pPixels;
+}
+
+//pixels with a channel more than dwTolerance off, a_pDiff (if not null) gets those in red over a darkened a_pImage
+inline
+u32 SoftRasterCompare( const u32 *a_pImage, const u32 *a_pGolden, u32 dwNumPixels, u32 dwTolerance, u32 *a_pDiff )
+{
+	u32 dwNumDifferent = 0;
+	for( u32 dwPixel = 0; dwPixel < dwNumPixels; ++dwPixel )
+	{
+		u32 dwMaxDelta = 0;
+		for( u32 dwShift = 0; dwShift < 32; dwShift += 8 )
+		{
+			s32 iDelta = (s32)( ( a_pImage[dwPixel] >> dwShift ) & 0xff ) - (s32)( ( a_pGolden[dwPixel] >> dwShift ) & 0xff );
+			u32 dwDelta = (u32)( iDelta < 0 ? -iDelta : iDelta );
+			dwMaxDelta = dwDelta > dwMaxDelta ? dwDelta : dwMaxDelta;
+		}
+		bool bDifferent = dwMaxDelta > dwTolerance;
+		dwNumDifferent += bDifferent ? 1 : 0;
+		if( a_pDiff )
+		{
+			a_pDiff[dwPixel] = bDifferent ? 0xff0000ff : ( ( a_pImage[dwPixel] >> 2 ) & 0x003f3f3f ) | 0xff000000;
+		}
+	}
+	return dwNumDifferent;
+}
+
+#if BENCHMARK_MODE
+//records an eye's passes the way RenderFrame does (FrameSubmitDraws for the static then the skinned draws FrameBuildDraws sorted),
+//into a_pStream through a null backend, and renders it cleared to RenderFrame's color
+inline
+bool SoftRasterRenderEye( SoftRaster *a_pRaster, RenderCommandStream *a_pStream, RenderQueue *a_pQueue, RenderResources *a_pResources, SceneDrawList *a_pDraws,
+	Mat4f *a_pViewProj, D3D12_VIEWPORT *a_pViewport, D3D12_RECT *a_pScissorRect, u8 *a_pVisible, u32 dwSkinnedStart, SoftRasterTarget *a_pTarget )
+{
+	RenderBackend backend;
+	RenderBackendBeginRecording( &backend, a_pStream, a_pResources->pPipelines[RENDER_PIPELINE_STATIC] );
+	RenderSetViewport( &backend, a_pViewport, a_pScissorRect );
+	FrameSubmitDraws( &backend, a_pQueue, a_pResources, a_pDraws, nullptr, a_pViewProj, a_pVisible, 0, dwSkinnedStart );
+	FrameSubmitDraws( &backend, a_pQueue, a_pResources, a_pDraws, nullptr, a_pViewProj, a_pVisible, dwSkinnedStart, a_pQueue->dwCount );
+	SoftRasterClear( a_pTarget, frameClearColor, EYE_DEPTH_CLEAR );
+	return SoftRasterExecute( a_pRaster, a_pStream, a_pResources, a_pTarget );
+}
+
+//pixel a world position lands on, false if it is behind the eye or off the target
+inline
+bool SoftRasterBenchmarkPixel( Mat4f *a_pViewProj, D3D12_VIEWPORT *a_pViewport, f32 fX, f32 fY, f32 fZ, u32 *a_pX, u32 *a_pY )
+{
+	f32 fPos[4] = { fX, fY, fZ, 1.0f };
+	f32 fClip[4];
+	SoftRasterMul( fPos, &a_pViewProj->m[0][0], fClip );
+	if( fClip[3] <= 0.0f )
+	{
+		return false;
+	}
+	f32 fPixelX = a_pViewport->TopLeftX + ( ( ( fClip[0] / fClip[3] ) + 1.0f ) * 0.5f * a_pViewport->Width );
+	f32 fPixelY = a_pViewport->TopLeftY + ( ( 1.0f - ( fClip[1] / fClip[3] ) ) * 0.5f * a_pViewport->Height );
+	if( fPixelX < 0.0f || fPixelY < 0.0f || fPixelX >= a_pViewport->Width || fPixelY >= a_pViewport->Height )
+	{
+		return false;
+	}
+	*a_pX = (u32)fPixelX;
+	*a_pY = (u32)fPixelY;
+	return true;
+}
+
+//true if every channel is within dwTolerance
+inline
+bool SoftRasterBenchmarkColor( u32 dwColor, u32 dwExpected, u32 dwTolerance )
+{
+	return SoftRasterCompare( &dwColor, &dwExpected, 1, dwTolerance, nullptr ) == 0;
+}
+
+//the scene InitScene makes (FrameCreateSceneEntities) with 3 more cubes, so the cubes and the hands get instanced, set up and recorded
+//through FrameRender.h like the app does it into the null backend's command stream, in every RenderDrawDataMode and with instancing,
+//both eyes at half the Rift's resolution:
+//- a 16x16 grid of triangles with vertices on pixel centers covers every pixel of its rect exactly once (the fill rule) and none
+//  when wound the other way (culling)
+//- every way of getting the transforms to the shader draws the same image, and a render on one thread is bit for bit the same
+//- known pixels: the clear color in the sky, the floor and the lit face of the cube at what PixelShader.hlsl gives for them,
+//  the hands cover some of the image
+//- PNGs read back exactly, BasicOVRBenchmark.left.png / right.png are written and diffed against the .golden.png next to them,
+//  a missing golden fails (copy the .png over to make one after a change that is meant to change the image), the differences go to .diff.png
+//then the timed frames: ms per frame per pass with triangle and pixel throughput
+u32 BenchmarkSoftRaster()
+{
+	LARGE_INTEGER frequency, startCounter, endCounter;
+	QueryPerformanceFrequency( &frequency );
+	u32 dwFailures = 0;
+	const u32 dwWidth = 672;
+	const u32 dwHeight = 800;
+	const u32 dwNumPixels = dwWidth * dwHeight;
+	const u32 dwIterations = 20;
+	const u32 dwPaletteBones = 8; //the hand's 7 rounded up, so the palettes aren't back to back like with a bigger skinned permutation
+	const u32 dwNumCubes = 4;
+	const u32 dwNumConfigs = RENDER_DRAW_DATA_MODE_COUNT + 1; //every draw data mode, then instancing
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo( &systemInfo );
+	WorkerPool pool;
+	WorkerPool serialPool;
+	SoftRaster raster;
+	RenderCommandStream stream;
+	RenderQueue queue;
+	SceneDrawList drawList;
+	EntityStore store;
+	store.pPosX = nullptr;
+	queue.pKeys = nullptr;
+	drawList.pWorld = nullptr;
+	stream.pCommands = nullptr;
+
+	//what UploadModels puts in the default heap, with cpu addresses as the VAs
+	const u32 dwStaticVertexSize = sizeof( SoftRasterStaticVertex );
+	MeshIndices planeIndices16, cubeIndices16;
+	MeshIndices handIndices16[MESH_LOD_MAX_LEVELS];
+	MeshIndices *pMeshIndices[MESH_COUNT] = { &planeIndices16, &cubeIndices16, handIndices16 };
+	const u32 dwModelSize = FrameBuildMeshIndices( pMeshIndices );
+	const u32 dwGridCells = 16;
+	const u32 dwGridVertices = ( dwGridCells + 1 ) * ( dwGridCells + 1 );
+	const u32 dwGridIndices = dwGridCells * dwGridCells * 6;
+	u32 dwImagesSize = dwNumConfigs * ovrEye_Count * dwNumPixels * sizeof( u32 );
+	u8 *pMemory = (u8*)malloc( dwModelSize + ( ovrHand_Count * dwPaletteBones * sizeof( Mat4f ) ) + ( 16 * sizeof( RenderInstance ) ) +
+		( 16 * RENDER_DRAW_DATA_CBV_SIZE ) + ( dwGridVertices * dwStaticVertexSize ) + ( 2 * dwGridIndices * sizeof( u32 ) ) + dwImagesSize + ( 3 * dwNumPixels * sizeof( u32 ) ) );
+	if( !pMemory || !InitWorkerPool( &pool, systemInfo.dwNumberOfProcessors > 1 ? systemInfo.dwNumberOfProcessors - 1 : 0 ) || !InitWorkerPool( &serialPool, 0 ) ||
+		!InitRenderCommandStream( &stream, 4096, 64 * 1024 ) || !InitRenderQueue( &queue, 16 ) || !InitSceneDrawList( &drawList, 16 ) || !InitEntityStore( &store, 16 ) )
+	{
+		printf( "Soft raster: out of memory\n" );
+		return 1;
+	}
+	InitSoftRaster( &raster, &pool, dwPaletteBones );
+	u8 *pModels = pMemory;
+	Mat4f *pBones = (Mat4f*)( pModels + dwModelSize );
+	RenderInstance *pInstances = (RenderInstance*)( pBones + ( ovrHand_Count * dwPaletteBones ) );
+	u8 *pDrawData = (u8*)( pInstances + 16 );
+	SoftRasterStaticVertex *pGridVertices = (SoftRasterStaticVertex*)( pDrawData + ( 16 * RENDER_DRAW_DATA_CBV_SIZE ) );
+	u32 *pGridIndices = (u32*)( pGridVertices + dwGridVertices );
+	u32 *pImages = pGridIndices + ( 2 * dwGridIndices );
+	u32 *pScratch = pImages + ( dwNumConfigs * ovrEye_Count * dwNumPixels );
+	f32 *pDepth = (f32*)( pScratch + dwNumPixels );
+	u32 *pDiff = pScratch + ( 2 * dwNumPixels );
+
+	D3D12_VERTEX_BUFFER_VIEW vertexBuffers[MESH_COUNT];
+	D3D12_INDEX_BUFFER_VIEW indexBuffers[MESH_COUNT];
+	D3D12_VERTEX_BUFFER_VIEW *pVertexBuffers[MESH_COUNT] = { &vertexBuffers[MESH_PLANE], &vertexBuffers[MESH_CUBE], &vertexBuffers[MESH_HAND] };
+	D3D12_INDEX_BUFFER_VIEW *pIndexBuffers[MESH_COUNT] = { &indexBuffers[MESH_PLANE], &indexBuffers[MESH_CUBE], &indexBuffers[MESH_HAND] };
+	FrameWriteModels( pModels, (D3D12_GPU_VIRTUAL_ADDRESS)pModels, pMeshIndices, pVertexBuffers, pIndexBuffers );
+
+	//the scene, hands held out in front like a tracked pose would put them
+	Quatf qIdentity = { 1.0f, 0.0f, 0.0f, 0.0f };
+	EntityHandle hCube;
+	EntityHandle hHands[ovrHand_Count];
+	FrameCreateSceneEntities( &store, &hCube, hHands );
+	const Vec3f vCubePositions[dwNumCubes - 1] = { { -2.5f, 0.0f, -7.0f }, { 2.5f, 0.5f, -8.0f }, { 0.0f, 2.0f, -9.0f } };
+	for( u32 dwCube = 0; dwCube < dwNumCubes - 1; ++dwCube )
+	{
+		hCube = CreateEntity( &store );
+		Vec3f vPos = vCubePositions[dwCube];
+		SetEntityTransform( &store, hCube, &vPos, &qIdentity, 1.0f );
+		AddRenderable( &store, hCube, MESH_CUBE );
+	}
+	for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
+	{
+		Vec3f vHandPos = { dwHand == ovrHand_Left ? -0.2f : 0.2f, -0.3f, -0.5f };
+		SetEntityTransform( &store, hHands[dwHand], &vHandPos, &qIdentity, 1.0f );
+	}
+	UpdateEntityTransforms( &store, &pool );
+	BuildSceneDrawList( &store, &drawList );
+
+	//palettes at the starting pose like InitStartingSkeletons, latched with the hand's model matrix like LateLatchHandPoses
+	memset( pBones, 0, ovrHand_Count * dwPaletteBones * sizeof( Mat4f ) );
+	Mat4f mFinalBones[handBonesCount];
+	FrameHandStartingBones( mFinalBones );
+	u8 palettePresent[ovrHand_Count] = { 0, 0 };
+	for( u32 dwDraw = drawList.dwNumStatic; dwDraw < drawList.dwCount; ++dwDraw )
+	{
+		u32 dwHand = drawList.pPalette[dwDraw];
+		FrameWriteHandPalette( mFinalBones, &drawList.pWorld[dwDraw], (u8*)( pBones + ( dwHand * dwPaletteBones ) ) );
+		palettePresent[dwHand] = 1;
+	}
+
+	//InitPipelineStates' pipelines and root signatures only get compared
+	u32 dwPipelineIds[RENDER_PIPELINE_COUNT + RENDER_DRAW_DATA_MODE_COUNT + RENDER_ROOT_SIGNATURE_COUNT];
+	ID3D12PipelineState *pipelines[RENDER_PIPELINE_COUNT];
+	ID3D12RootSignature *rootSignatures[RENDER_ROOT_SIGNATURE_COUNT];
+	for( u32 dwPipeline = 0; dwPipeline < RENDER_PIPELINE_COUNT; ++dwPipeline )
+	{
+		pipelines[dwPipeline] = (ID3D12PipelineState*)&dwPipelineIds[dwPipeline];
+	}
+	for( u32 dwSignature = 0; dwSignature < RENDER_ROOT_SIGNATURE_COUNT; ++dwSignature )
+	{
+		rootSignatures[dwSignature] = (ID3D12RootSignature*)&dwPipelineIds[RENDER_PIPELINE_COUNT + RENDER_DRAW_DATA_MODE_COUNT + dwSignature];
+	}
+	pixelShaderCB pixelConstants;
+	FrameInitPixelConstants( &pixelConstants );
+	D3D12_GPU_VIRTUAL_ADDRESS palettes[ovrHand_Count];
+	RenderResources resources;
+	FrameInitRenderResources( &resources, pipelines, rootSignatures, (ID3D12PipelineState*)&dwPipelineIds[RENDER_PIPELINE_COUNT + RENDER_DRAW_DATA_ROOT_CBV],
+		(ID3D12PipelineState*)&dwPipelineIds[RENDER_PIPELINE_COUNT + RENDER_DRAW_DATA_INDEX], pVertexBuffers, pIndexBuffers, pMeshIndices, palettes, &pixelConstants );
+	D3D12_VERTEX_BUFFER_VIEW instanceBuffer = { (D3D12_GPU_VIRTUAL_ADDRESS)pInstances, 16 * sizeof( RenderInstance ), sizeof( RenderInstance ) };
+	FrameDrawBuffers drawBuffers = { pInstances, &instanceBuffer, pDrawData, (D3D12_GPU_VIRTUAL_ADDRESS)pDrawData, (D3D12_GPU_VIRTUAL_ADDRESS)pBones, dwPaletteBones * (u32)sizeof( Mat4f ) };
+
+	//the eyes 64mm apart, looking down -z
+	ovrFovPort fovs[ovrEye_Count] = { { 1.33f, 1.33f, 1.06f, 1.09f }, { 1.33f, 1.33f, 1.09f, 1.06f } }; //up, down, left, right
+	Mat4f eyeViewProjs[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		Vec3f vEyePos = { dwEye == ovrEye_Left ? -0.032f : 0.032f, 0.0f, 0.0f };
+		Mat4f mView, mProj;
+		InitViewMat4ByQuatf( &mView, &qIdentity, &vEyePos );
+		InitEyeProjection( &mProj, fovs[dwEye] );
+		Mat4fMult( &mView, &mProj, &eyeViewProjs[dwEye] );
+	}
+	D3D12_VIEWPORT viewport = { 0.0f, 0.0f, (f32)dwWidth, (f32)dwHeight, 0.0f, 1.0f };
+	D3D12_RECT scissorRect = { 0, 0, (LONG)dwWidth, (LONG)dwHeight };
+	u8 visible[( SCENE_MAX_ENTITIES + 7 ) / 8];
+	memset( visible, 0xff, sizeof( visible ) );
+	Vec3f vCenterEye = { 0.0f, 0.0f, 0.0f };
+	SoftRasterTarget target = { pScratch, pDepth, dwWidth, dwHeight };
+
+	//the fill rule: a grid over [84, 588) x [100, 700) whose inner vertices sit on pixel centers, half of them nudged a subpixel so
+	//diagonals pass exactly through centers too, drawn with an identity mvp so the positions are clip space
+	u32 dwSeed = 777;
+	for( u32 dwRow = 0; dwRow <= dwGridCells; ++dwRow )
+	{
+		for( u32 dwColumn = 0; dwColumn <= dwGridCells; ++dwColumn )
+		{
+			f32 fX = 84.0f + ( 31.5f * dwColumn );
+			f32 fY = 100.0f + ( 37.5f * dwRow );
+			dwSeed = ( dwSeed * 1664525 ) + 1013904223;
+			if( dwRow > 0 && dwRow < dwGridCells && dwColumn > 0 && dwColumn < dwGridCells && ( dwSeed >> 31 ) )
+			{
+				fX += ( (f32)( ( dwSeed >> 8 ) & 31 ) - 16.0f ) / SOFT_RASTER_SUBPIXEL;
+				fY += ( (f32)( ( dwSeed >> 16 ) & 31 ) - 16.0f ) / SOFT_RASTER_SUBPIXEL;
+			}
+			SoftRasterStaticVertex *pVertex = &pGridVertices[( dwRow * ( dwGridCells + 1 ) ) + dwColumn];
+			SoftRasterStaticVertex vertex = { { ( ( fX / dwWidth ) * 2.0f ) - 1.0f, 1.0f - ( ( fY / dwHeight ) * 2.0f ), 0.5f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } };
+			*pVertex = vertex;
+		}
+	}
+	for( u32 dwCell = 0; dwCell < dwGridCells * dwGridCells; ++dwCell )
+	{
+		u32 dwCorner = ( ( dwCell / dwGridCells ) * ( dwGridCells + 1 ) ) + ( dwCell % dwGridCells );
+		u32 dwQuad[4] = { dwCorner, dwCorner + 1, dwCorner + dwGridCells + 2, dwCorner + dwGridCells + 1 }; //clockwise on screen from the top left
+		u32 dwSplit = ( dwCell & 1 ) ? 1 : 0; //alternate diagonals
+		u32 dwTriangles[6] = { dwQuad[dwSplit], dwQuad[dwSplit + 1], dwQuad[( dwSplit + 2 ) & 3], dwQuad[( dwSplit + 2 ) & 3], dwQuad[( dwSplit + 3 ) & 3], dwQuad[dwSplit] };
+		for( u32 dwIndex = 0; dwIndex < 6; ++dwIndex )
+		{
+			pGridIndices[( dwCell * 6 ) + dwIndex] = dwTriangles[dwIndex];
+			pGridIndices[dwGridIndices + ( dwCell * 6 ) + ( 5 - dwIndex )] = dwTriangles[dwIndex];
+		}
+	}
+	MeshIndices gridIndices;
+	SetMeshIndicesSinglePart( &gridIndices, DXGI_FORMAT_R32_UINT, dwGridIndices );
+	D3D12_VERTEX_BUFFER_VIEW gridVertexBuffer = { (D3D12_GPU_VIRTUAL_ADDRESS)pGridVertices, dwGridVertices * dwStaticVertexSize, dwStaticVertexSize };
+	vertexShaderCB gridConstants;
+	memset( &gridConstants, 0, sizeof( vertexShaderCB ) );
+	InitMat4f( &gridConstants.mvpMat );
+	for( u32 dwWinding = 0; dwWinding < 2; ++dwWinding )
+	{
+		D3D12_INDEX_BUFFER_VIEW gridIndexBuffer = { (D3D12_GPU_VIRTUAL_ADDRESS)( pGridIndices + ( dwWinding * dwGridIndices ) ), dwGridIndices * sizeof( u32 ), DXGI_FORMAT_R32_UINT };
+		RenderBackend backend;
+		RenderBackendBeginRecording( &backend, &stream, resources.pPipelines[RENDER_PIPELINE_STATIC] );
+		RenderSetRootSignature( &backend, &resources, resources.pRootSignatures[RENDER_ROOT_SIGNATURE_STATIC] );
+		RenderSetGeometry( &backend, &gridVertexBuffer, &gridIndexBuffer );
+		RenderSetVertexConstants( &backend, &gridConstants, RENDER_CONSTANTS_NONE );
+		RenderDrawIndexed( &backend, &gridIndices, 1, 0 );
+		SoftRasterClear( &target, pixelConstants.vLightColor.v, EYE_DEPTH_CLEAR );
+		dwFailures += SoftRasterExecute( &raster, &stream, &resources, &target ) ? 0 : 1;
+		u64 qwExpected = dwWinding ? 0 : ( 588 - 84 ) * ( 700 - 100 );
+		dwFailures += raster.stats.qwNumCovered == qwExpected && raster.stats.qwNumPixels == qwExpected ? 0 : 1;
+	}
+
+	//the scene in every configuration
+	u32 dwSkinnedStart = 0;
+	for( u32 dwConfig = 0; dwConfig < dwNumConfigs; ++dwConfig )
+	{
+		u8 bInstancing = dwConfig == RENDER_DRAW_DATA_MODE_COUNT ? 1 : 0;
+		dwSkinnedStart = FrameBuildDraws( &queue, &resources, &drawList, visible, visible, palettePresent, &vCenterEye, bInstancing,
+			bInstancing ? RENDER_DRAW_DATA_ROOT_CONSTANTS : (s32)dwConfig, &drawBuffers );
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			target.pColor = pImages + ( ( ( dwConfig * ovrEye_Count ) + dwEye ) * dwNumPixels );
+			dwFailures += SoftRasterRenderEye( &raster, &stream, &queue, &resources, &drawList, &eyeViewProjs[dwEye], &viewport, &scissorRect, visible, dwSkinnedStart, &target ) ? 0 : 1;
+			dwFailures += raster.stats.dwNumDropped == 0 && raster.stats.dwNumInstances == drawList.dwCount ? 0 : 1;
+			dwFailures += raster.stats.dwNumDraws == ( bInstancing ? 3u : drawList.dwCount ) ? 0 : 1;
+		}
+	}
+	//the transforms take different roundings to the same place, so only a pixel here and there along an edge may differ
+	u32 dwMostDifferent = 0;
+	for( u32 dwConfig = 1; dwConfig < dwNumConfigs; ++dwConfig )
+	{
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			u32 dwDifferent = SoftRasterCompare( pImages + ( ( ( dwConfig * ovrEye_Count ) + dwEye ) * dwNumPixels ), pImages + ( dwEye * dwNumPixels ), dwNumPixels, 2, nullptr );
+			dwMostDifferent = dwDifferent > dwMostDifferent ? dwDifferent : dwMostDifferent;
+		}
+	}
+	dwFailures += dwMostDifferent <= dwNumPixels / 1000 ? 0 : 1;
+
+	//the last configuration again without workers
+	raster.pPool = &serialPool;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		target.pColor = pScratch;
+		dwFailures += SoftRasterRenderEye( &raster, &stream, &queue, &resources, &drawList, &eyeViewProjs[dwEye], &viewport, &scissorRect, visible, dwSkinnedStart, &target ) ? 0 : 1;
+		dwFailures += memcmp( pScratch, pImages + ( ( ( RENDER_DRAW_DATA_MODE_COUNT * ovrEye_Count ) + dwEye ) * dwNumPixels ), dwNumPixels * sizeof( u32 ) ) == 0 ? 0 : 1;
+	}
+	raster.pPool = &pool;
+
+	//known pixels of the reference images. the cube's +z face and the floor only get the light's y and z part
+	f32 fDiffuse = pixelConstants.vInvLightDir.v[1];
+	u32 dwCubeColor = SoftRasterEncodeColor( 0.0f, 0.62745f * ( fDiffuse + 0.45f ), 0.0f, 1.0f );
+	f32 fFloor = fDiffuse + 0.45f;
+	u32 dwFloorColor = SoftRasterEncodeColor( 0.5882f * 0.83137f * fFloor, 0.2941f * 0.62745f * fFloor, 0.0f, 1.0f );
+	u32 dwHandPixels = 0;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		u32 *pImage = pImages + ( dwEye * dwNumPixels );
+		u32 dwX, dwY;
+		dwFailures += pImage[0] == SoftRasterEncodeColor( frameClearColor[0], frameClearColor[1], frameClearColor[2], frameClearColor[3] ) ? 0 : 1;
+		dwFailures += SoftRasterBenchmarkPixel( &eyeViewProjs[dwEye], &viewport, 0.1f, 0.1f, -4.5f, &dwX, &dwY ) &&
+			SoftRasterBenchmarkColor( pImage[( dwY * dwWidth ) + dwX], dwCubeColor, 1 ) ? 0 : 1;
+		dwFailures += SoftRasterBenchmarkPixel( &eyeViewProjs[dwEye], &viewport, 0.0f, -1.0f, -3.0f, &dwX, &dwY ) &&
+			SoftRasterBenchmarkColor( pImage[( dwY * dwWidth ) + dwX], dwFloorColor, 1 ) ? 0 : 1;
+	}
+	memset( palettePresent, 0, sizeof( palettePresent ) );
+	dwSkinnedStart = FrameBuildDraws( &queue, &resources, &drawList, visible, visible, palettePresent, &vCenterEye, 0, RENDER_DRAW_DATA_ROOT_CONSTANTS, &drawBuffers );
+	target.pColor = pScratch;
+	dwFailures += SoftRasterRenderEye( &raster, &stream, &queue, &resources, &drawList, &eyeViewProjs[ovrEye_Left], &viewport, &scissorRect, visible, dwSkinnedStart, &target ) ? 0 : 1;
+	dwHandPixels = SoftRasterCompare( pScratch, pImages, dwNumPixels, 0, nullptr );
+	dwFailures += dwHandPixels > dwNumPixels / 200 && dwHandPixels < dwNumPixels / 4 ? 0 : 1;
+
+	//images out, and against the goldens
+	const char *pImageNames[ovrEye_Count] = { "BasicOVRBenchmark.left.png", "BasicOVRBenchmark.right.png" };
+	const char *pGoldenNames[ovrEye_Count] = { "BasicOVRBenchmark.left.golden.png", "BasicOVRBenchmark.right.golden.png" };
+	const char *pDiffNames[ovrEye_Count] = { "BasicOVRBenchmark.left.diff.png", "BasicOVRBenchmark.right.diff.png" };
+	u32 dwGoldenDifferent[ovrEye_Count] = { 0, 0 };
+	u32 dwNumGoldens = 0;
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		u32 *pImage = pImages + ( dwEye * dwNumPixels );
+		u32 dwReadWidth, dwReadHeight;
+		dwFailures += SoftRasterWritePng( pImageNames[dwEye], pImage, dwWidth, dwHeight ) ? 0 : 1;
+		u32 *pRead = SoftRasterReadPng( pImageNames[dwEye], &dwReadWidth, &dwReadHeight );
+		dwFailures += pRead && dwReadWidth == dwWidth && dwReadHeight == dwHeight && memcmp( pRead, pImage, dwNumPixels * sizeof( u32 ) ) == 0 ? 0 : 1;
+		free( pRead );
+		u32 *pGolden = SoftRasterReadPng( pGoldenNames[dwEye], &dwReadWidth, &dwReadHeight );
+		if( !pGolden )
+		{
+			printf( "Soft raster: %s is missing\n", pGoldenNames[dwEye] );
+			++dwFailures;
+			continue;
+		}
+		++dwNumGoldens;
+		dwGoldenDifferent[dwEye] = dwReadWidth == dwWidth && dwReadHeight == dwHeight ? SoftRasterCompare( pImage, pGolden, dwNumPixels, 2, pDiff ) : dwNumPixels;
+		if( dwGoldenDifferent[dwEye] )
+		{
+			SoftRasterWritePng( pDiffNames[dwEye], pDiff, dwWidth, dwHeight );
+		}
+		dwFailures += dwGoldenDifferent[dwEye] <= dwNumPixels / 1000 ? 0 : 1;
+		free( pGolden );
+	}
+
+	//timed, instanced with the draw data mode picked like the app submits
+	palettePresent[ovrHand_Left] = 1;
+	palettePresent[ovrHand_Right] = 1;
+	dwSkinnedStart = FrameBuildDraws( &queue, &resources, &drawList, visible, visible, palettePresent, &vCenterEye, 1, -1, &drawBuffers );
+	SoftRasterStats totals;
+	memset( &totals, 0, sizeof( SoftRasterStats ) );
+	QueryPerformanceCounter( &startCounter );
+	for( u32 dwIter = 0; dwIter < dwIterations; ++dwIter )
+	{
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			SoftRasterRenderEye( &raster, &stream, &queue, &resources, &drawList, &eyeViewProjs[dwEye], &viewport, &scissorRect, visible, dwSkinnedStart, &target );
+			totals.dwNumTriangles += raster.stats.dwNumTriangles;
+			totals.dwNumSetup += raster.stats.dwNumSetup;
+			totals.qwNumPixels += raster.stats.qwNumPixels;
+			totals.qwVertexTicks += raster.stats.qwVertexTicks;
+			totals.qwSetupTicks += raster.stats.qwSetupTicks;
+			totals.qwRasterTicks += raster.stats.qwRasterTicks;
+		}
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fMsPerTick = 1000.0 / (f64)frequency.QuadPart;
+	f64 fFrameMs = ( (f64)( endCounter.QuadPart - startCounter.QuadPart ) * fMsPerTick ) / dwIterations;
+	printf( "Soft raster: %ux%u per eye on %u threads, %.2fms per frame (vertex %.2fms, setup %.2fms, raster %.2fms), %.2fM triangles/s, %.1fM pixels/s\n",
+		dwWidth, dwHeight, pool.dwNumThreads + 1, fFrameMs, ( totals.qwVertexTicks * fMsPerTick ) / dwIterations, ( totals.qwSetupTicks * fMsPerTick ) / dwIterations,
+		( totals.qwRasterTicks * fMsPerTick ) / dwIterations, ( totals.dwNumTriangles / 1000.0 ) / ( fFrameMs * dwIterations ), ( totals.qwNumPixels / 1000.0 ) / ( fFrameMs * dwIterations ) );
+	printf( "Soft raster: %u triangles per frame, %u after clipping and culling, %u pixels shaded, configurations differ by up to %u pixels, hands cover %u, %u of %u goldens matched, %u failures\n",
+		totals.dwNumTriangles / dwIterations, totals.dwNumSetup / dwIterations, (u32)( totals.qwNumPixels / dwIterations ), dwMostDifferent, dwHandPixels,
+		dwNumGoldens - ( dwGoldenDifferent[0] > dwNumPixels / 1000 ? 1 : 0 ) - ( dwGoldenDifferent[1] > dwNumPixels / 1000 ? 1 : 0 ), dwNumGoldens, dwFailures );
+
+	DestroySoftRaster( &raster );
+	DestroyEntityStore( &store );
+	DestroySceneDrawList( &drawList );
+	DestroyRenderQueue( &queue );
+	DestroyRenderCommandStream( &stream );
+	DestroyWorkerPool( &serialPool );
+	DestroyWorkerPool( &pool );
+	free( pMemory );
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,333 @@
+//Compositor telemetry, ovr_GetPerfStats polled after every EndFrame, one compact sample per compositor frame
+//the cumulative counters (dropped frames, ASW frames) are stored as deltas so a sample shows what happened in that frame
+//release builds dump the ring as binary on exit for production logs, debug builds can also write csv
+//https://developer.oculus.com/documentation/native/pc/dg-hud/ (what the perf stats mean)
+
+#define TELEMETRY_RING_SIZE 4096 //needs to be a power of 2, ~45 seconds at 90hz
+#define TELEMETRY_FILE_MAGIC 0x5452564F //"OVRT"
+#define TELEMETRY_FILE_VERSION 1
+
+#define TELEMETRY_FLAG_ASW_ACTIVE 0x1
+#define TELEMETRY_FLAG_STATS_DROPPED 0x2 //we polled too slowly and the sdk threw some frames' stats away
+
+typedef struct TelemetrySample
+{
+	s32 dwHmdVsyncIndex;
+	s32 dwAppFrameIndex;
+	u16 wAppDroppedFrames; //since the previous sample
+	u16 wCompositorDroppedFrames;
+	u16 wAswPresentedFrames;
+	u16 wAswFailedFrames;
+	u8 bFlags;
+	u8 bVsyncsSkipped; //HmdVsyncIndex jumped by more than 1
+	u16 wAdaptiveGpuScale; //AdaptiveGpuPerformanceScale * 1000
+	f32 fAppMotionToPhotonMs;
+	f32 fAppCpuMs;
+	f32 fAppGpuMs;
+	f32 fAppQueueAheadMs;
+	f32 fCompositorLatencyMs;
+	f32 fCompositorGpuMs;
+	f32 fAppHeadroomMs; //frame budget - max(app cpu, app gpu), negative means the app is over budget
+} TelemetrySample;
+
+typedef struct TelemetryFileHeader
+{
+	u32 dwMagic;
+	u32 dwVersion;
+	u32 dwSampleSize;
+	u32 dwNumSamples;
+	f32 fFrameBudgetMs;
+} TelemetryFileHeader;
+
+typedef struct Telemetry
+{
+	TelemetrySample samples[TELEMETRY_RING_SIZE];
+	u64 qwHead; //total samples ever written, render thread only
+	f32 fFrameBudgetMs;
+	//last cumulative counters seen, for the deltas
+	s32 dwLastCompositorFrameIndex;
+	s32 dwLastHmdVsyncIndex;
+	s32 dwLastAppDroppedFrameCount;
+	s32 dwLastCompositorDroppedFrameCount;
+	s32 dwLastAswPresentedFrameCount;
+	s32 dwLastAswFailedFrameCount;
+	s32 dwLastAswActivatedToggleCount;
+	u8 bHaveLast;
+	//totals since startup
+	u64 qwTotalAppDroppedFrames;
+	u64 qwTotalCompositorDroppedFrames;
+	u64 qwTotalAswFrames;
+	u64 qwTotalAswToggles;
+} Telemetry;
+
+Telemetry telemetry;
+
+inline
+void InitTelemetry( f32 fDisplayRefreshRate )
+{
+	memset( &telemetry, 0, sizeof(Telemetry) );
+	telemetry.fFrameBudgetMs = 1000.0f / fDisplayRefreshRate;
+}
+
+//cumulative counter to a per sample delta, ovr_ResetPerfStats (or anything else restarting the counters) shows up as going backwards
+inline
+u16 TelemetryCounterDelta( s32 dwCount, s32 *a_pLastCount )
+{
+	s32 dwDelta = dwCount >= *a_pLastCount ? dwCount - *a_pLastCount : dwCount;
+	*a_pLastCount = dwCount;
+	return (u16)( dwDelta > 0xFFFF ? 0xFFFF : dwDelta );
+}
+
+inline
+void TelemetryAddFrame( ovrPerfStatsPerCompositorFrame *a_pFrame, u8 bStatsDropped )
+{
+	if( telemetry.bHaveLast && a_pFrame->CompositorFrameIndex == telemetry.dwLastCompositorFrameIndex )
+	{
+		return; //already have it
+	}
+	if( !telemetry.bHaveLast )
+	{
+		//first frame, nothing to diff against so it starts from zero
+		telemetry.dwLastHmdVsyncIndex = a_pFrame->HmdVsyncIndex - 1;
+		telemetry.dwLastAppDroppedFrameCount = a_pFrame->AppDroppedFrameCount;
+		telemetry.dwLastCompositorDroppedFrameCount = a_pFrame->CompositorDroppedFrameCount;
+		telemetry.dwLastAswPresentedFrameCount = a_pFrame->AswPresentedFrameCount;
+		telemetry.dwLastAswFailedFrameCount = a_pFrame->AswFailedFrameCount;
+		telemetry.dwLastAswActivatedToggleCount = a_pFrame->AswActivatedToggleCount;
+		telemetry.bHaveLast = 1;
+	}
+	telemetry.dwLastCompositorFrameIndex = a_pFrame->CompositorFrameIndex;
+
+	TelemetrySample *pSample = &telemetry.samples[telemetry.qwHead & ( TELEMETRY_RING_SIZE - 1 )];
+	pSample->dwHmdVsyncIndex = a_pFrame->HmdVsyncIndex;
+	pSample->dwAppFrameIndex = a_pFrame->AppFrameIndex;
+	pSample->wAppDroppedFrames = TelemetryCounterDelta( a_pFrame->AppDroppedFrameCount, &telemetry.dwLastAppDroppedFrameCount );
+	pSample->wCompositorDroppedFrames = TelemetryCounterDelta( a_pFrame->CompositorDroppedFrameCount, &telemetry.dwLastCompositorDroppedFrameCount );
+	pSample->wAswPresentedFrames = TelemetryCounterDelta( a_pFrame->AswPresentedFrameCount, &telemetry.dwLastAswPresentedFrameCount );
+	pSample->wAswFailedFrames = TelemetryCounterDelta( a_pFrame->AswFailedFrameCount, &telemetry.dwLastAswFailedFrameCount );
+	u16 wAswToggles = TelemetryCounterDelta( a_pFrame->AswActivatedToggleCount, &telemetry.dwLastAswActivatedToggleCount );
+	s32 dwVsyncs = a_pFrame->HmdVsyncIndex - telemetry.dwLastHmdVsyncIndex;
+	telemetry.dwLastHmdVsyncIndex = a_pFrame->HmdVsyncIndex;
+	pSample->bVsyncsSkipped = (u8)( dwVsyncs > 1 ? ( dwVsyncs > 256 ? 255 : dwVsyncs - 1 ) : 0 );
+	pSample->bFlags = ( a_pFrame->AswIsActive ? TELEMETRY_FLAG_ASW_ACTIVE : 0 ) | ( bStatsDropped ? TELEMETRY_FLAG_STATS_DROPPED : 0 );
+	pSample->fAppMotionToPhotonMs = a_pFrame->AppMotionToPhotonLatency * 1000.0f;
+	pSample->fAppCpuMs = a_pFrame->AppCpuElapsedTime * 1000.0f;
+	pSample->fAppGpuMs = a_pFrame->AppGpuElapsedTime * 1000.0f;
+	pSample->fAppQueueAheadMs = a_pFrame->AppQueueAheadTime * 1000.0f;
+	pSample->fCompositorLatencyMs = a_pFrame->CompositorLatency * 1000.0f;
+	pSample->fCompositorGpuMs = a_pFrame->CompositorGpuElapsedTime * 1000.0f;
+	f32 fAppBusyMs = pSample->fAppCpuMs > pSample->fAppGpuMs ? pSample->fAppCpuMs : pSample->fAppGpuMs;
+	pSample->fAppHeadroomMs = telemetry.fFrameBudgetMs - fAppBusyMs;
+	pSample->wAdaptiveGpuScale = 1000; //filled in by TelemetryProcessPerfStats, it is per poll not per frame
+	++telemetry.qwHead;
+
+	telemetry.qwTotalAppDroppedFrames += pSample->wAppDroppedFrames;
+	telemetry.qwTotalCompositorDroppedFrames += pSample->wCompositorDroppedFrames;
+	telemetry.qwTotalAswFrames += pSample->wAswPresentedFrames;
+	telemetry.qwTotalAswToggles += wAswToggles;
+}
+
+//FrameStats comes newest first, add them oldest first
+inline
+void TelemetryProcessPerfStats( ovrPerfStats *a_pStats )
+{
+	for( s32 dwFrame = a_pStats->FrameStatsCount - 1; dwFrame >= 0; --dwFrame )
+	{
+		TelemetryAddFrame( &a_pStats->FrameStats[dwFrame], a_pStats->AnyFrameStatsDropped ? 1 : 0 );
+	}
+	if( a_pStats->FrameStatsCount > 0 )
+	{
+		f32 fScale = a_pStats->AdaptiveGpuPerformanceScale * 1000.0f;
+		telemetry.samples[( telemetry.qwHead - 1 ) & ( TELEMETRY_RING_SIZE - 1 )].wAdaptiveGpuScale = (u16)( fScale < 0.0f ? 0.0f : ( fScale > 65535.0f ? 65535.0f : fScale ) );
+	}
+}
+
+//render thread, after ovr_EndFrame
+inline
+void PollTelemetry()
+{
+	ovrPerfStats perfStats;
+	if( OVR_SUCCESS( ovr_GetPerfStats( oculusSession, &perfStats ) ) )
+	{
+		TelemetryProcessPerfStats( &perfStats );
+	}
+}
+
+inline
+u32 TelemetryNumSamples()
+{
+	return telemetry.qwHead < TELEMETRY_RING_SIZE ? (u32)telemetry.qwHead : TELEMETRY_RING_SIZE;
+}
+
+inline
+TelemetrySample* TelemetryGetSample( u32 dwIdx ) //0 is the oldest still in the ring
+{
+	u64 qwFirst = telemetry.qwHead - TelemetryNumSamples();
+	return &telemetry.samples[( qwFirst + dwIdx ) & ( TELEMETRY_RING_SIZE - 1 )];
+}
+
+//header then the samples oldest first, no crt needed so release builds can write it
+inline
+bool TelemetryWriteBinary( const char *pFileName )
+{
+	HANDLE hFile = CreateFileA( pFileName, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( hFile == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+	TelemetryFileHeader header;
+	header.dwMagic = TELEMETRY_FILE_MAGIC;
+	header.dwVersion = TELEMETRY_FILE_VERSION;
+	header.dwSampleSize = sizeof(TelemetrySample);
+	header.dwNumSamples = TelemetryNumSamples();
+	header.fFrameBudgetMs = telemetry.fFrameBudgetMs;
+	DWORD dwWritten;
+	bool bSuccess = WriteFile( hFile, &header, sizeof(header), &dwWritten, nullptr ) != 0;
+	//the ring wraps at most once, so it is at most 2 writes
+	u32 dwFirst = (u32)( ( telemetry.qwHead - header.dwNumSamples ) & ( TELEMETRY_RING_SIZE - 1 ) );
+	u32 dwFirstRun = header.dwNumSamples < ( TELEMETRY_RING_SIZE - dwFirst ) ? header.dwNumSamples : TELEMETRY_RING_SIZE - dwFirst;
+	bSuccess = bSuccess && WriteFile( hFile, &telemetry.samples[dwFirst], dwFirstRun * sizeof(TelemetrySample), &dwWritten, nullptr ) != 0;
+	if( header.dwNumSamples > dwFirstRun )
+	{
+		bSuccess = bSuccess && WriteFile( hFile, &telemetry.samples[0], ( header.dwNumSamples - dwFirstRun ) * sizeof(TelemetrySample), &dwWritten, nullptr ) != 0;
+	}
+	CloseHandle( hFile );
+	return bSuccess;
+}
+
+#if MAIN_DEBUG
+inline
+bool TelemetryWriteCsv( const char *pFileName )
+{
+	FILE *pFile;
+	if( fopen_s( &pFile, pFileName, "w" ) != 0 )
+	{
+		return false;
+	}
+	fprintf( pFile, "vsync,app_frame,app_dropped,compositor_dropped,vsyncs_skipped,asw_active,asw_presented,asw_failed,stats_dropped,app_motion_to_photon_ms,app_cpu_ms,app_gpu_ms,app_queue_ahead_ms,app_headroom_ms,compositor_latency_ms,compositor_gpu_ms,adaptive_gpu_scale\n" );
+	u32 dwNumSamples = TelemetryNumSamples();
+	for( u32 dwSample = 0; dwSample < dwNumSamples; ++dwSample )
+	{
+		TelemetrySample *pSample = TelemetryGetSample( dwSample );
+		fprintf( pFile, "%d,%d,%u,%u,%u,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n", pSample->dwHmdVsyncIndex, pSample->dwAppFrameIndex,
+			pSample->wAppDroppedFrames, pSample->wCompositorDroppedFrames, pSample->bVsyncsSkipped, ( pSample->bFlags & TELEMETRY_FLAG_ASW_ACTIVE ) ? 1 : 0,
+			pSample->wAswPresentedFrames, pSample->wAswFailedFrames, ( pSample->bFlags & TELEMETRY_FLAG_STATS_DROPPED ) ? 1 : 0,
+			pSample->fAppMotionToPhotonMs, pSample->fAppCpuMs, pSample->fAppGpuMs, pSample->fAppQueueAheadMs, pSample->fAppHeadroomMs,
+			pSample->fCompositorLatencyMs, pSample->fCompositorGpuMs, pSample->wAdaptiveGpuScale / 1000.0f );
+	}
+	fclose( pFile );
+	return true;
+}
+
+//summary over what is still in the ring plus the totals since startup
+inline
+void TelemetryPrintReport()
+{
+	u32 dwNumSamples = TelemetryNumSamples();
+	if( dwNumSamples == 0 )
+	{
+		return;
+	}
+	f64 fSumLatencyMs = 0.0, fSumHeadroomMs = 0.0;
+	f32 fMinHeadroomMs = telemetry.fFrameBudgetMs;
+	u32 dwAswFrames = 0;
+	for( u32 dwSample = 0; dwSample < dwNumSamples; ++dwSample )
+	{
+		TelemetrySample *pSample = TelemetryGetSample( dwSample );
+		fSumLatencyMs += pSample->fAppMotionToPhotonMs;
+		fSumHeadroomMs += pSample->fAppHeadroomMs;
+		fMinHeadroomMs = pSample->fAppHeadroomMs < fMinHeadroomMs ? pSample->fAppHeadroomMs : fMinHeadroomMs;
+		dwAswFrames += ( pSample->bFlags & TELEMETRY_FLAG_ASW_ACTIVE ) ? 1 : 0;
+	}
+	printf( "compositor: %u frames, app motion to photon %.2fms, headroom avg %.2fms min %.2fms, asw active %.1f%%\n", dwNumSamples, fSumLatencyMs / dwNumSamples, fSumHeadroomMs / dwNumSamples, fMinHeadroomMs, ( 100.0 * dwAswFrames ) / dwNumSamples );
+	printf( "compositor totals: app dropped %llu, compositor dropped %llu, asw frames %llu, asw toggles %llu\n", (unsigned long long)telemetry.qwTotalAppDroppedFrames, (unsigned long long)telemetry.qwTotalCompositorDroppedFrames, (unsigned long long)telemetry.qwTotalAswFrames, (unsigned long long)telemetry.qwTotalAswToggles );
+}
+#endif
+
+#if BENCHMARK_MODE
+//stand in for the compositor: a 90hz session that drops an app frame every 100 frames and goes into ASW for a while under "load"
+inline
+void TelemetrySyntheticPerfStats( ovrPerfStats *a_pStats, u32 dwPoll, ovrPerfStatsPerCompositorFrame *a_pState )
+{
+	memset( a_pStats, 0, sizeof(ovrPerfStats) );
+	u32 dwFramesThisPoll = ( dwPoll % 50 ) == 49 ? 3 : 1; //the app hitched, the sdk hands us several frames at once
+	for( u32 dwFrame = 0; dwFrame < dwFramesThisPoll; ++dwFrame )
+	{
+		++a_pState->CompositorFrameIndex;
+		++a_pState->HmdVsyncIndex;
+		u8 bUnderLoad = ( a_pState->CompositorFrameIndex % 900 ) >= 600;
+		if( ( a_pState->CompositorFrameIndex % 100 ) == 0 )
+		{
+			++a_pState->AppDroppedFrameCount;
+		}
+		else
+		{
+			++a_pState->AppFrameIndex;
+		}
+		if( bUnderLoad && !a_pState->AswIsActive )
+		{
+			++a_pState->AswActivatedToggleCount;
+		}
+		a_pState->AswIsActive = bUnderLoad;
+		a_pState->AswPresentedFrameCount += bUnderLoad ? 1 : 0;
+		a_pState->AppMotionToPhotonLatency = 0.030f;
+		a_pState->AppCpuElapsedTime = 0.004f;
+		a_pState->AppGpuElapsedTime = bUnderLoad ? 0.013f : 0.008f;
+		a_pState->AppQueueAheadTime = 0.0f;
+		a_pState->CompositorLatency = 0.002f;
+		a_pState->CompositorGpuElapsedTime = 0.0008f;
+		//newest first
+		memmove( &a_pStats->FrameStats[1], &a_pStats->FrameStats[0], sizeof(ovrPerfStatsPerCompositorFrame) * ( ovrMaxProvidedFrameStats - 1 ) );
+		a_pStats->FrameStats[0] = *a_pState;
+	}
+	a_pStats->FrameStatsCount = dwFramesThisPoll;
+	a_pStats->AdaptiveGpuPerformanceScale = a_pState->AswIsActive ? 0.8f : 1.0f;
+	a_pStats->AswIsAvailable = ovrTrue;
+}
+
+u32 BenchmarkTelemetry()
+{
+	InitTelemetry( 90.0f );
+	ovrPerfStatsPerCompositorFrame state;
+	memset( &state, 0, sizeof(state) );
+	ovrPerfStats stats;
+	LARGE_INTEGER startCounter, endCounter, PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	QueryPerformanceCounter( &startCounter );
+	u32 dwNumPolls = 0;
+	while( state.CompositorFrameIndex < 2700 ) //30 seconds
+	{
+		TelemetrySyntheticPerfStats( &stats, dwNumPolls++, &state );
+		TelemetryProcessPerfStats( &stats );
+	}
+	QueryPerformanceCounter( &endCounter );
+	f64 fUsPerPoll = ( 1000000.0 * ( endCounter.QuadPart - startCounter.QuadPart ) ) / ( (f64)PerfCountFrequency.QuadPart * dwNumPolls );
+	TelemetryPrintReport();
+
+	//30 seconds of the synthetic compositor: a drop every 100 frames, ASW on for the last 300 of every 900
+	u32 dwFailures = 0;
+	dwFailures += telemetry.qwHead == (u64)state.CompositorFrameIndex ? 0 : 1; //hitched polls hand over 3 frames, none may get lost
+	dwFailures += telemetry.qwTotalAppDroppedFrames == 27 ? 0 : 1;
+	dwFailures += telemetry.qwTotalAswToggles == 3 ? 0 : 1;
+	dwFailures += telemetry.qwTotalAswFrames == 900 ? 0 : 1;
+	u32 dwRingDropped = 0, dwRingAsw = 0, dwRingOverBudget = 0;
+	for( u32 dwSample = 0; dwSample < TelemetryNumSamples(); ++dwSample )
+	{
+		TelemetrySample *pSample = TelemetryGetSample( dwSample );
+		dwRingDropped += pSample->wAppDroppedFrames;
+		dwRingAsw += ( pSample->bFlags & TELEMETRY_FLAG_ASW_ACTIVE ) ? 1 : 0;
+		dwRingOverBudget += pSample->fAppHeadroomMs < 0.0f ? 1 : 0;
+		dwFailures += pSample->bVsyncsSkipped == 0 ? 0 : 1;
+	}
+	//the deltas in the ring have to add back up to the totals, and only the 13ms ASW frames are over the 11.1ms budget
+	dwFailures += dwRingDropped == telemetry.qwTotalAppDroppedFrames ? 0 : 1;
+	dwFailures += dwRingAsw == 900 && dwRingOverBudget == 900 ? 0 : 1;
+	printf( "Telemetry: %.3fus per poll, app dropped %llu (27 expected) asw toggles %llu (3 expected), %u bytes per sample, %u failures\n",
+		fUsPerPoll, (unsigned long long)telemetry.qwTotalAppDroppedFrames, (unsigned long long)telemetry.qwTotalAswToggles, (u32)sizeof(TelemetrySample), dwFailures );
+	if( TelemetryWriteCsv( "BasicOVRBenchmark.telemetry.csv" ) && TelemetryWriteBinary( "BasicOVRBenchmark.telemetry.bin" ) )
+	{
+		printf( "Telemetry: wrote BasicOVRBenchmark.telemetry.csv and .bin\n" );
+	}
+	return dwFailures;
+}
+#endif
@@ -0,0 +1,322 @@
+//Tests, the CPU side of the modules built on their own and run, built and run by Compile.bat before the app
+//plain C++ so it also builds where there's no Windows SDK or LibOVR runtime, e.g. "g++ -O2 -pthread -DMAX_BONES=32 -IlibOVR/Include Tests.cpp -o Tests && ./Tests"
+//once MeshSimplify has written modelLods.h ("g++ -O2 MeshSimplify.cpp -o MeshSimplify && ./MeshSimplify modelLods.h"), run from the repo so the goldens are found
+//Platform.h stands in for windows.h and NullD3D12.h for d3d12.h, so the modules are the app's own code and go through the same paths,
+//LibOVR's header is the one in the repo but nothing calls into it
+//runs each module's benchmark plus the tests below that need the null device, exits with 1 if any of their checks failed
+
+#ifndef MAIN_DEBUG
+#define MAIN_DEBUG 1 //the reports print the numbers the checks are made on
+#endif
+#ifndef BENCHMARK_MODE
+#define BENCHMARK_MODE 1
+#endif
+#ifndef REVERSE_Z
+#define REVERSE_Z 1
+#endif
+#ifndef AVX_ACTIVE
+#define AVX_ACTIVE 0 //-DAVX_ACTIVE=1 -mavx2 -mf16c for the AVX2 paths
+#endif
+
+#include "Platform.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include "OVR_CAPI.h" //only its types, nothing here calls into the runtime so LibOVR.lib isn't linked
+
+#include "VecMath.h"
+
+typedef struct vertexShaderCB
+{
+	Mat4f mvpMat;
+	Mat3x4f nMat;
+} vertexShaderCB;
+
+typedef struct pixelShaderCB
+{
+	Vec4f vLightColor;
+	Vec3f vInvLightDir;
+} pixelShaderCB;
+
+#include "Models.h"
+#include "ShaderPermutations.h"
+#include "NullD3D12.h"
+#include "MeshLod.h"
+#include "modelLods.h"
+#include "MeshIndices.h"
+
+//the app's globals and helpers the modules use, there's no session so the HMD desc and viewports stay zero
+ovrSession oculusSession;
+ovrHmdDesc oculusHMDDesc;
+ovrRecti oculusEyeRenderViewport[ovrEye_Count];
+ID3D12Device *device;
+ID3D12CommandQueue *commandQueue;
+ID3D12GraphicsCommandList *commandLists[ovrEye_Count+1];
+
+int logError( const char *msg )
+{
+	printf( "%s", msg );
+	return -1;
+}
+
+#define MAIN_VB_SLOT 0
+#define INSTANCE_VB_SLOT 1
+#define VERTEX_CB_ROOT_SLOT 0
+#define PIXEL_CB_ROOT_SLOT 1
+#define VERTEX_SB_ROOT_SLOT 2
+#define VERTEX_DRAW_CBV_ROOT_SLOT 3
+
+#include "IK.h"
+#include "InputPrediction.h"
+#include "Profiler.h"
+#include "Workers.h"
+#include "Scene.h"
+#include "GpuTimer.h"
+#include "Telemetry.h"
+#include "DynamicResolution.h"
+#include "DepthLayer.h"
+#include "Culling.h"
+#include "Bvh.h"
+#include "RenderQueue.h"
+#include "IndirectDraw.h"
+#include "Meshlets.h"
+#include "Foveation.h"
+#include "PipelineCache.h"
+#include "FrameRender.h"
+#include "SoftRaster.h"
+
+//GpuTimer end to end on the null device: every pass's queries go into each eye's command list, get resolved into the readback ring
+//and are read back once the fence passes them. the GPU stalls for a few frames in the middle so every slot is pending and frames go untimed
+u32 TestGpuTimerNullDevice()
+{
+	ID3D12Device nullDevice;
+	ID3D12CommandQueue nullQueue;
+	nullQueue.qwTimestampFrequency = 10000000; //10MHz, a common GPU timestamp rate
+	nullQueue.qwTimestamp = 5000000000;
+	device = &nullDevice;
+	commandQueue = &nullQueue;
+	ID3D12GraphicsCommandList commandList;
+	u32 dwFailures = InitGpuTimer() ? 0 : 1;
+	if( dwFailures )
+	{
+		printf( "GPU timer (null device): init failed\n" );
+		return dwFailures;
+	}
+
+	const u64 qwPassTicks[GPU_PASS_COUNT] = { 0, 500, 1800, 4000 }; //the eye pass is the sum of the others plus a barrier either side
+	const u32 dwStallBegin = 20, dwStallEnd = 30; //GPU_TIMER_FRAMES of frames get recorded into the stall, the rest of it goes untimed
+	u64 qwLeftHandsTicks = 0, qwFrameTicks = 0, qwTagHandsTicks[2] = { 0, 0 };
+	u32 dwTagFrames[2] = { 0, 0 };
+	u32 dwTimed = 0, dwUntimed = 0, dwUntimedOutsideStall = 0;
+	u64 qwStalledFenceValue = 0;
+	for( u32 dwFrame = 0; dwTimed < GPU_TIMER_AVG_FRAMES; ++dwFrame )
+	{
+		if( dwFrame == dwStallEnd )
+		{
+			gpuTimer.pFence->qwCompletedValue = gpuTimer.qwFenceValue; //the GPU catches up
+		}
+		gpuTimer.dwFrameTag = dwFrame & 1;
+		GpuTimerBeginFrame( dwFrame );
+		if( gpuTimer.dwWriteSlot == GPU_TIMER_FRAMES )
+		{
+			++dwUntimed;
+			dwUntimedOutsideStall += dwFrame < dwStallBegin + GPU_TIMER_FRAMES || dwFrame >= dwStallEnd ? 1 : 0;
+			continue;
+		}
+		u64 qwFrameBegin = nullQueue.qwTimestamp;
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			commandList.qwTimestamp = nullQueue.qwTimestamp;
+			GpuTimerQuery( &commandList, dwEye, GPU_PASS_EYE, 0 );
+			commandList.qwTimestamp += 20;
+			for( u32 dwPass = GPU_PASS_CLEAR; dwPass < GPU_PASS_COUNT; ++dwPass )
+			{
+				u64 qwTicks = qwPassTicks[dwPass] + ( dwFrame % 3 ) + ( dwPass == GPU_PASS_HANDS ? ( dwFrame & 1 ) * 100 : 0 ); //odd frames are the B side
+				GpuTimerQuery( &commandList, dwEye, dwPass, 0 );
+				commandList.qwTimestamp += qwTicks;
+				GpuTimerQuery( &commandList, dwEye, dwPass, 1 );
+				qwLeftHandsTicks += dwEye == ovrEye_Left && dwPass == GPU_PASS_HANDS ? qwTicks : 0;
+				qwTagHandsTicks[dwFrame & 1] += dwPass == GPU_PASS_HANDS ? qwTicks : 0;
+			}
+			commandList.qwTimestamp += 20;
+			GpuTimerQuery( &commandList, dwEye, GPU_PASS_EYE, 1 );
+			GpuTimerResolve( &commandList, dwEye );
+			nullQueue.qwTimestamp = commandList.qwTimestamp;
+		}
+		GpuTimerEndFrame();
+		qwFrameTicks += nullQueue.qwTimestamp - qwFrameBegin;
+		++dwTagFrames[dwFrame & 1];
+		++dwTimed;
+		nullQueue.qwTimestamp += 111111 - ( nullQueue.qwTimestamp - qwFrameBegin ); //rest of an 11.1ms frame
+
+		//the null queue is done the moment it's signaled, hold the fence back to stall it
+		if( dwFrame == dwStallBegin )
+		{
+			qwStalledFenceValue = gpuTimer.qwFenceValue - 1;
+		}
+		if( dwFrame >= dwStallBegin && dwFrame < dwStallEnd )
+		{
+			gpuTimer.pFence->qwCompletedValue = qwStalledFenceValue;
+		}
+	}
+	GpuTimerBeginFrame( 1000 ); //reads back the last frame
+
+	f64 fUsPerTick = 1000000.0 / (f64)nullQueue.qwTimestampFrequency;
+	f64 fExpectedLeftHandsUs = ( qwLeftHandsTicks * fUsPerTick ) / GPU_TIMER_AVG_FRAMES;
+	f64 fExpectedFrameUs = ( qwFrameTicks * fUsPerTick ) / GPU_TIMER_AVG_FRAMES;
+	f64 fExpectedTagHandsUs[2] = { ( qwTagHandsTicks[0] * fUsPerTick ) / dwTagFrames[0], ( qwTagHandsTicks[1] * fUsPerTick ) / dwTagFrames[1] };
+	dwFailures += gpuTimer.qwNumFramesProcessed == GPU_TIMER_AVG_FRAMES ? 0 : 1;
+	dwFailures += dwUntimed == dwStallEnd - dwStallBegin - GPU_TIMER_FRAMES && !dwUntimedOutsideStall ? 0 : 1;
+	dwFailures += fabs( gpuTimer.fAvgPassUs[ovrEye_Left][GPU_PASS_HANDS] - fExpectedLeftHandsUs ) < 0.01 ? 0 : 1;
+	dwFailures += fabs( gpuTimer.fAvgFrameUs - fExpectedFrameUs ) < 0.01 ? 0 : 1;
+	for( u32 dwTag = 0; dwTag < 2; ++dwTag )
+	{
+		dwFailures += gpuTimer.dwAvgTagFrames[dwTag] == dwTagFrames[dwTag] ? 0 : 1;
+		dwFailures += fabs( gpuTimer.fAvgTagPassUs[dwTag][GPU_PASS_HANDS] - fExpectedTagHandsUs[dwTag] ) < 0.01 ? 0 : 1;
+	}
+	printf( "GPU timer (null device): %u frames read back, %u untimed in the stall, left hands %.1fus (%.1fus expected), frame %.1fus (%.1fus expected), %u failures\n",
+		(u32)gpuTimer.qwNumFramesProcessed, dwUntimed, gpuTimer.fAvgPassUs[ovrEye_Left][GPU_PASS_HANDS], fExpectedLeftHandsUs, gpuTimer.fAvgFrameUs, fExpectedFrameUs, dwFailures );
+
+	gpuTimer.pQueryHeap->Release();
+	gpuTimer.pReadbackBuffer->Release();
+	gpuTimer.pFence->Release();
+	device = nullptr;
+	commandQueue = nullptr;
+	return dwFailures;
+}
+
+//stands in for the archive ShaderPack writes from the compiled permutations, a different blob for every key
+u32 TestShaderPermutations()
+{
+	u32 keys[SKIN_PERMUTATION_COUNT];
+	ShaderBlob blobs[SKIN_PERMUTATION_COUNT];
+	for( u32 dwKey = 0; dwKey < SKIN_PERMUTATION_COUNT; ++dwKey )
+	{
+		keys[dwKey] = 0xc0de0000 | dwKey;
+		blobs[dwKey].pData = &keys[dwKey];
+		blobs[dwKey].dwSize = sizeof( keys[0] );
+	}
+	u32 dwArchiveSize = ShaderArchiveWrite( blobs, SKIN_PERMUTATION_COUNT, nullptr );
+	u8 *pArchive = (u8*)malloc( dwArchiveSize );
+	if( !pArchive )
+	{
+		printf( "Shader permutations: out of memory\n" );
+		return 1;
+	}
+	ShaderArchiveWrite( blobs, SKIN_PERMUTATION_COUNT, pArchive );
+	u32 dwFailures = BenchmarkShaderPermutations( pArchive, dwArchiveSize );
+	free( pArchive );
+	return dwFailures;
+}
+
+//PipelineCache across three launches on the null device: the first compiles everything and writes the file, the second loads it all from
+//the library the file recreates, the third finds a file whose checks pass but that the driver won't take and falls back to compiling
+u32 TestPipelineCacheNullDevice()
+{
+	const char *pFileName = "Tests.pipelines.bin";
+	u8 vertexBytecode[256], pixelBytecode[128], rootSignatureBlob[32];
+	for( u32 dwByte = 0; dwByte < sizeof( vertexBytecode ); ++dwByte )
+	{
+		vertexBytecode[dwByte] = (u8)( dwByte * 7 );
+		pixelBytecode[dwByte & ( sizeof( pixelBytecode ) - 1 )] = (u8)( dwByte * 13 );
+		rootSignatureBlob[dwByte & ( sizeof( rootSignatureBlob ) - 1 )] = (u8)( dwByte * 31 );
+	}
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsDescs[2];
+	memset( graphicsDescs, 0, sizeof( graphicsDescs ) );
+	graphicsDescs[0].VS.pShaderBytecode = vertexBytecode;
+	graphicsDescs[0].VS.BytecodeLength = sizeof( vertexBytecode );
+	graphicsDescs[0].PS.pShaderBytecode = pixelBytecode;
+	graphicsDescs[0].PS.BytecodeLength = sizeof( pixelBytecode );
+	graphicsDescs[0].DepthStencilState.DepthFunc = EYE_DEPTH_FUNC;
+	graphicsDescs[1] = graphicsDescs[0];
+	graphicsDescs[1].RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	D3D12_COMPUTE_PIPELINE_STATE_DESC computeDesc;
+	memset( &computeDesc, 0, sizeof( computeDesc ) );
+	computeDesc.CS = graphicsDescs[0].PS;
+
+	WorkerPool pool;
+	PipelineCache *pCache = (PipelineCache*)malloc( sizeof( PipelineCache ) );
+	if( !pCache || !InitWorkerPool( &pool, 2 ) )
+	{
+		printf( "Pipeline cache (null device): out of memory\n" );
+		free( pCache );
+		return 1;
+	}
+	remove( pFileName );
+	u32 dwFailures = 0;
+	const u32 dwNumPipelines = 3;
+	for( u32 dwLaunch = 0; dwLaunch < 3; ++dwLaunch )
+	{
+		if( dwLaunch == 2 )
+		{
+			u8 foreignLibrary[64]; //intact as a file, but not a library this driver wrote
+			memset( foreignLibrary, 0xab, sizeof( foreignLibrary ) );
+			dwFailures += PipelineCacheWriteFile( pFileName, foreignLibrary, sizeof( foreignLibrary ) ) ? 0 : 1;
+		}
+		ID3D12Device1 nullDevice;
+		InitPipelineCache( pCache, &nullDevice, pFileName );
+		ID3D12PipelineState *pipelines[dwNumPipelines];
+		PipelineCacheAddGraphics( pCache, &graphicsDescs[0], rootSignatureBlob, sizeof( rootSignatureBlob ), &pipelines[0], "base" );
+		PipelineCacheAddGraphics( pCache, &graphicsDescs[1], rootSignatureBlob, sizeof( rootSignatureBlob ), &pipelines[1], "no cull" );
+		PipelineCacheAddCompute( pCache, &computeDesc, rootSignatureBlob, sizeof( rootSignatureBlob ), &pipelines[2], "compute" );
+		dwFailures += PipelineCacheBuild( pCache, &pool ) ? 0 : 1;
+		dwFailures += pCache->pLibrary ? 0 : 1;
+		dwFailures += pCache->dwNumLoaded == ( dwLaunch == 1 ? dwNumPipelines : 0 ) ? 0 : 1;
+		dwFailures += pCache->dwNumCompiled == ( dwLaunch == 1 ? 0 : dwNumPipelines ) ? 0 : 1;
+		dwFailures += pCache->bFileRejected == ( dwLaunch == 2 ? 1 : 0 ) ? 0 : 1;
+		dwFailures += pCache->bDirty == ( dwLaunch == 1 ? 0 : 1 ) ? 0 : 1;
+		dwFailures += PipelineCacheSave( pCache, pFileName ) && !pCache->bDirty ? 0 : 1;
+		for( u32 dwPipeline = 0; dwPipeline < dwNumPipelines; ++dwPipeline )
+		{
+			dwFailures += pipelines[dwPipeline] ? 0 : 1;
+			if( pipelines[dwPipeline] )
+			{
+				pipelines[dwPipeline]->Release();
+			}
+		}
+		printf( "Pipeline cache (null device) launch %u: %u loaded %u compiled%s\n", dwLaunch, pCache->dwNumLoaded, pCache->dwNumCompiled, pCache->bFileRejected ? ", cache file rejected" : "" );
+		DestroyPipelineCache( pCache );
+	}
+	DestroyWorkerPool( &pool );
+	free( pCache );
+	remove( pFileName );
+	printf( "Pipeline cache (null device): %u failures\n", dwFailures );
+	return dwFailures;
+}
+
+int main()
+{
+	InitProfiler();
+	u32 dwFailures = 0;
+	dwFailures += BenchmarkIK();
+	dwFailures += BenchmarkInputPrediction();
+	dwFailures += TestGpuTimerNullDevice();
+	dwFailures += BenchmarkGpuTimer();
+	dwFailures += BenchmarkTelemetry();
+	dwFailures += BenchmarkDynamicResolution();
+	dwFailures += BenchmarkDepthLayer();
+	dwFailures += BenchmarkDepthPrecision();
+	dwFailures += BenchmarkCulling();
+	dwFailures += BenchmarkBvh();
+	dwFailures += BenchmarkEntityStore();
+	dwFailures += BenchmarkTransformHierarchy();
+	dwFailures += BenchmarkRenderQueue();
+	dwFailures += BenchmarkDrawData();
+	dwFailures += BenchmarkIndirectDraw();
+	dwFailures += TestShaderPermutations();
+	dwFailures += BenchmarkMeshIndices();
+	dwFailures += BenchmarkMeshLod();
+	dwFailures += BenchmarkMeshlets();
+	dwFailures += BenchmarkFoveation();
+	dwFailures += TestPipelineCacheNullDevice();
+	dwFailures += BenchmarkPipelineCache();
+	dwFailures += BenchmarkSoftRaster();
+	printf( "Tests: %u failures\n", dwFailures );
+	return dwFailures ? 1 : 0;
+}
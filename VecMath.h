@@ -0,0 +1,631 @@
+//Math types and functions, everything here is plain C++ so the tools and Tests.cpp can include it without windows.h, d3d12 or LibOVR
+//matrices are row vector (v * M) like DirectX's, quaternions are w x y z
+
+#include <stdint.h>
+#include <math.h>
+
+#define PI_F 3.1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679f
+#define PI_D 3.1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+typedef float    f32; //floating 32
+typedef double   f64; //floating 64
+
+typedef struct Mat3f
+{
+	union
+	{
+		f32 m[3][3];
+	};
+} Mat3f;
+
+typedef struct Mat4f
+{
+	union
+	{
+		f32 m[4][4];
+	};
+} Mat4f;
+
+typedef struct Mat3x4f
+{
+	union
+	{
+		f32 m[3][4];
+	};
+} Mat3x4f;
+
+typedef struct Vec2f
+{
+	union
+	{
+		f32 v[2];
+		struct
+		{
+			f32 x;
+			f32 y;
+		};
+	};
+} Vec2f;
+
+typedef struct Vec3f
+{
+	union
+	{
+		f32 v[3];
+		struct
+		{
+			f32 x;
+			f32 y;
+			f32 z;
+		};
+	};
+} Vec3f;
+
+typedef struct Vec4f
+{
+	union
+	{
+		f32 v[4];
+		struct
+		{
+			f32 x;
+			f32 y;
+			f32 z;
+			f32 w;
+		};
+	};
+} Vec4f;
+
+typedef struct Quatf
+{
+	union
+	{
+		f32 q[4];
+		struct
+		{
+			f32 w; //real
+			f32 x;
+			f32 y;
+			f32 z;
+		};
+		struct
+		{
+			f32 r; //real;
+			Vec3f v;
+		};
+	};
+} Quatf;
+
+typedef struct Bone
+{
+	Quatf qLocalRot;
+	Vec3f vLocalTrans;
+	Vec3f vScale;
+} Bone;
+
+typedef struct KeyFrame
+{
+	Quatf qRot;
+	Vec3f vPos;
+} KeyFrame;
+
+inline
+void InitMat3f( Mat3f *a_pMat )
+{
+	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0; a_pMat->m[0][2] = 0;
+	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0;
+	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = 0; a_pMat->m[2][2] = 1;
+}
+
+inline
+void InitMat4f( Mat4f *a_pMat )
+{
+	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0; a_pMat->m[0][2] = 0; a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0; a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = 0; a_pMat->m[2][2] = 1; a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = 0; a_pMat->m[3][1] = 0; a_pMat->m[3][2] = 0; a_pMat->m[3][3] = 1;
+}
+
+inline
+void InitTransMat4f( Mat4f *a_pMat, f32 x, f32 y, f32 z )
+{
+	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0; a_pMat->m[0][2] = 0; a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0; a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = 0; a_pMat->m[2][2] = 1; a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = x; a_pMat->m[3][1] = y; a_pMat->m[3][2] = z; a_pMat->m[3][3] = 1;
+}
+
+inline
+void InitTransMat4f( Mat4f *a_pMat, Vec3f *a_pTrans )
+{
+	a_pMat->m[0][0] = 1;           a_pMat->m[0][1] = 0;           a_pMat->m[0][2] = 0;           a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;           a_pMat->m[1][1] = 1;           a_pMat->m[1][2] = 0;           a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 0;           a_pMat->m[2][1] = 0;           a_pMat->m[2][2] = 1;           a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = a_pTrans->x; a_pMat->m[3][1] = a_pTrans->y; a_pMat->m[3][2] = a_pTrans->z; a_pMat->m[3][3] = 1;
+}
+
+/*
+inline
+void InitRotXMat4f( Mat4f *a_pMat, f32 angle )
+{
+	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0;                        a_pMat->m[0][2] = 0;                       a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = cosf(angle*PI_F/180.0f);  a_pMat->m[1][2] = sinf(angle*PI_F/180.0f); a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = -sinf(angle*PI_F/180.0f); a_pMat->m[2][2] = cosf(angle*PI_F/180.0f); a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = 0; a_pMat->m[3][1] = 0;                        a_pMat->m[3][2] = 0;                       a_pMat->m[3][3] = 1;
+}
+
+inline
+void InitRotYMat4f( Mat4f *a_pMat, f32 angle )
+{
+	a_pMat->m[0][0] = cosf(angle*PI_F/180.0f);  a_pMat->m[0][1] = 0; a_pMat->m[0][2] = -sinf(angle*PI_F/180.0f); a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;                        a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0;                        a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = sinf(angle*PI_F/180.0f);  a_pMat->m[2][1] = 0; a_pMat->m[2][2] = cosf(angle*PI_F/180.0f);  a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = 0;                        a_pMat->m[3][1] = 0; a_pMat->m[3][2] = 0;                        a_pMat->m[3][3] = 1;
+}
+
+inline
+void InitRotZMat4f( Mat4f *a_pMat, f32 angle )
+{
+	a_pMat->m[0][0] = cosf(angle*PI_F/180.0f);  a_pMat->m[0][1] = sinf(angle*PI_F/180.0f); a_pMat->m[0][2] = 0; a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = -sinf(angle*PI_F/180.0f); a_pMat->m[1][1] = cosf(angle*PI_F/180.0f); a_pMat->m[1][2] = 0; a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 0;                        a_pMat->m[2][1] = 0; 					   a_pMat->m[2][2] = 1; a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = 0;                        a_pMat->m[3][1] = 0;                       a_pMat->m[3][2] = 0; a_pMat->m[3][3] = 1;
+}
+*/
+
+inline
+void InitRotArbAxisMat4f( Mat4f *a_pMat, Vec3f *a_pAxis, f32 angle )
+{
+	f32 c = cosf(angle*PI_F/180.0f);
+	f32 mC = 1.0f-c;
+	f32 s = sinf(angle*PI_F/180.0f);
+	a_pMat->m[0][0] = c                          + (a_pAxis->x*a_pAxis->x*mC); a_pMat->m[0][1] = (a_pAxis->y*a_pAxis->x*mC) + (a_pAxis->z*s);             a_pMat->m[0][2] = (a_pAxis->z*a_pAxis->x*mC) - (a_pAxis->y*s);             a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = (a_pAxis->x*a_pAxis->y*mC) - (a_pAxis->z*s);             a_pMat->m[1][1] = c                          + (a_pAxis->y*a_pAxis->y*mC); a_pMat->m[1][2] = (a_pAxis->z*a_pAxis->y*mC) + (a_pAxis->x*s);             a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = (a_pAxis->x*a_pAxis->z*mC) + (a_pAxis->y*s);             a_pMat->m[2][1] = (a_pAxis->y*a_pAxis->z*mC) - (a_pAxis->x*s);             a_pMat->m[2][2] = c                          + (a_pAxis->z*a_pAxis->z*mC); a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = 0;                                                       a_pMat->m[3][1] = 0;                                                       a_pMat->m[3][2] = 0;                                                       a_pMat->m[3][3] = 1;
+}
+
+
+//Following are DirectX Matrices
+inline
+void InitPerspectiveProjectionMat4fDirectXRH( Mat4f *a_pMat, u64 width, u64 height, f32 a_hFOV, f32 a_vFOV, f32 nearPlane, f32 farPlane )
+{
+	f32 thFOV = tanf(a_hFOV*PI_F/360);
+	f32 tvFOV = tanf(a_vFOV*PI_F/360);
+	f32 nMinF = farPlane/(nearPlane-farPlane);
+  	f32 aspect = height / (f32)width;
+	a_pMat->m[0][0] = aspect/(thFOV); a_pMat->m[0][1] = 0;            a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;              a_pMat->m[1][1] = 1.0f/(tvFOV); a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 0;              a_pMat->m[2][1] = 0;            a_pMat->m[2][2] = nMinF;           a_pMat->m[2][3] = -1.0f;
+	a_pMat->m[3][0] = 0;              a_pMat->m[3][1] = 0;            a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
+}
+
+inline
+void InitPerspectiveProjectionMat4fDirectXLH( Mat4f *a_pMat, u64 width, u64 height, f32 a_hFOV, f32 a_vFOV, f32 nearPlane, f32 farPlane )
+{
+	f32 thFOV = tanf(a_hFOV*PI_F/360);
+	f32 tvFOV = tanf(a_vFOV*PI_F/360);
+	f32 nMinF = farPlane/(nearPlane-farPlane);
+  	f32 aspect = height / (f32)width;
+	a_pMat->m[0][0] = aspect/(thFOV); a_pMat->m[0][1] = 0;            a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 0;              a_pMat->m[1][1] = 1.0f/(tvFOV); a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 0;              a_pMat->m[2][1] = 0;            a_pMat->m[2][2] = -nMinF;          a_pMat->m[2][3] = 1.0f;
+	a_pMat->m[3][0] = 0;              a_pMat->m[3][1] = 0;            a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
+}
+
+inline
+f32 DeterminantUpper3x3Mat4f( Mat4f *a_pMat )
+{
+	return (a_pMat->m[0][0] * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]))) + 
+		   (a_pMat->m[0][1] * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[1][0]*a_pMat->m[2][2]))) + 
+		   (a_pMat->m[0][2] * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[2][0]*a_pMat->m[1][1])));
+}
+
+inline
+void InverseUpper3x3Mat4f( Mat4f *__restrict a_pMat, Mat4f *__restrict out )
+{
+	f32 fDet = DeterminantUpper3x3Mat4f( a_pMat );
+#if MAIN_DEBUG
+	assert( fDet != 0.f );
+#endif
+	f32 fInvDet = 1.0f / fDet;
+	out->m[0][0] = fInvDet * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]));
+	out->m[0][1] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[2][1]) - (a_pMat->m[0][1]*a_pMat->m[2][2]));
+	out->m[0][2] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[1][2]) - (a_pMat->m[0][2]*a_pMat->m[1][1]));
+	out->m[0][3] = 0.0f;
+
+	out->m[1][0] = fInvDet * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[2][2]*a_pMat->m[1][0]));
+	out->m[1][1] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[2][2]) - (a_pMat->m[0][2]*a_pMat->m[2][0])); 
+	out->m[1][2] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[1][0]) - (a_pMat->m[1][2]*a_pMat->m[0][0]));
+	out->m[1][3] = 0.0f;
+
+	out->m[2][0] = fInvDet * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[1][1]*a_pMat->m[2][0]));
+	out->m[2][1] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[2][0]) - (a_pMat->m[0][0]*a_pMat->m[2][1]));
+	out->m[2][2] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[1][1]) - (a_pMat->m[1][0]*a_pMat->m[0][1]));
+	out->m[2][3] = 0.0f;
+
+	out->m[3][0] = 0.0f;
+	out->m[3][1] = 0.0f;
+	out->m[3][2] = 0.0f;
+	out->m[3][3] = 1.0f;
+}
+
+inline
+void InverseTransposeUpper3x3Mat4f( Mat4f *__restrict a_pMat, Mat4f *__restrict out )
+{
+	f32 fDet = DeterminantUpper3x3Mat4f( a_pMat );
+#if MAIN_DEBUG
+	assert( fDet != 0.f );
+#endif
+	f32 fInvDet = 1.0f / fDet;
+	out->m[0][0] = fInvDet * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]));
+	out->m[0][1] = fInvDet * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[2][2]*a_pMat->m[1][0]));
+	out->m[0][2] = fInvDet * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[1][1]*a_pMat->m[2][0]));
+	out->m[0][3] = 0.0f;
+
+	out->m[1][0] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[2][1]) - (a_pMat->m[0][1]*a_pMat->m[2][2]));
+	out->m[1][1] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[2][2]) - (a_pMat->m[0][2]*a_pMat->m[2][0])); 
+	out->m[1][2] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[2][0]) - (a_pMat->m[0][0]*a_pMat->m[2][1]));
+	out->m[1][3] = 0.0f;
+
+	out->m[2][0] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[1][2]) - (a_pMat->m[0][2]*a_pMat->m[1][1]));
+	out->m[2][1] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[1][0]) - (a_pMat->m[1][2]*a_pMat->m[0][0]));
+	out->m[2][2] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[1][1]) - (a_pMat->m[1][0]*a_pMat->m[0][1]));
+	out->m[2][3] = 0.0f;
+
+	out->m[3][0] = 0.0f;
+	out->m[3][1] = 0.0f;
+	out->m[3][2] = 0.0f;
+	out->m[3][3] = 1.0f;
+}
+
+inline
+void InverseTransposeUpper3x3Mat4f( Mat4f *__restrict a_pMat, Mat3x4f *__restrict out )
+{
+	f32 fDet = DeterminantUpper3x3Mat4f( a_pMat );
+#if MAIN_DEBUG
+	assert( fDet != 0.f );
+#endif
+	f32 fInvDet = 1.0f / fDet;
+	out->m[0][0] = fInvDet * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]));
+	out->m[0][1] = fInvDet * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[2][2]*a_pMat->m[1][0]));
+	out->m[0][2] = fInvDet * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[1][1]*a_pMat->m[2][0]));
+	out->m[0][3] = 0.0f;
+
+	out->m[1][0] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[2][1]) - (a_pMat->m[0][1]*a_pMat->m[2][2]));
+	out->m[1][1] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[2][2]) - (a_pMat->m[0][2]*a_pMat->m[2][0])); 
+	out->m[1][2] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[2][0]) - (a_pMat->m[0][0]*a_pMat->m[2][1]));
+	out->m[1][3] = 0.0f;
+
+	out->m[2][0] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[1][2]) - (a_pMat->m[0][2]*a_pMat->m[1][1]));
+	out->m[2][1] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[1][0]) - (a_pMat->m[1][2]*a_pMat->m[0][0]));
+	out->m[2][2] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[1][1]) - (a_pMat->m[1][0]*a_pMat->m[0][1]));
+	out->m[2][3] = 0.0f;
+}
+
+
+inline
+void Mat4fMult( Mat4f *__restrict a, Mat4f *__restrict b, Mat4f *__restrict out)
+{
+	out->m[0][0] = a->m[0][0]*b->m[0][0] + a->m[0][1]*b->m[1][0] + a->m[0][2]*b->m[2][0] + a->m[0][3]*b->m[3][0];
+	out->m[0][1] = a->m[0][0]*b->m[0][1] + a->m[0][1]*b->m[1][1] + a->m[0][2]*b->m[2][1] + a->m[0][3]*b->m[3][1];
+	out->m[0][2] = a->m[0][0]*b->m[0][2] + a->m[0][1]*b->m[1][2] + a->m[0][2]*b->m[2][2] + a->m[0][3]*b->m[3][2];
+	out->m[0][3] = a->m[0][0]*b->m[0][3] + a->m[0][1]*b->m[1][3] + a->m[0][2]*b->m[2][3] + a->m[0][3]*b->m[3][3];
+
+	out->m[1][0] = a->m[1][0]*b->m[0][0] + a->m[1][1]*b->m[1][0] + a->m[1][2]*b->m[2][0] + a->m[1][3]*b->m[3][0];
+	out->m[1][1] = a->m[1][0]*b->m[0][1] + a->m[1][1]*b->m[1][1] + a->m[1][2]*b->m[2][1] + a->m[1][3]*b->m[3][1];
+	out->m[1][2] = a->m[1][0]*b->m[0][2] + a->m[1][1]*b->m[1][2] + a->m[1][2]*b->m[2][2] + a->m[1][3]*b->m[3][2];
+	out->m[1][3] = a->m[1][0]*b->m[0][3] + a->m[1][1]*b->m[1][3] + a->m[1][2]*b->m[2][3] + a->m[1][3]*b->m[3][3];
+
+	out->m[2][0] = a->m[2][0]*b->m[0][0] + a->m[2][1]*b->m[1][0] + a->m[2][2]*b->m[2][0] + a->m[2][3]*b->m[3][0];
+	out->m[2][1] = a->m[2][0]*b->m[0][1] + a->m[2][1]*b->m[1][1] + a->m[2][2]*b->m[2][1] + a->m[2][3]*b->m[3][1];
+	out->m[2][2] = a->m[2][0]*b->m[0][2] + a->m[2][1]*b->m[1][2] + a->m[2][2]*b->m[2][2] + a->m[2][3]*b->m[3][2];
+	out->m[2][3] = a->m[2][0]*b->m[0][3] + a->m[2][1]*b->m[1][3] + a->m[2][2]*b->m[2][3] + a->m[2][3]*b->m[3][3];
+
+	out->m[3][0] = a->m[3][0]*b->m[0][0] + a->m[3][1]*b->m[1][0] + a->m[3][2]*b->m[2][0] + a->m[3][3]*b->m[3][0];
+	out->m[3][1] = a->m[3][0]*b->m[0][1] + a->m[3][1]*b->m[1][1] + a->m[3][2]*b->m[2][1] + a->m[3][3]*b->m[3][1];
+	out->m[3][2] = a->m[3][0]*b->m[0][2] + a->m[3][1]*b->m[1][2] + a->m[3][2]*b->m[2][2] + a->m[3][3]*b->m[3][2];
+	out->m[3][3] = a->m[3][0]*b->m[0][3] + a->m[3][1]*b->m[1][3] + a->m[3][2]*b->m[2][3] + a->m[3][3]*b->m[3][3];
+}
+
+inline
+void Vec3fAdd( Vec3f *a, Vec3f *b, Vec3f *out )
+{
+	out->x = a->x + b->x;
+	out->y = a->y + b->y;
+	out->z = a->z + b->z;
+}
+
+inline
+void Vec3fSub( Vec3f *a, Vec3f *b, Vec3f *out )
+{
+	out->x = a->x - b->x;
+	out->y = a->y - b->y;
+	out->z = a->z - b->z;
+}
+
+inline
+void Vec3fMult( Vec3f *a, Vec3f *b, Vec3f *out )
+{
+	out->x = a->x * b->x;
+	out->y = a->y * b->y;
+	out->z = a->z * b->z;
+}
+
+inline
+void Vec3fCross( Vec3f *a, Vec3f *b, Vec3f *out )
+{
+	out->x = (a->y * b->z) - (a->z * b->y);
+	out->y = (a->z * b->x) - (a->x * b->z);
+	out->z = (a->x * b->y) - (a->y * b->x);
+}
+
+inline
+void Vec3fScale( Vec3f *a, f32 scale, Vec3f *out )
+{
+	out->x = a->x * scale;
+	out->y = a->y * scale;
+	out->z = a->z * scale;
+}
+
+
+inline
+void Vec3fScaleAdd( Vec3f *a, f32 scale, Vec3f *b, Vec3f *out )
+{
+	out->x = (a->x * scale) + b->x;
+	out->y = (a->y * scale) + b->y;
+	out->z = (a->z * scale) + b->z;
+}
+
+inline
+f32 Vec3fDot( Vec3f *a, Vec3f *b )
+{
+	return (a->x * b->x) + (a->y * b->y) + (a->z * b->z);
+}
+
+inline
+f32 Vec3fLength( Vec3f *a )
+{
+	return sqrtf((a->x*a->x) + (a->y*a->y) + (a->z*a->z));
+}
+
+inline
+void Vec3fNormalize( Vec3f *a, Vec3f *out )
+{
+
+	f32 mag = sqrtf((a->x*a->x) + (a->y*a->y) + (a->z*a->z));
+	if(mag == 0)
+	{
+		out->x = 0;
+		out->y = 0;
+		out->z = 0;
+	}
+	else
+	{
+		out->x = a->x/mag;
+		out->y = a->y/mag;
+		out->z = a->z/mag;
+	}
+}
+
+
+inline
+void Vec3fLerp( Vec3f *a, Vec3f *b, f32 fT, Vec3f *out )
+{
+	Vec3f vTmp;
+	Vec3fSub(b,a,&vTmp);
+	Vec3fScaleAdd(&vTmp,fT,a,out);
+}
+
+inline
+void Vec3fRotByUnitQuat(Vec3f *v, Quatf *__restrict q, Vec3f *out)
+{
+    f32 fVecScalar = (2.0f*q->w*q->w)-1;
+    f32 fQuatVecScalar = 2.0f* Vec3fDot(v,&q->v);
+
+    Vec3f vScaledQuatVec;
+    Vec3f vScaledVec;
+    Vec3fScale(&q->v,fQuatVecScalar,&vScaledQuatVec);
+    Vec3fScale(v,fVecScalar,&vScaledVec);
+
+    Vec3f vQuatCrossVec;
+    Vec3fCross(&q->v, v, &vQuatCrossVec);
+
+    Vec3fScale(&vQuatCrossVec,2.0f*q->w,&vQuatCrossVec);
+
+    Vec3fAdd(&vScaledQuatVec,&vScaledVec,out);
+    Vec3fAdd(out,&vQuatCrossVec,out);
+}
+
+/*
+inline
+void Vec3fRotByUnitQuat(Vec3f *v, Quatf *__restrict q, Vec3f *out)
+{
+	Vec3f vDoubleRot;
+	vDoubleRot.x = q->x + q->x;
+	vDoubleRot.y = q->y + q->y;
+	vDoubleRot.z = q->z + q->z;
+
+	Vec3f vScaledWRot;
+	vScaledWRot.x = q->w * vDoubleRot.x;
+	vScaledWRot.y = q->w * vDoubleRot.y;
+	vScaledWRot.z = q->w * vDoubleRot.z;
+
+	Vec3f vScaledXRot;
+	vScaledXRot.x = q->x * vDoubleRot.x;
+	vScaledXRot.y = q->x * vDoubleRot.y;
+	vScaledXRot.z = q->x * vDoubleRot.z;
+
+	f32 fScaledYRot0 = q->y * vDoubleRot.y;
+	f32 fScaledYRot1 = q->y * vDoubleRot.z;
+
+	f32 fScaledZRot0 = q->z * vDoubleRot.z;
+
+	out->x = ((v->x * ((1.f - fScaledYRot0) - fScaledZRot0)) + (v->y * (vScaledXRot.y - vScaledWRot.z))) + (v->z * (vScaledXRot.z + vScaledWRot.y));
+	out->y = ((v->x * (vScaledXRot.y + vScaledWRot.z)) + (v->y * ((1.f - vScaledXRot.x) - fScaledZRot0))) + (v->z * (fScaledYRot1 - vScaledWRot.x));
+	out->z = ((v->x * (vScaledXRot.z - vScaledWRot.y)) + (v->y * (fScaledYRot1 + vScaledWRot.x))) + (v->z * ((1.f - vScaledXRot.x) - fScaledYRot0));
+}
+*/
+
+
+inline
+void InitUnitQuatf( Quatf *q, f32 angle, Vec3f *axis )
+{
+	f32 s = sinf(angle*PI_F/360.0f);
+	q->w = cosf(angle*PI_F/360.0f);
+	q->x = axis->x * s;
+	q->y = axis->y * s;
+	q->z = axis->z * s;
+}
+
+inline
+void QuatfMult( Quatf *__restrict a, Quatf *__restrict b, Quatf *__restrict out )
+{
+	out->w = (a->w * b->w) - (a->x* b->x) - (a->y* b->y) - (a->z* b->z);
+	out->x = (a->w * b->x) + (a->x* b->w) + (a->y* b->z) - (a->z* b->y);
+	out->y = (a->w * b->y) + (a->y* b->w) + (a->z* b->x) - (a->x* b->z);
+	out->z = (a->w * b->z) + (a->z* b->w) + (a->x* b->y) - (a->y* b->x);
+}
+
+inline
+void QuatfSub( Quatf *a, Quatf *b, Quatf *out )
+{
+	out->w = a->w - b->w;
+	out->x = a->x - b->x;
+	out->y = a->y - b->y;
+	out->z = a->z - b->z;
+}
+
+inline
+void QuatfScaleAdd( Quatf *a, f32 scale, Quatf *b, Quatf *out )
+{
+	out->w = (a->w * scale) + b->w;
+	out->x = (a->x * scale) + b->x;
+	out->y = (a->y * scale) + b->y;
+	out->z = (a->z * scale) + b->z;
+}
+
+inline
+void QuatfNormalize( Quatf *a, Quatf *out )
+{
+
+	f32 mag = sqrtf((a->w*a->w) + (a->x*a->x) + (a->y*a->y) + (a->z*a->z));
+	if(mag == 0.f)
+	{
+		out->w = 0.f;
+		out->x = 0.f;
+		out->y = 0.f;
+		out->z = 0.f;
+	}
+	else
+	{
+		out->w = a->w/mag;
+		out->x = a->x/mag;
+		out->y = a->y/mag;
+		out->z = a->z/mag;
+	}
+}
+
+inline
+void QuatfConjugate( Quatf *a, Quatf *out )
+{
+	out->w = a->w;
+	out->x = -a->x;
+	out->y = -a->y;
+	out->z = -a->z;
+}
+
+//shortest arc rotation taking direction a onto direction b (neither needs to be normalized)
+inline
+void InitUnitQuatfFromTo( Quatf *q, Vec3f *a, Vec3f *b )
+{
+	Vec3f vA, vB;
+	Vec3fNormalize(a,&vA);
+	Vec3fNormalize(b,&vB);
+	f32 fDot = Vec3fDot(&vA,&vB);
+	if( fDot < -0.999999f )
+	{
+		//opposite directions, pick any perpendicular axis
+		Vec3f vAxis = { 0.0f, -vA.z, vA.y };
+		if( Vec3fDot(&vAxis,&vAxis) < 0.000001f )
+		{
+			vAxis = { vA.z, 0.0f, -vA.x };
+		}
+		Vec3fNormalize(&vAxis,&vAxis);
+		q->w = 0.0f;
+		q->v = vAxis;
+		return;
+	}
+	Vec3f vCross;
+	Vec3fCross(&vA,&vB,&vCross);
+	q->w = 1.0f + fDot;
+	q->v = vCross;
+	QuatfNormalize(q,q);
+}
+
+//todo simplify to reduce floating point error
+inline
+void InitViewMat4ByQuatf( Mat4f *a_pMat, Quatf *a_qRot, Vec3f *a_pPos )
+{
+	a_pMat->m[0][0] = 1.0f - 2.0f*(a_qRot->y*a_qRot->y + a_qRot->z*a_qRot->z);                            a_pMat->m[0][1] = 2.0f*(a_qRot->x*a_qRot->y - a_qRot->w*a_qRot->z);                                   a_pMat->m[0][2] = 2.0f*(a_qRot->x*a_qRot->z + a_qRot->w*a_qRot->y);        		                      a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 2.0f*(a_qRot->x*a_qRot->y + a_qRot->w*a_qRot->z);                                   a_pMat->m[1][1] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->z*a_qRot->z);                            a_pMat->m[1][2] = 2.0f*(a_qRot->y*a_qRot->z - a_qRot->w*a_qRot->x);        		                      a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 2.0f*(a_qRot->x*a_qRot->z - a_qRot->w*a_qRot->y);                                   a_pMat->m[2][1] = 2.0f*(a_qRot->y*a_qRot->z + a_qRot->w*a_qRot->x);                                   a_pMat->m[2][2] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->y*a_qRot->y); 		                      a_pMat->m[2][3] = 0;
+	a_pMat->m[3][0] = -a_pPos->x*a_pMat->m[0][0] - a_pPos->y*a_pMat->m[1][0] - a_pPos->z*a_pMat->m[2][0]; a_pMat->m[3][1] = -a_pPos->x*a_pMat->m[0][1] - a_pPos->y*a_pMat->m[1][1] - a_pPos->z*a_pMat->m[2][1]; a_pMat->m[3][2] = -a_pPos->x*a_pMat->m[0][2] - a_pPos->y*a_pMat->m[1][2] - a_pPos->z*a_pMat->m[2][2]; a_pMat->m[3][3] = 1;
+}
+
+inline
+void InitModelMat4ByQuatf( Mat4f *a_pMat, Quatf *a_qRot, Vec3f *a_pPos )
+{
+	a_pMat->m[0][0] = 1.0f - 2.0f*(a_qRot->y*a_qRot->y + a_qRot->z*a_qRot->z);                            a_pMat->m[0][1] = 2.0f*(a_qRot->x*a_qRot->y + a_qRot->w*a_qRot->z);                                   a_pMat->m[0][2] = 2.0f*(a_qRot->x*a_qRot->z - a_qRot->w*a_qRot->y);        		                      a_pMat->m[0][3] = 0;
+	a_pMat->m[1][0] = 2.0f*(a_qRot->x*a_qRot->y - a_qRot->w*a_qRot->z);                                   a_pMat->m[1][1] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->z*a_qRot->z);                            a_pMat->m[1][2] = 2.0f*(a_qRot->y*a_qRot->z + a_qRot->w*a_qRot->x);        		                      a_pMat->m[1][3] = 0;
+	a_pMat->m[2][0] = 2.0f*(a_qRot->x*a_qRot->z + a_qRot->w*a_qRot->y);                                   a_pMat->m[2][1] = 2.0f*(a_qRot->y*a_qRot->z - a_qRot->w*a_qRot->x);                                   a_pMat->m[2][2] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->y*a_qRot->y); 		                      a_pMat->m[2][3] = 0;
+	//a_pMat->m[3][0] = a_pPos->x*a_pMat->m[0][0] + a_pPos->y*a_pMat->m[1][0] + a_pPos->z*a_pMat->m[2][0];  a_pMat->m[3][1] = a_pPos->x*a_pMat->m[0][1] + a_pPos->y*a_pMat->m[1][1] + a_pPos->z*a_pMat->m[2][1]; a_pMat->m[3][2] = a_pPos->x*a_pMat->m[0][2] + a_pPos->y*a_pMat->m[1][2] + a_pPos->z*a_pMat->m[2][2]; a_pMat->m[3][3] = 1;
+	a_pMat->m[3][0] = a_pPos->x;  a_pMat->m[3][1] = a_pPos->y; a_pMat->m[3][2] = a_pPos->z; a_pMat->m[3][3] = 1.f;
+}
+
+inline
+void QuatfNormLerp( Quatf *a, Quatf *b, f32 fT, Quatf *out )
+{
+	Quatf qTmp;
+	QuatfSub(b,a,&qTmp);
+	QuatfScaleAdd(&qTmp,fT,a,out);
+	QuatfNormalize(out,out);
+}
+
+inline
+void QuatfSlerp( Vec3f *a, Vec3f *b, f32 fT, Vec3f *out )
+{
+	//todo
+}
+
+#if MAIN_DEBUG
+void PrintMat4f( Mat4f *a_pMat )
+{
+	for( u32 dwIdx = 0; dwIdx < 4; ++dwIdx )
+	{
+		for( u32 dwJdx = 0; dwJdx < 4; ++dwJdx )
+		{
+			printf("%f ", a_pMat->m[dwIdx][dwJdx] );
+		}
+		printf("\n");
+	}
+}
+#endif
+
+f32 clamp(f32 d, f32 min, f32 max) {
+  const f32 t = d < min ? min : d;
+  return t > max ? max : t;
+}
+
+u32 max( u32 a, u32 b )
+{
+	return a > b ? a : b;
+}
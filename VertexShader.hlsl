@@ -1,8 +1,25 @@
+#ifndef INSTANCED
+#define INSTANCED 0 //Compile.bat also builds this with /DINSTANCED=1, the transforms then come from the per instance stream
+#endif
+#ifndef DRAW_DATA
+#define DRAW_DATA 0 //RenderDrawDataMode, Compile.bat also builds 1 (root cbv at b2) and 2 (structured buffer at t0 indexed by a root constant)
+#endif
+
 struct VertexInput
 {
 	float3 pos : POS;
 	float3 localNormal : NORMAL;
 	float4 color : COLOR; //todo we can save a byte on opaque objects by assuming alpha = 1!
+#if INSTANCED
+	//RenderInstance, rows of the model and normal matrices in the same row vector convention as the cpu side
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
+	float3 normal0 : NORMALMAT0;
+	float3 normal1 : NORMALMAT1;
+	float3 normal2 : NORMALMAT2;
+#endif
 };
 
 struct VertexOutput
@@ -12,12 +29,38 @@ struct VertexOutput
 	float4 color : COLOR;
 };
 
+#if DRAW_DATA
+//mvpMat is just the view projection, the model transform comes from the draw's RenderDrawData
+cbuffer uniformsCB : register(b0)
+{
+    float4x4 mvpMat;
+	uint drawIndex; //RENDER_DRAW_DATA_INDEX
+};
+
+struct DrawData
+{
+	float4 worldColumns[3]; //x, y and z columns of the world matrix
+	uint4 normalHalves; //normal matrix rows as halves, low half first
+	uint normalHalf8;
+	uint3 pad;
+};
+
+#if DRAW_DATA == 1
+cbuffer drawCB : register(b2)
+{
+	DrawData drawData;
+};
+#else
+StructuredBuffer<DrawData> drawDatas : register(t0);
+#endif
+#else
 //vs_5_0 way
 cbuffer uniformsCB : register(b0)
 {
     float4x4 mvpMat;
 	float3x3 nMat;
 };
+#endif
 
 /* //vs_5_1 way
 struct Uniforms
@@ -40,9 +83,29 @@ float4 pos -> mul( inVert.pos, mvpMat ); or mul( mvpMat, inVert.pos );
 VertexOutput main( VertexInput inVert )
 {
 	VertexOutput outVert;
+#if INSTANCED
+	//mvpMat is just the view projection, the model matrix is applied per instance
+	float4 worldPos = ( inVert.world0 * inVert.pos.x ) + ( inVert.world1 * inVert.pos.y ) + ( inVert.world2 * inVert.pos.z ) + inVert.world3;
+	outVert.pos = mul( mvpMat, worldPos );
+	outVert.worldNormal = ( inVert.normal0 * inVert.localNormal.x ) + ( inVert.normal1 * inVert.localNormal.y ) + ( inVert.normal2 * inVert.localNormal.z );
+#elif DRAW_DATA
+#if DRAW_DATA == 1
+	DrawData draw = drawData;
+#else
+	DrawData draw = drawDatas[drawIndex];
+#endif
+	float4 localPos = float4( inVert.pos, 1.0f );
+	float4 worldPos = float4( dot( draw.worldColumns[0], localPos ), dot( draw.worldColumns[1], localPos ), dot( draw.worldColumns[2], localPos ), 1.0f );
+	outVert.pos = mul( mvpMat, worldPos );
+	float3 normal0 = float3( f16tof32( draw.normalHalves.x ), f16tof32( draw.normalHalves.x >> 16 ), f16tof32( draw.normalHalves.y ) );
+	float3 normal1 = float3( f16tof32( draw.normalHalves.y >> 16 ), f16tof32( draw.normalHalves.z ), f16tof32( draw.normalHalves.z >> 16 ) );
+	float3 normal2 = float3( f16tof32( draw.normalHalves.w ), f16tof32( draw.normalHalves.w >> 16 ), f16tof32( draw.normalHalf8 ) );
+	outVert.worldNormal = ( normal0 * inVert.localNormal.x ) + ( normal1 * inVert.localNormal.y ) + ( normal2 * inVert.localNormal.z );
+#else
 	//vs_5_0 way
 	outVert.pos = mul( mvpMat, float4( inVert.pos, 1.0f) );
 	outVert.worldNormal = mul( nMat, inVert.localNormal );
+#endif
 	//vs_5_1 way
 	//outVert.pos = mul( uniformsCB.mvpMat, float4( inVert.pos, 1.0f) );
 	//outVert.worldNormal = mul( uniformsCB.nMat, inVert.localNormal );
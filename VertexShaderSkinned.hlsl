@@ -2,8 +2,16 @@
 
 //is row or column major order more efficent in shader code?
 
+//every permutation ShaderPack.cpp lists sets MAX_BONES, ARRAY_IN_STRUCTURED_BUFFER and INSTANCED on the fxc command line
+#ifndef STRUCTURED_BUFFER
 #define STRUCTURED_BUFFER 1
+#endif
+#ifndef ARRAY_IN_STRUCTURED_BUFFER
 #define ARRAY_IN_STRUCTURED_BUFFER 1
+#endif
+#ifndef INSTANCED
+#define INSTANCED 0 //with 1 each instance picks its palette out of the frame's bone buffer
+#endif
 
 #if __SHADER_TARGET_MAJOR >= 5
 #if __SHADER_TARGET_MAJOR > 5 ||  ( __SHADER_TARGET_MAJOR == 5 && __SHADER_TARGET_MINOR >= 1 )
@@ -62,6 +70,9 @@ struct VertexInput
 	uint4 skinJoints : JOINT; //need to switch to 8/16 bit bone index
 	float4 skinWeights : WEIGHT;
 	float4 color : COLOR; //todo we can save a byte on opaque objects by assuming alpha = 1!
+#if INSTANCED
+	uint palette : PALETTE; //RenderInstance, the rest of it is unused since the model matrix is in the palette
+#endif
 };
 
 struct VertexOutput
@@ -113,21 +124,36 @@ VertexOutput main( VertexInput inVert )
 {
 	VertexOutput outVert;
 	//vs_5_0 way
+#if INSTANCED
+	uint palette = inVert.palette; //the root srv points at the first palette of the frame
+#else
+	uint palette = 0; //the root srv points at this draw's palette
+#endif
 
+//the bone palettes have the model matrix baked in (it is late latched right before submission), so skinning lands in world space
+//and mvpMat is just the view projection, the normals are skinned by the same palette instead of using nMat (no non uniform scale on bones)
 #if ARRAY_IN_STRUCTURED_BUFFER && STRUCTURED_BUFFER
- 	float4 pos = mul( bonesSB[0].boneMat[inVert.skinJoints.x], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.x;
- 	pos += mul( bonesSB[0].boneMat[inVert.skinJoints.y], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.y;
- 	pos += mul( bonesSB[0].boneMat[inVert.skinJoints.z], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.z;
- 	pos += mul( bonesSB[0].boneMat[inVert.skinJoints.w], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.w;
+ 	float4 pos = mul( bonesSB[palette].boneMat[inVert.skinJoints.x], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.x;
+ 	pos += mul( bonesSB[palette].boneMat[inVert.skinJoints.y], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.y;
+ 	pos += mul( bonesSB[palette].boneMat[inVert.skinJoints.z], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.z;
+ 	pos += mul( bonesSB[palette].boneMat[inVert.skinJoints.w], float4( inVert.pos, 1.0f) ) * inVert.skinWeights.w;
+ 	float3 normal = mul( (float3x3)bonesSB[palette].boneMat[inVert.skinJoints.x], inVert.localNormal ) * inVert.skinWeights.x;
+ 	normal += mul( (float3x3)bonesSB[palette].boneMat[inVert.skinJoints.y], inVert.localNormal ) * inVert.skinWeights.y;
+ 	normal += mul( (float3x3)bonesSB[palette].boneMat[inVert.skinJoints.z], inVert.localNormal ) * inVert.skinWeights.z;
+ 	normal += mul( (float3x3)bonesSB[palette].boneMat[inVert.skinJoints.w], inVert.localNormal ) * inVert.skinWeights.w;
 #else
- 	float4 pos = mul( bonesSB[inVert.skinJoints.x].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.x;
- 	pos += mul( bonesSB[inVert.skinJoints.y].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.y;
- 	pos += mul( bonesSB[inVert.skinJoints.z].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.z;
- 	pos += mul( bonesSB[inVert.skinJoints.w].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.w;
+ 	float4 pos = mul( bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.x].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.x;
+ 	pos += mul( bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.y].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.y;
+ 	pos += mul( bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.z].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.z;
+ 	pos += mul( bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.w].boneMat, float4( inVert.pos, 1.0f) ) * inVert.skinWeights.w;
+ 	float3 normal = mul( (float3x3)bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.x].boneMat, inVert.localNormal ) * inVert.skinWeights.x;
+ 	normal += mul( (float3x3)bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.y].boneMat, inVert.localNormal ) * inVert.skinWeights.y;
+ 	normal += mul( (float3x3)bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.z].boneMat, inVert.localNormal ) * inVert.skinWeights.z;
+ 	normal += mul( (float3x3)bonesSB[( palette * MAX_BONES ) + inVert.skinJoints.w].boneMat, inVert.localNormal ) * inVert.skinWeights.w;
 #endif
 
 	outVert.pos = mul( mvpMat, pos );
-	outVert.worldNormal = mul( nMat, inVert.localNormal );
+	outVert.worldNormal = normal;
 	outVert.color = inVert.color;
 	return outVert;
 }
\ No newline at end of file
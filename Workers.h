@@ -0,0 +1,142 @@
+//Worker threads for data parallel loops, ParallelFor splits [0, count) into chunks that the workers and the calling thread pull
+//off a shared counter, it returns once every chunk is done so a caller can put a dependency (e.g. the next hierarchy level) right after it
+//meant to be driven by one thread at a time (the sim thread), the workers sleep on a semaphore in between
+
+#define WORKER_MAX_THREADS 8
+#define WORKER_CHUNK_IDLE 0x40000000 //dwNextChunk between jobs, so a worker waking late never claims a chunk of a job being set up
+static_assert( PROFILER_MAX_THREADS >= WORKER_MAX_THREADS + 3, "the profiler needs a slot per worker plus sim, render and the GPU track" );
+
+typedef void (*WorkerRangeFn)( void *pContext, u32 dwBegin, u32 dwEnd );
+
+typedef struct WorkerPool
+{
+	HANDLE hThreads[WORKER_MAX_THREADS];
+	HANDLE hWake; //semaphore, released once per worker per job
+	u32 dwNumThreads;
+	volatile LONG bQuit;
+
+	//the current job, only written while dwNextChunk is WORKER_CHUNK_IDLE
+	WorkerRangeFn pFn;
+	void *pContext;
+	u32 dwCount;
+	u32 dwChunkSize;
+	LONG dwNumChunks;
+	volatile LONG dwNextChunk;
+	volatile LONG dwChunksDone;
+} WorkerPool;
+
+WorkerPool workerPool;
+
+//returns false once the job has no chunks left, the chunk is claimed with a compare exchange rather than an increment so a worker
+//that read the counter during one job can never claim an index against the next job's chunk count
+inline
+bool WorkerRunChunk( WorkerPool *a_pPool )
+{
+	LONG dwChunk;
+	do
+	{
+		dwChunk = a_pPool->dwNextChunk;
+		if( dwChunk >= a_pPool->dwNumChunks )
+		{
+			return false;
+		}
+	} while( InterlockedCompareExchange( &a_pPool->dwNextChunk, dwChunk + 1, dwChunk ) != dwChunk );
+	u32 dwBegin = (u32)dwChunk * a_pPool->dwChunkSize;
+	u32 dwEnd = dwBegin + a_pPool->dwChunkSize;
+	a_pPool->pFn( a_pPool->pContext, dwBegin, dwEnd < a_pPool->dwCount ? dwEnd : a_pPool->dwCount );
+	InterlockedIncrement( &a_pPool->dwChunksDone );
+	return true;
+}
+
+DWORD WINAPI WorkerThreadProc( LPVOID lpParameter )
+{
+	WorkerPool *pPool = (WorkerPool*)lpParameter;
+	ProfilerRegisterThread( "Worker" );
+	for( ;; )
+	{
+		WaitForSingleObject( pPool->hWake, INFINITE );
+		if( pPool->bQuit )
+		{
+			break;
+		}
+		while( WorkerRunChunk( pPool ) )
+		{
+		}
+	}
+	return 0;
+}
+
+//dwNumThreads of 0 is fine, ParallelFor then just runs everything on the caller
+inline
+bool InitWorkerPool( WorkerPool *a_pPool, u32 dwNumThreads )
+{
+	a_pPool->dwNumThreads = 0;
+	a_pPool->bQuit = 0;
+	a_pPool->dwNextChunk = WORKER_CHUNK_IDLE;
+	a_pPool->dwNumChunks = 0;
+	a_pPool->hWake = CreateSemaphore( nullptr, 0, 0x7fffffff, nullptr ); //a wake a worker missed only costs it a spurious loop
+	if( !a_pPool->hWake )
+	{
+		return false;
+	}
+	dwNumThreads = dwNumThreads < WORKER_MAX_THREADS ? dwNumThreads : WORKER_MAX_THREADS;
+	for( u32 dwThread = 0; dwThread < dwNumThreads; ++dwThread )
+	{
+		a_pPool->hThreads[dwThread] = CreateThread( nullptr, 0, WorkerThreadProc, a_pPool, 0, nullptr );
+		if( !a_pPool->hThreads[dwThread] )
+		{
+			break; //run with however many we got
+		}
+		++a_pPool->dwNumThreads;
+	}
+	return true;
+}
+
+inline
+void DestroyWorkerPool( WorkerPool *a_pPool )
+{
+	if( !a_pPool->hWake )
+	{
+		return;
+	}
+	a_pPool->bQuit = 1;
+	ReleaseSemaphore( a_pPool->hWake, a_pPool->dwNumThreads, nullptr );
+	for( u32 dwThread = 0; dwThread < a_pPool->dwNumThreads; ++dwThread )
+	{
+		WaitForSingleObject( a_pPool->hThreads[dwThread], INFINITE );
+		CloseHandle( a_pPool->hThreads[dwThread] );
+	}
+	CloseHandle( a_pPool->hWake );
+	a_pPool->hWake = nullptr;
+	a_pPool->dwNumThreads = 0;
+}
+
+//the range gets split into dwChunkSize pieces, a single chunk (or no workers) just runs inline without waking anyone
+inline
+void ParallelFor( WorkerPool *a_pPool, u32 dwCount, u32 dwChunkSize, WorkerRangeFn pFn, void *pContext )
+{
+	u32 dwNumChunks = ( dwCount + dwChunkSize - 1 ) / dwChunkSize;
+	if( dwNumChunks <= 1 || !a_pPool->dwNumThreads )
+	{
+		pFn( pContext, 0, dwCount );
+		return;
+	}
+	a_pPool->pFn = pFn;
+	a_pPool->pContext = pContext;
+	a_pPool->dwCount = dwCount;
+	a_pPool->dwChunkSize = dwChunkSize;
+	a_pPool->dwNumChunks = (LONG)dwNumChunks;
+	a_pPool->dwChunksDone = 0;
+	InterlockedExchange( &a_pPool->dwNextChunk, 0 ); //full barrier, the job is visible before any chunk can be taken
+	u32 dwWake = dwNumChunks - 1 < a_pPool->dwNumThreads ? dwNumChunks - 1 : a_pPool->dwNumThreads;
+	ReleaseSemaphore( a_pPool->hWake, dwWake, nullptr );
+	while( WorkerRunChunk( a_pPool ) )
+	{
+	}
+	//the last chunks may still be running on workers
+	while( a_pPool->dwChunksDone != (LONG)dwNumChunks )
+	{
+		YieldProcessor();
+	}
+	InterlockedExchange( &a_pPool->dwNextChunk, WORKER_CHUNK_IDLE ); //also the barrier between the workers' writes and the caller's reads
+}
@@ -43,12 +43,20 @@ To achieve optimal performance, applications should generally sort the layout of
 
 #if MAIN_DEBUG
 #include "vertShaderDebug.h" //in debug use .cso files for hot shader reloading for faster developing
-#include "vertShaderSkinnedDebug.h"
+#include "vertShaderInstancedDebug.h"
+#include "vertShaderDrawCBVDebug.h"
+#include "vertShaderDrawIndexDebug.h"
+#include "skinnedShadersDebug.h" //every skinned permutation, see ShaderPermutations.h
 #include "pixelShaderDebug.h"
+#include "indirectCullDebug.h"
 #else
 #include "vertShader.h"
-#include "vertShaderSkinned.h"
+#include "vertShaderInstanced.h"
+#include "vertShaderDrawCBV.h"
+#include "vertShaderDrawIndex.h"
+#include "skinnedShaders.h"
 #include "pixelShader.h"
+#include "indirectCull.h"
 #endif
 
 #if !MAIN_DEBUG
@@ -66,118 +74,7 @@ To achieve optimal performance, applications should generally sort the layout of
 // for struct references look in OVR_CAPI.h and 
 #include "OVR_CAPI_D3D.h"
 
-#define PI_F 3.1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679f
-#define PI_D 3.1415926535897932384626433832795028841971693993751058209749445923078164062862089986280348253421170679
-
-typedef uint8_t  u8;
-typedef uint16_t u16;
-typedef uint32_t u32;
-typedef uint64_t u64;
-typedef int8_t   s8;
-typedef int16_t  s16;
-typedef int32_t  s32;
-typedef int64_t  s64;
-typedef float    f32; //floating 32
-typedef double   f64; //floating 64
-
-typedef struct Mat3f
-{
-	union
-	{
-		f32 m[3][3];
-	};
-} Mat3f;
-
-typedef struct Mat4f
-{
-	union
-	{
-		f32 m[4][4];
-	};
-} Mat4f;
-
-typedef struct Mat3x4f
-{
-	union
-	{
-		f32 m[3][4];
-	};
-} Mat3x4f;
-
-typedef struct Vec2f
-{
-	union
-	{
-		f32 v[2];
-		struct
-		{
-			f32 x;
-			f32 y;
-		};
-	};
-} Vec2f;
-
-typedef struct Vec3f
-{
-	union
-	{
-		f32 v[3];
-		struct
-		{
-			f32 x;
-			f32 y;
-			f32 z;
-		};
-	};
-} Vec3f;
-
-typedef struct Vec4f
-{
-	union
-	{
-		f32 v[4];
-		struct
-		{
-			f32 x;
-			f32 y;
-			f32 z;
-			f32 w;
-		};
-	};
-} Vec4f;
-
-typedef struct Quatf
-{
-	union
-	{
-		f32 q[4];
-		struct
-		{
-			f32 w; //real
-			f32 x;
-			f32 y;
-			f32 z;
-		};
-		struct
-		{
-			f32 r; //real;
-			Vec3f v;
-		};
-	};
-} Quatf;
-
-typedef struct Bone
-{
-	Quatf qLocalRot;
-	Vec3f vLocalTrans;
-	Vec3f vScale;
-} Bone;
-
-typedef struct KeyFrame
-{
-	Quatf qRot;
-	Vec3f vPos;
-} KeyFrame;
+#include "VecMath.h"
 
 typedef struct vertexShaderCB
 {
@@ -193,9 +90,13 @@ typedef struct pixelShaderCB
 
 
 #include "Models.h"
+#include "ShaderPermutations.h" //no d3d12 in it, the skinned pso arrays and BONE_PALETTE_SIZE need it up here
+#include "MeshLod.h"
+#include "modelLods.h" //MeshSimplify.exe writes it from Models.h at build time
+#include "MeshIndices.h"
 
 //Game state
-u8 Running;
+volatile u8 Running; //the render thread reads this too
 u8 isPaused;
 
 //Camera
@@ -213,14 +114,15 @@ ovrSession oculusSession; //oculus's global state variable
 ovrGraphicsLuid oculusGLuid; //uid of graphics card that has headset attachted to it
 ovrHmdDesc oculusHMDDesc; //description of the headset
 ovrRecti oculusEyeRenderViewport[ovrEye_Count]; //TODO do I even need to store this!
-D3D12_VIEWPORT EyeViewports[ovrEye_Count];
+D3D12_VIEWPORT EyeViewports[ovrEye_Count]; //full target size, each frame renders to a scaled down part of it (DynamicResolutionEyeViewport)
 D3D12_RECT EyeScissorRects[ovrEye_Count];
 ovrTextureSwapChain oculusEyeSwapChains[ovrEye_Count];
 ID3D12Resource** oculusEyeBackBuffers;
-ID3D12Resource* depthStencilBuffers[ovrEye_Count];
+ovrTextureSwapChain oculusEyeDepthSwapChains[ovrEye_Count];
+ID3D12Resource** oculusEyeDepthBuffers;
 
 D3D12_CPU_DESCRIPTOR_HANDLE eyeStartingRTVHandle[ovrEye_Count];
-D3D12_CPU_DESCRIPTOR_HANDLE eyeDSVHandle[ovrEye_Count];
+D3D12_CPU_DESCRIPTOR_HANDLE eyeStartingDSVHandle[ovrEye_Count];
 
 //DirectX12 Globals
 const u8 numSwapChains = 2; // we should allow users the ability to display the game on their screen, so change to 3 (1 for left eye, 1 for right eye, 1 for toggleable render window(when not displaying on screen a very small check box window is appearing saying toggle to render to screen too, then in options in game you can untoggle and turn it off))
@@ -236,7 +138,9 @@ ID3D12Heap* pModelUploadHeap; //will be <= size of the default heap
 
 ID3D12Resource* defaultBuffer; //a default committed resource
 ID3D12Resource* uploadBuffer; //a tmp upload committed resource
-ID3D12Resource* boneBuffer[6][ovrHand_Count];
+ID3D12Resource* boneBuffer[6]; //per frame, every hand's palette back to back BONE_PALETTE_SIZE apart
+
+#define BONE_PALETTE_SIZE ( skinShaders.dwBones * sizeof( Mat4f ) ) //one Bones element of the picked skinned permutation's structured buffer
 
 //views
 D3D12_VERTEX_BUFFER_VIEW planeVertexBufferView;
@@ -245,20 +149,44 @@ D3D12_VERTEX_BUFFER_VIEW cubeVertexBufferView;
 D3D12_INDEX_BUFFER_VIEW cubeIndexBufferView;
 D3D12_VERTEX_BUFFER_VIEW handVertexBufferView;
 D3D12_INDEX_BUFFER_VIEW handIndexBufferView;
+MeshIndices planeMeshIndices; //format and parts the indices were packed to in UploadModels
+MeshIndices cubeMeshIndices;
+MeshIndices handMeshIndices[MESH_LOD_MAX_LEVELS]; //one per level of handLodLevels
+
+//by MeshId
+D3D12_VERTEX_BUFFER_VIEW *meshVertexBufferViews[MESH_COUNT] = { &planeVertexBufferView, &cubeVertexBufferView, &handVertexBufferView };
+D3D12_INDEX_BUFFER_VIEW *meshIndexBufferViews[MESH_COUNT] = { &planeIndexBufferView, &cubeIndexBufferView, &handIndexBufferView };
+MeshIndices *meshIndices[MESH_COUNT] = { &planeMeshIndices, &cubeMeshIndices, handMeshIndices }; //the first of each mesh's LOD levels
 
 // D3D12 Descriptors
 ID3D12DescriptorHeap* rtvDescriptorHeap;
 u64 rtvDescriptorSize;
+u64 dsvDescriptorSize;
 ID3D12DescriptorHeap* dsDescriptorHeap;
-ID3D12DescriptorHeap* srvDescriptorHeap;
-u64 srvDescriptorSize;
 
 //pipeline info
 const u32 dwSampleRate = 1;
 ID3D12RootSignature* rootSignature; // root signature defines data shaders will access
 ID3D12RootSignature* skinnedRootSignature;
 ID3D12PipelineState* pipelineStateObject; // pso containing a pipeline state (a per material thing)
-ID3D12PipelineState* skinnedPipelineStateObject; // pso containing a pipeline state
+ID3D12PipelineState* skinnedPipelineStateObjects[SKIN_LAYOUT_COUNT]; //one per palette layout of the picked bone count, RenderFrame picks one
+ID3D12PipelineState* instancedPipelineStateObject; //same root signatures, transforms come from the instance stream
+ID3D12PipelineState* drawCBVPipelineStateObject; //static, transforms from a root cbv into the frame's draw data
+ID3D12PipelineState* drawIndexPipelineStateObject; //static, transforms from the frame's draw data indexed by a root constant
+ID3D12PipelineState* skinnedInstancedPipelineStateObjects[SKIN_LAYOUT_COUNT];
+
+//when using multiple memory srcs for input for rendering the following will be the main slot
+#define MAIN_VB_SLOT 0
+#define INSTANCE_VB_SLOT 1 //RenderInstance per instance data for the instanced pipelines
+
+#define SKIN_LAYOUT_AB_TEST MAIN_DEBUG //alternate the skinned palette layouts every frame, GpuTimerPrintReport shows the hands pass of each
+
+#define VERTEX_CB_ROOT_SLOT 0
+#define PIXEL_CB_ROOT_SLOT 1
+#define VERTEX_SB_ROOT_SLOT 2 //bone palettes for skinned draws, the frame's draw data for RENDER_DRAW_DATA_INDEX static ones
+#define VERTEX_DRAW_CBV_ROOT_SLOT 3 //static root signature only, a draw's RenderDrawData for RENDER_DRAW_DATA_ROOT_CBV
+#define DRAW_DATA_MODE -1 //a RenderDrawDataMode to always use, -1 lets RenderDrawDataPickMode choose every frame
+#define FOVEATION_LEVEL 2 //which of foveationLevels' ring sets shades the periphery coarser, 0 shades everything at full rate
 
 //Model Upload Syncronization
 ID3D12Fence* streamingFence;
@@ -273,512 +201,12 @@ ID3D12InfoQueue *pIQueue;
 #endif
 
 //Constant Buffers
-vertexShaderCB vertexConstantBuffer;
 pixelShaderCB pixelConstantBuffer;
 
-Mat4f mHandFrameFinalBones[6][ovrHand_Count][handBonesCount]; //initialize these to first frame of animation!  //only use up to oculusNUM_FRAMES amount
-f32 fPrevSideFingerDownAmount[6][ovrHand_Count] = { 0.0f }; //only use up to oculusNUM_FRAMES amount
-f32 fPrevIndexFingerDownAmount[6][ovrHand_Count] = { 0.0f }; //only use up to oculusNUM_FRAMES amount
-
-inline
-void InitMat3f( Mat3f *a_pMat )
-{
-	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0; a_pMat->m[0][2] = 0;
-	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0;
-	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = 0; a_pMat->m[2][2] = 1;
-}
-
-inline
-void InitMat4f( Mat4f *a_pMat )
-{
-	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0; a_pMat->m[0][2] = 0; a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0; a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = 0; a_pMat->m[2][2] = 1; a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = 0; a_pMat->m[3][1] = 0; a_pMat->m[3][2] = 0; a_pMat->m[3][3] = 1;
-}
-
-inline
-void InitTransMat4f( Mat4f *a_pMat, f32 x, f32 y, f32 z )
-{
-	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0; a_pMat->m[0][2] = 0; a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0; a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = 0; a_pMat->m[2][2] = 1; a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = x; a_pMat->m[3][1] = y; a_pMat->m[3][2] = z; a_pMat->m[3][3] = 1;
-}
-
-inline
-void InitTransMat4f( Mat4f *a_pMat, Vec3f *a_pTrans )
-{
-	a_pMat->m[0][0] = 1;           a_pMat->m[0][1] = 0;           a_pMat->m[0][2] = 0;           a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0;           a_pMat->m[1][1] = 1;           a_pMat->m[1][2] = 0;           a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 0;           a_pMat->m[2][1] = 0;           a_pMat->m[2][2] = 1;           a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = a_pTrans->x; a_pMat->m[3][1] = a_pTrans->y; a_pMat->m[3][2] = a_pTrans->z; a_pMat->m[3][3] = 1;
-}
-
-/*
-inline
-void InitRotXMat4f( Mat4f *a_pMat, f32 angle )
-{
-	a_pMat->m[0][0] = 1; a_pMat->m[0][1] = 0;                        a_pMat->m[0][2] = 0;                       a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0; a_pMat->m[1][1] = cosf(angle*PI_F/180.0f);  a_pMat->m[1][2] = sinf(angle*PI_F/180.0f); a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 0; a_pMat->m[2][1] = -sinf(angle*PI_F/180.0f); a_pMat->m[2][2] = cosf(angle*PI_F/180.0f); a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = 0; a_pMat->m[3][1] = 0;                        a_pMat->m[3][2] = 0;                       a_pMat->m[3][3] = 1;
-}
-
-inline
-void InitRotYMat4f( Mat4f *a_pMat, f32 angle )
-{
-	a_pMat->m[0][0] = cosf(angle*PI_F/180.0f);  a_pMat->m[0][1] = 0; a_pMat->m[0][2] = -sinf(angle*PI_F/180.0f); a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0;                        a_pMat->m[1][1] = 1; a_pMat->m[1][2] = 0;                        a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = sinf(angle*PI_F/180.0f);  a_pMat->m[2][1] = 0; a_pMat->m[2][2] = cosf(angle*PI_F/180.0f);  a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = 0;                        a_pMat->m[3][1] = 0; a_pMat->m[3][2] = 0;                        a_pMat->m[3][3] = 1;
-}
-
-inline
-void InitRotZMat4f( Mat4f *a_pMat, f32 angle )
-{
-	a_pMat->m[0][0] = cosf(angle*PI_F/180.0f);  a_pMat->m[0][1] = sinf(angle*PI_F/180.0f); a_pMat->m[0][2] = 0; a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = -sinf(angle*PI_F/180.0f); a_pMat->m[1][1] = cosf(angle*PI_F/180.0f); a_pMat->m[1][2] = 0; a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 0;                        a_pMat->m[2][1] = 0; 					   a_pMat->m[2][2] = 1; a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = 0;                        a_pMat->m[3][1] = 0;                       a_pMat->m[3][2] = 0; a_pMat->m[3][3] = 1;
-}
-*/
-
-inline
-void InitRotArbAxisMat4f( Mat4f *a_pMat, Vec3f *a_pAxis, f32 angle )
-{
-	f32 c = cosf(angle*PI_F/180.0f);
-	f32 mC = 1.0f-c;
-	f32 s = sinf(angle*PI_F/180.0f);
-	a_pMat->m[0][0] = c                          + (a_pAxis->x*a_pAxis->x*mC); a_pMat->m[0][1] = (a_pAxis->y*a_pAxis->x*mC) + (a_pAxis->z*s);             a_pMat->m[0][2] = (a_pAxis->z*a_pAxis->x*mC) - (a_pAxis->y*s);             a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = (a_pAxis->x*a_pAxis->y*mC) - (a_pAxis->z*s);             a_pMat->m[1][1] = c                          + (a_pAxis->y*a_pAxis->y*mC); a_pMat->m[1][2] = (a_pAxis->z*a_pAxis->y*mC) + (a_pAxis->x*s);             a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = (a_pAxis->x*a_pAxis->z*mC) + (a_pAxis->y*s);             a_pMat->m[2][1] = (a_pAxis->y*a_pAxis->z*mC) - (a_pAxis->x*s);             a_pMat->m[2][2] = c                          + (a_pAxis->z*a_pAxis->z*mC); a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = 0;                                                       a_pMat->m[3][1] = 0;                                                       a_pMat->m[3][2] = 0;                                                       a_pMat->m[3][3] = 1;
-}
-
-
-//Following are DirectX Matrices
-inline
-void InitPerspectiveProjectionMat4fDirectXRH( Mat4f *a_pMat, u64 width, u64 height, f32 a_hFOV, f32 a_vFOV, f32 nearPlane, f32 farPlane )
-{
-	f32 thFOV = tanf(a_hFOV*PI_F/360);
-	f32 tvFOV = tanf(a_vFOV*PI_F/360);
-	f32 nMinF = farPlane/(nearPlane-farPlane);
-  	f32 aspect = height / (f32)width;
-	a_pMat->m[0][0] = aspect/(thFOV); a_pMat->m[0][1] = 0;            a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0;              a_pMat->m[1][1] = 1.0f/(tvFOV); a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 0;              a_pMat->m[2][1] = 0;            a_pMat->m[2][2] = nMinF;           a_pMat->m[2][3] = -1.0f;
-	a_pMat->m[3][0] = 0;              a_pMat->m[3][1] = 0;            a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
-}
-
-inline
-void InitPerspectiveProjectionMat4fDirectXLH( Mat4f *a_pMat, u64 width, u64 height, f32 a_hFOV, f32 a_vFOV, f32 nearPlane, f32 farPlane )
-{
-	f32 thFOV = tanf(a_hFOV*PI_F/360);
-	f32 tvFOV = tanf(a_vFOV*PI_F/360);
-	f32 nMinF = farPlane/(nearPlane-farPlane);
-  	f32 aspect = height / (f32)width;
-	a_pMat->m[0][0] = aspect/(thFOV); a_pMat->m[0][1] = 0;            a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0;              a_pMat->m[1][1] = 1.0f/(tvFOV); a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 0;              a_pMat->m[2][1] = 0;            a_pMat->m[2][2] = -nMinF;          a_pMat->m[2][3] = 1.0f;
-	a_pMat->m[3][0] = 0;              a_pMat->m[3][1] = 0;            a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
-}
-
-inline
-void InitPerspectiveProjectionMat4fOculusDirectXLH( Mat4f *a_pMat, ovrFovPort tanHalfFov, f32 nearPlane, f32 farPlane )
-{
-    f32 projXScale = 2.0f / ( tanHalfFov.LeftTan + tanHalfFov.RightTan );
-    f32 projXOffset = ( tanHalfFov.LeftTan - tanHalfFov.RightTan ) * projXScale * 0.5f;
-    f32 projYScale = 2.0f / ( tanHalfFov.UpTan + tanHalfFov.DownTan );
-    f32 projYOffset = ( tanHalfFov.UpTan - tanHalfFov.DownTan ) * projYScale * 0.5f;
-	f32 nMinF = farPlane/(nearPlane-farPlane);
-	a_pMat->m[0][0] = projXScale;  a_pMat->m[0][1] = 0;            a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0;           a_pMat->m[1][1] = projYScale;   a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = projXOffset; a_pMat->m[2][1] = -projYOffset; a_pMat->m[2][2] = -nMinF;          a_pMat->m[2][3] = 1.0f;
-	a_pMat->m[3][0] = 0;           a_pMat->m[3][1] = 0;            a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
-}
-
-
-inline
-void InitPerspectiveProjectionMat4fOculusDirectXRH( Mat4f *a_pMat, ovrFovPort tanHalfFov, f32 nearPlane, f32 farPlane )
-{
-    f32 projXScale = 2.0f / ( tanHalfFov.LeftTan + tanHalfFov.RightTan );
-    f32 projXOffset = ( tanHalfFov.LeftTan - tanHalfFov.RightTan ) * projXScale * 0.5f;
-    f32 projYScale = 2.0f / ( tanHalfFov.UpTan + tanHalfFov.DownTan );
-    f32 projYOffset = ( tanHalfFov.UpTan - tanHalfFov.DownTan ) * projYScale * 0.5f;
-	f32 nMinF = farPlane/(nearPlane-farPlane);
-	a_pMat->m[0][0] = projXScale;   a_pMat->m[0][1] = 0;           a_pMat->m[0][2] = 0;               a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 0;            a_pMat->m[1][1] = projYScale;  a_pMat->m[1][2] = 0;               a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = -projXOffset; a_pMat->m[2][1] = projYOffset; a_pMat->m[2][2] = nMinF;           a_pMat->m[2][3] = -1.0f;
-	a_pMat->m[3][0] = 0;            a_pMat->m[3][1] = 0;           a_pMat->m[3][2] = nearPlane*nMinF; a_pMat->m[3][3] = 0;
-}
-
-inline
-f32 DeterminantUpper3x3Mat4f( Mat4f *a_pMat )
-{
-	return (a_pMat->m[0][0] * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]))) + 
-		   (a_pMat->m[0][1] * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[1][0]*a_pMat->m[2][2]))) + 
-		   (a_pMat->m[0][2] * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[2][0]*a_pMat->m[1][1])));
-}
-
-inline
-void InverseUpper3x3Mat4f( Mat4f *__restrict a_pMat, Mat4f *__restrict out )
-{
-	f32 fDet = DeterminantUpper3x3Mat4f( a_pMat );
-#if MAIN_DEBUG
-	assert( fDet != 0.f );
-#endif
-	f32 fInvDet = 1.0f / fDet;
-	out->m[0][0] = fInvDet * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]));
-	out->m[0][1] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[2][1]) - (a_pMat->m[0][1]*a_pMat->m[2][2]));
-	out->m[0][2] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[1][2]) - (a_pMat->m[0][2]*a_pMat->m[1][1]));
-	out->m[0][3] = 0.0f;
-
-	out->m[1][0] = fInvDet * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[2][2]*a_pMat->m[1][0]));
-	out->m[1][1] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[2][2]) - (a_pMat->m[0][2]*a_pMat->m[2][0])); 
-	out->m[1][2] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[1][0]) - (a_pMat->m[1][2]*a_pMat->m[0][0]));
-	out->m[1][3] = 0.0f;
-
-	out->m[2][0] = fInvDet * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[1][1]*a_pMat->m[2][0]));
-	out->m[2][1] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[2][0]) - (a_pMat->m[0][0]*a_pMat->m[2][1]));
-	out->m[2][2] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[1][1]) - (a_pMat->m[1][0]*a_pMat->m[0][1]));
-	out->m[2][3] = 0.0f;
-
-	out->m[3][0] = 0.0f;
-	out->m[3][1] = 0.0f;
-	out->m[3][2] = 0.0f;
-	out->m[3][3] = 1.0f;
-}
-
-inline
-void InverseTransposeUpper3x3Mat4f( Mat4f *__restrict a_pMat, Mat4f *__restrict out )
-{
-	f32 fDet = DeterminantUpper3x3Mat4f( a_pMat );
-#if MAIN_DEBUG
-	assert( fDet != 0.f );
-#endif
-	f32 fInvDet = 1.0f / fDet;
-	out->m[0][0] = fInvDet * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]));
-	out->m[0][1] = fInvDet * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[2][2]*a_pMat->m[1][0]));
-	out->m[0][2] = fInvDet * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[1][1]*a_pMat->m[2][0]));
-	out->m[0][3] = 0.0f;
-
-	out->m[1][0] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[2][1]) - (a_pMat->m[0][1]*a_pMat->m[2][2]));
-	out->m[1][1] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[2][2]) - (a_pMat->m[0][2]*a_pMat->m[2][0])); 
-	out->m[1][2] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[2][0]) - (a_pMat->m[0][0]*a_pMat->m[2][1]));
-	out->m[1][3] = 0.0f;
-
-	out->m[2][0] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[1][2]) - (a_pMat->m[0][2]*a_pMat->m[1][1]));
-	out->m[2][1] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[1][0]) - (a_pMat->m[1][2]*a_pMat->m[0][0]));
-	out->m[2][2] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[1][1]) - (a_pMat->m[1][0]*a_pMat->m[0][1]));
-	out->m[2][3] = 0.0f;
-
-	out->m[3][0] = 0.0f;
-	out->m[3][1] = 0.0f;
-	out->m[3][2] = 0.0f;
-	out->m[3][3] = 1.0f;
-}
-
-inline
-void InverseTransposeUpper3x3Mat4f( Mat4f *__restrict a_pMat, Mat3x4f *__restrict out )
-{
-	f32 fDet = DeterminantUpper3x3Mat4f( a_pMat );
-#if MAIN_DEBUG
-	assert( fDet != 0.f );
-#endif
-	f32 fInvDet = 1.0f / fDet;
-	out->m[0][0] = fInvDet * ((a_pMat->m[1][1]*a_pMat->m[2][2]) - (a_pMat->m[1][2]*a_pMat->m[2][1]));
-	out->m[0][1] = fInvDet * ((a_pMat->m[2][0]*a_pMat->m[1][2]) - (a_pMat->m[2][2]*a_pMat->m[1][0]));
-	out->m[0][2] = fInvDet * ((a_pMat->m[1][0]*a_pMat->m[2][1]) - (a_pMat->m[1][1]*a_pMat->m[2][0]));
-	out->m[0][3] = 0.0f;
-
-	out->m[1][0] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[2][1]) - (a_pMat->m[0][1]*a_pMat->m[2][2]));
-	out->m[1][1] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[2][2]) - (a_pMat->m[0][2]*a_pMat->m[2][0])); 
-	out->m[1][2] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[2][0]) - (a_pMat->m[0][0]*a_pMat->m[2][1]));
-	out->m[1][3] = 0.0f;
-
-	out->m[2][0] = fInvDet * ((a_pMat->m[0][1]*a_pMat->m[1][2]) - (a_pMat->m[0][2]*a_pMat->m[1][1]));
-	out->m[2][1] = fInvDet * ((a_pMat->m[0][2]*a_pMat->m[1][0]) - (a_pMat->m[1][2]*a_pMat->m[0][0]));
-	out->m[2][2] = fInvDet * ((a_pMat->m[0][0]*a_pMat->m[1][1]) - (a_pMat->m[1][0]*a_pMat->m[0][1]));
-	out->m[2][3] = 0.0f;
-}
-
-
-inline
-void Mat4fMult( Mat4f *__restrict a, Mat4f *__restrict b, Mat4f *__restrict out)
-{
-	out->m[0][0] = a->m[0][0]*b->m[0][0] + a->m[0][1]*b->m[1][0] + a->m[0][2]*b->m[2][0] + a->m[0][3]*b->m[3][0];
-	out->m[0][1] = a->m[0][0]*b->m[0][1] + a->m[0][1]*b->m[1][1] + a->m[0][2]*b->m[2][1] + a->m[0][3]*b->m[3][1];
-	out->m[0][2] = a->m[0][0]*b->m[0][2] + a->m[0][1]*b->m[1][2] + a->m[0][2]*b->m[2][2] + a->m[0][3]*b->m[3][2];
-	out->m[0][3] = a->m[0][0]*b->m[0][3] + a->m[0][1]*b->m[1][3] + a->m[0][2]*b->m[2][3] + a->m[0][3]*b->m[3][3];
-
-	out->m[1][0] = a->m[1][0]*b->m[0][0] + a->m[1][1]*b->m[1][0] + a->m[1][2]*b->m[2][0] + a->m[1][3]*b->m[3][0];
-	out->m[1][1] = a->m[1][0]*b->m[0][1] + a->m[1][1]*b->m[1][1] + a->m[1][2]*b->m[2][1] + a->m[1][3]*b->m[3][1];
-	out->m[1][2] = a->m[1][0]*b->m[0][2] + a->m[1][1]*b->m[1][2] + a->m[1][2]*b->m[2][2] + a->m[1][3]*b->m[3][2];
-	out->m[1][3] = a->m[1][0]*b->m[0][3] + a->m[1][1]*b->m[1][3] + a->m[1][2]*b->m[2][3] + a->m[1][3]*b->m[3][3];
-
-	out->m[2][0] = a->m[2][0]*b->m[0][0] + a->m[2][1]*b->m[1][0] + a->m[2][2]*b->m[2][0] + a->m[2][3]*b->m[3][0];
-	out->m[2][1] = a->m[2][0]*b->m[0][1] + a->m[2][1]*b->m[1][1] + a->m[2][2]*b->m[2][1] + a->m[2][3]*b->m[3][1];
-	out->m[2][2] = a->m[2][0]*b->m[0][2] + a->m[2][1]*b->m[1][2] + a->m[2][2]*b->m[2][2] + a->m[2][3]*b->m[3][2];
-	out->m[2][3] = a->m[2][0]*b->m[0][3] + a->m[2][1]*b->m[1][3] + a->m[2][2]*b->m[2][3] + a->m[2][3]*b->m[3][3];
-
-	out->m[3][0] = a->m[3][0]*b->m[0][0] + a->m[3][1]*b->m[1][0] + a->m[3][2]*b->m[2][0] + a->m[3][3]*b->m[3][0];
-	out->m[3][1] = a->m[3][0]*b->m[0][1] + a->m[3][1]*b->m[1][1] + a->m[3][2]*b->m[2][1] + a->m[3][3]*b->m[3][1];
-	out->m[3][2] = a->m[3][0]*b->m[0][2] + a->m[3][1]*b->m[1][2] + a->m[3][2]*b->m[2][2] + a->m[3][3]*b->m[3][2];
-	out->m[3][3] = a->m[3][0]*b->m[0][3] + a->m[3][1]*b->m[1][3] + a->m[3][2]*b->m[2][3] + a->m[3][3]*b->m[3][3];
-}
-
-inline
-void Vec3fAdd( Vec3f *a, Vec3f *b, Vec3f *out )
-{
-	out->x = a->x + b->x;
-	out->y = a->y + b->y;
-	out->z = a->z + b->z;
-}
-
-inline
-void Vec3fSub( Vec3f *a, Vec3f *b, Vec3f *out )
-{
-	out->x = a->x - b->x;
-	out->y = a->y - b->y;
-	out->z = a->z - b->z;
-}
-
-inline
-void Vec3fMult( Vec3f *a, Vec3f *b, Vec3f *out )
-{
-	out->x = a->x * b->x;
-	out->y = a->y * b->y;
-	out->z = a->z * b->z;
-}
-
-inline
-void Vec3fCross( Vec3f *a, Vec3f *b, Vec3f *out )
-{
-	out->x = (a->y * b->z) - (a->z * b->y);
-	out->y = (a->z * b->x) - (a->x * b->z);
-	out->z = (a->x * b->y) - (a->y * b->x);
-}
-
-inline
-void Vec3fScale( Vec3f *a, f32 scale, Vec3f *out )
-{
-	out->x = a->x * scale;
-	out->y = a->y * scale;
-	out->z = a->z * scale;
-}
-
-
-inline
-void Vec3fScaleAdd( Vec3f *a, f32 scale, Vec3f *b, Vec3f *out )
-{
-	out->x = (a->x * scale) + b->x;
-	out->y = (a->y * scale) + b->y;
-	out->z = (a->z * scale) + b->z;
-}
-
-inline
-f32 Vec3fDot( Vec3f *a, Vec3f *b )
-{
-	return (a->x * b->x) + (a->y * b->y) + (a->z * b->z);
-}
-
-inline
-void Vec3fNormalize( Vec3f *a, Vec3f *out )
-{
-
-	f32 mag = sqrtf((a->x*a->x) + (a->y*a->y) + (a->z*a->z));
-	if(mag == 0)
-	{
-		out->x = 0;
-		out->y = 0;
-		out->z = 0;
-	}
-	else
-	{
-		out->x = a->x/mag;
-		out->y = a->y/mag;
-		out->z = a->z/mag;
-	}
-}
-
-
-inline
-void Vec3fLerp( Vec3f *a, Vec3f *b, f32 fT, Vec3f *out )
-{
-	Vec3f vTmp;
-	Vec3fSub(b,a,&vTmp);
-	Vec3fScaleAdd(&vTmp,fT,a,out);
-}
-
-inline
-void Vec3fRotByUnitQuat(Vec3f *v, Quatf *__restrict q, Vec3f *out)
-{
-    f32 fVecScalar = (2.0f*q->w*q->w)-1;
-    f32 fQuatVecScalar = 2.0f* Vec3fDot(v,&q->v);
-
-    Vec3f vScaledQuatVec;
-    Vec3f vScaledVec;
-    Vec3fScale(&q->v,fQuatVecScalar,&vScaledQuatVec);
-    Vec3fScale(v,fVecScalar,&vScaledVec);
-
-    Vec3f vQuatCrossVec;
-    Vec3fCross(&q->v, v, &vQuatCrossVec);
-
-    Vec3fScale(&vQuatCrossVec,2.0f*q->w,&vQuatCrossVec);
-
-    Vec3fAdd(&vScaledQuatVec,&vScaledVec,out);
-    Vec3fAdd(out,&vQuatCrossVec,out);
-}
-
-/*
-inline
-void Vec3fRotByUnitQuat(Vec3f *v, Quatf *__restrict q, Vec3f *out)
-{
-	Vec3f vDoubleRot;
-	vDoubleRot.x = q->x + q->x;
-	vDoubleRot.y = q->y + q->y;
-	vDoubleRot.z = q->z + q->z;
-
-	Vec3f vScaledWRot;
-	vScaledWRot.x = q->w * vDoubleRot.x;
-	vScaledWRot.y = q->w * vDoubleRot.y;
-	vScaledWRot.z = q->w * vDoubleRot.z;
-
-	Vec3f vScaledXRot;
-	vScaledXRot.x = q->x * vDoubleRot.x;
-	vScaledXRot.y = q->x * vDoubleRot.y;
-	vScaledXRot.z = q->x * vDoubleRot.z;
-
-	f32 fScaledYRot0 = q->y * vDoubleRot.y;
-	f32 fScaledYRot1 = q->y * vDoubleRot.z;
-
-	f32 fScaledZRot0 = q->z * vDoubleRot.z;
-
-	out->x = ((v->x * ((1.f - fScaledYRot0) - fScaledZRot0)) + (v->y * (vScaledXRot.y - vScaledWRot.z))) + (v->z * (vScaledXRot.z + vScaledWRot.y));
-	out->y = ((v->x * (vScaledXRot.y + vScaledWRot.z)) + (v->y * ((1.f - vScaledXRot.x) - fScaledZRot0))) + (v->z * (fScaledYRot1 - vScaledWRot.x));
-	out->z = ((v->x * (vScaledXRot.z - vScaledWRot.y)) + (v->y * (fScaledYRot1 + vScaledWRot.x))) + (v->z * ((1.f - vScaledXRot.x) - fScaledYRot0));
-}
-*/
-
-
-inline
-void InitUnitQuatf( Quatf *q, f32 angle, Vec3f *axis )
-{
-	f32 s = sinf(angle*PI_F/360.0f);
-	q->w = cosf(angle*PI_F/360.0f);
-	q->x = axis->x * s;
-	q->y = axis->y * s;
-	q->z = axis->z * s;
-}
-
-inline
-void QuatfMult( Quatf *__restrict a, Quatf *__restrict b, Quatf *__restrict out )
-{
-	out->w = (a->w * b->w) - (a->x* b->x) - (a->y* b->y) - (a->z* b->z);
-	out->x = (a->w * b->x) + (a->x* b->w) + (a->y* b->z) - (a->z* b->y);
-	out->y = (a->w * b->y) + (a->y* b->w) + (a->z* b->x) - (a->x* b->z);
-	out->z = (a->w * b->z) + (a->z* b->w) + (a->x* b->y) - (a->y* b->x);
-}
-
-inline
-void QuatfSub( Quatf *a, Quatf *b, Quatf *out )
-{
-	out->w = a->w - b->w;
-	out->x = a->x - b->x;
-	out->y = a->y - b->y;
-	out->z = a->z - b->z;
-}
-
-inline
-void QuatfScaleAdd( Quatf *a, f32 scale, Quatf *b, Quatf *out )
-{
-	out->w = (a->w * scale) + b->w;
-	out->x = (a->x * scale) + b->x;
-	out->y = (a->y * scale) + b->y;
-	out->z = (a->z * scale) + b->z;
-}
-
-inline
-void QuatfNormalize( Quatf *a, Quatf *out )
-{
-
-	f32 mag = sqrtf((a->w*a->w) + (a->x*a->x) + (a->y*a->y) + (a->z*a->z));
-	if(mag == 0.f)
-	{
-		out->w = 0.f;
-		out->x = 0.f;
-		out->y = 0.f;
-		out->z = 0.f;
-	}
-	else
-	{
-		out->w = a->w/mag;
-		out->x = a->x/mag;
-		out->y = a->y/mag;
-		out->z = a->z/mag;
-	}
-}
-
-//todo simplify to reduce floating point error
-inline
-void InitViewMat4ByQuatf( Mat4f *a_pMat, Quatf *a_qRot, Vec3f *a_pPos )
-{
-	a_pMat->m[0][0] = 1.0f - 2.0f*(a_qRot->y*a_qRot->y + a_qRot->z*a_qRot->z);                            a_pMat->m[0][1] = 2.0f*(a_qRot->x*a_qRot->y - a_qRot->w*a_qRot->z);                                   a_pMat->m[0][2] = 2.0f*(a_qRot->x*a_qRot->z + a_qRot->w*a_qRot->y);        		                      a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 2.0f*(a_qRot->x*a_qRot->y + a_qRot->w*a_qRot->z);                                   a_pMat->m[1][1] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->z*a_qRot->z);                            a_pMat->m[1][2] = 2.0f*(a_qRot->y*a_qRot->z - a_qRot->w*a_qRot->x);        		                      a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 2.0f*(a_qRot->x*a_qRot->z - a_qRot->w*a_qRot->y);                                   a_pMat->m[2][1] = 2.0f*(a_qRot->y*a_qRot->z + a_qRot->w*a_qRot->x);                                   a_pMat->m[2][2] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->y*a_qRot->y); 		                      a_pMat->m[2][3] = 0;
-	a_pMat->m[3][0] = -a_pPos->x*a_pMat->m[0][0] - a_pPos->y*a_pMat->m[1][0] - a_pPos->z*a_pMat->m[2][0]; a_pMat->m[3][1] = -a_pPos->x*a_pMat->m[0][1] - a_pPos->y*a_pMat->m[1][1] - a_pPos->z*a_pMat->m[2][1]; a_pMat->m[3][2] = -a_pPos->x*a_pMat->m[0][2] - a_pPos->y*a_pMat->m[1][2] - a_pPos->z*a_pMat->m[2][2]; a_pMat->m[3][3] = 1;
-}
-
-inline
-void InitModelMat4ByQuatf( Mat4f *a_pMat, Quatf *a_qRot, Vec3f *a_pPos )
-{
-	a_pMat->m[0][0] = 1.0f - 2.0f*(a_qRot->y*a_qRot->y + a_qRot->z*a_qRot->z);                            a_pMat->m[0][1] = 2.0f*(a_qRot->x*a_qRot->y + a_qRot->w*a_qRot->z);                                   a_pMat->m[0][2] = 2.0f*(a_qRot->x*a_qRot->z - a_qRot->w*a_qRot->y);        		                      a_pMat->m[0][3] = 0;
-	a_pMat->m[1][0] = 2.0f*(a_qRot->x*a_qRot->y - a_qRot->w*a_qRot->z);                                   a_pMat->m[1][1] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->z*a_qRot->z);                            a_pMat->m[1][2] = 2.0f*(a_qRot->y*a_qRot->z + a_qRot->w*a_qRot->x);        		                      a_pMat->m[1][3] = 0;
-	a_pMat->m[2][0] = 2.0f*(a_qRot->x*a_qRot->z + a_qRot->w*a_qRot->y);                                   a_pMat->m[2][1] = 2.0f*(a_qRot->y*a_qRot->z - a_qRot->w*a_qRot->x);                                   a_pMat->m[2][2] = 1.0f - 2.0f*(a_qRot->x*a_qRot->x + a_qRot->y*a_qRot->y); 		                      a_pMat->m[2][3] = 0;
-	//a_pMat->m[3][0] = a_pPos->x*a_pMat->m[0][0] + a_pPos->y*a_pMat->m[1][0] + a_pPos->z*a_pMat->m[2][0];  a_pMat->m[3][1] = a_pPos->x*a_pMat->m[0][1] + a_pPos->y*a_pMat->m[1][1] + a_pPos->z*a_pMat->m[2][1]; a_pMat->m[3][2] = a_pPos->x*a_pMat->m[0][2] + a_pPos->y*a_pMat->m[1][2] + a_pPos->z*a_pMat->m[2][2]; a_pMat->m[3][3] = 1;
-	a_pMat->m[3][0] = a_pPos->x;  a_pMat->m[3][1] = a_pPos->y; a_pMat->m[3][2] = a_pPos->z; a_pMat->m[3][3] = 1.f;
-}
-
-inline
-void QuatfNormLerp( Quatf *a, Quatf *b, f32 fT, Quatf *out )
-{
-	Quatf qTmp;
-	QuatfSub(b,a,&qTmp);
-	QuatfScaleAdd(&qTmp,fT,a,out);
-	QuatfNormalize(out,out);
-}
-
-inline
-void QuatfSlerp( Vec3f *a, Vec3f *b, f32 fT, Vec3f *out )
-{
-	//todo
-}
-
-#if MAIN_DEBUG
-void PrintMat4f( Mat4f *a_pMat )
-{
-	for( u32 dwIdx = 0; dwIdx < 4; ++dwIdx )
-	{
-		for( u32 dwJdx = 0; dwJdx < 4; ++dwJdx )
-		{
-			printf("%f ", a_pMat->m[dwIdx][dwJdx] );
-		}
-		printf("\n");
-	}
-}
-#endif
-
-f32 clamp(f32 d, f32 min, f32 max) {
-  const f32 t = d < min ? min : d;
-  return t > max ? max : t;
-}
-
-u32 max( u32 a, u32 b )
-{
-	return a > b ? a : b;
-}
-
+//sim thread owned, copied into the frame packet every frame so these don't need to be per swap chain frame anymore
+Mat4f mHandFrameFinalBones[ovrHand_Count][handBonesCount]; //initialize these to first frame of animation!
+f32 fPrevSideFingerDownAmount[ovrHand_Count] = { 0.0f };
+f32 fPrevIndexFingerDownAmount[ovrHand_Count] = { 0.0f };
 
 int logError(const char* msg)
 {
@@ -788,6 +216,26 @@ int logError(const char* msg)
     return -1;
 }
 
+#include "IK.h"
+#include "InputPrediction.h"
+#include "Profiler.h"
+#include "Workers.h"
+#include "Scene.h"
+#include "FramePacket.h"
+#include "GpuTimer.h"
+#include "Telemetry.h"
+#include "DynamicResolution.h"
+#include "DepthLayer.h"
+#include "Culling.h"
+#include "Bvh.h"
+#include "RenderQueue.h"
+#include "IndirectDraw.h"
+#include "Meshlets.h"
+#include "Foveation.h"
+#include "PipelineCache.h"
+#include "FrameRender.h"
+#include "SoftRaster.h"
+
 void CloseProgram()
 {
 	Running = 0;
@@ -819,13 +267,13 @@ void InitStartingGameState()
 {
 	Running = 1;
     isPaused = 0;
+    InitInputPrediction();
 }
 
 inline
 void InitHeadsetGraphicsState()
 {
-	pixelConstantBuffer.vLightColor = {0.83137f,0.62745f,0.09020f,1.0f};
-	pixelConstantBuffer.vInvLightDir = {0.57735026919f,0.57735026919f,0.57735026919f};
+	FrameInitPixelConstants( &pixelConstantBuffer );
 }
 
 inline
@@ -840,57 +288,23 @@ void InitStartingCamera()
 inline 
 void InitStartingSkeletons( u32 dwNumFrames )
 {
-	Mat4f mHandFrameBindBones[ovrHand_Count][handBonesCount];
 	for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
 	{
-		InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans );
-		Mat4fMult(&handInvBind[0], &mHandFrameBindBones[dwHand][0],&mHandFrameFinalBones[0][dwHand][0]);
-		for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
-		{				
-			Mat4f mLocalFrameBone;
-			InitModelMat4ByQuatf( &mLocalFrameBone, &handInnerKeyFrames[0][dwBone-firstInnerBone].qRot, &handInnerKeyFrames[0][dwBone-firstInnerBone].vPos );
-			Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-			Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-		}
-		for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
-		{				
-			Mat4f mLocalFrameBone;
-			InitModelMat4ByQuatf( &mLocalFrameBone, &handOutterKeyFrames[0][dwBone-firstOutterBone].qRot, &handOutterKeyFrames[0][dwBone-firstOutterBone].vPos );
-			Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-			Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-		}
-
-		u8* pUploadBoneBufferData;
-		if( FAILED( boneBuffer[0][dwHand]->Map( 0, nullptr, (void**) &pUploadBoneBufferData ) ) )
-		{
-		    return;
-		}
-		memcpy(pUploadBoneBufferData,&mHandFrameFinalBones[0][dwHand],sizeof(Mat4f)*handBonesCount);
-		boneBuffer[0][dwHand]->Unmap( 0, nullptr );
+		FrameHandStartingBones( mHandFrameFinalBones[dwHand] );
 
-		fPrevSideFingerDownAmount[0][dwHand] = 0.0f;
-		fPrevIndexFingerDownAmount[0][dwHand] = 0.0f; 
-	}
-	for( u32 dwFrame = 1; dwFrame < dwNumFrames; ++dwFrame )
-	{
-		for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
+		for( u32 dwFrame = 0; dwFrame < dwNumFrames; ++dwFrame )
 		{
-			for( u32 dwBone = 0; dwBone < handBonesCount; ++dwBone )
-			{	
-				mHandFrameFinalBones[dwFrame][dwHand][dwBone] = mHandFrameFinalBones[0][dwHand][dwBone];
-			}
-
 			u8* pUploadBoneBufferData;
-			if( FAILED( boneBuffer[dwFrame][dwHand]->Map( 0, nullptr, (void**) &pUploadBoneBufferData ) ) )
+			if( FAILED( boneBuffer[dwFrame]->Map( 0, nullptr, (void**) &pUploadBoneBufferData ) ) )
 			{
 			    return;
 			}
-			memcpy(pUploadBoneBufferData,&mHandFrameFinalBones[dwFrame][dwHand],sizeof(Mat4f)*handBonesCount);
-			boneBuffer[dwFrame][dwHand]->Unmap( 0, nullptr );
-
-			fPrevSideFingerDownAmount[dwFrame][dwHand] = 0.0f;
-			fPrevIndexFingerDownAmount[dwFrame][dwHand] = 0.0f; 
+			memcpy(pUploadBoneBufferData + (dwHand*BONE_PALETTE_SIZE),&mHandFrameFinalBones[dwHand],sizeof(Mat4f)*handBonesCount);
+			boneBuffer[dwFrame]->Unmap( 0, nullptr );
 		}
+
+		fPrevSideFingerDownAmount[dwHand] = 0.0f;
+		fPrevIndexFingerDownAmount[dwHand] = 0.0f; 
 	}
 }
 
@@ -1113,55 +527,21 @@ ID3D12DescriptorHeap *InitDepthStencilDescriptorHeap( ID3D12Device* dxd3Device,
 	return dsvHeap;
 }
 
-inline
-ID3D12DescriptorHeap *InitSRVDescriptorHeap()
-{
-	return nullptr;
-}
-
 
+//the depth targets are ovr swap chains so the compositor can read them (ovrLayerEyeFovDepth), one buffer per swap chain index like color
+//the cpu never touches them but the compositor may still be sampling the last one we committed while we render the next
 inline
-bool CreateDepthStencilBuffer()
-{
-	/*
-	frame time->
-	|--- prev ---|--- curr ---|--- next ---|
-
-	we only need 1 depth buffer currently, since the cpu is not mutating it while it is actively rendering (unlike uniforms). 
-	and it is reset within the command lists and only actively used within the current frame rendering. (it is synchronous within the command list, this is not always the case, but here it is) (unlike swap chain buffers which cannot be mutated until after the screen is done with them)
-
-	only 1 frame will be using it as a time, since one frame doesn't start rendering until the last one is finished executing its command lists (maybe in future programs, this won't be true)
-	
-	hence we only need 1 depth buffer here.
-
-	"Since we are only using a single command queue for rendering, then all of the rendering commands are executed serially in the queue so the depth buffer will not be accessed by multiple queues at the same time. The reason why we need multiple color buffers is because we can’t write the next frame until the Windows Driver Display Model (WDDM) is finished presenting the frame on the screen. Stalling the CPU thread until the frame is finished being presented is not efficient so to avoid the stall, we simply render to a different (front) buffer. Since the depth buffer is not used by WDDM, we don’t need to create multiple depth buffers!"
-
-	Note: You cannot use this trick if you need GBuffer Depth information!
-	
-	*/
-
-	D3D12_HEAP_PROPERTIES depthBuffHeapBufferDesc; //describes heap type
-	depthBuffHeapBufferDesc.Type = D3D12_HEAP_TYPE_DEFAULT;
-	depthBuffHeapBufferDesc.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	depthBuffHeapBufferDesc.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-	depthBuffHeapBufferDesc.CreationNodeMask = 1;
-	depthBuffHeapBufferDesc.VisibleNodeMask = 1;
-
-	D3D12_RESOURCE_DESC depthBufferDesc; //describes what is placed in heap
-  	depthBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-  	depthBufferDesc.Alignment = 0;
-  	depthBufferDesc.DepthOrArraySize = 1;
-  	depthBufferDesc.MipLevels = 0;
-  	depthBufferDesc.Format = DXGI_FORMAT_D32_FLOAT;
-  	depthBufferDesc.SampleDesc.Count = 1;
-  	depthBufferDesc.SampleDesc.Quality = 0;
-  	depthBufferDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-  	depthBufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-	D3D12_CLEAR_VALUE depthClearValue;
-	depthClearValue.Format = DXGI_FORMAT_D32_FLOAT;
-	depthClearValue.DepthStencil.Depth = 1.0f;
-	depthClearValue.DepthStencil.Stencil = 0;
+bool CreateEyeDepthSwapChains()
+{
+	ovrTextureSwapChainDesc eyeSwapchainDepthTextureDesc;
+	eyeSwapchainDepthTextureDesc.Type = ovrTexture_2D;
+	eyeSwapchainDepthTextureDesc.Format = OVR_FORMAT_D32_FLOAT;
+	eyeSwapchainDepthTextureDesc.ArraySize = 1;
+	eyeSwapchainDepthTextureDesc.MipLevels = 1;
+	eyeSwapchainDepthTextureDesc.SampleCount = dwSampleRate;
+	eyeSwapchainDepthTextureDesc.StaticImage = ovrFalse;
+	eyeSwapchainDepthTextureDesc.MiscFlags = ovrTextureMisc_DX_Typeless; //R32_TYPELESS so the compositor can make its srv and we our dsv
+	eyeSwapchainDepthTextureDesc.BindFlags = ovrTextureBind_DX_DepthStencil;
 
 	D3D12_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc;
 	depthStencilViewDesc.Format = DXGI_FORMAT_D32_FLOAT;
@@ -1170,26 +550,42 @@ bool CreateDepthStencilBuffer()
 	depthStencilViewDesc.Texture2D.MipSlice = 0;
 
 	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-	u64 dsvDescriptorSize = device->GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE_DSV );
+	dsvDescriptorSize = device->GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE_DSV );
 
 	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
 	{
-		ovrSizei oculusIdealSize = ovr_GetFovTextureSize( oculusSession, (ovrEyeType)dwEye, oculusHMDDesc.DefaultEyeFov[dwEye], 1.0f );
-		depthBufferDesc.Width = oculusIdealSize.w;
-  		depthBufferDesc.Height = oculusIdealSize.h;
-  		//TODO HOW TO COMBINE INTO 1 HEAP!
-		if( FAILED( device->CreateCommittedResource( &depthBuffHeapBufferDesc, D3D12_HEAP_FLAG_NONE, &depthBufferDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClearValue, IID_PPV_ARGS( &depthStencilBuffers[dwEye] ) ) ) )
+		//same size as the color chain, the depth layer needs them to map 1:1
+		eyeSwapchainDepthTextureDesc.Width = oculusEyeRenderViewport[dwEye].Size.w;
+		eyeSwapchainDepthTextureDesc.Height = oculusEyeRenderViewport[dwEye].Size.h;
+		if( ovr_CreateTextureSwapChainDX( oculusSession, commandQueue, &eyeSwapchainDepthTextureDesc, &oculusEyeDepthSwapChains[dwEye] ) < 0 )
 		{
-			logError( "Failed to allocate depth buffer!\n" );
-			CloseProgram();
+			logError( "Failed to create depth swap chain texture for eye!\n" );
 			return false;
 		}
+
+		s32 depthTextureCount;
+		ovr_GetTextureSwapChainLength( oculusSession, oculusEyeDepthSwapChains[dwEye], &depthTextureCount );
+		if( depthTextureCount != (s32)oculusNUM_FRAMES )
+		{
+			//the buffer/descriptor arrays are sized off the color chain
+			logError( "Depth swap chain length does not match the color swap chain!\n" );
+			return false;
+		}
+
+		eyeStartingDSVHandle[dwEye] = dsvHandle;
+		for( u32 dwIdx = 0; dwIdx < oculusNUM_FRAMES; ++dwIdx )
+		{
+			if( ovr_GetTextureSwapChainBufferDX( oculusSession, oculusEyeDepthSwapChains[dwEye], dwIdx, IID_PPV_ARGS(&oculusEyeDepthBuffers[(dwEye*oculusNUM_FRAMES) + dwIdx])) < 0 )
+			{
+				logError( "Failed to get depth swap chain buffer!\n" );
+				return false;
+			}
 #if MAIN_DEBUG
-		depthStencilBuffers[dwEye]->SetName(L"Eye Depth/Stencil Default Heap");
+			oculusEyeDepthBuffers[(dwEye*oculusNUM_FRAMES) + dwIdx]->SetName(L"Eye Depth Swap Chain Texture");
 #endif
-		eyeDSVHandle[dwEye] = dsvHandle;
-		device->CreateDepthStencilView( depthStencilBuffers[dwEye], &depthStencilViewDesc, dsvHandle );
-		dsvHandle.ptr = (u64)dsvHandle.ptr + dsvDescriptorSize;
+			device->CreateDepthStencilView( oculusEyeDepthBuffers[(dwEye*oculusNUM_FRAMES) + dwIdx], &depthStencilViewDesc, dsvHandle );
+			dsvHandle.ptr = (u64)dsvHandle.ptr + dsvDescriptorSize;
+		}
 	}
 	return true;
 }
@@ -1210,7 +606,7 @@ void InitSRVUploadHeap( u32 dwGPUNumber, u32 dwVisibleGPUMask ) //we conly need
 	heapBufferDesc.CreationNodeMask = dwGPUNumber;
 	heapBufferDesc.VisibleNodeMask = dwVisibleGPUMask; //todo
 
-	const u64 qwFrameSize = (handBonesCount * sizeof( Mat4f ));
+	const u64 qwFrameSize = BONE_PALETTE_SIZE * ovrHand_Count; //one buffer per frame so an instanced draw can index any hand's palette
 
 	//todo
 	D3D12_RESOURCE_DESC resourceBufferDesc; //describes what is placed in heap
@@ -1230,7 +626,7 @@ void InitSRVUploadHeap( u32 dwGPUNumber, u32 dwVisibleGPUMask ) //we conly need
 	u64 qwNumFullAlignments = qwFrameSize / allocInfo.Alignment;
 	const u64 qwAlignedFrameSize = (qwNumFullAlignments * allocInfo.Alignment) + ((qwFrameSize % allocInfo.Alignment) > 0 ? allocInfo.Alignment : 0);
 	resourceBufferDesc.Width = qwAlignedFrameSize; //allocations fail if we don't take up the entire page :/
-	const u64 qwHeapSize = qwAlignedFrameSize * oculusNUM_FRAMES * ovrHand_Count; //TODO THIS MAY BE WRONG AS each resource may need to be 65536 aligned, then if so increase the max bone count?
+	const u64 qwHeapSize = qwAlignedFrameSize * oculusNUM_FRAMES;
 
 	D3D12_HEAP_DESC boneHeapDesc;
 	boneHeapDesc.SizeInBytes = qwHeapSize;
@@ -1246,57 +642,18 @@ void InitSRVUploadHeap( u32 dwGPUNumber, u32 dwVisibleGPUMask ) //we conly need
 	pSrvBoneHeap->SetName( L"SRV Bone Buffer Upload Resource Heap" );
 #endif
 
-	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc;
-	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	srvHeapDesc.NumDescriptors = oculusNUM_FRAMES*ovrHand_Count; 
-	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	srvHeapDesc.NodeMask = dwGPUNumber;
-
-	if( FAILED( device->CreateDescriptorHeap( &srvHeapDesc, IID_PPV_ARGS( &srvDescriptorHeap ) ) ) )
-	{
-		return;
-	}
-#if MAIN_DEBUG
-	srvDescriptorHeap->SetName( L"SRV Bone Buffer Descriptor Heap" );
-#endif
-
-	srvDescriptorSize = device->GetDescriptorHandleIncrementSize( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
-	D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-
-	//final state D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
-	//can we just transistion the heap/resoyrce a bunch between states for cheap?
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
-	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-	srvDesc.Shader4ComponentMapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(0,1,2,3);
-	srvDesc.Buffer.FirstElement = 0; //index
-#if ARRAY_IN_STRUCTURED_BUFFER
-	srvDesc.Buffer.NumElements = 1;
-	srvDesc.Buffer.StructureByteStride = MAX_BONES * sizeof( Mat4f );
-#else
-	srvDesc.Buffer.NumElements = MAX_BONES;
-	srvDesc.Buffer.StructureByteStride = sizeof( Mat4f );
-#endif
-	srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE; //D3D12_BUFFER_SRV_FLAG_RAW (I believe for byte-addressable buffers)
-
+	//no descriptors, RenderFrame binds each hand's palette as a root SRV at its offset in the frame's buffer (renderPalettes)
   	//verify that we are using the advanced model!
   	for( u32 dwFrame = 0; dwFrame < oculusNUM_FRAMES; ++dwFrame )
   	{
-  		for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
-  		{
-  			//can i set state to D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE?
-  			//D3D12_RESOURCE_STATE_COMMON
-  			//D3D12_RESOURCE_STATE_GENERIC_READ
-			HRESULT allocres = device->CreatePlacedResource( pSrvBoneHeap, (dwFrame*ovrHand_Count + dwHand)*qwAlignedFrameSize, &resourceBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&boneBuffer[dwFrame][dwHand]) );
+		//can i set state to D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE?
+		//D3D12_RESOURCE_STATE_COMMON
+		//D3D12_RESOURCE_STATE_GENERIC_READ
+		HRESULT allocres = device->CreatePlacedResource( pSrvBoneHeap, dwFrame*qwAlignedFrameSize, &resourceBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&boneBuffer[dwFrame]) );
 #if MAIN_DEBUG
-			PrintDirectXErrorCode(allocres);
-			boneBuffer[dwFrame][dwHand]->SetName(L"Bone Buffer");
+		PrintDirectXErrorCode(allocres);
+		boneBuffer[dwFrame]->SetName(L"Bone Buffer");
 #endif
-			//sets the descriptor to point to the resource
-			device->CreateShaderResourceView( boneBuffer[dwFrame][dwHand],&srvDesc,srvHandle); //used in descriptor table (can I do without this function and just set a struct? like vertex and index buffer views?)
-			srvHandle.ptr = (u64)srvHandle.ptr + srvDescriptorSize;
-		}
 	}
 }
 
@@ -1316,7 +673,8 @@ void UploadModels( u32 dwGPUNumber, u32 dwVisibleGPUMask )
 	heapBufferDesc.CreationNodeMask = dwGPUNumber;
 	heapBufferDesc.VisibleNodeMask = dwVisibleGPUMask;
 
-	const u64 qwModelSize = sizeof(planeVertices) + sizeof(planeIndices) + sizeof(cubeVertices) + sizeof(cubeIndicies) + sizeof(handVertices) + sizeof(handIndices);
+	//plane, cube then hand, each mesh's vertices then its indices (FrameWriteModels)
+	const u64 qwModelSize = FrameBuildMeshIndices( meshIndices );
 
 	D3D12_RESOURCE_DESC resourceBufferDesc; //describes what is placed in heap
   	resourceBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -1367,16 +725,12 @@ void UploadModels( u32 dwGPUNumber, u32 dwVisibleGPUMask )
     {
         return;
     }
-    memcpy(pUploadBufferData,planeVertices,sizeof(planeVertices));
-    memcpy(pUploadBufferData+sizeof(planeVertices),planeIndices,sizeof(planeIndices));
-    memcpy(pUploadBufferData+sizeof(planeVertices)+sizeof(planeIndices),cubeVertices,sizeof(cubeVertices));
-    memcpy(pUploadBufferData+sizeof(planeVertices)+sizeof(planeIndices)+sizeof(cubeVertices),cubeIndicies,sizeof(cubeIndicies));
-    memcpy(pUploadBufferData+sizeof(planeVertices)+sizeof(planeIndices)+sizeof(cubeVertices)+sizeof(cubeIndicies),handVertices,sizeof(handVertices));
-    memcpy(pUploadBufferData+sizeof(planeVertices)+sizeof(planeIndices)+sizeof(cubeVertices)+sizeof(cubeIndicies)+sizeof(handVertices),handIndices,sizeof(handIndices));
+    //does this apply in my case https://twitter.com/MyNameIsMJP/status/1574431011579928580 ?
+    FrameWriteModels( pUploadBufferData, defaultBuffer->GetGPUVirtualAddress(), meshIndices, meshVertexBufferViews, meshIndexBufferViews );
     uploadBuffer->Unmap( 0, nullptr );
 
 	commandLists[ovrEye_Count]->CopyResource( defaultBuffer, uploadBuffer );
-	//commandLists[ovrEye_Count]->CopyBufferRegion( defaultBuffer, 0, uploadBuffer, 0, sizeof(planeVertices)+sizeof(planeIndices)+sizeof(cubeVertices)+sizeof(cubeIndicies) );
+	//commandLists[ovrEye_Count]->CopyBufferRegion( defaultBuffer, 0, uploadBuffer, 0, sizeof(planeVertices)+dwPlaneIndicesSize+sizeof(cubeVertices)+dwCubeIndicesSize );
 
 	D3D12_RESOURCE_BARRIER defaultHeapUploadToReadBarrier;
     defaultHeapUploadToReadBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
@@ -1386,47 +740,21 @@ void UploadModels( u32 dwGPUNumber, u32 dwVisibleGPUMask )
     defaultHeapUploadToReadBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
     defaultHeapUploadToReadBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
     commandLists[ovrEye_Count]->ResourceBarrier( 1, &defaultHeapUploadToReadBarrier );
-
-    //does this apply in my case https://twitter.com/MyNameIsMJP/status/1574431011579928580 ?
-    planeVertexBufferView.BufferLocation = defaultBuffer->GetGPUVirtualAddress();
-    planeVertexBufferView.StrideInBytes = 3*sizeof(f32) + 3*sizeof(f32) + 4*sizeof(f32); //size of s single vertex
-    planeVertexBufferView.SizeInBytes = sizeof(planeVertices);
-
-	planeIndexBufferView.BufferLocation = planeVertexBufferView.BufferLocation + sizeof(planeVertices);
-    planeIndexBufferView.SizeInBytes = sizeof(planeIndices);
-    planeIndexBufferView.Format = DXGI_FORMAT_R32_UINT; 
-
-    cubeVertexBufferView.BufferLocation = planeIndexBufferView.BufferLocation+sizeof(planeIndices);
-    cubeVertexBufferView.StrideInBytes = 3*sizeof(f32) + 3*sizeof(f32) + 4*sizeof(f32); //size of s single vertex
-    cubeVertexBufferView.SizeInBytes = sizeof(cubeVertices);
-
-	cubeIndexBufferView.BufferLocation = cubeVertexBufferView.BufferLocation+sizeof(cubeVertices);
-    cubeIndexBufferView.SizeInBytes = sizeof(cubeIndicies);
-    cubeIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
-
-    handVertexBufferView.BufferLocation = cubeIndexBufferView.BufferLocation+sizeof(cubeIndicies);
-    handVertexBufferView.StrideInBytes = 3*sizeof(f32) + 3*sizeof(f32) + 4*sizeof(u32) + 4*sizeof(f32) + 4*sizeof(f32); //size of s single vertex
-    handVertexBufferView.SizeInBytes = sizeof(handVertices);
-
-	handIndexBufferView.BufferLocation = handVertexBufferView.BufferLocation+sizeof(handVertices);
-    handIndexBufferView.SizeInBytes = sizeof(handIndices);
-    handIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
 }
 
-//when using multiple memory srcs for input for rendering the following will be the main slot
-#define MAIN_VB_SLOT 0
-
-#define VERTEX_CB_ROOT_SLOT 0
-#define PIXEL_CB_ROOT_SLOT 1
-#define VERTEX_SB_ROOT_SLOT 2
 //are structured buffers best here, also are they in SRV? or what if so
 // do i need to create a heap for then and store a descriptor for that in a descriptor table
 // then store that table in the root signature? https://www.gamedev.net/forums/topic/708895-structured-buffers-in-dx12/
 //https://www.gamedev.net/forums/topic/624529-structured-buffers-vs-constant-buffers/
 
+#define PIPELINE_CACHE_FILE_NAME "BasicOVR.pipelines.bin"
+
+//the psos are queued on pipelineCache and built together at the end, loaded from its library or compiled on the workers
 inline 
 bool InitPipelineStates()
 {
+	InitPipelineCache( &pipelineCache, device, PIPELINE_CACHE_FILE_NAME );
+
 	//vertex shader constants
 	D3D12_ROOT_CONSTANTS cbVertDesc;
 	cbVertDesc.ShaderRegister = 0;
@@ -1440,7 +768,7 @@ bool InitPipelineStates()
 	                            //float4 and float3
 	cbPixelDesc.Num32BitValues = 4 + 3;
 
-	D3D12_ROOT_PARAMETER rootParams[3];
+	D3D12_ROOT_PARAMETER rootParams[4];
 	rootParams[VERTEX_CB_ROOT_SLOT].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
 	rootParams[VERTEX_CB_ROOT_SLOT].Constants = cbVertDesc;
 	rootParams[VERTEX_CB_ROOT_SLOT].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
@@ -1455,9 +783,14 @@ bool InitPipelineStates()
 	rootParams[VERTEX_SB_ROOT_SLOT].Descriptor.RegisterSpace = 0;
 	rootParams[VERTEX_SB_ROOT_SLOT].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
 
+	rootParams[VERTEX_DRAW_CBV_ROOT_SLOT].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	rootParams[VERTEX_DRAW_CBV_ROOT_SLOT].Descriptor.ShaderRegister = 2;
+	rootParams[VERTEX_DRAW_CBV_ROOT_SLOT].Descriptor.RegisterSpace = 0;
+	rootParams[VERTEX_DRAW_CBV_ROOT_SLOT].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX;
+
 	//D3D12_VERSIONED_ROOT_SIGNATURE_DESC
 	D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc;
-	rootSignatureDesc.NumParameters = 2;
+	rootSignatureDesc.NumParameters = 4; //the static pipelines leave the slots their RenderDrawDataMode doesn't use unbound
 	rootSignatureDesc.pParameters = rootParams;
 	rootSignatureDesc.NumStaticSamplers = 0;
 	rootSignatureDesc.pStaticSamplers = nullptr;
@@ -1566,7 +899,7 @@ bool InitPipelineStates()
 	D3D12_DEPTH_STENCIL_DESC pipelineDepthStencilState;
 	pipelineDepthStencilState.DepthEnable = 1;
 	pipelineDepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-	pipelineDepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	pipelineDepthStencilState.DepthFunc = EYE_DEPTH_FUNC;
 	pipelineDepthStencilState.StencilEnable = 0;
 	pipelineDepthStencilState.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
 	pipelineDepthStencilState.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
@@ -1600,11 +933,19 @@ bool InitPipelineStates()
 	pipelineDesc.CachedPSO = {};
 	pipelineDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE; //set in debug mode for embedded graphics
 
-	if( FAILED( device->CreateGraphicsPipelineState( &pipelineDesc, IID_PPV_ARGS( &pipelineStateObject ) ) ) )
-	{
-		logError( "Failed to create pipeline state object!\n" );
-		return false;
-	}
+	PipelineCacheAddGraphics( &pipelineCache, &pipelineDesc, serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize(),
+		&pipelineStateObject, "static" );
+
+	//the same static pipeline reading its transforms from the frame's draw data, see RenderDrawDataMode
+	pipelineDesc.VS.pShaderBytecode = vertexShaderDrawCBVBlob;
+	pipelineDesc.VS.BytecodeLength = sizeof(vertexShaderDrawCBVBlob);
+	PipelineCacheAddGraphics( &pipelineCache, &pipelineDesc, serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize(),
+		&drawCBVPipelineStateObject, "static draw cbv" );
+
+	pipelineDesc.VS.pShaderBytecode = vertexShaderDrawIndexBlob;
+	pipelineDesc.VS.BytecodeLength = sizeof(vertexShaderDrawIndexBlob);
+	PipelineCacheAddGraphics( &pipelineCache, &pipelineDesc, serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize(),
+		&drawIndexPipelineStateObject, "static draw index" );
 
 	D3D12_INPUT_ELEMENT_DESC inputLayoutSkinned[] =
 	{
@@ -1620,21 +961,75 @@ bool InitPipelineStates()
 	inputLayoutSkinndedDesc.NumElements = 5;
 
 	pipelineDesc.pRootSignature = skinnedRootSignature;
+	pipelineDesc.InputLayout = inputLayoutSkinndedDesc;
 
-	D3D12_SHADER_BYTECODE vertexShaderSkinnedBytecode;
-	vertexShaderSkinnedBytecode.pShaderBytecode = vertexShaderSkinnedBlob;
-	vertexShaderSkinnedBytecode.BytecodeLength = sizeof(vertexShaderSkinnedBlob);
+	//a pso per palette layout, all of them read the same bone buffer so RenderFrame can switch between them any frame
+	const char *skinnedNames[SKIN_LAYOUT_COUNT] = { "skinned", "skinned flat" };
+	for( u32 dwLayout = 0; dwLayout < SKIN_LAYOUT_COUNT; ++dwLayout )
+	{
+		pipelineDesc.VS.pShaderBytecode = skinShaders.blobs[dwLayout][0].pData;
+		pipelineDesc.VS.BytecodeLength = skinShaders.blobs[dwLayout][0].dwSize;
+		PipelineCacheAddGraphics( &pipelineCache, &pipelineDesc, serializedSkinnedRootSignature->GetBufferPointer(), serializedSkinnedRootSignature->GetBufferSize(),
+			&skinnedPipelineStateObjects[dwLayout], skinnedNames[dwLayout] );
+	}
 
-	pipelineDesc.VS = vertexShaderSkinnedBytecode;
-	pipelineDesc.InputLayout = inputLayoutSkinndedDesc;
+	//instanced variants, the same vertices plus a RenderInstance per instance in INSTANCE_VB_SLOT
+	D3D12_INPUT_ELEMENT_DESC inputLayoutInstanced[] =
+	{
+		{ "POS", 0, DXGI_FORMAT_R32G32B32_FLOAT, MAIN_VB_SLOT, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, MAIN_VB_SLOT, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, MAIN_VB_SLOT, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, INSTANCE_VB_SLOT, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, INSTANCE_VB_SLOT, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, INSTANCE_VB_SLOT, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, INSTANCE_VB_SLOT, 48, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "NORMALMAT", 0, DXGI_FORMAT_R32G32B32_FLOAT, INSTANCE_VB_SLOT, 64, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "NORMALMAT", 1, DXGI_FORMAT_R32G32B32_FLOAT, INSTANCE_VB_SLOT, 80, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "NORMALMAT", 2, DXGI_FORMAT_R32G32B32_FLOAT, INSTANCE_VB_SLOT, 96, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+	};
+
+	D3D12_INPUT_LAYOUT_DESC inputLayoutInstancedDesc;
+	inputLayoutInstancedDesc.pInputElementDescs = inputLayoutInstanced;
+	inputLayoutInstancedDesc.NumElements = _countof( inputLayoutInstanced );
 
-	if( FAILED( device->CreateGraphicsPipelineState( &pipelineDesc, IID_PPV_ARGS( &skinnedPipelineStateObject ) ) ) )
+	D3D12_SHADER_BYTECODE vertexShaderInstancedBytecode;
+	vertexShaderInstancedBytecode.pShaderBytecode = vertexShaderInstancedBlob;
+	vertexShaderInstancedBytecode.BytecodeLength = sizeof(vertexShaderInstancedBlob);
+
+	pipelineDesc.pRootSignature = rootSignature;
+	pipelineDesc.VS = vertexShaderInstancedBytecode;
+	pipelineDesc.InputLayout = inputLayoutInstancedDesc;
+
+	PipelineCacheAddGraphics( &pipelineCache, &pipelineDesc, serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize(),
+		&instancedPipelineStateObject, "instanced" );
+
+	D3D12_INPUT_ELEMENT_DESC inputLayoutSkinnedInstanced[] =
 	{
-		logError( "Failed to create skinned pipeline state object!\n" );
-		return false;
+		{ "POS", 0, DXGI_FORMAT_R32G32B32_FLOAT, MAIN_VB_SLOT, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, MAIN_VB_SLOT, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "JOINT", 0, DXGI_FORMAT_R32G32B32A32_UINT, MAIN_VB_SLOT, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "WEIGHT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, MAIN_VB_SLOT, 40, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, MAIN_VB_SLOT, 56, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "PALETTE", 0, DXGI_FORMAT_R32_UINT, INSTANCE_VB_SLOT, 112, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+	};
+
+	D3D12_INPUT_LAYOUT_DESC inputLayoutSkinnedInstancedDesc;
+	inputLayoutSkinnedInstancedDesc.pInputElementDescs = inputLayoutSkinnedInstanced;
+	inputLayoutSkinnedInstancedDesc.NumElements = _countof( inputLayoutSkinnedInstanced );
+
+	pipelineDesc.pRootSignature = skinnedRootSignature;
+	pipelineDesc.InputLayout = inputLayoutSkinnedInstancedDesc;
+
+	const char *skinnedInstancedNames[SKIN_LAYOUT_COUNT] = { "skinned instanced", "skinned instanced flat" };
+	for( u32 dwLayout = 0; dwLayout < SKIN_LAYOUT_COUNT; ++dwLayout )
+	{
+		pipelineDesc.VS.pShaderBytecode = skinShaders.blobs[dwLayout][1].pData;
+		pipelineDesc.VS.BytecodeLength = skinShaders.blobs[dwLayout][1].dwSize;
+		PipelineCacheAddGraphics( &pipelineCache, &pipelineDesc, serializedSkinnedRootSignature->GetBufferPointer(), serializedSkinnedRootSignature->GetBufferSize(),
+			&skinnedInstancedPipelineStateObjects[dwLayout], skinnedInstancedNames[dwLayout] );
 	}
 
-	return true;
+	return PipelineCacheBuild( &pipelineCache, &workerPool );
 }
 
 inline
@@ -1694,6 +1089,7 @@ u8 InitDirectX12()
         // Suppress individual messages by their ID
         D3D12_MESSAGE_ID DenyIds[] = {
             D3D12_MESSAGE_ID_CLEARRENDERTARGETVIEW_MISMATCHINGCLEARVALUE,   // I'm really not sure how to avoid this message.
+            D3D12_MESSAGE_ID_CLEARDEPTHSTENCILVIEW_MISMATCHINGCLEARVALUE,   // ovr creates the depth swap chains, we don't get to pick their optimized clear value
             D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,                         // This warning occurs when using capture frame while graphics debugging.
             D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE,                       // This warning occurs when using capture frame while graphics debugging.
         };
@@ -1771,8 +1167,9 @@ u8 InitDirectX12()
 	// or there a constant defined in libOVR so I don't have to do this
 	ovr_GetTextureSwapChainLength( oculusSession, oculusEyeSwapChains[0] , (s32*)&oculusNUM_FRAMES);
 
-	commandAllocators = (ID3D12CommandAllocator**)malloc( (oculusNUM_FRAMES*ovrEye_Count*(sizeof(ID3D12CommandAllocator*) + sizeof(ID3D12Resource*))) + sizeof(ID3D12CommandAllocator*) );
+	commandAllocators = (ID3D12CommandAllocator**)malloc( (oculusNUM_FRAMES*ovrEye_Count*(sizeof(ID3D12CommandAllocator*) + (2*sizeof(ID3D12Resource*)))) + sizeof(ID3D12CommandAllocator*) );
 	oculusEyeBackBuffers = (ID3D12Resource**)(commandAllocators + (oculusNUM_FRAMES*ovrEye_Count) + 1);
+	oculusEyeDepthBuffers = oculusEyeBackBuffers + (oculusNUM_FRAMES*ovrEye_Count);
 
 #if MAIN_DEBUG
 	s32 otherTextureCount;
@@ -1823,14 +1220,14 @@ u8 InitDirectX12()
 		}
 	}
 
-	dsDescriptorHeap = InitDepthStencilDescriptorHeap( device, ovrEye_Count );
+	dsDescriptorHeap = InitDepthStencilDescriptorHeap( device, oculusNUM_FRAMES*ovrEye_Count );
 	if( !dsDescriptorHeap )
 	{
 		logError( "Failed to create depth buffer descriptor heap!\n" );
 		return 1;
 	}
 
-	if( !CreateDepthStencilBuffer() )
+	if( !CreateEyeDepthSwapChains() )
 	{
 		return 1;
 	}
@@ -1838,16 +1235,6 @@ u8 InitDirectX12()
 
 	InitSRVUploadHeap(0x1,0x1);
 
-/*
-	//TODO change to just using a root descriptor in the root signature
-	srvDescriptorHeap = InitSRVDescriptorHeap();
-		if( !srvDescriptorHeap )
-	{
-		logError( "Failed to create SRV descriptor heap!\n" );
-		return 1;
-	}
-*/
-
 	for( u32 dwIdx = 0; dwIdx < (u32)(oculusNUM_FRAMES*ovrEye_Count+1); ++dwIdx )
 	{
 		if( FAILED( device->CreateCommandAllocator( D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS( &commandAllocators[dwIdx] ) ) ) )
@@ -1909,8 +1296,18 @@ u8 InitDirectX12()
 		return false;
 	}
 
+	if( !InitGpuTimer() )
+	{
+		return 1;
+	}
+
 	UploadModels(0x1,0x1); //upload meshes to GPU 1
 
+	if( !InitFoveation( FOVEATION_LEVEL ) )
+	{
+		return 1;
+	}
+
 	//finish up streaming command list
 	if( FAILED( commandLists[ovrEye_Count]->Close() ) )
 	{
@@ -1925,10 +1322,15 @@ u8 InitDirectX12()
     FlushStreamingCommandQueue();
     uploadBuffer->Release();
 	pModelUploadHeap->Release();
+	if( foveation.pUpload )
+	{
+		foveation.pUpload->Release();
+		foveation.pUpload = nullptr;
+	}
 
 	if( !InitPipelineStates() )
 	{
-		return false;
+		return 1;
 	}
 
 	return 0;
@@ -1944,14 +1346,117 @@ struct ControllerState
 };
 
 
-void DrawScene( f32 deltaTime ) //todo change to f64 for higher precision time steps 
+//Late latching
+//the command lists only reference boneBuffer[frame], so the hand poses can be resampled and written after recording
+typedef struct LateLatchStats
+{
+	LARGE_INTEGER earlyPoseCounter; //when SimulateFrame first sampled tracking (copied out of the frame packet)
+	LARGE_INTEGER latchPoseCounter; //when LateLatchHandPoses resampled it
+	f64 fPoseToSubmitUs; //latched pose sample to ExecuteCommandLists, last frame
+	f64 fEarlyPoseToSubmitUs; //what it would have been without latching, last frame
+	f64 fSumPoseToSubmitUs;
+	f64 fSumEarlyPoseToSubmitUs;
+	u32 dwNumFrames;
+} LateLatchStats;
+
+LateLatchStats lateLatchStats;
+
+inline
+void InitHandModelFromPose( Mat4f *a_pMat, ovrPosef *a_pPose )
+{
+	Quatf handQuat;
+	handQuat.w = a_pPose->Orientation.w;
+	handQuat.x = a_pPose->Orientation.x;
+	handQuat.y = a_pPose->Orientation.y;
+	handQuat.z = a_pPose->Orientation.z;
+
+	Vec3f handPos;
+	handPos.x = a_pPose->Position.x;
+	handPos.y = a_pPose->Position.y;
+	handPos.z = a_pPose->Position.z;
+
+	InitModelMat4ByQuatf( a_pMat, &handQuat, &handPos );
+}
+
+//resample the hand poses and write the packet's model space bones * hand model into this frame's palettes
+inline
+bool LateLatchHandPoses( FramePacket *a_pPacket )
+{
+	PROFILE_SCOPE( "LateLatchHandPoses" );
+	ovrTrackingState oculusTrackState = ovr_GetTrackingState( oculusSession, a_pPacket->fPredictedDisplayTime, ovrFalse );
+	QueryPerformanceCounter( &lateLatchStats.latchPoseCounter );
+	for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
+	{
+		if( !a_pPacket->hwHandPresent[dwHand] )
+		{
+			continue; //no draw was recorded for it
+		}
+		Mat4f mLatchedHandModel = a_pPacket->mHandModel[dwHand]; //the sim thread's pose, kept if tracking dropped out since
+		if( oculusTrackState.HandStatusFlags[dwHand] & (ovrStatus_OrientationTracked|ovrStatus_PositionTracked) )
+		{
+			InitHandModelFromPose( &mLatchedHandModel, &oculusTrackState.HandPoses[dwHand].ThePose );
+		}
+
+		u8* pUploadBoneBufferData;
+		if( FAILED( boneBuffer[oculusCurrentFrameIdx]->Map( 0, nullptr, (void**) &pUploadBoneBufferData ) ) )
+		{
+			logError( "Failed to map bone buffer!\n" );
+			return false;
+		}
+		FrameWriteHandPalette( a_pPacket->mHandFinalBones[dwHand], &mLatchedHandModel, pUploadBoneBufferData + (dwHand*BONE_PALETTE_SIZE) );
+		boneBuffer[oculusCurrentFrameIdx]->Unmap( 0, nullptr );
+	}
+	return true;
+}
+
+inline
+void RecordLateLatchStats( LARGE_INTEGER submitCounter )
+{
+	LARGE_INTEGER PerfCountFrequency;
+	QueryPerformanceFrequency( &PerfCountFrequency );
+	lateLatchStats.fPoseToSubmitUs = ( 1000000.0 * ( submitCounter.QuadPart - lateLatchStats.latchPoseCounter.QuadPart ) ) / (f64)PerfCountFrequency.QuadPart;
+	lateLatchStats.fEarlyPoseToSubmitUs = ( 1000000.0 * ( submitCounter.QuadPart - lateLatchStats.earlyPoseCounter.QuadPart ) ) / (f64)PerfCountFrequency.QuadPart;
+	lateLatchStats.fSumPoseToSubmitUs += lateLatchStats.fPoseToSubmitUs;
+	lateLatchStats.fSumEarlyPoseToSubmitUs += lateLatchStats.fEarlyPoseToSubmitUs;
+	++lateLatchStats.dwNumFrames;
+#if MAIN_DEBUG
+	if( lateLatchStats.dwNumFrames == 90 )
+	{
+		printf( "hand pose to submit: %.1fus latched, %.1fus unlatched (avg over %u frames)\n", lateLatchStats.fSumPoseToSubmitUs / lateLatchStats.dwNumFrames, lateLatchStats.fSumEarlyPoseToSubmitUs / lateLatchStats.dwNumFrames, lateLatchStats.dwNumFrames );
+		lateLatchStats.fSumPoseToSubmitUs = 0.0;
+		lateLatchStats.fSumEarlyPoseToSubmitUs = 0.0;
+		lateLatchStats.dwNumFrames = 0;
+	}
+#endif
+}
+
+//sim thread owned, what it draws reaches the render thread as the frame packet's draw list
+EntityStore sceneEntities;
+EntityHandle cubeEntity;
+EntityHandle handEntities[ovrHand_Count];
+
+inline
+bool InitScene()
+{
+	if( !InitEntityStore( &sceneEntities, SCENE_MAX_ENTITIES ) )
+	{
+		return false;
+	}
+	FrameCreateSceneEntities( &sceneEntities, &cubeEntity, handEntities );
+	return true;
+}
+
+//sim thread, samples input and tracking for frame oculusFrameCount, animates, and publishes it as a frame packet
+//returns false if nothing was published (not visible or shutting down)
+bool SimulateFrame( f32 deltaTime ) //todo change to f64 for higher precision time steps 
 {
+	PROFILE_SCOPE( "SimulateFrame" );
 	ovrSessionStatus oculusSessionStatus;
     ovr_GetSessionStatus( oculusSession, &oculusSessionStatus );
     if( oculusSessionStatus.ShouldQuit )
     {
     	CloseProgram();
-    	return;
+    	return false;
     }
     if( oculusSessionStatus.ShouldRecenter )
     {
@@ -1970,30 +1475,38 @@ void DrawScene( f32 deltaTime ) //todo change to f64 for higher precision time s
     //TODO while paused grey tint the world
     if( oculusSessionStatus.IsVisible )
     {
-    	if( ovr_WaitToBeginFrame( oculusSession, oculusFrameCount ) < 0 )
+    	{
+    		//the render thread has to have the last packet before this index gets waited on, see FramePacket.h
+    		PROFILE_SCOPE( "WaitPacketTaken" );
+    		while( !WaitFramePacketTaken( &framePackets, FRAME_PACKET_WAIT_MS ) )
+    		{
+    			if( !Running )
+    			{
+    				return false;
+    			}
+    		}
+    	}
+    	ovrResult waitResult;
+    	{
+    		PROFILE_SCOPE( "WaitToBeginFrame" );
+    		waitResult = ovr_WaitToBeginFrame( oculusSession, oculusFrameCount );
+    	}
+    	if( waitResult < 0 )
     	{
 #if MAIN_DEBUG
     		//TODO change to a retry create head set, maybe?
     		printf("wait to begin failed\n");
 #endif
     		CloseProgram();
-    		return;
+    		return false;
     	}
 
     	//predict when the current frame will be displayed (predicted time for frame oculusFrameCount)
     	f64 fOculusFrameTiming = ovr_GetPredictedDisplayTime( oculusSession, oculusFrameCount ); 
 
-    	if( ovr_BeginFrame( oculusSession, oculusFrameCount ) < 0 )
-    	{
-#if MAIN_DEBUG
-    		//TODO change to a retry create head set, maybe?
-    		printf("begin failed\n");
-#endif
-    		CloseProgram();
-    		return;
-    	}
-
-    	ovr_GetTextureSwapChainCurrentIndex(oculusSession, oculusEyeSwapChains[0], (s32*)&oculusCurrentFrameIdx); //I don't think this will ever be out of sync between swap chains...
+    	FramePacket *pPacket = FramePacketWriteSlot( &framePackets );
+    	pPacket->qwOculusFrameIndex = oculusFrameCount;
+    	pPacket->fPredictedDisplayTime = fOculusFrameTiming;
 
     	//get head and hand tracked state
     	//https://developer.oculus.com/documentation/native/pc/dg-input-touch-poses/
@@ -2001,6 +1514,7 @@ void DrawScene( f32 deltaTime ) //todo change to f64 for higher precision time s
     	//https://developer.oculus.com/documentation/native/pc/dg-input-touch-buttons/
     	//https://developer.oculus.com/documentation/native/pc/dg-input-touch-touch/
     	ovrTrackingState oculusTrackState = ovr_GetTrackingState( oculusSession, fOculusFrameTiming, ovrFalse );
+    	QueryPerformanceCounter( &pPacket->earlyPoseCounter );
     	//ovrTrackerPose oculusTrackerPose = ovr_GetTrackerPose( oculusSession, 0); //is this for getting the world poses for the old 2 cameras that would watch the scene? (outside in tracking for before rift s oculus, or are these little extra things you would wear for tracking? or what the heck does the index return?)
     	//TODO vision tracking?
 
@@ -2040,46 +1554,35 @@ void DrawScene( f32 deltaTime ) //todo change to f64 for higher precision time s
 		Quatf qRot;
 		QuatfMult( &qVert, &qHor, &qRot);
 
-    	Mat4f mTrans;
-    	InitTransMat4f( &mTrans, 0, 0, -5); //TODO should this be negative or the view matrix position be negated?
-    	Mat4f mRot;
+    	//spin the cube, its orientation lives in the entity store so it just gets rotated a bit further each frame
     	Vec3f rotAxis = {0.57735026919f,0.57735026919f,0.57735026919f};
-    	static f32 cubeRotAngle = 0;
-    	cubeRotAngle += 50.0f*deltaTime;
-    	InitRotArbAxisMat4f( &mRot, &rotAxis, cubeRotAngle );
-    	Mat4f mCubeModel;
-    	Mat4fMult(&mRot, &mTrans, &mCubeModel);
-
-		Mat4f mPlaneModel;
-		InitMat4f( &mPlaneModel );
+    	Quatf qSpin, qCubeRot, qSpunCubeRot;
+    	InitUnitQuatf( &qSpin, 50.0f*deltaTime, &rotAxis );
+    	GetEntityRotation( &sceneEntities, cubeEntity, &qCubeRot );
+    	QuatfMult( &qCubeRot, &qSpin, &qSpunCubeRot );
+    	QuatfNormalize( &qSpunCubeRot, &qSpunCubeRot );
+    	SetEntityRotation( &sceneEntities, cubeEntity, &qSpunCubeRot );
 
 		//you need to fully understand the game to decide whether both controllers need to be present and pause on one missing
 		// or allow to keep playing with say one of the 2 hands disconnected
-		u8 hwHandPresent[ovrHand_Count];
-		Mat4f mHandModel[ovrHand_Count];
+		//the hand model matrices themselves are late latched into the bone palettes right before submission (see LateLatchHandPoses)
 		u8 hwHandFlags = 0;
 		for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
 		{
-			hwHandPresent[dwHand] = (oculusTrackState.HandStatusFlags[dwHand] & (ovrStatus_OrientationTracked|ovrStatus_PositionTracked)) > 0 ? 1 : 0;
-			if( hwHandPresent[dwHand] )
+			pPacket->hwHandPresent[dwHand] = (oculusTrackState.HandStatusFlags[dwHand] & (ovrStatus_OrientationTracked|ovrStatus_PositionTracked)) > 0 ? 1 : 0;
+			if( pPacket->hwHandPresent[dwHand] )
 			{
 				hwHandFlags |= (1 << dwHand);
-				Quatf handQuat;
-    			handQuat.w = oculusTrackState.HandPoses[dwHand].ThePose.Orientation.w;
-    			handQuat.x = oculusTrackState.HandPoses[dwHand].ThePose.Orientation.x;
-    			handQuat.y = oculusTrackState.HandPoses[dwHand].ThePose.Orientation.y;
-    			handQuat.z = oculusTrackState.HandPoses[dwHand].ThePose.Orientation.z;
-    			
-    			Vec3f handPos;
-    			handPos.x = oculusTrackState.HandPoses[dwHand].ThePose.Position.x; 
-    			handPos.y = oculusTrackState.HandPoses[dwHand].ThePose.Position.y;
-    			handPos.z = oculusTrackState.HandPoses[dwHand].ThePose.Position.z;
-
-    			InitModelMat4ByQuatf(&mHandModel[dwHand], &handQuat, &handPos);
+				ovrPosef *pHandPose = &oculusTrackState.HandPoses[dwHand].ThePose;
+				InitHandModelFromPose( &pPacket->mHandModel[dwHand], pHandPose );
+				Vec3f vHandPos = { pHandPose->Position.x, pHandPose->Position.y, pHandPose->Position.z };
+				Quatf qHandRot = { pHandPose->Orientation.w, pHandPose->Orientation.x, pHandPose->Orientation.y, pHandPose->Orientation.z };
+				SetEntityTransform( &sceneEntities, handEntities[dwHand], &vHandPos, &qHandRot, 1.0f );
 			}
 		}
 
 		ControllerState handStates[ovrHand_Count];
+		PROFILE_SCOPE( "InputAndAnimation" );
 
 		//input is the one spot where you actually want decent error handling...
 		//like what if the controller dies between getting the pose and sampling the button states
@@ -2101,292 +1604,845 @@ void DrawScene( f32 deltaTime ) //todo change to f64 for higher precision time s
 						//if index finger trigger is on right trigger, is this mutually exlcusive with ( ovrTouch_RIndexPointing << ( 8 * dwHand ) )?
 					}
 
-					//gesture
-					if(oculusControllerInputState.Touches & ( ovrTouch_RIndexPointing << ( 8 * dwHand ) ) )
-					{
-						//if index finger trigger is being being pointed
-					}
-					
-					if(oculusControllerInputState.Touches & ( ovrTouch_RThumb << ( 8 * dwHand ) ))
-					{
-						//if thumb is on joystick
-					}
+					//gesture
+					if(oculusControllerInputState.Touches & ( ovrTouch_RIndexPointing << ( 8 * dwHand ) ) )
+					{
+						//if index finger trigger is being being pointed
+					}
+					
+					if(oculusControllerInputState.Touches & ( ovrTouch_RThumb << ( 8 * dwHand ) ))
+					{
+						//if thumb is on joystick
+					}
+
+					//gesture
+					if(oculusControllerInputState.Touches & ( ovrTouch_RThumbUp << ( 8 * dwHand ) ))
+					{
+						//if thumb is above joystick is this mutually exlcusive with ( ovrTouch_RThumbRest << ( 8 * dwHand ) )?
+					}
+
+					if(oculusControllerInputState.Touches & ( ovrTouch_RThumbRest << ( 8 * dwHand ) ))
+					{
+						//if thumb is on thumb rest being touched (only on quest controllers it seems)
+					}
+	
+					//the triggers are sampled now but the hands are posed for fOculusFrameTiming, predict the triggers out to match
+					TriggerPredictorAddSample( &indexTriggerPredictors[dwHand], oculusControllerInputState.TimeInSeconds, oculusControllerInputState.IndexTrigger[dwHand] );
+					TriggerPredictorAddSample( &handTriggerPredictors[dwHand], oculusControllerInputState.TimeInSeconds, oculusControllerInputState.HandTrigger[dwHand] );
+					f32 fIndexTrigger = TriggerPredict( &indexTriggerPredictors[dwHand], fOculusFrameTiming );
+					f32 fHandTrigger = TriggerPredict( &handTriggerPredictors[dwHand], fOculusFrameTiming );
+
+					if (fIndexTrigger > 0.15f)
+					{
+					    // index finger pressed state...
+					    handStates[dwHand].m_fFrontTrigger = fIndexTrigger;
+					}
+					else
+					{
+						handStates[dwHand].m_fFrontTrigger = 0.0f;
+					}
+	
+					if (fHandTrigger > 0.15f)
+					{
+					    // index finger pressed state...
+					    handStates[dwHand].m_fSideTrigger = fHandTrigger;
+					}
+					else
+					{
+						handStates[dwHand].m_fSideTrigger = 0.0f;
+					}
+	
+					ovrVector2f vThumbStick = oculusControllerInputState.Thumbstick[dwHand];
+				
+					if( handStates[dwHand].m_fSideTrigger != fPrevSideFingerDownAmount[dwHand] )
+					{
+						fPrevSideFingerDownAmount[dwHand] = handStates[dwHand].m_fSideTrigger;
+						f64 fTotalTime = handInnerAnimTimeStamps[animationInnerKeyframeCount-1] - handInnerAnimTimeStamps[0];
+						if( handStates[dwHand].m_fSideTrigger == 0.0 )
+						{
+							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
+							for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
+							{				
+								Mat4f mLocalFrameBone;
+								InitModelMat4ByQuatf( &mLocalFrameBone, &handInnerKeyFrames[0][dwBone-firstInnerBone].qRot, &handInnerKeyFrames[0][dwBone-firstInnerBone].vPos );
+								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
+								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[dwHand][dwBone]);
+							}
+						}
+						else if( handStates[dwHand].m_fSideTrigger == 1.0 )
+						{
+							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
+							for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
+							{				
+								Mat4f mLocalFrameBone;
+								InitModelMat4ByQuatf( &mLocalFrameBone, &handInnerKeyFrames[animationInnerKeyframeCount-1][dwBone-firstInnerBone].qRot, &handInnerKeyFrames[animationInnerKeyframeCount-1][dwBone-firstInnerBone].vPos );
+								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
+								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[dwHand][dwBone]);
+							}
+						}
+						else
+						{
+							f64 fCurrAnimationTime = fTotalTime * handStates[dwHand].m_fSideTrigger;
+							u32 dwCurrKeyFrame = 1;
+							for( ; dwCurrKeyFrame < animationInnerKeyframeCount; ++dwCurrKeyFrame )
+							{
+								if( fCurrAnimationTime <= handInnerAnimTimeStamps[dwCurrKeyFrame])
+								{
+									break;
+								}
+							}
+							u32 dwPrevKeyFrame = dwCurrKeyFrame-1;
+							f32 fT = (f32)((fCurrAnimationTime - handInnerAnimTimeStamps[dwPrevKeyFrame]) / (handInnerAnimTimeStamps[dwCurrKeyFrame] - handInnerAnimTimeStamps[dwPrevKeyFrame]));
+							Quatf rot;
+							Vec3f pos;
+							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
+							for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
+							{				
+								Mat4f mLocalFrameBone;
+								QuatfNormLerp(&handInnerKeyFrames[dwCurrKeyFrame][dwBone-firstInnerBone].qRot,&handInnerKeyFrames[dwPrevKeyFrame][dwBone-firstInnerBone].qRot,fT,&rot );
+								Vec3fLerp(&handInnerKeyFrames[dwCurrKeyFrame][dwBone-firstInnerBone].vPos,&handInnerKeyFrames[dwPrevKeyFrame][dwBone-firstInnerBone].vPos,fT,&pos);
+								InitModelMat4ByQuatf( &mLocalFrameBone, &rot, &pos );
+								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
+								Mat4fMult(&handInvBind[dwBone], &mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[dwHand][dwBone]);
+							}
+						}
+
+					}
+					if( handStates[dwHand].m_fFrontTrigger != fPrevIndexFingerDownAmount[dwHand] )
+					{
+						fPrevIndexFingerDownAmount[dwHand] = handStates[dwHand].m_fFrontTrigger;
+						f64 fTotalTime = handOutterAnimTimeStamps[animationOutterKeyframeCount-1] - handOutterAnimTimeStamps[0];
+						if( handStates[dwHand].m_fFrontTrigger == 0.0 )
+						{
+							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
+							for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
+							{				
+								Mat4f mLocalFrameBone;
+								InitModelMat4ByQuatf( &mLocalFrameBone, &handOutterKeyFrames[0][dwBone-firstOutterBone].qRot, &handOutterKeyFrames[0][dwBone-firstOutterBone].vPos );
+								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
+								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[dwHand][dwBone]);
+							}
+						}
+						else if( handStates[dwHand].m_fFrontTrigger == 1.0 )
+						{
+							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
+							for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
+							{				
+								Mat4f mLocalFrameBone;
+								InitModelMat4ByQuatf( &mLocalFrameBone, &handOutterKeyFrames[animationOutterKeyframeCount-1][dwBone-firstOutterBone].qRot, &handOutterKeyFrames[animationOutterKeyframeCount-1][dwBone-firstOutterBone].vPos );
+								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
+								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[dwHand][dwBone]);
+							}
+						}
+						else
+						{
+							f64 fCurrAnimationTime = fTotalTime * handStates[dwHand].m_fFrontTrigger;
+							u32 dwCurrKeyFrame = 1;
+							for( ; dwCurrKeyFrame < animationOutterKeyframeCount; ++dwCurrKeyFrame )
+							{
+								if( fCurrAnimationTime <= handOutterAnimTimeStamps[dwCurrKeyFrame])
+								{
+									break;
+								}
+							}
+							u32 dwPrevKeyFrame = dwCurrKeyFrame-1;
+							f32 fT = (f32)((fCurrAnimationTime - handOutterAnimTimeStamps[dwPrevKeyFrame]) / (handOutterAnimTimeStamps[dwCurrKeyFrame] - handOutterAnimTimeStamps[dwPrevKeyFrame]));
+							Quatf rot;
+							Vec3f pos;
+							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
+							for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
+							{				
+								Mat4f mLocalFrameBone;
+								QuatfNormLerp(&handOutterKeyFrames[dwCurrKeyFrame][dwBone-firstOutterBone].qRot,&handOutterKeyFrames[dwPrevKeyFrame][dwBone-firstOutterBone].qRot,fT,&rot );
+								Vec3fLerp(&handOutterKeyFrames[dwCurrKeyFrame][dwBone-firstOutterBone].vPos,&handOutterKeyFrames[dwPrevKeyFrame][dwBone-firstOutterBone].vPos,fT,&pos);
+								InitModelMat4ByQuatf( &mLocalFrameBone, &rot, &pos );
+								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
+								Mat4fMult(&handInvBind[dwBone], &mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[dwHand][dwBone]);
+							}
+						}
+
+					}
+				}
+			}
+		}
+
+
+    	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+    	{
+    		pPacket->EyeRenderPose[dwEye] = EyeRenderPose[dwEye];
+    		pPacket->EyeFov[dwEye] = oculusEyeRenderDesc[dwEye].Fov;
+    	}
+    	pPacket->qCamRot = qRot;
+    	pPacket->vCamPos = startingPos;
+    	{
+    		PROFILE_SCOPE( "UpdateTransforms" );
+    		UpdateEntityTransforms( &sceneEntities, &workerPool );
+    	}
+    	{
+    		PROFILE_SCOPE( "BuildDrawList" );
+    		BuildSceneDrawList( &sceneEntities, &pPacket->draws );
+    	}
+    	memcpy( pPacket->mHandFinalBones, mHandFrameFinalBones, sizeof( mHandFrameFinalBones ) );
+
+    	//hand it off, the render thread does Begin/EndFrame with this same index
+    	PublishFramePacket( &framePackets );
+    	++oculusFrameCount;
+    	return true;
+    }
+    return false;
+}
+
+#define CULL_HAND_LATCH_MARGIN 0.05f //the hands get latched to a newer pose after culling, this covers how far they can move in between
+
+CullBoxes sceneCullBoxes; //one per draw, in draw list order
+SkinnedCullBounds handCullBounds; //MESH_HAND is the only skinned mesh
+u8 sceneLods[SCENE_MAX_ENTITIES]; //last frame's LOD level by entity slot, what MeshLodSelect's hysteresis starts from
+
+//mesh space bounds of the static meshes by MeshId, skinned ones get theirs from the palette
+Vec3f meshCullCenters[MESH_COUNT] = { { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+Vec3f meshCullExtents[MESH_COUNT] = { { 1000.0f, 0.0f, 1000.0f }, { 0.5f, 0.5f, 0.5f }, { 0.0f, 0.0f, 0.0f } };
+
+//by MeshId
+u32 meshLodCounts[MESH_COUNT] = { 1, 1, handLodCount };
+const MeshLodLevel *meshLodLevels[MESH_COUNT] = { nullptr, nullptr, handLodLevels };
+
+//render thread owned, the queue is rebuilt and sorted every frame and each eye's command list goes through its own backend
+RenderQueue renderQueue;
+RenderBackend renderBackends[ovrEye_Count];
+RenderResources renderResources;
+D3D12_GPU_VIRTUAL_ADDRESS renderPalettes[ovrHand_Count]; //this frame's bone buffer, a palette per hand
+
+//per frame RenderInstances, persistently mapped upload buffers the queue writes once per frame for both eyes
+ID3D12Resource* instanceBuffers[6]; //sized like boneBuffer, oculusNUM_FRAMES are used
+RenderInstance* instanceBufferData[6];
+D3D12_VERTEX_BUFFER_VIEW instanceBufferViews[6];
+
+inline
+bool InitInstanceBuffers()
+{
+	D3D12_HEAP_PROPERTIES uploadHeapDesc;
+	uploadHeapDesc.Type = D3D12_HEAP_TYPE_UPLOAD;
+	uploadHeapDesc.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	uploadHeapDesc.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	uploadHeapDesc.CreationNodeMask = 1;
+	uploadHeapDesc.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC instanceBufferDesc;
+	instanceBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	instanceBufferDesc.Alignment = 0;
+	instanceBufferDesc.Width = sizeof( RenderInstance ) * SCENE_MAX_ENTITIES;
+	instanceBufferDesc.Height = 1;
+	instanceBufferDesc.DepthOrArraySize = 1;
+	instanceBufferDesc.MipLevels = 1;
+	instanceBufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	instanceBufferDesc.SampleDesc.Count = 1;
+	instanceBufferDesc.SampleDesc.Quality = 0;
+	instanceBufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	instanceBufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	for( u32 dwFrame = 0; dwFrame < oculusNUM_FRAMES; ++dwFrame )
+	{
+		if( FAILED( device->CreateCommittedResource( &uploadHeapDesc, D3D12_HEAP_FLAG_NONE, &instanceBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS( &instanceBuffers[dwFrame] ) ) ) )
+		{
+			logError( "Failed to create instance buffer!\n" );
+			return false;
+		}
+#if MAIN_DEBUG
+		instanceBuffers[dwFrame]->SetName( L"Instance Buffer" );
+#endif
+		D3D12_RANGE readRange = { 0, 0 }; //never read back
+		if( FAILED( instanceBuffers[dwFrame]->Map( 0, &readRange, (void**) &instanceBufferData[dwFrame] ) ) )
+		{
+			logError( "Failed to map instance buffer!\n" );
+			return false;
+		}
+		instanceBufferViews[dwFrame].BufferLocation = instanceBuffers[dwFrame]->GetGPUVirtualAddress();
+		instanceBufferViews[dwFrame].SizeInBytes = sizeof( RenderInstance ) * SCENE_MAX_ENTITIES;
+		instanceBufferViews[dwFrame].StrideInBytes = sizeof( RenderInstance );
+	}
+	return true;
+}
+
+//per frame RenderDrawData, sized for every draw to get a RENDER_DRAW_DATA_CBV_SIZE slot so either buffer mode fits
+ID3D12Resource* drawDataBuffers[6];
+u8* drawDataBufferData[6];
+
+inline
+bool InitDrawDataBuffers()
+{
+	D3D12_HEAP_PROPERTIES uploadHeapDesc;
+	uploadHeapDesc.Type = D3D12_HEAP_TYPE_UPLOAD;
+	uploadHeapDesc.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	uploadHeapDesc.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	uploadHeapDesc.CreationNodeMask = 1;
+	uploadHeapDesc.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC drawDataBufferDesc;
+	drawDataBufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	drawDataBufferDesc.Alignment = 0;
+	drawDataBufferDesc.Width = (u64)RENDER_DRAW_DATA_CBV_SIZE * SCENE_MAX_ENTITIES;
+	drawDataBufferDesc.Height = 1;
+	drawDataBufferDesc.DepthOrArraySize = 1;
+	drawDataBufferDesc.MipLevels = 1;
+	drawDataBufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	drawDataBufferDesc.SampleDesc.Count = 1;
+	drawDataBufferDesc.SampleDesc.Quality = 0;
+	drawDataBufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	drawDataBufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	for( u32 dwFrame = 0; dwFrame < oculusNUM_FRAMES; ++dwFrame )
+	{
+		if( FAILED( device->CreateCommittedResource( &uploadHeapDesc, D3D12_HEAP_FLAG_NONE, &drawDataBufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS( &drawDataBuffers[dwFrame] ) ) ) )
+		{
+			logError( "Failed to create draw data buffer!\n" );
+			return false;
+		}
+#if MAIN_DEBUG
+		drawDataBuffers[dwFrame]->SetName( L"Draw Data Buffer" );
+#endif
+		D3D12_RANGE readRange = { 0, 0 }; //never read back
+		if( FAILED( drawDataBuffers[dwFrame]->Map( 0, &readRange, (void**) &drawDataBufferData[dwFrame] ) ) )
+		{
+			logError( "Failed to map draw data buffer!\n" );
+			return false;
+		}
+	}
+	return true;
+}
+
+inline
+bool InitRenderQueueResources()
+{
+	if( !InitRenderQueue( &renderQueue, SCENE_MAX_ENTITIES ) || !InitInstanceBuffers() || !InitDrawDataBuffers() )
+	{
+		return false;
+	}
+	ID3D12PipelineState *pipelines[RENDER_PIPELINE_COUNT];
+	pipelines[RENDER_PIPELINE_STATIC] = pipelineStateObject;
+	pipelines[RENDER_PIPELINE_STATIC_INSTANCED] = instancedPipelineStateObject;
+	pipelines[RENDER_PIPELINE_SKINNED] = skinnedPipelineStateObjects[SKIN_LAYOUT_DEFAULT];
+	pipelines[RENDER_PIPELINE_SKINNED_INSTANCED] = skinnedInstancedPipelineStateObjects[SKIN_LAYOUT_DEFAULT];
+	ID3D12RootSignature *rootSignatures[RENDER_ROOT_SIGNATURE_COUNT];
+	rootSignatures[RENDER_ROOT_SIGNATURE_STATIC] = rootSignature;
+	rootSignatures[RENDER_ROOT_SIGNATURE_SKINNED] = skinnedRootSignature;
+	FrameInitRenderResources( &renderResources, pipelines, rootSignatures, drawCBVPipelineStateObject, drawIndexPipelineStateObject,
+		meshVertexBufferViews, meshIndexBufferViews, meshIndices, renderPalettes, &pixelConstantBuffer );
+	return true;
+}
+
+//gpu driven static draws, see IndirectDraw.h
+#define INDIRECT_CB_ROOT_SLOT 0
+#define INDIRECT_WORLD_ROOT_SLOT 1
+#define INDIRECT_NORMAL_ROOT_SLOT 2
+#define INDIRECT_MESH_ROOT_SLOT 3
+#define INDIRECT_MESH_TABLE_ROOT_SLOT 4
+#define INDIRECT_COMMANDS_ROOT_SLOT 5
+#define INDIRECT_COUNTS_ROOT_SLOT 6
+#define INDIRECT_COUNTS_OFFSET ( sizeof( IndirectCommand ) * SCENE_MAX_ENTITIES * ovrEye_Count ) //the count buffer is after both eyes' commands
+
+typedef struct IndirectDraws
+{
+	ID3D12RootSignature *pCullRootSignature;
+	ID3D12PipelineState *pCullPipeline;
+	ID3D12CommandSignature *pCommandSignature; //needs rootSignature bound, it sets its vertex constants
+	ID3D12Resource *pCommands; //SCENE_MAX_ENTITIES per eye, left then right, then a count per eye. lives in UNORDERED_ACCESS between frames
+	ID3D12Resource *pUploads[6]; //per frame, persistently mapped
+	IndirectFrame frames[6];
+	IndirectFrameLayout layout;
+	u8 bEnabled; //0 sends the static draws through the render queue like the skinned ones
+} IndirectDraws;
+
+IndirectDraws indirectDraws;
+
+inline
+bool InitIndirectDraws()
+{
+	//the commands carry one view projection per eye, the octilinear quadrants each need their own
+	if( foveation.dwMode == FOVEATION_MULTIRES )
+	{
+		indirectDraws.bEnabled = 0;
+		return true;
+	}
+	//a command per draw can't split a mesh into parts, the static draws stay on the render queue if one has them
+	for( u32 dwMesh = 0; dwMesh < MESH_COUNT; ++dwMesh )
+	{
+		if( meshIndices[dwMesh]->dwNumParts > 1 )
+		{
+			indirectDraws.bEnabled = 0;
+			return true;
+		}
+	}
+
+	D3D12_ROOT_PARAMETER rootParams[7];
+	for( u32 dwParam = 0; dwParam < 7; ++dwParam )
+	{
+		rootParams[dwParam].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;
+		rootParams[dwParam].Descriptor.ShaderRegister = dwParam - INDIRECT_WORLD_ROOT_SLOT;
+		rootParams[dwParam].Descriptor.RegisterSpace = 0;
+		rootParams[dwParam].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	}
+	rootParams[INDIRECT_CB_ROOT_SLOT].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+	rootParams[INDIRECT_CB_ROOT_SLOT].Descriptor.ShaderRegister = 0;
+	rootParams[INDIRECT_COMMANDS_ROOT_SLOT].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+	rootParams[INDIRECT_COMMANDS_ROOT_SLOT].Descriptor.ShaderRegister = 0;
+	rootParams[INDIRECT_COUNTS_ROOT_SLOT].ParameterType = D3D12_ROOT_PARAMETER_TYPE_UAV;
+	rootParams[INDIRECT_COUNTS_ROOT_SLOT].Descriptor.ShaderRegister = 1;
+
+	D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.NumParameters = 7;
+	rootSignatureDesc.pParameters = rootParams;
+	rootSignatureDesc.NumStaticSamplers = 0;
+	rootSignatureDesc.pStaticSamplers = nullptr;
+	rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+	ID3DBlob* serializedRootSignature;
+	if( FAILED( D3D12SerializeRootSignature( &rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_0, &serializedRootSignature, nullptr ) ) )
+	{
+		logError( "Failed to serialize cull root signature!\n" );
+		return false;
+	}
+	if( FAILED( device->CreateRootSignature( 0, serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize(), IID_PPV_ARGS( &indirectDraws.pCullRootSignature ) ) ) )
+	{
+		logError( "Failed to create cull root signature!\n" );
+		return false;
+	}
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC cullPipelineDesc;
+	cullPipelineDesc.pRootSignature = indirectDraws.pCullRootSignature;
+	cullPipelineDesc.CS.pShaderBytecode = indirectCullBlob;
+	cullPipelineDesc.CS.BytecodeLength = sizeof(indirectCullBlob);
+	cullPipelineDesc.NodeMask = 0;
+	cullPipelineDesc.CachedPSO = {};
+	cullPipelineDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+	PipelineCacheAddCompute( &pipelineCache, &cullPipelineDesc, serializedRootSignature->GetBufferPointer(), serializedRootSignature->GetBufferSize(),
+		&indirectDraws.pCullPipeline, "indirect cull" );
+	if( !PipelineCacheBuild( &pipelineCache, &workerPool ) )
+	{
+		return false;
+	}
+
+	//IndirectCommand
+	D3D12_INDIRECT_ARGUMENT_DESC indirectArgs[4];
+	indirectArgs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW;
+	indirectArgs[0].VertexBuffer.Slot = MAIN_VB_SLOT;
+	indirectArgs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW;
+	indirectArgs[2].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	indirectArgs[2].Constant.RootParameterIndex = VERTEX_CB_ROOT_SLOT;
+	indirectArgs[2].Constant.DestOffsetIn32BitValues = 0;
+	indirectArgs[2].Constant.Num32BitValuesToSet = INDIRECT_CONSTANTS;
+	indirectArgs[3].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+	D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc;
+	commandSignatureDesc.ByteStride = sizeof( IndirectCommand );
+	commandSignatureDesc.NumArgumentDescs = 4;
+	commandSignatureDesc.pArgumentDescs = indirectArgs;
+	commandSignatureDesc.NodeMask = 0;
+	if( FAILED( device->CreateCommandSignature( &commandSignatureDesc, rootSignature, IID_PPV_ARGS( &indirectDraws.pCommandSignature ) ) ) )
+	{
+		logError( "Failed to create indirect command signature!\n" );
+		return false;
+	}
+
+	D3D12_HEAP_PROPERTIES heapDesc;
+	heapDesc.Type = D3D12_HEAP_TYPE_DEFAULT;
+	heapDesc.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapDesc.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	heapDesc.CreationNodeMask = 1;
+	heapDesc.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC bufferDesc;
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufferDesc.Alignment = 0;
+	bufferDesc.Width = INDIRECT_COUNTS_OFFSET + ( sizeof( u32 ) * ovrEye_Count );
+	bufferDesc.Height = 1;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.Format = DXGI_FORMAT_UNKNOWN;
+	bufferDesc.SampleDesc.Count = 1;
+	bufferDesc.SampleDesc.Quality = 0;
+	bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	bufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	if( FAILED( device->CreateCommittedResource( &heapDesc, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS( &indirectDraws.pCommands ) ) ) )
+	{
+		logError( "Failed to create indirect command buffer!\n" );
+		return false;
+	}
+#if MAIN_DEBUG
+	indirectDraws.pCommands->SetName( L"Indirect Command Buffer" );
+#endif
+
+	InitIndirectFrameLayout( &indirectDraws.layout, SCENE_MAX_ENTITIES, MESH_COUNT );
+	heapDesc.Type = D3D12_HEAP_TYPE_UPLOAD;
+	bufferDesc.Width = indirectDraws.layout.qwSize;
+	bufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	for( u32 dwFrame = 0; dwFrame < oculusNUM_FRAMES; ++dwFrame )
+	{
+		if( FAILED( device->CreateCommittedResource( &heapDesc, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS( &indirectDraws.pUploads[dwFrame] ) ) ) )
+		{
+			logError( "Failed to create indirect upload buffer!\n" );
+			return false;
+		}
+#if MAIN_DEBUG
+		indirectDraws.pUploads[dwFrame]->SetName( L"Indirect Upload Buffer" );
+#endif
+		u8 *pUploadData;
+		D3D12_RANGE readRange = { 0, 0 }; //never read back
+		if( FAILED( indirectDraws.pUploads[dwFrame]->Map( 0, &readRange, (void**) &pUploadData ) ) )
+		{
+			logError( "Failed to map indirect upload buffer!\n" );
+			return false;
+		}
+		InitIndirectFrame( &indirectDraws.frames[dwFrame], &indirectDraws.layout, pUploadData );
+		//the meshes never change, their table goes in once
+		for( u32 dwMesh = 0; dwMesh < MESH_COUNT; ++dwMesh )
+		{
+			SetIndirectMesh( &indirectDraws.frames[dwFrame].pMeshes[dwMesh], meshVertexBufferViews[dwMesh], meshIndexBufferViews[dwMesh], meshIndices[dwMesh]->dwIndexCount,
+				&meshCullCenters[dwMesh], &meshCullExtents[dwMesh] );
+		}
+	}
+	indirectDraws.bEnabled = 1;
+	return true;
+}
+
+inline
+void IndirectCommandsBarrier( ID3D12GraphicsCommandList *a_pCommandList, D3D12_RESOURCE_STATES a_before, D3D12_RESOURCE_STATES a_after )
+{
+	D3D12_RESOURCE_BARRIER commandsBarrier;
+	commandsBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	commandsBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	commandsBarrier.Transition.pResource = indirectDraws.pCommands;
+	commandsBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	commandsBarrier.Transition.StateBefore = a_before;
+	commandsBarrier.Transition.StateAfter = a_after;
+	a_pCommandList->ResourceBarrier( 1, &commandsBarrier );
+}
+
+//culls this frame's uploaded static draws into both eyes' commands, recorded at the start of the left eye so the right eye's
+//list (executed after it) finds them ready too. the counts start from the upload's zeros
+inline
+void RecordIndirectCull( ID3D12GraphicsCommandList *a_pCommandList, RenderBackend *a_pBackend, u32 dwNumObjects )
+{
+	D3D12_GPU_VIRTUAL_ADDRESS qwUpload = indirectDraws.pUploads[oculusCurrentFrameIdx]->GetGPUVirtualAddress();
+	IndirectCommandsBarrier( a_pCommandList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_DEST );
+	a_pCommandList->CopyBufferRegion( indirectDraws.pCommands, INDIRECT_COUNTS_OFFSET, indirectDraws.pUploads[oculusCurrentFrameIdx], indirectDraws.layout.qwCounts,
+		sizeof( u32 ) * ovrEye_Count );
+	IndirectCommandsBarrier( a_pCommandList, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS );
+	a_pCommandList->SetComputeRootSignature( indirectDraws.pCullRootSignature );
+	a_pCommandList->SetPipelineState( indirectDraws.pCullPipeline );
+	a_pBackend->pPipeline = indirectDraws.pCullPipeline; //so the next graphics pipeline gets set again
+	a_pCommandList->SetComputeRootConstantBufferView( INDIRECT_CB_ROOT_SLOT, qwUpload + indirectDraws.layout.qwParams );
+	a_pCommandList->SetComputeRootShaderResourceView( INDIRECT_WORLD_ROOT_SLOT, qwUpload + indirectDraws.layout.qwWorld );
+	a_pCommandList->SetComputeRootShaderResourceView( INDIRECT_NORMAL_ROOT_SLOT, qwUpload + indirectDraws.layout.qwNormal );
+	a_pCommandList->SetComputeRootShaderResourceView( INDIRECT_MESH_ROOT_SLOT, qwUpload + indirectDraws.layout.qwMesh );
+	a_pCommandList->SetComputeRootShaderResourceView( INDIRECT_MESH_TABLE_ROOT_SLOT, qwUpload + indirectDraws.layout.qwMeshTable );
+	a_pCommandList->SetComputeRootUnorderedAccessView( INDIRECT_COMMANDS_ROOT_SLOT, indirectDraws.pCommands->GetGPUVirtualAddress() );
+	a_pCommandList->SetComputeRootUnorderedAccessView( INDIRECT_COUNTS_ROOT_SLOT, indirectDraws.pCommands->GetGPUVirtualAddress() + INDIRECT_COUNTS_OFFSET );
+	if( dwNumObjects )
+	{
+		a_pCommandList->Dispatch( ( dwNumObjects + INDIRECT_CULL_GROUP - 1 ) / INDIRECT_CULL_GROUP, 1, 1 );
+	}
+	IndirectCommandsBarrier( a_pCommandList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT );
+}
+
+inline
+bool InitSceneCulling()
+{
+	InitSkinnedCullBounds( &handCullBounds, handVertices, sizeof(handVertices) / ( sizeof(u32) * 18 ), 18, 6, handInvBind, handBonesCount );
+	return InitCullBoxes( &sceneCullBoxes, SCENE_MAX_ENTITIES );
+}
+
+//world boxes for the packet's draws (or just its skinned ones), then one stereo cull for both eyes
+inline
+void CullScene( FramePacket *a_pPacket, SceneDrawList *pDraws, StereoCullFrustum *a_pStereoFrustum, u8 *a_pLeftVisible, u8 *a_pRightVisible )
+{
+	PROFILE_SCOPE( "Cull" );
+	sceneCullBoxes.dwCount = 0;
+	Vec3f vCenter, vExtent;
+	for( u32 dwDraw = 0; dwDraw < pDraws->dwNumStatic; ++dwDraw )
+	{
+		u32 dwMesh = pDraws->pMesh[dwDraw];
+		TransformCullBox( &meshCullCenters[dwMesh], &meshCullExtents[dwMesh], &pDraws->pWorld[dwDraw], &vCenter, &vExtent );
+		AddCullBox( &sceneCullBoxes, &vCenter, &vExtent );
+	}
+	for( u32 dwDraw = pDraws->dwNumStatic; dwDraw < pDraws->dwCount; ++dwDraw )
+	{
+		//absent hands still take their slot so the indices stay fixed, they are never drawn anyway
+		SkinnedCullBox( &handCullBounds, a_pPacket->mHandFinalBones[pDraws->pPalette[dwDraw]], &pDraws->pWorld[dwDraw], &vCenter, &vExtent );
+		vExtent.x += CULL_HAND_LATCH_MARGIN;
+		vExtent.y += CULL_HAND_LATCH_MARGIN;
+		vExtent.z += CULL_HAND_LATCH_MARGIN;
+		AddCullBox( &sceneCullBoxes, &vCenter, &vExtent );
+	}
+	StereoCullBoxes( a_pStereoFrustum, &sceneCullBoxes, a_pLeftVisible, a_pRightVisible );
+}
+
+//LOD level of every visible draw whose mesh has a chain, from how many pixels a mesh unit covers at the near side of its cull box
+//in whichever eye sees it bigger. uses CullScene's boxes, draws no eye sees keep last frame's level
+inline
+void SelectSceneLods( SceneDrawList *a_pDraws, ovrFovPort *a_pEyeFovs, D3D12_VIEWPORT *a_pViewports, Vec3f *a_pEyePositions, u8 *a_pLeftVisible,
+	u8 *a_pRightVisible )
+{
+	PROFILE_SCOPE( "SelectLods" );
+	u8 *pVisible[ovrEye_Count] = { a_pLeftVisible, a_pRightVisible };
+	f32 fPixelsPerTan[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		fPixelsPerTan[dwEye] = a_pViewports[dwEye].Height / ( a_pEyeFovs[dwEye].UpTan + a_pEyeFovs[dwEye].DownTan );
+	}
+	for( u32 dwDraw = 0; dwDraw < a_pDraws->dwCount; ++dwDraw )
+	{
+		u32 dwMesh = a_pDraws->pMesh[dwDraw];
+		if( meshLodCounts[dwMesh] == 1 )
+		{
+			continue;
+		}
+		f32 fPixelsPerUnit = 0.0f;
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			if( !CullIsVisible( pVisible[dwEye], dwDraw ) )
+			{
+				continue;
+			}
+			f32 fDX = sceneCullBoxes.pCenterX[dwDraw] - a_pEyePositions[dwEye].x;
+			f32 fDY = sceneCullBoxes.pCenterY[dwDraw] - a_pEyePositions[dwEye].y;
+			f32 fDZ = sceneCullBoxes.pCenterZ[dwDraw] - a_pEyePositions[dwEye].z;
+			f32 fRadius = sqrtf( ( sceneCullBoxes.pExtentX[dwDraw] * sceneCullBoxes.pExtentX[dwDraw] ) + ( sceneCullBoxes.pExtentY[dwDraw] * sceneCullBoxes.pExtentY[dwDraw] ) +
+				( sceneCullBoxes.pExtentZ[dwDraw] * sceneCullBoxes.pExtentZ[dwDraw] ) );
+			f32 fDistance = sqrtf( ( fDX * fDX ) + ( fDY * fDY ) + ( fDZ * fDZ ) ) - fRadius;
+			fDistance = fDistance > EYE_NEAR_PLANE ? fDistance : EYE_NEAR_PLANE;
+			f32 fEyePixels = fPixelsPerTan[dwEye] / fDistance;
+			fPixelsPerUnit = fEyePixels > fPixelsPerUnit ? fEyePixels : fPixelsPerUnit;
+		}
+		if( fPixelsPerUnit == 0.0f )
+		{
+			continue;
+		}
+		//the levels' errors are in mesh units, the world matrix's biggest axis scale takes them to world units
+		Mat4f *pWorld = &a_pDraws->pWorld[dwDraw];
+		f32 fScaleSq = 0.0f;
+		for( u32 dwAxis = 0; dwAxis < 3; ++dwAxis )
+		{
+			f32 fAxisSq = ( pWorld->m[dwAxis][0] * pWorld->m[dwAxis][0] ) + ( pWorld->m[dwAxis][1] * pWorld->m[dwAxis][1] ) + ( pWorld->m[dwAxis][2] * pWorld->m[dwAxis][2] );
+			fScaleSq = fAxisSq > fScaleSq ? fAxisSq : fScaleSq;
+		}
+		u32 dwSlot = a_pDraws->pSlot[dwDraw];
+		sceneLods[dwSlot] = (u8)MeshLodSelect( meshLodLevels[dwMesh], meshLodCounts[dwMesh], sceneLods[dwSlot], fPixelsPerUnit * sqrtf( fScaleSq ) );
+		a_pDraws->pLod[dwDraw] = sceneLods[dwSlot];
+	}
+}
+
+//render thread, records, latches, submits and ends the frame the packet was simulated for
+void RenderFrame( FramePacket *a_pPacket )
+{
+	PROFILE_SCOPE( "RenderFrame" );
+	if( ovr_BeginFrame( oculusSession, a_pPacket->qwOculusFrameIndex ) < 0 )
+	{
+#if MAIN_DEBUG
+		//TODO change to a retry create head set, maybe?
+		printf("begin failed\n");
+#endif
+		CloseProgram();
+		return;
+	}
+
+	ovr_GetTextureSwapChainCurrentIndex(oculusSession, oculusEyeSwapChains[0], (s32*)&oculusCurrentFrameIdx); //I don't think this will ever be out of sync between swap chains...
+	u32 dwDepthIdx; //the depth chains are committed with the color ones, but ask rather than assume
+	ovr_GetTextureSwapChainCurrentIndex(oculusSession, oculusEyeDepthSwapChains[0], (s32*)&dwDepthIdx);
+	ovrTimewarpProjectionDesc timewarpProjectionDesc; //same for both eyes, only near/far go into it
+#if SKIN_LAYOUT_AB_TEST
+	u32 dwSkinLayout = (u32)( a_pPacket->qwOculusFrameIndex % SKIN_LAYOUT_COUNT );
+	renderResources.pPipelines[RENDER_PIPELINE_SKINNED] = skinnedPipelineStateObjects[dwSkinLayout];
+	renderResources.pPipelines[RENDER_PIPELINE_SKINNED_INSTANCED] = skinnedInstancedPipelineStateObjects[dwSkinLayout];
+	gpuTimer.dwFrameTag = dwSkinLayout;
+#endif
+	GpuTimerBeginFrame( a_pPacket->qwOculusFrameIndex );
+
+	//pick this frame's render scale from the newest GPU frame time we have
+	if( gpuTimer.qwNumFramesProcessed != dynamicResolution.qwLastGpuFrame )
+	{
+		dynamicResolution.qwLastGpuFrame = gpuTimer.qwNumFramesProcessed;
+		DynamicResolutionUpdate( &dynamicResolution, (f32)( gpuTimer.fLastFrameUs / 1000.0 ) );
+	}
+	ovrRecti scaledEyeViewports[ovrEye_Count];
+	D3D12_VIEWPORT scaledD3DViewports[ovrEye_Count];
+	D3D12_RECT scaledScissorRects[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		DynamicResolutionEyeViewport( dynamicResolution.fScale, &oculusEyeRenderViewport[dwEye], &scaledEyeViewports[dwEye], &scaledD3DViewports[dwEye], &scaledScissorRects[dwEye] );
+	}
 
-					//gesture
-					if(oculusControllerInputState.Touches & ( ovrTouch_RThumbUp << ( 8 * dwHand ) ))
-					{
-						//if thumb is above joystick is this mutually exlcusive with ( ovrTouch_RThumbRest << ( 8 * dwHand ) )?
-					}
+	ovrPosef *EyeRenderPose = a_pPacket->EyeRenderPose;
+	Quatf qRot = a_pPacket->qCamRot;
+	Vec3f vCamPos = a_pPacket->vCamPos;
+	u8 *hwHandPresent = a_pPacket->hwHandPresent;
 
-					if(oculusControllerInputState.Touches & ( ovrTouch_RThumbRest << ( 8 * dwHand ) ))
-					{
-						//if thumb is on thumb rest being touched (only on quest controllers it seems)
-					}
-	
-					if (oculusControllerInputState.IndexTrigger[dwHand] > 0.15f)
-					{
-					    // index finger pressed state...
-					    handStates[dwHand].m_fFrontTrigger = oculusControllerInputState.IndexTrigger[dwHand];
-					}
-					else
-					{
-						handStates[dwHand].m_fFrontTrigger = 0.0f;
-					}
-	
-					if (oculusControllerInputState.HandTrigger[dwHand] > 0.15f)
-					{
-					    // index finger pressed state...
-					    handStates[dwHand].m_fSideTrigger = oculusControllerInputState.HandTrigger[dwHand];
-					}
-					else
-					{
-						handStates[dwHand].m_fSideTrigger = 0.0f;
-					}
-	
-					ovrVector2f vThumbStick = oculusControllerInputState.Thumbstick[dwHand];
-				
-					u32 dwStartingOffset = 0; //needs to be min
-					u32 dwNumMats = 0;
-										if( handStates[dwHand].m_fSideTrigger != fPrevSideFingerDownAmount[oculusCurrentFrameIdx][dwHand] )
-					{
-						fPrevSideFingerDownAmount[oculusCurrentFrameIdx][dwHand] = handStates[dwHand].m_fSideTrigger;
-						f64 fTotalTime = handInnerAnimTimeStamps[animationInnerKeyframeCount-1] - handInnerAnimTimeStamps[0];
-						if( handStates[dwHand].m_fSideTrigger == 0.0 )
-						{
-							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
-							for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
-							{				
-								Mat4f mLocalFrameBone;
-								InitModelMat4ByQuatf( &mLocalFrameBone, &handInnerKeyFrames[0][dwBone-firstInnerBone].qRot, &handInnerKeyFrames[0][dwBone-firstInnerBone].vPos );
-								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-							}
-						}
-						else if( handStates[dwHand].m_fSideTrigger == 1.0 )
-						{
-							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
-							for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
-							{				
-								Mat4f mLocalFrameBone;
-								InitModelMat4ByQuatf( &mLocalFrameBone, &handInnerKeyFrames[animationInnerKeyframeCount-1][dwBone-firstInnerBone].qRot, &handInnerKeyFrames[animationInnerKeyframeCount-1][dwBone-firstInnerBone].vPos );
-								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-							}
-						}
-						else
-						{
-							f64 fCurrAnimationTime = fTotalTime * handStates[dwHand].m_fSideTrigger;
-							u32 dwCurrKeyFrame = 1;
-							for( ; dwCurrKeyFrame < animationInnerKeyframeCount; ++dwCurrKeyFrame )
-							{
-								if( fCurrAnimationTime <= handInnerAnimTimeStamps[dwCurrKeyFrame])
-								{
-									break;
-								}
-							}
-							u32 dwPrevKeyFrame = dwCurrKeyFrame-1;
-							f32 fT = (f32)((fCurrAnimationTime - handInnerAnimTimeStamps[dwPrevKeyFrame]) / (handInnerAnimTimeStamps[dwCurrKeyFrame] - handInnerAnimTimeStamps[dwPrevKeyFrame]));
-							Quatf rot;
-							Vec3f pos;
-							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
-							for( u32 dwBone = firstInnerBone; dwBone < (firstInnerBone+numInnerChannels); ++dwBone )
-							{				
-								Mat4f mLocalFrameBone;
-								QuatfNormLerp(&handInnerKeyFrames[dwCurrKeyFrame][dwBone-firstInnerBone].qRot,&handInnerKeyFrames[dwPrevKeyFrame][dwBone-firstInnerBone].qRot,fT,&rot );
-								Vec3fLerp(&handInnerKeyFrames[dwCurrKeyFrame][dwBone-firstInnerBone].vPos,&handInnerKeyFrames[dwPrevKeyFrame][dwBone-firstInnerBone].vPos,fT,&pos);
-								InitModelMat4ByQuatf( &mLocalFrameBone, &rot, &pos );
-								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-								Mat4fMult(&handInvBind[dwBone], &mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-							}
-						}
+	Quatf eyeCamRots[ovrEye_Count];
+	Vec3f eyeCamPositions[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		//why would the following be different per eye?
+		Quatf eyeQuat;
+		eyeQuat.w = EyeRenderPose[dwEye].Orientation.w;
+		eyeQuat.x = EyeRenderPose[dwEye].Orientation.x;
+		eyeQuat.y = EyeRenderPose[dwEye].Orientation.y;
+		eyeQuat.z = EyeRenderPose[dwEye].Orientation.z;
+
+		Vec3f eyePos;
+		eyePos.x = EyeRenderPose[dwEye].Position.x; 
+		eyePos.y = EyeRenderPose[dwEye].Position.y;
+		eyePos.z = EyeRenderPose[dwEye].Position.z;
+
+		QuatfMult( &eyeQuat, &qRot, &eyeCamRots[dwEye] );
+
+		Vec3f vRotatedEyePos;
+		Vec3fRotByUnitQuat(&eyePos,&qRot,&vRotatedEyePos);
+		Vec3fAdd( &vRotatedEyePos, &vCamPos, &eyeCamPositions[dwEye] );
+	}
 
-						dwStartingOffset = firstInnerBone;
-						dwNumMats += numInnerChannels;
-					}
-					if( handStates[dwHand].m_fFrontTrigger != fPrevIndexFingerDownAmount[oculusCurrentFrameIdx][dwHand] )
-					{
-						fPrevIndexFingerDownAmount[oculusCurrentFrameIdx][dwHand] = handStates[dwHand].m_fFrontTrigger;
-						f64 fTotalTime = handOutterAnimTimeStamps[animationOutterKeyframeCount-1] - handOutterAnimTimeStamps[0];
-						if( handStates[dwHand].m_fFrontTrigger == 0.0 )
-						{
-							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
-							for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
-							{				
-								Mat4f mLocalFrameBone;
-								InitModelMat4ByQuatf( &mLocalFrameBone, &handOutterKeyFrames[0][dwBone-firstOutterBone].qRot, &handOutterKeyFrames[0][dwBone-firstOutterBone].vPos );
-								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-							}
-						}
-						else if( handStates[dwHand].m_fFrontTrigger == 1.0 )
-						{
-							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
-							for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
-							{				
-								Mat4f mLocalFrameBone;
-								InitModelMat4ByQuatf( &mLocalFrameBone, &handOutterKeyFrames[animationOutterKeyframeCount-1][dwBone-firstOutterBone].qRot, &handOutterKeyFrames[animationOutterKeyframeCount-1][dwBone-firstOutterBone].vPos );
-								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-								Mat4fMult(&handInvBind[dwBone],&mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-							}
-						}
-						else
-						{
-							f64 fCurrAnimationTime = fTotalTime * handStates[dwHand].m_fFrontTrigger;
-							u32 dwCurrKeyFrame = 1;
-							for( ; dwCurrKeyFrame < animationOutterKeyframeCount; ++dwCurrKeyFrame )
-							{
-								if( fCurrAnimationTime <= handOutterAnimTimeStamps[dwCurrKeyFrame])
-								{
-									break;
-								}
-							}
-							u32 dwPrevKeyFrame = dwCurrKeyFrame-1;
-							f32 fT = (f32)((fCurrAnimationTime - handOutterAnimTimeStamps[dwPrevKeyFrame]) / (handOutterAnimTimeStamps[dwCurrKeyFrame] - handOutterAnimTimeStamps[dwPrevKeyFrame]));
-							Quatf rot;
-							Vec3f pos;
-							InitModelMat4ByQuatf( &mHandFrameBindBones[dwHand][0], &handSkeleton[0].qLocalRot, &handSkeleton[0].vLocalTrans ); 
-							for( u32 dwBone = firstOutterBone; dwBone < (firstOutterBone+numOutterChannels); ++dwBone )
-							{				
-								Mat4f mLocalFrameBone;
-								QuatfNormLerp(&handOutterKeyFrames[dwCurrKeyFrame][dwBone-firstOutterBone].qRot,&handOutterKeyFrames[dwPrevKeyFrame][dwBone-firstOutterBone].qRot,fT,&rot );
-								Vec3fLerp(&handOutterKeyFrames[dwCurrKeyFrame][dwBone-firstOutterBone].vPos,&handOutterKeyFrames[dwPrevKeyFrame][dwBone-firstOutterBone].vPos,fT,&pos);
-								InitModelMat4ByQuatf( &mLocalFrameBone, &rot, &pos );
-								Mat4fMult(&mLocalFrameBone,&mHandFrameBindBones[dwHand][handBoneParents[dwBone]],&mHandFrameBindBones[dwHand][dwBone]);
-								Mat4fMult(&handInvBind[dwBone], &mHandFrameBindBones[dwHand][dwBone],&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwBone]);
-							}
-						}
+	StereoCullFrustum stereoFrustum;
+	InitStereoCullFrustum( &stereoFrustum, a_pPacket->EyeFov, eyeCamRots, eyeCamPositions, EYE_NEAR_PLANE );
+	Mat4f eyeViewProjs[ovrEye_Count];
+	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+	{
+		Mat4f mView;
+		InitViewMat4ByQuatf( &mView, &eyeCamRots[dwEye], &eyeCamPositions[dwEye] );
 
-						dwStartingOffset = firstOutterBone;
-						dwNumMats += numOutterChannels;
-					}
+		Mat4f mProj;
+		InitEyeProjection( &mProj, a_pPacket->EyeFov[dwEye] );
+		InitTimewarpProjectionDesc( &mProj, &timewarpProjectionDesc );
 
-					if( dwNumMats > 0 )
-					{
-						u8* pUploadBoneBufferData;
-						if( FAILED( boneBuffer[oculusCurrentFrameIdx][dwHand]->Map( 0, nullptr, (void**) &pUploadBoneBufferData ) ) )
-    					{
-    					    return;
-    					}
-    					memcpy(pUploadBoneBufferData+(sizeof(Mat4f)*dwStartingOffset),&mHandFrameFinalBones[oculusCurrentFrameIdx][dwHand][dwStartingOffset],sizeof(Mat4f)*dwNumMats);
-    					boneBuffer[oculusCurrentFrameIdx][dwHand]->Unmap( 0, nullptr );
-    				}
-				}
+		Mat4fMult( &mView, &mProj, &eyeViewProjs[dwEye] );
+	}
+	//the octilinear layer only gets the part of the scaled viewport the quadrants cover, and only that is cleared
+	ovrTextureLayoutOctilinear octilinearLayouts[ovrEye_Count];
+	FoveationQuadrant quadrants[ovrEye_Count][FOVEATION_NUM_QUADRANTS];
+	if( foveation.dwMode == FOVEATION_MULTIRES )
+	{
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			FoveationOctilinearLayout( foveation.fWarp, &scaledEyeViewports[dwEye], &octilinearLayouts[dwEye] );
+			scaledScissorRects[dwEye].right = scaledEyeViewports[dwEye].Pos.x + scaledEyeViewports[dwEye].Size.w;
+			scaledScissorRects[dwEye].bottom = scaledEyeViewports[dwEye].Pos.y + scaledEyeViewports[dwEye].Size.h;
+			for( u32 dwQuadrant = 0; dwQuadrant < FOVEATION_NUM_QUADRANTS; ++dwQuadrant )
+			{
+				FoveationQuadrantSetup( &octilinearLayouts[dwEye], &scaledEyeViewports[dwEye], dwQuadrant, &eyeViewProjs[dwEye], &quadrants[dwEye][dwQuadrant] );
 			}
 		}
+	}
+
+	//with indirect draws the static ones only get uploaded, the gpu culls them and writes their commands,
+	//the cpu cull and the render queue are left with the hands
+	SceneDrawList *pDraws = &a_pPacket->draws;
+	SceneDrawList skinnedDraws;
+	u32 dwNumIndirect = 0;
+	if( indirectDraws.bEnabled )
+	{
+		PROFILE_SCOPE( "UploadIndirect" );
+		IndirectFrame *pIndirectFrame = &indirectDraws.frames[oculusCurrentFrameIdx];
+		WriteIndirectObjects( pIndirectFrame, pDraws, SCENE_MAX_ENTITIES );
+		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+		{
+			SetIndirectEye( pIndirectFrame->pParams, dwEye, &stereoFrustum.eyes[dwEye], &eyeViewProjs[dwEye] );
+		}
+		dwNumIndirect = pDraws->dwNumStatic;
+		SceneSkinnedDraws( pDraws, &skinnedDraws );
+		pDraws = &skinnedDraws;
+	}
+	u8 sceneVisible[ovrEye_Count][( SCENE_MAX_ENTITIES + 7 ) / 8];
+	CullScene( a_pPacket, pDraws, &stereoFrustum, sceneVisible[ovrEye_Left], sceneVisible[ovrEye_Right] );
+	//only the hands have a chain so far, with indirect draws the static meshes stay on their single level on the gpu
+	SelectSceneLods( pDraws, a_pPacket->EyeFov, scaledD3DViewports, eyeCamPositions, sceneVisible[ovrEye_Left], sceneVisible[ovrEye_Right] );
 
+	u32 dwSkinnedStart;
+	{
+		PROFILE_SCOPE( "SortDraws" );
+		Vec3f vCenterEye = { ( eyeCamPositions[0].x + eyeCamPositions[1].x ) * 0.5f, ( eyeCamPositions[0].y + eyeCamPositions[1].y ) * 0.5f,
+			( eyeCamPositions[0].z + eyeCamPositions[1].z ) * 0.5f };
+		FrameDrawBuffers drawBuffers;
+		drawBuffers.pInstances = instanceBufferData[oculusCurrentFrameIdx];
+		drawBuffers.pInstanceBufferView = &instanceBufferViews[oculusCurrentFrameIdx];
+		drawBuffers.pDrawData = drawDataBufferData[oculusCurrentFrameIdx];
+		drawBuffers.qwDrawData = drawDataBuffers[oculusCurrentFrameIdx]->GetGPUVirtualAddress();
+		drawBuffers.qwBones = boneBuffer[oculusCurrentFrameIdx]->GetGPUVirtualAddress();
+		drawBuffers.dwPaletteSize = BONE_PALETTE_SIZE;
+		dwSkinnedStart = FrameBuildDraws( &renderQueue, &renderResources, pDraws, sceneVisible[ovrEye_Left], sceneVisible[ovrEye_Right], hwHandPresent, &vCenterEye, 1,
+			DRAW_DATA_MODE, &drawBuffers );
+	}
 
     	for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
     	{
-    		//why would the following be different per eye?
-    		Quatf eyeQuat;
-    		eyeQuat.w = EyeRenderPose[dwEye].Orientation.w;
-    		eyeQuat.x = EyeRenderPose[dwEye].Orientation.x;
-    		eyeQuat.y = EyeRenderPose[dwEye].Orientation.y;
-    		eyeQuat.z = EyeRenderPose[dwEye].Orientation.z;
-
-    		Vec3f eyePos;
-    		eyePos.x = EyeRenderPose[dwEye].Position.x; 
-    		eyePos.y = EyeRenderPose[dwEye].Position.y;
-    		eyePos.z = EyeRenderPose[dwEye].Position.z;
-
-			Quatf eyeCamRot;
-			QuatfMult( &eyeQuat, &qRot, &eyeCamRot );
-
-			Vec3f vRotatedEyePos;
-    		Vec3fRotByUnitQuat(&eyePos,&qRot,&vRotatedEyePos);
-    		Vec3f eyeCamPos;
-    		Vec3fAdd( &vRotatedEyePos, &startingPos, &eyeCamPos );
+    		PROFILE_SCOPE( dwEye == ovrEye_Left ? "RecordLeftEye" : "RecordRightEye" );
 
         	commandAllocators[(dwEye*oculusNUM_FRAMES) + oculusCurrentFrameIdx]->Reset();
 			commandLists[dwEye]->Reset( commandAllocators[(dwEye*oculusNUM_FRAMES) + oculusCurrentFrameIdx], pipelineStateObject );
-
-    		D3D12_RESOURCE_BARRIER presentToRenderBarrier;
-    		presentToRenderBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    		presentToRenderBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    		presentToRenderBarrier.Transition.pResource = oculusEyeBackBuffers[(dwEye*oculusNUM_FRAMES) + oculusCurrentFrameIdx];
-   			presentToRenderBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    		presentToRenderBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    		presentToRenderBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    		commandLists[dwEye]->ResourceBarrier( 1, &presentToRenderBarrier );
+			GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_EYE, 0 );
+
+    		D3D12_RESOURCE_BARRIER presentToRenderBarriers[2];
+    		presentToRenderBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    		presentToRenderBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    		presentToRenderBarriers[0].Transition.pResource = oculusEyeBackBuffers[(dwEye*oculusNUM_FRAMES) + oculusCurrentFrameIdx];
+   			presentToRenderBarriers[0].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    		presentToRenderBarriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    		presentToRenderBarriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    		//the compositor samples depth too, so it comes back to us as a shader resource like color
+    		presentToRenderBarriers[1] = presentToRenderBarriers[0];
+    		presentToRenderBarriers[1].Transition.pResource = oculusEyeDepthBuffers[(dwEye*oculusNUM_FRAMES) + dwDepthIdx];
+    		presentToRenderBarriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    		commandLists[dwEye]->ResourceBarrier( 2, presentToRenderBarriers );
     		
     		//render here
     		D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = eyeStartingRTVHandle[dwEye];
     		rtvHandle.ptr = (u64)rtvHandle.ptr + ( rtvDescriptorSize * oculusCurrentFrameIdx );
-			D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = eyeDSVHandle[dwEye]; //need 2 textures cause they may be diff sizes
+			D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = eyeStartingDSVHandle[dwEye]; //need 2 textures cause they may be diff sizes
+			dsvHandle.ptr = (u64)dsvHandle.ptr + ( dsvDescriptorSize * dwDepthIdx );
 		
 			commandLists[dwEye]->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
 		
-    		const float clearColor[] = { 0.5294f, 0.8078f, 0.9216f, 1.0f };
-    		commandLists[dwEye]->ClearRenderTargetView( rtvHandle, clearColor, 0, NULL );
-    		commandLists[dwEye]->ClearDepthStencilView( dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr );
+    		GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_CLEAR, 0 );
+    		commandLists[dwEye]->ClearRenderTargetView( rtvHandle, frameClearColor, 1, &scaledScissorRects[dwEye] ); //only clear what we render to
+    		commandLists[dwEye]->ClearDepthStencilView( dsvHandle, D3D12_CLEAR_FLAG_DEPTH, EYE_DEPTH_CLEAR, 0, 1, &scaledScissorRects[dwEye] );
+    		GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_CLEAR, 1 );
     		
-    		commandLists[dwEye]->SetGraphicsRootSignature( rootSignature ); //is this set with the pso?
-			commandLists[dwEye]->SetGraphicsRoot32BitConstants( PIXEL_CB_ROOT_SLOT, 4 + 3, &pixelConstantBuffer ,0);
+    		RenderBackendBegin( &renderBackends[dwEye], commandLists[dwEye], pipelineStateObject ); //root signature and constants come with the first draw
 
 			commandLists[dwEye]->IASetPrimitiveTopology( D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST ); 
 
-    		commandLists[dwEye]->RSSetViewports( 1, &EyeViewports[dwEye] ); //does this always need to be set?
-    		commandLists[dwEye]->RSSetScissorRects( 1, &EyeScissorRects[dwEye] ); //does this always need to be set?
-
-			Mat4f mView;
-    		InitViewMat4ByQuatf( &mView, &eyeCamRot, &eyeCamPos );
-		
-			Mat4f mProj;
-			InitPerspectiveProjectionMat4fOculusDirectXRH( &mProj, oculusEyeRenderDesc[dwEye].Fov, 0.01f, 1000.0f ); //TODO tune near/far
-
-			//ovrTimewarpProjectionDesc_FromProjection
-
-    		Mat4f mVP;
-    		Mat4fMult( &mView, &mProj, &mVP);
-		
-    		Mat4fMult(&mPlaneModel,&mVP, &vertexConstantBuffer.mvpMat);
-    		InverseTransposeUpper3x3Mat4f( &mPlaneModel, &vertexConstantBuffer.nMat );
-		
-    		commandLists[dwEye]->SetGraphicsRoot32BitConstants( VERTEX_CB_ROOT_SLOT, ( 4 * 4 ) + ( ( ( 4 * 2 ) + 3 ) ), &vertexConstantBuffer ,0);
-    		commandLists[dwEye]->IASetVertexBuffers( MAIN_VB_SLOT, 1, &planeVertexBufferView );
-    		commandLists[dwEye]->IASetIndexBuffer( &planeIndexBufferView );
-    		commandLists[dwEye]->DrawIndexedInstanced( planeIndexCount, 1, 0, 0, 0 );
+    		RenderSetViewport( &renderBackends[dwEye], &scaledD3DViewports[dwEye], &scaledScissorRects[dwEye] ); //does this always need to be set?
+    		FoveationBeginEye( dwEye, dynamicResolution.fScale );
 		
-		    Mat4fMult(&mCubeModel,&mVP, &vertexConstantBuffer.mvpMat);
-    		InverseTransposeUpper3x3Mat4f( &mCubeModel, &vertexConstantBuffer.nMat );
+    		GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_STATIC, 0 );
+    		if( indirectDraws.bEnabled )
+    		{
+    			if( dwEye == ovrEye_Left )
+    			{
+    				RecordIndirectCull( commandLists[dwEye], &renderBackends[dwEye], dwNumIndirect );
+    			}
+    			IndirectDrawSubmit( &renderBackends[dwEye], &renderResources, indirectDraws.pCommandSignature, indirectDraws.pCommands,
+    				(u64)dwEye * SCENE_MAX_ENTITIES * sizeof( IndirectCommand ), indirectDraws.pCommands, INDIRECT_COUNTS_OFFSET + ( sizeof( u32 ) * dwEye ), dwNumIndirect );
+    		}
+    		FrameSubmitDraws( &renderBackends[dwEye], &renderQueue, &renderResources, pDraws, quadrants[dwEye], &eyeViewProjs[dwEye], sceneVisible[dwEye], 0, dwSkinnedStart );
+    		GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_STATIC, 1 );
 		
-    		commandLists[dwEye]->SetGraphicsRoot32BitConstants( VERTEX_CB_ROOT_SLOT, ( 4 * 4 ) + ( ( ( 4 * 2 ) + 3 ) ), &vertexConstantBuffer ,0);
-    		commandLists[dwEye]->IASetVertexBuffers( MAIN_VB_SLOT, 1, &cubeVertexBufferView );
-    		commandLists[dwEye]->IASetIndexBuffer( &cubeIndexBufferView );
-    		commandLists[dwEye]->DrawIndexedInstanced( cubeIndexCount, 1, 0, 0, 0 );
-		
-    		commandLists[dwEye]->SetPipelineState( skinnedPipelineStateObject );
-    		commandLists[dwEye]->SetGraphicsRootSignature( skinnedRootSignature );
-
-    		for( u32 dwHand = 0; dwHand < ovrHand_Count; ++dwHand )
-			{
-				if( hwHandPresent[dwHand] )
-				{
-					Mat4fMult(&mHandModel[dwHand],&mVP, &vertexConstantBuffer.mvpMat);
-    				InverseTransposeUpper3x3Mat4f( &mHandModel[dwHand], &vertexConstantBuffer.nMat );
-				
-    				commandLists[dwEye]->SetGraphicsRoot32BitConstants( VERTEX_CB_ROOT_SLOT, ( 4 * 4 ) + ( ( ( 4 * 2 ) + 3 ) ), &vertexConstantBuffer ,0);
-//#if MAIN_DEBUG
-//    				D3D12_GPU_DESCRIPTOR_HANDLE srvHandle = srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-//    				srvHandle.ptr = (u64)srvHandle.ptr + (srvDescriptorSize* ((dwHand * ovrHand_Count) + oculusCurrentFrameIdx));
-//    				commandLists[dwEye]->SetGraphicsRootDescriptorTable(VERTEX_SB_ROOT_SLOT,srvHandle);
-//#else
-    				commandLists[dwEye]->SetGraphicsRootShaderResourceView( VERTEX_SB_ROOT_SLOT, boneBuffer[oculusCurrentFrameIdx][dwHand]->GetGPUVirtualAddress()); //i might be able to do this without a view but dangerously >:)
-//#endif	
-    				commandLists[dwEye]->IASetVertexBuffers( MAIN_VB_SLOT, 1, &handVertexBufferView );
-    				commandLists[dwEye]->IASetIndexBuffer( &handIndexBufferView );
-    				commandLists[dwEye]->DrawIndexedInstanced( handIndexCount, 1, 0, 0, 0 );
-				}
-			}
-
-    		D3D12_RESOURCE_BARRIER renderToPresentBarrier;
-    		renderToPresentBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    		renderToPresentBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    		renderToPresentBarrier.Transition.pResource = oculusEyeBackBuffers[(dwEye*oculusNUM_FRAMES) + oculusCurrentFrameIdx];
-   			renderToPresentBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    		renderToPresentBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    		renderToPresentBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    		commandLists[dwEye]->ResourceBarrier( 1, &renderToPresentBarrier );
+    		GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_HANDS, 0 );
+    		FrameSubmitDraws( &renderBackends[dwEye], &renderQueue, &renderResources, pDraws, quadrants[dwEye], &eyeViewProjs[dwEye], sceneVisible[dwEye], dwSkinnedStart, renderQueue.dwCount );
+    		GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_HANDS, 1 );
+
+    		D3D12_RESOURCE_BARRIER renderToPresentBarriers[2];
+    		renderToPresentBarriers[0].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+    		renderToPresentBarriers[0].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    		renderToPresentBarriers[0].Transition.pResource = oculusEyeBackBuffers[(dwEye*oculusNUM_FRAMES) + oculusCurrentFrameIdx];
+   			renderToPresentBarriers[0].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+    		renderToPresentBarriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+    		renderToPresentBarriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    		renderToPresentBarriers[1] = renderToPresentBarriers[0];
+    		renderToPresentBarriers[1].Transition.pResource = oculusEyeDepthBuffers[(dwEye*oculusNUM_FRAMES) + dwDepthIdx];
+    		renderToPresentBarriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    		commandLists[dwEye]->ResourceBarrier( 2, renderToPresentBarriers );
+    		if( indirectDraws.bEnabled && dwEye == ovrEye_Right )
+    		{
+    			//the right eye's list runs last, the next frame's cull writes them again
+    			IndirectCommandsBarrier( commandLists[dwEye], D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS );
+    		}
+    		GpuTimerQuery( commandLists[dwEye], dwEye, GPU_PASS_EYE, 1 );
+    		GpuTimerResolve( commandLists[dwEye], dwEye );
 
     		if( FAILED( commandLists[dwEye]->Close() ) )
 			{
@@ -2394,42 +2450,148 @@ void DrawScene( f32 deltaTime ) //todo change to f64 for higher precision time s
 				CloseProgram();
 				return;
 			}
-			
-			ID3D12CommandList* ppCommandLists[] = { commandLists[dwEye] };
-    		commandQueue->ExecuteCommandLists( _countof( ppCommandLists ), ppCommandLists );
+    	}
+
+    	//both eyes are recorded, now grab the freshest hand poses we can and submit right after
+    	if( !LateLatchHandPoses( a_pPacket ) )
+    	{
+    		CloseProgram();
+    		return;
+    	}
 
-    		ovr_CommitTextureSwapChain( oculusSession, oculusEyeSwapChains[dwEye]); //does this muck with the command list/command queue?
+    	{
+    		PROFILE_SCOPE( "Submit" );
+    		LARGE_INTEGER submitCounter;
+    		QueryPerformanceCounter( &submitCounter );
+    		lateLatchStats.earlyPoseCounter = a_pPacket->earlyPoseCounter;
+			ID3D12CommandList* ppCommandLists[] = { commandLists[0], commandLists[1] };
+    		commandQueue->ExecuteCommandLists( _countof( ppCommandLists ), ppCommandLists );
+    		GpuTimerEndFrame();
+    		RecordLateLatchStats( submitCounter );
+
+    		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+    		{
+    			ovr_CommitTextureSwapChain( oculusSession, oculusEyeSwapChains[dwEye]); //does this muck with the command list/command queue?
+    			ovr_CommitTextureSwapChain( oculusSession, oculusEyeDepthSwapChains[dwEye]);
+    		}
     	}
 
-    	//We specify the layer information now for the compositor, in the future use ovrLayerEyeFovDepth for asyn time warping
-    	//They use the depth version of ovrLayerEyeFov_ instead to do positional timewarp, but for our example, do we even need positional timewarp?
-    	ovrLayerEyeFov ld;
-    	ld.Header.Type = ovrLayerType_EyeFov; //look into ovrLayerType
+    	//We specify the layer information now for the compositor, with depth so timewarp/ASW can reproject positionally when we miss a frame
+    	ovrLayerEyeFovDepth ld;
+    	ld.Header.Type = ovrLayerType_EyeFovDepth; //look into ovrLayerType
     	ld.Header.Flags = 0; //look into ovrLayerFlags
     	memset(ld.Header.Reserved,0,128);
-    	ld.SensorSampleTime = fOculusFrameTiming;//fSensorSampleTime; //is this ok?
+    	ld.SensorSampleTime = a_pPacket->fPredictedDisplayTime;//fSensorSampleTime; //is this ok?
     	for (int dwEye = 0; dwEye < ovrEye_Count; ++dwEye)
     	{
     	    ld.ColorTexture[dwEye] = oculusEyeSwapChains[dwEye];
-    	    ld.Viewport[dwEye] = oculusEyeRenderViewport[dwEye];
+    	    ld.Viewport[dwEye] = scaledEyeViewports[dwEye]; //only the part we rendered this frame
     	    ld.Fov[dwEye] = oculusHMDDesc.DefaultEyeFov[dwEye];
     	    ld.RenderPose[dwEye] = EyeRenderPose[dwEye];
+    	    ld.DepthTexture[dwEye] = oculusEyeDepthSwapChains[dwEye]; //same viewport as color
     	}
+    	ld.ProjectionDesc = timewarpProjectionDesc;
 
     	ovrLayerHeader* oculusLayers = &ld.Header;
-    	if( ovr_EndFrame( oculusSession, oculusFrameCount, nullptr, &oculusLayers, 1 ) < 0 )
+    	//the octilinear eyes go as a multires layer instead, it has no depth
+    	ovrLayerEyeFovMultires lm;
+    	if( foveation.dwMode == FOVEATION_MULTIRES )
+    	{
+    		lm.Header = ld.Header;
+    		lm.Header.Type = ovrLayerType_EyeFovMultires;
+    		lm.SensorSampleTime = ld.SensorSampleTime;
+    		for( u32 dwEye = 0; dwEye < ovrEye_Count; ++dwEye )
+    		{
+    			lm.ColorTexture[dwEye] = ld.ColorTexture[dwEye];
+    			lm.Viewport[dwEye] = ld.Viewport[dwEye];
+    			lm.Fov[dwEye] = ld.Fov[dwEye];
+    			lm.RenderPose[dwEye] = ld.RenderPose[dwEye];
+    			lm.TextureLayoutDesc.Octilinear[dwEye] = octilinearLayouts[dwEye];
+    		}
+    		lm.TextureLayout = ovrTextureLayout_Octilinear;
+    		oculusLayers = &lm.Header;
+    	}
+    	ovrResult endResult;
+    	{
+    		PROFILE_SCOPE( "EndFrame" );
+    		endResult = ovr_EndFrame( oculusSession, a_pPacket->qwOculusFrameIndex, nullptr, &oculusLayers, 1 );
+    	}
+    	if( endResult < 0 )
     	{
 #if MAIN_DEBUG
     		//TODO change to a retry create head set, maybe?
     		printf("end failed\n");
 #endif
     		CloseProgram();
+    		return;
     	}
-    	++oculusFrameCount;
-    }
+    	PollTelemetry();
+#if MAIN_DEBUG
+    	//printed from here since the render thread is the one writing all of it
+    	if( ( a_pPacket->qwOculusFrameIndex % 900 ) == 0 ) //every ~10 seconds at 90hz
+    	{
+    		ProfilerPrintReport();
+    		GpuTimerPrintReport();
+    		TelemetryPrintReport();
+    		printf( "render scale %.2f (controller wants %.2f)\n", dynamicResolution.fScale, dynamicResolution.fDesiredScale );
+    		RenderStats *pLeftStats = &renderBackends[ovrEye_Left].stats;
+    		RenderStats *pRightStats = &renderBackends[ovrEye_Right].stats;
+    		printf( "draws %u (%u instances), state changes %u, api calls %u (%u redundant binds skipped)\n", pLeftStats->dwNumDraws + pRightStats->dwNumDraws,
+    			pLeftStats->dwNumInstances + pRightStats->dwNumInstances, pLeftStats->dwNumStateChanges + pRightStats->dwNumStateChanges, pLeftStats->dwNumApiCalls + pRightStats->dwNumApiCalls,
+    			pLeftStats->dwNumApiCallsSaved + pRightStats->dwNumApiCallsSaved );
+    	}
+#endif
+}
+
+DWORD WINAPI RenderThreadProc( LPVOID lpParameter )
+{
+	ProfilerRegisterThread( "Render" );
+	while( Running )
+	{
+		FramePacket *pPacket = AcquireFramePacket( &framePackets, FRAME_PACKET_WAIT_MS );
+		if( pPacket )
+		{
+			RenderFrame( pPacket );
+		}
+	}
+	return 0;
 }
 
 
+#if BENCHMARK_MODE
+//headless, no headset or gpu needed
+//returns how many checks failed, the benchmark exits with 1 if any did
+u32 RunBenchmarks()
+{
+	InitProfiler();
+	u32 dwFailures = 0;
+	dwFailures += BenchmarkIK();
+	dwFailures += BenchmarkInputPrediction();
+	BenchmarkProfiler();
+	dwFailures += BenchmarkGpuTimer();
+	dwFailures += BenchmarkTelemetry();
+	dwFailures += BenchmarkDynamicResolution();
+	dwFailures += BenchmarkDepthLayer();
+	dwFailures += BenchmarkDepthPrecision();
+	dwFailures += BenchmarkCulling();
+	dwFailures += BenchmarkBvh();
+	dwFailures += BenchmarkEntityStore();
+	dwFailures += BenchmarkTransformHierarchy();
+	dwFailures += BenchmarkRenderQueue();
+	dwFailures += BenchmarkDrawData();
+	dwFailures += BenchmarkIndirectDraw();
+	dwFailures += BenchmarkPipelineCache();
+	dwFailures += BenchmarkShaderPermutations( skinnedShaderArchive, sizeof( skinnedShaderArchive ) );
+	dwFailures += BenchmarkMeshIndices();
+	dwFailures += BenchmarkMeshLod();
+	dwFailures += BenchmarkMeshlets();
+	dwFailures += BenchmarkFoveation();
+	dwFailures += BenchmarkSoftRaster();
+	printf( "Benchmarks: %u failures\n", dwFailures );
+	return dwFailures;
+}
+#endif
+
 #if MAIN_DEBUG
 s32 main()
 #else
@@ -2440,6 +2602,9 @@ s32 APIENTRY WinMain(
     _In_ s32 ShowCode )
 #endif
 {
+#if BENCHMARK_MODE
+	return RunBenchmarks() ? 1 : 0;
+#endif
 	//TODO enter a searching for headset loop, once head set is found initialize it.
 	//     then go into that rendering loop for that headset
 	//     if that headset is disconnected for any reason go back to the searching for headset loop
@@ -2464,18 +2629,106 @@ s32 APIENTRY WinMain(
     	LARGE_INTEGER LastCounter;
     	QueryPerformanceCounter( &LastCounter );
 
+		InitProfiler();
+		ProfilerRegisterThread( "Sim" );
+		InitTelemetry( oculusHMDDesc.DisplayRefreshRate );
+		InitDynamicResolution( &dynamicResolution, oculusHMDDesc.DisplayRefreshRate );
 		InitStartingGameState();
 		InitHeadsetGraphicsState();
+		//the bone count of the skinned permutation sizes the bone buffers, so pick it before any of them get made
+		if( !InitSkinShaders( &skinShaders, skinnedShaderArchive, sizeof( skinnedShaderArchive ), handBonesCount ) )
+		{
+			logError( "No skinned shader permutation for the hand skeleton!\n" );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
+#if SKIN_LAYOUT_AB_TEST
+		gpuTimer.tagNames[SKIN_LAYOUT_PALETTE_ARRAY] = "skin palette array";
+		gpuTimer.tagNames[SKIN_LAYOUT_FLAT] = "skin flat";
+#endif
+		//the sim and render threads each keep a core, the workers get the rest, startup already uses them for pipeline compiles
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo( &systemInfo );
+		if( !InitWorkerPool( &workerPool, systemInfo.dwNumberOfProcessors > 2 ? systemInfo.dwNumberOfProcessors - 2 : 0 ) )
+		{
+			logError( "Failed to create worker threads!\n" );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
 		if( InitDirectX12() )
 		{
+			DestroyWorkerPool( &workerPool );
 			ovr_Destroy( oculusSession );
 			ovr_Shutdown();
 			return -1;
 		}
 		InitStartingSkeletons( oculusNUM_FRAMES );
+		if( !InitScene() )
+		{
+			logError( "Failed to allocate the scene!\n" );
+			DestroyWorkerPool( &workerPool );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
+		if( !InitSceneCulling() )
+		{
+			logError( "Failed to allocate cull boxes!\n" );
+			DestroyWorkerPool( &workerPool );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
+		if( !InitRenderQueueResources() )
+		{
+			logError( "Failed to allocate the render queue!\n" );
+			DestroyWorkerPool( &workerPool );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
+		if( !InitIndirectDraws() )
+		{
+			logError( "Failed to create the indirect draw resources!\n" );
+			DestroyWorkerPool( &workerPool );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
+
+		//only written when this launch compiled something the file didn't have
+		PipelineCacheSave( &pipelineCache, PIPELINE_CACHE_FILE_NAME );
+#if MAIN_DEBUG
+		LARGE_INTEGER startupEndCounter;
+		QueryPerformanceCounter( &startupEndCounter );
+		PipelineCachePrintReport( &pipelineCache, (f64)( startupEndCounter.QuadPart - LastCounter.QuadPart ) * 1000.0 / (f64)PerfCountFrequency );
+#endif
+
+		if( !InitFramePackets( &framePackets, SCENE_MAX_ENTITIES ) )
+		{
+			logError( "Failed to create frame packets!\n" );
+			DestroyWorkerPool( &workerPool );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
+		//simulate frame N+1 on this thread while the render thread records and submits frame N
+		HANDLE hRenderThread = CreateThread( nullptr, 0, RenderThreadProc, nullptr, 0, nullptr );
+		if( !hRenderThread )
+		{
+			logError( "Failed to create render thread!\n" );
+			DestroyWorkerPool( &workerPool );
+			DestroyFramePackets( &framePackets );
+			ovr_Destroy( oculusSession );
+			ovr_Shutdown();
+			return -1;
+		}
 
 		while( Running )
 		{
+    		PROFILE_SCOPE( "SimLoop" );
     		u64 EndCycleCount = __rdtsc();
     	
     		LARGE_INTEGER EndCounter;
@@ -2552,8 +2805,19 @@ s32 APIENTRY WinMain(
         	//DEAL WITH OCULUS CONTEXT LOST LIKE DEMO
 
         	//todo maybe add a #define for multiplayer where updates still happen but rendering does not on minimization
-        	DrawScene( ( 1 - isPaused ) * deltaTime );
+        	SimulateFrame( ( 1 - isPaused ) * deltaTime );
 		}
+		//let the render thread finish the frame it is on before the session goes away
+		WaitForSingleObject( hRenderThread, INFINITE );
+		CloseHandle( hRenderThread );
+		DestroyWorkerPool( &workerPool );
+		DestroyFramePackets( &framePackets );
+		DestroyPipelineCache( &pipelineCache );
+		TelemetryWriteBinary( "BasicOVR.telemetry.bin" ); //kept in release, this is what gets attached to bug reports
+#if MAIN_DEBUG
+		ProfilerWriteChromeTrace( "BasicOVR.trace.json" );
+		TelemetryWriteCsv( "BasicOVR.telemetry.csv" );
+#endif
 		//free(commandAllocators);
 		ovr_Destroy( oculusSession );
 		ovr_Shutdown();